@@ -9,7 +9,9 @@
  * - CPU pinning for consistent, fair measurements
  * - Multiple trials with statistical analysis (stddev, min, max)
  * - CSV output for visualization
- * - All algorithms: dir24, 4stride8 (IPv4), wide16, 6stride8 (IPv6)
+ * - Cache pressure mode (-P): co-runner threads and cache flushes
+ * - SIMD variant sweep (--simd-sweep): every batch kernel of every engine
+ * - All algorithms: dir24, 4stride8, lctrie (IPv4), wide16, 6stride8 (IPv6)
  */
 
 #define _GNU_SOURCE
@@ -30,6 +32,8 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "../include/lpm.h"
 
@@ -92,6 +96,7 @@ static bool dpdk_initialized = false;
 typedef enum {
     ALGO_DIR24,
     ALGO_4STRIDE8,
+    ALGO_LCTRIE,
     ALGO_WIDE16,
     ALGO_6STRIDE8,
 #ifdef HAVE_DPDK
@@ -141,6 +146,13 @@ static const algorithm_info_t ALGORITHMS[] = {
         .create = lpm_create_ipv4_8stride,
         .add = lpm_add_ipv4_8stride
     },
+    [ALGO_LCTRIE] = {
+        .name = "lctrie",
+        .display_name = "IPv4 LC-Trie",
+        .ip_version = IP_V4,
+        .create = lpm_create_ipv4_lctrie,
+        .add = lpm_add_ipv4_lctrie
+    },
     [ALGO_WIDE16] = {
         .name = "wide16",
         .display_name = "IPv6 Wide 16-bit",
@@ -457,6 +469,9 @@ static benchmark_result_t benchmark_ipv4_single(algorithm_t algo, int num_prefix
             if (algo == ALGO_DIR24) {
                 volatile uint32_t nh = lpm_lookup_ipv4_dir24(trie, test_addrs_u32[i % TEST_ADDR_COUNT]);
                 (void)nh;
+            } else if (algo == ALGO_LCTRIE) {
+                volatile uint32_t nh = lpm_lookup_ipv4_lctrie(trie, test_addrs_u32[i % TEST_ADDR_COUNT]);
+                (void)nh;
             } else {
                 volatile uint32_t nh = lpm_lookup_ipv4_8stride(trie, test_addrs_u32[i % TEST_ADDR_COUNT]);
                 (void)nh;
@@ -479,6 +494,15 @@ static benchmark_result_t benchmark_ipv4_single(algorithm_t algo, int num_prefix
                 }
                 total_lookups += 1000;
             }
+        } else if (algo == ALGO_LCTRIE) {
+            while (get_elapsed_sec(&start) < BENCH_DURATION_SEC) {
+                for (int i = 0; i < 1000; i++) {
+                    volatile uint32_t nh = lpm_lookup_ipv4_lctrie(trie, test_addrs_u32[idx]);
+                    (void)nh;
+                    idx = (idx + 1) % TEST_ADDR_COUNT;
+                }
+                total_lookups += 1000;
+            }
         } else {
             while (get_elapsed_sec(&start) < BENCH_DURATION_SEC) {
                 for (int i = 0; i < 1000; i++) {
@@ -498,6 +522,8 @@ static benchmark_result_t benchmark_ipv4_single(algorithm_t algo, int num_prefix
             if (algo == ALGO_DIR24) {
                 result.memory_bytes = LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry) +
                                      trie->tbl8_groups_used * 256 * sizeof(struct lpm_tbl8_entry);
+            } else if (algo == ALGO_LCTRIE) {
+                result.memory_bytes = lpm_lctrie_memory(trie);
             } else {
                 result.memory_bytes = trie->pool_used * sizeof(lpm_node_t);
             }
@@ -563,6 +589,8 @@ static benchmark_result_t benchmark_ipv4_batch(algorithm_t algo, int num_prefixe
         /* Warmup */
         if (algo == ALGO_DIR24) {
             lpm_lookup_batch_ipv4_dir24(trie, test_addrs, next_hops, BATCH_SIZE);
+        } else if (algo == ALGO_LCTRIE) {
+            lpm_lookup_batch_ipv4_lctrie(trie, test_addrs, next_hops, BATCH_SIZE);
         } else {
             lpm_lookup_batch_ipv4_8stride(trie, test_addrs, next_hops, BATCH_SIZE);
         }
@@ -577,6 +605,8 @@ static benchmark_result_t benchmark_ipv4_batch(algorithm_t algo, int num_prefixe
         while (get_elapsed_sec(&start) < BENCH_DURATION_SEC) {
             if (algo == ALGO_DIR24) {
                 lpm_lookup_batch_ipv4_dir24(trie, &test_addrs[batch_idx], next_hops, BATCH_SIZE);
+            } else if (algo == ALGO_LCTRIE) {
+                lpm_lookup_batch_ipv4_lctrie(trie, &test_addrs[batch_idx], next_hops, BATCH_SIZE);
             } else {
                 lpm_lookup_batch_ipv4_8stride(trie, &test_addrs[batch_idx], next_hops, BATCH_SIZE);
             }
@@ -591,6 +621,8 @@ static benchmark_result_t benchmark_ipv4_batch(algorithm_t algo, int num_prefixe
             if (algo == ALGO_DIR24) {
                 result.memory_bytes = LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry) +
                                      trie->tbl8_groups_used * 256 * sizeof(struct lpm_tbl8_entry);
+            } else if (algo == ALGO_LCTRIE) {
+                result.memory_bytes = lpm_lctrie_memory(trie);
             } else {
                 result.memory_bytes = trie->pool_used * sizeof(lpm_node_t);
             }
@@ -1757,6 +1789,624 @@ static benchmark_result_t run_benchmark(algorithm_t algo, lookup_type_t lookup_t
     }
 }
 
+/* ============================================================================
+ * Cache pressure mode
+ * ============================================================================ */
+
+/*
+ * The scaling runs above have the core and its caches to themselves. Here the
+ * lookups share the machine with co-runner threads: streamers sweep a buffer
+ * several times the LLC (memory bandwidth), polluters read-modify-write random
+ * lines of an LLC-sized buffer (LLC capacity). Before every sample the
+ * benchmark can also write flush_bytes of its own buffer, evicting that much
+ * of the table; sweeping flush_bytes from 0 to the LLC size gives throughput
+ * and tail latency as functions of the cache left to the table.
+ *
+ * A sample is PRESSURE_CHUNK lookups (single calls or one batch call) timed
+ * together; p50/p99 are over the per-lookup time of the samples, and the
+ * flush is not counted in either.
+ */
+
+#define PRESSURE_DURATION_SEC 1.0       /* Duration per point */
+#define PRESSURE_CHUNK 64               /* Lookups per timed sample */
+#define PRESSURE_MAX_SAMPLES (1 << 20)
+#define PRESSURE_DEFAULT_LLC (32u << 20)
+#define PRESSURE_STREAM_LLCS 4          /* Streamer buffer, in LLC sizes */
+#define PRESSURE_SWEEP_STEPS 4          /* Flush 0, 1/4 .. 4/4 of the LLC */
+
+typedef struct {
+    int streamers;
+    int polluters;
+    size_t flush_bytes;     /* SIZE_MAX: sweep */
+    size_t llc_bytes;
+    int num_prefixes;
+    int cpu;
+} pressure_config_t;
+
+typedef struct {
+    double lookups_per_sec;
+    double p50_ns;
+    double p99_ns;
+    size_t memory_bytes;
+} pressure_result_t;
+
+typedef struct {
+    pthread_t thread;
+    uint8_t *buf;
+    size_t bytes;
+    int cpu;                /* -1: not pinned */
+} corunner_t;
+
+static atomic_bool corunners_stop;
+
+/* Parse "64", "512K", "32M" or "1G" */
+static bool parse_size(const char *str, size_t *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(str, &end, 10);
+    if (errno || end == str) {
+        return false;
+    }
+    switch (toupper((unsigned char)*end)) {
+        case 'G': v <<= 10; /* fall through */
+        case 'M': v <<= 10; /* fall through */
+        case 'K': v <<= 10; end++; break;
+        default: break;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    *out = (size_t)v;
+    return true;
+}
+
+/* Last-level cache size, or PRESSURE_DEFAULT_LLC if the system won't say */
+static size_t detect_llc_bytes(void)
+{
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0) {
+        return (size_t)l3;
+    }
+#endif
+    FILE *f = fopen("/sys/devices/system/cpu/cpu0/cache/index3/size", "r");
+    if (f) {
+        char line[64];
+        size_t bytes;
+        if (fgets(line, sizeof(line), f)) {
+            line[strcspn(line, "\n")] = '\0';
+            if (parse_size(line, &bytes) && bytes > 0) {
+                fclose(f);
+                return bytes;
+            }
+        }
+        fclose(f);
+    }
+    return PRESSURE_DEFAULT_LLC;
+}
+
+/* Sequential read-modify-write sweeps: saturates memory bandwidth */
+static void *streamer_main(void *arg)
+{
+    corunner_t *c = arg;
+    if (c->cpu >= 0) {
+        pin_to_cpu(c->cpu);
+    }
+    while (!atomic_load_explicit(&corunners_stop, memory_order_relaxed)) {
+        for (size_t i = 0; i < c->bytes; i += 64) {
+            c->buf[i]++;
+        }
+    }
+    return NULL;
+}
+
+/* Random read-modify-writes of whole lines: keeps the LLC full of its data */
+static void *polluter_main(void *arg)
+{
+    corunner_t *c = arg;
+    size_t lines = c->bytes / 64;
+    uint64_t x = 0x9E3779B97F4A7C15ULL ^ (uintptr_t)c;
+    if (c->cpu >= 0) {
+        pin_to_cpu(c->cpu);
+    }
+    while (!atomic_load_explicit(&corunners_stop, memory_order_relaxed)) {
+        for (int i = 0; i < 4096; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            c->buf[(x % lines) * 64]++;
+        }
+    }
+    return NULL;
+}
+
+/* Start the co-runners on the cores after cfg->cpu; returns how many run */
+static int corunners_start(const pressure_config_t *cfg, corunner_t *runners)
+{
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int total = cfg->streamers + cfg->polluters;
+    int started = 0;
+
+    atomic_store(&corunners_stop, false);
+    for (int i = 0; i < total; i++) {
+        corunner_t *c = &runners[i];
+        bool streamer = i < cfg->streamers;
+        c->bytes = streamer ? cfg->llc_bytes * PRESSURE_STREAM_LLCS : cfg->llc_bytes;
+        c->cpu = ncpu > 1 ? (int)((cfg->cpu + 1 + i) % ncpu) : -1;
+        c->buf = malloc(c->bytes);
+        if (!c->buf) {
+            fprintf(stderr, "Failed to allocate %zu bytes for co-runner %d\n", c->bytes, i);
+            break;
+        }
+        memset(c->buf, 1, c->bytes);
+        if (pthread_create(&c->thread, NULL, streamer ? streamer_main : polluter_main, c) != 0) {
+            fprintf(stderr, "Failed to start co-runner %d\n", i);
+            free(c->buf);
+            break;
+        }
+        started++;
+    }
+    return started;
+}
+
+static void corunners_stop_all(corunner_t *runners, int count)
+{
+    atomic_store(&corunners_stop, true);
+    for (int i = 0; i < count; i++) {
+        pthread_join(runners[i].thread, NULL);
+        free(runners[i].buf);
+    }
+}
+
+/* Write one byte per line of buf, evicting up to bytes of other data */
+static void flush_cache(volatile uint8_t *buf, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i += 64) {
+        buf[i]++;
+    }
+}
+
+static size_t engine_memory(algorithm_t algo, const lpm_trie_t *trie)
+{
+    switch (algo) {
+        case ALGO_DIR24:
+            return LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry) +
+                   trie->tbl8_groups_used * 256 * sizeof(struct lpm_tbl8_entry);
+        case ALGO_LCTRIE:
+            return lpm_lctrie_memory(trie);
+        case ALGO_WIDE16:
+            return trie->wide_pool_used * sizeof(struct lpm_node_16) +
+                   trie->pool_used * sizeof(lpm_node_t);
+        default:
+            return trie->pool_used * sizeof(lpm_node_t);
+    }
+}
+
+static int compare_float(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+/* One point: the engine's lookups with flush_bytes evicted before each sample */
+static pressure_result_t pressure_measure(algorithm_t algo, lookup_type_t lookup_type,
+                                          const pressure_config_t *cfg,
+                                          size_t flush_bytes, uint8_t *flush_buf)
+{
+    pressure_result_t result = {0};
+    const algorithm_info_t *info = &ALGORITHMS[algo];
+    bool v4 = info->ip_version == IP_V4;
+
+    srand(42);
+    lpm_trie_t *trie = info->create();
+    if (!trie) {
+        fprintf(stderr, "Failed to create trie for %s\n", info->name);
+        return result;
+    }
+    for (int i = 0; i < cfg->num_prefixes; i++) {
+        uint8_t prefix[16];
+        if (v4) {
+            generate_random_ipv4(prefix);
+            info->add(trie, prefix, 8 + (rand() % 25), i);
+        } else {
+            generate_random_ipv6(prefix);
+            info->add(trie, prefix, 8 + (rand() % 121), i);
+        }
+    }
+
+    uint32_t (*lookup4)(const lpm_trie_t *, uint32_t) =
+        algo == ALGO_DIR24 ? lpm_lookup_ipv4_dir24 :
+        algo == ALGO_LCTRIE ? lpm_lookup_ipv4_lctrie : lpm_lookup_ipv4_8stride;
+    void (*batch4)(const lpm_trie_t *, const uint32_t *, uint32_t *, size_t) =
+        algo == ALGO_DIR24 ? lpm_lookup_batch_ipv4_dir24 :
+        algo == ALGO_LCTRIE ? lpm_lookup_batch_ipv4_lctrie : lpm_lookup_batch_ipv4_8stride;
+    uint32_t (*lookup6)(const lpm_trie_t *, const uint8_t[16]) =
+        algo == ALGO_WIDE16 ? lpm_lookup_ipv6_wide16 : lpm_lookup_ipv6_8stride;
+    void (*batch6)(const lpm_trie_t *, const uint8_t (*)[16], uint32_t *, size_t) =
+        algo == ALGO_WIDE16 ? lpm_lookup_batch_ipv6_wide16 : lpm_lookup_batch_ipv6_8stride;
+
+    uint32_t *addrs4 = malloc(TEST_ADDR_COUNT * sizeof(*addrs4));
+    uint8_t (*addrs6)[16] = malloc(TEST_ADDR_COUNT * sizeof(*addrs6));
+    float *samples = malloc(PRESSURE_MAX_SAMPLES * sizeof(*samples));
+    if (!addrs4 || !addrs6 || !samples) {
+        fprintf(stderr, "Failed to allocate test data\n");
+        goto out;
+    }
+    for (int i = 0; i < TEST_ADDR_COUNT; i++) {
+        uint8_t addr[4];
+        generate_random_ipv4(addr);
+        addrs4[i] = ipv4_to_uint32(addr);
+        generate_random_ipv6(addrs6[i]);
+    }
+
+    uint32_t next_hops[PRESSURE_CHUNK];
+    volatile uint32_t sink = 0;
+    size_t n = 0;
+    int idx = 0;
+    double lookup_ns = 0;
+    struct timespec start, t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (n < PRESSURE_MAX_SAMPLES && get_elapsed_sec(&start) < PRESSURE_DURATION_SEC) {
+        if (flush_bytes) {
+            flush_cache(flush_buf, flush_bytes);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (lookup_type == LOOKUP_BATCH) {
+            if (v4) {
+                batch4(trie, &addrs4[idx], next_hops, PRESSURE_CHUNK);
+            } else {
+                batch6(trie, &addrs6[idx], next_hops, PRESSURE_CHUNK);
+            }
+            sink += next_hops[0];
+        } else {
+            for (int i = 0; i < PRESSURE_CHUNK; i++) {
+                sink += v4 ? lookup4(trie, addrs4[idx + i]) : lookup6(trie, addrs6[idx + i]);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double ns = time_diff_us(&t0, &t1) * 1000.0;
+        lookup_ns += ns;
+        samples[n++] = (float)(ns / PRESSURE_CHUNK);
+        idx = (idx + PRESSURE_CHUNK) % (TEST_ADDR_COUNT - PRESSURE_CHUNK);
+    }
+    (void)sink;
+
+    qsort(samples, n, sizeof(*samples), compare_float);
+    result.lookups_per_sec = (double)n * PRESSURE_CHUNK / (lookup_ns / 1e9);
+    result.p50_ns = samples[n / 2];
+    result.p99_ns = samples[(size_t)((double)n * 0.99)];
+    result.memory_bytes = engine_memory(algo, trie);
+
+out:
+    free(addrs4);
+    free(addrs6);
+    free(samples);
+    lpm_destroy(trie);
+    return result;
+}
+
+/* Run every selected engine and lookup type under cfg; one CSV per pair */
+static int run_pressure(const pressure_config_t *cfg, int selected_algo, int selected_lookup,
+                        const char *output_dir, const char *cpu_sanitized,
+                        const char *cpu_model, bool quiet)
+{
+    size_t flushes[PRESSURE_SWEEP_STEPS + 1];
+    int num_flushes = 0;
+    if (cfg->flush_bytes == SIZE_MAX) {
+        for (int i = 0; i <= PRESSURE_SWEEP_STEPS; i++) {
+            flushes[num_flushes++] = cfg->llc_bytes / PRESSURE_SWEEP_STEPS * i;
+        }
+    } else {
+        flushes[num_flushes++] = cfg->flush_bytes;
+    }
+
+    size_t flush_max = 0;
+    for (int i = 0; i < num_flushes; i++) {
+        if (flushes[i] > flush_max) flush_max = flushes[i];
+    }
+    uint8_t *flush_buf = flush_max ? malloc(flush_max) : NULL;
+    if (flush_max && !flush_buf) {
+        fprintf(stderr, "Failed to allocate %zu byte flush buffer\n", flush_max);
+        return 1;
+    }
+    if (flush_buf) {
+        memset(flush_buf, 1, flush_max);
+    }
+
+    int total = cfg->streamers + cfg->polluters;
+    corunner_t *runners = calloc(total > 0 ? total : 1, sizeof(*runners));
+    if (!runners) {
+        free(flush_buf);
+        return 1;
+    }
+    int running = corunners_start(cfg, runners);
+    if (running < total) {
+        corunners_stop_all(runners, running);
+        free(runners);
+        free(flush_buf);
+        return 1;
+    }
+
+    if (!quiet) {
+        printf("Cache pressure: LLC %zu KB, %d streamer(s), %d polluter(s), %d prefixes\n\n",
+               cfg->llc_bytes >> 10, cfg->streamers, cfg->polluters, cfg->num_prefixes);
+    }
+
+    for (int algo = 0; algo < ALGO_COUNT; algo++) {
+        if (selected_algo >= 0 && algo != selected_algo) continue;
+        const algorithm_info_t *info = &ALGORITHMS[algo];
+        if (!info->create) {
+            if (!quiet) {
+                printf("Skipping %s (not supported in pressure mode)\n\n", info->name);
+            }
+            continue;
+        }
+        const char *ip_version = (info->ip_version == IP_V4) ? "ipv4" : "ipv6";
+
+        for (int lt = 0; lt < 2; lt++) {
+            if (selected_lookup >= 0 && lt != selected_lookup) continue;
+            const char *lookup_name = (lt == 0) ? "single" : "batch";
+
+            char subdir[768];
+            snprintf(subdir, sizeof(subdir), "%s/%s_%s_%s_pressure",
+                     output_dir, cpu_sanitized, ip_version, lookup_name);
+            if (mkdir_recursive(subdir) != 0) {
+                fprintf(stderr, "Warning: Could not create directory %s\n", subdir);
+            }
+            char filepath[1024];
+            snprintf(filepath, sizeof(filepath), "%s/%s.csv", subdir, info->name);
+            FILE *f = fopen(filepath, "w");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open %s for writing\n", filepath);
+                continue;
+            }
+
+            fprintf(f, "# LPM Cache Pressure Results\n");
+            fprintf(f, "# Algorithm: %s (%s)\n", info->display_name, info->name);
+            fprintf(f, "# IP Version: %s\n", ip_version);
+            fprintf(f, "# Lookup Type: %s\n", lookup_name);
+            fprintf(f, "# CPU: %s\n", cpu_model);
+            fprintf(f, "# LLC bytes: %zu\n", cfg->llc_bytes);
+            fprintf(f, "# Streamers: %d, polluters: %d\n", cfg->streamers, cfg->polluters);
+            fprintf(f, "# Prefixes: %d\n", cfg->num_prefixes);
+            fprintf(f, "#\n");
+            fprintf(f, "flush_bytes,available_cache_bytes,lookups_per_sec,p50_ns,p99_ns,memory_bytes\n");
+
+            if (!quiet) {
+                printf("Benchmarking %s %s %s under pressure...\n", info->name, ip_version, lookup_name);
+            }
+            for (int i = 0; i < num_flushes; i++) {
+                size_t available = flushes[i] < cfg->llc_bytes ? cfg->llc_bytes - flushes[i] : 0;
+                if (!quiet) {
+                    printf("  %zu KB of cache left... ", available >> 10);
+                    fflush(stdout);
+                }
+                pressure_result_t r = pressure_measure(algo, lt, cfg, flushes[i], flush_buf);
+                fprintf(f, "%zu,%zu,%.2f,%.2f,%.2f,%zu\n", flushes[i], available,
+                        r.lookups_per_sec, r.p50_ns, r.p99_ns, r.memory_bytes);
+                if (!quiet) {
+                    printf("%.2f Mlookups/s, p99 %.1f ns\n", r.lookups_per_sec / 1e6, r.p99_ns);
+                }
+            }
+            fclose(f);
+            if (!quiet) {
+                printf("  -> %s\n\n", filepath);
+            }
+        }
+    }
+
+    corunners_stop_all(runners, running);
+    free(runners);
+    free(flush_buf);
+    return 0;
+}
+
+/* ============================================================================
+ * SIMD variant sweep
+ *
+ * Batch lookups normally run the kernel the ifunc resolvers bound at load
+ * time. This mode times every kernel an engine has, from scalar up to the
+ * CPU's level, on one table and address set through
+ * lpm_lookup_batch_ipv{4,6}_simd(). Levels that map to the kernel of a lower
+ * level are not timed again. Each variant's results are checked against the
+ * scalar kernel's.
+ * ============================================================================ */
+
+#define SIMD_DURATION_SEC 1.0   /* Duration per trial */
+
+typedef struct {
+    const char *name;
+    ip_version_t ip_version;
+    lpm_trie_t *(*create)(void);
+} simd_engine_t;
+
+/* Every engine whose batch path is bound by a resolver, plus the LC-trie */
+static const simd_engine_t SIMD_ENGINES[] = {
+    {"dir24",    IP_V4, lpm_create_ipv4_dir24},
+    {"dir24c",   IP_V4, lpm_create_ipv4_dir24_compact},
+    {"small",    IP_V4, lpm_create_ipv4_small},
+    {"lctrie",   IP_V4, lpm_create_ipv4_lctrie},
+    {"4stride8", IP_V4, lpm_create_ipv4_8stride},
+    {"wide16",   IP_V6, lpm_create_ipv6_wide16},
+    {"6stride8", IP_V6, lpm_create_ipv6_8stride},
+};
+#define NUM_SIMD_ENGINES (sizeof(SIMD_ENGINES) / sizeof(SIMD_ENGINES[0]))
+
+static int simd_batch(const lpm_trie_t *trie, bool v4, lpm_simd_level_t level,
+                      const uint32_t *addrs4, const uint8_t (*addrs6)[16],
+                      uint32_t *next_hops, size_t count)
+{
+    return v4 ? lpm_lookup_batch_ipv4_simd(trie, level, addrs4, next_hops, count)
+              : lpm_lookup_batch_ipv6_simd(trie, level, addrs6, next_hops, count);
+}
+
+/* Median lookups/s over NUM_TRIALS; 0 if the variant disagrees with want */
+static double simd_measure(const lpm_trie_t *trie, bool v4, lpm_simd_level_t level,
+                           const uint32_t *addrs4, const uint8_t (*addrs6)[16],
+                           const uint32_t *want, uint32_t *next_hops)
+{
+    double trial_results[NUM_TRIALS];
+    double median, mean, stddev, min, max;
+
+    for (int i = 0; i < TEST_ADDR_COUNT; i += BATCH_SIZE) {
+        size_t n = TEST_ADDR_COUNT - i < BATCH_SIZE ? TEST_ADDR_COUNT - i : BATCH_SIZE;
+        simd_batch(trie, v4, level, &addrs4[i], &addrs6[i], next_hops, n);
+        if (memcmp(next_hops, &want[i], n * sizeof(*next_hops)) != 0) {
+            fprintf(stderr, "%s kernel disagrees with scalar at address %d\n",
+                    lpm_simd_level_name(level), i);
+            return 0;
+        }
+    }
+
+    for (int trial = 0; trial < NUM_TRIALS; trial++) {
+        struct timespec start;
+        long long total_lookups = 0;
+        int batch_idx = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (get_elapsed_sec(&start) < SIMD_DURATION_SEC) {
+            simd_batch(trie, v4, level, &addrs4[batch_idx], &addrs6[batch_idx], next_hops, BATCH_SIZE);
+            total_lookups += BATCH_SIZE;
+            batch_idx = (batch_idx + BATCH_SIZE) % (TEST_ADDR_COUNT - BATCH_SIZE);
+        }
+        trial_results[trial] = (double)total_lookups / get_elapsed_sec(&start);
+    }
+    calculate_stats(trial_results, NUM_TRIALS, &median, &mean, &stddev, &min, &max);
+    return median;
+}
+
+/* Sweep the selected engines (all if selected_name is NULL); one CSV */
+static int run_simd_sweep(const char *selected_name, int num_prefixes, const char *output_dir,
+                          const char *cpu_sanitized, const char *cpu_model, bool quiet)
+{
+    lpm_simd_level_t cpu = lpm_simd_cpu_level();
+    lpm_simd_level_t active = lpm_simd_active_level();
+
+    if (mkdir_recursive(output_dir) != 0) {
+        fprintf(stderr, "Warning: Could not create directory %s\n", output_dir);
+    }
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "%s/%s_simd_variants.csv", output_dir, cpu_sanitized);
+    FILE *f = fopen(filepath, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Could not open %s for writing\n", filepath);
+        return 1;
+    }
+    fprintf(f, "# LPM SIMD Variant Sweep\n");
+    fprintf(f, "# CPU: %s\n", cpu_model);
+    fprintf(f, "# CPU level: %s, bound level: %s\n",
+            lpm_simd_level_name(cpu), lpm_simd_level_name(active));
+    fprintf(f, "# Prefixes: %d, batch size: %d\n", num_prefixes, BATCH_SIZE);
+    fprintf(f, "#\n");
+    fprintf(f, "engine,ip_version,variant,lookups_per_sec,ns_per_lookup,speedup_vs_scalar,bound,winner\n");
+
+    uint32_t *addrs4 = malloc(TEST_ADDR_COUNT * sizeof(*addrs4));
+    uint8_t (*addrs6)[16] = malloc(TEST_ADDR_COUNT * sizeof(*addrs6));
+    uint32_t *want = malloc(TEST_ADDR_COUNT * sizeof(*want));
+    uint32_t next_hops[BATCH_SIZE];
+    if (!addrs4 || !addrs6 || !want) {
+        fprintf(stderr, "Failed to allocate test data\n");
+        free(addrs4);
+        free(addrs6);
+        free(want);
+        fclose(f);
+        return 1;
+    }
+    srand(42);
+    for (int i = 0; i < TEST_ADDR_COUNT; i++) {
+        uint8_t addr[4];
+        generate_random_ipv4(addr);
+        addrs4[i] = ipv4_to_uint32(addr);
+        generate_random_ipv6(addrs6[i]);
+    }
+
+    if (!quiet) {
+        printf("SIMD variant sweep: CPU level %s, bound level %s, %d prefixes\n\n",
+               lpm_simd_level_name(cpu), lpm_simd_level_name(active), num_prefixes);
+    }
+
+    for (size_t e = 0; e < NUM_SIMD_ENGINES; e++) {
+        const simd_engine_t *eng = &SIMD_ENGINES[e];
+        if (selected_name && strcmp(selected_name, eng->name) != 0) continue;
+        bool v4 = eng->ip_version == IP_V4;
+
+        srand(42);
+        lpm_trie_t *trie = eng->create();
+        if (!trie) {
+            fprintf(stderr, "Failed to create trie for %s\n", eng->name);
+            continue;
+        }
+        for (int i = 0; i < num_prefixes; i++) {
+            uint8_t prefix[16];
+            if (v4) {
+                generate_random_ipv4(prefix);
+                lpm_add(trie, prefix, 8 + (rand() % 25), i);
+            } else {
+                generate_random_ipv6(prefix);
+                lpm_add(trie, prefix, 8 + (rand() % 121), i);
+            }
+        }
+        for (int i = 0; i < TEST_ADDR_COUNT; i += BATCH_SIZE) {
+            size_t n = TEST_ADDR_COUNT - i < BATCH_SIZE ? TEST_ADDR_COUNT - i : BATCH_SIZE;
+            simd_batch(trie, v4, LPM_SIMD_SCALAR, &addrs4[i], &addrs6[i], &want[i], n);
+        }
+
+        if (!quiet) {
+            printf("Benchmarking %s batch variants...\n", eng->name);
+        }
+        double rate[LPM_SIMD_LEVELS] = {0};
+        int bound = lpm_simd_kernel_level(trie, active);
+        int winner = -1;
+        for (int l = 0; l < LPM_SIMD_LEVELS; l++) {
+            const char *name = lpm_simd_level_name((lpm_simd_level_t)l);
+            int k = lpm_simd_kernel_level(trie, (lpm_simd_level_t)l);
+            if (l > (int)cpu) {
+                if (!quiet) printf("  %-7s not supported by this CPU\n", name);
+                continue;
+            }
+            if (k != l) {
+                if (!quiet) printf("  %-7s same kernel as %s\n", name, lpm_simd_level_name((lpm_simd_level_t)k));
+                continue;
+            }
+            if (!quiet) {
+                printf("  %-7s ", name);
+                fflush(stdout);
+            }
+            rate[l] = simd_measure(trie, v4, (lpm_simd_level_t)l, addrs4, addrs6, want, next_hops);
+            if (rate[l] > 0 && (winner < 0 || rate[l] > rate[winner])) {
+                winner = l;
+            }
+            if (!quiet) {
+                printf("%.2f Mlookups/s, %.2f ns/lookup\n", rate[l] / 1e6, rate[l] > 0 ? 1e9 / rate[l] : 0);
+            }
+        }
+        for (int l = 0; l < LPM_SIMD_LEVELS; l++) {
+            if (rate[l] <= 0) continue;
+            fprintf(f, "%s,%s,%s,%.2f,%.3f,%.3f,%d,%d\n", eng->name, v4 ? "ipv4" : "ipv6",
+                    lpm_simd_level_name((lpm_simd_level_t)l), rate[l], 1e9 / rate[l],
+                    rate[0] > 0 ? rate[l] / rate[0] : 0, l == bound, l == winner);
+        }
+        if (!quiet && winner >= 0) {
+            printf("  winner: %s (%.2fx scalar)%s\n\n", lpm_simd_level_name((lpm_simd_level_t)winner),
+                   rate[0] > 0 ? rate[winner] / rate[0] : 0,
+                   winner == bound ? ", bound at load time" : "");
+        }
+        lpm_destroy(trie);
+    }
+
+    free(addrs4);
+    free(addrs6);
+    free(want);
+    fclose(f);
+    if (!quiet) {
+        printf("  -> %s\n\n", filepath);
+    }
+    return 0;
+}
+
 /* ============================================================================
  * Output functions
  * ============================================================================ */
@@ -1795,11 +2445,29 @@ static void print_usage(const char *prog)
     fprintf(stderr, "  -q, --quiet             Suppress progress output\n");
     fprintf(stderr, "  -d, --debug             Run debug verification tests and exit\n");
     fprintf(stderr, "  -h, --help              Show this help\n");
+    fprintf(stderr, "\nCache pressure mode:\n");
+    fprintf(stderr, "  -P, --pressure          Measure throughput and p99 against the cache left\n");
+    fprintf(stderr, "                          to the table instead of the prefix-count sweep\n");
+    fprintf(stderr, "      --streamers N       Co-runner threads streaming through memory (default: 0)\n");
+    fprintf(stderr, "      --polluters N       Co-runner threads writing random LLC lines (default: 0)\n");
+    fprintf(stderr, "      --flush SIZE        Evict SIZE bytes (K/M/G) before every sample;\n");
+    fprintf(stderr, "                          default sweeps 0 to the LLC size in quarters\n");
+    fprintf(stderr, "      --llc SIZE          Last-level cache size (default: detected)\n");
+    fprintf(stderr, "      --prefixes N        Prefixes in each table (default: %d; also used\n"
+                    "                          by --simd-sweep)\n",
+            PREFIX_COUNTS[NUM_PREFIX_COUNTS - 1]);
+    fprintf(stderr, "\nSIMD variant sweep:\n");
+    fprintf(stderr, "      --simd-sweep        Time every batch kernel (scalar .. avx512) the CPU\n");
+    fprintf(stderr, "                          can run for each engine, including dir24c and\n");
+    fprintf(stderr, "                          small, and report the fastest\n");
     fprintf(stderr, "\nAlgorithms:\n");
     fprintf(stderr, "  dir24     - IPv4 DIR-24-8 (fastest for IPv4)\n");
     fprintf(stderr, "  4stride8  - IPv4 8-bit stride trie\n");
+    fprintf(stderr, "  lctrie    - IPv4 level- and path-compressed trie\n");
     fprintf(stderr, "  wide16    - IPv6 16-bit wide stride\n");
     fprintf(stderr, "  6stride8  - IPv6 8-bit stride trie\n");
+    fprintf(stderr, "  dir24c    - IPv4 compact DIR-24-8 (--simd-sweep only)\n");
+    fprintf(stderr, "  small     - IPv4 small table (--simd-sweep only)\n");
 #ifdef HAVE_DPDK
     fprintf(stderr, "  dpdk      - DPDK LPM (IPv4)\n");
     fprintf(stderr, "  dpdk6     - DPDK LPM6 (IPv6)\n");
@@ -1822,6 +2490,13 @@ int main(int argc, char **argv)
     int cpu_core = 0;
     char hostname[256] = "";
     bool quiet = false;
+    bool pressure = false;
+    bool simd_sweep = false;
+    const char *sweep_only_algo = NULL;
+    pressure_config_t pcfg = {
+        .flush_bytes = SIZE_MAX,
+        .num_prefixes = PREFIX_COUNTS[NUM_PREFIX_COUNTS - 1],
+    };
     
 #ifdef HAVE_DPDK
     /* Initialize DPDK EAL (must be done early) */
@@ -1849,6 +2524,7 @@ int main(int argc, char **argv)
 #endif
     
     /* Parse options */
+    enum { OPT_STREAMERS = 256, OPT_POLLUTERS, OPT_FLUSH, OPT_LLC, OPT_PREFIXES, OPT_SIMD_SWEEP };
     static struct option long_options[] = {
         {"algorithm", required_argument, 0, 'a'},
         {"type",      required_argument, 0, 't'},
@@ -1858,16 +2534,24 @@ int main(int argc, char **argv)
         {"quiet",     no_argument,       0, 'q'},
         {"debug",     no_argument,       0, 'd'},
         {"help",      no_argument,       0, 'h'},
+        {"pressure",  no_argument,       0, 'P'},
+        {"streamers", required_argument, 0, OPT_STREAMERS},
+        {"polluters", required_argument, 0, OPT_POLLUTERS},
+        {"flush",     required_argument, 0, OPT_FLUSH},
+        {"llc",       required_argument, 0, OPT_LLC},
+        {"prefixes",  required_argument, 0, OPT_PREFIXES},
+        {"simd-sweep", no_argument,      0, OPT_SIMD_SWEEP},
         {0, 0, 0, 0}
     };
     
     int debug_mode = 0;
     int opt;
-    while ((opt = getopt_long(argc, argv, "a:t:o:c:n:qdh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "a:t:o:c:n:qdhP", long_options, NULL)) != -1) {
         switch (opt) {
             case 'a':
                 if (strcmp(optarg, "dir24") == 0) selected_algo = ALGO_DIR24;
                 else if (strcmp(optarg, "4stride8") == 0) selected_algo = ALGO_4STRIDE8;
+                else if (strcmp(optarg, "lctrie") == 0) selected_algo = ALGO_LCTRIE;
                 else if (strcmp(optarg, "wide16") == 0) selected_algo = ALGO_WIDE16;
                 else if (strcmp(optarg, "6stride8") == 0) selected_algo = ALGO_6STRIDE8;
 #ifdef HAVE_DPDK
@@ -1881,6 +2565,10 @@ int main(int argc, char **argv)
 #ifdef HAVE_LIBPATRICIA
                 else if (strcmp(optarg, "patricia") == 0) selected_algo = ALGO_PATRICIA_IPV4;
 #endif
+                else if (strcmp(optarg, "dir24c") == 0 || strcmp(optarg, "small") == 0) {
+                    selected_algo = ALGO_COUNT;     /* --simd-sweep only */
+                    sweep_only_algo = optarg;
+                }
                 else {
                     fprintf(stderr, "Unknown algorithm: %s\n", optarg);
                     return 1;
@@ -1909,6 +2597,28 @@ int main(int argc, char **argv)
             case 'd':
                 debug_mode = 1;
                 break;
+            case 'P':
+                pressure = true;
+                break;
+            case OPT_STREAMERS:
+                pcfg.streamers = atoi(optarg);
+                break;
+            case OPT_POLLUTERS:
+                pcfg.polluters = atoi(optarg);
+                break;
+            case OPT_FLUSH:
+            case OPT_LLC:
+                if (!parse_size(optarg, opt == OPT_FLUSH ? &pcfg.flush_bytes : &pcfg.llc_bytes)) {
+                    fprintf(stderr, "Invalid size: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_PREFIXES:
+                pcfg.num_prefixes = atoi(optarg);
+                break;
+            case OPT_SIMD_SWEEP:
+                simd_sweep = true;
+                break;
             case 'h':
             default:
                 print_usage(argv[0]);
@@ -1976,6 +2686,33 @@ int main(int argc, char **argv)
         return 0;
     }
     
+    if (simd_sweep) {
+        if (pcfg.num_prefixes <= 0) {
+            fprintf(stderr, "Invalid prefix count\n");
+            return 1;
+        }
+        return run_simd_sweep(selected_algo == ALGO_COUNT ? sweep_only_algo :
+                              selected_algo >= 0 ? ALGORITHMS[selected_algo].name : NULL,
+                              pcfg.num_prefixes, output_dir, cpu_sanitized, cpu_model, quiet);
+    }
+    if (selected_algo == ALGO_COUNT) {
+        fprintf(stderr, "Algorithm %s is only benchmarked by --simd-sweep\n", sweep_only_algo);
+        return 1;
+    }
+
+    if (pressure) {
+        if (pcfg.streamers < 0 || pcfg.polluters < 0 || pcfg.num_prefixes <= 0) {
+            fprintf(stderr, "Invalid cache pressure options\n");
+            return 1;
+        }
+        if (pcfg.llc_bytes == 0) {
+            pcfg.llc_bytes = detect_llc_bytes();
+        }
+        pcfg.cpu = cpu_core;
+        return run_pressure(&pcfg, selected_algo, selected_lookup,
+                            output_dir, cpu_sanitized, cpu_model, quiet);
+    }
+
     /* Create output directories */
     const char *ip_versions[] = {"ipv4", "ipv6"};
     const char *lookup_types[] = {"single", "batch"};
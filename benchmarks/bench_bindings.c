@@ -0,0 +1,356 @@
+/*
+ * liblpm - Binding Overhead Benchmark (raw C reference)
+ *
+ * Every language binding is measured with the same protocol on the same
+ * table and address trace; this program is the baseline they are compared
+ * against, and it also generates the workload:
+ *
+ *   bench_bindings --generate DIR [--prefixes N] [--addresses N] [--seed S]
+ *       writes DIR/table.txt ("a.b.c.d/len next_hop" per line, also readable
+ *       by lpm_load_prefix_file()) and DIR/trace.txt (one address per line)
+ *
+ *   bench_bindings TABLE TRACE
+ *       builds an IPv4 table with the default engine and prints one CSV row
+ *       per mode, without a header:
+ *       binding,api,mode,batch_size,lookups,ns_per_lookup,allocs_per_call,
+ *       bytes_per_call,checksum
+ *
+ * Protocol (shared by the drivers in benchmarks/bindings/): addresses are
+ * converted to the binding's native form up front. For single lookups and
+ * for batches of 16, 256 and 4096 consecutive trace addresses, one warm-up
+ * pass computes the checksum (sum of matched next hops, misses count 0), one
+ * pass counts allocations where the runtime exposes a counter, and the best
+ * of BENCH_PASSES timed passes gives ns_per_lookup. Empty allocation columns
+ * mean the runtime has no counter.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+#include "../include/lpm.h"
+
+#define BENCH_PASSES 3
+#define DEFAULT_PREFIXES 100000
+#define DEFAULT_ADDRESSES (1 << 20)
+
+static const size_t BATCH_SIZES[] = {16, 256, 4096};
+#define NUM_BATCH_SIZES (sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]))
+
+/* ============================================================================
+ * Allocation counting
+ *
+ * glibc lets the executable interpose malloc and friends and still reach the
+ * real allocator through __libc_*; elsewhere the columns stay empty.
+ * ============================================================================ */
+
+#ifdef __GLIBC__
+#define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static size_t alloc_calls;
+static size_t alloc_bytes;
+
+void *malloc(size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    alloc_calls++;
+    alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+#else
+#define HAVE_ALLOC_COUNT 0
+static size_t alloc_calls;
+static size_t alloc_bytes;
+#endif
+
+/* ============================================================================
+ * Workload
+ * ============================================================================ */
+
+static uint64_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 16);
+}
+
+/* Roughly the length mix of a BGP table: mostly /24, then /16-/23 */
+static uint8_t random_prefix_len(void)
+{
+    uint32_t r = rng_next() % 100;
+    if (r < 55) return 24;
+    if (r < 90) return (uint8_t)(16 + rng_next() % 8);
+    if (r < 95) return (uint8_t)(8 + rng_next() % 8);
+    return (uint8_t)(25 + rng_next() % 8);
+}
+
+static void format_ipv4(uint32_t addr, char *buf, size_t size)
+{
+    snprintf(buf, size, "%u.%u.%u.%u", addr >> 24, (addr >> 16) & 0xFF,
+             (addr >> 8) & 0xFF, addr & 0xFF);
+}
+
+static int generate(const char *dir, size_t num_prefixes, size_t num_addrs)
+{
+    char path[1024];
+    char buf[32];
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Could not create %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    uint32_t *prefixes = malloc(num_prefixes * sizeof(*prefixes));
+    uint8_t *lens = malloc(num_prefixes);
+    if (!prefixes || !lens) {
+        free(prefixes);
+        free(lens);
+        return 1;
+    }
+
+    snprintf(path, sizeof(path), "%s/table.txt", dir);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        free(prefixes);
+        free(lens);
+        return 1;
+    }
+    fprintf(f, "# liblpm binding benchmark table: %zu IPv4 prefixes\n", num_prefixes);
+    for (size_t i = 0; i < num_prefixes; i++) {
+        lens[i] = random_prefix_len();
+        prefixes[i] = rng_next() & (uint32_t)(~0ULL << (32 - lens[i]));
+        format_ipv4(prefixes[i], buf, sizeof(buf));
+        fprintf(f, "%s/%u %zu\n", buf, lens[i], 1 + i % 65535);
+    }
+    fclose(f);
+
+    /* Three in four addresses fall inside a table prefix */
+    snprintf(path, sizeof(path), "%s/trace.txt", dir);
+    f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        free(prefixes);
+        free(lens);
+        return 1;
+    }
+    for (size_t i = 0; i < num_addrs; i++) {
+        uint32_t addr = rng_next();
+        if (rng_next() % 4) {
+            size_t k = rng_next() % num_prefixes;
+            uint32_t host = (uint32_t)((1ULL << (32 - lens[k])) - 1);
+            addr = prefixes[k] | (addr & host);
+        }
+        format_ipv4(addr, buf, sizeof(buf));
+        fprintf(f, "%s\n", buf);
+    }
+    fclose(f);
+
+    free(prefixes);
+    free(lens);
+    return 0;
+}
+
+/* ============================================================================
+ * Measurement
+ * ============================================================================ */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* One pass over the trace; batch 0 means single lookups */
+static uint64_t run_pass(const lpm_trie_t *trie, const uint32_t *addrs, size_t count,
+                         size_t batch, uint32_t *results)
+{
+    uint64_t sum = 0;
+
+    if (batch == 0) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t nh = lpm_lookup_ipv4(trie, addrs[i]);
+            sum += nh != LPM_INVALID_NEXT_HOP ? nh : 0;
+        }
+        return sum;
+    }
+    for (size_t i = 0; i + batch <= count; i += batch) {
+        lpm_lookup_batch_ipv4(trie, &addrs[i], results, batch);
+        for (size_t j = 0; j < batch; j++) {
+            sum += results[j] != LPM_INVALID_NEXT_HOP ? results[j] : 0;
+        }
+    }
+    return sum;
+}
+
+static void measure(const lpm_trie_t *trie, const uint32_t *addrs, size_t count,
+                    size_t batch, uint32_t *results)
+{
+    size_t lookups = batch ? count / batch * batch : count;
+    size_t calls = batch ? count / batch : count;
+
+    uint64_t checksum = run_pass(trie, addrs, count, batch, results);
+
+    size_t calls0 = alloc_calls, bytes0 = alloc_bytes;
+    run_pass(trie, addrs, count, batch, results);
+    size_t allocs = alloc_calls - calls0, bytes = alloc_bytes - bytes0;
+
+    double best = 0;
+    for (int p = 0; p < BENCH_PASSES; p++) {
+        double t0 = now_ns();
+        run_pass(trie, addrs, count, batch, results);
+        double t = now_ns() - t0;
+        if (p == 0 || t < best) best = t;
+    }
+
+    printf("c,lpm_lookup_%s,%s,%zu,%zu,%.3f,", batch ? "batch_ipv4" : "ipv4",
+           batch ? "batch" : "single", batch ? batch : (size_t)1, lookups, best / lookups);
+    if (HAVE_ALLOC_COUNT) {
+        printf("%.3f,%.3f", (double)allocs / calls, (double)bytes / calls);
+    } else {
+        printf(",");
+    }
+    printf(",%llu\n", (unsigned long long)checksum);
+}
+
+static int run(const char *table_path, const char *trace_path)
+{
+    lpm_trie_t *trie = lpm_create_ipv4();
+    if (!trie) {
+        fprintf(stderr, "Failed to create table\n");
+        return 1;
+    }
+
+    /* Inserted line by line, as the bindings do */
+    FILE *f = fopen(table_path, "r");
+    if (!f) {
+        fprintf(stderr, "Could not open %s: %s\n", table_path, strerror(errno));
+        lpm_destroy(trie);
+        return 1;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        char addr[32];
+        unsigned len;
+        unsigned long nh;
+        uint8_t prefix[4];
+        if (line[0] == '#' || sscanf(line, "%31[0-9.]/%u %lu", addr, &len, &nh) != 3) {
+            continue;
+        }
+        if (inet_pton(AF_INET, addr, prefix) != 1 || len > 32) {
+            continue;
+        }
+        lpm_add(trie, prefix, (uint8_t)len, (uint32_t)nh);
+    }
+    fclose(f);
+
+    f = fopen(trace_path, "r");
+    if (!f) {
+        fprintf(stderr, "Could not open %s: %s\n", trace_path, strerror(errno));
+        lpm_destroy(trie);
+        return 1;
+    }
+    size_t count = 0, cap = 1 << 16;
+    uint32_t *addrs = malloc(cap * sizeof(*addrs));
+    while (addrs && fgets(line, sizeof(line), f)) {
+        struct in_addr in;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (inet_pton(AF_INET, line, &in) != 1) {
+            continue;
+        }
+        if (count == cap) {
+            uint32_t *grown = realloc(addrs, 2 * cap * sizeof(*addrs));
+            if (!grown) {
+                free(addrs);
+                addrs = NULL;
+                break;
+            }
+            addrs = grown;
+            cap *= 2;
+        }
+        addrs[count++] = ntohl(in.s_addr);
+    }
+    fclose(f);
+
+    uint32_t *results = malloc(BATCH_SIZES[NUM_BATCH_SIZES - 1] * sizeof(*results));
+    if (!addrs || !results || count < BATCH_SIZES[NUM_BATCH_SIZES - 1]) {
+        fprintf(stderr, "Trace %s is unreadable or too short\n", trace_path);
+        free(addrs);
+        free(results);
+        lpm_destroy(trie);
+        return 1;
+    }
+
+    measure(trie, addrs, count, 0, results);
+    for (size_t b = 0; b < NUM_BATCH_SIZES; b++) {
+        measure(trie, addrs, count, BATCH_SIZES[b], results);
+    }
+
+    free(addrs);
+    free(results);
+    lpm_destroy(trie);
+    return 0;
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s TABLE TRACE\n", prog);
+    fprintf(stderr, "       %s --generate DIR [--prefixes N] [--addresses N] [--seed S]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--generate") == 0) {
+        size_t num_prefixes = DEFAULT_PREFIXES;
+        size_t num_addrs = DEFAULT_ADDRESSES;
+        rng_state = 42;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            unsigned long long v = strtoull(argv[i + 1], NULL, 10);
+            if (strcmp(argv[i], "--prefixes") == 0 && v > 0) num_prefixes = v;
+            else if (strcmp(argv[i], "--addresses") == 0 && v > 0) num_addrs = v;
+            else if (strcmp(argv[i], "--seed") == 0 && v > 0) rng_state = v;
+            else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        return generate(argv[2], num_prefixes, num_addrs);
+    }
+    if (argc != 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    return run(argv[1], argv[2]);
+}
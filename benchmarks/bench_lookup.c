@@ -4,7 +4,10 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "../include/lpm.h"
+#include "../include/lpm_inline.h"
 
 #define MILLION 1000000
 #define NUM_PREFIXES 10000
@@ -145,6 +148,725 @@ static void benchmark_ipv4_batch_lookup(void)
     lpm_destroy(trie);
 }
 
+static void benchmark_ipv4_multi_table_lookup(void)
+{
+    printf("\n=== IPv4 Multi-Table Lookup Benchmark (3 tables) ===\n");
+    
+    /* FIB, ACL class and geo tables with different prefix mixes */
+    lpm_trie_t *tries[3];
+    for (int t = 0; t < 3; t++) {
+        tries[t] = lpm_create_ipv4();
+        assert(tries[t] != NULL);
+        for (int i = 0; i < NUM_PREFIXES * 10; i++) {
+            uint8_t prefix[4];
+            generate_random_ipv4(prefix);
+            uint8_t prefix_len = (t == 2) ? 16 + (rand() % 9) : 8 + (rand() % 25);
+            lpm_add(tries[t], prefix, prefix_len, i);
+        }
+    }
+    
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results[3];
+    for (int t = 0; t < 3; t++) {
+        results[t] = malloc(BATCH_SIZE * sizeof(uint32_t));
+    }
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    
+    /* Separate batch call per table */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int batch = 0; batch < num_batches; batch++) {
+        for (int t = 0; t < 3; t++) {
+            lpm_lookup_batch_ipv4(tries[t], &addrs[batch * BATCH_SIZE], results[t], BATCH_SIZE);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double separate_us = time_diff_us(&start, &end);
+    
+    /* One interleaved pass over all tables */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int batch = 0; batch < num_batches; batch++) {
+        lpm_lookup_batch_multi_ipv4((const lpm_trie_t *const *)tries, 3,
+                                    &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double multi_us = time_diff_us(&start, &end);
+    
+    double total = (double)num_batches * BATCH_SIZE;
+    printf("Per-address cost across 3 tables (batch size %d):\n", BATCH_SIZE);
+    printf("  3x lpm_lookup_batch_ipv4:      %.2f ns\n", separate_us * 1000 / total);
+    printf("  lpm_lookup_batch_multi_ipv4:   %.2f ns\n", multi_us * 1000 / total);
+    
+    for (int t = 0; t < 3; t++) {
+        free(results[t]);
+        lpm_destroy(tries[t]);
+    }
+    free(addrs);
+}
+
+static void benchmark_ipv4_dir24_compact(void)
+{
+    printf("\n=== IPv4 DIR-24-8 4-byte vs 2-byte Entries ===\n");
+    
+    /* Same routes in both tables; next hops kept within 15 bits */
+    lpm_trie_t *full = lpm_create_ipv4_dir24();
+    lpm_trie_t *compact = lpm_create_ipv4_dir24_compact();
+    assert(full != NULL && compact != NULL);
+    for (int i = 0; i < NUM_PREFIXES * 10; i++) {
+        uint8_t prefix[4];
+        generate_random_ipv4(prefix);
+        uint8_t prefix_len = 8 + (rand() % 25);
+        lpm_add(full, prefix, prefix_len, i & LPM_DIR24C_MAX_NEXT_HOP);
+        lpm_add(compact, prefix, prefix_len, i & LPM_DIR24C_MAX_NEXT_HOP);
+    }
+    
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results = malloc(BATCH_SIZE * sizeof(uint32_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    double total = (double)num_batches * BATCH_SIZE;
+    
+    lpm_trie_t *tries[2] = {full, compact};
+    const char *names[2] = {"4-byte (64 MB)", "2-byte (32 MB)"};
+    for (int t = 0; t < 2; t++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int batch = 0; batch < num_batches; batch++) {
+            lpm_lookup_batch_ipv4(tries[t], &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double us = time_diff_us(&start, &end);
+        printf("  %-16s %.2f ns/lookup, %.2f Mlookups/sec\n", names[t],
+               us * 1000 / total, total / us);
+    }
+    
+    free(results);
+    free(addrs);
+    lpm_destroy(full);
+    lpm_destroy(compact);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Per-batch latency of the first batches after the caches were flushed */
+static void cold_start_tail(const lpm_trie_t *trie, const uint32_t *addrs, uint8_t *flush,
+                            size_t flush_size, bool prefault, const char *label)
+{
+    enum { COLD_BATCHES = 512 };
+    double lat[COLD_BATCHES];
+    uint32_t results[BATCH_SIZE];
+    
+    /* Evict the table from the caches and the TLB, as a failover would */
+    memset(flush, prefault ? 1 : 2, flush_size);
+    
+    lpm_prefault_stats_t st = {0};
+    if (prefault) {
+        lpm_prefault((lpm_trie_t *)trie, LPM_PREFAULT_POPULATE | LPM_PREFAULT_HUGEPAGES |
+                     LPM_PREFAULT_WARM, &st);
+    }
+    for (int b = 0; b < COLD_BATCHES; b++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        lpm_lookup_batch_ipv4(trie, &addrs[b * BATCH_SIZE], results, BATCH_SIZE);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lat[b] = time_diff_us(&start, &end);
+    }
+    qsort(lat, COLD_BATCHES, sizeof(double), cmp_double);
+    printf("  %-22s p50 %6.1f us  p99 %6.1f us  max %6.1f us per %d-lookup batch",
+           label, lat[COLD_BATCHES / 2], lat[COLD_BATCHES * 99 / 100], lat[COLD_BATCHES - 1],
+           BATCH_SIZE);
+    if (prefault) {
+        printf(" (prefault %.1f ms, %.0f MB huge)", st.total_ms, st.huge_bytes / (1024.0 * 1024.0));
+    }
+    printf("\n");
+}
+
+static void benchmark_ipv4_prefault(void)
+{
+    printf("\n=== IPv4 Cold Start: First Lookups With and Without lpm_prefault() ===\n");
+    
+    lpm_trie_t *trie = lpm_create_ipv4_dir24();
+    assert(trie != NULL);
+    for (int i = 0; i < NUM_PREFIXES * 10; i++) {
+        uint8_t prefix[4];
+        generate_random_ipv4(prefix);
+        lpm_add(trie, prefix, 8 + (rand() % 25), i);
+    }
+    
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    size_t flush_size = (size_t)1024 * 1024 * 1024;   /* Beyond any LLC */
+    uint8_t *flush = malloc(flush_size);
+    
+    cold_start_tail(trie, addrs, flush, flush_size, false, "cold");
+    cold_start_tail(trie, addrs, flush, flush_size, true, "cold + lpm_prefault()");
+    
+    /* Steady state for reference */
+    uint32_t results[BATCH_SIZE];
+    for (int batch = 0; batch < num_batches; batch++) {
+        lpm_lookup_batch_ipv4(trie, &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+    }
+    cold_start_tail(trie, addrs, flush, 0, false, "warm");
+    
+    free(flush);
+    free(addrs);
+    lpm_destroy(trie);
+}
+
+static void benchmark_ipv4_small_table(void)
+{
+    printf("\n=== IPv4 Small Tables: DIR-24-8 vs Eytzinger Range Search ===\n");
+    
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results = malloc(BATCH_SIZE * sizeof(uint32_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    double total = (double)num_batches * BATCH_SIZE;
+    
+    static const int sizes[] = {64, 512, LPM_SMALL_MAX_PREFIXES};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        lpm_trie_t *dir24 = lpm_create_ipv4_dir24();
+        lpm_trie_t *small = lpm_create_ipv4_small();
+        assert(dir24 != NULL && small != NULL);
+        for (int i = 0; i < sizes[s]; i++) {
+            uint8_t prefix[4];
+            generate_random_ipv4(prefix);
+            uint8_t prefix_len = 8 + (rand() % 25);
+            lpm_add(dir24, prefix, prefix_len, i);
+            lpm_add(small, prefix, prefix_len, i);
+        }
+        
+        lpm_trie_t *tries[2] = {dir24, small};
+        const char *names[2] = {"DIR-24-8", "Small"};
+        for (int t = 0; t < 2; t++) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int batch = 0; batch < num_batches; batch++) {
+                lpm_lookup_batch_ipv4(tries[t], &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double us = time_diff_us(&start, &end);
+            printf("  %5d prefixes, %-9s %.2f ns/lookup, %.2f Mlookups/sec\n", sizes[s], names[t],
+                   us * 1000 / total, total / us);
+        }
+        lpm_destroy(dir24);
+        lpm_destroy(small);
+    }
+    
+    free(results);
+    free(addrs);
+}
+
+static void benchmark_ipv4_adaptive(void)
+{
+    printf("\n=== IPv4 Adaptive Table: growing through the engines ===\n");
+    
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results = malloc(BATCH_SIZE * sizeof(uint32_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    double total = (double)num_batches * BATCH_SIZE;
+    
+    /* Default thresholds; the same prefixes go into a fixed DIR-24-8 */
+    lpm_trie_t *dir24 = lpm_create_ipv4_dir24();
+    lpm_trie_t *adaptive = lpm_create_adaptive(LPM_IPV4_MAX_DEPTH, NULL);
+    assert(dir24 != NULL && adaptive != NULL);
+    
+    static const int sizes[] = {256, 4096, 100000};
+    int added = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (; added < sizes[s]; added++) {
+            uint8_t prefix[4];
+            generate_random_ipv4(prefix);
+            uint8_t prefix_len = 8 + (rand() % 25);
+            lpm_add(adaptive, prefix, prefix_len, added);
+            lpm_add(dir24, prefix, prefix_len, added);
+        }
+        lpm_adaptive_wait(adaptive);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lpm_adaptive_reclaim(adaptive);
+        printf("  %6d prefixes: %s after %u migrations (%.1f ms of updates)\n", sizes[s],
+               lpm_adaptive_engine(adaptive), lpm_adaptive_migrations(adaptive),
+               time_diff_us(&start, &end) / 1000);
+        
+        lpm_trie_t *tries[2] = {dir24, adaptive};
+        const char *names[2] = {"DIR-24-8", "Adaptive"};
+        for (int t = 0; t < 2; t++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int batch = 0; batch < num_batches; batch++) {
+                lpm_lookup_batch_ipv4(tries[t], &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double us = time_diff_us(&start, &end);
+            printf("    %-9s %.2f ns/lookup, %.2f Mlookups/sec\n", names[t],
+                   us * 1000 / total, total / us);
+        }
+    }
+    
+    lpm_destroy(dir24);
+    lpm_destroy(adaptive);
+    free(results);
+    free(addrs);
+}
+
+static void benchmark_ipv4_set(void)
+{
+    printf("\n=== IPv4 Blocklist: DIR-24-8 vs Membership Set ===\n");
+    
+    /* Same prefixes in both; the set only answers covered / not covered */
+    lpm_trie_t *dir24 = lpm_create_ipv4_dir24();
+    lpm_trie_t *set = lpm_create_set_ipv4();
+    assert(dir24 != NULL && set != NULL);
+    for (int i = 0; i < NUM_PREFIXES * 10; i++) {
+        uint8_t prefix[4];
+        generate_random_ipv4(prefix);
+        uint8_t prefix_len = 16 + (rand() % 17);  /* Blocklist-like: /16-/32 */
+        lpm_add(dir24, prefix, prefix_len, 1);
+        lpm_add(set, prefix, prefix_len, 1);
+    }
+    
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results = malloc(BATCH_SIZE * sizeof(uint32_t));
+    uint64_t *mask = malloc(((BATCH_SIZE + 63) / 64) * sizeof(uint64_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        addrs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    double total = (double)num_batches * BATCH_SIZE;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int batch = 0; batch < num_batches; batch++) {
+        lpm_lookup_batch_ipv4(dir24, &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double us = time_diff_us(&start, &end);
+    printf("  %-24s %.2f ns/lookup, %.2f Mlookups/sec\n", "DIR-24-8 (64 MB)",
+           us * 1000 / total, total / us);
+    
+    size_t hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int batch = 0; batch < num_batches; batch++) {
+        hits += lpm_contains_batch_ipv4(set, &addrs[batch * BATCH_SIZE], mask, BATCH_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    us = time_diff_us(&start, &end);
+    printf("  %-24s %.2f ns/lookup, %.2f Mlookups/sec (%.1f%% covered)\n", "Set bitmap (4 MB+blocks)",
+           us * 1000 / total, total / us, 100.0 * (double)hits / total);
+    
+    free(mask);
+    free(results);
+    free(addrs);
+    lpm_destroy(dir24);
+    lpm_destroy(set);
+}
+
+/* BGP-like table: /24-heavy, carved from /16-/20 allocations that are often
+ * announced as a whole too; most more-specifics keep the holder's next hop */
+static void bgp_put(uint8_t (*prefixes)[16], uint8_t *lens, uint32_t *nhs, size_t *n,
+                    uint32_t p, uint32_t len, uint32_t nh)
+{
+    memset(prefixes[*n], 0, 16);
+    prefixes[*n][0] = (uint8_t)(p >> 24);
+    prefixes[*n][1] = (uint8_t)(p >> 16);
+    prefixes[*n][2] = (uint8_t)(p >> 8);
+    prefixes[*n][3] = (uint8_t)p;
+    lens[*n] = (uint8_t)len;
+    nhs[*n] = nh;
+    (*n)++;
+}
+
+static size_t generate_bgp_like_ipv4(uint8_t (*prefixes)[16], uint8_t *lens, uint32_t *nhs, size_t max)
+{
+    size_t n = 0;
+    while (n + 2 <= max) {
+        uint32_t block_len = 16 + (uint32_t)(rand() % 5);
+        uint32_t block = (((uint32_t)rand() << 16) ^ (uint32_t)rand()) & (~0U << (32 - block_len));
+        uint32_t holder = (uint32_t)(rand() % 64);
+        if (rand() % 2) {
+            bgp_put(prefixes, lens, nhs, &n, block, block_len, holder);
+        }
+        for (uint32_t s = 0; s < (1U << (24 - block_len)) && n + 2 <= max; s++) {
+            if (rand() % 4 == 0) { continue; }                      /* Unannounced /24 */
+            uint32_t p = block | (s << 8);
+            bgp_put(prefixes, lens, nhs, &n, p, 24, rand() % 8 == 0 ? (uint32_t)(rand() % 64) : holder);
+            if (rand() % 10 == 0) {
+                uint32_t len = 25 + (uint32_t)(rand() % 8);
+                p |= (uint32_t)rand() & 0xFF & (~0U << (32 - len));
+                bgp_put(prefixes, lens, nhs, &n, p, len, rand() % 4 == 0 ? (uint32_t)(rand() % 64) : holder);
+            }
+        }
+    }
+    return n;
+}
+
+static void benchmark_ipv4_aggregation(void)
+{
+    printf("\n=== IPv4 FIB Aggregation (BGP-like table) ===\n");
+    
+    size_t count = (size_t)NUM_PREFIXES * 10;
+    uint8_t (*prefixes)[16] = malloc(count * sizeof(*prefixes));
+    uint8_t *lens = malloc(count);
+    uint32_t *nhs = malloc(count * sizeof(uint32_t));
+    count = generate_bgp_like_ipv4(prefixes, lens, nhs, count);
+    
+    /* Lookups land inside the table's address space */
+    uint32_t *addrs = malloc(NUM_LOOKUPS * sizeof(uint32_t));
+    uint32_t *results = malloc(BATCH_SIZE * sizeof(uint32_t));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        size_t r = (size_t)rand() % count;
+        addrs[i] = ((uint32_t)prefixes[r][0] << 24 | (uint32_t)prefixes[r][1] << 16 |
+                    (uint32_t)prefixes[r][2] << 8) | ((uint32_t)rand() & 0xFF);
+    }
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    double total = (double)num_batches * BATCH_SIZE;
+    
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            struct timespec start, end;
+            size_t before = count;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            int rc = lpm_aggregate(prefixes, lens, nhs, &count, LPM_IPV4_MAX_DEPTH);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            assert(rc == 0);
+            printf("  lpm_aggregate: %zu -> %zu prefixes in %.1f ms\n", before, count,
+                   time_diff_us(&start, &end) / 1000);
+        }
+        
+        lpm_trie_t *dir24 = lpm_create_ipv4_dir24();
+        lpm_trie_t *stride = lpm_create_ipv4_8stride();
+        assert(dir24 != NULL && stride != NULL);
+        for (size_t i = 0; i < count; i++) {
+            lpm_add(dir24, prefixes[i], lens[i], nhs[i]);
+            lpm_add(stride, prefixes[i], lens[i], nhs[i]);
+        }
+        
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int batch = 0; batch < num_batches; batch++) {
+            lpm_lookup_batch_ipv4(dir24, &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double dir24_ns = time_diff_us(&start, &end) * 1000 / total;
+        
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int batch = 0; batch < num_batches; batch++) {
+            lpm_lookup_batch_ipv4(stride, &addrs[batch * BATCH_SIZE], results, BATCH_SIZE);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double stride_ns = time_diff_us(&start, &end) * 1000 / total;
+        
+        printf("  %-10s %7zu prefixes | DIR-24-8: %5u tbl8 groups, %.2f ns/lookup | "
+               "8-bit stride: %6llu nodes, %.2f ns/lookup\n",
+               pass ? "Aggregated" : "Original", count, dir24->tbl8_groups_used, dir24_ns,
+               (unsigned long long)stride->num_nodes, stride_ns);
+        
+        lpm_destroy(dir24);
+        lpm_destroy(stride);
+    }
+    
+    free(results);
+    free(addrs);
+    free(nhs);
+    free(lens);
+    free(prefixes);
+}
+
+static void benchmark_ipv4_replace_next_hop(void)
+{
+    printf("\n=== IPv4 Next-Hop Replacement (peer down) ===\n");
+    
+    size_t count = (size_t)NUM_PREFIXES * 10;
+    uint8_t (*prefixes)[16] = malloc(count * sizeof(*prefixes));
+    uint8_t *lens = malloc(count);
+    uint32_t *nhs = malloc(count * sizeof(uint32_t));
+    count = generate_bgp_like_ipv4(prefixes, lens, nhs, count);
+    
+    lpm_trie_t *scan = lpm_create_ipv4_dir24();
+    lpm_trie_t *indexed = lpm_create_ipv4_dir24();
+    assert(scan != NULL && indexed != NULL);
+    assert(lpm_enable_next_hop_index(indexed) == 0);
+    for (size_t i = 0; i < count; i++) {
+        lpm_add(scan, prefixes[i], lens[i], nhs[i]);
+        lpm_add(indexed, prefixes[i], lens[i], nhs[i]);
+    }
+    printf("  %zu prefixes, %zu on the failed next hop\n", count, lpm_next_hop_count(indexed, 7));
+    
+    /* Baseline: scan the RIB and re-add every prefix of the peer */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < count; i++) {
+        if (nhs[i] == 7) {
+            lpm_add(scan, prefixes[i], lens[i], 100);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  %-30s %8.3f ms\n", "RIB scan + lpm_add", time_diff_us(&start, &end) / 1000);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lpm_replace_next_hop(scan, 100, 101);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  %-30s %8.3f ms\n", "lpm_replace_next_hop (scan)", time_diff_us(&start, &end) / 1000);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lpm_replace_next_hop(indexed, 7, 101);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  %-30s %8.3f ms\n", "lpm_replace_next_hop (index)", time_diff_us(&start, &end) / 1000);
+    
+    lpm_destroy(scan);
+    lpm_destroy(indexed);
+    free(nhs);
+    free(lens);
+    free(prefixes);
+}
+
+static void benchmark_ipv4_recovery(void)
+{
+    printf("\n=== IPv4 Restart: Rebuild vs Snapshot + Journal Replay ===\n");
+    
+    size_t count = (size_t)NUM_PREFIXES * 50;
+    uint8_t (*prefixes)[16] = malloc(count * sizeof(*prefixes));
+    uint8_t *lens = malloc(count);
+    uint32_t *nhs = malloc(count * sizeof(uint32_t));
+    count = generate_bgp_like_ipv4(prefixes, lens, nhs, count);
+    
+    /* Baseline: a cold start re-adds the whole table */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    lpm_trie_t *fib = lpm_create_ipv4_dir24();
+    assert(fib != NULL);
+    for (size_t i = 0; i < count; i++) {
+        lpm_add(fib, prefixes[i], lens[i], nhs[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  %zu prefixes\n", count);
+    printf("  %-34s %8.1f ms\n", "Rebuild (lpm_add x all)", time_diff_us(&start, &end) / 1000);
+    
+    char dir[] = "/tmp/lpm_bench_journal_XXXXXX";
+    char path[64], name[80];
+    if (!mkdtemp(dir)) {
+        lpm_destroy(fib);
+        free(nhs);
+        free(lens);
+        free(prefixes);
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/fib", dir);
+    
+    /* Group commit only on lpm_journal_sync(), no automatic snapshots */
+    lpm_journal_config_t cfg = { .sync_records = 0, .sync_us = 0, .snapshot_records = 0 };
+    int rc = lpm_enable_journal(fib, path, &cfg);
+    assert(rc == 0);
+    
+    static const size_t churn[] = { 0, 10000, 100000 };
+    size_t done = 0;
+    for (size_t c = 0; c < sizeof(churn) / sizeof(churn[0]); c++) {
+        /* Route churn since the snapshot: re-announce with new next hops */
+        for (; done < churn[c]; done++) {
+            size_t r = (size_t)rand() % count;
+            lpm_add(fib, prefixes[r], lens[r], (uint32_t)(rand() % 64));
+        }
+        rc = lpm_journal_sync(fib);
+        assert(rc == 0);
+        
+        lpm_recover_stats_t st;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        lpm_trie_t *back = lpm_recover(path, &cfg, &st);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        assert(back != NULL);
+        snprintf(name, sizeof(name), "lpm_recover, %zu records", (size_t)st.replayed);
+        printf("  %-34s %8.1f ms (snapshot %.1f MB in %.1f ms, replay %.1f ms)\n", name,
+               time_diff_us(&start, &end) / 1000, (double)st.snapshot_bytes / (1024 * 1024),
+               st.snapshot_ms, st.replay_ms);
+        lpm_destroy(back);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = lpm_snapshot(fib);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    assert(rc == 0);
+    printf("  %-34s %8.1f ms\n", "lpm_snapshot", time_diff_us(&start, &end) / 1000);
+    
+    lpm_destroy(fib);
+    snprintf(name, sizeof(name), "%s.snap", path);
+    unlink(name);
+    snprintf(name, sizeof(name), "%s.wal", path);
+    unlink(name);
+    rmdir(dir);
+    (void)rc;
+    free(nhs);
+    free(lens);
+    free(prefixes);
+}
+
+struct bench_writer {
+    lpm_trie_t *trie;
+    const uint8_t (*prefixes)[16];
+    const uint8_t *lens;
+    const uint32_t *nhs;
+    size_t count;
+    unsigned index;    /* Takes the /8s with top byte % stride == index */
+    unsigned stride;
+};
+
+static void *bench_writer_main(void *arg)
+{
+    struct bench_writer *w = arg;
+    for (size_t i = 0; i < w->count; i++) {
+        if (w->prefixes[i][0] % w->stride == w->index) {
+            lpm_add(w->trie, w->prefixes[i], w->lens[i], w->nhs[i]);
+        }
+    }
+    return NULL;
+}
+
+static void benchmark_ipv4_sharded_writers(void)
+{
+    printf("\n=== IPv4 Sharded Writers (full-table resync, DIR-24-8) ===\n");
+    
+    size_t count = (size_t)NUM_PREFIXES * 50;
+    uint8_t (*prefixes)[16] = malloc(count * sizeof(*prefixes));
+    uint8_t *lens = malloc(count);
+    uint32_t *nhs = malloc(count * sizeof(uint32_t));
+    count = generate_bgp_like_ipv4(prefixes, lens, nhs, count);
+    printf("  %zu prefixes\n", count);
+    
+    static const unsigned threads[] = { 0, 1, 2, 4, 8 };   /* 0: not sharded */
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        lpm_trie_t *trie = lpm_create_ipv4_dir24();
+        assert(trie != NULL);
+        unsigned n = threads[t] ? threads[t] : 1;
+        if (threads[t]) {
+            int rc = lpm_enable_sharded_writers(trie, 8);
+            assert(rc == 0);
+            (void)rc;
+        }
+        
+        struct bench_writer w[8];
+        pthread_t tids[8];
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned i = 0; i < n; i++) {
+            w[i] = (struct bench_writer){ .trie = trie, .prefixes = prefixes, .lens = lens, .nhs = nhs,
+                                          .count = count, .index = i, .stride = n };
+            pthread_create(&tids[i], NULL, bench_writer_main, &w[i]);
+        }
+        for (unsigned i = 0; i < n; i++) {
+            pthread_join(tids[i], NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        
+        double us = time_diff_us(&start, &end);
+        char label[32];
+        snprintf(label, sizeof(label), threads[t] ? "Sharded, %u writer%s" : "Unsharded, 1 writer",
+                 n, n > 1 ? "s" : "");
+        printf("  %-22s %8.1f ms  %6.2f M updates/sec\n", label, us / 1000, (double)count / us);
+        lpm_destroy(trie);
+    }
+    
+    free(nhs);
+    free(lens);
+    free(prefixes);
+}
+
+static void benchmark_ipv4_async_updates(void)
+{
+    printf("\n=== IPv4 Async Update Queue (route flaps, DIR-24-8) ===\n");
+    
+    size_t count = (size_t)NUM_PREFIXES * 50;
+    uint8_t (*prefixes)[16] = malloc(count * sizeof(*prefixes));
+    uint8_t *lens = malloc(count);
+    uint32_t *nhs = malloc(count * sizeof(uint32_t));
+    count = generate_bgp_like_ipv4(prefixes, lens, nhs, count);
+    
+    /* Every route is announced, re-announced with another next hop within
+     * a window of 32 routes, and every fourth withdrawn */
+    size_t ops = 0;
+    for (size_t i = 0; i < count; i++) {
+        ops += 2 + (i % 4 == 0);
+    }
+    printf("  %zu prefixes, %zu updates\n", count, ops);
+    
+    static const uint32_t batches[] = { 0, 64, 1024, 4096 };   /* 0: lpm_add()/lpm_delete() */
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        lpm_trie_t *trie = lpm_create_ipv4_dir24();
+        assert(trie != NULL);
+        if (batches[b]) {
+            lpm_async_config_t cfg = { .queue_size = 1U << 20, .batch_size = batches[b] };
+            int rc = lpm_enable_async_updates(trie, &cfg);
+            assert(rc == 0);
+            (void)rc;
+        }
+        
+        struct timespec start, queued, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t seq = 0;
+        for (size_t base = 0; base < count; base += 32) {
+            size_t top = base + 32 < count ? base + 32 : count;
+            for (int pass = 0; pass < 2; pass++) {
+                for (size_t i = base; i < top; i++) {
+                    if (batches[b]) {
+                        seq = lpm_add_async(trie, prefixes[i], lens[i], nhs[i] + pass);
+                    } else {
+                        lpm_add(trie, prefixes[i], lens[i], nhs[i] + pass);
+                    }
+                }
+            }
+            for (size_t i = base; i < top; i++) {
+                if (i % 4) { continue; }
+                if (batches[b]) {
+                    seq = lpm_delete_async(trie, prefixes[i], lens[i]);
+                } else {
+                    lpm_delete(trie, prefixes[i], lens[i]);
+                }
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &queued);
+        if (batches[b]) {
+            lpm_async_wait(trie, seq);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        
+        double us = time_diff_us(&start, &end);
+        if (!batches[b]) {
+            printf("  %-18s %8.1f ms  %6.2f M updates/sec\n", "Synchronous", us / 1000, (double)ops / us);
+        } else {
+            lpm_async_stats_t st;
+            lpm_async_stats(trie, &st);
+            char label[32];
+            snprintf(label, sizeof(label), "Async, batch %u", batches[b]);
+            printf("  %-18s %8.1f ms  %6.2f M updates/sec  (enqueue %.1f ms, %.1f%% coalesced, "
+                   "max depth %llu, latency avg %.0f us max %.0f us)\n",
+                   label, us / 1000, (double)ops / us, time_diff_us(&start, &queued) / 1000,
+                   100.0 * (double)st.coalesced / (double)st.enqueued, (unsigned long long)st.max_depth,
+                   st.latency_avg_us, st.latency_max_us);
+        }
+        lpm_destroy(trie);
+    }
+    
+    free(nhs);
+    free(lens);
+    free(prefixes);
+}
+
 static void benchmark_ipv6_single_lookup(void)
 {
     printf("\n=== IPv6 Single Lookup Benchmark ===\n");
@@ -249,6 +971,296 @@ static void benchmark_ipv6_batch_lookup(void)
     lpm_destroy(trie);
 }
 
+static void benchmark_ipv6_wide_levels(void)
+{
+    printf("\n=== IPv6 Wide16: 1-3 wide levels on a /32 + /48 table ===\n");
+    
+    /* Allocation-shaped table: 2000 /32s with 20 /48s each */
+    enum { N32 = 2000, PER32 = 20 };
+    static uint8_t p32[N32][16];
+    for (int i = 0; i < N32; i++) {
+        memset(p32[i], 0, 16);
+        p32[i][0] = 0x20 | (rand() % 2);
+        p32[i][1] = rand() % 256;
+        p32[i][2] = rand() % 256;
+        p32[i][3] = rand() % 256;
+    }
+    
+    int num_batches = NUM_LOOKUPS / BATCH_SIZE;
+    uint8_t (*test_addrs)[16] = malloc(num_batches * BATCH_SIZE * sizeof(*test_addrs));
+    uint32_t *next_hops = malloc(BATCH_SIZE * sizeof(uint32_t));
+    
+    for (uint8_t levels = 1; levels <= LPM_IPV6_WIDE_STRIDE_MAX_LEVELS; levels++) {
+        lpm_trie_t *trie = lpm_create_ipv6_wide16_levels(levels);
+        assert(trie != NULL);
+        srand(7);
+        for (int i = 0; i < N32; i++) {
+            lpm_add(trie, p32[i], 32, i);
+            for (int j = 0; j < PER32; j++) {
+                uint8_t p48[16];
+                memcpy(p48, p32[i], 16);
+                p48[4] = rand() % 256;
+                p48[5] = rand() % 256;
+                lpm_add(trie, p48, 48, N32 + i * PER32 + j);
+            }
+        }
+        /* Addresses inside the /32s; one in PER32 / 65536 also hits a /48 */
+        for (int i = 0; i < num_batches * BATCH_SIZE; i++) {
+            generate_random_ipv6(test_addrs[i]);
+            memcpy(test_addrs[i], p32[rand() % N32], 4);
+        }
+        
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int batch = 0; batch < num_batches; batch++) {
+            lpm_lookup_batch_ipv6(trie, &test_addrs[batch * BATCH_SIZE], next_hops, BATCH_SIZE);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        
+        double total = (double)num_batches * BATCH_SIZE;
+        double us = time_diff_us(&start, &end);
+        printf("  %u wide level%s: %.2f ns/lookup, %6lu 8-bit nodes (%.1f MB)\n", levels,
+               levels > 1 ? "s" : " ", us * 1000 / total, (unsigned long)trie->num_nodes,
+               (double)trie->num_nodes * sizeof(lpm_node_t) / (1024.0 * 1024.0));
+        lpm_destroy(trie);
+    }
+    
+    free(test_addrs);
+    free(next_hops);
+}
+
+static void benchmark_ipv6_range_cache(void)
+{
+    printf("\n=== IPv6 Range Cache: Zipf traffic over /64 subnets ===\n");
+    
+    /* Allocation-shaped table: 2000 /32s with 20 /48s each */
+    enum { N32 = 2000, PER32 = 20, SUBNETS = 100000 };
+    static uint8_t p48[N32 * PER32][16];
+    for (int i = 0; i < N32; i++) {
+        uint8_t p32[16] = {0};
+        p32[0] = 0x20 | (rand() % 2);
+        p32[1] = rand() % 256;
+        p32[2] = rand() % 256;
+        p32[3] = rand() % 256;
+        for (int j = 0; j < PER32; j++) {
+            memcpy(p48[i * PER32 + j], p32, 16);
+            p48[i * PER32 + j][4] = rand() % 256;
+            p48[i * PER32 + j][5] = rand() % 256;
+        }
+    }
+    
+    /* Active /64s inside the /48s; subnet k carries traffic in proportion
+     * to 1/(k+1), each packet to a random host */
+    static uint8_t subnets[SUBNETS][8];
+    double *cdf = malloc(SUBNETS * sizeof(double));
+    double sum = 0;
+    for (int k = 0; k < SUBNETS; k++) {
+        memcpy(subnets[k], p48[rand() % (N32 * PER32)], 6);
+        subnets[k][6] = rand() % 256;
+        subnets[k][7] = rand() % 256;
+        sum += 1.0 / (k + 1);
+        cdf[k] = sum;
+    }
+    uint8_t (*test_addrs)[16] = malloc(NUM_LOOKUPS * sizeof(*test_addrs));
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        double u = (double)rand() / RAND_MAX * sum;
+        int lo = 0, hi = SUBNETS - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cdf[mid] < u) { lo = mid + 1; } else { hi = mid; }
+        }
+        generate_random_ipv6(test_addrs[i]);
+        memcpy(test_addrs[i], subnets[lo], 8);
+    }
+    
+    for (int e = 0; e < 2; e++) {
+        lpm_trie_t *trie = e == 0 ? lpm_create_ipv6_8stride() : lpm_create_ipv6_wide16();
+        assert(trie != NULL);
+        for (int i = 0; i < N32 * PER32; i++) {
+            lpm_add(trie, p48[i], 48, i);
+        }
+        
+        static const uint32_t sizes[] = { 0, 1024, 4096, 65536 };   /* 0: uncached */
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            lpm_range_cache_t *cache = sizes[s] ? lpm_range_cache_create(trie, sizes[s]) : NULL;
+            volatile uint32_t sink = 0;
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int i = 0; i < NUM_LOOKUPS; i++) {
+                sink += cache ? lpm_lookup_ipv6_cached(cache, test_addrs[i])
+                              : lpm_lookup_ipv6(trie, test_addrs[i]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            
+            double ns = time_diff_us(&start, &end) * 1000 / NUM_LOOKUPS;
+            const char *engine = e == 0 ? "6stride8" : "wide16";
+            if (!cache) {
+                printf("  %-8s uncached          %6.2f ns/lookup\n", engine, ns);
+                continue;
+            }
+            lpm_range_cache_stats_t st;
+            lpm_range_cache_stats(cache, &st);
+            printf("  %-8s cache %6u       %6.2f ns/lookup  %5.1f%% hits\n", engine, sizes[s], ns,
+                   100.0 * (double)st.hits / (double)(st.hits + st.misses));
+            lpm_range_cache_destroy(cache);
+        }
+        lpm_destroy(trie);
+    }
+    
+    free(test_addrs);
+    free(cdf);
+}
+
+/* ============================================================================
+ * Inline Kernels: exported lookups vs lpm_inline.h
+ * Same tables and traffic three ways: lpm_lookup_ipv4/6(), the engine's own
+ * exported lookup, and the static-inline kernel. The traffic hits installed
+ * prefixes from a cache-resident pool, so the call and the per-call checks
+ * are not hidden behind cache misses.
+ * ============================================================================ */
+
+#define INLINE_PREFIXES 4000      /* Under LPM_SMALL_MAX_PREFIXES */
+#define INLINE_POOL 16384
+
+enum { VIA_GENERIC, VIA_ENGINE, VIA_INLINE };
+static const char *const via_names[] = { "lpm_lookup", "engine export", "lpm_inline.h" };
+
+static uint32_t ipv4_engine_export(const lpm_trie_t *trie, lpm_inline_engine_t e, uint32_t addr)
+{
+    switch (e) {
+    case LPM_INLINE_IPV4_DIR24:  return lpm_lookup_ipv4_dir24(trie, addr);
+    case LPM_INLINE_IPV4_DIR24C: return lpm_lookup_ipv4_dir24_compact(trie, addr);
+    case LPM_INLINE_IPV4_SMALL:  return lpm_lookup_ipv4_small(trie, addr);
+    case LPM_INLINE_IPV4_LCTRIE: return lpm_lookup_ipv4_lctrie(trie, addr);
+    default:                     return lpm_lookup_ipv4_8stride(trie, addr);
+    }
+}
+
+static uint32_t ipv6_engine_export(const lpm_trie_t *trie, lpm_inline_engine_t e, const uint8_t addr[16])
+{
+    return e == LPM_INLINE_IPV6_WIDE16 ? lpm_lookup_ipv6_wide16(trie, addr)
+                                       : lpm_lookup_ipv6_8stride(trie, addr);
+}
+
+/* ns per lookup; *sum receives the checksum of the results */
+static double time_ipv4_via(const lpm_trie_t *trie, int via, const uint32_t *pool, uint32_t *sum)
+{
+    lpm_inline_engine_t e = lpm_inline_engine(trie);
+    struct timespec start, end;
+    uint32_t s = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        uint32_t a = pool[i & (INLINE_POOL - 1)];
+        switch (via) {
+        case VIA_GENERIC: s += lpm_lookup_ipv4(trie, a); break;
+        case VIA_ENGINE:  s += ipv4_engine_export(trie, e, a); break;
+        default:          s += lpm_inline_lookup_ipv4(trie, e, a); break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *sum = s;
+    return time_diff_us(&start, &end) * 1000 / NUM_LOOKUPS;
+}
+
+static double time_ipv6_via(const lpm_trie_t *trie, int via, const uint8_t (*pool)[16], uint32_t *sum)
+{
+    lpm_inline_engine_t e = lpm_inline_engine(trie);
+    struct timespec start, end;
+    uint32_t s = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        const uint8_t *a = pool[i & (INLINE_POOL - 1)];
+        switch (via) {
+        case VIA_GENERIC: s += lpm_lookup_ipv6(trie, a); break;
+        case VIA_ENGINE:  s += ipv6_engine_export(trie, e, a); break;
+        default:          s += lpm_inline_lookup_ipv6(trie, e, a); break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *sum = s;
+    return time_diff_us(&start, &end) * 1000 / NUM_LOOKUPS;
+}
+
+static void print_via_row(const char *engine, const double *ns, const uint32_t *sum)
+{
+    printf("  %-9s", engine);
+    for (int v = VIA_GENERIC; v <= VIA_INLINE; v++) {
+        printf("  %14.2f", ns[v]);
+    }
+    printf("  %6.2fx%s\n", ns[VIA_GENERIC] / ns[VIA_INLINE],
+           (sum[VIA_ENGINE] != sum[VIA_GENERIC] || sum[VIA_INLINE] != sum[VIA_GENERIC]) ? "  MISMATCH" : "");
+}
+
+static void benchmark_inline_kernels(void)
+{
+    printf("\n=== Single Lookup: Exported Functions vs lpm_inline.h Kernels ===\n");
+    printf("  %-9s  %14s  %14s  %14s  %7s\n", "engine", via_names[0], via_names[1], via_names[2], "gain");
+    printf("  %-9s  %14s  %14s  %14s\n", "", "ns/lookup", "ns/lookup", "ns/lookup");
+
+    uint8_t (*prefixes)[16] = malloc(INLINE_PREFIXES * sizeof(*prefixes));
+    uint8_t *lens = malloc(INLINE_PREFIXES);
+    uint32_t *pool4 = malloc(INLINE_POOL * sizeof(uint32_t));
+    uint8_t (*pool6)[16] = malloc(INLINE_POOL * sizeof(*pool6));
+    double ns[3];
+    uint32_t sum[3];
+
+    /* IPv4: /8-/32 prefixes; traffic inside them */
+    for (int i = 0; i < INLINE_PREFIXES; i++) {
+        generate_random_ipv4(prefixes[i]);
+        lens[i] = 8 + (rand() % 25);
+    }
+    for (int i = 0; i < INLINE_POOL; i++) {
+        const uint8_t *p = prefixes[rand() % INLINE_PREFIXES];
+        uint32_t a = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        pool4[i] = a ^ ((uint32_t)rand() & 0xFF);
+    }
+    const char *names4[] = { "dir24", "dir24c", "small", "lctrie", "4stride8" };
+    lpm_trie_t *tries4[] = { lpm_create_ipv4_dir24(), lpm_create_ipv4_dir24_compact(),
+                             lpm_create_ipv4_small(), lpm_create_ipv4_lctrie(),
+                             lpm_create_ipv4_8stride() };
+    for (int t = 0; t < 5; t++) {
+        assert(tries4[t] != NULL);
+        for (int i = 0; i < INLINE_PREFIXES; i++) {
+            lpm_add(tries4[t], prefixes[i], lens[i], i);
+        }
+        for (int v = VIA_GENERIC; v <= VIA_INLINE; v++) {
+            ns[v] = time_ipv4_via(tries4[t], v, pool4, &sum[v]);
+        }
+        print_via_row(names4[t], ns, sum);
+        lpm_destroy(tries4[t]);
+    }
+
+    /* IPv6: /16-/64 prefixes; traffic inside them */
+    for (int i = 0; i < INLINE_PREFIXES; i++) {
+        generate_random_ipv6(prefixes[i]);
+        lens[i] = 16 + (rand() % 49);
+    }
+    for (int i = 0; i < INLINE_POOL; i++) {
+        memcpy(pool6[i], prefixes[rand() % INLINE_PREFIXES], 16);
+        pool6[i][15] ^= (uint8_t)rand();
+    }
+    const char *names6[] = { "wide16", "6stride8" };
+    lpm_trie_t *tries6[] = { lpm_create_ipv6_wide16(), lpm_create_ipv6_8stride() };
+    for (int t = 0; t < 2; t++) {
+        assert(tries6[t] != NULL);
+        for (int i = 0; i < INLINE_PREFIXES; i++) {
+            lpm_add(tries6[t], prefixes[i], lens[i], i);
+        }
+        for (int v = VIA_GENERIC; v <= VIA_INLINE; v++) {
+            ns[v] = time_ipv6_via(tries6[t], v, pool6, &sum[v]);
+        }
+        print_via_row(names6[t], ns, sum);
+        lpm_destroy(tries6[t]);
+    }
+
+    free(pool6);
+    free(pool4);
+    free(lens);
+    free(prefixes);
+}
+
 static void benchmark_memory_usage(void)
 {
     printf("\n=== Memory Usage Analysis ===\n");
@@ -296,8 +1308,22 @@ int main(void)
     /* Run benchmarks */
     benchmark_ipv4_single_lookup();
     benchmark_ipv4_batch_lookup();
+    benchmark_ipv4_multi_table_lookup();
+    benchmark_ipv4_dir24_compact();
+    benchmark_ipv4_prefault();
+    benchmark_ipv4_small_table();
+    benchmark_ipv4_adaptive();
+    benchmark_ipv4_set();
+    benchmark_ipv4_aggregation();
+    benchmark_ipv4_replace_next_hop();
+    benchmark_ipv4_recovery();
+    benchmark_ipv4_sharded_writers();
+    benchmark_ipv4_async_updates();
     benchmark_ipv6_single_lookup();
     benchmark_ipv6_batch_lookup();
+    benchmark_ipv6_wide_levels();
+    benchmark_ipv6_range_cache();
+    benchmark_inline_kernels();
     benchmark_memory_usage();
     
     printf("\nBenchmark complete!\n");
@@ -0,0 +1,123 @@
+/*
+ * Java driver for the binding overhead benchmark.
+ *
+ * Usage: java -cp <liblpm jar>:. BenchBindings TABLE TRACE
+ *
+ * Follows the protocol in benchmarks/bench_bindings.c. HotSpot only counts
+ * allocated bytes per thread, so allocs_per_call stays empty. Batches are
+ * cut from the trace up front, as the JNI batch call takes whole arrays.
+ */
+
+import com.github.murilochianfa.liblpm.LpmTableIPv4;
+import com.github.murilochianfa.liblpm.NextHop;
+
+import java.io.IOException;
+import java.lang.management.ManagementFactory;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.Arrays;
+import java.util.List;
+
+public class BenchBindings {
+    private static final int BENCH_PASSES = 3;
+    private static final int[] BATCH_SIZES = {16, 256, 4096};
+
+    private static final com.sun.management.ThreadMXBean THREADS =
+        (com.sun.management.ThreadMXBean) ManagementFactory.getThreadMXBean();
+
+    private static long runSingle(LpmTableIPv4 table, int[] addrs) {
+        long sum = 0;
+        for (int addr : addrs) {
+            int nh = table.lookup(addr);
+            if (nh != NextHop.INVALID) {
+                sum += Integer.toUnsignedLong(nh);
+            }
+        }
+        return sum;
+    }
+
+    private static long runBatch(LpmTableIPv4 table, int[][] batches, int[] results) {
+        long sum = 0;
+        for (int[] batch : batches) {
+            table.lookupBatchFast(batch, results);
+            for (int i = 0; i < batch.length; i++) {
+                if (results[i] != NextHop.INVALID) {
+                    sum += Integer.toUnsignedLong(results[i]);
+                }
+            }
+        }
+        return sum;
+    }
+
+    private static void measure(LpmTableIPv4 table, int[] addrs, int batch) {
+        int calls = batch == 0 ? addrs.length : addrs.length / batch;
+        long lookups = batch == 0 ? addrs.length : (long) calls * batch;
+        int[][] batches = new int[batch == 0 ? 0 : calls][];
+        for (int i = 0; i < batches.length; i++) {
+            batches[i] = Arrays.copyOfRange(addrs, i * batch, (i + 1) * batch);
+        }
+        int[] results = new int[Math.max(batch, 1)];
+
+        long checksum = batch == 0 ? runSingle(table, addrs) : runBatch(table, batches, results);
+
+        long tid = Thread.currentThread().getId();
+        long bytes0 = THREADS.getThreadAllocatedBytes(tid);
+        if (batch == 0) {
+            runSingle(table, addrs);
+        } else {
+            runBatch(table, batches, results);
+        }
+        long bytes = THREADS.getThreadAllocatedBytes(tid) - bytes0;
+
+        long best = Long.MAX_VALUE;
+        for (int p = 0; p < BENCH_PASSES; p++) {
+            long t0 = System.nanoTime();
+            if (batch == 0) {
+                runSingle(table, addrs);
+            } else {
+                runBatch(table, batches, results);
+            }
+            best = Math.min(best, System.nanoTime() - t0);
+        }
+
+        System.out.printf("java,%s,%s,%d,%d,%.3f,,%.3f,%d%n",
+            batch == 0 ? "LpmTableIPv4.lookup" : "LpmTableIPv4.lookupBatchFast",
+            batch == 0 ? "single" : "batch", Math.max(batch, 1), lookups,
+            (double) best / lookups, (double) bytes / calls, checksum);
+    }
+
+    private static int parseIPv4(String s) {
+        String[] parts = s.split("\\.");
+        return (Integer.parseInt(parts[0]) << 24) | (Integer.parseInt(parts[1]) << 16)
+             | (Integer.parseInt(parts[2]) << 8) | Integer.parseInt(parts[3]);
+    }
+
+    public static void main(String[] args) throws IOException {
+        if (args.length != 2) {
+            System.err.println("Usage: BenchBindings TABLE TRACE");
+            System.exit(1);
+        }
+
+        try (LpmTableIPv4 table = LpmTableIPv4.create()) {
+            for (String line : Files.readAllLines(Paths.get(args[0]))) {
+                if (line.isEmpty() || line.startsWith("#")) {
+                    continue;
+                }
+                String[] fields = line.trim().split("\\s+");
+                table.insert(fields[0], Integer.parseInt(fields[1]));
+            }
+
+            List<String> lines = Files.readAllLines(Paths.get(args[1]));
+            int[] addrs = lines.stream().filter(l -> !l.isEmpty()).mapToInt(BenchBindings::parseIPv4).toArray();
+            if (addrs.length < BATCH_SIZES[BATCH_SIZES.length - 1]) {
+                System.err.println("Trace " + args[1] + " is too short");
+                System.exit(1);
+            }
+
+            measure(table, addrs, 0);
+            for (int batch : BATCH_SIZES) {
+                measure(table, addrs, batch);
+            }
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// bench_bindings.cpp - C++ wrapper driver for the binding overhead benchmark
+//
+// Usage: bench_bindings_cpp TABLE TRACE
+// Follows the protocol in benchmarks/bench_bindings.c. Allocations are
+// counted by replacing the global operator new.
+
+#include <liblpm>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+
+static size_t alloc_calls;
+static size_t alloc_bytes;
+
+void* operator new(std::size_t size) {
+    alloc_calls++;
+    alloc_bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr int BENCH_PASSES = 3;
+constexpr size_t BATCH_SIZES[] = {16, 256, 4096};
+
+using Addr = std::array<uint8_t, 4>;
+
+struct Workload {
+    const liblpm::LpmTableIPv4& table;
+    const std::vector<Addr>& addrs;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<uint32_t> results;
+};
+
+uint64_t run_pass(Workload& w, size_t batch) {
+    uint64_t sum = 0;
+    const size_t count = w.addrs.size();
+
+    if (batch == 0) {
+        for (const Addr& a : w.addrs) {
+            uint32_t nh = w.table.lookup(a.data());
+            sum += nh != LPM_INVALID_NEXT_HOP ? nh : 0;
+        }
+        return sum;
+    }
+    for (size_t i = 0; i + batch <= count; i += batch) {
+        w.table.lookup_batch(liblpm::span<const uint8_t* const>(&w.ptrs[i], batch),
+                             liblpm::span<uint32_t>(w.results.data(), batch));
+        for (size_t j = 0; j < batch; j++) {
+            sum += w.results[j] != LPM_INVALID_NEXT_HOP ? w.results[j] : 0;
+        }
+    }
+    return sum;
+}
+
+void measure(Workload& w, size_t batch) {
+    const size_t count = w.addrs.size();
+    const size_t lookups = batch ? count / batch * batch : count;
+    const size_t calls = batch ? count / batch : count;
+
+    uint64_t checksum = run_pass(w, batch);
+
+    size_t calls0 = alloc_calls, bytes0 = alloc_bytes;
+    run_pass(w, batch);
+    size_t allocs = alloc_calls - calls0, bytes = alloc_bytes - bytes0;
+
+    double best = 0;
+    for (int p = 0; p < BENCH_PASSES; p++) {
+        auto t0 = std::chrono::steady_clock::now();
+        run_pass(w, batch);
+        double t = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - t0).count();
+        if (p == 0 || t < best) best = t;
+    }
+
+    std::printf("cpp,%s,%s,%zu,%zu,%.3f,%.3f,%.3f,%llu\n",
+                batch ? "LpmTable::lookup_batch" : "LpmTable::lookup",
+                batch ? "batch" : "single", batch ? batch : size_t{1}, lookups,
+                best / lookups, double(allocs) / calls, double(bytes) / calls,
+                static_cast<unsigned long long>(checksum));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s TABLE TRACE\n", argv[0]);
+        return 1;
+    }
+
+    liblpm::LpmTableIPv4 table;
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        char addr[32];
+        unsigned len;
+        unsigned long nh;
+        Addr prefix;
+        if (line.empty() || line[0] == '#' ||
+            std::sscanf(line.c_str(), "%31[0-9.]/%u %lu", addr, &len, &nh) != 3 ||
+            inet_pton(AF_INET, addr, prefix.data()) != 1 || len > 32) {
+            continue;
+        }
+        table.insert(prefix.data(), static_cast<uint8_t>(len), static_cast<uint32_t>(nh));
+    }
+
+    std::ifstream trace(argv[2]);
+    std::vector<Addr> addrs;
+    while (std::getline(trace, line)) {
+        Addr a;
+        if (inet_pton(AF_INET, line.c_str(), a.data()) == 1) {
+            addrs.push_back(a);
+        }
+    }
+    if (addrs.size() < BATCH_SIZES[std::size(BATCH_SIZES) - 1]) {
+        std::fprintf(stderr, "Trace %s is unreadable or too short\n", argv[2]);
+        return 1;
+    }
+
+    Workload w{table, addrs, {}, std::vector<uint32_t>(BATCH_SIZES[std::size(BATCH_SIZES) - 1])};
+    w.ptrs.reserve(addrs.size());
+    for (const Addr& a : addrs) {
+        w.ptrs.push_back(a.data());
+    }
+
+    measure(w, 0);
+    for (size_t batch : BATCH_SIZES) {
+        measure(w, batch);
+    }
+    return 0;
+}
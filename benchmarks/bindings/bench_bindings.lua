@@ -0,0 +1,101 @@
+#!/usr/bin/env lua
+-- ============================================================================
+-- bench_bindings.lua - Lua driver for the binding overhead benchmark
+-- ============================================================================
+--
+-- Run: lua bench_bindings.lua TABLE TRACE
+--
+-- Follows the protocol in benchmarks/bench_bindings.c. Addresses are passed
+-- as 4-byte binary strings. The collector is stopped while counting, and
+-- collectgarbage("count") only reports bytes, so allocs_per_call stays empty.
+--
+-- ============================================================================
+
+local lpm = require("liblpm")
+local unpack = table.unpack or unpack
+
+local BENCH_PASSES = 3
+local BATCH_SIZES = { 16, 256, 4096 }
+
+local function run_pass(t, addrs, batches, batch)
+    local sum = 0
+    if batch == 0 then
+        for i = 1, #addrs do
+            local nh = t:lookup(addrs[i])
+            if nh then sum = sum + nh end
+        end
+        return sum
+    end
+    for b = 1, #batches do
+        local results = t:lookup_batch(batches[b])
+        for j = 1, batch do
+            local nh = results[j]
+            if nh then sum = sum + nh end
+        end
+    end
+    return sum
+end
+
+local function measure(t, addrs, batch)
+    local batches = {}
+    if batch > 0 then
+        for i = 1, #addrs - batch + 1, batch do
+            batches[#batches + 1] = { unpack(addrs, i, i + batch - 1) }
+        end
+    end
+    local calls = batch > 0 and #batches or #addrs
+    local lookups = batch > 0 and calls * batch or #addrs
+
+    local checksum = run_pass(t, addrs, batches, batch)
+
+    collectgarbage("collect")
+    collectgarbage("stop")
+    local kb0 = collectgarbage("count")
+    run_pass(t, addrs, batches, batch)
+    local bytes = (collectgarbage("count") - kb0) * 1024
+    collectgarbage("restart")
+
+    local best
+    for _ = 1, BENCH_PASSES do
+        local t0 = os.clock()
+        run_pass(t, addrs, batches, batch)
+        local elapsed = os.clock() - t0
+        if not best or elapsed < best then best = elapsed end
+    end
+
+    print(string.format("lua,%s,%s,%d,%d,%.3f,,%.3f,%d",
+        batch > 0 and "table:lookup_batch" or "table:lookup",
+        batch > 0 and "batch" or "single", batch > 0 and batch or 1, lookups,
+        best * 1e9 / lookups, bytes / calls, checksum))
+end
+
+if #arg ~= 2 then
+    io.stderr:write("Usage: lua bench_bindings.lua TABLE TRACE\n")
+    os.exit(1)
+end
+
+local t = lpm.new_ipv4()
+for line in io.lines(arg[1]) do
+    local prefix, nh = line:match("^(%d+%.%d+%.%d+%.%d+/%d+)%s+(%d+)")
+    if prefix then
+        t:insert(prefix, tonumber(nh))
+    end
+end
+
+local addrs = {}
+for line in io.lines(arg[2]) do
+    local a, b, c, d = line:match("^(%d+)%.(%d+)%.(%d+)%.(%d+)")
+    if a then
+        addrs[#addrs + 1] = string.char(tonumber(a), tonumber(b), tonumber(c), tonumber(d))
+    end
+end
+if #addrs < BATCH_SIZES[#BATCH_SIZES] then
+    io.stderr:write("Trace " .. arg[2] .. " is too short\n")
+    os.exit(1)
+end
+
+measure(t, addrs, 0)
+for _, batch in ipairs(BATCH_SIZES) do
+    measure(t, addrs, batch)
+end
+t:close()
@@ -0,0 +1,93 @@
+<?php
+/**
+ * bench_bindings.php - PHP driver for the binding overhead benchmark
+ *
+ * Usage: php -d extension=liblpm.so bench_bindings.php TABLE TRACE
+ *
+ * Follows the protocol in benchmarks/bench_bindings.c. memory_get_usage()
+ * only reports bytes, so allocs_per_call stays empty. bytes_per_call is the
+ * growth of the Zend heap over one pass, so results that are freed again
+ * within the pass do not show up.
+ */
+
+const BENCH_PASSES = 3;
+const BATCH_SIZES = [16, 256, 4096];
+
+function run_pass(LpmTableIPv4 $table, array $addrs, ?array $batches): int
+{
+    $sum = 0;
+    if ($batches === null) {
+        foreach ($addrs as $addr) {
+            $nh = $table->lookup($addr);
+            if ($nh !== false) {
+                $sum += $nh;
+            }
+        }
+        return $sum;
+    }
+    foreach ($batches as $batch) {
+        foreach ($table->lookupBatch($batch) as $nh) {
+            if ($nh !== false) {
+                $sum += $nh;
+            }
+        }
+    }
+    return $sum;
+}
+
+function measure(LpmTableIPv4 $table, array $addrs, int $batch): void
+{
+    $batches = $batch ? array_chunk($addrs, $batch) : null;
+    if ($batches && count(end($batches)) < $batch) {
+        array_pop($batches);
+    }
+    $calls = $batch ? count($batches) : count($addrs);
+    $lookups = $batch ? $calls * $batch : count($addrs);
+
+    $checksum = run_pass($table, $addrs, $batches);
+
+    $mem0 = memory_get_usage();
+    run_pass($table, $addrs, $batches);
+    $bytes = max(0, memory_get_usage() - $mem0);
+
+    $best = null;
+    for ($p = 0; $p < BENCH_PASSES; $p++) {
+        $t0 = hrtime(true);
+        run_pass($table, $addrs, $batches);
+        $elapsed = hrtime(true) - $t0;
+        if ($best === null || $elapsed < $best) {
+            $best = $elapsed;
+        }
+    }
+
+    printf("php,%s,%s,%d,%d,%.3f,,%.3f,%d\n",
+        $batch ? 'LpmTableIPv4::lookupBatch' : 'LpmTableIPv4::lookup',
+        $batch ? 'batch' : 'single', $batch ?: 1, $lookups,
+        $best / $lookups, $bytes / $calls, $checksum);
+}
+
+if ($argc !== 3) {
+    fwrite(STDERR, "Usage: php bench_bindings.php TABLE TRACE\n");
+    exit(1);
+}
+
+$table = new LpmTableIPv4();
+foreach (file($argv[1], FILE_IGNORE_NEW_LINES | FILE_SKIP_EMPTY_LINES) as $line) {
+    if ($line[0] === '#') {
+        continue;
+    }
+    [$prefix, $nh] = preg_split('/\s+/', trim($line));
+    $table->insert($prefix, (int)$nh);
+}
+
+$addrs = file($argv[2], FILE_IGNORE_NEW_LINES | FILE_SKIP_EMPTY_LINES);
+if ($addrs === false || count($addrs) < BATCH_SIZES[count(BATCH_SIZES) - 1]) {
+    fwrite(STDERR, "Trace {$argv[2]} is unreadable or too short\n");
+    exit(1);
+}
+
+measure($table, $addrs, 0);
+foreach (BATCH_SIZES as $batch) {
+    measure($table, $addrs, $batch);
+}
+$table->close();
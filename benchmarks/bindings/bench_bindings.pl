@@ -0,0 +1,88 @@
+#!/usr/bin/env perl
+#
+# bench_bindings.pl - Perl driver for the binding overhead benchmark
+#
+# Usage: perl bench_bindings.pl TABLE TRACE
+#
+# Follows the protocol in benchmarks/bench_bindings.c. Perl has no per-call
+# allocation counter, so the allocation columns stay empty.
+#
+
+use strict;
+use warnings;
+use FindBin qw($Bin);
+use lib "$Bin/../../bindings/perl/lib", "$Bin/../../bindings/perl/blib/lib",
+        "$Bin/../../bindings/perl/blib/arch";
+use Time::HiRes qw(clock_gettime CLOCK_MONOTONIC);
+use Net::LPM;
+
+use constant BENCH_PASSES => 3;
+my @BATCH_SIZES = (16, 256, 4096);
+
+sub run_pass {
+    my ($table, $addrs, $batches) = @_;
+    my $sum = 0;
+
+    unless ($batches) {
+        for my $addr (@$addrs) {
+            my $nh = $table->lookup($addr);
+            $sum += $nh if defined $nh;
+        }
+        return $sum;
+    }
+    for my $batch (@$batches) {
+        for my $nh ($table->lookup_batch($batch)) {
+            $sum += $nh if defined $nh;
+        }
+    }
+    return $sum;
+}
+
+sub measure {
+    my ($table, $addrs, $batch) = @_;
+    my $batches;
+    if ($batch) {
+        $batches = [];
+        for (my $i = 0; $i + $batch <= @$addrs; $i += $batch) {
+            push @$batches, [ @$addrs[$i .. $i + $batch - 1] ];
+        }
+    }
+    my $lookups = $batch ? @$batches * $batch : scalar @$addrs;
+
+    my $checksum = run_pass($table, $addrs, $batches);
+
+    my $best;
+    for (1 .. BENCH_PASSES) {
+        my $t0 = clock_gettime(CLOCK_MONOTONIC);
+        run_pass($table, $addrs, $batches);
+        my $elapsed = clock_gettime(CLOCK_MONOTONIC) - $t0;
+        $best = $elapsed if !defined $best || $elapsed < $best;
+    }
+
+    printf "perl,%s,%s,%d,%d,%.3f,,,%d\n",
+        $batch ? 'Net::LPM::lookup_batch' : 'Net::LPM::lookup',
+        $batch ? 'batch' : 'single', $batch || 1, $lookups,
+        $best * 1e9 / $lookups, $checksum;
+}
+
+die "Usage: $0 TABLE TRACE\n" unless @ARGV == 2;
+
+my $table = Net::LPM->new_ipv4();
+open my $fh, '<', $ARGV[0] or die "Could not open $ARGV[0]: $!\n";
+while (my $line = <$fh>) {
+    next unless $line =~ m{^(\d+\.\d+\.\d+\.\d+/\d+)\s+(\d+)};
+    $table->insert($1, $2);
+}
+close $fh;
+
+my @addrs;
+open $fh, '<', $ARGV[1] or die "Could not open $ARGV[1]: $!\n";
+while (my $line = <$fh>) {
+    chomp $line;
+    push @addrs, $line if length $line;
+}
+close $fh;
+die "Trace $ARGV[1] is too short\n" if @addrs < $BATCH_SIZES[-1];
+
+measure($table, \@addrs, 0);
+measure($table, \@addrs, $_) for @BATCH_SIZES;
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Python driver for the binding overhead benchmark.
+
+Usage: bench_bindings.py TABLE TRACE
+
+Follows the protocol in benchmarks/bench_bindings.c. CPython has no
+per-call allocation counter, so the allocation columns stay empty.
+"""
+
+import sys
+import time
+from ipaddress import IPv4Address, IPv4Network
+
+from liblpm import LpmTableIPv4
+
+BENCH_PASSES = 3
+BATCH_SIZES = (16, 256, 4096)
+
+
+def run_pass(table, addrs, batch):
+    total = 0
+    if batch == 0:
+        lookup = table.lookup
+        for addr in addrs:
+            nh = lookup(addr)
+            if nh is not None:
+                total += nh
+        return total
+    for i in range(0, len(addrs) - batch + 1, batch):
+        for nh in table.lookup_batch(addrs[i:i + batch]):
+            if nh is not None:
+                total += nh
+    return total
+
+
+def measure(table, addrs, batch):
+    lookups = len(addrs) // batch * batch if batch else len(addrs)
+
+    checksum = run_pass(table, addrs, batch)
+
+    best = None
+    for _ in range(BENCH_PASSES):
+        t0 = time.perf_counter_ns()
+        run_pass(table, addrs, batch)
+        elapsed = time.perf_counter_ns() - t0
+        if best is None or elapsed < best:
+            best = elapsed
+
+    api = "LpmTableIPv4.lookup_batch" if batch else "LpmTableIPv4.lookup"
+    mode = "batch" if batch else "single"
+    print(f"python,{api},{mode},{batch or 1},{lookups},"
+          f"{best / lookups:.3f},,,{checksum}")
+
+
+def read_lines(path):
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line and not line.startswith("#"):
+                yield line
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} TABLE TRACE", file=sys.stderr)
+        return 1
+
+    with LpmTableIPv4() as table:
+        for line in read_lines(sys.argv[1]):
+            prefix, nh = line.split()
+            table.insert(IPv4Network(prefix), int(nh))
+
+        addrs = [IPv4Address(line) for line in read_lines(sys.argv[2])]
+        if len(addrs) < BATCH_SIZES[-1]:
+            print(f"Trace {sys.argv[2]} is too short", file=sys.stderr)
+            return 1
+
+        measure(table, addrs, 0)
+        for batch in BATCH_SIZES:
+            measure(table, addrs, batch)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,102 @@
+// C# driver for the binding overhead benchmark.
+//
+// Usage: dotnet run -c Release -- TABLE TRACE
+// Follows the protocol in benchmarks/bench_bindings.c. The runtime only
+// counts allocated bytes per thread, so allocs_per_call stays empty.
+
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using LibLpm;
+
+const int BenchPasses = 3;
+int[] batchSizes = { 16, 256, 4096 };
+
+if (args.Length != 2)
+{
+    Console.Error.WriteLine("Usage: BenchBindings TABLE TRACE");
+    return 1;
+}
+
+using var trie = LpmTrieIPv4.CreateDefault();
+foreach (var line in File.ReadLines(args[0]))
+{
+    if (line.Length == 0 || line[0] == '#')
+    {
+        continue;
+    }
+    var fields = line.Split(' ', StringSplitOptions.RemoveEmptyEntries);
+    trie.Add(fields[0], uint.Parse(fields[1], CultureInfo.InvariantCulture));
+}
+
+uint[] addrs = File.ReadLines(args[1])
+    .Where(l => l.Length > 0)
+    .Select(l => l.Split('.').Aggregate(0u, (a, o) => (a << 8) | uint.Parse(o, CultureInfo.InvariantCulture)))
+    .ToArray();
+if (addrs.Length < batchSizes[^1])
+{
+    Console.Error.WriteLine($"Trace {args[1]} is too short");
+    return 1;
+}
+
+Measure(0);
+foreach (int batch in batchSizes)
+{
+    Measure(batch);
+}
+return 0;
+
+ulong RunPass(int batch, uint[] results)
+{
+    ulong sum = 0;
+    if (batch == 0)
+    {
+        foreach (uint addr in addrs)
+        {
+            sum += trie.Lookup(addr) ?? 0;
+        }
+        return sum;
+    }
+    for (int i = 0; i + batch <= addrs.Length; i += batch)
+    {
+        trie.LookupBatch(addrs.AsSpan(i, batch), results.AsSpan(0, batch));
+        for (int j = 0; j < batch; j++)
+        {
+            if (results[j] != LpmConstants.InvalidNextHop)
+            {
+                sum += results[j];
+            }
+        }
+    }
+    return sum;
+}
+
+void Measure(int batch)
+{
+    int calls = batch == 0 ? addrs.Length : addrs.Length / batch;
+    long lookups = batch == 0 ? addrs.Length : (long)calls * batch;
+    var results = new uint[Math.Max(batch, 1)];
+
+    ulong checksum = RunPass(batch, results);
+
+    long bytes0 = GC.GetAllocatedBytesForCurrentThread();
+    RunPass(batch, results);
+    long bytes = GC.GetAllocatedBytesForCurrentThread() - bytes0;
+
+    double best = double.MaxValue;
+    for (int p = 0; p < BenchPasses; p++)
+    {
+        long t0 = Stopwatch.GetTimestamp();
+        RunPass(batch, results);
+        double ns = (Stopwatch.GetTimestamp() - t0) * 1e9 / Stopwatch.Frequency;
+        best = Math.Min(best, ns);
+    }
+
+    Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+        "csharp,{0},{1},{2},{3},{4:F3},,{5:F3},{6}",
+        batch == 0 ? "LpmTrieIPv4.Lookup" : "LpmTrieIPv4.LookupBatch",
+        batch == 0 ? "single" : "batch", Math.Max(batch, 1), lookups,
+        best / lookups, (double)bytes / calls, checksum));
+}
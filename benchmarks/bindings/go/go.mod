@@ -0,0 +1,7 @@
+module github.com/MuriloChianfa/liblpm/benchmarks/bindings/go
+
+go 1.21
+
+require github.com/MuriloChianfa/liblpm/go v0.0.0
+
+replace github.com/MuriloChianfa/liblpm/go => ../../../bindings/go
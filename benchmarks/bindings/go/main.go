@@ -0,0 +1,141 @@
+// Go driver for the binding overhead benchmark.
+//
+// Usage: go run . TABLE TRACE
+// Follows the protocol in benchmarks/bench_bindings.c. Allocations come from
+// runtime.MemStats, so they include everything the binding allocates on the
+// Go heap per call.
+package main
+
+import (
+	"bufio"
+	"fmt"
+	"net/netip"
+	"os"
+	"runtime"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/MuriloChianfa/liblpm/go/liblpm"
+)
+
+const benchPasses = 3
+
+var batchSizes = []int{16, 256, 4096}
+
+func runPass(t *liblpm.Table, addrs []netip.Addr, batch int) uint64 {
+	var sum uint64
+	if batch == 0 {
+		for _, a := range addrs {
+			if nh, ok := t.Lookup(a); ok {
+				sum += uint64(nh)
+			}
+		}
+		return sum
+	}
+	for i := 0; i+batch <= len(addrs); i += batch {
+		results, err := t.LookupBatch(addrs[i : i+batch])
+		if err != nil {
+			panic(err)
+		}
+		for _, nh := range results {
+			if nh.IsValid() {
+				sum += uint64(nh)
+			}
+		}
+	}
+	return sum
+}
+
+func measure(t *liblpm.Table, addrs []netip.Addr, batch int) {
+	lookups, calls := len(addrs), len(addrs)
+	if batch > 0 {
+		calls = len(addrs) / batch
+		lookups = calls * batch
+	}
+
+	checksum := runPass(t, addrs, batch)
+
+	var before, after runtime.MemStats
+	runtime.ReadMemStats(&before)
+	runPass(t, addrs, batch)
+	runtime.ReadMemStats(&after)
+
+	var best time.Duration
+	for p := 0; p < benchPasses; p++ {
+		t0 := time.Now()
+		runPass(t, addrs, batch)
+		if d := time.Since(t0); p == 0 || d < best {
+			best = d
+		}
+	}
+
+	api, mode, size := "Table.Lookup", "single", 1
+	if batch > 0 {
+		api, mode, size = "Table.LookupBatch", "batch", batch
+	}
+	fmt.Printf("go,%s,%s,%d,%d,%.3f,%.3f,%.3f,%d\n", api, mode, size, lookups,
+		float64(best.Nanoseconds())/float64(lookups),
+		float64(after.Mallocs-before.Mallocs)/float64(calls),
+		float64(after.TotalAlloc-before.TotalAlloc)/float64(calls), checksum)
+}
+
+func readLines(path string, fn func(string)) error {
+	f, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer f.Close()
+	sc := bufio.NewScanner(f)
+	for sc.Scan() {
+		if line := sc.Text(); line != "" && line[0] != '#' {
+			fn(line)
+		}
+	}
+	return sc.Err()
+}
+
+func main() {
+	if len(os.Args) != 3 {
+		fmt.Fprintf(os.Stderr, "Usage: %s TABLE TRACE\n", os.Args[0])
+		os.Exit(1)
+	}
+
+	t, err := liblpm.NewTableIPv4()
+	if err != nil {
+		panic(err)
+	}
+	defer t.Close()
+
+	err = readLines(os.Args[1], func(line string) {
+		fields := strings.Fields(line)
+		if len(fields) != 2 {
+			return
+		}
+		prefix, err := netip.ParsePrefix(fields[0])
+		nh, err2 := strconv.ParseUint(fields[1], 10, 32)
+		if err == nil && err2 == nil {
+			t.Insert(prefix, liblpm.NextHop(nh))
+		}
+	})
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+
+	var addrs []netip.Addr
+	err = readLines(os.Args[2], func(line string) {
+		if a, err := netip.ParseAddr(line); err == nil && a.Is4() {
+			addrs = append(addrs, a)
+		}
+	})
+	if err != nil || len(addrs) < batchSizes[len(batchSizes)-1] {
+		fmt.Fprintf(os.Stderr, "Trace %s is unreadable or too short\n", os.Args[2])
+		os.Exit(1)
+	}
+
+	measure(t, addrs, 0)
+	for _, b := range batchSizes {
+		measure(t, addrs, b)
+	}
+}
@@ -14,11 +14,13 @@ namespace liblpm {
 // ============================================================================
 
 IPv4Address::IPv4Address(const char* str) noexcept {
-    // Use inet_pton for robust parsing
-    if (inet_pton(AF_INET, str, octets) != 1) {
-        // Invalid address - zero it out
-        std::memset(octets, 0, sizeof(octets));
-    }
+    // Use the library's SIMD parser (zeroes the result on invalid input)
+    uint32_t addr = 0;
+    lpm_parse_ipv4_batch(&str, nullptr, &addr, nullptr, 1);
+    octets[0] = static_cast<uint8_t>(addr >> 24);
+    octets[1] = static_cast<uint8_t>(addr >> 16);
+    octets[2] = static_cast<uint8_t>(addr >> 8);
+    octets[3] = static_cast<uint8_t>(addr);
 }
 
 std::optional<IPv4Address> parse_ipv4(const char* str) noexcept {
@@ -37,11 +39,10 @@ std::optional<IPv4Address> parse_ipv4(const char* str) noexcept {
 // ============================================================================
 
 IPv6Address::IPv6Address(const char* str) noexcept {
-    // Use inet_pton for robust parsing
-    if (inet_pton(AF_INET6, str, octets) != 1) {
-        // Invalid address - zero it out
-        std::memset(octets, 0, sizeof(octets));
-    }
+    // Use the library's SIMD parser (zeroes the result on invalid input)
+    uint8_t addr[1][16];
+    lpm_parse_ipv6_batch(&str, nullptr, addr, nullptr, 1);
+    std::memcpy(octets, addr[0], sizeof(octets));
 }
 
 std::optional<IPv6Address> parse_ipv6(const char* str) noexcept {
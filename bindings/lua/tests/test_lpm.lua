@@ -559,6 +559,28 @@ test("IPv4 lookup with IPv6 address fails", function()
     t:close()
 end)
 
+test("CIDR strings use the same address syntax as plain addresses", function()
+    local t = lpm.new_ipv4()
+    -- Leading zeros are rejected with or without a length (sscanf took them)
+    assert_nil(t:insert("010.0.0.0/8", 100), "leading zero in CIDR")
+    assert_nil(t:insert("010.0.0.0", 8, 100), "leading zero in address")
+    -- The length is plain decimal (strtol took a sign, spaces and zeros)
+    for _, s in ipairs({"10.0.0.0/+8", "10.0.0.0/ 8", "10.0.0.0/08", "10.0.0.0/"}) do
+        assert_nil(t:insert(s, 100), "should reject " .. s)
+    end
+    -- Host bits are still cleared
+    assert_true(t:insert("10.1.2.3/8", 100), "host bits set")
+    assert_eq(t:lookup("10.200.0.1"), 100, "should match the /8")
+    t:close()
+
+    local t6 = lpm.new_ipv6()
+    assert_nil(t6:insert("2001:db8::/+32", 100), "signed IPv6 length")
+    assert_nil(t6:insert("10.0.0.0/8", 100), "IPv4 CIDR in IPv6 table")
+    assert_true(t6:insert("2001:db8::1/32", 100), "IPv6 host bits set")
+    assert_eq(t6:lookup("2001:db8:ffff::1"), 100, "should match the /32")
+    t6:close()
+end)
+
 -- ============================================================================
 -- Edge Cases
 -- ============================================================================
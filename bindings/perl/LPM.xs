@@ -31,23 +31,21 @@ typedef struct {
 static int
 parse_ipv4_addr(const char *str, uint32_t *addr)
 {
-    struct in_addr in;
-    if (inet_pton(AF_INET, str, &in) != 1) {
-        return 0;
-    }
-    *addr = ntohl(in.s_addr);
-    return 1;
+    return lpm_parse_ipv4_batch(&str, NULL, addr, NULL, 1) == 1;
 }
 
 /* Helper: Parse IPv4 address string to byte array */
 static int
 parse_ipv4_addr_bytes(const char *str, uint8_t *bytes)
 {
-    struct in_addr in;
-    if (inet_pton(AF_INET, str, &in) != 1) {
+    uint32_t addr;
+    if (lpm_parse_ipv4_batch(&str, NULL, &addr, NULL, 1) != 1) {
         return 0;
     }
-    memcpy(bytes, &in.s_addr, 4);
+    bytes[0] = (uint8_t)(addr >> 24);
+    bytes[1] = (uint8_t)(addr >> 16);
+    bytes[2] = (uint8_t)(addr >> 8);
+    bytes[3] = (uint8_t)addr;
     return 1;
 }
 
@@ -55,12 +53,7 @@ parse_ipv4_addr_bytes(const char *str, uint8_t *bytes)
 static int
 parse_ipv6_addr(const char *str, uint8_t *bytes)
 {
-    struct in6_addr in6;
-    if (inet_pton(AF_INET6, str, &in6) != 1) {
-        return 0;
-    }
-    memcpy(bytes, &in6.s6_addr, 16);
-    return 1;
+    return lpm_parse_ipv6_batch(&str, NULL, (uint8_t (*)[16])bytes, NULL, 1) == 1;
 }
 
 /* Helper: Parse CIDR prefix notation (e.g., "192.168.0.0/16") */
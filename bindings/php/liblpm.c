@@ -46,11 +46,14 @@ ZEND_TSRMLS_CACHE_DEFINE()
  */
 int liblpm_parse_ipv4_addr(const char *str, uint8_t *addr)
 {
-    struct in_addr in;
-    if (inet_pton(AF_INET, str, &in) != 1) {
+    uint32_t v4;
+    if (lpm_parse_ipv4_batch(&str, NULL, &v4, NULL, 1) != 1) {
         return 0;
     }
-    memcpy(addr, &in.s_addr, 4);
+    addr[0] = (uint8_t)(v4 >> 24);
+    addr[1] = (uint8_t)(v4 >> 16);
+    addr[2] = (uint8_t)(v4 >> 8);
+    addr[3] = (uint8_t)v4;
     return 1;
 }
 
@@ -59,12 +62,7 @@ int liblpm_parse_ipv4_addr(const char *str, uint8_t *addr)
  */
 int liblpm_parse_ipv6_addr(const char *str, uint8_t *addr)
 {
-    struct in6_addr in6;
-    if (inet_pton(AF_INET6, str, &in6) != 1) {
-        return 0;
-    }
-    memcpy(addr, &in6.s6_addr, 16);
-    return 1;
+    return lpm_parse_ipv6_batch(&str, NULL, (uint8_t (*)[16])addr, NULL, 1) == 1;
 }
 
 /**
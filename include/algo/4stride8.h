@@ -11,6 +11,49 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Inline Lookup - Unrolled 4 levels with prefetch
+ * Shared by the single lookups and lpm_inline.h. Returns the longest match
+ * below node N, LPM_INVALID_NEXT_HOP if none; the default route is left to
+ * the caller.
+ * ============================================================================ */
+
+__attribute__((hot, always_inline))
+static inline uint32_t lpm_ipv4_8stride_lookup_inline(const lpm_node_t * restrict P,
+                                                       uint32_t N, const uint8_t *addr)
+{
+    uint32_t R = LPM_INVALID_NEXT_HOP;
+    const struct lpm_entry *e;
+    uint32_t cv;
+    
+    /* Level 0 */
+    e = &P[N].entries[addr[0]]; cv = e->child_and_valid;
+    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
+    N = cv & LPM_CHILD_MASK;
+    if (!N) { return R; }
+    __builtin_prefetch(&P[N].entries[addr[1]], 0, 3);
+    
+    /* Level 1 */
+    e = &P[N].entries[addr[1]]; cv = e->child_and_valid;
+    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
+    N = cv & LPM_CHILD_MASK;
+    if (!N) { return R; }
+    __builtin_prefetch(&P[N].entries[addr[2]], 0, 3);
+    
+    /* Level 2 */
+    e = &P[N].entries[addr[2]]; cv = e->child_and_valid;
+    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
+    N = cv & LPM_CHILD_MASK;
+    if (!N) { return R; }
+    __builtin_prefetch(&P[N].entries[addr[3]], 0, 3);
+    
+    /* Level 3 */
+    e = &P[N].entries[addr[3]]; cv = e->child_and_valid;
+    if (cv & LPM_VALID_FLAG) { R = e->next_hop; }
+    
+    return R;
+}
+
 /* ============================================================================
  * Internal SIMD variants (used by ifunc resolver)
  * Public API functions are declared in lpm.h
@@ -36,6 +79,12 @@ void lpm_lookup_batch_ipv4_8stride_avx2(const lpm_trie_t *trie, const uint8_t **
 void lpm_lookup_batch_ipv4_8stride_avx512(const lpm_trie_t *trie, const uint8_t **addrs,
                                            uint32_t *next_hops, size_t count);
 
+typedef void (*lpm_ipv4_8stride_batch_func_t)(const lpm_trie_t *, const uint8_t **, uint32_t *, size_t);
+
+/* lpm_lookup_batch_ipv4_8stride() with a given kernel, or the bound one if NULL */
+void lpm_lookup_batch_ipv4_8stride_with(lpm_ipv4_8stride_batch_func_t kernel, const lpm_trie_t *trie,
+                                        const uint32_t *addrs, uint32_t *next_hops, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,41 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Inline Lookup - Unrolled 16 levels, branchless
+ * Shared by the single lookups and lpm_inline.h. Returns the longest match
+ * below node N, LPM_INVALID_NEXT_HOP if none; the default route is left to
+ * the caller.
+ * ============================================================================ */
+
+__attribute__((hot, always_inline))
+static inline uint32_t lpm_ipv6_8stride_lookup_inline(const lpm_node_t * restrict P,
+                                                       uint32_t N, const uint8_t *addr)
+{
+    uint32_t R = LPM_INVALID_NEXT_HOP;
+    
+#define LPM_6STRIDE8_STEP(i) do { \
+    const struct lpm_entry *e = &P[N].entries[addr[i]]; \
+    uint32_t cv = e->child_and_valid; \
+    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R; \
+    N = cv & LPM_CHILD_MASK; \
+    if (!N) { return R; } \
+} while(0)
+    
+    LPM_6STRIDE8_STEP(0); LPM_6STRIDE8_STEP(1); LPM_6STRIDE8_STEP(2); LPM_6STRIDE8_STEP(3);
+    LPM_6STRIDE8_STEP(4); LPM_6STRIDE8_STEP(5); LPM_6STRIDE8_STEP(6); LPM_6STRIDE8_STEP(7);
+    LPM_6STRIDE8_STEP(8); LPM_6STRIDE8_STEP(9); LPM_6STRIDE8_STEP(10); LPM_6STRIDE8_STEP(11);
+    LPM_6STRIDE8_STEP(12); LPM_6STRIDE8_STEP(13); LPM_6STRIDE8_STEP(14);
+    
+    /* Last byte */
+    const struct lpm_entry *e = &P[N].entries[addr[15]];
+    uint32_t cv = e->child_and_valid;
+    if (cv & LPM_VALID_FLAG) { R = e->next_hop; }
+    
+#undef LPM_6STRIDE8_STEP
+    return R;
+}
+
 /* ============================================================================
  * Internal SIMD variants (used by ifunc resolver)
  * Public API functions are declared in lpm.h
@@ -36,6 +71,12 @@ void lpm_lookup_batch_ipv6_8stride_avx2(const lpm_trie_t *trie, const uint8_t **
 void lpm_lookup_batch_ipv6_8stride_avx512(const lpm_trie_t *trie, const uint8_t **addrs,
                                            uint32_t *next_hops, size_t count);
 
+typedef void (*lpm_ipv6_8stride_batch_func_t)(const lpm_trie_t *, const uint8_t **, uint32_t *, size_t);
+
+/* lpm_lookup_batch_ipv6_8stride() with a given kernel, or the bound one if NULL */
+void lpm_lookup_batch_ipv6_8stride_with(lpm_ipv6_8stride_batch_func_t kernel, const lpm_trie_t *trie,
+                                        const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
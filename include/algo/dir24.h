@@ -11,6 +11,91 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Resumable updates
+ * An add or delete of a prefix up to /24 rewrites 2^(24-len) slots. The op
+ * records which slots to visit and what to write so the expansion can be
+ * split into bounded steps; every slot write is a single 32-bit store, so
+ * lookups between steps see each slot either before or after the update.
+ * ============================================================================ */
+
+typedef struct lpm_dir24_op {
+    uint32_t base;        /* First dir24 slot covered */
+    uint32_t count;       /* Slots covered */
+    uint32_t cursor;      /* Next slot to visit */
+    uint32_t data;        /* Entry value written to matching slots */
+    uint8_t depth_lo;     /* Slots whose depth is in [depth_lo, depth_hi] */
+    uint8_t depth_hi;     /*   are overwritten ... */
+    uint8_t depth;        /*   ... and take this depth */
+} lpm_dir24_op_t;
+
+/* Largest next hop the trie's entry format can hold */
+static inline uint32_t lpm_dir24_max_next_hop(const lpm_trie_t *trie)
+{
+    return trie->dir24c_table ? LPM_DIR24C_MAX_NEXT_HOP : LPM_DIR24_NH_MASK;
+}
+
+/* ============================================================================
+ * Inline Lookups
+ * Shared by the single and batch lookups and lpm_inline.h. The default route
+ * is left to the caller: a miss returns LPM_INVALID_NEXT_HOP.
+ * ============================================================================ */
+
+/* addr in network byte order. Most routes are /8-/24 and end in the 24-bit
+ * table; only extended slots reach tbl8 */
+__attribute__((hot, always_inline, flatten))
+static inline uint32_t lpm_dir24_lookup_inline(const struct lpm_dir24_entry * restrict dir24,
+                                               const struct lpm_tbl8_entry * restrict tbl8,
+                                               const uint8_t * restrict addr)
+{
+    uint32_t dir24_idx = ((uint32_t)addr[0] << 16) | ((uint32_t)addr[1] << 8) | addr[2];
+    uint32_t data = dir24[dir24_idx].data;
+
+    if (__builtin_expect(!(data & LPM_DIR24_EXT_FLAG), 1)) {
+        return (data & LPM_DIR24_VALID_FLAG) ? (data & LPM_DIR24_NH_MASK) : LPM_INVALID_NEXT_HOP;
+    }
+
+    uint32_t tbl8_idx = ((data & LPM_DIR24_NH_MASK) << 8) | addr[3];
+    uint32_t tbl8_data = tbl8[tbl8_idx].data;
+
+    return (tbl8_data & LPM_DIR24_VALID_FLAG) ? (tbl8_data & LPM_DIR24_NH_MASK) : LPM_INVALID_NEXT_HOP;
+}
+
+/* Compact tables store next_hop + 1, so an empty entry decodes to
+ * LPM_INVALID_NEXT_HOP with the same subtract */
+__attribute__((hot, always_inline))
+static inline uint32_t lpm_dir24c_lookup_inline(const uint16_t * restrict dir24,
+                                                const uint16_t * restrict tbl8, uint32_t ip)
+{
+    uint32_t v = dir24[ip >> 8];
+    if (__builtin_expect(v & LPM_DIR24C_EXT_FLAG, 0)) {
+        v = tbl8[((v & LPM_DIR24C_IDX_MASK) << 8) | (ip & 0xFF)];
+    }
+    return v - 1;
+}
+
+/*
+ * Start an update. Returns 1 if slots remain to be written with
+ * lpm_dir24_op_run(), 0 if the update completed (routes longer than /24 and
+ * the default route finish here), -1 on error or when deleting a prefix that
+ * is not installed.
+ */
+int lpm_dir24_op_begin(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t next_hop, bool del, lpm_dir24_op_t *op);
+
+/* Do up to budget units of work (one per slot, 256 per extended slot) and
+ * return the units done. The op is finished when cursor == count. */
+uint32_t lpm_dir24_op_run(lpm_trie_t *trie, lpm_dir24_op_t *op, uint32_t budget);
+
+/* Double the tbl8 arrays; no other writer may touch the table meanwhile */
+int lpm_dir24_tbl8_grow(lpm_trie_t *trie);
+
+/* Rewrite every entry holding old_nh inside prefix/len (/0: the whole table)
+ * to new_nh with single stores; entry depths are unchanged. The default route
+ * and the rule store are left to the caller. */
+void lpm_dir24_repoint(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t old_nh, uint32_t new_nh);
+
 /* ============================================================================
  * Internal SIMD variants (used by ifunc resolver)
  * Public API functions are declared in lpm.h
@@ -27,6 +112,13 @@ void lpm_lookup_batch_ipv4_dir24_avx2(const lpm_trie_t *trie, const uint32_t *ip
 void lpm_lookup_batch_ipv4_dir24_avx512(const lpm_trie_t *trie, const uint32_t *ips,
                                          uint32_t *next_hops, size_t count);
 
+void lpm_lookup_batch_ipv4_dir24_compact_scalar(const lpm_trie_t *trie, const uint32_t *ips,
+                                                 uint32_t *next_hops, size_t count);
+void lpm_lookup_batch_ipv4_dir24_compact_avx2(const lpm_trie_t *trie, const uint32_t *ips,
+                                               uint32_t *next_hops, size_t count);
+void lpm_lookup_batch_ipv4_dir24_compact_avx512(const lpm_trie_t *trie, const uint32_t *ips,
+                                                 uint32_t *next_hops, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,115 @@
+/*
+ * liblpm - IPv4 LC-Trie Engine (level- and path-compressed trie)
+ * Internal declarations
+ */
+#ifndef LPM_ALGO_LCTRIE_H_
+#define LPM_ALGO_LCTRIE_H_
+
+#include "../lpm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Data Structures
+ * ============================================================================ */
+
+/*
+ * Keys are IPv4 addresses in host order. Bit positions count from the least
+ * significant bit, so an internal node at pos with bits index bits selects
+ * its child with key bits [pos, pos + bits); everything above pos + bits is
+ * fixed for the whole subtree (path compression) and stored in key, with the
+ * bits below it zero. bits is 0 for leaves.
+ *
+ * A prefix a/len is kept in the leaf whose key is a, as an alias with suffix
+ * length slen = 32 - len; 10.0.0.0/8 and 10.0.0.0/16 share a leaf. The slen
+ * of a node is the largest suffix length below it (at least pos): no prefix
+ * under the node covers an address that differs from it above slen.
+ */
+struct lpm_lct_node {
+    uint32_t key;
+    uint8_t pos;
+    uint8_t bits;
+    uint8_t slen;
+    uint8_t count;            /* Leaves: aliases */
+};
+
+struct lpm_lct_alias {
+    uint32_t next_hop;
+    uint8_t slen;
+};
+
+struct lpm_lct_leaf {
+    struct lpm_lct_node n;
+    struct lpm_lct_alias alias[];   /* Longest prefix (smallest slen) first */
+};
+
+struct lpm_lct_tnode {
+    struct lpm_lct_node n;
+    uint32_t empty_children;
+    uint32_t full_children;   /* Internal children with no skipped bits */
+    struct lpm_lct_node *child[];   /* 1 << bits */
+};
+
+struct lpm_lctrie {
+    struct lpm_lct_node *root;      /* NULL, a leaf or an internal node */
+    uint32_t leaves;
+    uint32_t tnodes;
+    size_t bytes;
+};
+
+void lpm_lctrie_destroy(struct lpm_lctrie *t);
+/* Point every prefix using old_nh at new_nh */
+void lpm_lctrie_repoint(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh);
+
+static inline bool lpm_lct_is_leaf(const struct lpm_lct_node *n)
+{
+    return n->bits == 0;
+}
+
+/* Index of key among the children of tn; 1 << bits or more if key differs
+ * from tn above pos + bits */
+static inline uint32_t lpm_lct_index(uint32_t key, const struct lpm_lct_node *tn)
+{
+    return (key ^ tn->key) >> tn->pos;
+}
+
+/* First alias of a leaf that covers addr, or NULL */
+static inline const struct lpm_lct_alias *lpm_lct_leaf_match(const struct lpm_lct_node *n, uint32_t addr)
+{
+    const struct lpm_lct_leaf *l = (const struct lpm_lct_leaf *)n;
+    uint64_t diff = addr ^ n->key;
+    for (uint32_t i = 0; i < n->count; i++) {
+        if ((diff >> l->alias[i].slen) == 0) {
+            return &l->alias[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t lpm_lctrie_lookup(const struct lpm_lctrie *t, uint32_t addr);
+
+/* Descent only, for lpm_inline.h: most lookups end on a leaf that covers
+ * the address. The rest take lpm_lctrie_lookup(), which backs up */
+__attribute__((hot, always_inline))
+static inline uint32_t lpm_lctrie_lookup_inline(const struct lpm_lctrie *t, uint32_t addr)
+{
+    const struct lpm_lct_node *n = t->root;
+
+    while (n && !lpm_lct_is_leaf(n)) {
+        uint32_t idx = lpm_lct_index(addr, n);
+        if (idx >> n->bits) {
+            return lpm_lctrie_lookup(t, addr);
+        }
+        n = ((const struct lpm_lct_tnode *)n)->child[idx];
+    }
+    const struct lpm_lct_alias *a = n ? lpm_lct_leaf_match(n, addr) : NULL;
+    return a ? a->next_hop : lpm_lctrie_lookup(t, addr);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPM_ALGO_LCTRIE_H_ */
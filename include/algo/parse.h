@@ -0,0 +1,83 @@
+/*
+ * liblpm - Address Text Parsing
+ * Internal declarations
+ */
+#ifndef LPM_ALGO_PARSE_H_
+#define LPM_ALGO_PARSE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "../lpm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest accepted text forms */
+#define LPM_PARSE_IPV4_MAX_CHARS 15  /* "255.255.255.255" */
+#define LPM_PARSE_IPV6_MAX_CHARS 45  /* "ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255" */
+
+#define LPM_PARSE_PAGE_SIZE 4096
+
+/*
+ * Vector kernels load a fixed number of bytes past the start of the string
+ * and mask off everything beyond its length. That over-read is harmless as
+ * long as it stays within the same page; otherwise the string is copied to
+ * a stack buffer first.
+ */
+static inline const char *lpm_parse_load_ptr(const char *s, size_t len,
+                                             char *buf, size_t width)
+{
+    if (((uintptr_t)s & (LPM_PARSE_PAGE_SIZE - 1)) <= LPM_PARSE_PAGE_SIZE - width) {
+        return s;
+    }
+    memcpy(buf, s, len);
+    return buf;
+}
+
+/* ============================================================================
+ * Single-element kernels (shared by the address and prefix batch parsers)
+ * Return an LPM_PARSE_* status.
+ * ============================================================================ */
+
+uint8_t lpm_parse_ipv4_elem_scalar(const char *s, size_t len, uint32_t *out);
+uint8_t lpm_parse_ipv4_elem_sse42(const char *s, size_t len, uint32_t *out);
+
+uint8_t lpm_parse_ipv6_elem_scalar(const char *s, size_t len, uint8_t out[16]);
+uint8_t lpm_parse_ipv6_elem_sse42(const char *s, size_t len, uint8_t out[16]);
+uint8_t lpm_parse_ipv6_elem_avx2(const char *s, size_t len, uint8_t out[16]);
+
+/* ============================================================================
+ * Internal SIMD variants (used by ifunc resolver)
+ * Public API functions are declared in lpm.h
+ * ============================================================================ */
+
+size_t lpm_parse_ipv4_batch_scalar(const char *const *strs, const size_t *lens,
+                                   uint32_t *addrs, uint8_t *status, size_t count);
+size_t lpm_parse_ipv4_batch_sse42(const char *const *strs, const size_t *lens,
+                                  uint32_t *addrs, uint8_t *status, size_t count);
+size_t lpm_parse_ipv4_batch_avx2(const char *const *strs, const size_t *lens,
+                                 uint32_t *addrs, uint8_t *status, size_t count);
+
+size_t lpm_parse_ipv6_batch_scalar(const char *const *strs, const size_t *lens,
+                                   uint8_t (*addrs)[16], uint8_t *status, size_t count);
+size_t lpm_parse_ipv6_batch_sse42(const char *const *strs, const size_t *lens,
+                                  uint8_t (*addrs)[16], uint8_t *status, size_t count);
+size_t lpm_parse_ipv6_batch_avx2(const char *const *strs, const size_t *lens,
+                                 uint8_t (*addrs)[16], uint8_t *status, size_t count);
+
+size_t lpm_parse_prefix_batch_scalar(const char *const *strs, const size_t *lens,
+                                     uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                     uint8_t *max_depths, uint8_t *status, size_t count);
+size_t lpm_parse_prefix_batch_sse42(const char *const *strs, const size_t *lens,
+                                    uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                    uint8_t *max_depths, uint8_t *status, size_t count);
+size_t lpm_parse_prefix_batch_avx2(const char *const *strs, const size_t *lens,
+                                   uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                   uint8_t *max_depths, uint8_t *status, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPM_ALGO_PARSE_H_ */
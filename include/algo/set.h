@@ -0,0 +1,110 @@
+/*
+ * liblpm - Membership Sets (IPv4 bitmaps, IPv6 bitmap-compressed trie)
+ * Internal declarations
+ */
+#ifndef LPM_ALGO_SET_H_
+#define LPM_ALGO_SET_H_
+
+#include "../lpm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Data Structures
+ * ============================================================================ */
+
+/* Coverage of one /24 by prefixes longer than /24: one bit per address */
+struct lpm_set_block {
+    uint32_t key;             /* /24 index + 1, 0 = empty slot */
+    uint64_t bits[4];
+};
+
+/* IPv6 node: one byte of the address. A set leaf bit means every address
+ * below that byte is covered; children are stored in byte order, indexed by
+ * the rank of their child bit. */
+struct lpm_set_node6 {
+    uint64_t leaf[4];
+    uint64_t child[4];
+    uint32_t *children;
+    uint32_t num_children;
+    uint32_t next_free;       /* Free list link while unused */
+};
+
+struct lpm_set {
+    /* IPv4 */
+    uint64_t *cover;          /* 2^24 bits: /24 covered by a prefix up to /24 */
+    uint64_t *ext;            /* 2^24 bits: /24 has a block of longer prefixes */
+    struct lpm_set_block *blocks;
+    uint32_t block_capacity;  /* Power of two */
+    uint32_t block_count;
+
+    /* IPv6 */
+    struct lpm_set_node6 *nodes;  /* nodes[0] is the root */
+    uint32_t node_capacity;
+    uint32_t node_used;           /* High-water mark */
+    uint32_t node_live;
+    uint32_t free_head;           /* 0 = empty (the root is never freed) */
+};
+
+#define LPM_SET_IPV4_BITMAP_BYTES ((size_t)LPM_IPV4_DIR24_SIZE / 8)
+
+static inline bool lpm_set_bit(const uint64_t *bm, uint32_t i)
+{
+    return (bm[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline uint32_t lpm_set_block_home(uint32_t idx24, uint32_t mask)
+{
+    return (uint32_t)(((uint64_t)idx24 * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+/* Probe the block of a /24 (NULL if it has no longer prefixes) */
+static inline const struct lpm_set_block *lpm_set_block_find(const struct lpm_set *s, uint32_t idx24)
+{
+    uint32_t mask = s->block_capacity - 1;
+    for (uint32_t i = lpm_set_block_home(idx24, mask); s->blocks[i].key; i = (i + 1) & mask) {
+        if (s->blocks[i].key == idx24 + 1) {
+            return &s->blocks[i];
+        }
+    }
+    return NULL;
+}
+
+static inline bool lpm_set_contains_ipv4_inline(const struct lpm_set *s, uint32_t addr)
+{
+    uint32_t idx = addr >> 8;
+    if (lpm_set_bit(s->cover, idx)) { return true; }
+    if (__builtin_expect(!lpm_set_bit(s->ext, idx), 1)) { return false; }
+    const struct lpm_set_block *b = lpm_set_block_find(s, idx);
+    return b && lpm_set_bit(b->bits, addr & 0xFF);
+}
+
+/* ============================================================================
+ * Internal SIMD variants (used by ifunc resolver)
+ * Public API functions are declared in lpm.h
+ * ============================================================================ */
+
+size_t lpm_contains_batch_ipv4_scalar(const lpm_trie_t *set, const uint32_t *addrs,
+                                      uint64_t *mask, size_t count);
+size_t lpm_contains_batch_ipv4_avx2(const lpm_trie_t *set, const uint32_t *addrs,
+                                    uint64_t *mask, size_t count);
+size_t lpm_contains_batch_ipv4_avx512(const lpm_trie_t *set, const uint32_t *addrs,
+                                      uint64_t *mask, size_t count);
+
+/* Updates, dispatched from lpm_add()/lpm_delete() */
+int lpm_add_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+int lpm_delete_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+
+/* Bytes held by the lookup structures (for lpm_print_stats) */
+size_t lpm_set_memory(const lpm_trie_t *trie);
+
+/* Teardown, called from lpm_destroy() */
+void lpm_set_destroy(struct lpm_set *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPM_ALGO_SET_H_ */
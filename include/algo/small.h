@@ -0,0 +1,84 @@
+/*
+ * liblpm - IPv4 Small-Table Engine (Eytzinger search over address ranges)
+ * Internal declarations
+ */
+#ifndef LPM_ALGO_SMALL_H_
+#define LPM_ALGO_SMALL_H_
+
+#include "../lpm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Data Structures
+ * ============================================================================ */
+
+struct lpm_small_rule {
+    uint32_t prefix;          /* Host order, masked to len bits */
+    uint32_t next_hop;
+    uint8_t len;
+};
+
+/*
+ * The prefixes cut the address space into disjoint ranges. The start of every
+ * range but the first is a key; keys are stored in Eytzinger (BFS) order,
+ * 1-based, biased by 2^31 so signed compares order them, and padded with
+ * INT32_MAX to a complete tree of 2^height - 1 keys.
+ *
+ * A lookup walks height levels keeping the last key greater than the address;
+ * vals[k] is the next hop of the range that ends just below key k, and
+ * vals[0] (no greater key) the next hop of the last range.
+ */
+struct lpm_small {
+    struct lpm_small_rule *rules;   /* Sorted by (prefix, len) */
+    uint32_t rule_count;
+    uint32_t rule_capacity;
+
+    int32_t *keys;            /* 2^height entries, keys[0] unused */
+    uint32_t *vals;           /* 2^height entries */
+    uint32_t height;
+};
+
+void lpm_small_destroy(struct lpm_small *s);
+size_t lpm_small_memory(const lpm_trie_t *trie);
+/* Point every prefix using old_nh at new_nh (default route included). On -1
+ * the rules are repointed but the search tree is not; the next update
+ * rebuilds it. */
+int lpm_small_repoint(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh);
+
+static inline uint32_t lpm_small_lookup_inline(const struct lpm_small *s, uint32_t addr)
+{
+    const int32_t *keys = s->keys;
+    int32_t x = (int32_t)(addr ^ 0x80000000U);
+    uint32_t k = 1, res = 0;
+
+    for (uint32_t h = s->height; h; h--) {
+        /* Four levels down is one cache line of 16 keys */
+        __builtin_prefetch(&keys[k * 16], 0, 3);
+        bool gt = keys[k] > x;
+        res = gt ? k : res;
+        k = 2 * k + !gt;
+    }
+    return s->vals[res];
+}
+
+/* ============================================================================
+ * Internal SIMD variants (used by ifunc resolver)
+ * Public API functions are declared in lpm.h
+ * ============================================================================ */
+
+void lpm_lookup_batch_ipv4_small_scalar(const lpm_trie_t *trie, const uint32_t *addrs,
+                                        uint32_t *next_hops, size_t count);
+void lpm_lookup_batch_ipv4_small_avx2(const lpm_trie_t *trie, const uint32_t *addrs,
+                                      uint32_t *next_hops, size_t count);
+void lpm_lookup_batch_ipv4_small_avx512(const lpm_trie_t *trie, const uint32_t *addrs,
+                                        uint32_t *next_hops, size_t count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPM_ALGO_SMALL_H_ */
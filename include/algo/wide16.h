@@ -11,6 +11,175 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Sparse 16-bit Nodes (src/wide16/sparse.c)
+ * ============================================================================ */
+
+#define LPM_SPARSE16_CELL     64    /* Pool allocation unit, one cache line */
+#define LPM_SPARSE16_CLASSES  15    /* Blocks of 1, 2, 4 ... 16384 cells */
+
+/*
+ * A sparse node holds the 65536 entries of a 16-bit level as runs of equal
+ * entries: run i covers [starts[i], starts[i + 1]) and its entry is what a
+ * flat node would hold there. An entry with a child is a run of one index.
+ * The header, the starts and the entries are contiguous in a block of
+ * cells, so a node of up to 5 runs, such as a /32 with one /48 below it,
+ * is a single cache line. A count of 0 marks a free block.
+ */
+struct lpm_sparse16 {
+    uint32_t count;           /* Runs; starts[0] == 0 */
+    uint32_t capacity;        /* Runs the block holds */
+    uint16_t starts[];        /* Entries follow, 8-byte aligned */
+};
+
+struct lpm_sparse16_pool {
+    uint8_t *cells;           /* Cache-line aligned */
+    uint32_t capacity;        /* Cells */
+    uint32_t used;            /* Cells handed out; cell 0 is never a node */
+    uint32_t free_head[LPM_SPARSE16_CLASSES];   /* 0 = none */
+    uint64_t nodes;
+    uint64_t live_cells;
+};
+
+enum lpm_sparse16_op {
+    LPM_SPARSE16_SET_NH,      /* Mark valid with next hop value */
+    LPM_SPARSE16_CLEAR_NH,    /* Mark invalid */
+    LPM_SPARSE16_SET_CHILD,   /* Child bits (index | LPM_WIDE_NODE_FLAG) = value */
+};
+
+struct lpm_sparse16_pool *lpm_sparse16_pool_create(void);
+void lpm_sparse16_pool_destroy(struct lpm_sparse16_pool *p);
+size_t lpm_sparse16_memory(const struct lpm_sparse16_pool *p);
+/* New node with every entry empty; LPM_INVALID_INDEX if out of memory */
+uint32_t lpm_sparse16_alloc(struct lpm_sparse16_pool *p);
+void lpm_sparse16_free(struct lpm_sparse16_pool *p, uint32_t idx);
+/* Apply op to indexes [lo, hi]. The node may move to a new block: *idx is
+ * updated and the caller repoints the parent. Returns 0 or -1 */
+int lpm_sparse16_update(struct lpm_sparse16_pool *p, uint32_t *idx, uint32_t lo, uint32_t hi,
+                        enum lpm_sparse16_op op, uint32_t value);
+/* Rewrite valid next hops old_nh in [lo, hi] in place (whole runs) */
+void lpm_sparse16_repoint(struct lpm_sparse16_pool *p, uint32_t idx, uint32_t lo, uint32_t hi,
+                          uint32_t old_nh, uint32_t new_nh);
+void lpm_sparse16_repoint_all(struct lpm_sparse16_pool *p, uint32_t old_nh, uint32_t new_nh);
+
+static inline struct lpm_sparse16 *lpm_sparse16_node(const struct lpm_sparse16_pool *p, uint32_t idx)
+{
+    return (struct lpm_sparse16 *)(p->cells + (size_t)idx * LPM_SPARSE16_CELL);
+}
+
+static inline struct lpm_entry *lpm_sparse16_entries(const struct lpm_sparse16 *n)
+{
+    size_t off = sizeof(*n) + (((size_t)n->capacity * sizeof(uint16_t) + 7) & ~(size_t)7);
+    return (struct lpm_entry *)((uint8_t *)n + off);
+}
+
+/* Run holding index: branch-free search for the last start <= index */
+static inline const struct lpm_entry *lpm_sparse16_find(const struct lpm_sparse16_pool *p,
+                                                        uint32_t idx, uint16_t index)
+{
+    const struct lpm_sparse16 *n = lpm_sparse16_node(p, idx);
+    const uint16_t *starts = n->starts;
+    uint32_t lo = 0, len = n->count;
+
+    while (len > 1) {
+        uint32_t half = len / 2;
+        lo = (starts[lo + half] <= index) ? lo + half : lo;
+        len -= half;
+    }
+    return &lpm_sparse16_entries(n)[lo];
+}
+
+/* Entry for index at a wide level: the flat root, or a sparse node below it */
+static inline const struct lpm_entry *lpm_wide16_entry(const lpm_trie_t *trie, unsigned level,
+                                                       uint32_t node, uint16_t index)
+{
+    if (level == 0) {
+        return &((const struct lpm_node_16 *)trie->wide_nodes_pool)[node].entries[index];
+    }
+    return lpm_sparse16_find(trie->sparse16, node, index);
+}
+
+/* ============================================================================
+ * Resumable updates
+ * A prefix up to /16 ends in the flat root and covers 2^(16-len) of its
+ * entries. The op records the range and what to write so the expansion can
+ * be split into bounded steps; every entry write is a single 8-byte store,
+ * so lookups between steps see each entry either before or after the update.
+ * Longer prefixes end in a sparse node (rewritten run by run) or an 8-bit
+ * node and are applied when the op begins.
+ * ============================================================================ */
+
+typedef struct lpm_wide16_op {
+    uint32_t base;        /* First root entry covered */
+    uint32_t count;       /* Entries covered */
+    uint32_t cursor;      /* Next entry to write */
+    uint32_t next_hop;
+    bool del;
+} lpm_wide16_op_t;
+
+/* Start an update. Returns 1 if root entries remain to be written with
+ * lpm_wide16_op_run(), 0 if the update completed, -1 on error. */
+int lpm_wide16_op_begin(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                        uint32_t next_hop, bool del, lpm_wide16_op_t *op);
+
+/* Write up to budget root entries and return the number written. The op is
+ * finished when cursor == count. */
+uint32_t lpm_wide16_op_run(lpm_trie_t *trie, lpm_wide16_op_t *op, uint32_t budget);
+
+/* ============================================================================
+ * Inline Lookup
+ * Shared by the single and batch lookups and lpm_inline.h; falls back to the
+ * default route
+ * ============================================================================ */
+
+__attribute__((hot, always_inline))
+static inline uint32_t lpm_wide16_lookup_inline(const lpm_trie_t *trie, const uint8_t *addr)
+{
+    uint32_t best_next_hop = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+    uint32_t node_idx = trie->root_idx;
+    const unsigned wide_levels = trie->wide_levels;
+    
+    /* Wide levels: flat 16-bit root, then sparse 16-bit nodes */
+    for (unsigned level = 0; level < wide_levels; level++) {
+        uint16_t index = ((uint16_t)addr[(size_t)level * 2] << 8) | addr[((size_t)level * 2) + 1];
+        const struct lpm_entry *entry = lpm_wide16_entry(trie, level, node_idx, index);
+        
+        if (entry->child_and_valid & LPM_VALID_FLAG) {
+            best_next_hop = entry->next_hop;
+        }
+        
+        uint32_t cv = entry->child_and_valid;
+        uint32_t child_idx = cv & LPM_CHILD_MASK;
+        bool has_child = (child_idx != 0) || (cv & LPM_WIDE_NODE_FLAG);
+        if (!has_child) {
+            return best_next_hop;
+        }
+        
+        node_idx = child_idx;
+    }
+    
+    /* Remaining levels: 8-bit stride */
+    for (unsigned byte_idx = 2 * wide_levels; byte_idx < 16; byte_idx++) {
+        if (node_idx == LPM_INVALID_INDEX) { break; }
+        
+        struct lpm_node *node = &((struct lpm_node *)trie->node_pool)[node_idx];
+        struct lpm_entry *entry = &node->entries[addr[byte_idx]];
+        
+        if (entry->child_and_valid & LPM_VALID_FLAG) {
+            best_next_hop = entry->next_hop;
+        }
+        
+        uint32_t child_idx = entry->child_and_valid & LPM_CHILD_MASK;
+        if (child_idx == LPM_INVALID_INDEX) {
+            return best_next_hop;
+        }
+        
+        node_idx = child_idx;
+    }
+    
+    return best_next_hop;
+}
+
 /* ============================================================================
  * Internal SIMD variants (used by ifunc resolver)
  * Public API functions are declared in lpm.h
@@ -30,6 +199,12 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
 void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t **addrs,
                                           uint32_t *next_hops, size_t count);
 
+typedef void (*lpm_wide16_batch_func_t)(const lpm_trie_t *, const uint8_t **, uint32_t *, size_t);
+
+/* lpm_lookup_batch_ipv6_wide16() with a given kernel, or the bound one if NULL */
+void lpm_lookup_batch_ipv6_wide16_with(lpm_wide16_batch_func_t kernel, const lpm_trie_t *trie,
+                                       const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,6 +5,7 @@
 #ifndef LPM_INTERNAL_H_
 #define LPM_INTERNAL_H_
 
+#include <time.h>
 #include "lpm.h"
 #include <dynemit/core.h>
 #include <dynemit/err.h>
@@ -12,22 +13,76 @@
 /* Conditional SIMD detection based on build configuration */
 #ifdef LPM_TS_RESOLVERS
     /* Thread-safe version for dlopen() contexts, plugins */
-    #define LPM_DETECT_SIMD() detect_simd_level_ts()
+    #define LPM_DETECT_SIMD_CPU() detect_simd_level_ts()
 #else
     /* Direct version for standard C programs (no atomic overhead) */
-    #define LPM_DETECT_SIMD() detect_simd_level()
+    #define LPM_DETECT_SIMD_CPU() detect_simd_level()
 #endif
 
+/* Functions the ifunc resolvers call. Resolvers can run before the library's
+ * PLT is relocated, so these must be reached by direct calls */
+#define LPM_RESOLVER_HELPER __attribute__((visibility("hidden")))
+
+/* Level the ifunc resolvers bind to: the CPU's, capped by LPM_SIMD (simd.c) */
+LPM_RESOLVER_HELPER simd_level_t lpm_simd_detect(void);
+#define LPM_DETECT_SIMD() lpm_simd_detect()
+
 /* Algorithm-specific headers */
 #include "algo/4stride8.h"
 #include "algo/6stride8.h"
 #include "algo/dir24.h"
 #include "algo/wide16.h"
+#include "algo/parse.h"
+#include "algo/set.h"
+#include "algo/small.h"
+#include "algo/lctrie.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Batch Kernel Selection (src/simd.c)
+ * The kernel each batch resolver binds at a SIMD level. Kept out of the algo
+ * headers so those need only lpm.h (lpm_inline.h includes them)
+ * ============================================================================ */
+
+/* Kernels over uint32_t addresses; the stride engines and wide16 take
+ * pointers to the address bytes (their *_batch_func_t) */
+typedef void (*lpm_batch_ipv4_kernel_t)(const lpm_trie_t *, const uint32_t *, uint32_t *, size_t);
+
+LPM_RESOLVER_HELPER lpm_batch_ipv4_kernel_t lpm_dir24_batch_kernel(simd_level_t level);
+LPM_RESOLVER_HELPER lpm_batch_ipv4_kernel_t lpm_dir24_compact_batch_kernel(simd_level_t level);
+LPM_RESOLVER_HELPER lpm_batch_ipv4_kernel_t lpm_small_batch_kernel(simd_level_t level);
+LPM_RESOLVER_HELPER lpm_ipv4_8stride_batch_func_t lpm_ipv4_8stride_batch_kernel(simd_level_t level);
+LPM_RESOLVER_HELPER lpm_ipv6_8stride_batch_func_t lpm_ipv6_8stride_batch_kernel(simd_level_t level);
+LPM_RESOLVER_HELPER lpm_wide16_batch_func_t lpm_wide16_batch_kernel(simd_level_t level);
+
+/* ============================================================================
+ * Timing (load and journal stats, update budgets, async batching)
+ * ============================================================================ */
+
+static inline double lpm_elapsed_ms(const struct timespec *a, const struct timespec *b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e3 + (double)(b->tv_nsec - a->tv_nsec) / 1e6;
+}
+
+static inline uint64_t lpm_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * DIR-24-8 Layout (src/dir24, shared with the journal and prefaulting)
+ * ============================================================================ */
+
+#define LPM_TBL8_GROUP_ENTRIES 256
+
+/* The compact kernels gather 4 bytes at 2-byte entries: pad the tables */
+#define LPM_DIR24C_PAD 64
+
 /* ============================================================================
  * Internal Node Pool Management
  * ============================================================================ */
@@ -38,6 +93,206 @@ uint32_t node_alloc(lpm_trie_t *trie);
 /* Allocate a new 16-bit wide stride node from the pool */
 uint32_t wide_node_alloc(lpm_trie_t *trie);
 
+/* ============================================================================
+ * Rule Store (src/rules.c)
+ * Exact (prefix, length) -> next hop map kept beside the expanded tables
+ * ============================================================================ */
+
+struct lpm_rule {
+    uint8_t prefix[16];   /* Masked to len bits, zero padded */
+    uint8_t len;
+    uint8_t used;
+    uint32_t next_hop;
+};
+
+struct lpm_rule_table {
+    struct lpm_rule *slots;
+    uint32_t capacity;    /* Power of two */
+    uint32_t count;
+    uint32_t len_count[129];
+};
+
+struct lpm_rule_table *lpm_rules_create(void);
+void lpm_rules_destroy(struct lpm_rule_table *rt);
+struct lpm_rule *lpm_rules_find(const struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len);
+/* Grow the table so count rules fit without rehashing. Returns 0 or -1 */
+int lpm_rules_reserve(struct lpm_rule_table *rt, size_t count);
+/* Insert or update; *existed tells which (may be NULL). Returns 0 or -1 */
+int lpm_rules_insert(struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len,
+                     uint32_t next_hop, bool *existed);
+/* Returns 0 if removed, -1 if not present */
+int lpm_rules_remove(struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len);
+/* Longest rule of length 1..len-1 covering prefix, or NULL */
+struct lpm_rule *lpm_rules_find_parent(const struct lpm_rule_table *rt, const uint8_t *prefix,
+                                       uint8_t len);
+/* Call fn for every rule of length len+1..max_len inside prefix/len */
+void lpm_rules_for_each_within(const struct lpm_rule_table *rt, const uint8_t *prefix,
+                               uint8_t len, uint8_t max_len,
+                               void (*fn)(const struct lpm_rule *r, void *ctx), void *ctx);
+
+/* ============================================================================
+ * Bulk Build (src/load.c)
+ * ============================================================================ */
+
+/* One parsed route; the loader sorts them by ascending length */
+struct lpm_route {
+    uint8_t prefix[16];
+    uint32_t next_hop;
+    uint8_t len;
+};
+
+/* Fill an empty DIR-24-8 table (either entry size) from routes sorted by
+ * ascending length in one pass, with no per-route depth checks. Adds the
+ * routes that could not be installed to *failed. Returns -1 without touching
+ * the trie if it already holds routes or is sharded. */
+int lpm_dir24_build(lpm_trie_t *trie, const struct lpm_route *routes, size_t count,
+                    uint64_t *failed);
+
+/* ============================================================================
+ * Incremental Updates (src/update.c)
+ * ============================================================================ */
+
+/* Apply every queued incremental update; called before synchronous updates */
+void lpm_update_flush(lpm_trie_t *trie);
+/* Whether lpm_add_incremental()/lpm_delete_incremental() queue on this trie */
+bool lpm_update_deferred(const lpm_trie_t *trie);
+void lpm_update_queue_destroy(struct lpm_update_queue *q);
+
+/* ============================================================================
+ * Engine Dispatch (src/api.c)
+ * lpm_add()/lpm_delete() minus route-level features (expiry, aggregation)
+ * ============================================================================ */
+
+/* Pick the generic lookup functions; every create function calls it last */
+void lpm_dispatch_init(lpm_trie_t *trie);
+
+int lpm_add_engine(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_delete_engine(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+
+/* ============================================================================
+ * FIB Aggregation (src/aggregate.c)
+ * ============================================================================ */
+
+int lpm_agg_add(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_agg_delete(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+/* Bulk build: stage routes without touching the engine, then commit once */
+int lpm_agg_stage(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_agg_commit(lpm_trie_t *trie);
+/* Point every route using old_nh at new_nh and reinstall what changes */
+int lpm_agg_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh);
+void lpm_agg_destroy(struct lpm_agg *a);
+
+/* ============================================================================
+ * Next-Hop Index (src/nexthop.c)
+ * ============================================================================ */
+
+/* Record or drop the next hop of a prefix; called by lpm_add()/lpm_delete() */
+int lpm_nh_index_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+void lpm_nh_index_clear(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+void lpm_nh_index_destroy(struct lpm_nh_index *x);
+
+/* ============================================================================
+ * Adaptive Tables (src/adaptive.c)
+ * ============================================================================ */
+
+/* The engine lookups currently run on, with its lookup functions */
+struct lpm_adapt_view {
+    lpm_trie_t *engine;
+    uint32_t (*lookup_ipv4)(const lpm_trie_t *trie, uint32_t addr);
+    void (*batch_ipv4)(const lpm_trie_t *trie, const uint32_t *addrs,
+                       uint32_t *next_hops, size_t count);
+    uint32_t (*lookup_ipv6)(const lpm_trie_t *trie, const uint8_t addr[16]);
+    void (*batch_ipv6)(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                       uint32_t *next_hops, size_t count);
+};
+
+/* First member of struct lpm_adapt: the part lookups touch */
+struct lpm_adapt_head {
+    const struct lpm_adapt_view *active;   /* Swapped with release semantics */
+    uint64_t lookups;                      /* Batch lookups, while count_lookups */
+    bool count_lookups;
+};
+
+int lpm_adapt_add(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_adapt_delete(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+/* Repoint the routes and the current engine; waits out a migration */
+int lpm_adapt_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh);
+void lpm_adapt_destroy(struct lpm_adapt *a);
+
+static inline const struct lpm_adapt_view *lpm_adapt_active(const lpm_trie_t *trie)
+{
+    return __atomic_load_n(&((const struct lpm_adapt_head *)trie->adapt)->active, __ATOMIC_ACQUIRE);
+}
+
+/* Batch lookups feed the traffic threshold of stride tables */
+static inline void lpm_adapt_count(const lpm_trie_t *trie, size_t count)
+{
+    struct lpm_adapt_head *h = (struct lpm_adapt_head *)trie->adapt;
+    if (__atomic_load_n(&h->count_lookups, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&h->lookups, count, __ATOMIC_RELAXED);
+    }
+}
+
+/* ============================================================================
+ * Expiring Prefixes (src/ttl.c)
+ * ============================================================================ */
+
+/* Drop the timer of a prefix, if any; called by lpm_add()/lpm_delete() */
+void lpm_ttl_cancel(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+void lpm_ttl_destroy(struct lpm_ttl *w);
+
+/* ============================================================================
+ * Update Journal (src/journal.c)
+ * ============================================================================ */
+
+enum lpm_journal_op {
+    LPM_JOURNAL_ADD = 1,
+    LPM_JOURNAL_DELETE = 2,
+    LPM_JOURNAL_REPLACE = 3,     /* a = old next hop, b = new next hop */
+};
+
+/* Record an applied update; write errors latch in the journal */
+void lpm_journal_record(lpm_trie_t *trie, enum lpm_journal_op op, const uint8_t *prefix,
+                        uint8_t prefix_len, uint32_t a, uint32_t b);
+/* Commit pending records once the oldest is sync_us old */
+void lpm_journal_idle(lpm_trie_t *trie);
+/* snapshot_records records have been written since the last snapshot */
+bool lpm_journal_snapshot_due(const lpm_trie_t *trie);
+void lpm_journal_destroy(struct lpm_journal *j);
+
+/* ============================================================================
+ * Sharded Writers (src/shard.c)
+ * ============================================================================ */
+
+/* lpm_add()/lpm_delete() of a sharded DIR-24-8 trie, under the shard locks */
+int lpm_shard_update(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                     uint32_t next_hop, bool del);
+/* Rule table holding prefix/len, and the longest rule covering it */
+struct lpm_rule_table *lpm_shard_rules(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+struct lpm_rule *lpm_shard_find_parent(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+/* Next tbl8 group reserved by the shard of dir24 slot idx, or -1 */
+int32_t lpm_shard_tbl8_alloc(lpm_trie_t *trie, uint32_t idx);
+/* lpm_replace_next_hop() with every shard locked */
+void lpm_shard_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh);
+/* Shard owning prefix/len, or -1 if it spans several (or none are set up) */
+int lpm_shard_of(const lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+unsigned lpm_shard_count(const lpm_trie_t *trie);
+void lpm_shards_destroy(struct lpm_shards *x);
+
+/* ============================================================================
+ * Asynchronous Updates (src/async.c)
+ * ============================================================================ */
+
+/* Apply what is queued, stop the writer thread and free the queue */
+void lpm_async_destroy(lpm_trie_t *trie);
+
+/* ============================================================================
+ * Prefaulting (src/prefault.c)
+ * ============================================================================ */
+
+/* munlock() what lpm_prefault() locked; called by lpm_destroy() */
+void lpm_prefault_release(lpm_trie_t *trie);
+
 /* ============================================================================
  * Algorithm Type Enumeration
  * ============================================================================ */
@@ -52,9 +307,35 @@ typedef enum {
  * Shared Utility Functions
  * ============================================================================ */
 
-/* Cache management */
+/* Cache management; also bumps the generation */
 void lpm_cache_invalidate(lpm_trie_t *trie);
 
+/* Called after every change to the table: range-cache entries filled
+ * before it stop matching (src/rangecache.c) */
+static inline void lpm_generation_bump(lpm_trie_t *trie)
+{
+    __atomic_add_fetch(&trie->generation, 1, __ATOMIC_RELEASE);
+}
+
+/* Reader side of the next-hop replacement epoch (src/nexthop.c): wait until
+ * no replacement runs, look up, and retry if the epoch moved meanwhile */
+static inline uint64_t lpm_replace_read_begin(const lpm_trie_t *trie)
+{
+    uint64_t seq;
+    while ((seq = __atomic_load_n(&trie->replace_seq, __ATOMIC_ACQUIRE)) & 1) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    return seq;
+}
+
+static inline bool lpm_replace_read_retry(const lpm_trie_t *trie, uint64_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&trie->replace_seq, __ATOMIC_RELAXED) != seq;
+}
+
 /* Fast inline hash for hot cache */
 static inline uint64_t lpm_fast_hash(const uint8_t *addr, uint8_t len)
 {
@@ -38,8 +38,11 @@ extern "C" {
 /* IPv6 Variable Stride Configuration: 16-8-8-8...
  * First 16 bits: 1 level of 16-bit stride (512KB)
  * Remaining 112 bits: 14 levels of 8-bit stride
+ * lpm_create_ipv6_wide16_levels() makes up to 3 levels wide (16-16-16-8...);
+ * the second and third are sparse nodes sized by their content.
  */
 #define LPM_IPV6_WIDE_STRIDE_LEVELS 1
+#define LPM_IPV6_WIDE_STRIDE_MAX_LEVELS 3
 
 /* IPv4 DIR-24-8 Configuration
  * First 24 bits: Single 24-bit lookup (16.7M entries)
@@ -117,6 +120,13 @@ struct lpm_tbl8_entry {
 #define LPM_DIR24_EXT_FLAG      (1U << 30)  /* Extended to tbl8 */
 #define LPM_DIR24_NH_MASK       0x3FFFFFFF  /* Lower 30 bits for next_hop/tbl8_idx */
 
+/* Compact DIR-24-8 entries (2 bytes): bit 15 = tbl8 extended flag,
+ * bits 0-14 = tbl8 group, or next_hop + 1 with 0 meaning no route */
+#define LPM_DIR24C_EXT_FLAG     0x8000
+#define LPM_DIR24C_IDX_MASK     0x7FFF
+#define LPM_DIR24C_MAX_NEXT_HOP 0x7FFE      /* Largest storable next hop */
+#define LPM_DIR24C_MAX_GROUPS   0x8000      /* tbl8 groups addressable in 15 bits */
+
 /* Legacy compatibility */
 struct lpm_node {
     struct lpm_entry entries[LPM_STRIDE_SIZE_8];
@@ -150,13 +160,40 @@ struct lpm_trie {
     void *wide_nodes_pool;
     uint32_t wide_pool_capacity;
     uint32_t wide_pool_used;
+    struct lpm_sparse16_pool *sparse16;  /* Sparse 16-bit nodes below the root (internal) */
     
     /* IPv4 DIR-24-8 table (compact 4-byte entries) */
     struct lpm_dir24_entry *dir24_table;
     struct lpm_tbl8_entry *tbl8_groups;  /* Array of 256-entry groups */
     uint32_t tbl8_num_groups;
     uint32_t tbl8_groups_used;
-    
+    uint16_t *dir24c_table;              /* Compact variant: 2-byte entries, 32 MB */
+    uint16_t *tbl8c_groups;
+    uint8_t *dir24_depth;                /* Prefix length behind each dir24 slot */
+    uint8_t *tbl8_depth;                 /* Prefix length behind each tbl8 entry */
+
+    /* Installed rules and queued incremental updates (internal) */
+    struct lpm_rule_table *rules;
+    struct lpm_update_queue *updates;
+    struct lpm_set *set;                 /* Membership set tables (set tries only) */
+    struct lpm_small *small;             /* Range search tree (small tries only) */
+    struct lpm_lctrie *lctrie;           /* Level-compressed trie (LC-trie tries only) */
+    struct lpm_adapt *adapt;             /* Engine behind an adaptive trie (internal) */
+    struct lpm_ttl *ttl;                 /* Expiry timers (internal, update path only) */
+    struct lpm_agg *agg;                 /* Routes behind an aggregated FIB (internal) */
+    struct lpm_nh_index *nh_index;       /* Next hop -> prefixes (internal, update path only) */
+    struct lpm_journal *journal;         /* Update journal (internal, update path only) */
+    struct lpm_shards *shards;           /* Per-shard writer state (internal, update path only) */
+    struct lpm_async *async;             /* Update queue and writer thread (internal) */
+
+    /* Engine lookups behind the generic calls, set at creation (internal) */
+    uint32_t (*lookup_ipv4)(const struct lpm_trie *trie, uint32_t addr);
+    void (*lookup_batch_ipv4)(const struct lpm_trie *trie, const uint32_t *addrs,
+                              uint32_t *next_hops, size_t count);
+    uint32_t (*lookup_ipv6)(const struct lpm_trie *trie, const uint8_t addr[16]);
+    void (*lookup_batch_ipv6)(const struct lpm_trie *trie, const uint8_t (*addrs)[16],
+                              uint32_t *next_hops, size_t count);
+
     uint32_t root_idx;
     
     uint64_t num_prefixes;
@@ -164,11 +201,15 @@ struct lpm_trie {
     uint64_t num_wide_nodes;
     uint64_t cache_hits;
     uint64_t cache_misses;
+    uint64_t generation;         /* Bumped after every table change (range caches) */
+    uint64_t replace_seq;        /* Odd while lpm_replace_next_hop() rewrites entries */
     
     uint8_t max_depth;
     bool has_default_route;
     bool use_huge_pages;
+    bool mem_locked;             /* Table memory mlock()ed by lpm_prefault() */
     bool use_ipv6_wide_stride;  /* Enable 16-bit stride for IPv6 */
+    uint8_t wide_levels;         /* 16-bit levels of a wide16 trie (1-3) */
     bool use_ipv4_dir24;         /* Enable DIR-24-8 for IPv4 */
     
     uint32_t default_next_hop;
@@ -203,6 +244,18 @@ void lpm_lookup_batch_ipv4(const lpm_trie_t *trie, const uint32_t *addrs,
 void lpm_lookup_batch_ipv6(const lpm_trie_t *trie, const uint8_t (*addrs)[16], 
                            uint32_t *next_hops, size_t count);
 
+/* Multi-table batch lookup: every address is looked up in each of the k
+ * tries (e.g. FIB, ACL class, geo) in a single pass, with the k walks
+ * interleaved so their memory accesses overlap. results[t][i] receives the
+ * next hop of addrs[i] in tries[t]. Tries may mix engines of one family;
+ * NULL or wrong-family tries yield LPM_INVALID_NEXT_HOP. */
+void lpm_lookup_batch_multi_ipv4(const lpm_trie_t *const *tries, size_t k,
+                                 const uint32_t *addrs, uint32_t *const *results,
+                                 size_t count);
+void lpm_lookup_batch_multi_ipv6(const lpm_trie_t *const *tries, size_t k,
+                                 const uint8_t (*addrs)[16], uint32_t *const *results,
+                                 size_t count);
+
 /* ============================================================================
  * ALGORITHM-SPECIFIC API: IPv4 DIR-24-8
  *
@@ -222,6 +275,56 @@ void lpm_lookup_batch_ipv4_dir24_bytes(const lpm_trie_t *trie, const uint8_t (*a
 void lpm_lookup_batch_ipv4_dir24_ptrs(const lpm_trie_t *trie, const uint8_t **addrs,
                                        uint32_t *next_hops, size_t count);
 
+/* Compact variant: 2-byte entries halve the 24-bit table to 32 MB so twice
+ * as much of it stays in the LLC. Next hops are limited to
+ * 0..LPM_DIR24C_MAX_NEXT_HOP and tbl8 groups to LPM_DIR24C_MAX_GROUPS.
+ * Prefixes are added and deleted with lpm_add_ipv4_dir24() and
+ * lpm_delete_ipv4_dir24() (or the generic calls). */
+lpm_trie_t *lpm_create_ipv4_dir24_compact(void);
+uint32_t lpm_lookup_ipv4_dir24_compact(const lpm_trie_t *trie, uint32_t addr);
+void lpm_lookup_batch_ipv4_dir24_compact(const lpm_trie_t *trie, const uint32_t *addrs,
+                                         uint32_t *next_hops, size_t count);
+
+/* ============================================================================
+ * ALGORITHM-SPECIFIC API: IPv4 Small Table
+ *
+ * For tables of up to LPM_SMALL_MAX_PREFIXES prefixes (ACLs, VRFs, tenant
+ * tables). Prefixes are flattened into disjoint address ranges whose starts
+ * are searched as an implicit Eytzinger tree: a few KB instead of DIR-24-8's
+ * 64MB, and batch lookups run the search in SIMD lanes. Every update
+ * rebuilds the tree (O(n)); adds beyond the cap fail.
+ * ============================================================================ */
+
+#define LPM_SMALL_MAX_PREFIXES 4096
+
+lpm_trie_t *lpm_create_ipv4_small(void);
+int lpm_add_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_delete_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+uint32_t lpm_lookup_ipv4_small(const lpm_trie_t *trie, uint32_t addr);
+void lpm_lookup_batch_ipv4_small(const lpm_trie_t *trie, const uint32_t *addrs,
+                                 uint32_t *next_hops, size_t count);
+
+/* ============================================================================
+ * ALGORITHM-SPECIFIC API: IPv4 LC-Trie
+ *
+ * Level- and path-compressed binary trie in the style of Linux's fib_trie.
+ * Runs of bits every prefix below a node shares are skipped, and dense
+ * subtrees are replaced by one node indexing several bits at once, resized
+ * as the table changes. Memory grows with the number of prefixes (a few
+ * tens of bytes each) rather than with their spread, at the cost of a
+ * pointer chase per level and a backtracking step when the deepest match
+ * is not the longest. Lookups must not run concurrently with updates.
+ * lpm_lctrie_memory() reports the bytes held by nodes and leaves.
+ * ============================================================================ */
+
+lpm_trie_t *lpm_create_ipv4_lctrie(void);
+int lpm_add_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+int lpm_delete_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+uint32_t lpm_lookup_ipv4_lctrie(const lpm_trie_t *trie, uint32_t addr);
+void lpm_lookup_batch_ipv4_lctrie(const lpm_trie_t *trie, const uint32_t *addrs,
+                                  uint32_t *next_hops, size_t count);
+size_t lpm_lctrie_memory(const lpm_trie_t *trie);
+
 /* ============================================================================
  * ALGORITHM-SPECIFIC API: IPv4 8-bit Stride
  *
@@ -244,9 +347,15 @@ void lpm_lookup_batch_ipv4_8stride_bytes(const lpm_trie_t *trie, const uint8_t *
  *
  * Uses 16-bit stride for first level, then 8-bit for remaining.
  * Optimal for IPv6 with common /48 allocations.
+ *
+ * With 2 or 3 wide levels, /32 and /48 prefixes resolve in 2 or 3 node
+ * visits. Only the root is a flat 512KB node; the 16-bit levels below it
+ * store runs of equal entries and cost a cache line when nearly empty.
  * ============================================================================ */
 
 lpm_trie_t *lpm_create_ipv6_wide16(void);
+/* wide_levels 1..LPM_IPV6_WIDE_STRIDE_MAX_LEVELS; 1 is lpm_create_ipv6_wide16() */
+lpm_trie_t *lpm_create_ipv6_wide16_levels(uint8_t wide_levels);
 int lpm_add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
 int lpm_delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
 uint32_t lpm_lookup_ipv6_wide16(const lpm_trie_t *trie, const uint8_t addr[16]);
@@ -267,6 +376,508 @@ uint32_t lpm_lookup_ipv6_8stride(const lpm_trie_t *trie, const uint8_t addr[16])
 void lpm_lookup_batch_ipv6_8stride(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
                                     uint32_t *next_hops, size_t count);
 
+/* ============================================================================
+ * ADDRESS TEXT PARSING
+ *
+ * Batch parsers for IPv4/IPv6 addresses and CIDR prefixes, vectorised with
+ * SSE4.2/AVX2 and selected at load time via ifunc like the lookup kernels.
+ *
+ * strs[i] is parsed as exactly lens[i] bytes; pass lens == NULL for
+ * NUL-terminated strings. status (may be NULL) receives one LPM_PARSE_*
+ * code per element; failed elements have their outputs zeroed.
+ * All functions return the number of elements parsed successfully.
+ * ============================================================================ */
+
+#define LPM_PARSE_OK              0
+#define LPM_PARSE_ERR_SYNTAX      1  /* Malformed address text */
+#define LPM_PARSE_ERR_RANGE       2  /* IPv4 octet above 255 */
+#define LPM_PARSE_ERR_PREFIX_LEN  3  /* Malformed or too long "/len" */
+
+/* Dotted-quad to host byte order (0xC0A80001 == "192.168.0.1"), ready for
+ * lpm_lookup_ipv4() and lpm_lookup_batch_ipv4() */
+size_t lpm_parse_ipv4_batch(const char *const *strs, const size_t *lens,
+                            uint32_t *addrs, uint8_t *status, size_t count);
+
+/* RFC 4291 text form (including "::" and embedded IPv4) to network order */
+size_t lpm_parse_ipv6_batch(const char *const *strs, const size_t *lens,
+                            uint8_t (*addrs)[16], uint8_t *status, size_t count);
+
+/* "addr/len" in either family (a bare address is a host route). Prefixes are
+ * written in network byte order with host bits cleared, ready for lpm_add().
+ * max_depths (may be NULL) receives LPM_IPV4_MAX_DEPTH or LPM_IPV6_MAX_DEPTH
+ * so mixed input can be routed to the right trie. */
+size_t lpm_parse_prefix_batch(const char *const *strs, const size_t *lens,
+                              uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                              uint8_t *max_depths, uint8_t *status, size_t count);
+
+/* ============================================================================
+ * BULK LOADING
+ *
+ * lpm_load_prefix_file() memory-maps a route dump and inserts every prefix of
+ * the trie's address family; prefixes of the other family are skipped.
+ * Recognised formats:
+ * - Text: "prefix/len [next_hop]" per line, '#' starts a comment. Lines
+ *   without a next-hop column get next hop 0.
+ * - MRT TABLE_DUMP_V2 (RFC 6396/8050) RIB records. The next hop is the peer
+ *   index of the first RIB entry.
+ *
+ * Parsing is split across num_threads threads (0 = one per online CPU). The
+ * parsed prefixes are then ordered by length and inserted shortest-first in
+ * one pass, so duplicates resolve to the last occurrence in the file.
+ *
+ * lpm_load_prefix_file_pair() fills an IPv4 and an IPv6 trie from a single
+ * parse of a mixed dump; either trie may be NULL.
+ * ============================================================================ */
+
+typedef struct lpm_load_stats {
+    uint64_t records;   /* Non-empty text lines or MRT RIB records */
+    uint64_t loaded;    /* Prefixes inserted */
+    uint64_t skipped;   /* Prefixes of the other address family */
+    uint64_t errors;    /* Malformed records or rejected inserts */
+    uint32_t threads;   /* Parser threads actually used */
+    bool mrt;           /* Input was detected as MRT */
+    double parse_ms;
+    double sort_ms;
+    double build_ms;
+} lpm_load_stats_t;
+
+/* Returns 0 on success (check stats->errors for malformed input), -1 if the
+ * file cannot be read or memory runs out. stats may be NULL. */
+int lpm_load_prefix_file(lpm_trie_t *trie, const char *path, unsigned num_threads,
+                         lpm_load_stats_t *stats);
+int lpm_load_prefix_file_pair(lpm_trie_t *ipv4, lpm_trie_t *ipv6, const char *path,
+                              unsigned num_threads, lpm_load_stats_t *stats);
+
+/* ============================================================================
+ * RANGE CACHE
+ *
+ * A per-thread result cache for lookups that repeat within address ranges
+ * rather than for single addresses: IPv6 traffic spread over many hosts of
+ * the same /64, say. Each result is stored under the longest address prefix
+ * that every address inside resolves identically on this table (where the
+ * lookup walk stopped), so any address in the range hits. Stride and wide16
+ * tries and DIR-24-8 stop early; other engines are cached per address.
+ *
+ * Every update bumps trie->generation, which makes older entries miss; no
+ * flush is needed. A cache serves one trie and one thread: create one per
+ * lookup thread, and destroy them before the trie. Updates and uncached
+ * lookups may run concurrently as usual.
+ * ============================================================================ */
+
+typedef struct lpm_range_cache lpm_range_cache_t;
+
+typedef struct lpm_range_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;   /* Lookups that found the generation moved */
+    uint32_t spans;           /* Range lengths cached in this generation */
+} lpm_range_cache_stats_t;
+
+/* entries is rounded up to a power of two; 0 means 4096. NULL on error. */
+lpm_range_cache_t *lpm_range_cache_create(const lpm_trie_t *trie, uint32_t entries);
+void lpm_range_cache_destroy(lpm_range_cache_t *cache);
+uint32_t lpm_lookup_ipv4_cached(lpm_range_cache_t *cache, uint32_t addr);
+uint32_t lpm_lookup_ipv6_cached(lpm_range_cache_t *cache, const uint8_t addr[16]);
+int lpm_range_cache_stats(const lpm_range_cache_t *cache, lpm_range_cache_stats_t *stats);
+
+/* ============================================================================
+ * PREFAULTING
+ *
+ * A freshly built or loaded table takes page faults and TLB misses on the
+ * first lookups into each page, which shows up as latency spikes right
+ * after a failover. lpm_prefault() moves that cost to a call made before
+ * traffic arrives:
+ * - LPM_PREFAULT_POPULATE maps every page of the table (MADV_POPULATE_WRITE,
+ *   or a read of each page on older kernels).
+ * - LPM_PREFAULT_HUGEPAGES backs arrays of 2MB and more with transparent huge
+ *   pages, collapsing them at once where the kernel supports MADV_COLLAPSE.
+ * - LPM_PREFAULT_LOCK mlock()s the table; it stays locked until
+ *   lpm_destroy(). Arrays reallocated by later updates are not locked.
+ * - LPM_PREFAULT_WARM reads the parts every lookup walks (tbl8 groups,
+ *   stride nodes, search trees, bitmaps) into the cache. The 24-bit
+ *   DIR-24-8 tables are included when the table fits in half the LLC.
+ *
+ * Table contents are not modified: lookups may run meanwhile, updates
+ * should not. An adaptive trie prefaults the engine currently serving
+ * lookups. Returns 0, or -1 for bad arguments or when memory could not be
+ * locked (RLIMIT_MEMLOCK); the other steps are still done. stats may be
+ * NULL.
+ * ============================================================================ */
+
+#define LPM_PREFAULT_POPULATE   (1U << 0)
+#define LPM_PREFAULT_HUGEPAGES  (1U << 1)
+#define LPM_PREFAULT_LOCK       (1U << 2)
+#define LPM_PREFAULT_WARM       (1U << 3)
+#define LPM_PREFAULT_ALL        0xFU
+
+typedef struct lpm_prefault_stats {
+    size_t bytes;         /* Table memory covered */
+    size_t huge_bytes;    /* Advised for huge pages */
+    size_t locked_bytes;
+    size_t warm_bytes;    /* Read into the cache */
+    double hugepage_ms;
+    double populate_ms;
+    double lock_ms;
+    double warm_ms;
+    double total_ms;
+} lpm_prefault_stats_t;
+
+int lpm_prefault(lpm_trie_t *trie, unsigned flags, lpm_prefault_stats_t *stats);
+
+/* ============================================================================
+ * UPDATE JOURNAL
+ *
+ * lpm_enable_journal() persists a trie under path: path.snap holds an image
+ * of the table and path.wal a journal of every lpm_add()/lpm_delete()
+ * (including the incremental forms) and lpm_replace_next_hop() applied since.
+ * lpm_recover() maps the snapshot, restores the engine's arrays directly and
+ * replays only the journal tail, so restarting takes time in proportion to
+ * the churn since the last snapshot rather than to the table size. The
+ * recovered trie keeps journaling to the same files.
+ *
+ * Journal records are group committed: they are written and fdatasync()ed
+ * together once sync_records are pending or the oldest is sync_us old
+ * (checked when a record is added and by lpm_journal_poll() and
+ * lpm_update_step()), or on lpm_journal_sync(). Updates not yet synced may
+ * be lost in a crash. lpm_snapshot() writes a new image and starts an empty
+ * journal; it runs after lpm_load_prefix_file(), and lpm_journal_poll()
+ * runs it once snapshot_records records are pending. Snapshots take time in
+ * proportion to the table size, on the caller's thread, so updates never
+ * take one: call lpm_journal_poll() when idle. With async updates the
+ * writer does so itself when its queue runs empty.
+ *
+ * Snapshots can be read only by the same build of the library. DIR-24-8
+ * (both variants), the stride engines, wide16 and small tables are
+ * supported; membership sets, adaptive and aggregated tries, expiring
+ * prefixes, and next-hop indexes on engines without a rule store are not.
+ * ============================================================================ */
+
+typedef struct lpm_journal_config {
+    uint32_t sync_records;      /* fdatasync() once this many are pending; 0: no limit */
+    uint32_t sync_us;           /* ... or once the oldest is this old; 0: no limit */
+    uint64_t snapshot_records;  /* lpm_journal_poll() snapshots after this many; 0: never */
+} lpm_journal_config_t;
+
+typedef struct lpm_recover_stats {
+    uint64_t snapshot_lsn;      /* Journal records the snapshot includes */
+    uint64_t replayed;          /* Records replayed on top of it */
+    uint64_t failed;            /* Replayed updates that failed again */
+    uint64_t truncated_bytes;   /* Torn journal tail dropped */
+    size_t snapshot_bytes;
+    double snapshot_ms;         /* Map and restore the snapshot */
+    double replay_ms;
+} lpm_recover_stats_t;
+
+/* config may be NULL for the defaults (1024 records, 10 ms, 1M records).
+ * Writes the current contents as the first snapshot. Returns 0 or -1. */
+int lpm_enable_journal(lpm_trie_t *trie, const char *path, const lpm_journal_config_t *config);
+int lpm_journal_sync(lpm_trie_t *trie);
+/* Commit records once due and take the snapshot once due. Returns 1 if it
+ * wrote a snapshot, 0, or -1 on error */
+int lpm_journal_poll(lpm_trie_t *trie);
+int lpm_snapshot(lpm_trie_t *trie);
+/* Returns NULL if there is no valid snapshot at path or the journal does
+ * not continue it. stats may be NULL. */
+lpm_trie_t *lpm_recover(const char *path, const lpm_journal_config_t *config,
+                        lpm_recover_stats_t *stats);
+
+/* ============================================================================
+ * SHARDED WRITERS
+ *
+ * lpm_enable_sharded_writers() lets several threads call lpm_add() and
+ * lpm_delete() (and their incremental forms, applied immediately) on one
+ * DIR-24-8 trie at once. The address space is split into 2^shard_bits
+ * shards by its top bits (8: one shard per /8); each shard has its own
+ * lock, rule table and tbl8 reservation, so updates to different shards
+ * run in parallel. Prefixes shorter than shard_bits lock every shard.
+ * Lookups stay lock-free. lpm_load_prefix_file() builds sharded tries with
+ * one thread per group of shards.
+ *
+ * Aggregation, expiring prefixes, the next-hop index and the journal need
+ * every route in one place: they cannot be combined with sharding.
+ * lpm_replace_next_hop() works and locks every shard. Returns 0, or -1 for
+ * other engines, shard_bits outside 1..8, or one of those features.
+ * ============================================================================ */
+
+int lpm_enable_sharded_writers(lpm_trie_t *trie, unsigned shard_bits);
+
+/* ============================================================================
+ * ASYNCHRONOUS UPDATES
+ *
+ * lpm_enable_async_updates() starts a writer thread for the trie. Any
+ * number of threads then enqueue updates with lpm_add_async() and
+ * lpm_delete_async(), which take no locks and return a sequence number
+ * (0 for bad arguments). Sequence numbers are handed out in queue order
+ * and the writer applies operations in that order, so once
+ * lpm_async_applied() reaches n every update numbered n or less is
+ * installed; lpm_async_wait() blocks until then. on_applied, if set, is
+ * called on the writer thread after each batch with the new value.
+ *
+ * The writer applies up to batch_size operations at a time, keeping only
+ * the last one per prefix: repeated adds install the last next hop and an
+ * add followed by a delete cancels out. With a journal each batch is synced
+ * before it is reported. When the queue is full, enqueueing waits for the
+ * writer.
+ *
+ * While the writer runs it owns the update path: other update calls are
+ * safe only on tries with sharded writers, and features are enabled
+ * beforehand (aggregation, the next-hop index, the journal and sharding
+ * refuse a trie with async updates). lpm_destroy() applies what is queued
+ * and stops the writer. Lookups are unaffected.
+ * ============================================================================ */
+
+typedef struct lpm_async_config {
+    uint32_t queue_size;        /* Operations the queue holds, a power of two; 0: 65536 */
+    uint32_t batch_size;        /* Most operations applied per batch; 0: 4096 */
+    void (*on_applied)(void *ctx, uint64_t seq);
+    void *ctx;
+} lpm_async_config_t;
+
+typedef struct lpm_async_stats {
+    uint64_t enqueued;          /* Last sequence number handed out */
+    uint64_t applied;           /* Sequence number applied up to */
+    uint64_t depth;             /* Enqueued, not yet applied */
+    uint64_t max_depth;
+    uint64_t coalesced;         /* Operations superseded or cancelled within a batch */
+    uint64_t failed;            /* Adds and deletes that returned -1 */
+    uint64_t batches;
+    double latency_avg_us;      /* Enqueue to applied */
+    double latency_max_us;
+} lpm_async_stats_t;
+
+/* config may be NULL for the defaults. Returns 0, or -1 if async updates
+ * are already on, the sizes are invalid or the thread cannot start. */
+int lpm_enable_async_updates(lpm_trie_t *trie, const lpm_async_config_t *config);
+uint64_t lpm_add_async(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop);
+uint64_t lpm_delete_async(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+uint64_t lpm_async_applied(const lpm_trie_t *trie);
+/* Returns 0 once seq is applied, -1 if it was never handed out */
+int lpm_async_wait(lpm_trie_t *trie, uint64_t seq);
+int lpm_async_stats(const lpm_trie_t *trie, lpm_async_stats_t *stats);
+
+/* ============================================================================
+ * INCREMENTAL UPDATES
+ *
+ * Adding or deleting a short prefix in DIR-24-8 rewrites 2^(24-len) table
+ * slots; a /8 is 65,536 of them. In wide16 a prefix up to /16 rewrites
+ * 2^(16-len) root entries. The incremental calls queue the update and
+ * lpm_update_step() applies queued work for about budget_us microseconds, so
+ * large expansions can be spread between lookup batches. Lookups in between
+ * see every slot either before or after the update in progress, and more
+ * specific prefixes are never overwritten by a covering one.
+ *
+ * Updates apply in queue order, and lpm_add()/lpm_delete() apply everything
+ * queued before them first. Queued deletes of prefixes that are not installed
+ * are ignored.
+ *
+ * DIR-24-8 (either entry size) and wide16 are deferred; wide16 defers the
+ * root entries and applies longer prefixes when their turn comes. All other
+ * engines, and aggregated or sharded tries, apply incremental updates
+ * immediately and without a time budget, as lpm_add()/lpm_delete() would.
+ * DIR-24-8 keeps a 16 MB array of the prefix length behind each slot for
+ * this, and lpm_delete() of a prefix that is not installed returns -1.
+ * On a journaled trie lpm_update_step() also commits journal records that
+ * are sync_us old, even when nothing is queued.
+ * ============================================================================ */
+
+int lpm_add_incremental(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                        uint32_t next_hop);
+int lpm_delete_incremental(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len);
+
+/* Returns 1 if work remains, 0 when the queue is empty, -1 on error. At least
+ * one slice of work is done per call, even with a zero budget. */
+int lpm_update_step(lpm_trie_t *trie, uint32_t budget_us);
+
+/* Number of queued updates, counting one that is partially applied */
+size_t lpm_update_pending(const lpm_trie_t *trie);
+
+/* ============================================================================
+ * FIB AGGREGATION
+ *
+ * Replaces a route set with the smallest prefix set that forwards every
+ * address to the same next hop (ORTC). Adjacent and nested routes with equal
+ * next hops collapse, which saves tbl8 groups and stride nodes. Addresses no
+ * route covers stay uncovered.
+ *
+ * lpm_aggregate() minimizes arrays in place before they are loaded;
+ * *count is updated. lpm_enable_aggregation() (on an empty trie) keeps the
+ * trie's contents minimal under lpm_add()/lpm_delete(): routes are recorded
+ * as given, and only the prefixes whose selection changes are rewritten in
+ * the engine. Lookups are unchanged. lpm_route_count() returns the number of
+ * routes added; trie->num_prefixes counts the prefixes actually installed.
+ * On the 8-bit stride and wide16 engines, which do not keep covered prefixes,
+ * each rewrite also re-installs the installed prefixes it covers in the same
+ * stride node, shortest first.
+ * ============================================================================ */
+
+int lpm_aggregate(uint8_t (*prefixes)[16], uint8_t *prefix_lens, uint32_t *next_hops,
+                  size_t *count, uint8_t max_depth);
+int lpm_enable_aggregation(lpm_trie_t *trie);
+size_t lpm_route_count(const lpm_trie_t *trie);
+
+/* ============================================================================
+ * NEXT-HOP REPLACEMENT
+ *
+ * lpm_replace_next_hop() repoints every prefix using old_next_hop to
+ * new_next_hop, e.g. when a BGP peer goes down. With the reverse index
+ * enabled (lpm_enable_next_hop_index(), kept up to date by lpm_add()/
+ * lpm_delete() and the incremental calls), only the table spans of the
+ * affected prefixes are rewritten; without it the whole table is scanned.
+ * The index can be enabled on a non-empty DIR-24-8 trie, other engines need
+ * an empty one.
+ *
+ * A replacement is published as one epoch: trie->replace_seq is odd while
+ * entries are rewritten. The generic batch lookups (lpm_lookup_batch(),
+ * lpm_lookup_batch_ipv4(), lpm_lookup_batch_ipv6()) retry across it, so
+ * every result of a batch comes from before or every one from after the
+ * replacement. Other readers that need the same for a group of lookups
+ * bracket them with lpm_replace_seq()/lpm_replace_retry(). A single lookup
+ * needs no retry: each entry changes with one store, so it sees the old or
+ * the new next hop.
+ * ============================================================================ */
+
+int lpm_enable_next_hop_index(lpm_trie_t *trie);
+int lpm_replace_next_hop(lpm_trie_t *trie, uint32_t old_next_hop, uint32_t new_next_hop);
+
+/* Epoch to pass to lpm_replace_retry(); waits while a replacement runs */
+uint64_t lpm_replace_seq(const lpm_trie_t *trie);
+/* True if a replacement started or finished since lpm_replace_seq() */
+bool lpm_replace_retry(const lpm_trie_t *trie, uint64_t seq);
+
+/* Prefixes using next_hop (0 without the index) */
+size_t lpm_next_hop_count(const lpm_trie_t *trie, uint32_t next_hop);
+
+/* ============================================================================
+ * EXPIRING PREFIXES
+ *
+ * lpm_add_ttl() adds a prefix like lpm_add() and schedules its removal at
+ * expires_at; lpm_expire(now) deletes every prefix due at or before now in
+ * one call. Times use any monotonic unit the caller picks (seconds,
+ * milliseconds, ...) as long as it is used consistently. Timers are kept in
+ * a hierarchical timing wheel that only the update calls touch, so lookups
+ * cost nothing extra. Adding the prefix again (with lpm_add_ttl() or
+ * lpm_add()) replaces its expiry, and lpm_delete() cancels it; use the
+ * generic calls rather than the engine-specific ones for such prefixes.
+ *
+ * On DIR-24-8 the due prefixes are deleted through the incremental update
+ * queue and applied in one flush, with one generation bump; other engines
+ * delete them one at a time. In neither case is the batch atomic: a lookup
+ * running concurrently may see some due prefixes removed and others still
+ * present, though each address resolves to a route it had before or after.
+ * ============================================================================ */
+
+int lpm_add_ttl(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                uint32_t next_hop, uint64_t expires_at);
+
+/* Returns the number of prefixes removed */
+size_t lpm_expire(lpm_trie_t *trie, uint64_t now);
+
+/* Pending timers and the bytes they use (wheel, timers and their index) */
+size_t lpm_ttl_count(const lpm_trie_t *trie);
+size_t lpm_ttl_memory(const lpm_trie_t *trie);
+
+/* ============================================================================
+ * ADAPTIVE TABLES
+ *
+ * An adaptive trie picks its engine from its size and moves to another one
+ * as it grows or shrinks: IPv4 small table -> 8-bit stride -> DIR-24-8,
+ * IPv6 8-bit stride -> wide16. It moves up when the prefix count exceeds a
+ * threshold and back down below half of it. A stride table that serves
+ * hot_lookups batch lookups moves up early and stays up.
+ *
+ * The next engine is built on a worker thread while updates continue; the
+ * first update or lpm_adaptive_poll() after the build switches lookups over
+ * with one atomic pointer store. The replaced engine stays allocated until
+ * lpm_adaptive_reclaim() or the next switch-over, so a lookup may overlap
+ * one switch-over but not two. All generic calls work on adaptive tries;
+ * IPv4 next hops are limited to LPM_DIR24_NH_MASK.
+ * ============================================================================ */
+
+typedef struct lpm_adaptive_config {
+    uint32_t small_max;     /* IPv4: most prefixes kept in the small table (< 2048) */
+    uint32_t stride_max;    /* Most prefixes kept in the 8-bit stride engine */
+    uint64_t hot_lookups;   /* Batch lookups that promote a stride table (0 = off) */
+} lpm_adaptive_config_t;
+
+/* config NULL: small_max 1024, stride_max 65536, hot_lookups 2^26 */
+lpm_trie_t *lpm_create_adaptive(uint8_t max_depth, const lpm_adaptive_config_t *config);
+
+/* Switch over to a finished engine and start any migration that is due.
+ * Returns 1 while a migration is in flight, 0 otherwise, -1 on error */
+int lpm_adaptive_poll(lpm_trie_t *trie);
+
+/* Block until an in-flight migration has switched over (or failed) */
+int lpm_adaptive_wait(lpm_trie_t *trie);
+
+/* Free the engine replaced by the last switch-over; call once no lookup
+ * that started before it can still be running */
+void lpm_adaptive_reclaim(lpm_trie_t *trie);
+
+/* "small", "stride8", "dir24" or "wide16"; NULL if not adaptive */
+const char *lpm_adaptive_engine(const lpm_trie_t *trie);
+uint32_t lpm_adaptive_migrations(const lpm_trie_t *trie);
+
+/* ============================================================================
+ * MEMBERSHIP SETS
+ *
+ * For blocklists and other sets that only need "is this address covered",
+ * without a next hop. IPv4 keeps one bit per /24 (a 2 MB bitmap) plus
+ * 256-bit blocks for /24s that hold longer prefixes; IPv6 uses a byte-stride
+ * trie of bitmap nodes. Prefixes are added and deleted with lpm_add() and
+ * lpm_delete() (the next hop is ignored). Other lookups on a set trie return
+ * 0 for covered addresses and LPM_INVALID_NEXT_HOP otherwise.
+ *
+ * Batch calls write one bit per address to mask (bit i % 64 of word i / 64,
+ * (count + 63) / 64 words) and return the number of covered addresses.
+ * ============================================================================ */
+
+lpm_trie_t *lpm_create_set_ipv4(void);
+lpm_trie_t *lpm_create_set_ipv6(void);
+bool lpm_contains_ipv4(const lpm_trie_t *set, uint32_t addr);
+bool lpm_contains_ipv6(const lpm_trie_t *set, const uint8_t addr[16]);
+size_t lpm_contains_batch_ipv4(const lpm_trie_t *set, const uint32_t *addrs,
+                               uint64_t *mask, size_t count);
+size_t lpm_contains_batch_ipv6(const lpm_trie_t *set, const uint8_t (*addrs)[16],
+                               uint64_t *mask, size_t count);
+
+/* ============================================================================
+ * SIMD KERNEL SELECTION
+ *
+ * Each engine's batch lookup is bound to one kernel when the library loads,
+ * from the SIMD level the CPU supports. Setting LPM_SIMD to a level name
+ * ("scalar", "sse2", "sse42", "avx", "avx2", "avx512") in the environment
+ * caps the level every engine binds to; unknown names are ignored and a cap
+ * above the CPU's level has no effect.
+ *
+ * The _simd batch calls run the kernel the trie's engine uses at level,
+ * whatever was bound at load time. They return 0, or -1 if the CPU lacks
+ * level, the trie is of the other address family, or its batch path has no
+ * per-level kernels (sets and adaptive tries). Engines do not have a kernel
+ * for every level: lpm_simd_kernel_level() returns the lowest level that runs
+ * the same kernel as level, or -1 as above.
+ * ============================================================================ */
+
+typedef enum {
+    LPM_SIMD_SCALAR = 0,
+    LPM_SIMD_SSE2,
+    LPM_SIMD_SSE4_2,
+    LPM_SIMD_AVX,
+    LPM_SIMD_AVX2,
+    LPM_SIMD_AVX512,
+    LPM_SIMD_LEVELS
+} lpm_simd_level_t;
+
+lpm_simd_level_t lpm_simd_cpu_level(void);
+/* Level the batch kernels are bound at: the CPU's, capped by LPM_SIMD */
+lpm_simd_level_t lpm_simd_active_level(void);
+/* The LPM_SIMD name of level; NULL if out of range */
+const char *lpm_simd_level_name(lpm_simd_level_t level);
+int lpm_simd_kernel_level(const lpm_trie_t *trie, lpm_simd_level_t level);
+int lpm_lookup_batch_ipv4_simd(const lpm_trie_t *trie, lpm_simd_level_t level,
+                               const uint32_t *addrs, uint32_t *next_hops, size_t count);
+int lpm_lookup_batch_ipv6_simd(const lpm_trie_t *trie, lpm_simd_level_t level,
+                               const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count);
+
 /* ============================================================================
  * LEGACY API (for backwards compatibility)
  *
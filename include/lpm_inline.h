@@ -0,0 +1,140 @@
+/*
+ * liblpm - Inline Lookup Kernels
+ *
+ * The exported lookups are reached through the PLT, most of them through an
+ * ifunc, and each call checks the trie again, so none of them can inline
+ * into a caller's per-packet loop. This header has the same single-address
+ * lookups as static inline functions without the checks: classify the trie
+ * once with lpm_inline_engine(), then call the kernel for that engine (or
+ * lpm_inline_lookup_ipv4/6(), whose switch the compiler hoists out of a loop
+ * over one trie).
+ *
+ * A trie's engine is fixed when it is created, so the classification holds
+ * for the life of the trie. The kernels read the tables exactly as the
+ * exported lookups do and are safe under the same conditions; calling one on
+ * a trie of another engine is undefined. They use the library's internal
+ * table layouts, so code built with this header must run against the liblpm
+ * version it was compiled with. C only.
+ */
+#ifndef LPM_INLINE_H_
+#define LPM_INLINE_H_
+
+#include "lpm.h"
+#include "algo/4stride8.h"
+#include "algo/6stride8.h"
+#include "algo/dir24.h"
+#include "algo/small.h"
+#include "algo/lctrie.h"
+#include "algo/wide16.h"
+
+/* Engine behind a trie's lookups */
+typedef enum {
+    LPM_INLINE_NONE = 0,        /* No inline kernel (NULL, set or adaptive trie) */
+    LPM_INLINE_IPV4_DIR24,
+    LPM_INLINE_IPV4_DIR24C,
+    LPM_INLINE_IPV4_SMALL,
+    LPM_INLINE_IPV4_LCTRIE,
+    LPM_INLINE_IPV4_8STRIDE,
+    LPM_INLINE_IPV6_WIDE16,
+    LPM_INLINE_IPV6_8STRIDE
+} lpm_inline_engine_t;
+
+/* Same order as lpm_lookup_ipv4() and lpm_lookup_ipv6() dispatch */
+static inline lpm_inline_engine_t lpm_inline_engine(const lpm_trie_t *trie)
+{
+    if (!trie) {
+        return LPM_INLINE_NONE;
+    }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        if (trie->use_ipv4_dir24 && trie->dir24_table) { return LPM_INLINE_IPV4_DIR24; }
+        if (trie->dir24c_table) { return LPM_INLINE_IPV4_DIR24C; }
+        if (trie->small) { return LPM_INLINE_IPV4_SMALL; }
+        if (trie->lctrie) { return LPM_INLINE_IPV4_LCTRIE; }
+        if (trie->set || trie->adapt) { return LPM_INLINE_NONE; }
+        return LPM_INLINE_IPV4_8STRIDE;
+    }
+    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) { return LPM_INLINE_IPV6_WIDE16; }
+    if (trie->set || trie->adapt) { return LPM_INLINE_NONE; }
+    return LPM_INLINE_IPV6_8STRIDE;
+}
+
+/* ============================================================================
+ * IPv4 Kernels (addr in host byte order, as lpm_lookup_ipv4())
+ * ============================================================================ */
+
+static inline uint32_t lpm_inline_default(const lpm_trie_t *trie, uint32_t result)
+{
+    return (result == LPM_INVALID_NEXT_HOP && trie->has_default_route) ? trie->default_next_hop : result;
+}
+
+static inline uint32_t lpm_inline_lookup_ipv4_dir24(const lpm_trie_t *trie, uint32_t addr)
+{
+    const uint8_t bytes[4] = { addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF };
+    return lpm_inline_default(trie, lpm_dir24_lookup_inline(trie->dir24_table, trie->tbl8_groups, bytes));
+}
+
+static inline uint32_t lpm_inline_lookup_ipv4_dir24c(const lpm_trie_t *trie, uint32_t addr)
+{
+    return lpm_inline_default(trie, lpm_dir24c_lookup_inline(trie->dir24c_table, trie->tbl8c_groups, addr));
+}
+
+static inline uint32_t lpm_inline_lookup_ipv4_small(const lpm_trie_t *trie, uint32_t addr)
+{
+    return lpm_small_lookup_inline(trie->small, addr);
+}
+
+/* Inlines the descent; the rare lookup that has to back up calls into the
+ * library */
+static inline uint32_t lpm_inline_lookup_ipv4_lctrie(const lpm_trie_t *trie, uint32_t addr)
+{
+    return lpm_lctrie_lookup_inline(trie->lctrie, addr);
+}
+
+static inline uint32_t lpm_inline_lookup_ipv4_8stride(const lpm_trie_t *trie, uint32_t addr)
+{
+    const uint8_t bytes[4] = { addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF };
+    return lpm_inline_default(trie, lpm_ipv4_8stride_lookup_inline(trie->node_pool, trie->root_idx, bytes));
+}
+
+/* lpm_lookup_ipv4() for a trie classified as engine */
+static inline uint32_t lpm_inline_lookup_ipv4(const lpm_trie_t *trie, lpm_inline_engine_t engine,
+                                              uint32_t addr)
+{
+    switch (engine) {
+    case LPM_INLINE_IPV4_DIR24:   return lpm_inline_lookup_ipv4_dir24(trie, addr);
+    case LPM_INLINE_IPV4_DIR24C:  return lpm_inline_lookup_ipv4_dir24c(trie, addr);
+    case LPM_INLINE_IPV4_SMALL:   return lpm_inline_lookup_ipv4_small(trie, addr);
+    case LPM_INLINE_IPV4_LCTRIE:  return lpm_inline_lookup_ipv4_lctrie(trie, addr);
+    case LPM_INLINE_IPV4_8STRIDE: return lpm_inline_lookup_ipv4_8stride(trie, addr);
+    default:
+        return lpm_lookup_ipv4(trie, addr);
+    }
+}
+
+/* ============================================================================
+ * IPv6 Kernels
+ * ============================================================================ */
+
+static inline uint32_t lpm_inline_lookup_ipv6_wide16(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    return lpm_wide16_lookup_inline(trie, addr);
+}
+
+static inline uint32_t lpm_inline_lookup_ipv6_8stride(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    return lpm_inline_default(trie, lpm_ipv6_8stride_lookup_inline(trie->node_pool, trie->root_idx, addr));
+}
+
+/* lpm_lookup_ipv6() for a trie classified as engine */
+static inline uint32_t lpm_inline_lookup_ipv6(const lpm_trie_t *trie, lpm_inline_engine_t engine,
+                                              const uint8_t addr[16])
+{
+    switch (engine) {
+    case LPM_INLINE_IPV6_WIDE16:  return lpm_inline_lookup_ipv6_wide16(trie, addr);
+    case LPM_INLINE_IPV6_8STRIDE: return lpm_inline_lookup_ipv6_8stride(trie, addr);
+    default:
+        return lpm_lookup_ipv6(trie, addr);
+    }
+}
+
+#endif /* LPM_INLINE_H_ */
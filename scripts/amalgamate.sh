@@ -0,0 +1,187 @@
+#!/bin/bash
+# amalgamate.sh - Generate the single-file liblpm build
+#
+# Usage: ./scripts/amalgamate.sh -o OUT_DIR -I DYNEMIT_INCLUDE_DIR
+#                                [-4 dir24|stride8] [-6 wide16|stride8] [-t]
+#                                SOURCE...
+#
+# Writes OUT_DIR/lpm.c, the given sources (libdynemit's first, then liblpm's
+# in build order) as one translation unit with every project and libdynemit
+# header inlined once, plus OUT_DIR/lpm.h and a self-contained
+# OUT_DIR/lpm_inline.h. Build with: cc -O3 -c lpm.c
+#
+# Options:
+#   -o DIR    Output directory (created if missing)
+#   -I DIR    libdynemit include directory (holds dynemit/core.h)
+#   -4 ALGO   Default IPv4 algorithm baked in (default: stride8)
+#   -6 ALGO   Default IPv6 algorithm baked in (default: wide16)
+#   -t        Thread-safe resolvers (LPM_TS_RESOLVERS)
+#
+# The CMake target 'amalgamation' (-DBUILD_AMALGAMATION=ON) runs this with
+# the configured sources and options.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+
+OUT_DIR=""
+DYNEMIT_INCLUDE=""
+IPV4_DEFAULT="stride8"
+IPV6_DEFAULT="wide16"
+TS_RESOLVERS=0
+
+while getopts "o:I:4:6:t" opt; do
+    case $opt in
+        o) OUT_DIR="$OPTARG" ;;
+        I) DYNEMIT_INCLUDE="$OPTARG" ;;
+        4) IPV4_DEFAULT="$OPTARG" ;;
+        6) IPV6_DEFAULT="$OPTARG" ;;
+        t) TS_RESOLVERS=1 ;;
+        *) exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ -z "$OUT_DIR" ] || [ -z "$DYNEMIT_INCLUDE" ] || [ $# -eq 0 ]; then
+    echo "Usage: $0 -o OUT_DIR -I DYNEMIT_INCLUDE_DIR [-4 ALGO] [-6 ALGO] [-t] SOURCE..." >&2
+    exit 1
+fi
+case "$IPV4_DEFAULT" in dir24|stride8) ;; *) echo "Error: -4 must be dir24 or stride8" >&2; exit 1 ;; esac
+case "$IPV6_DEFAULT" in wide16|stride8) ;; *) echo "Error: -6 must be wide16 or stride8" >&2; exit 1 ;; esac
+
+mkdir -p "$OUT_DIR"
+VERSION="$(sed -n 's/^project(liblpm VERSION \([0-9.]*\).*/\1/p' "$PROJECT_ROOT/CMakeLists.txt")"
+
+# Expand the quoted includes and <dynemit/...> includes of each file in turn,
+# each header at its first include only (none is included conditionally, so
+# guards and #pragma once have nothing left to do). lpm.h stays an #include,
+# as it ships beside lpm.c, and system headers are left alone.
+expand() {
+    awk -v root="$PROJECT_ROOT" -v dyninc="$DYNEMIT_INCLUDE" '
+    function dirname(p) {
+        if (p !~ /\//) { return "." }
+        sub(/\/[^\/]*$/, "", p)
+        return p
+    }
+    function canon(p,    n, i, k, parts, st, out) {
+        n = split(p, parts, "/")
+        k = 0
+        for (i = 1; i <= n; i++) {
+            if (parts[i] == "." || (parts[i] == "" && i > 1)) { continue }
+            if (parts[i] == ".." && k > 0 && st[k] != ".." && st[k] != "") { k--; continue }
+            st[++k] = parts[i]
+        }
+        out = st[1]
+        for (i = 2; i <= k; i++) { out = out "/" st[i] }
+        return out
+    }
+    function exists(p,    junk, r) {
+        r = (getline junk < p)
+        if (r >= 0) { close(p) }
+        return r >= 0
+    }
+    function rel(p) {
+        if (index(p, root "/") == 1) { return substr(p, length(root) + 2) }
+        if (index(p, dyninc "/") == 1) { return "libdynemit/" substr(p, length(dyninc) + 2) }
+        return p
+    }
+    function emit(path,    dir, line, inc, target) {
+        if (path in seen) { return }
+        seen[path] = 1
+        dir = dirname(path)
+        print "/************** Begin " rel(path) " **************/"
+        while ((getline line < path) > 0) {
+            if (line ~ /^[ \t]*#[ \t]*include[ \t]*"/) {
+                inc = line
+                sub(/^[^"]*"/, "", inc)
+                sub(/".*$/, "", inc)
+                target = canon(dir "/" inc)
+                if (!exists(target)) { target = canon(dyninc "/" inc) }
+                if (target == public_h) {
+                    if (!public_done++) { print "#include \"lpm.h\"" }
+                    continue
+                }
+                if (exists(target)) { emit(target); continue }
+            } else if (line ~ /^[ \t]*#[ \t]*include[ \t]*<dynemit\//) {
+                inc = line
+                sub(/^[^<]*</, "", inc)
+                sub(/>.*$/, "", inc)
+                emit(canon(dyninc "/" inc))
+                continue
+            } else if (line ~ /^[ \t]*#[ \t]*pragma[ \t]+once/) {
+                continue
+            }
+            print line
+        }
+        close(path)
+        print "/************** End " rel(path) " **************/"
+    }
+    BEGIN {
+        root = canon(root)
+        dyninc = canon(dyninc)
+        public_h = root "/include/lpm.h"
+        for (i = 1; i < ARGC; i++) {
+            emit(canon(ARGV[i]))
+        }
+        exit
+    }' "$@"
+}
+
+# Absolute paths, so headers resolve against the including file
+SOURCES=()
+for f in "$@"; do
+    case "$f" in
+        /*) SOURCES+=("$f") ;;
+        *) SOURCES+=("$PWD/$f") ;;
+    esac
+done
+
+{
+    cat <<EOF
+/*
+ * liblpm $VERSION amalgamation: the whole library, libdynemit included, as
+ * one translation unit. Generated by scripts/amalgamate.sh; do not edit.
+ *
+ * Build: cc -O3 -c lpm.c (needs lpm.h beside it; link with -lm -lpthread).
+ * The SIMD kernels carry their own target attributes and are picked at load
+ * time by ifunc resolvers, as in the regular build.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* Build configuration; define these first to override */
+#if !defined(LPM_IPV4_DEFAULT_dir24) && !defined(LPM_IPV4_DEFAULT_stride8)
+#define LPM_IPV4_DEFAULT_$IPV4_DEFAULT 1
+#endif
+#if !defined(LPM_IPV6_DEFAULT_wide16) && !defined(LPM_IPV6_DEFAULT_stride8)
+#define LPM_IPV6_DEFAULT_$IPV6_DEFAULT 1
+#endif
+#if !defined(LPM_X86_ARCH) && (defined(__x86_64__) || defined(__i386__))
+#define LPM_X86_ARCH 1
+#endif
+EOF
+    if [ $TS_RESOLVERS -eq 1 ]; then
+        printf '#ifndef LPM_TS_RESOLVERS\n#define LPM_TS_RESOLVERS 1\n#endif\n'
+    fi
+    echo ""
+    expand "${SOURCES[@]}"
+} > "$OUT_DIR/lpm.c"
+
+cp "$PROJECT_ROOT/include/lpm.h" "$OUT_DIR/lpm.h"
+
+{
+    cat <<EOF
+/*
+ * liblpm $VERSION inline lookup kernels, with the internal headers they use
+ * inlined. Generated by scripts/amalgamate.sh from include/lpm_inline.h;
+ * do not edit. Needs lpm.h beside it.
+ */
+
+EOF
+    expand "$PROJECT_ROOT/include/lpm_inline.h"
+} > "$OUT_DIR/lpm_inline.h"
+
+echo "Amalgamation written to $OUT_DIR (lpm.c, lpm.h, lpm_inline.h)"
@@ -0,0 +1,165 @@
+#!/bin/bash
+#
+# Profile-Guided liblpm Build
+#
+# Builds liblpm_pgo: liblpm compiled with instrumentation, trained on the
+# benchmark workloads, then rebuilt from the recorded profile with LTO. The
+# hot lookup paths get their branch layout from the measured ext-flag rates
+# and trie depths instead of the __builtin_expect/hot annotations alone.
+#
+# Training workload, run against the instrumented library:
+#   - bench_bindings on a generated BGP-like IPv4 table (mostly /24, then
+#     /16-/23) with a trace where three in four addresses fall inside a
+#     prefix: single lookups and batches of 16, 256 and 4096
+#   - bench_lookup: every engine, IPv4 and IPv6, single and batch lookups,
+#     plus bulk updates, aggregation, journal replay and the update queues
+#
+# The training table has its own seed, so run_pgo_benchmarks.sh measures on
+# a table and trace the profile has not seen.
+#
+# Both phases run in one build directory: GCC finds each object's profile
+# by the object's path. The result is DIR/liblpm_pgo.so and liblpm_pgo.a,
+# with the benchmarks in DIR/benchmarks linked against them. Install the
+# shared library next to the default one with
+#   cmake --install DIR --component runtime
+# (or configure the main build with -DBUILD_PGO=ON, which runs this script).
+#
+# Usage:
+#   ./scripts/build_pgo.sh [OPTIONS] [-- CMAKE_ARGS...]
+#
+# Options:
+#   -B, --build-dir DIR     Build directory (default: build-pgo)
+#   --prefixes N            Prefixes in the training table (default: 100000)
+#   --addresses N           Addresses in the training trace (default: 1048576)
+#   -h, --help              Show this help
+#
+# Examples:
+#   ./scripts/build_pgo.sh
+#   ./scripts/build_pgo.sh -B /tmp/lpm-pgo -- -DLPM_IPV4_DEFAULT=dir24
+#   CC=clang ./scripts/build_pgo.sh
+#
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+BUILD_DIR="${PROJECT_ROOT}/build-pgo"
+PREFIXES=100000
+ADDRESSES=1048576
+TRAINING_SEED=20240601
+CMAKE_ARGS=()
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_usage() {
+    echo "Usage: $0 [OPTIONS] [-- CMAKE_ARGS...]"
+    echo ""
+    echo "Options:"
+    echo "  -B, --build-dir DIR     Build directory (default: build-pgo)"
+    echo "  --prefixes N            Prefixes in the training table (default: 100000)"
+    echo "  --addresses N           Addresses in the training trace (default: 1048576)"
+    echo "  -h, --help              Show this help"
+}
+
+# Parse arguments
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        -B|--build-dir)
+            BUILD_DIR="$2"
+            shift 2
+            ;;
+        --prefixes)
+            PREFIXES="$2"
+            shift 2
+            ;;
+        --addresses)
+            ADDRESSES="$2"
+            shift 2
+            ;;
+        -h|--help)
+            print_usage
+            exit 0
+            ;;
+        --)
+            shift
+            CMAKE_ARGS=("$@")
+            break
+            ;;
+        *)
+            echo -e "${RED}Error: Unknown option $1${NC}"
+            print_usage
+            exit 1
+            ;;
+    esac
+done
+
+mkdir -p "$BUILD_DIR"
+BUILD_DIR="$(cd "$BUILD_DIR" && pwd)"
+PROFILE_DIR="${BUILD_DIR}/pgo-profile"
+TRAIN_DIR="${BUILD_DIR}/pgo-train"
+JOBS="$(nproc 2> /dev/null || echo 4)"
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}  Profile-Guided liblpm Build${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+# Phase 1: instrumented library and the training programs
+echo -e "${YELLOW}[1/3] Building the instrumented library...${NC}"
+cmake -S "$PROJECT_ROOT" -B "$BUILD_DIR" \
+    -DCMAKE_BUILD_TYPE=Release \
+    -DLPM_PGO=GENERATE \
+    -DLPM_PGO_DIR="$PROFILE_DIR" \
+    -DBUILD_BENCHMARKS=ON \
+    -DBUILD_TESTS=OFF \
+    -DBUILD_TOOLS=OFF \
+    -DBUILD_PGO=OFF \
+    "${CMAKE_ARGS[@]}" > /dev/null
+cmake --build "$BUILD_DIR" -j "$JOBS" --target bench_bindings bench_lookup
+
+CC_PATH="$(sed -n 's/^CMAKE_C_COMPILER:[A-Z]*=//p' "$BUILD_DIR/CMakeCache.txt")"
+CLANG=0
+if "$CC_PATH" --version 2> /dev/null | grep -qi clang; then
+    CLANG=1
+fi
+
+# Phase 2: training runs; stale counts from an earlier build would skew the profile
+echo -e "${YELLOW}[2/3] Training on the benchmark workloads...${NC}"
+rm -rf "$PROFILE_DIR" "$TRAIN_DIR"
+mkdir -p "$PROFILE_DIR" "$TRAIN_DIR"
+export LLVM_PROFILE_FILE="${PROFILE_DIR}/lpm-%p.profraw"
+
+BENCH="${BUILD_DIR}/benchmarks"
+"$BENCH/bench_bindings" --generate "$TRAIN_DIR" --prefixes "$PREFIXES" \
+    --addresses "$ADDRESSES" --seed "$TRAINING_SEED"
+echo "  bench_bindings ($PREFIXES prefixes, $ADDRESSES addresses)"
+"$BENCH/bench_bindings" "$TRAIN_DIR/table.txt" "$TRAIN_DIR/trace.txt" > /dev/null
+echo "  bench_lookup"
+(cd "$TRAIN_DIR" && "$BENCH/bench_lookup" > /dev/null)
+
+if [[ $CLANG -eq 1 ]]; then
+    PROFDATA="${LLVM_PROFDATA:-$(dirname "$CC_PATH")/llvm-profdata}"
+    if [[ ! -x "$PROFDATA" ]]; then
+        PROFDATA="llvm-profdata"
+    fi
+    "$PROFDATA" merge -o "$PROFILE_DIR/lpm.profdata" "$PROFILE_DIR"/*.profraw
+fi
+if [[ -z "$(ls -A "$PROFILE_DIR")" ]]; then
+    echo -e "${RED}Error: training wrote no profile to $PROFILE_DIR${NC}"
+    exit 1
+fi
+
+# Phase 3: rebuild everything from the profile
+echo -e "${YELLOW}[3/3] Building the profile-guided library...${NC}"
+cmake -S "$PROJECT_ROOT" -B "$BUILD_DIR" -DLPM_PGO=USE > /dev/null
+cmake --build "$BUILD_DIR" -j "$JOBS"
+
+echo ""
+echo -e "${GREEN}Profile-guided library: ${BUILD_DIR}/liblpm_pgo.so${NC}"
+echo "Install alongside liblpm: cmake --install $BUILD_DIR --component runtime"
+echo "Compare with a default build: ./scripts/run_pgo_benchmarks.sh -B build -P $BUILD_DIR"
@@ -77,6 +77,9 @@ for config_dir in "$DATA_DIR"/*; do
                 "4stride8")
                     algo_name="IPv4 8-bit Stride"
                     ;;
+                "lctrie")
+                    algo_name="IPv4 LC-Trie"
+                    ;;
                 "wide16")
                     algo_name="IPv6 Wide 16-bit"
                     ;;
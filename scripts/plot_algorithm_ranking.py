@@ -47,6 +47,7 @@ SMALL_TABLE_PREFIX_COUNTS = [32, 64, 128]
 ALGORITHM_DISPLAY_NAMES = {
     'dir24': 'DIR-24-8',
     '4stride8': '4-Stride-8',
+    'lctrie': 'LC-Trie',
     '6stride8': '6-Stride-8',
     'wide16': 'Wide-16',
     'dpdk': 'DPDK IPv4',
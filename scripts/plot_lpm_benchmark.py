@@ -112,7 +112,7 @@ def infer_label_from_filepath(filepath: str, metadata: Dict[str, str]) -> str:
     if parent.count('_') >= 2:  # e.g., "dir24_ipv4_single"
         parts = parent.split('_')
         # Check if first part is an algorithm name
-        if parts[0] in ['dir24', '4stride8', 'wide16', '6stride8', 'dpdk', 'dpdk6', 'patricia', 'rmindlpm', 'rmindlpm6']:
+        if parts[0] in ['dir24', '4stride8', 'lctrie', 'wide16', '6stride8', 'dpdk', 'dpdk6', 'patricia', 'rmindlpm', 'rmindlpm6']:
             # This is cpu_comparison - use CPU name from filename or metadata
             if cpu:
                 cpu_short = cpu
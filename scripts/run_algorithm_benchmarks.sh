@@ -9,7 +9,7 @@
 #   ./scripts/run_algorithm_benchmarks.sh [OPTIONS]
 #
 # Options:
-#   -a, --algorithm ALGO    Run only specified algorithm (dir24, 4stride8, wide16, 6stride8)
+#   -a, --algorithm ALGO    Run only specified algorithm (dir24, 4stride8, lctrie, wide16, 6stride8)
 #   -t, --type TYPE         Run only specified lookup type (single, batch)
 #   -c, --cpu CPU           Pin to specific CPU core (default: 0)
 #   -o, --output DIR        Output directory (default: benchmarks/data/algorithm_comparison)
@@ -51,7 +51,7 @@ print_usage() {
     echo "Usage: $0 [OPTIONS]"
     echo ""
     echo "Options:"
-    echo "  -a, --algorithm ALGO    Run only specified algorithm (dir24, 4stride8, wide16, 6stride8)"
+    echo "  -a, --algorithm ALGO    Run only specified algorithm (dir24, 4stride8, lctrie, wide16, 6stride8)"
     echo "  -t, --type TYPE         Run only specified lookup type (single, batch)"
     echo "  -c, --cpu CPU           Pin to specific CPU core (default: 0)"
     echo "  -o, --output DIR        Output directory (default: benchmarks/data/algorithm_comparison)"
@@ -0,0 +1,334 @@
+#!/bin/bash
+#
+# LPM Binding Overhead Benchmark Runner
+#
+# Runs the raw C reference (benchmarks/bench_bindings.c) and every language
+# driver in benchmarks/bindings/ on one shared table and address trace, and
+# collects the results in a single CSV:
+#
+#   binding,api,mode,batch_size,lookups,ns_per_lookup,allocs_per_call,
+#   bytes_per_call,checksum,overhead_vs_c
+#
+# overhead_vs_c is ns_per_lookup divided by the C row of the same mode and
+# batch size. Every driver must report the C checksum; a mismatch means the
+# binding returned wrong next hops and fails the run. Bindings whose
+# toolchain or build is missing are skipped with a message.
+#
+# Usage:
+#   ./scripts/run_binding_benchmarks.sh [OPTIONS]
+#
+# Options:
+#   -B, --build-dir DIR     liblpm build directory (default: build)
+#   -o, --output FILE       CSV file (default: benchmarks/data/bindings/<host>.csv)
+#   -w, --workload DIR      Table and trace directory (default: <build-dir>/bindings_workload)
+#   -l, --languages LIST    Comma-separated drivers to run (default: all)
+#   -c, --cpu CPU           Pin to specific CPU core (default: 0)
+#   --prefixes N            Prefixes in a generated table (default: 100000)
+#   --addresses N           Addresses in a generated trace (default: 1048576)
+#   --baseline FILE         Compare ns_per_lookup with an earlier CSV
+#   --threshold PCT         Slowdown over the baseline that fails (default: 10)
+#   -h, --help              Show this help
+#
+# Examples:
+#   # Run every available binding
+#   ./scripts/run_binding_benchmarks.sh
+#
+#   # Only Go and Python, and fail on a 15% regression against the last run
+#   ./scripts/run_binding_benchmarks.sh -l go,python \
+#       --baseline benchmarks/data/bindings/old.csv --threshold 15
+#
+
+set -e
+
+# Default values
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+BUILD_DIR="${PROJECT_ROOT}/build"
+OUTPUT_FILE=""
+WORKLOAD_DIR=""
+LANGUAGES="c,cpp,go,python,java,csharp,lua,perl,php"
+CPU_CORE=0
+PREFIXES=100000
+ADDRESSES=1048576
+BASELINE=""
+THRESHOLD=10
+
+DRIVERS="${PROJECT_ROOT}/benchmarks/bindings"
+CSV_HEADER="binding,api,mode,batch_size,lookups,ns_per_lookup,allocs_per_call,bytes_per_call,checksum"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_usage() {
+    echo "Usage: $0 [OPTIONS]"
+    echo ""
+    echo "Options:"
+    echo "  -B, --build-dir DIR     liblpm build directory (default: build)"
+    echo "  -o, --output FILE       CSV file (default: benchmarks/data/bindings/<host>.csv)"
+    echo "  -w, --workload DIR      Table and trace directory (default: <build-dir>/bindings_workload)"
+    echo "  -l, --languages LIST    Comma-separated drivers to run (default: all)"
+    echo "                          c, cpp, go, python, java, csharp, lua, perl, php"
+    echo "  -c, --cpu CPU           Pin to specific CPU core (default: 0)"
+    echo "  --prefixes N            Prefixes in a generated table (default: 100000)"
+    echo "  --addresses N           Addresses in a generated trace (default: 1048576)"
+    echo "  --baseline FILE         Compare ns_per_lookup with an earlier CSV"
+    echo "  --threshold PCT         Slowdown over the baseline that fails (default: 10)"
+    echo "  -h, --help              Show this help"
+}
+
+# Parse arguments
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        -B|--build-dir)
+            BUILD_DIR="$(cd "$2" && pwd)"
+            shift 2
+            ;;
+        -o|--output)
+            OUTPUT_FILE="$2"
+            shift 2
+            ;;
+        -w|--workload)
+            WORKLOAD_DIR="$2"
+            shift 2
+            ;;
+        -l|--languages)
+            LANGUAGES="$2"
+            shift 2
+            ;;
+        -c|--cpu)
+            CPU_CORE="$2"
+            shift 2
+            ;;
+        --prefixes)
+            PREFIXES="$2"
+            shift 2
+            ;;
+        --addresses)
+            ADDRESSES="$2"
+            shift 2
+            ;;
+        --baseline)
+            BASELINE="$2"
+            shift 2
+            ;;
+        --threshold)
+            THRESHOLD="$2"
+            shift 2
+            ;;
+        -h|--help)
+            print_usage
+            exit 0
+            ;;
+        *)
+            echo -e "${RED}Error: Unknown option $1${NC}"
+            print_usage
+            exit 1
+            ;;
+    esac
+done
+
+OUTPUT_FILE="${OUTPUT_FILE:-${PROJECT_ROOT}/benchmarks/data/bindings/$(hostname).csv}"
+WORKLOAD_DIR="${WORKLOAD_DIR:-${BUILD_DIR}/bindings_workload}"
+BENCHMARK_BIN="${BUILD_DIR}/benchmarks/bench_bindings"
+TABLE="${WORKLOAD_DIR}/table.txt"
+TRACE="${WORKLOAD_DIR}/trace.txt"
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}  LPM Binding Overhead Benchmark${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+if [[ ! -x "$BENCHMARK_BIN" ]]; then
+    echo -e "${RED}Error: Benchmark binary not found at $BENCHMARK_BIN${NC}"
+    echo "Build it first:"
+    echo "  cmake -S . -B build -DCMAKE_BUILD_TYPE=Release -DBUILD_BENCHMARKS=ON"
+    echo "  cmake --build build --target bench_bindings"
+    exit 1
+fi
+
+if [[ ! -f "$TABLE" || ! -f "$TRACE" ]]; then
+    echo -e "${YELLOW}Generating workload in $WORKLOAD_DIR...${NC}"
+    mkdir -p "$WORKLOAD_DIR"
+    "$BENCHMARK_BIN" --generate "$WORKLOAD_DIR" --prefixes "$PREFIXES" --addresses "$ADDRESSES"
+fi
+
+# Every binding loads the liblpm from this build
+export LD_LIBRARY_PATH="${BUILD_DIR}${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}"
+
+PIN=()
+if command -v taskset > /dev/null; then
+    PIN=(taskset -c "$CPU_CORE")
+fi
+
+RESULTS="$(mktemp)"
+trap 'rm -f "$RESULTS"' EXIT
+
+skip() {
+    echo -e "${YELLOW}  $1: skipped ($2)${NC}"
+}
+
+# run_driver NAME COMMAND... - appends the driver's rows to RESULTS
+run_driver() {
+    local name="$1"
+    shift
+    local out
+    if out="$("${PIN[@]}" "$@")"; then
+        echo "$out" | grep "^${name}," >> "$RESULTS" || true
+        echo -e "${GREEN}  $name: done${NC}"
+    else
+        echo -e "${RED}  $name: failed${NC}"
+    fi
+}
+
+wanted() {
+    [[ ",$LANGUAGES," == *",$1,"* ]]
+}
+
+echo -e "${BLUE}Configuration:${NC}"
+echo "  Build directory: $BUILD_DIR"
+echo "  Table: $TABLE ($(grep -vc '^#' "$TABLE") prefixes)"
+echo "  Trace: $TRACE ($(wc -l < "$TRACE") addresses)"
+echo "  CPU core: $CPU_CORE"
+echo ""
+echo -e "${YELLOW}Running drivers...${NC}"
+
+if wanted c; then
+    run_driver c "$BENCHMARK_BIN" "$TABLE" "$TRACE"
+fi
+
+if wanted cpp; then
+    if [[ -x "${BUILD_DIR}/bindings/cpp/bench_bindings_cpp" ]]; then
+        run_driver cpp "${BUILD_DIR}/bindings/cpp/bench_bindings_cpp" "$TABLE" "$TRACE"
+    else
+        skip cpp "configure with -DBUILD_CPP_WRAPPER=ON"
+    fi
+fi
+
+if wanted go; then
+    if command -v go > /dev/null; then
+        GO_BIN="${BUILD_DIR}/bench_bindings_go"
+        if (cd "${DRIVERS}/go" && CGO_CFLAGS="-I${PROJECT_ROOT}/include" CGO_LDFLAGS="-L${BUILD_DIR}" go build -o "$GO_BIN" .); then
+            run_driver go "$GO_BIN" "$TABLE" "$TRACE"
+        else
+            skip go "build failed"
+        fi
+    else
+        skip go "go not found"
+    fi
+fi
+
+if wanted python; then
+    PY_PATH="${PROJECT_ROOT}/bindings/python/src${PYTHONPATH:+:$PYTHONPATH}"
+    if PYTHONPATH="$PY_PATH" python3 -c "import liblpm" 2> /dev/null; then
+        PYTHONPATH="$PY_PATH" run_driver python python3 "${DRIVERS}/bench_bindings.py" "$TABLE" "$TRACE"
+    else
+        skip python "liblpm module not built (pip install bindings/python)"
+    fi
+fi
+
+if wanted java; then
+    JAR="$(ls "${PROJECT_ROOT}"/bindings/java/build/libs/liblpm-*.jar 2> /dev/null | grep -v -e sources -e javadoc | head -1)"
+    if ! command -v javac > /dev/null; then
+        skip java "javac not found"
+    elif [[ -z "$JAR" ]]; then
+        skip java "jar not built (cd bindings/java && ./gradlew jar)"
+    else
+        JAVA_OUT="${BUILD_DIR}/bench_bindings_java"
+        mkdir -p "$JAVA_OUT"
+        javac -cp "$JAR" -d "$JAVA_OUT" "${DRIVERS}/BenchBindings.java"
+        run_driver java java -Djava.library.path="$BUILD_DIR" -cp "${JAR}:${JAVA_OUT}" BenchBindings "$TABLE" "$TRACE"
+    fi
+fi
+
+if wanted csharp; then
+    if command -v dotnet > /dev/null; then
+        run_driver csharp dotnet run -c Release --project "${DRIVERS}/csharp" -- "$TABLE" "$TRACE"
+    else
+        skip csharp "dotnet not found"
+    fi
+fi
+
+if wanted lua; then
+    if ! command -v lua > /dev/null; then
+        skip lua "lua not found"
+    elif [[ ! -f "${PROJECT_ROOT}/bindings/lua/liblpm.so" ]]; then
+        skip lua "module not built (make -C bindings/lua)"
+    else
+        LUA_CPATH="${PROJECT_ROOT}/bindings/lua/?.so;;" run_driver lua lua "${DRIVERS}/bench_bindings.lua" "$TABLE" "$TRACE"
+    fi
+fi
+
+if wanted perl; then
+    if perl -I"${PROJECT_ROOT}/bindings/perl/blib/lib" -I"${PROJECT_ROOT}/bindings/perl/blib/arch" -MNet::LPM -e 1 2> /dev/null; then
+        run_driver perl perl "${DRIVERS}/bench_bindings.pl" "$TABLE" "$TRACE"
+    else
+        skip perl "Net::LPM not built (cd bindings/perl && perl Makefile.PL && make)"
+    fi
+fi
+
+if wanted php; then
+    PHP_EXT="${PROJECT_ROOT}/bindings/php/modules/liblpm.so"
+    if ! command -v php > /dev/null; then
+        skip php "php not found"
+    elif [[ ! -f "$PHP_EXT" ]]; then
+        skip php "extension not built (cd bindings/php && phpize && ./configure && make)"
+    else
+        run_driver php php -d extension="$PHP_EXT" "${DRIVERS}/bench_bindings.php" "$TABLE" "$TRACE"
+    fi
+fi
+
+# Attach the overhead against C and check every checksum against it
+mkdir -p "$(dirname "$OUTPUT_FILE")"
+STATUS=0
+awk -F, -v header="${CSV_HEADER},overhead_vs_c" -v out="$OUTPUT_FILE" '
+    { rows[NR] = $0; key[NR] = $3 "," $4; ns[NR] = $6; sum[NR] = $9 }
+    $1 == "c" { c_ns[$3 "," $4] = $6; c_sum[$3 "," $4] = $9 }
+    END {
+        print header > out
+        bad = 0
+        for (i = 1; i <= NR; i++) {
+            k = key[i]
+            ratio = (k in c_ns && c_ns[k] > 0) ? sprintf("%.2f", ns[i] / c_ns[k]) : ""
+            print rows[i] "," ratio > out
+            if (k in c_sum && sum[i] != c_sum[k]) {
+                split(rows[i], f, ",")
+                printf "  checksum mismatch: %s %s batch=%s (%s, C has %s)\n", f[1], f[2], f[4], sum[i], c_sum[k]
+                bad = 1
+            }
+        }
+        exit bad
+    }' "$RESULTS" || STATUS=1
+
+echo ""
+column -s, -t "$OUTPUT_FILE" 2> /dev/null || cat "$OUTPUT_FILE"
+
+# Regression check against a baseline run
+if [[ -n "$BASELINE" ]]; then
+    echo ""
+    echo -e "${BLUE}Comparing with $BASELINE (threshold ${THRESHOLD}%)...${NC}"
+    awk -F, -v threshold="$THRESHOLD" '
+        FNR == 1 { next }
+        NR == FNR { base[$1 "," $2 "," $3 "," $4] = $6; next }
+        {
+            k = $1 "," $2 "," $3 "," $4
+            if (!(k in base) || base[k] <= 0) next
+            change = ($6 - base[k]) * 100 / base[k]
+            if (change > threshold) {
+                printf "  regression: %s %s batch=%s %.3f -> %.3f ns (+%.1f%%)\n", $1, $2, $4, base[k], $6, change
+                bad = 1
+            }
+        }
+        END { exit bad }' "$BASELINE" "$OUTPUT_FILE" || STATUS=1
+fi
+
+echo ""
+if [[ $STATUS -eq 0 ]]; then
+    echo -e "${GREEN}Results saved to: $OUTPUT_FILE${NC}"
+else
+    echo -e "${RED}Results saved to: $OUTPUT_FILE (checks failed)${NC}"
+fi
+exit $STATUS
@@ -0,0 +1,252 @@
+#!/bin/bash
+#
+# LPM Profile-Guided Build Comparison
+#
+# Runs the same benchmarks against a default build and a profile-guided
+# build (scripts/build_pgo.sh) and collects both in one CSV:
+#
+#   benchmark,engine,lookup,size,default_ns,pgo_ns,speedup
+#
+# - bindings: bench_bindings on a BGP-like IPv4 table and trace generated
+#   with a different seed than the training one, with the default engine.
+#   size is the batch size (1 for single lookups). Each build runs --runs
+#   times, alternating, and the best ns/lookup is kept. Both builds must
+#   return the same checksum.
+# - scaling: bench_algorithm_scaling for each engine in --algorithms, single
+#   and batch; size is the prefix count and ns is 1e9 / median lookups/sec.
+#   It takes a few minutes per engine and build; --algorithms none skips it.
+#
+# speedup is default_ns / pgo_ns, so above 1 means the PGO build is faster.
+#
+# Usage:
+#   ./scripts/run_pgo_benchmarks.sh [OPTIONS]
+#
+# Options:
+#   -B, --build-dir DIR     Default build directory (default: build)
+#   -P, --pgo-dir DIR       Profile-guided build directory
+#                           (default: <build-dir>/pgo if present, else build-pgo)
+#   -o, --output FILE       CSV file (default: benchmarks/data/pgo/<host>.csv)
+#   -w, --workload DIR      Table and trace directory (default: <build-dir>/pgo_compare_workload)
+#   -a, --algorithms LIST   Engines for the scaling runs
+#                           (default: dir24,4stride8,lctrie,wide16,6stride8; none to skip)
+#   -c, --cpu CPU           Pin to specific CPU core (default: 0)
+#   --runs N                bench_bindings runs per build (default: 3)
+#   -h, --help              Show this help
+#
+# Examples:
+#   # Main build configured with -DBUILD_PGO=ON -DBUILD_BENCHMARKS=ON
+#   ./scripts/run_pgo_benchmarks.sh -B build
+#
+#   # Separate builds, bindings workload and the dir24 sweep only
+#   ./scripts/run_pgo_benchmarks.sh -B build -P build-pgo -a dir24
+#
+
+set -e
+
+# Default values
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+BUILD_DIR="${PROJECT_ROOT}/build"
+PGO_DIR=""
+OUTPUT_FILE=""
+WORKLOAD_DIR=""
+ALGORITHMS="dir24,4stride8,lctrie,wide16,6stride8"
+CPU_CORE=0
+RUNS=3
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+print_usage() {
+    echo "Usage: $0 [OPTIONS]"
+    echo ""
+    echo "Options:"
+    echo "  -B, --build-dir DIR     Default build directory (default: build)"
+    echo "  -P, --pgo-dir DIR       Profile-guided build directory"
+    echo "                          (default: <build-dir>/pgo if present, else build-pgo)"
+    echo "  -o, --output FILE       CSV file (default: benchmarks/data/pgo/<host>.csv)"
+    echo "  -w, --workload DIR      Table and trace directory (default: <build-dir>/pgo_compare_workload)"
+    echo "  -a, --algorithms LIST   Engines for the scaling runs"
+    echo "                          (default: dir24,4stride8,lctrie,wide16,6stride8; none to skip)"
+    echo "  -c, --cpu CPU           Pin to specific CPU core (default: 0)"
+    echo "  --runs N                bench_bindings runs per build (default: 3)"
+    echo "  -h, --help              Show this help"
+}
+
+# Parse arguments
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        -B|--build-dir)
+            BUILD_DIR="$(cd "$2" && pwd)"
+            shift 2
+            ;;
+        -P|--pgo-dir)
+            PGO_DIR="$(cd "$2" && pwd)"
+            shift 2
+            ;;
+        -o|--output)
+            OUTPUT_FILE="$2"
+            shift 2
+            ;;
+        -w|--workload)
+            WORKLOAD_DIR="$2"
+            shift 2
+            ;;
+        -a|--algorithms)
+            ALGORITHMS="$2"
+            shift 2
+            ;;
+        -c|--cpu)
+            CPU_CORE="$2"
+            shift 2
+            ;;
+        --runs)
+            RUNS="$2"
+            shift 2
+            ;;
+        -h|--help)
+            print_usage
+            exit 0
+            ;;
+        *)
+            echo -e "${RED}Error: Unknown option $1${NC}"
+            print_usage
+            exit 1
+            ;;
+    esac
+done
+
+if [[ -z "$PGO_DIR" ]]; then
+    if [[ -d "${BUILD_DIR}/pgo" ]]; then
+        PGO_DIR="${BUILD_DIR}/pgo"
+    else
+        PGO_DIR="${PROJECT_ROOT}/build-pgo"
+    fi
+fi
+OUTPUT_FILE="${OUTPUT_FILE:-${PROJECT_ROOT}/benchmarks/data/pgo/$(hostname).csv}"
+WORKLOAD_DIR="${WORKLOAD_DIR:-${BUILD_DIR}/pgo_compare_workload}"
+TABLE="${WORKLOAD_DIR}/table.txt"
+TRACE="${WORKLOAD_DIR}/trace.txt"
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}  LPM Default vs Profile-Guided Build${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+for dir in "$BUILD_DIR" "$PGO_DIR"; do
+    for bench in bench_bindings bench_algorithm_scaling; do
+        if [[ ! -x "${dir}/benchmarks/${bench}" ]]; then
+            echo -e "${RED}Error: ${dir}/benchmarks/${bench} not found${NC}"
+            echo "Build both first:"
+            echo "  cmake -S . -B build -DCMAKE_BUILD_TYPE=Release -DBUILD_BENCHMARKS=ON && cmake --build build"
+            echo "  ./scripts/build_pgo.sh"
+            exit 1
+        fi
+    done
+done
+if [[ ! -e "${PGO_DIR}/liblpm_pgo.so" ]]; then
+    echo -e "${RED}Error: ${PGO_DIR} is not a profile-guided build (no liblpm_pgo.so)${NC}"
+    exit 1
+fi
+
+if [[ ! -f "$TABLE" || ! -f "$TRACE" ]]; then
+    echo -e "${YELLOW}Generating workload in $WORKLOAD_DIR...${NC}"
+    mkdir -p "$WORKLOAD_DIR"
+    "${BUILD_DIR}/benchmarks/bench_bindings" --generate "$WORKLOAD_DIR"
+fi
+
+PIN=()
+if command -v taskset > /dev/null; then
+    PIN=(taskset -c "$CPU_CORE")
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+echo -e "${BLUE}Configuration:${NC}"
+echo "  Default build: $BUILD_DIR"
+echo "  PGO build: $PGO_DIR"
+echo "  Table: $TABLE ($(grep -vc '^#' "$TABLE") prefixes)"
+echo "  Scaling engines: $ALGORITHMS"
+echo "  CPU core: $CPU_CORE"
+echo ""
+
+# bench_bindings, alternating builds so drift hits both alike
+echo -e "${YELLOW}Running bench_bindings ($RUNS runs per build)...${NC}"
+for run in $(seq 1 "$RUNS"); do
+    for build in default pgo; do
+        dir="$BUILD_DIR"
+        [[ $build == pgo ]] && dir="$PGO_DIR"
+        "${PIN[@]}" "${dir}/benchmarks/bench_bindings" "$TABLE" "$TRACE" | sed "s/^c,/${build},/" >> "${WORK}/bindings.csv"
+    done
+    echo "  run $run/$RUNS: done"
+done
+
+# bench_algorithm_scaling writes <out>/<cpu>_<ip>_<type>/<algo>.csv per build
+if [[ "$ALGORITHMS" != "none" ]]; then
+    IFS=',' read -ra ALGOS <<< "$ALGORITHMS"
+    for algo in "${ALGOS[@]}"; do
+        for build in default pgo; do
+            dir="$BUILD_DIR"
+            [[ $build == pgo ]] && dir="$PGO_DIR"
+            echo -e "${YELLOW}Running bench_algorithm_scaling -a $algo ($build)...${NC}"
+            "${dir}/benchmarks/bench_algorithm_scaling" -q -a "$algo" -c "$CPU_CORE" -o "${WORK}/scaling_${build}" > /dev/null
+        done
+    done
+    (cd "${WORK}/scaling_default" && find . -name '*.csv') | sort | while read -r rel; do
+        [[ -f "${WORK}/scaling_pgo/${rel}" ]] || continue
+        type="$(basename "$(dirname "$rel")")"
+        type="${type##*_}"
+        algo="$(basename "$rel" .csv)"
+        awk -F, -v algo="$algo" -v type="$type" '
+            /^#/ || $1 == "num_prefixes" { next }
+            NR == FNR { base[$1] = $2; next }
+            ($1 in base) && base[$1] > 0 && $2 > 0 {
+                printf "scaling,%s,%s,%s,%.3f,%.3f\n", algo, type, $1, 1e9 / base[$1], 1e9 / $2
+            }' "${WORK}/scaling_default/${rel}" "${WORK}/scaling_pgo/${rel}" >> "${WORK}/scaling.csv"
+    done
+fi
+
+# Best run per build and mode; the checksums of both builds must agree
+mkdir -p "$(dirname "$OUTPUT_FILE")"
+STATUS=0
+awk -F, '
+    {
+        k = $3 "," $4
+        if (!(k in order)) { order[k] = ++n; keys[n] = k }
+        if (!(($1, k) in ns) || $6 < ns[$1, k]) { ns[$1, k] = $6 }
+        sum[$1, k] = $9
+    }
+    END {
+        bad = 0
+        for (i = 1; i <= n; i++) {
+            k = keys[i]
+            printf "bindings,default,%s,%.3f,%.3f\n", k, ns["default", k], ns["pgo", k]
+            if (sum["default", k] != sum["pgo", k]) {
+                printf "  checksum mismatch: %s (default %s, pgo %s)\n", k, sum["default", k], sum["pgo", k] > "/dev/stderr"
+                bad = 1
+            }
+        }
+        exit bad
+    }' "${WORK}/bindings.csv" > "${WORK}/rows.csv" || STATUS=1
+if [[ -f "${WORK}/scaling.csv" ]]; then
+    cat "${WORK}/scaling.csv" >> "${WORK}/rows.csv"
+fi
+awk -F, '
+    BEGIN { print "benchmark,engine,lookup,size,default_ns,pgo_ns,speedup" }
+    { printf "%s,%.2f\n", $0, ($6 > 0 ? $5 / $6 : 0) }' "${WORK}/rows.csv" > "$OUTPUT_FILE"
+
+echo ""
+column -s, -t "$OUTPUT_FILE" 2> /dev/null || cat "$OUTPUT_FILE"
+
+echo ""
+if [[ $STATUS -eq 0 ]]; then
+    echo -e "${GREEN}Results saved to: $OUTPUT_FILE${NC}"
+else
+    echo -e "${RED}Results saved to: $OUTPUT_FILE (checks failed)${NC}"
+fi
+exit $STATUS
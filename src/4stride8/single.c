@@ -11,46 +11,6 @@
 #include "../../include/lpm.h"
 #include "../../include/internal.h"
 
-/* ============================================================================
- * IPv4 Lookup - Unrolled 4 levels with prefetch
- * ============================================================================ */
-
-__attribute__((hot, always_inline))
-static inline uint32_t lookup_ipv4_unrolled(const lpm_node_t * restrict P,
-                                            uint32_t N, const uint8_t *addr)
-{
-    uint32_t R = LPM_INVALID_NEXT_HOP;
-    const struct lpm_entry *e;
-    uint32_t cv;
-    
-    /* Level 0 */
-    e = &P[N].entries[addr[0]]; cv = e->child_and_valid;
-    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
-    N = cv & LPM_CHILD_MASK;
-    if (!N) { return R; }
-    __builtin_prefetch(&P[N].entries[addr[1]], 0, 3);
-    
-    /* Level 1 */
-    e = &P[N].entries[addr[1]]; cv = e->child_and_valid;
-    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
-    N = cv & LPM_CHILD_MASK;
-    if (!N) { return R; }
-    __builtin_prefetch(&P[N].entries[addr[2]], 0, 3);
-    
-    /* Level 2 */
-    e = &P[N].entries[addr[2]]; cv = e->child_and_valid;
-    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R;
-    N = cv & LPM_CHILD_MASK;
-    if (!N) { return R; }
-    __builtin_prefetch(&P[N].entries[addr[3]], 0, 3);
-    
-    /* Level 3 */
-    e = &P[N].entries[addr[3]]; cv = e->child_and_valid;
-    if (cv & LPM_VALID_FLAG) { R = e->next_hop; }
-    
-    return R;
-}
-
 /* ============================================================================
  * SIMD Variants
  * ============================================================================ */
@@ -61,7 +21,7 @@ uint32_t lpm_lookup_ipv4_8stride_scalar(const lpm_trie_t *trie, const uint8_t *a
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -75,7 +35,7 @@ uint32_t lpm_lookup_ipv4_8stride_sse2(const lpm_trie_t *trie, const uint8_t *add
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -89,7 +49,7 @@ uint32_t lpm_lookup_ipv4_8stride_sse42(const lpm_trie_t *trie, const uint8_t *ad
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -103,7 +63,7 @@ uint32_t lpm_lookup_ipv4_8stride_avx(const lpm_trie_t *trie, const uint8_t *addr
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -117,7 +77,7 @@ uint32_t lpm_lookup_ipv4_8stride_avx2(const lpm_trie_t *trie, const uint8_t *add
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -131,7 +91,7 @@ uint32_t lpm_lookup_ipv4_8stride_avx512(const lpm_trie_t *trie, const uint8_t *a
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv4_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv4_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
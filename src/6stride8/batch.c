@@ -277,37 +277,39 @@ void lpm_lookup_batch_ipv6_8stride_avx512(const lpm_trie_t *trie, const uint8_t
  * ifunc Resolver
  * ============================================================================ */
 
-typedef void (*lpm_ipv6_8stride_batch_func_t)(const lpm_trie_t *, const uint8_t **, uint32_t *, size_t);
-
-EXPLICIT_RUNTIME_RESOLVER(lpm_ipv6_8stride_batch_resolver)
+/* Kernel for a SIMD level; also used by the explicit selection API */
+lpm_ipv6_8stride_batch_func_t lpm_ipv6_8stride_batch_kernel(simd_level_t level)
 {
-    simd_level_t level = LPM_DETECT_SIMD();
-    
     switch (level) {
     case SIMD_AVX512F:
-        return (void*)lpm_lookup_batch_ipv6_8stride_avx512;
+        return lpm_lookup_batch_ipv6_8stride_avx512;
     case SIMD_AVX2:
-        return (void*)lpm_lookup_batch_ipv6_8stride_avx2;
+        return lpm_lookup_batch_ipv6_8stride_avx2;
     case SIMD_AVX:
-        return (void*)lpm_lookup_batch_ipv6_8stride_avx;
+        return lpm_lookup_batch_ipv6_8stride_avx;
     case SIMD_SSE4_2:
-        return (void*)lpm_lookup_batch_ipv6_8stride_sse42;
+        return lpm_lookup_batch_ipv6_8stride_sse42;
     case SIMD_SSE2:
-        return (void*)lpm_lookup_batch_ipv6_8stride_sse2;
+        return lpm_lookup_batch_ipv6_8stride_sse2;
     case SIMD_SCALAR:
     default:
-        return (void*)lpm_lookup_batch_ipv6_8stride_scalar;
+        return lpm_lookup_batch_ipv6_8stride_scalar;
     }
 }
 
+EXPLICIT_RUNTIME_RESOLVER(lpm_ipv6_8stride_batch_resolver)
+{
+    return (void*)lpm_ipv6_8stride_batch_kernel(LPM_DETECT_SIMD());
+}
+
 /* Internal ifunc-dispatched batch lookup for pointer array */
 static void lpm_lookup_batch_ipv6_8stride_internal(const lpm_trie_t *trie, const uint8_t **addrs,
                                                     uint32_t *next_hops, size_t count)
     __attribute__((ifunc("lpm_ipv6_8stride_batch_resolver")));
 
-/* Public API for 2D array */
-void lpm_lookup_batch_ipv6_8stride(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
-                                    uint32_t *next_hops, size_t count)
+/* Convert a 2D array for a pointer-array kernel; NULL runs the ifunc-bound one */
+void lpm_lookup_batch_ipv6_8stride_with(lpm_ipv6_8stride_batch_func_t kernel, const lpm_trie_t *trie,
+                                        const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count)
 {
     if (!trie || !addrs || !next_hops || count == 0) { return; }
     
@@ -325,9 +327,20 @@ void lpm_lookup_batch_ipv6_8stride(const lpm_trie_t *trie, const uint8_t (*addrs
         ptrs[i] = addrs[i];
     }
     
-    lpm_lookup_batch_ipv6_8stride_internal(trie, ptrs, next_hops, count);
+    if (kernel) {
+        kernel(trie, ptrs, next_hops, count);
+    } else {
+        lpm_lookup_batch_ipv6_8stride_internal(trie, ptrs, next_hops, count);
+    }
     
     if (count > 256) {
         free((void *)ptrs);
     }
 }
+
+/* Public API for 2D array */
+void lpm_lookup_batch_ipv6_8stride(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                    uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv6_8stride_with(NULL, trie, addrs, next_hops, count);
+}
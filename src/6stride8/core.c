@@ -52,6 +52,7 @@ lpm_trie_t *lpm_create_ipv6_8stride(void)
         memset(t->hot_cache, 0, cache_size);
     }
     
+    lpm_dispatch_init(t);
     return t;
 }
 
@@ -59,7 +60,7 @@ lpm_trie_t *lpm_create_ipv6_8stride(void)
  * Add Prefix
  * ============================================================================ */
 
-int lpm_add_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+static int add_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
 {
     if (!trie || !prefix || prefix_len > LPM_IPV6_MAX_DEPTH) { return -1; }
     
@@ -129,11 +130,20 @@ int lpm_add_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix
     return 0;
 }
 
+int lpm_add_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    int rc = add_ipv6_8stride(trie, prefix, prefix_len, next_hop);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
+
 /* ============================================================================
  * Delete Prefix
  * ============================================================================ */
 
-int lpm_delete_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+static int delete_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
 {
     if (!trie || !prefix || prefix_len > LPM_IPV6_MAX_DEPTH) { return -1; }
     
@@ -190,3 +200,12 @@ int lpm_delete_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t pre
     if (trie->num_prefixes > 0) { trie->num_prefixes--; }
     return 0;
 }
+
+int lpm_delete_ipv6_8stride(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    int rc = delete_ipv6_8stride(trie, prefix, prefix_len);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
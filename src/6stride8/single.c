@@ -11,38 +11,6 @@
 #include "../../include/lpm.h"
 #include "../../include/internal.h"
 
-/* ============================================================================
- * IPv6 Lookup - Unrolled 16 levels, branchless
- * ============================================================================ */
-
-__attribute__((hot, always_inline))
-static inline uint32_t lookup_ipv6_unrolled(const lpm_node_t * restrict P,
-                                            uint32_t N, const uint8_t *addr)
-{
-    uint32_t R = LPM_INVALID_NEXT_HOP;
-    
-#define S(i) do { \
-    const struct lpm_entry *e = &P[N].entries[addr[i]]; \
-    uint32_t cv = e->child_and_valid; \
-    R = (cv & LPM_VALID_FLAG) ? e->next_hop : R; \
-    N = cv & LPM_CHILD_MASK; \
-    if (!N) { return R; } \
-} while(0)
-    
-    S(0); S(1); S(2); S(3);
-    S(4); S(5); S(6); S(7);
-    S(8); S(9); S(10); S(11);
-    S(12); S(13); S(14);
-    
-    /* Last byte */
-    const struct lpm_entry *e = &P[N].entries[addr[15]];
-    uint32_t cv = e->child_and_valid;
-    if (cv & LPM_VALID_FLAG) { R = e->next_hop; }
-    
-#undef S
-    return R;
-}
-
 /* ============================================================================
  * SIMD Variants
  * ============================================================================ */
@@ -53,7 +21,7 @@ uint32_t lpm_lookup_ipv6_8stride_scalar(const lpm_trie_t *trie, const uint8_t *a
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -67,7 +35,7 @@ uint32_t lpm_lookup_ipv6_8stride_sse2(const lpm_trie_t *trie, const uint8_t *add
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -81,7 +49,7 @@ uint32_t lpm_lookup_ipv6_8stride_sse42(const lpm_trie_t *trie, const uint8_t *ad
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -95,7 +63,7 @@ uint32_t lpm_lookup_ipv6_8stride_avx(const lpm_trie_t *trie, const uint8_t *addr
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -109,7 +77,7 @@ uint32_t lpm_lookup_ipv6_8stride_avx2(const lpm_trie_t *trie, const uint8_t *add
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
@@ -123,7 +91,7 @@ uint32_t lpm_lookup_ipv6_8stride_avx512(const lpm_trie_t *trie, const uint8_t *a
     const lpm_node_t * restrict P = trie->node_pool;
     uint32_t N = trie->root_idx;
     
-    uint32_t R = lookup_ipv6_unrolled(P, N, addr);
+    uint32_t R = lpm_ipv6_8stride_lookup_inline(P, N, addr);
     
     if (R != LPM_INVALID_NEXT_HOP) {
         return R;
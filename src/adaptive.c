@@ -0,0 +1,606 @@
+/*
+ * liblpm Adaptive Tables
+ *
+ * An adaptive trie is a shell around one engine trie that it swaps for
+ * another as the table grows or shrinks: IPv4 moves small table -> 8-bit
+ * stride -> DIR-24-8, IPv6 8-bit stride -> wide 16-bit stride, and back
+ * down once the prefix count falls below half a threshold. A stride table
+ * that serves enough batch lookups moves up early and stays there.
+ *
+ * The shell's rule store is the route table. A migration snapshots it
+ * (shortest prefixes first) and builds the next engine on a worker thread
+ * while updates keep going to the current engine and into a log. The next
+ * update or lpm_adaptive_poll() after the worker is done replays the logged
+ * prefixes on the new engine and publishes it: lookups load one view
+ * pointer (engine plus lookup functions) with acquire semantics, so every
+ * lookup runs entirely on the old or entirely on the new engine. The
+ * retired engine is freed by lpm_adaptive_reclaim() or at the next
+ * switch-over, whichever comes first.
+ *
+ * The stride engines expand a prefix over its node without remembering
+ * which entries belong to longer prefixes of the same node. Updates here
+ * therefore re-install, from the rule store, the prefixes of that node
+ * that the write clobbered: more-specifics inside the prefix and, on
+ * delete, a covering prefix of the same node.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_ADAPT_SMALL_MAX   1024
+#define LPM_ADAPT_STRIDE_MAX  65536
+#define LPM_ADAPT_HOT_LOOKUPS (1ULL << 26)
+
+enum adapt_tier {
+    ADAPT_SMALL = 0,          /* IPv4 only */
+    ADAPT_STRIDE = 1,
+    ADAPT_TOP = 2,            /* DIR-24-8 or wide16 */
+};
+
+/* A route copied out of the rule store */
+struct adapt_route {
+    uint8_t prefix[16];
+    uint8_t len;
+    uint32_t next_hop;
+};
+
+/* Prefix touched while a migration was running */
+struct adapt_log_entry {
+    uint8_t prefix[16];
+    uint8_t len;
+};
+
+struct adapt_job {
+    lpm_trie_t *engine;       /* Built by the worker */
+    enum adapt_tier target;
+    uint8_t max_depth;
+    struct adapt_route *routes;
+    size_t count;
+    bool done;                /* Set (release) by the worker */
+    bool failed;
+};
+
+struct lpm_adapt {
+    struct lpm_adapt_head head;          /* Read by lookups; must stay first */
+    struct lpm_adapt_view views[2];
+    lpm_adaptive_config_t config;
+    enum adapt_tier tier;
+    bool sticky;                         /* Moved up for traffic: no demotion */
+    lpm_trie_t *retired;
+    uint32_t migrations;
+
+    /* Migration in flight */
+    bool migrating;
+    bool threaded;
+    pthread_t worker;
+    struct adapt_job job;
+    struct adapt_log_entry *log;
+    size_t log_count;
+    size_t log_capacity;
+
+    /* Backoff after a failed migration */
+    enum adapt_tier failed_target;
+    uint64_t failed_count;               /* 0 = none */
+
+    /* Scratch for re-installing clobbered prefixes */
+    struct adapt_route *scratch;
+    size_t scratch_count;
+    size_t scratch_capacity;
+    bool scratch_failed;
+};
+
+static const char *const adapt_names[2][3] = {
+    { "small", "stride8", "dir24" },
+    { "small", "stride8", "wide16" },
+};
+
+/* ============================================================================
+ * Engines
+ * ============================================================================ */
+
+static lpm_trie_t *tier_create(uint8_t max_depth, enum adapt_tier tier)
+{
+    if (max_depth == LPM_IPV4_MAX_DEPTH) {
+        switch (tier) {
+        case ADAPT_SMALL:  return lpm_create_ipv4_small();
+        case ADAPT_STRIDE: return lpm_create_ipv4_8stride();
+        case ADAPT_TOP:    return lpm_create_ipv4_dir24();
+        }
+        return NULL;
+    }
+    return tier == ADAPT_TOP ? lpm_create_ipv6_wide16() : lpm_create_ipv6_8stride();
+}
+
+/* The ifunc entry points are called, not stored: taking their address from a
+ * data relocation would run the resolver before the library is relocated */
+static void batch_ipv4_small(const lpm_trie_t *trie, const uint32_t *addrs,
+                             uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_small(trie, addrs, next_hops, count);
+}
+
+static void batch_ipv4_dir24(const lpm_trie_t *trie, const uint32_t *addrs,
+                             uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_dir24(trie, addrs, next_hops, count);
+}
+
+static void view_fill(struct lpm_adapt_view *v, lpm_trie_t *engine, uint8_t max_depth,
+                      enum adapt_tier tier)
+{
+    /* The other family keeps the stride functions, as for any engine */
+    v->engine = engine;
+    v->lookup_ipv4 = lpm_lookup_ipv4_8stride;
+    v->batch_ipv4 = lpm_lookup_batch_ipv4_8stride;
+    v->lookup_ipv6 = lpm_lookup_ipv6_8stride;
+    v->batch_ipv6 = lpm_lookup_batch_ipv6_8stride;
+
+    if (max_depth == LPM_IPV4_MAX_DEPTH) {
+        if (tier == ADAPT_SMALL) {
+            v->lookup_ipv4 = lpm_lookup_ipv4_small;
+            v->batch_ipv4 = batch_ipv4_small;
+        } else if (tier == ADAPT_TOP) {
+            v->lookup_ipv4 = lpm_lookup_ipv4_dir24;
+            v->batch_ipv4 = batch_ipv4_dir24;
+        }
+    } else if (tier == ADAPT_TOP) {
+        v->lookup_ipv6 = lpm_lookup_ipv6_wide16;
+        v->batch_ipv6 = lpm_lookup_batch_ipv6_wide16;
+    }
+}
+
+/* Bits [base, end) of the stride node a prefix of length len >= 1 is
+ * expanded in; wide16 starts with one 16-bit level */
+static void stride_node(uint8_t max_depth, enum adapt_tier tier, uint8_t len,
+                        uint8_t *base, uint8_t *end)
+{
+    if (max_depth == LPM_IPV6_MAX_DEPTH && tier == ADAPT_TOP && len <= 16) {
+        *base = 0;
+        *end = 16;
+        return;
+    }
+    uint8_t skip = (max_depth == LPM_IPV6_MAX_DEPTH && tier == ADAPT_TOP) ? 16 : 0;
+    *base = (uint8_t)(skip + 8 * ((len - skip - 1) / 8));
+    *end = (uint8_t)(*base + 8);
+}
+
+static bool tier_exact(uint8_t max_depth, enum adapt_tier tier)
+{
+    /* The small table and DIR-24-8 keep covering prefixes themselves */
+    return tier == ADAPT_SMALL || (tier == ADAPT_TOP && max_depth == LPM_IPV4_MAX_DEPTH);
+}
+
+static void scratch_push(const struct lpm_rule *r, void *ctx)
+{
+    struct lpm_adapt *a = ctx;
+    if (a->scratch_count == a->scratch_capacity) {
+        size_t cap = a->scratch_capacity ? a->scratch_capacity * 2 : 64;
+        struct adapt_route *s = realloc(a->scratch, cap * sizeof(*s));
+        if (!s) {
+            a->scratch_failed = true;
+            return;
+        }
+        a->scratch = s;
+        a->scratch_capacity = cap;
+    }
+    struct adapt_route *d = &a->scratch[a->scratch_count++];
+    memcpy(d->prefix, r->prefix, sizeof(d->prefix));
+    d->len = r->len;
+    d->next_hop = r->next_hop;
+}
+
+static int route_by_len(const void *x, const void *y)
+{
+    const struct adapt_route *a = x, *b = y;
+    return (int)a->len - (int)b->len;
+}
+
+/* Re-install the rules inside prefix/len that live in the same stride node,
+ * shortest first so each overwrites only what it covers */
+static int stride_restore(const lpm_trie_t *trie, lpm_trie_t *engine, enum adapt_tier tier,
+                          const uint8_t *prefix, uint8_t len)
+{
+    struct lpm_adapt *a = trie->adapt;
+    uint8_t base, end;
+    stride_node(trie->max_depth, tier, len, &base, &end);
+
+    a->scratch_count = 0;
+    a->scratch_failed = false;
+    lpm_rules_for_each_within(trie->rules, prefix, len, end, scratch_push, a);
+    if (a->scratch_failed) { return -1; }
+    if (a->scratch_count == 0) { return 0; }
+    qsort(a->scratch, a->scratch_count, sizeof(*a->scratch), route_by_len);
+    for (size_t i = 0; i < a->scratch_count; i++) {
+        const struct adapt_route *r = &a->scratch[i];
+        if (lpm_add(engine, r->prefix, r->len, r->next_hop) != 0) { return -1; }
+    }
+    return 0;
+}
+
+/* Make the engine agree with the rule store for prefix/len */
+static int engine_sync(const lpm_trie_t *trie, lpm_trie_t *engine, enum adapt_tier tier,
+                       const uint8_t *prefix, uint8_t len)
+{
+    const struct lpm_rule *r = lpm_rules_find(trie->rules, prefix, len);
+
+    if (tier_exact(trie->max_depth, tier) || len == 0) {
+        if (r) {
+            return lpm_add(engine, prefix, len, r->next_hop);
+        }
+        lpm_delete(engine, prefix, len);   /* May not be installed */
+        return 0;
+    }
+
+    if (r) {
+        if (lpm_add(engine, prefix, len, r->next_hop) != 0) { return -1; }
+        return stride_restore(trie, engine, tier, prefix, len);
+    }
+
+    lpm_delete(engine, prefix, len);
+    const struct lpm_rule *q = lpm_rules_find_parent(trie->rules, prefix, len);
+    uint8_t base, end, q_base = 0;
+    stride_node(trie->max_depth, tier, len, &base, &end);
+    if (q) {
+        stride_node(trie->max_depth, tier, q->len, &q_base, &end);
+    }
+    if (q && q_base == base) {
+        /* The delete cleared part of a covering prefix of the same node */
+        uint8_t qp[16];
+        uint8_t ql = q->len;
+        memcpy(qp, q->prefix, sizeof(qp));
+        if (lpm_add(engine, qp, ql, q->next_hop) != 0) { return -1; }
+        return stride_restore(trie, engine, tier, qp, ql);
+    }
+    return stride_restore(trie, engine, tier, prefix, len);
+}
+
+/* ============================================================================
+ * Migration
+ * ============================================================================ */
+
+static void *adapt_worker(void *arg)
+{
+    struct adapt_job *job = arg;
+    bool failed = false;
+
+    job->engine = tier_create(job->max_depth, job->target);
+    if (!job->engine) {
+        failed = true;
+    }
+    for (size_t i = 0; !failed && i < job->count; i++) {
+        const struct adapt_route *r = &job->routes[i];
+        failed = lpm_add(job->engine, r->prefix, r->len, r->next_hop) != 0;
+    }
+    job->failed = failed;
+    __atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void adapt_publish(lpm_trie_t *trie, lpm_trie_t *engine, enum adapt_tier tier)
+{
+    struct lpm_adapt *a = trie->adapt;
+    const struct lpm_adapt_view *cur = a->head.active;
+    struct lpm_adapt_view *next = (cur == &a->views[0]) ? &a->views[1] : &a->views[0];
+
+    /* Readers of the view before last are long gone: reuse its slot */
+    lpm_destroy(a->retired);
+    a->retired = cur ? cur->engine : NULL;
+
+    view_fill(next, engine, trie->max_depth, tier);
+    __atomic_store_n(&a->head.lookups, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->head.count_lookups,
+                     tier == ADAPT_STRIDE && a->config.hot_lookups != 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->head.active, next, __ATOMIC_RELEASE);
+    a->tier = tier;
+}
+
+static int log_push(struct lpm_adapt *a, const uint8_t *prefix, uint8_t len)
+{
+    if (a->log_count == a->log_capacity) {
+        size_t cap = a->log_capacity ? a->log_capacity * 2 : 64;
+        struct adapt_log_entry *l = realloc(a->log, cap * sizeof(*l));
+        if (!l) { return -1; }
+        a->log = l;
+        a->log_capacity = cap;
+    }
+    struct adapt_log_entry *e = &a->log[a->log_count++];
+    memset(e->prefix, 0, sizeof(e->prefix));
+    memcpy(e->prefix, prefix, (len + 7) / 8);
+    e->len = len;
+    return 0;
+}
+
+/* Land a migration whose worker is done (or wait for it when block) */
+static void adapt_finish(lpm_trie_t *trie, bool block)
+{
+    struct lpm_adapt *a = trie->adapt;
+    if (!a->migrating) { return; }
+    if (!block && !__atomic_load_n(&a->job.done, __ATOMIC_ACQUIRE)) { return; }
+    if (a->threaded) {
+        pthread_join(a->worker, NULL);
+    }
+
+    struct adapt_job *job = &a->job;
+    bool ok = !job->failed;
+    for (size_t i = 0; ok && i < a->log_count; i++) {
+        ok = engine_sync(trie, job->engine, job->target, a->log[i].prefix, a->log[i].len) == 0;
+    }
+    if (ok) {
+        adapt_publish(trie, job->engine, job->target);
+        a->migrations++;
+        a->failed_count = 0;
+    } else {
+        lpm_destroy(job->engine);
+        a->failed_target = job->target;
+        a->failed_count = trie->num_prefixes ? trie->num_prefixes : 1;
+    }
+
+    free(job->routes);
+    memset(job, 0, sizeof(*job));
+    a->log_count = 0;
+    a->migrating = false;
+}
+
+static void adapt_start(lpm_trie_t *trie, enum adapt_tier target)
+{
+    struct lpm_adapt *a = trie->adapt;
+    struct adapt_job *job = &a->job;
+    const struct lpm_rule_table *rt = trie->rules;
+
+    memset(job, 0, sizeof(*job));
+    job->target = target;
+    job->max_depth = trie->max_depth;
+    job->routes = malloc((rt->count ? rt->count : 1) * sizeof(*job->routes));
+    if (!job->routes) { return; }
+    for (uint32_t i = 0; i < rt->capacity; i++) {
+        const struct lpm_rule *r = &rt->slots[i];
+        if (r->used) {
+            struct adapt_route *d = &job->routes[job->count++];
+            memcpy(d->prefix, r->prefix, sizeof(d->prefix));
+            d->len = r->len;
+            d->next_hop = r->next_hop;
+        }
+    }
+    /* Shortest first: a stride build then never clobbers a longer prefix */
+    qsort(job->routes, job->count, sizeof(*job->routes), route_by_len);
+
+    a->migrating = true;
+    a->log_count = 0;
+    a->threaded = pthread_create(&a->worker, NULL, adapt_worker, job) == 0;
+    if (!a->threaded) {
+        adapt_worker(job);
+        adapt_finish(trie, true);
+    }
+}
+
+static enum adapt_tier tier_for(const lpm_trie_t *trie, uint64_t n, uint32_t small_max,
+                                uint32_t stride_max)
+{
+    if (n > stride_max) { return ADAPT_TOP; }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH && n <= small_max) { return ADAPT_SMALL; }
+    return ADAPT_STRIDE;
+}
+
+/* Start a migration if the table crossed a threshold */
+static void adapt_check(lpm_trie_t *trie)
+{
+    struct lpm_adapt *a = trie->adapt;
+    if (a->migrating) { return; }
+
+    const lpm_adaptive_config_t *c = &a->config;
+    uint64_t n = trie->num_prefixes;
+    enum adapt_tier target = a->tier;
+    enum adapt_tier up = tier_for(trie, n, c->small_max, c->stride_max);
+    enum adapt_tier down = tier_for(trie, n, c->small_max / 2, c->stride_max / 2);
+
+    if (up > a->tier) {
+        target = up;
+    } else if (down < a->tier && !a->sticky) {
+        target = down;
+    } else if (a->tier == ADAPT_STRIDE && c->hot_lookups &&
+               __atomic_load_n(&a->head.lookups, __ATOMIC_RELAXED) >= c->hot_lookups) {
+        target = ADAPT_TOP;
+        a->sticky = true;
+    }
+    if (target == a->tier) { return; }
+
+    /* Retry a failed migration only after the table doubled or halved */
+    if (a->failed_count && target == a->failed_target &&
+        n < 2 * a->failed_count && 2 * n > a->failed_count) {
+        return;
+    }
+    adapt_start(trie, target);
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+static int adapt_update(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    struct lpm_adapt *a = trie->adapt;
+    lpm_trie_t *engine = a->head.active->engine;
+
+    if (engine_sync(trie, engine, a->tier, prefix, prefix_len) != 0) {
+        if (!a->migrating) { return -1; }
+        /* The current engine is full; the one being built is not */
+        adapt_finish(trie, true);
+        if (a->migrating || engine == a->head.active->engine) { return -1; }
+        if (engine_sync(trie, a->head.active->engine, a->tier, prefix, prefix_len) != 0) {
+            return -1;
+        }
+    }
+    if (a->migrating && log_push(a, prefix, prefix_len) < 0) {
+        /* Without the log entry the new engine would miss this update */
+        adapt_finish(trie, true);
+        return engine_sync(trie, a->head.active->engine, a->tier, prefix, prefix_len);
+    }
+    return 0;
+}
+
+int lpm_adapt_add(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    if (next_hop == LPM_INVALID_NEXT_HOP ||
+        (trie->max_depth == LPM_IPV4_MAX_DEPTH && next_hop > LPM_DIR24_NH_MASK)) {
+        return -1;
+    }
+    adapt_finish(trie, false);
+
+    const struct lpm_rule *old = lpm_rules_find(trie->rules, prefix, prefix_len);
+    uint32_t old_nh = old ? old->next_hop : LPM_INVALID_NEXT_HOP;
+    bool existed;
+    if (lpm_rules_insert(trie->rules, prefix, prefix_len, next_hop, &existed) < 0) { return -1; }
+
+    if (adapt_update(trie, prefix, prefix_len) != 0) {
+        /* Put the rule store back and resync what the engine may have taken */
+        if (existed) {
+            lpm_rules_insert(trie->rules, prefix, prefix_len, old_nh, NULL);
+        } else {
+            lpm_rules_remove(trie->rules, prefix, prefix_len);
+        }
+        engine_sync(trie, trie->adapt->head.active->engine, trie->adapt->tier, prefix, prefix_len);
+        return -1;
+    }
+    if (!existed) {
+        trie->num_prefixes++;
+    }
+    adapt_check(trie);
+    return 0;
+}
+
+int lpm_adapt_delete(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    adapt_finish(trie, false);
+
+    const struct lpm_rule *old = lpm_rules_find(trie->rules, prefix, prefix_len);
+    if (!old) { return -1; }
+    uint32_t old_nh = old->next_hop;
+    lpm_rules_remove(trie->rules, prefix, prefix_len);
+
+    if (adapt_update(trie, prefix, prefix_len) != 0) {
+        lpm_rules_insert(trie->rules, prefix, prefix_len, old_nh, NULL);
+        engine_sync(trie, trie->adapt->head.active->engine, trie->adapt->tier, prefix, prefix_len);
+        return -1;
+    }
+    trie->num_prefixes--;
+    adapt_check(trie);
+    return 0;
+}
+
+int lpm_adapt_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH && new_nh > LPM_DIR24_NH_MASK) { return -1; }
+
+    /* Repoint the settled engine and the route table together */
+    adapt_finish(trie, true);
+    for (uint32_t i = 0; i < trie->rules->capacity; i++) {
+        struct lpm_rule *r = &trie->rules->slots[i];
+        if (r->used && r->next_hop == old_nh) {
+            r->next_hop = new_nh;
+        }
+    }
+    return lpm_replace_next_hop(trie->adapt->head.active->engine, old_nh, new_nh);
+}
+
+void lpm_adapt_destroy(struct lpm_adapt *a)
+{
+    if (!a) { return; }
+    if (a->migrating) {
+        if (a->threaded) {
+            pthread_join(a->worker, NULL);
+        }
+        lpm_destroy(a->job.engine);
+        free(a->job.routes);
+    }
+    if (a->head.active) {
+        lpm_destroy(a->head.active->engine);
+    }
+    lpm_destroy(a->retired);
+    free(a->log);
+    free(a->scratch);
+    free(a);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+lpm_trie_t *lpm_create_adaptive(uint8_t max_depth, const lpm_adaptive_config_t *config)
+{
+    if (max_depth != LPM_IPV4_MAX_DEPTH && max_depth != LPM_IPV6_MAX_DEPTH) { return NULL; }
+
+    lpm_adaptive_config_t c = {
+        .small_max = LPM_ADAPT_SMALL_MAX,
+        .stride_max = LPM_ADAPT_STRIDE_MAX,
+        .hot_lookups = LPM_ADAPT_HOT_LOOKUPS,
+    };
+    if (config) {
+        c = *config;
+    }
+    /* The small table needs headroom for updates made during a migration */
+    if (c.small_max >= LPM_SMALL_MAX_PREFIXES / 2 || c.stride_max <= c.small_max) {
+        return NULL;
+    }
+
+    lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
+    if (!t) { return NULL; }
+    memset(t, 0, sizeof(lpm_trie_t));
+
+    t->max_depth = max_depth;
+    t->default_next_hop = LPM_INVALID_NEXT_HOP;
+    t->rules = lpm_rules_create();
+    t->adapt = calloc(1, sizeof(struct lpm_adapt));
+    if (!t->rules || !t->adapt) {
+        lpm_destroy(t);
+        return NULL;
+    }
+
+    struct lpm_adapt *a = t->adapt;
+    a->config = c;
+    enum adapt_tier tier = max_depth == LPM_IPV4_MAX_DEPTH ? ADAPT_SMALL : ADAPT_STRIDE;
+    lpm_trie_t *engine = tier_create(max_depth, tier);
+    if (!engine) {
+        lpm_destroy(t);
+        return NULL;
+    }
+    adapt_publish(t, engine, tier);
+    lpm_dispatch_init(t);
+    return t;
+}
+
+int lpm_adaptive_poll(lpm_trie_t *trie)
+{
+    if (!trie || !trie->adapt) { return -1; }
+    adapt_finish(trie, false);
+    adapt_check(trie);
+    return trie->adapt->migrating ? 1 : 0;
+}
+
+int lpm_adaptive_wait(lpm_trie_t *trie)
+{
+    if (!trie || !trie->adapt) { return -1; }
+    adapt_finish(trie, true);
+    return 0;
+}
+
+void lpm_adaptive_reclaim(lpm_trie_t *trie)
+{
+    if (!trie || !trie->adapt) { return; }
+    lpm_destroy(trie->adapt->retired);
+    trie->adapt->retired = NULL;
+}
+
+const char *lpm_adaptive_engine(const lpm_trie_t *trie)
+{
+    if (!trie || !trie->adapt) { return NULL; }
+    return adapt_names[trie->max_depth == LPM_IPV6_MAX_DEPTH][trie->adapt->tier];
+}
+
+uint32_t lpm_adaptive_migrations(const lpm_trie_t *trie)
+{
+    return trie && trie->adapt ? trie->adapt->migrations : 0;
+}
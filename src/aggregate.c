@@ -0,0 +1,759 @@
+/*
+ * liblpm FIB Aggregation
+ *
+ * Optimal Routing Table Constructor (ORTC, Draves et al.): replaces a route
+ * set with the smallest prefix set that forwards every address the same way.
+ * Routes are kept in a binary trie; a node with one child behaves as if the
+ * missing child were a leaf carrying the inherited route (a "ghost" leaf).
+ *
+ *   Pass 2, bottom-up: a leaf's candidate set S is {route it falls under};
+ *   an inner node takes S = A & B if that is non-empty, else A | B.
+ *   Pass 3, top-down: a node gets no prefix if the value it inherits from
+ *   the prefixes above is in S, otherwise one prefix with a value from S.
+ *
+ * Engines cannot hold "no route" entries, so a subtree that contains
+ * unrouted space gets S = {none} and never a prefix; its routed parts are
+ * solved on their own. The result is still minimal under that constraint.
+ *
+ * Incremental mode (lpm_enable_aggregation) keeps the routes in the trie and
+ * the installed prefixes in the engine. An update recomputes S for the
+ * changed node's subtree and its ancestors, then pass 3 walks down from the
+ * root, skipping subtrees whose candidate sets and inherited value did not
+ * change, and pushes only the prefixes that differ to the engine.
+ *
+ * The 8-bit stride and wide16 engines expand a prefix over its node without
+ * remembering lengths, so an add overwrites the more specific prefixes of
+ * the same node and a delete clears them. On those engines each change is
+ * followed by re-installing, shortest first, the installed prefixes it may
+ * have hidden, as the adaptive tables do with their rule store.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define AGG_NONE     LPM_INVALID_NEXT_HOP
+#define AGG_UNSEEN   0xFFFFFFFEU     /* inh before the first pass 3 */
+
+struct agg_node {
+    uint32_t child[2];       /* 0 = none (the root is never a child) */
+    uint32_t route;          /* Route at this prefix, AGG_NONE if none */
+    uint32_t fib;            /* Prefix installed here, AGG_NONE if none */
+    uint32_t ghost_fib;      /* Installed for the ghost leaf, AGG_NONE if none */
+    uint32_t inh;            /* Inherited value seen by the last pass 3 */
+    union {
+        uint32_t one;
+        uint32_t *many;
+    } set;                   /* S, sorted */
+    uint16_t set_len;
+    uint8_t ghost_side;
+    uint8_t dirty;
+};
+
+struct lpm_agg {
+    struct agg_node *nodes;  /* nodes[0] is the root */
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t free_head;      /* Linked through child[0] */
+    uint64_t routes;
+    uint8_t max_depth;
+    uint32_t *scratch;
+    size_t scratch_cap;
+};
+
+/* An installed prefix, or a change to one (next_hop AGG_NONE: removal) */
+struct agg_route {
+    uint8_t prefix[16];
+    uint32_t next_hop;
+    uint8_t len;
+};
+
+struct agg_routes {
+    struct agg_route *v;
+    size_t count;
+    size_t capacity;
+};
+
+/* Where pass 3 sends prefix changes: the trie's engine or an output array */
+struct agg_sink {
+    lpm_trie_t *trie;
+    uint8_t (*prefixes)[16];
+    uint8_t *prefix_lens;
+    uint32_t *next_hops;
+    size_t count;
+    size_t capacity;
+    int err;
+    bool stride;               /* Engine changes are queued for sink_finish() */
+    struct agg_routes pending;
+    struct agg_routes restore;
+};
+
+/* ============================================================================
+ * Nodes and Candidate Sets
+ * ============================================================================ */
+
+static const uint32_t *set_elems(const struct agg_node *n)
+{
+    return n->set_len > 1 ? n->set.many : &n->set.one;
+}
+
+static bool set_has(const struct agg_node *n, uint32_t v)
+{
+    const uint32_t *s = set_elems(n);
+    for (uint16_t i = 0; i < n->set_len; i++) {
+        if (s[i] == v) { return true; }
+    }
+    return false;
+}
+
+static int set_assign(struct agg_node *n, const uint32_t *v, size_t len)
+{
+    uint32_t *many = NULL;
+    if (len > 1) {
+        many = malloc(len * sizeof(uint32_t));
+        if (!many) { return -1; }
+        memcpy(many, v, len * sizeof(uint32_t));
+    }
+    if (n->set_len > 1) {
+        free(n->set.many);
+    }
+    if (len > 1) {
+        n->set.many = many;
+    } else {
+        n->set.one = v[0];
+    }
+    n->set_len = (uint16_t)len;
+    return 0;
+}
+
+static uint32_t agg_node_alloc(struct lpm_agg *a)
+{
+    uint32_t idx;
+    if (a->free_head) {
+        idx = a->free_head;
+        a->free_head = a->nodes[idx].child[0];
+    } else {
+        if (a->used == a->capacity) {
+            struct agg_node *nodes = realloc(a->nodes, (size_t)a->capacity * 2 * sizeof(*nodes));
+            if (!nodes) { return 0; }
+            a->nodes = nodes;
+            a->capacity *= 2;
+        }
+        idx = a->used++;
+    }
+
+    struct agg_node *n = &a->nodes[idx];
+    memset(n, 0, sizeof(*n));
+    n->route = n->fib = n->ghost_fib = AGG_NONE;
+    n->inh = AGG_UNSEEN;
+    n->set.one = AGG_NONE;
+    n->set_len = 1;
+    n->dirty = 1;
+    return idx;
+}
+
+static void agg_node_free(struct lpm_agg *a, uint32_t idx)
+{
+    struct agg_node *n = &a->nodes[idx];
+    if (n->set_len > 1) {
+        free(n->set.many);
+    }
+    n->set_len = 0;
+    n->child[0] = a->free_head;
+    a->free_head = idx;
+}
+
+static struct lpm_agg *agg_create(uint8_t max_depth)
+{
+    struct lpm_agg *a = calloc(1, sizeof(*a));
+    if (!a) { return NULL; }
+    a->max_depth = max_depth;
+    a->capacity = 1024;
+    a->nodes = malloc((size_t)a->capacity * sizeof(*a->nodes));
+    if (!a->nodes) {
+        free(a);
+        return NULL;
+    }
+    agg_node_alloc(a);   /* Root */
+    return a;
+}
+
+void lpm_agg_destroy(struct lpm_agg *a)
+{
+    if (!a) { return; }
+    for (uint32_t i = 0; i < a->used; i++) {
+        if (a->nodes[i].set_len > 1) {
+            free(a->nodes[i].set.many);
+        }
+    }
+    free(a->nodes);
+    free(a->scratch);
+    free(a);
+}
+
+static inline int prefix_bit(const uint8_t *prefix, unsigned depth)
+{
+    return (prefix[depth / 8] >> (7 - depth % 8)) & 1;
+}
+
+static int routes_push(struct agg_routes *r, const uint8_t *prefix, uint8_t len, uint32_t next_hop)
+{
+    if (r->count == r->capacity) {
+        size_t cap = r->capacity ? r->capacity * 2 : 64;
+        struct agg_route *v = realloc(r->v, cap * sizeof(*v));
+        if (!v) { return -1; }
+        r->v = v;
+        r->capacity = cap;
+    }
+    struct agg_route *d = &r->v[r->count++];
+    memset(d->prefix, 0, sizeof(d->prefix));
+    memcpy(d->prefix, prefix, (len + 7) / 8);
+    if (len % 8) {
+        d->prefix[len / 8] &= (uint8_t)(0xFF << (8 - len % 8));
+    }
+    d->len = len;
+    d->next_hop = next_hop;
+    return 0;
+}
+
+/* ============================================================================
+ * Pass 2: Candidate Sets
+ * ============================================================================ */
+
+/* S of node idx from its children; rinh is the route inherited from above */
+static int agg_compute(struct lpm_agg *a, uint32_t idx, uint32_t rinh)
+{
+    struct agg_node *n = &a->nodes[idx];
+    uint32_t r = n->route != AGG_NONE ? n->route : rinh;
+    n->dirty = 1;
+
+    if (!n->child[0] && !n->child[1]) {
+        return set_assign(n, &r, 1);
+    }
+
+    /* A missing child is a ghost leaf with S = {r} */
+    const uint32_t *s[2];
+    size_t len[2];
+    for (int b = 0; b < 2; b++) {
+        if (n->child[b]) {
+            s[b] = set_elems(&a->nodes[n->child[b]]);
+            len[b] = a->nodes[n->child[b]].set_len;
+        } else {
+            s[b] = &r;
+            len[b] = 1;
+        }
+    }
+
+    /* Unrouted space below: no prefix may cover this node */
+    if (s[0][len[0] - 1] == AGG_NONE || s[1][len[1] - 1] == AGG_NONE) {
+        uint32_t none = AGG_NONE;
+        return set_assign(n, &none, 1);
+    }
+
+    if (a->scratch_cap < len[0] + len[1]) {
+        uint32_t *scratch = realloc(a->scratch, (len[0] + len[1]) * sizeof(uint32_t));
+        if (!scratch) { return -1; }
+        a->scratch = scratch;
+        a->scratch_cap = len[0] + len[1];
+    }
+
+    /* Sorted intersection, else sorted union */
+    size_t i = 0, j = 0, k = 0;
+    while (i < len[0] && j < len[1]) {
+        if (s[0][i] < s[1][j]) {
+            i++;
+        } else if (s[0][i] > s[1][j]) {
+            j++;
+        } else {
+            a->scratch[k++] = s[0][i];
+            i++;
+            j++;
+        }
+    }
+    if (k == 0) {
+        i = j = 0;
+        while (i < len[0] || j < len[1]) {
+            if (j == len[1] || (i < len[0] && s[0][i] < s[1][j])) {
+                a->scratch[k++] = s[0][i++];
+            } else if (i == len[0] || s[1][j] < s[0][i]) {
+                a->scratch[k++] = s[1][j++];
+            } else {
+                a->scratch[k++] = s[0][i];
+                i++;
+                j++;
+            }
+        }
+    }
+    return set_assign(&a->nodes[idx], a->scratch, k);
+}
+
+static int agg_compute_subtree(struct lpm_agg *a, uint32_t idx, uint32_t rinh)
+{
+    const struct agg_node *n = &a->nodes[idx];
+    uint32_t r = n->route != AGG_NONE ? n->route : rinh;
+    uint32_t c0 = n->child[0], c1 = n->child[1];
+
+    if (c0 && agg_compute_subtree(a, c0, r) < 0) { return -1; }
+    if (c1 && agg_compute_subtree(a, c1, r) < 0) { return -1; }
+    return agg_compute(a, idx, rinh);
+}
+
+/* ============================================================================
+ * Pass 3: Prefix Selection
+ * ============================================================================ */
+
+/* Install new_nh for prefix/len, or remove it when new_nh is AGG_NONE */
+static void sink_emit(struct agg_sink *sk, const uint8_t *prefix, uint8_t len, uint32_t new_nh)
+{
+    if (!sk->trie) {
+        if (new_nh == AGG_NONE) { return; }
+        if (sk->count == sk->capacity) {
+            sk->err = -1;
+            return;
+        }
+        memcpy(sk->prefixes[sk->count], prefix, 16);
+        sk->prefix_lens[sk->count] = len;
+        sk->next_hops[sk->count] = new_nh;
+        sk->count++;
+        return;
+    }
+
+    int rc;
+    if (sk->stride) {
+        rc = routes_push(&sk->pending, prefix, len, new_nh);
+    } else if (new_nh == AGG_NONE) {
+        rc = lpm_delete_engine(sk->trie, prefix, len);
+    } else {
+        rc = lpm_add_engine(sk->trie, prefix, len, new_nh);
+    }
+    if (rc < 0) { sk->err = -1; }
+}
+
+static void agg_assign(struct lpm_agg *a, uint32_t idx, uint8_t prefix[16], uint8_t depth,
+                       uint32_t inh, uint32_t rinh, struct agg_sink *sk)
+{
+    struct agg_node *n = &a->nodes[idx];
+    if (!n->dirty && n->inh == inh) { return; }
+    n->dirty = 0;
+    n->inh = inh;
+
+    /* Keep the current choice when it is still a candidate to limit churn */
+    uint32_t fib;
+    if (set_has(n, inh)) {
+        fib = AGG_NONE;
+    } else {
+        fib = (n->fib != AGG_NONE && set_has(n, n->fib)) ? n->fib : set_elems(n)[0];
+    }
+    if (fib != n->fib) {
+        sink_emit(sk, prefix, depth, fib);
+        n->fib = fib;
+    }
+    uint32_t out = fib != AGG_NONE ? fib : inh;
+    uint32_t r = n->route != AGG_NONE ? n->route : rinh;
+
+    /* Ghost leaf of a one-child node */
+    uint32_t ghost = AGG_NONE;
+    uint8_t side = n->ghost_side;
+    if (!n->child[0] != !n->child[1]) {
+        side = n->child[0] ? 1 : 0;
+        ghost = r == out ? AGG_NONE : r;
+    }
+    if (n->ghost_fib != AGG_NONE && (ghost == AGG_NONE || side != n->ghost_side)) {
+        prefix[depth / 8] |= (uint8_t)(n->ghost_side << (7 - depth % 8));
+        sink_emit(sk, prefix, depth + 1, AGG_NONE);
+        prefix[depth / 8] &= (uint8_t)~(0x80 >> (depth % 8));
+        n->ghost_fib = AGG_NONE;
+    }
+    if (ghost != AGG_NONE && ghost != n->ghost_fib) {
+        prefix[depth / 8] |= (uint8_t)(side << (7 - depth % 8));
+        sink_emit(sk, prefix, depth + 1, ghost);
+        prefix[depth / 8] &= (uint8_t)~(0x80 >> (depth % 8));
+    }
+    n->ghost_fib = ghost;
+    n->ghost_side = side;
+
+    uint32_t c0 = n->child[0], c1 = n->child[1];
+    if (c0) {
+        agg_assign(a, c0, prefix, depth + 1, out, r, sk);
+    }
+    if (c1) {
+        prefix[depth / 8] |= (uint8_t)(0x80 >> (depth % 8));
+        agg_assign(a, c1, prefix, depth + 1, out, r, sk);
+        prefix[depth / 8] &= (uint8_t)~(0x80 >> (depth % 8));
+    }
+}
+
+/* ============================================================================
+ * Stride Engines
+ * ============================================================================ */
+
+/* Bits [base, end) of the engine node a prefix of length len >= 1 expands
+ * in. False for engines that keep covered prefixes themselves. */
+static bool agg_stride_node(const lpm_trie_t *trie, uint8_t len, uint8_t *base, uint8_t *end)
+{
+    uint8_t wide = 0;
+    if (trie->set || trie->adapt) { return false; }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        if ((trie->use_ipv4_dir24 && (trie->dir24_table || trie->dir24c_table)) ||
+            trie->small || trie->lctrie) {
+            return false;
+        }
+    } else if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
+        wide = (uint8_t)(16 * trie->wide_levels);
+    }
+
+    if (len <= wide) {
+        *base = (uint8_t)(16 * ((len - 1) / 16));
+        *end = (uint8_t)(*base + 16);
+    } else {
+        *base = (uint8_t)(wide + 8 * ((len - wide - 1) / 8));
+        *end = (uint8_t)(*base + 8);
+    }
+    return true;
+}
+
+/* Longest installed prefix strictly covering prefix/len: its length (and
+ * next hop), or -1 */
+static int installed_parent(const struct lpm_agg *a, const uint8_t *prefix, uint8_t len,
+                            uint32_t *next_hop)
+{
+    int best = -1;
+    uint32_t idx = 0;
+    for (unsigned d = 0; d < len; d++) {
+        const struct agg_node *n = &a->nodes[idx];
+        int b = prefix_bit(prefix, d);
+        if (n->fib != AGG_NONE) {
+            best = (int)d;
+            *next_hop = n->fib;
+        }
+        if (n->ghost_fib != AGG_NONE && n->ghost_side == b && d + 1 < len) {
+            best = (int)d + 1;
+            *next_hop = n->ghost_fib;
+        }
+        idx = n->child[b];
+        if (!idx) { break; }
+    }
+    return best;
+}
+
+/* Append the installed prefixes of lengths depth+1..end below node idx */
+static int installed_within(const struct lpm_agg *a, uint32_t idx, uint8_t prefix[16],
+                            uint8_t depth, uint8_t end, struct agg_routes *out)
+{
+    const struct agg_node *n = &a->nodes[idx];
+    if (depth >= end) { return 0; }
+
+    int rc = 0;
+    if (n->ghost_fib != AGG_NONE) {
+        prefix[depth / 8] |= (uint8_t)(n->ghost_side << (7 - depth % 8));
+        rc = routes_push(out, prefix, depth + 1, n->ghost_fib);
+        prefix[depth / 8] &= (uint8_t)~(0x80 >> (depth % 8));
+    }
+    for (int b = 0; b < 2 && rc == 0; b++) {
+        uint32_t c = n->child[b];
+        if (!c) { continue; }
+        prefix[depth / 8] |= (uint8_t)(b << (7 - depth % 8));
+        if (a->nodes[c].fib != AGG_NONE) {
+            rc = routes_push(out, prefix, depth + 1, a->nodes[c].fib);
+        }
+        if (rc == 0) {
+            rc = installed_within(a, c, prefix, depth + 1, end, out);
+        }
+        prefix[depth / 8] &= (uint8_t)~(0x80 >> (depth % 8));
+    }
+    return rc;
+}
+
+static int agg_route_by_len(const void *x, const void *y)
+{
+    const struct agg_route *a = x, *b = y;
+    return (int)a->len - (int)b->len;
+}
+
+/* Re-install the installed prefixes inside prefix/len that share its node,
+ * shortest first so each overwrites only what it covers */
+static int agg_stride_restore(const struct lpm_agg *a, struct agg_sink *sk, const uint8_t *prefix,
+                              uint8_t len, uint8_t end)
+{
+    uint32_t idx = 0;
+    for (unsigned d = 0; d < len; d++) {
+        idx = a->nodes[idx].child[prefix_bit(prefix, d)];
+        if (!idx) { return 0; }     /* A ghost prefix: nothing below it */
+    }
+
+    uint8_t buf[16];
+    memcpy(buf, prefix, sizeof(buf));
+    sk->restore.count = 0;
+    if (installed_within(a, idx, buf, len, end, &sk->restore) < 0) { return -1; }
+    qsort(sk->restore.v, sk->restore.count, sizeof(*sk->restore.v), agg_route_by_len);
+    for (size_t i = 0; i < sk->restore.count; i++) {
+        const struct agg_route *r = &sk->restore.v[i];
+        if (lpm_add_engine(sk->trie, r->prefix, r->len, r->next_hop) < 0) { return -1; }
+    }
+    return 0;
+}
+
+/* Apply one queued change, then repair what it hid in its node */
+static int agg_stride_sync(const struct lpm_agg *a, struct agg_sink *sk, const struct agg_route *c)
+{
+    uint8_t base, end;
+    if (c->len == 0 || !agg_stride_node(sk->trie, c->len, &base, &end)) {
+        return c->next_hop == AGG_NONE ? lpm_delete_engine(sk->trie, c->prefix, c->len)
+                                       : lpm_add_engine(sk->trie, c->prefix, c->len, c->next_hop);
+    }
+    if (c->next_hop != AGG_NONE) {
+        if (lpm_add_engine(sk->trie, c->prefix, c->len, c->next_hop) < 0) { return -1; }
+        return agg_stride_restore(a, sk, c->prefix, c->len, end);
+    }
+
+    /* The delete clears the whole range, including any covering prefix of
+     * the same node; put that back first */
+    lpm_delete_engine(sk->trie, c->prefix, c->len);
+    uint32_t q_nh = AGG_NONE;
+    int q_len = installed_parent(a, c->prefix, c->len, &q_nh);
+    uint8_t q_base = 0, q_end;
+    if (q_len > 0 && agg_stride_node(sk->trie, (uint8_t)q_len, &q_base, &q_end) && q_base == base) {
+        uint8_t qp[16] = {0};
+        memcpy(qp, c->prefix, (size_t)(q_len + 7) / 8);
+        if (q_len % 8) {
+            qp[q_len / 8] &= (uint8_t)(0xFF << (8 - q_len % 8));
+        }
+        if (lpm_add_engine(sk->trie, qp, (uint8_t)q_len, q_nh) < 0) { return -1; }
+        return agg_stride_restore(a, sk, qp, (uint8_t)q_len, end);
+    }
+    return agg_stride_restore(a, sk, c->prefix, c->len, end);
+}
+
+static struct agg_sink sink_engine(lpm_trie_t *trie)
+{
+    uint8_t base, end;
+    return (struct agg_sink){.trie = trie, .stride = agg_stride_node(trie, 1, &base, &end)};
+}
+
+/* Apply the queued stride engine changes against the final prefix set */
+static int sink_finish(const struct lpm_agg *a, struct agg_sink *sk)
+{
+    for (size_t i = 0; i < sk->pending.count && sk->err == 0; i++) {
+        if (agg_stride_sync(a, sk, &sk->pending.v[i]) < 0) {
+            sk->err = -1;
+        }
+    }
+    free(sk->pending.v);
+    free(sk->restore.v);
+    return sk->err;
+}
+
+static int agg_commit(struct lpm_agg *a, struct agg_sink *sk)
+{
+    uint8_t prefix[16] = {0};
+    agg_assign(a, 0, prefix, 0, AGG_NONE, AGG_NONE, sk);
+    return sk->err;
+}
+
+/* ============================================================================
+ * Route Updates
+ * ============================================================================ */
+
+/* Set (next_hop != AGG_NONE) or clear the route at prefix/len. path[0..len]
+ * receives the nodes from the root down; returns 1 if nothing changed, 0 on
+ * change, -1 if the route to clear is missing or memory runs out. */
+static int agg_route(struct lpm_agg *a, const uint8_t *prefix, uint8_t len, uint32_t next_hop,
+                     uint32_t path[129])
+{
+    uint32_t idx = 0;
+    path[0] = 0;
+    for (uint8_t d = 0; d < len; d++) {
+        int b = prefix_bit(prefix, d);
+        uint32_t c = a->nodes[idx].child[b];
+        if (!c) {
+            if (next_hop == AGG_NONE) { return -1; }
+            c = agg_node_alloc(a);
+            if (!c) { return -1; }
+            a->nodes[idx].child[b] = c;
+        }
+        idx = c;
+        path[d + 1] = idx;
+    }
+
+    struct agg_node *n = &a->nodes[idx];
+    if (next_hop == AGG_NONE && n->route == AGG_NONE) { return -1; }
+    if (n->route == next_hop) { return 1; }
+    if (n->route == AGG_NONE) {
+        a->routes++;
+    } else if (next_hop == AGG_NONE) {
+        a->routes--;
+    }
+    n->route = next_hop;
+    return 0;
+}
+
+/* After agg_route(): prune dead nodes, recompute S and push the changes */
+static int agg_update(struct lpm_agg *a, const uint8_t *prefix, uint8_t len,
+                      const uint32_t path[129], struct agg_sink *sk)
+{
+    uint8_t buf[16];
+    int depth = len;
+
+    /* Drop route-less leaves, removing what they had installed first */
+    while (depth > 0) {
+        struct agg_node *n = &a->nodes[path[depth]];
+        if (n->route != AGG_NONE || n->child[0] || n->child[1]) { break; }
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, prefix, (depth + 7) / 8);
+        if (depth % 8) {
+            buf[(depth - 1) / 8] &= (uint8_t)(0xFF << (8 - depth % 8));
+        }
+        if (n->fib != AGG_NONE) {
+            sink_emit(sk, buf, (uint8_t)depth, AGG_NONE);
+        }
+        /* A node that lost its last child may still hold a ghost prefix */
+        if (n->ghost_fib != AGG_NONE) {
+            buf[depth / 8] |= (uint8_t)(n->ghost_side << (7 - depth % 8));
+            sink_emit(sk, buf, (uint8_t)(depth + 1), AGG_NONE);
+        }
+        a->nodes[path[depth - 1]].child[prefix_bit(prefix, (unsigned)depth - 1)] = 0;
+        agg_node_free(a, path[depth]);
+        depth--;
+    }
+
+    /* Routes inherited along the path */
+    uint32_t rinh[129];
+    rinh[0] = AGG_NONE;
+    for (int d = 0; d < depth; d++) {
+        uint32_t r = a->nodes[path[d]].route;
+        rinh[d + 1] = r != AGG_NONE ? r : rinh[d];
+    }
+
+    int rc = depth == len ? agg_compute_subtree(a, path[depth], rinh[depth])
+                          : agg_compute(a, path[depth], rinh[depth]);
+    for (int d = depth - 1; d >= 0 && rc == 0; d--) {
+        rc = agg_compute(a, path[d], rinh[d]);
+    }
+    if (rc < 0) { return -1; }
+    return agg_commit(a, sk);
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+int lpm_agg_add(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    if (next_hop == AGG_NONE || next_hop == AGG_UNSEEN) { return -1; }
+
+    uint32_t path[129];
+    int rc = agg_route(trie->agg, prefix, prefix_len, next_hop, path);
+    if (rc != 0) { return rc < 0 ? -1 : 0; }
+
+    struct agg_sink sk = sink_engine(trie);
+    if (agg_update(trie->agg, prefix, prefix_len, path, &sk) < 0) {
+        sk.err = -1;
+    }
+    return sink_finish(trie->agg, &sk);
+}
+
+int lpm_agg_delete(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    uint32_t path[129];
+    if (agg_route(trie->agg, prefix, prefix_len, AGG_NONE, path) != 0) { return -1; }
+
+    struct agg_sink sk = sink_engine(trie);
+    if (agg_update(trie->agg, prefix, prefix_len, path, &sk) < 0) {
+        sk.err = -1;
+    }
+    return sink_finish(trie->agg, &sk);
+}
+
+int lpm_agg_stage(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    if (next_hop == AGG_NONE || next_hop == AGG_UNSEEN) { return -1; }
+
+    uint32_t path[129];
+    return agg_route(trie->agg, prefix, prefix_len, next_hop, path) < 0 ? -1 : 0;
+}
+
+int lpm_agg_commit(lpm_trie_t *trie)
+{
+    struct agg_sink sk = sink_engine(trie);
+    if (agg_compute_subtree(trie->agg, 0, AGG_NONE) >= 0) {
+        agg_commit(trie->agg, &sk);
+    } else {
+        sk.err = -1;
+    }
+    return sink_finish(trie->agg, &sk);
+}
+
+int lpm_agg_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    if (new_nh == AGG_NONE || new_nh == AGG_UNSEEN) { return -1; }
+
+    struct lpm_agg *a = trie->agg;
+    for (uint32_t i = 0; i < a->used; i++) {
+        struct agg_node *n = &a->nodes[i];
+        if (n->set_len && n->route == old_nh) {     /* set_len 0: freed */
+            n->route = new_nh;
+        }
+    }
+    return lpm_agg_commit(trie);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_enable_aggregation(lpm_trie_t *trie)
+{
+    if (!trie || trie->num_prefixes || trie->has_default_route || trie->journal ||
+        trie->shards || trie->async) {
+        return -1;
+    }
+    if (trie->agg) { return 0; }
+
+    trie->agg = agg_create(trie->max_depth);
+    return trie->agg ? 0 : -1;
+}
+
+size_t lpm_route_count(const lpm_trie_t *trie)
+{
+    if (!trie) { return 0; }
+    return trie->agg ? (size_t)trie->agg->routes : (size_t)trie->num_prefixes;
+}
+
+int lpm_aggregate(uint8_t (*prefixes)[16], uint8_t *prefix_lens, uint32_t *next_hops,
+                  size_t *count, uint8_t max_depth)
+{
+    if (!prefixes || !prefix_lens || !next_hops || !count ||
+        (max_depth != LPM_IPV4_MAX_DEPTH && max_depth != LPM_IPV6_MAX_DEPTH)) {
+        return -1;
+    }
+
+    struct lpm_agg *a = agg_create(max_depth);
+    if (!a) { return -1; }
+
+    /* Later duplicates win, as with repeated lpm_add() calls */
+    uint32_t path[129];
+    for (size_t i = 0; i < *count; i++) {
+        if (prefix_lens[i] > max_depth || next_hops[i] == AGG_NONE || next_hops[i] == AGG_UNSEEN ||
+            agg_route(a, prefixes[i], prefix_lens[i], next_hops[i], path) < 0) {
+            lpm_agg_destroy(a);
+            return -1;
+        }
+    }
+
+    /* The input is a valid answer, so the minimum never needs more room */
+    struct agg_sink sk = {
+        .prefixes = prefixes, .prefix_lens = prefix_lens, .next_hops = next_hops,
+        .capacity = *count,
+    };
+    int rc = agg_compute_subtree(a, 0, AGG_NONE);
+    if (rc == 0) {
+        rc = agg_commit(a, &sk);
+    }
+    lpm_agg_destroy(a);
+    if (rc == 0) {
+        *count = sk.count;
+    }
+    return rc;
+}
@@ -13,6 +13,168 @@
 #include "../include/lpm.h"
 #include "../include/internal.h"
 
+/* ============================================================================
+ * Lookup Dispatch
+ * Each trie carries its lookup functions, picked once when it is created, so
+ * the generic lookups are one indirect call whatever the engine.
+ * ============================================================================ */
+
+/* Membership sets answer next-hop lookups with 0 (covered) or invalid */
+static inline uint32_t set_next_hop(bool covered)
+{
+    return covered ? 0 : LPM_INVALID_NEXT_HOP;
+}
+
+static uint32_t set_lookup_ipv4(const lpm_trie_t *trie, uint32_t addr)
+{
+    return set_next_hop(lpm_contains_ipv4(trie, addr));
+}
+
+static void set_lookup_batch_ipv4(const lpm_trie_t *trie, const uint32_t *addrs,
+                                  uint32_t *next_hops, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        next_hops[i] = set_next_hop(lpm_contains_ipv4(trie, addrs[i]));
+    }
+}
+
+static uint32_t set_lookup_ipv6(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    return set_next_hop(lpm_contains_ipv6(trie, addr));
+}
+
+static void set_lookup_batch_ipv6(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                  uint32_t *next_hops, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        next_hops[i] = set_next_hop(lpm_contains_ipv6(trie, addrs[i]));
+    }
+}
+
+/* The ifunc entry points are called, not stored: taking their address from a
+ * data relocation would run the resolver before the library is relocated */
+static void dir24_lookup_batch(const lpm_trie_t *trie, const uint32_t *addrs,
+                               uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_dir24(trie, addrs, next_hops, count);
+}
+
+static void dir24c_lookup_batch(const lpm_trie_t *trie, const uint32_t *addrs,
+                                uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_dir24_compact(trie, addrs, next_hops, count);
+}
+
+static void small_lookup_batch(const lpm_trie_t *trie, const uint32_t *addrs,
+                               uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_small(trie, addrs, next_hops, count);
+}
+
+static uint32_t stride4_lookup(const lpm_trie_t *trie, uint32_t addr)
+{
+    return lpm_lookup_ipv4_8stride(trie, addr);
+}
+
+static void stride4_lookup_batch(const lpm_trie_t *trie, const uint32_t *addrs,
+                                 uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv4_8stride(trie, addrs, next_hops, count);
+}
+
+static uint32_t wide16_lookup(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    return lpm_lookup_ipv6_wide16(trie, addr);
+}
+
+static void wide16_lookup_batch(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv6_wide16(trie, addrs, next_hops, count);
+}
+
+static uint32_t stride6_lookup(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    return lpm_lookup_ipv6_8stride(trie, addr);
+}
+
+static void stride6_lookup_batch(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                 uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv6_8stride(trie, addrs, next_hops, count);
+}
+
+/* Adaptive tries go through the active view, which a switch-over replaces */
+static uint32_t adapt_lookup_ipv4(const lpm_trie_t *trie, uint32_t addr)
+{
+    const struct lpm_adapt_view *v = lpm_adapt_active(trie);
+    return v->lookup_ipv4(v->engine, addr);
+}
+
+static void adapt_lookup_batch_ipv4(const lpm_trie_t *trie, const uint32_t *addrs,
+                                    uint32_t *next_hops, size_t count)
+{
+    const struct lpm_adapt_view *v = lpm_adapt_active(trie);
+    lpm_adapt_count(trie, count);
+    v->batch_ipv4(v->engine, addrs, next_hops, count);
+}
+
+static uint32_t adapt_lookup_ipv6(const lpm_trie_t *trie, const uint8_t addr[16])
+{
+    const struct lpm_adapt_view *v = lpm_adapt_active(trie);
+    return v->lookup_ipv6(v->engine, addr);
+}
+
+static void adapt_lookup_batch_ipv6(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                    uint32_t *next_hops, size_t count)
+{
+    const struct lpm_adapt_view *v = lpm_adapt_active(trie);
+    lpm_adapt_count(trie, count);
+    v->batch_ipv6(v->engine, addrs, next_hops, count);
+}
+
+void lpm_dispatch_init(lpm_trie_t *trie)
+{
+    /* IPv4 */
+    if (trie->use_ipv4_dir24 && trie->dir24_table) {
+        trie->lookup_ipv4 = lpm_lookup_ipv4_dir24;
+        trie->lookup_batch_ipv4 = dir24_lookup_batch;
+    } else if (trie->dir24c_table) {
+        trie->lookup_ipv4 = lpm_lookup_ipv4_dir24_compact;
+        trie->lookup_batch_ipv4 = dir24c_lookup_batch;
+    } else if (trie->small) {
+        trie->lookup_ipv4 = lpm_lookup_ipv4_small;
+        trie->lookup_batch_ipv4 = small_lookup_batch;
+    } else if (trie->lctrie) {
+        trie->lookup_ipv4 = lpm_lookup_ipv4_lctrie;
+        trie->lookup_batch_ipv4 = lpm_lookup_batch_ipv4_lctrie;
+    } else if (trie->set) {
+        trie->lookup_ipv4 = set_lookup_ipv4;
+        trie->lookup_batch_ipv4 = set_lookup_batch_ipv4;
+    } else if (trie->adapt) {
+        trie->lookup_ipv4 = adapt_lookup_ipv4;
+        trie->lookup_batch_ipv4 = adapt_lookup_batch_ipv4;
+    } else {
+        trie->lookup_ipv4 = stride4_lookup;
+        trie->lookup_batch_ipv4 = stride4_lookup_batch;
+    }
+
+    /* IPv6 */
+    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
+        trie->lookup_ipv6 = wide16_lookup;
+        trie->lookup_batch_ipv6 = wide16_lookup_batch;
+    } else if (trie->set) {
+        trie->lookup_ipv6 = set_lookup_ipv6;
+        trie->lookup_batch_ipv6 = set_lookup_batch_ipv6;
+    } else if (trie->adapt) {
+        trie->lookup_ipv6 = adapt_lookup_ipv6;
+        trie->lookup_batch_ipv6 = adapt_lookup_batch_ipv6;
+    } else {
+        trie->lookup_ipv6 = stride6_lookup;
+        trie->lookup_batch_ipv6 = stride6_lookup_batch;
+    }
+}
+
 /* ============================================================================
  * Generic IPv4 API - Compile-time dispatch
  * ============================================================================ */
@@ -32,12 +194,7 @@ uint32_t lpm_lookup_ipv4(const lpm_trie_t *trie, uint32_t addr)
     if (!trie) {
         return LPM_INVALID_NEXT_HOP;
     }
-
-    /* Runtime dispatch based on trie configuration */
-    if (trie->use_ipv4_dir24 && trie->dir24_table) {
-        return lpm_lookup_ipv4_dir24(trie, addr);
-    }
-    return lpm_lookup_ipv4_8stride(trie, addr);
+    return trie->lookup_ipv4(trie, addr);
 }
 
 void lpm_lookup_batch_ipv4(const lpm_trie_t *trie, const uint32_t *addrs,
@@ -46,13 +203,12 @@ void lpm_lookup_batch_ipv4(const lpm_trie_t *trie, const uint32_t *addrs,
     if (!trie || !addrs || !next_hops || count == 0) {
         return;
     }
-
-    /* Runtime dispatch based on trie configuration */
-    if (trie->use_ipv4_dir24 && trie->dir24_table) {
-        lpm_lookup_batch_ipv4_dir24(trie, addrs, next_hops, count);
-        return;
-    }
-    lpm_lookup_batch_ipv4_8stride(trie, addrs, next_hops, count);
+    /* A next-hop replacement that overlaps the batch: run it again */
+    uint64_t seq;
+    do {
+        seq = lpm_replace_read_begin(trie);
+        trie->lookup_batch_ipv4(trie, addrs, next_hops, count);
+    } while (lpm_replace_read_retry(trie, seq));
 }
 
 /* ============================================================================
@@ -74,12 +230,7 @@ uint32_t lpm_lookup_ipv6(const lpm_trie_t *trie, const uint8_t addr[16])
     if (!trie || !addr) {
         return LPM_INVALID_NEXT_HOP;
     }
-
-    /* Runtime dispatch based on trie configuration */
-    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
-        return lpm_lookup_ipv6_wide16(trie, addr);
-    }
-    return lpm_lookup_ipv6_8stride(trie, addr);
+    return trie->lookup_ipv6(trie, addr);
 }
 
 void lpm_lookup_batch_ipv6(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
@@ -88,13 +239,11 @@ void lpm_lookup_batch_ipv6(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
     if (!trie || !addrs || !next_hops || count == 0) {
         return;
     }
-
-    /* Runtime dispatch based on trie configuration */
-    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
-        lpm_lookup_batch_ipv6_wide16(trie, addrs, next_hops, count);
-        return;
-    }
-    lpm_lookup_batch_ipv6_8stride(trie, addrs, next_hops, count);
+    uint64_t seq;
+    do {
+        seq = lpm_replace_read_begin(trie);
+        trie->lookup_batch_ipv6(trie, addrs, next_hops, count);
+    } while (lpm_replace_read_retry(trie, seq));
 }
 
 /* ============================================================================
@@ -107,11 +256,42 @@ int lpm_add(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_
         return -1;
     }
 
+    if (trie->ttl) {
+        lpm_ttl_cancel(trie, prefix, prefix_len);
+    }
+
+    int rc = trie->agg ? lpm_agg_add(trie, prefix, prefix_len, next_hop)
+                       : lpm_add_engine(trie, prefix, prefix_len, next_hop);
+    if (rc == 0 && trie->nh_index) {
+        rc = lpm_nh_index_set(trie, prefix, prefix_len, next_hop);
+    }
+    if (rc == 0 && trie->journal) {
+        lpm_journal_record(trie, LPM_JOURNAL_ADD, prefix, prefix_len, next_hop, 0);
+    }
+    return rc;
+}
+
+int lpm_add_engine(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    /* The engines bump the generation themselves; sets and adaptive tries here */
+    if (trie->set || trie->adapt) {
+        int rc = trie->set ? lpm_add_set(trie, prefix, prefix_len)
+                           : lpm_adapt_add(trie, prefix, prefix_len, next_hop);
+        lpm_generation_bump(trie);
+        return rc;
+    }
+
     /* IPv4 dispatch */
     if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
-        if (trie->use_ipv4_dir24 && trie->dir24_table) {
+        if (trie->use_ipv4_dir24 && (trie->dir24_table || trie->dir24c_table)) {
             return lpm_add_ipv4_dir24(trie, prefix, prefix_len, next_hop);
         }
+        if (trie->small) {
+            return lpm_add_ipv4_small(trie, prefix, prefix_len, next_hop);
+        }
+        if (trie->lctrie) {
+            return lpm_add_ipv4_lctrie(trie, prefix, prefix_len, next_hop);
+        }
         return lpm_add_ipv4_8stride(trie, prefix, prefix_len, next_hop);
     }
 
@@ -132,11 +312,41 @@ int lpm_delete(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
         return -1;
     }
 
+    if (trie->ttl) {
+        lpm_ttl_cancel(trie, prefix, prefix_len);
+    }
+
+    int rc = trie->agg ? lpm_agg_delete(trie, prefix, prefix_len)
+                       : lpm_delete_engine(trie, prefix, prefix_len);
+    if (rc == 0 && trie->nh_index) {
+        lpm_nh_index_clear(trie, prefix, prefix_len);
+    }
+    if (rc == 0 && trie->journal) {
+        lpm_journal_record(trie, LPM_JOURNAL_DELETE, prefix, prefix_len, 0, 0);
+    }
+    return rc;
+}
+
+int lpm_delete_engine(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (trie->set || trie->adapt) {
+        int rc = trie->set ? lpm_delete_set(trie, prefix, prefix_len)
+                           : lpm_adapt_delete(trie, prefix, prefix_len);
+        lpm_generation_bump(trie);
+        return rc;
+    }
+
     /* IPv4 dispatch */
     if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
-        if (trie->use_ipv4_dir24 && trie->dir24_table) {
+        if (trie->use_ipv4_dir24 && (trie->dir24_table || trie->dir24c_table)) {
             return lpm_delete_ipv4_dir24(trie, prefix, prefix_len);
         }
+        if (trie->small) {
+            return lpm_delete_ipv4_small(trie, prefix, prefix_len);
+        }
+        if (trie->lctrie) {
+            return lpm_delete_ipv4_lctrie(trie, prefix, prefix_len);
+        }
         return lpm_delete_ipv4_8stride(trie, prefix, prefix_len);
     }
 
@@ -166,6 +376,30 @@ uint32_t lpm_lookup(const lpm_trie_t *trie, const uint8_t *addr)
         if (trie->use_ipv4_dir24 && trie->dir24_table) {
             return lpm_lookup_ipv4_dir24_bytes(trie, addr);
         }
+        if (trie->dir24c_table) {
+            return lpm_lookup_ipv4_dir24_compact(trie, ((uint32_t)addr[0] << 24) |
+                                                 ((uint32_t)addr[1] << 16) |
+                                                 ((uint32_t)addr[2] << 8) | addr[3]);
+        }
+        if (trie->small) {
+            return lpm_lookup_ipv4_small(trie, ((uint32_t)addr[0] << 24) |
+                                         ((uint32_t)addr[1] << 16) |
+                                         ((uint32_t)addr[2] << 8) | addr[3]);
+        }
+        if (trie->lctrie) {
+            return lpm_lookup_ipv4_lctrie(trie, ((uint32_t)addr[0] << 24) |
+                                          ((uint32_t)addr[1] << 16) |
+                                          ((uint32_t)addr[2] << 8) | addr[3]);
+        }
+        if (trie->set) {
+            return set_next_hop(lpm_contains_ipv4(trie, ((uint32_t)addr[0] << 24) |
+                                                  ((uint32_t)addr[1] << 16) |
+                                                  ((uint32_t)addr[2] << 8) | addr[3]));
+        }
+        if (trie->adapt) {
+            return lpm_lookup_ipv4(trie, ((uint32_t)addr[0] << 24) | ((uint32_t)addr[1] << 16) |
+                                         ((uint32_t)addr[2] << 8) | addr[3]);
+        }
         return lpm_lookup_ipv4_8stride_bytes(trie, addr);
     }
 
@@ -174,6 +408,12 @@ uint32_t lpm_lookup(const lpm_trie_t *trie, const uint8_t *addr)
         if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
             return lpm_lookup_ipv6_wide16(trie, addr);
         }
+        if (trie->set) {
+            return set_next_hop(lpm_contains_ipv6(trie, addr));
+        }
+        if (trie->adapt) {
+            return lpm_lookup_ipv6(trie, addr);
+        }
         return lpm_lookup_ipv6_8stride(trie, addr);
     }
 
@@ -181,12 +421,9 @@ uint32_t lpm_lookup(const lpm_trie_t *trie, const uint8_t *addr)
 }
 
 /* Batch lookup with pointer array */
-void lpm_lookup_batch(const lpm_trie_t *trie, const uint8_t **addrs,
-                      uint32_t *next_hops, size_t count)
+static void lookup_batch_ptrs(const lpm_trie_t *trie, const uint8_t **addrs,
+                              uint32_t *next_hops, size_t count)
 {
-    if (!trie || !addrs || !next_hops || count == 0) {
-        return;
-    }
 
     /* IPv4 */
     if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
@@ -194,6 +431,12 @@ void lpm_lookup_batch(const lpm_trie_t *trie, const uint8_t **addrs,
             lpm_lookup_batch_ipv4_dir24_ptrs(trie, addrs, next_hops, count);
             return;
         }
+        if (trie->dir24c_table || trie->small || trie->lctrie || trie->set || trie->adapt) {
+            for (size_t i = 0; i < count; i++) {
+                next_hops[i] = lpm_lookup(trie, addrs[i]);
+            }
+            return;
+        }
         lpm_lookup_batch_ipv4_8stride_bytes(trie, addrs, next_hops, count);
         return;
     }
@@ -203,9 +446,26 @@ void lpm_lookup_batch(const lpm_trie_t *trie, const uint8_t **addrs,
         for (size_t i = 0; i < count; i++) {
             if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
                 next_hops[i] = lpm_lookup_ipv6_wide16(trie, addrs[i]);
+            } else if (trie->set) {
+                next_hops[i] = set_next_hop(lpm_contains_ipv6(trie, addrs[i]));
+            } else if (trie->adapt) {
+                next_hops[i] = lpm_lookup_ipv6(trie, addrs[i]);
             } else {
                 next_hops[i] = lpm_lookup_ipv6_8stride(trie, addrs[i]);
             }
         }
     }
 }
+
+void lpm_lookup_batch(const lpm_trie_t *trie, const uint8_t **addrs,
+                      uint32_t *next_hops, size_t count)
+{
+    if (!trie || !addrs || !next_hops || count == 0) {
+        return;
+    }
+    uint64_t seq;
+    do {
+        seq = lpm_replace_read_begin(trie);
+        lookup_batch_ptrs(trie, addrs, next_hops, count);
+    } while (lpm_replace_read_retry(trie, seq));
+}
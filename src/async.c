@@ -0,0 +1,402 @@
+/*
+ * liblpm Asynchronous Updates
+ *
+ * lpm_enable_async_updates() starts a writer thread that owns the update
+ * path. Callers enqueue adds and deletes without taking a lock and get a
+ * sequence number back; the writer drains the queue in batches, coalesces
+ * each batch, applies it with lpm_add()/lpm_delete() and then publishes the
+ * sequence number it has applied up to. Callers wait on that number, or get
+ * a callback on the writer thread after every batch.
+ *
+ * The queue is a bounded ring of slots with a turn counter each (Vyukov's
+ * MPMC queue with a single consumer). A producer takes a ticket with one
+ * fetch-add, waits for its slot to come free, fills it and hands it over by
+ * storing the next turn. The ticket is also the sequence number, so the
+ * writer consumes operations in sequence order and "applied up to n" means
+ * every operation numbered n or less has been applied. A full ring makes
+ * producers wait for the writer.
+ *
+ * Coalescing keeps the last operation per (prefix, length) within a batch:
+ * repeated adds keep the last next hop, and a delete after an add removes
+ * the prefix in one step. If that delete finds nothing to remove the prefix
+ * was not installed before the batch, so the add and delete cancelled out.
+ * The surviving operations are applied in the order of their last
+ * occurrence. With a journal, each batch is synced before it is reported,
+ * so a completed sequence number is also durable, and a snapshot that is due
+ * is written once the queue runs empty.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_ASYNC_DEFAULT_QUEUE  65536
+#define LPM_ASYNC_DEFAULT_BATCH  4096
+#define LPM_ASYNC_MAX_QUEUE      (1U << 24)
+
+struct async_slot {
+    uint64_t turn;            /* ticket: free for it; ticket + 1: filled */
+    uint64_t enqueued_ns;
+    uint32_t next_hop;
+    uint8_t len;
+    bool del;
+    uint8_t prefix[16];       /* Masked to len bits, zero padded */
+};
+
+/* An operation taken off the ring */
+struct async_op {
+    uint64_t enqueued_ns;
+    uint32_t next_hop;
+    uint8_t len;
+    bool del;
+    bool superseded;          /* A later operation in the batch has the same key */
+    bool after_add;           /* An earlier operation in the batch added the key */
+    uint8_t prefix[16];
+};
+
+struct lpm_async {
+    /* Producers */
+    uint64_t tail LPM_ALIGN_CACHE;  /* Next ticket */
+
+    /* Writer */
+    uint64_t head LPM_ALIGN_CACHE;  /* Next ticket to consume */
+    uint64_t applied;               /* Published sequence number */
+    bool sleeping;                  /* Writer waits on wake */
+    bool stop;
+
+    struct async_slot *slots;
+    uint32_t mask;
+    uint32_t batch_size;
+    struct async_op *batch;
+    int32_t *keys;                  /* Coalescing hash: batch index or -1 */
+    uint32_t keys_mask;
+
+    void (*on_applied)(void *ctx, uint64_t seq);
+    void *ctx;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;            /* Writer: work arrived or stop */
+    pthread_cond_t done;            /* Waiters: applied moved */
+    uint32_t waiters;
+
+    /* Metrics, written by the writer and read relaxed */
+    uint64_t coalesced;
+    uint64_t failed;
+    uint64_t batches;
+    uint64_t max_depth;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+};
+
+/* ============================================================================
+ * Queue
+ * ============================================================================ */
+
+static uint64_t async_enqueue(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                              uint32_t next_hop, bool del)
+{
+    struct lpm_async *a = trie ? trie->async : NULL;
+    if (!a || !prefix || prefix_len > trie->max_depth) { return 0; }
+
+    uint64_t t = __atomic_fetch_add(&a->tail, 1, __ATOMIC_RELAXED);
+    struct async_slot *s = &a->slots[t & a->mask];
+    while (__atomic_load_n(&s->turn, __ATOMIC_ACQUIRE) != t) {
+        sched_yield();      /* Ring full: wait for the writer */
+    }
+
+    memset(s->prefix, 0, sizeof(s->prefix));
+    uint8_t bytes = (prefix_len + 7) / 8;
+    memcpy(s->prefix, prefix, bytes);
+    if (prefix_len % 8) {
+        s->prefix[bytes - 1] &= (uint8_t)(0xFF << (8 - prefix_len % 8));
+    }
+    s->len = prefix_len;
+    s->del = del;
+    s->next_hop = next_hop;
+    s->enqueued_ns = lpm_now_ns();
+    __atomic_store_n(&s->turn, t + 1, __ATOMIC_SEQ_CST);
+
+    /* Pairs with the writer publishing sleeping before its last look */
+    if (__atomic_load_n(&a->sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&a->lock);
+        __atomic_store_n(&a->sleeping, false, __ATOMIC_RELAXED);
+        pthread_cond_signal(&a->wake);
+        pthread_mutex_unlock(&a->lock);
+    }
+    return t + 1;
+}
+
+static bool slot_ready(const struct lpm_async *a, uint64_t t)
+{
+    return __atomic_load_n(&a->slots[t & a->mask].turn, __ATOMIC_ACQUIRE) == t + 1;
+}
+
+/* Copy up to batch_size filled slots out and free them for producers */
+static uint32_t async_drain(struct lpm_async *a)
+{
+    uint32_t n = 0;
+    while (n < a->batch_size && slot_ready(a, a->head + n)) {
+        struct async_slot *s = &a->slots[(a->head + n) & a->mask];
+        struct async_op *op = &a->batch[n];
+        op->enqueued_ns = s->enqueued_ns;
+        op->next_hop = s->next_hop;
+        op->len = s->len;
+        op->del = s->del;
+        op->superseded = false;
+        op->after_add = false;
+        memcpy(op->prefix, s->prefix, sizeof(op->prefix));
+        __atomic_store_n(&s->turn, a->head + n + a->mask + 1, __ATOMIC_RELEASE);
+        n++;
+    }
+    return n;
+}
+
+/* ============================================================================
+ * Writer
+ * ============================================================================ */
+
+static void async_coalesce(struct lpm_async *a, uint32_t n)
+{
+    memset(a->keys, 0xFF, ((size_t)a->keys_mask + 1) * sizeof(int32_t));
+    for (uint32_t i = 0; i < n; i++) {
+        struct async_op *op = &a->batch[i];
+        uint32_t h = (uint32_t)(lpm_fast_hash(op->prefix, (op->len + 7) / 8) ^ op->len) & a->keys_mask;
+        for (;; h = (h + 1) & a->keys_mask) {
+            int32_t k = a->keys[h];
+            if (k < 0) { break; }
+            struct async_op *prev = &a->batch[k];
+            if (prev->len == op->len && memcmp(prev->prefix, op->prefix, sizeof(op->prefix)) == 0) {
+                prev->superseded = true;
+                op->after_add = prev->after_add || !prev->del;
+                __atomic_fetch_add(&a->coalesced, 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        a->keys[h] = (int32_t)i;
+    }
+}
+
+static void async_apply(lpm_trie_t *trie, struct lpm_async *a, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        const struct async_op *op = &a->batch[i];
+        if (op->superseded) { continue; }
+        int rc = op->del ? lpm_delete(trie, op->prefix, op->len)
+                         : lpm_add(trie, op->prefix, op->len, op->next_hop);
+        if (rc == 0) { continue; }
+        /* A delete that finds nothing after an add in the same batch: the
+         * prefix was not installed before, so the pair cancelled out */
+        __atomic_fetch_add(op->del && op->after_add ? &a->coalesced : &a->failed, 1, __ATOMIC_RELAXED);
+    }
+    if (trie->journal) {
+        lpm_journal_sync(trie);
+    }
+}
+
+static void async_publish(struct lpm_async *a, uint32_t n)
+{
+    uint64_t now = lpm_now_ns();
+    uint64_t sum = 0, max = a->latency_max_ns;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t d = now - a->batch[i].enqueued_ns;
+        sum += d;
+        if (d > max) { max = d; }
+    }
+    __atomic_store_n(&a->latency_sum_ns, a->latency_sum_ns + sum, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->latency_max_ns, max, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->batches, a->batches + 1, __ATOMIC_RELAXED);
+
+    a->head += n;
+    __atomic_store_n(&a->applied, a->head, __ATOMIC_SEQ_CST);
+    if (a->on_applied) {
+        a->on_applied(a->ctx, a->head);
+    }
+    if (__atomic_load_n(&a->waiters, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&a->lock);
+        pthread_cond_broadcast(&a->done);
+        pthread_mutex_unlock(&a->lock);
+    }
+}
+
+/* Sleep until a slot is filled or stop is set; false once stopped and empty */
+static bool async_idle(struct lpm_async *a)
+{
+    bool more = true;
+    pthread_mutex_lock(&a->lock);
+    for (;;) {
+        /* Announce before looking, so a producer filling a slot after the
+         * look sees it and signals (it needs the lock, held until we wait) */
+        __atomic_store_n(&a->sleeping, true, __ATOMIC_SEQ_CST);
+        if (slot_ready(a, a->head)) { break; }
+        if (a->stop && __atomic_load_n(&a->tail, __ATOMIC_SEQ_CST) == a->head) {
+            more = false;
+            break;
+        }
+        pthread_cond_wait(&a->wake, &a->lock);
+    }
+    __atomic_store_n(&a->sleeping, false, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&a->lock);
+    return more;
+}
+
+static void *async_writer(void *arg)
+{
+    lpm_trie_t *trie = arg;
+    struct lpm_async *a = trie->async;
+
+    for (;;) {
+        uint64_t depth = __atomic_load_n(&a->tail, __ATOMIC_RELAXED) - a->head;
+        if (depth > a->max_depth) {
+            __atomic_store_n(&a->max_depth, depth, __ATOMIC_RELAXED);
+        }
+        uint32_t n = async_drain(a);
+        if (n == 0) {
+            /* Snapshots wait for an empty queue rather than stall a batch */
+            if (trie->journal && lpm_journal_snapshot_due(trie)) {
+                lpm_snapshot(trie);
+            }
+            if (!async_idle(a)) { break; }
+            continue;
+        }
+        async_coalesce(a, n);
+        async_apply(trie, a, n);
+        async_publish(a, n);
+    }
+    return NULL;
+}
+
+static void async_free(struct lpm_async *a)
+{
+    pthread_cond_destroy(&a->done);
+    pthread_cond_destroy(&a->wake);
+    pthread_mutex_destroy(&a->lock);
+    free(a->keys);
+    free(a->batch);
+    free(a->slots);
+    free(a);
+}
+
+void lpm_async_destroy(lpm_trie_t *trie)
+{
+    struct lpm_async *a = trie->async;
+    if (!a) { return; }
+
+    /* The writer applies everything enqueued before it stops */
+    pthread_mutex_lock(&a->lock);
+    a->stop = true;
+    pthread_cond_signal(&a->wake);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->thread, NULL);
+    trie->async = NULL;
+    async_free(a);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_enable_async_updates(lpm_trie_t *trie, const lpm_async_config_t *config)
+{
+    if (!trie || trie->async) { return -1; }
+
+    uint32_t queue = config && config->queue_size ? config->queue_size : LPM_ASYNC_DEFAULT_QUEUE;
+    uint32_t batch = config && config->batch_size ? config->batch_size : LPM_ASYNC_DEFAULT_BATCH;
+    if ((queue & (queue - 1)) || queue > LPM_ASYNC_MAX_QUEUE || batch > queue) { return -1; }
+
+    struct lpm_async *a = aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(*a));
+    if (!a) { return -1; }
+    memset(a, 0, sizeof(*a));
+    a->mask = queue - 1;
+    a->batch_size = batch;
+    a->keys_mask = 1;
+    while (a->keys_mask + 1 < 2 * batch) {
+        a->keys_mask = (a->keys_mask << 1) | 1;
+    }
+    a->slots = malloc((size_t)queue * sizeof(struct async_slot));
+    a->batch = malloc((size_t)batch * sizeof(struct async_op));
+    a->keys = malloc(((size_t)a->keys_mask + 1) * sizeof(int32_t));
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->wake, NULL);
+    pthread_cond_init(&a->done, NULL);
+    if (!a->slots || !a->batch || !a->keys) {
+        async_free(a);
+        return -1;
+    }
+    for (uint32_t i = 0; i < queue; i++) {
+        a->slots[i].turn = i;
+    }
+    if (config) {
+        a->on_applied = config->on_applied;
+        a->ctx = config->ctx;
+    }
+
+    /* Work queued for lpm_update_step() goes first */
+    lpm_update_flush(trie);
+    trie->async = a;
+    if (pthread_create(&a->thread, NULL, async_writer, trie) != 0) {
+        trie->async = NULL;
+        async_free(a);
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t lpm_add_async(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    return async_enqueue(trie, prefix, prefix_len, next_hop, false);
+}
+
+uint64_t lpm_delete_async(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    return async_enqueue(trie, prefix, prefix_len, 0, true);
+}
+
+uint64_t lpm_async_applied(const lpm_trie_t *trie)
+{
+    if (!trie || !trie->async) { return 0; }
+    return __atomic_load_n(&trie->async->applied, __ATOMIC_ACQUIRE);
+}
+
+int lpm_async_wait(lpm_trie_t *trie, uint64_t seq)
+{
+    struct lpm_async *a = trie ? trie->async : NULL;
+    if (!a || seq > __atomic_load_n(&a->tail, __ATOMIC_RELAXED)) { return -1; }
+    if (__atomic_load_n(&a->applied, __ATOMIC_ACQUIRE) >= seq) { return 0; }
+
+    __atomic_fetch_add(&a->waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&a->lock);
+    while (__atomic_load_n(&a->applied, __ATOMIC_SEQ_CST) < seq) {
+        pthread_cond_wait(&a->done, &a->lock);
+    }
+    pthread_mutex_unlock(&a->lock);
+    __atomic_fetch_sub(&a->waiters, 1, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+int lpm_async_stats(const lpm_trie_t *trie, lpm_async_stats_t *stats)
+{
+    if (!stats) { return -1; }
+    memset(stats, 0, sizeof(*stats));
+    const struct lpm_async *a = trie ? trie->async : NULL;
+    if (!a) { return -1; }
+
+    stats->enqueued = __atomic_load_n(&a->tail, __ATOMIC_RELAXED);
+    stats->applied = __atomic_load_n(&a->applied, __ATOMIC_ACQUIRE);
+    stats->depth = stats->enqueued - stats->applied;
+    stats->max_depth = __atomic_load_n(&a->max_depth, __ATOMIC_RELAXED);
+    stats->coalesced = __atomic_load_n(&a->coalesced, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&a->failed, __ATOMIC_RELAXED);
+    stats->batches = __atomic_load_n(&a->batches, __ATOMIC_RELAXED);
+    if (stats->applied) {
+        stats->latency_avg_us = (double)__atomic_load_n(&a->latency_sum_ns, __ATOMIC_RELAXED) /
+                                (double)stats->applied / 1e3;
+    }
+    stats->latency_max_us = (double)__atomic_load_n(&a->latency_max_ns, __ATOMIC_RELAXED) / 1e3;
+    return 0;
+}
@@ -15,7 +15,7 @@
 #include "../include/lpm.h"
 #include "../include/internal.h"
 
-static const char *lpm_version = "liblpm 2.1.1";
+static const char *lpm_version = "liblpm 3.0.0";
 
 /* ============================================================================
  * Node Pool Management
@@ -113,7 +113,11 @@ uint32_t wide_node_alloc(lpm_trie_t *trie)
 
 void lpm_cache_invalidate(lpm_trie_t *trie)
 {
-    if (trie && trie->hot_cache) {
+    if (!trie) {
+        return;
+    }
+    lpm_generation_bump(trie);
+    if (trie->hot_cache) {
         memset(trie->hot_cache, 0, LPM_HOT_CACHE_SIZE * sizeof(struct lpm_cache_entry));
     }
 }
@@ -127,10 +131,28 @@ void lpm_destroy(lpm_trie_t *trie)
     if (!trie) {
         return;
     }
+    lpm_async_destroy(trie);
+    lpm_journal_destroy(trie->journal);
+    lpm_prefault_release(trie);
     free(trie->node_pool);
     free(trie->wide_nodes_pool);
+    lpm_sparse16_pool_destroy(trie->sparse16);
     free(trie->dir24_table);
     free(trie->tbl8_groups);
+    free(trie->dir24c_table);
+    free(trie->tbl8c_groups);
+    free(trie->dir24_depth);
+    free(trie->tbl8_depth);
+    lpm_rules_destroy(trie->rules);
+    lpm_shards_destroy(trie->shards);
+    lpm_update_queue_destroy(trie->updates);
+    lpm_set_destroy(trie->set);
+    lpm_small_destroy(trie->small);
+    lpm_lctrie_destroy(trie->lctrie);
+    lpm_adapt_destroy(trie->adapt);
+    lpm_ttl_destroy(trie->ttl);
+    lpm_agg_destroy(trie->agg);
+    lpm_nh_index_destroy(trie->nh_index);
     free(trie->direct_table);
     free(trie->hot_cache);
     free(trie);
@@ -178,24 +200,56 @@ void lpm_print_stats(const lpm_trie_t *trie)
     printf("  Version: %s\n", lpm_version);
     printf("  Max depth: %u bits\n", trie->max_depth);
 
-    if (trie->use_ipv4_dir24) {
-        printf("  Algorithm: DIR-24-8\n");
+    if (trie->set) {
+        printf("  Algorithm: Membership set (%s)\n",
+               trie->max_depth == LPM_IPV4_MAX_DEPTH ? "/24 bitmap + blocks" : "bitmap trie");
+        printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
+        if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+            printf("  /25-/32 blocks: %u\n", trie->set->block_count);
+        } else {
+            printf("  Nodes: %u\n", trie->set->node_live);
+        }
+        printf("  Memory: %.2f MB\n", (double)lpm_set_memory(trie) / (1024.0 * 1024.0));
+    } else if (trie->adapt) {
+        printf("  Algorithm: Adaptive (now %s, %u migrations)\n", lpm_adaptive_engine(trie),
+               lpm_adaptive_migrations(trie));
+        printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
+    } else if (trie->small) {
+        printf("  Algorithm: Small table (Eytzinger range search)\n");
+        printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
+        printf("  Tree height: %u (%u keys)\n", trie->small->height,
+               (1U << trie->small->height) - 1);
+        printf("  Memory: %.2f KB\n", (double)lpm_small_memory(trie) / 1024.0);
+    } else if (trie->lctrie) {
+        printf("  Algorithm: LC-trie (level and path compressed)\n");
+        printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
+        printf("  Leaves: %u, internal nodes: %u\n", trie->lctrie->leaves, trie->lctrie->tnodes);
+        printf("  Memory: %.2f KB\n", (double)lpm_lctrie_memory(trie) / 1024.0);
+    } else if (trie->use_ipv4_dir24) {
+        size_t entry_size = trie->dir24c_table ? sizeof(uint16_t) : sizeof(struct lpm_dir24_entry);
+        printf("  Algorithm: DIR-24-8%s\n", trie->dir24c_table ? " (compact)" : "");
         printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
         printf("  TBL8 groups: %u / %u\n", trie->tbl8_groups_used, trie->tbl8_num_groups);
 
-        size_t dir24_mem = LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry);
-        size_t tbl8_mem = (size_t)trie->tbl8_groups_used * 256 * sizeof(struct lpm_tbl8_entry);
+        size_t dir24_mem = LPM_IPV4_DIR24_SIZE * entry_size;
+        size_t tbl8_mem = (size_t)trie->tbl8_groups_used * 256 * entry_size;
         printf("  Memory: DIR24=%.2f MB, TBL8=%.2f MB, Total=%.2f MB\n",
                (double)dir24_mem / (1024.0 * 1024.0),
                (double)tbl8_mem / (1024.0 * 1024.0),
                (double)(dir24_mem + tbl8_mem) / (1024.0 * 1024.0));
     } else if (trie->use_ipv6_wide_stride) {
-        printf("  Algorithm: Wide 16-bit stride (IPv6)\n");
+        printf("  Algorithm: Wide 16-bit stride (IPv6, %u wide levels)\n", trie->wide_levels);
         printf("  Prefixes: %llu\n", (unsigned long long)trie->num_prefixes);
         printf("  8-bit nodes: %llu\n", (unsigned long long)trie->num_nodes);
         printf("  16-bit nodes: %llu\n", (unsigned long long)trie->num_wide_nodes);
+        if (trie->sparse16) {
+            printf("  Sparse 16-bit nodes: %llu (%.2f KB in use)\n",
+                   (unsigned long long)trie->sparse16->nodes,
+                   (double)trie->sparse16->live_cells * LPM_SPARSE16_CELL / 1024.0);
+        }
 
-        size_t wide_mem = trie->num_wide_nodes * sizeof(struct lpm_node_16);
+        size_t wide_mem = trie->num_wide_nodes * sizeof(struct lpm_node_16) +
+                          lpm_sparse16_memory(trie->sparse16);
         printf("  Total memory: %.2f MB (8-bit: %.2f MB, 16-bit: %.2f MB)\n",
                (double)(used_mem + wide_mem) / (1024.0 * 1024.0),
                (double)used_mem / (1024.0 * 1024.0),
@@ -208,6 +262,17 @@ void lpm_print_stats(const lpm_trie_t *trie)
         printf("  Pool: %.2f MB allocated, %.2f MB used\n",
                (double)pool_mem / (1024.0 * 1024.0), (double)used_mem / (1024.0 * 1024.0));
     }
+    if (trie->agg) {
+        printf("  Aggregation: %zu routes -> %llu prefixes\n", lpm_route_count(trie),
+               (unsigned long long)trie->num_prefixes);
+    }
+    if (trie->nh_index) {
+        printf("  Next-hop index: enabled\n");
+    }
+    if (trie->ttl) {
+        printf("  Expiring prefixes: %zu (%.2f KB of timers)\n", lpm_ttl_count(trie),
+               (double)lpm_ttl_memory(trie) / 1024.0);
+    }
     printf("  Huge pages: %s\n", trie->use_huge_pages ? "enabled" : "disabled");
     printf("  Direct table: %s\n", trie->direct_table ? "enabled (256KB)" : "disabled");
     printf("  Hot cache: %s", trie->hot_cache ? "enabled" : "disabled");
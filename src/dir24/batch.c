@@ -16,31 +16,6 @@
 #include "../../include/lpm.h"
 #include "../../include/internal.h"
 
-#define LPM_TBL8_GROUP_ENTRIES 256
-
-/* ============================================================================
- * Inline Lookup Helper
- * ============================================================================ */
-
-__attribute__((hot, always_inline, flatten))
-static inline uint32_t dir24_lookup_inline(const struct lpm_dir24_entry * restrict dir24,
-                                           const struct lpm_tbl8_entry * restrict tbl8,
-                                           const uint8_t * restrict addr)
-{
-    uint32_t dir24_idx = ((uint32_t)addr[0] << 16) | ((uint32_t)addr[1] << 8) | addr[2];
-    uint32_t data = dir24[dir24_idx].data;
-    
-    if (__builtin_expect(!(data & LPM_DIR24_EXT_FLAG), 1)) {
-        return (data & LPM_DIR24_VALID_FLAG) ? (data & LPM_DIR24_NH_MASK) : LPM_INVALID_NEXT_HOP;
-    }
-    
-    uint32_t tbl8_group = data & LPM_DIR24_NH_MASK;
-    uint32_t tbl8_idx = (tbl8_group << 8) | addr[3];
-    uint32_t tbl8_data = tbl8[tbl8_idx].data;
-    
-    return (tbl8_data & LPM_DIR24_VALID_FLAG) ? (tbl8_data & LPM_DIR24_NH_MASK) : LPM_INVALID_NEXT_HOP;
-}
-
 /* ============================================================================
  * Scalar Batch Implementation
  * ============================================================================ */
@@ -179,8 +154,11 @@ void lpm_lookup_batch_ipv4_dir24_avx2(const lpm_trie_t *trie, const uint32_t *ip
             __m256i tbl8_indices = _mm256_or_si256(
                 _mm256_slli_epi32(tbl8_groups, 8), last_bytes);
             
-            /* Gather tbl8 entries for ALL (we'll blend later) */
-            __m256i tbl8_data = _mm256_i32gather_epi32((const int *)tbl8, tbl8_indices, 4);
+            /* Gather tbl8 entries for extended lanes only: elsewhere the
+             * "group" is a next hop and may lie past the tbl8 array */
+            __m256i ext_blend_mask = _mm256_cmpeq_epi32(is_extended, ext_mask);
+            __m256i tbl8_data = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)tbl8,
+                                                            tbl8_indices, ext_blend_mask, 4);
             
             /* Extract tbl8 results */
             __m256i tbl8_results = _mm256_and_si256(tbl8_data, nh_mask);
@@ -189,7 +167,6 @@ void lpm_lookup_batch_ipv4_dir24_avx2(const lpm_trie_t *trie, const uint32_t *ip
                 _mm256_cmpeq_epi32(tbl8_valid, valid_mask));
             
             /* Blend: use tbl8_results where extended, otherwise keep dir24 results */
-            __m256i ext_blend_mask = _mm256_cmpeq_epi32(is_extended, ext_mask);
             results = _mm256_blendv_epi8(results, tbl8_results, ext_blend_mask);
         }
         
@@ -330,26 +307,30 @@ void lpm_lookup_batch_ipv4_dir24_avx512(const lpm_trie_t *trie, const uint32_t *
 
 typedef void (*lpm_dir24_batch_func_t)(const lpm_trie_t *, const uint32_t *, uint32_t *, size_t);
 
-EXPLICIT_RUNTIME_RESOLVER(lpm_dir24_batch_resolver)
+/* Kernel for a SIMD level; also used by the explicit selection API */
+lpm_batch_ipv4_kernel_t lpm_dir24_batch_kernel(simd_level_t level)
 {
-    simd_level_t level = LPM_DETECT_SIMD();
-    
     switch (level) {
     case SIMD_AVX512F:
-        return (void*)lpm_lookup_batch_ipv4_dir24_avx512;
+        return lpm_lookup_batch_ipv4_dir24_avx512;
     case SIMD_AVX2:
-        return (void*)lpm_lookup_batch_ipv4_dir24_avx2;
+        return lpm_lookup_batch_ipv4_dir24_avx2;
     case SIMD_AVX:
-        return (void*)lpm_lookup_batch_ipv4_dir24_avx;
+        return lpm_lookup_batch_ipv4_dir24_avx;
     case SIMD_SSE4_2:
-        return (void*)lpm_lookup_batch_ipv4_dir24_sse42;
+        return lpm_lookup_batch_ipv4_dir24_sse42;
     case SIMD_SSE2:
     case SIMD_SCALAR:
     default:
-        return (void*)lpm_lookup_batch_ipv4_dir24_scalar;
+        return lpm_lookup_batch_ipv4_dir24_scalar;
     }
 }
 
+EXPLICIT_RUNTIME_RESOLVER(lpm_dir24_batch_resolver)
+{
+    return (void*)lpm_dir24_batch_kernel(LPM_DETECT_SIMD());
+}
+
 /* Main batch lookup for uint32_t IPs */
 void lpm_lookup_batch_ipv4_dir24(const lpm_trie_t *trie, const uint32_t *addrs,
                                   uint32_t *next_hops, size_t count)
@@ -368,7 +349,7 @@ static void lpm_lookup_batch_dir24_ptrs_scalar(const lpm_trie_t *trie, const uin
     const uint32_t default_nh = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
     
     for (size_t i = 0; i < count; i++) {
-        uint32_t r = dir24_lookup_inline(dir24, tbl8, addrs[i]);
+        uint32_t r = lpm_dir24_lookup_inline(dir24, tbl8, addrs[i]);
         next_hops[i] = (r == LPM_INVALID_NEXT_HOP) ? default_nh : r;
     }
 }
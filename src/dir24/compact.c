@@ -0,0 +1,194 @@
+/*
+ * IPv4 DIR-24-8 Algorithm - Compact (2-byte entry) Lookups
+ *
+ * Same two-level layout as DIR-24-8 with 16-bit entries: bit 15 marks a tbl8
+ * extension, bits 0-14 hold the tbl8 group or next_hop + 1 (0 = no route).
+ * Storing next_hop + 1 makes "v - 1" map an empty entry straight to
+ * LPM_INVALID_NEXT_HOP, so decoding is one subtract.
+ *
+ * SIMD kernels use 32-bit gathers with scale 2 and keep the low half: each
+ * gather reads 2 bytes past the entry, which the tables are padded for.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef LPM_X86_ARCH
+#include <immintrin.h>
+#endif
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+/* ============================================================================
+ * Single Lookup
+ * ============================================================================ */
+
+uint32_t lpm_lookup_ipv4_dir24_compact(const lpm_trie_t *trie, uint32_t addr)
+{
+    if (!trie || !trie->dir24c_table) {
+        return LPM_INVALID_NEXT_HOP;
+    }
+
+    uint32_t result = lpm_dir24c_lookup_inline(trie->dir24c_table, trie->tbl8c_groups, addr);
+
+    /* Return default route if no match and default exists */
+    if (result == LPM_INVALID_NEXT_HOP && trie->has_default_route) {
+        return trie->default_next_hop;
+    }
+    return result;
+}
+
+/* ============================================================================
+ * Scalar Batch Implementation
+ * ============================================================================ */
+
+__attribute__((hot))
+void lpm_lookup_batch_ipv4_dir24_compact_scalar(const lpm_trie_t *trie, const uint32_t *ips,
+                                                 uint32_t *next_hops, size_t count)
+{
+    const uint16_t * restrict dir24 = trie->dir24c_table;
+    const uint16_t * restrict tbl8 = trie->tbl8c_groups;
+    const uint32_t default_nh = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+
+    for (size_t i = 0; i < count; i++) {
+        /* Prefetch next entry */
+        if (i + 8 < count) {
+            __builtin_prefetch(&dir24[ips[i + 8] >> 8], 0, 0);
+        }
+        uint32_t r = lpm_dir24c_lookup_inline(dir24, tbl8, ips[i]);
+        next_hops[i] = (r == LPM_INVALID_NEXT_HOP) ? default_nh : r;
+    }
+}
+
+/* ============================================================================
+ * AVX2 Batch - 8 lookups per iteration with 16-bit gathers
+ * ============================================================================ */
+
+__attribute__((hot, target("avx2")))
+void lpm_lookup_batch_ipv4_dir24_compact_avx2(const lpm_trie_t *trie, const uint32_t *ips,
+                                               uint32_t *next_hops, size_t count)
+{
+    const uint16_t * restrict dir24 = trie->dir24c_table;
+    const uint16_t * restrict tbl8 = trie->tbl8c_groups;
+    const uint32_t default_nh = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+
+    const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i ext_flag = _mm256_set1_epi32(LPM_DIR24C_EXT_FLAG);
+    const __m256i idx_mask = _mm256_set1_epi32(LPM_DIR24C_IDX_MASK);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i ones = _mm256_set1_epi32(1);
+    const __m256i invalid_vec = _mm256_set1_epi32((int)LPM_INVALID_NEXT_HOP);
+    const __m256i default_vec = _mm256_set1_epi32((int)default_nh);
+
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i ips_vec = _mm256_loadu_si256((const __m256i *)&ips[i]);
+
+        /* GATHER: 8 first-level entries, 2-byte stride */
+        __m256i idx = _mm256_srli_epi32(ips_vec, 8);
+        __m256i v = _mm256_and_si256(_mm256_i32gather_epi32((const int *)dir24, idx, 2), low16);
+
+        __m256i is_ext = _mm256_cmpeq_epi32(_mm256_and_si256(v, ext_flag), ext_flag);
+        if (!_mm256_testz_si256(is_ext, is_ext)) {
+            /* Masked gather of tbl8 entries for the extended lanes only */
+            __m256i t_idx = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(v, idx_mask), 8),
+                                            _mm256_and_si256(ips_vec, byte_mask));
+            __m256i t = _mm256_mask_i32gather_epi32(v, (const int *)tbl8, t_idx, is_ext, 2);
+            v = _mm256_blendv_epi8(v, _mm256_and_si256(t, low16), is_ext);
+        }
+
+        /* next_hop + 1 -> next_hop; empty (0) -> LPM_INVALID_NEXT_HOP */
+        __m256i results = _mm256_sub_epi32(v, ones);
+        __m256i need_default = _mm256_cmpeq_epi32(results, invalid_vec);
+        results = _mm256_blendv_epi8(results, default_vec, need_default);
+
+        _mm256_storeu_si256((__m256i *)&next_hops[i], results);
+    }
+
+    /* Scalar remainder */
+    for (; i < count; i++) {
+        uint32_t r = lpm_dir24c_lookup_inline(dir24, tbl8, ips[i]);
+        next_hops[i] = (r == LPM_INVALID_NEXT_HOP) ? default_nh : r;
+    }
+}
+
+/* ============================================================================
+ * AVX512 Batch - 16 lookups per iteration with 16-bit gathers
+ * ============================================================================ */
+
+__attribute__((hot, target("avx512f")))
+void lpm_lookup_batch_ipv4_dir24_compact_avx512(const lpm_trie_t *trie, const uint32_t *ips,
+                                                 uint32_t *next_hops, size_t count)
+{
+    const uint16_t * restrict dir24 = trie->dir24c_table;
+    const uint16_t * restrict tbl8 = trie->tbl8c_groups;
+    const uint32_t default_nh = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+
+    const __m512i low16 = _mm512_set1_epi32(0xFFFF);
+    const __m512i ext_flag = _mm512_set1_epi32(LPM_DIR24C_EXT_FLAG);
+    const __m512i idx_mask = _mm512_set1_epi32(LPM_DIR24C_IDX_MASK);
+    const __m512i byte_mask = _mm512_set1_epi32(0xFF);
+    const __m512i ones = _mm512_set1_epi32(1);
+    const __m512i invalid_vec = _mm512_set1_epi32((int)LPM_INVALID_NEXT_HOP);
+    const __m512i default_vec = _mm512_set1_epi32((int)default_nh);
+
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m512i ips_vec = _mm512_loadu_si512(&ips[i]);
+
+        /* GATHER: 16 first-level entries, 2-byte stride */
+        __m512i idx = _mm512_srli_epi32(ips_vec, 8);
+        __m512i v = _mm512_and_si512(_mm512_i32gather_epi32(idx, dir24, 2), low16);
+
+        __mmask16 ext_bits = _mm512_test_epi32_mask(v, ext_flag);
+        if (ext_bits) {
+            __m512i t_idx = _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(v, idx_mask), 8),
+                                            _mm512_and_si512(ips_vec, byte_mask));
+            __m512i t = _mm512_mask_i32gather_epi32(v, ext_bits, t_idx, tbl8, 2);
+            v = _mm512_mask_and_epi32(v, ext_bits, t, low16);
+        }
+
+        __m512i results = _mm512_sub_epi32(v, ones);
+        __mmask16 need_default = _mm512_cmpeq_epi32_mask(results, invalid_vec);
+        results = _mm512_mask_blend_epi32(need_default, results, default_vec);
+
+        _mm512_storeu_si512(&next_hops[i], results);
+    }
+
+    /* Handle remaining with AVX2 */
+    if (i < count) {
+        lpm_lookup_batch_ipv4_dir24_compact_avx2(trie, &ips[i], &next_hops[i], count - i);
+    }
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+/* Kernel for a SIMD level; also used by the explicit selection API */
+lpm_batch_ipv4_kernel_t lpm_dir24_compact_batch_kernel(simd_level_t level)
+{
+    switch (level) {
+    case SIMD_AVX512F:
+        return lpm_lookup_batch_ipv4_dir24_compact_avx512;
+    case SIMD_AVX2:
+        return lpm_lookup_batch_ipv4_dir24_compact_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return lpm_lookup_batch_ipv4_dir24_compact_scalar;
+    }
+}
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_dir24_compact_batch_resolver)
+{
+    return (void*)lpm_dir24_compact_batch_kernel(LPM_DETECT_SIMD());
+}
+
+void lpm_lookup_batch_ipv4_dir24_compact(const lpm_trie_t *trie, const uint32_t *addrs,
+                                         uint32_t *next_hops, size_t count)
+    __attribute__((ifunc("lpm_dir24_compact_batch_resolver")));
@@ -3,7 +3,8 @@
  * Create, Add, Delete operations for IPv4 with DIR-24-8 table
  *
  * Uses 24-8 stride pattern for IPv4 with compact 4-byte entries:
- * - First 24 bits: Single table lookup (16.7M entries, 64MB)
+ * - First 24 bits: Single table lookup (16.7M entries, 64MB; 32MB in the
+ *   2-byte compact variant)
  * - Last 8 bits: 8-bit table for longer routes (256 entries per group)
  * - Total: 1-2 memory accesses for any lookup!
  */
@@ -17,13 +18,12 @@
 
 /* Default number of tbl8 groups to allocate */
 #define LPM_TBL8_DEFAULT_GROUPS 256
-#define LPM_TBL8_GROUP_ENTRIES 256
 
 /* ============================================================================
  * Trie Creation
  * ============================================================================ */
 
-lpm_trie_t *lpm_create_ipv4_dir24(void)
+static lpm_trie_t *dir24_create(bool compact)
 {
     lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
     if (!t) { return NULL; }
@@ -34,29 +34,53 @@ lpm_trie_t *lpm_create_ipv4_dir24(void)
     t->default_next_hop = LPM_INVALID_NEXT_HOP;
     t->use_ipv6_wide_stride = false;
     t->use_ipv4_dir24 = true;  /* Enable DIR-24-8 */
+    t->tbl8_num_groups = LPM_TBL8_DEFAULT_GROUPS;
+    t->tbl8_groups_used = 0;
+    size_t tbl8_entries = (size_t)t->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
     
-    /* Allocate DIR-24 table (24-bit direct lookup table) - 64MB with 4-byte entries */
-    size_t dir24_size = LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry);
-    t->dir24_table = (struct lpm_dir24_entry *)aligned_alloc(LPM_CACHE_LINE_SIZE, dir24_size);
-    if (!t->dir24_table) {
-        free(t);
-        return NULL;
+    if (compact) {
+        /* 2-byte entries: 32MB first level; 0 = no route */
+        size_t dir24_size = LPM_IPV4_DIR24_SIZE * sizeof(uint16_t) + LPM_DIR24C_PAD;
+        size_t tbl8_size = tbl8_entries * sizeof(uint16_t) + LPM_DIR24C_PAD;
+        t->dir24c_table = (uint16_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, dir24_size);
+        t->tbl8c_groups = (uint16_t *)malloc(tbl8_size);
+        if (!t->dir24c_table || !t->tbl8c_groups) {
+            lpm_destroy(t);
+            return NULL;
+        }
+        memset(t->dir24c_table, 0, dir24_size);
+        memset(t->tbl8c_groups, 0, tbl8_size);
+    } else {
+        /* Allocate DIR-24 table (24-bit direct lookup table) - 64MB with 4-byte entries */
+        size_t dir24_size = LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry);
+        t->dir24_table = (struct lpm_dir24_entry *)aligned_alloc(LPM_CACHE_LINE_SIZE, dir24_size);
+        if (!t->dir24_table) {
+            free(t);
+            return NULL;
+        }
+        
+        /* Initialize all DIR24 entries to invalid (0) */
+        memset(t->dir24_table, 0, dir24_size);
+        
+        /* Allocate tbl8 groups (for /25-/32 prefixes) */
+        size_t tbl8_size = tbl8_entries * sizeof(struct lpm_tbl8_entry);
+        t->tbl8_groups = (struct lpm_tbl8_entry *)aligned_alloc(LPM_CACHE_LINE_SIZE, tbl8_size);
+        if (!t->tbl8_groups) {
+            free(t->dir24_table);
+            free(t);
+            return NULL;
+        }
+        memset(t->tbl8_groups, 0, tbl8_size);
     }
     
-    /* Initialize all DIR24 entries to invalid (0) */
-    memset(t->dir24_table, 0, dir24_size);
-    
-    /* Allocate tbl8 groups (for /25-/32 prefixes) */
-    t->tbl8_num_groups = LPM_TBL8_DEFAULT_GROUPS;
-    t->tbl8_groups_used = 0;
-    size_t tbl8_size = (size_t)t->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES * sizeof(struct lpm_tbl8_entry);
-    t->tbl8_groups = (struct lpm_tbl8_entry *)aligned_alloc(LPM_CACHE_LINE_SIZE, tbl8_size);
-    if (!t->tbl8_groups) {
-        free(t->dir24_table);
-        free(t);
+    /* Per-slot prefix lengths and the rule store keep updates covering-correct */
+    t->dir24_depth = (uint8_t *)calloc(LPM_IPV4_DIR24_SIZE, 1);
+    t->tbl8_depth = (uint8_t *)calloc(tbl8_entries, 1);
+    t->rules = lpm_rules_create();
+    if (!t->dir24_depth || !t->tbl8_depth || !t->rules) {
+        lpm_destroy(t);
         return NULL;
     }
-    memset(t->tbl8_groups, 0, tbl8_size);
     
     /* Allocate hot cache */
     size_t cache_size = LPM_HOT_CACHE_SIZE * sizeof(struct lpm_cache_entry);
@@ -65,213 +89,444 @@ lpm_trie_t *lpm_create_ipv4_dir24(void)
         memset(t->hot_cache, 0, cache_size);
     }
     
+    lpm_dispatch_init(t);
     return t;
 }
 
+lpm_trie_t *lpm_create_ipv4_dir24(void)
+{
+    return dir24_create(false);
+}
+
+lpm_trie_t *lpm_create_ipv4_dir24_compact(void)
+{
+    return dir24_create(true);
+}
+
 /* ============================================================================
- * TBL8 Group Allocation
+ * Entry Access
+ * Updates work on the 4-byte entry format; the compact variant converts on
+ * load and store.
  * ============================================================================ */
 
-static int32_t tbl8_group_alloc(lpm_trie_t *trie)
+static inline uint16_t compact_encode(uint32_t data)
 {
-    if (trie->tbl8_groups_used >= trie->tbl8_num_groups) {
-        /* Need to grow the tbl8 array */
-        uint32_t new_groups = trie->tbl8_num_groups * 2;
-        struct lpm_tbl8_entry *new_tbl8 = realloc(trie->tbl8_groups,
-            (size_t)new_groups * LPM_TBL8_GROUP_ENTRIES * sizeof(struct lpm_tbl8_entry));
-        if (!new_tbl8) { return -1; }
-        
-        /* Initialize new groups */
-        memset(&new_tbl8[(size_t)trie->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES], 0,
-               (size_t)(new_groups - trie->tbl8_num_groups) * LPM_TBL8_GROUP_ENTRIES * sizeof(struct lpm_tbl8_entry));
-        
-        trie->tbl8_groups = new_tbl8;
-        trie->tbl8_num_groups = new_groups;
+    if (data & LPM_DIR24_EXT_FLAG) {
+        return (uint16_t)(LPM_DIR24C_EXT_FLAG | (data & LPM_DIR24C_IDX_MASK));
+    }
+    return (data & LPM_DIR24_VALID_FLAG) ? (uint16_t)((data & LPM_DIR24_NH_MASK) + 1) : 0;
+}
+
+static inline uint32_t slot_load(const lpm_trie_t *trie, uint32_t idx)
+{
+    if (!trie->dir24c_table) {
+        return trie->dir24_table[idx].data;
+    }
+    uint16_t v = trie->dir24c_table[idx];
+    if (v & LPM_DIR24C_EXT_FLAG) {
+        return LPM_DIR24_VALID_FLAG | LPM_DIR24_EXT_FLAG | (v & LPM_DIR24C_IDX_MASK);
+    }
+    return v ? (LPM_DIR24_VALID_FLAG | (uint32_t)(v - 1)) : 0;
+}
+
+static inline void slot_store(lpm_trie_t *trie, uint32_t idx, uint32_t data)
+{
+    if (trie->dir24c_table) {
+        trie->dir24c_table[idx] = compact_encode(data);
+    } else {
+        trie->dir24_table[idx].data = data;
     }
+}
+
+static inline uint32_t tbl8_load(const lpm_trie_t *trie, size_t idx)
+{
+    if (!trie->tbl8c_groups) {
+        return trie->tbl8_groups[idx].data;
+    }
+    uint16_t v = trie->tbl8c_groups[idx];
+    return v ? (LPM_DIR24_VALID_FLAG | (uint32_t)(v - 1)) : 0;
+}
+
+static inline void tbl8_store(lpm_trie_t *trie, size_t idx, uint32_t data)
+{
+    if (trie->tbl8c_groups) {
+        trie->tbl8c_groups[idx] = compact_encode(data);
+    } else {
+        trie->tbl8_groups[idx].data = data;
+    }
+}
+
+/* ============================================================================
+ * TBL8 Group Allocation
+ * ============================================================================ */
+
+static int tbl8_grow_compact(lpm_trie_t *trie, uint32_t new_groups)
+{
+    size_t entries = (size_t)new_groups * LPM_TBL8_GROUP_ENTRIES;
+    uint16_t *new_tbl8 = realloc(trie->tbl8c_groups, entries * sizeof(uint16_t) + LPM_DIR24C_PAD);
+    if (!new_tbl8) { return -1; }
+    trie->tbl8c_groups = new_tbl8;
+    
+    size_t old_entries = (size_t)trie->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
+    memset(&new_tbl8[old_entries], 0, (entries - old_entries) * sizeof(uint16_t) + LPM_DIR24C_PAD);
+    return 0;
+}
+
+static int tbl8_grow(lpm_trie_t *trie, uint32_t new_groups)
+{
+    size_t entries = (size_t)new_groups * LPM_TBL8_GROUP_ENTRIES;
+    struct lpm_tbl8_entry *new_tbl8 = realloc(trie->tbl8_groups, entries * sizeof(struct lpm_tbl8_entry));
+    if (!new_tbl8) { return -1; }
+    trie->tbl8_groups = new_tbl8;
+    
+    size_t old_entries = (size_t)trie->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
+    memset(&new_tbl8[old_entries], 0, (entries - old_entries) * sizeof(struct lpm_tbl8_entry));
+    return 0;
+}
+
+int lpm_dir24_tbl8_grow(lpm_trie_t *trie)
+{
+    uint32_t new_groups = trie->tbl8_num_groups * 2;
+    if (trie->tbl8c_groups && new_groups > LPM_DIR24C_MAX_GROUPS) { return -1; }
+    
+    int rc = trie->tbl8c_groups ? tbl8_grow_compact(trie, new_groups) : tbl8_grow(trie, new_groups);
+    if (rc < 0) { return -1; }
+    
+    uint8_t *new_depth = realloc(trie->tbl8_depth, (size_t)new_groups * LPM_TBL8_GROUP_ENTRIES);
+    if (!new_depth) { return -1; }
+    trie->tbl8_depth = new_depth;
+    
+    /* Initialize new groups */
+    size_t old_entries = (size_t)trie->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
+    size_t new_entries = (size_t)(new_groups - trie->tbl8_num_groups) * LPM_TBL8_GROUP_ENTRIES;
+    memset(&new_depth[old_entries], 0, new_entries);
+    
+    trie->tbl8_num_groups = new_groups;
+    return 0;
+}
+
+static int32_t tbl8_group_alloc(lpm_trie_t *trie, uint32_t idx)
+{
+    /* Sharded writers take groups from their shard's reservation */
+    if (trie->shards) { return lpm_shard_tbl8_alloc(trie, idx); }
     
+    if (trie->tbl8c_groups && trie->tbl8_groups_used >= LPM_DIR24C_MAX_GROUPS) { return -1; }
+    
+    if (trie->tbl8_groups_used >= trie->tbl8_num_groups && lpm_dir24_tbl8_grow(trie) < 0) {
+        return -1;
+    }
     return (int32_t)trie->tbl8_groups_used++;
 }
 
 /* ============================================================================
- * Add Prefix
+ * Resumable Add/Delete
+ *
+ * Every slot and tbl8 entry carries the length of the prefix that wrote it.
+ * An add of /len overwrites only entries written by prefixes of length <= len,
+ * so more specific routes survive; a delete rewrites only entries of exactly
+ * /len, with the longest remaining covering rule from the rule store.
  * ============================================================================ */
 
-int lpm_add_ipv4_dir24(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+static inline uint32_t dir24_index(const uint8_t *prefix, uint8_t prefix_len)
 {
-    if (!trie || !prefix || prefix_len > 32 || !trie->dir24_table) { return -1; }
-    if (next_hop & 0xC0000000) { return -1; }  /* Next hop must fit in 30 bits */
-    
-    /* Handle default route */
-    if (prefix_len == 0) {
-        trie->has_default_route = true;
-        trie->default_next_hop = next_hop;
-        trie->num_prefixes++;
-        return 0;
+    uint32_t idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8);
+    if (prefix_len > 16) {
+        idx |= prefix[2];
     }
+    if (prefix_len < 24) {
+        idx &= ~((1U << (24 - prefix_len)) - 1);
+    }
+    return idx;
+}
+
+static inline bool op_matches(const lpm_dir24_op_t *op, uint8_t depth)
+{
+    return depth >= op->depth_lo && depth <= op->depth_hi;
+}
+
+/* Rewrite the matching entries [first, first + count) of one tbl8 group */
+static void tbl8_apply(lpm_trie_t *trie, uint32_t group, uint32_t first, uint32_t count,
+                       const lpm_dir24_op_t *op)
+{
+    size_t base = (size_t)group * LPM_TBL8_GROUP_ENTRIES;
+    uint8_t *depth = &trie->tbl8_depth[base];
     
-    /* Routes up to /24: Store directly in DIR24 table */
-    if (prefix_len <= 24) {
-        uint32_t base_idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8);
-        if (prefix_len >= 16) {
-            base_idx |= prefix[2];
+    for (uint32_t i = first; i < first + count; i++) {
+        if (op_matches(op, depth[i])) {
+            tbl8_store(trie, base + i, op->data);
+            depth[i] = op->depth;
         }
-        
-        /* Mask off bits beyond prefix length */
-        if (prefix_len < 24) {
-            uint32_t mask = ~((1U << (24 - prefix_len)) - 1);
-            base_idx &= mask;
+    }
+}
+
+/* Give a dir24 slot its own tbl8 group, inheriting the slot's route */
+static int32_t dir24_extend(lpm_trie_t *trie, uint32_t idx)
+{
+    int32_t group = tbl8_group_alloc(trie, idx);
+    if (group < 0) { return -1; }
+    
+    uint32_t data = slot_load(trie, idx);
+    size_t base = (size_t)group * LPM_TBL8_GROUP_ENTRIES;
+    for (int i = 0; i < LPM_TBL8_GROUP_ENTRIES; i++) {
+        tbl8_store(trie, base + i, data);
+    }
+    memset(&trie->tbl8_depth[base], trie->dir24_depth[idx], LPM_TBL8_GROUP_ENTRIES);
+    
+    /* The group must be complete before lookups can reach it */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot_store(trie, idx, LPM_DIR24_VALID_FLAG | LPM_DIR24_EXT_FLAG | (uint32_t)group);
+    return group;
+}
+
+int lpm_dir24_op_begin(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t next_hop, bool del, lpm_dir24_op_t *op)
+{
+    if (!trie || !prefix || !op || prefix_len > 32 || !trie->rules) { return -1; }
+    if (!trie->dir24_table && !trie->dir24c_table) { return -1; }
+    if (!del && next_hop > lpm_dir24_max_next_hop(trie)) { return -1; }
+    
+    memset(op, 0, sizeof(*op));
+    
+    /* Routes longer than /24 need their slot extended before anything changes */
+    int32_t group = -1;
+    uint32_t idx = 0;
+    if (prefix_len > 24) {
+        idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8) | prefix[2];
+        uint32_t data = slot_load(trie, idx);
+        if (data & LPM_DIR24_EXT_FLAG) {
+            group = (int32_t)(data & LPM_DIR24_NH_MASK);
+        } else if (!del) {
+            group = dir24_extend(trie, idx);
+            if (group < 0) { return -1; }
         }
+    }
+    
+    /* Sharded writers keep the rules of each shard apart and update the
+     * prefix count concurrently */
+    struct lpm_rule_table *rt = trie->shards ? lpm_shard_rules(trie, prefix, prefix_len) : trie->rules;
+    if (del) {
+        if (lpm_rules_remove(rt, prefix, prefix_len) < 0) { return -1; }
+        __atomic_sub_fetch(&trie->num_prefixes, 1, __ATOMIC_RELAXED);
         
-        /* Calculate how many entries to fill (prefix expansion) */
-        uint32_t count = 1U << (24 - prefix_len);
-        
-        /* Fill all matching entries */
-        for (uint32_t i = 0; i < count; i++) {
-            uint32_t idx = base_idx + i;
-            struct lpm_dir24_entry *entry = &trie->dir24_table[idx];
-            
-            /* Only overwrite if this is a more specific prefix or not extended */
-            if (!(entry->data & LPM_DIR24_EXT_FLAG)) {
-                entry->data = LPM_DIR24_VALID_FLAG | next_hop;
-            }
-        }
+        /* Entries of this prefix fall back to the longest covering rule */
+        const struct lpm_rule *parent = trie->shards ? lpm_shard_find_parent(trie, prefix, prefix_len)
+                                                     : lpm_rules_find_parent(rt, prefix, prefix_len);
+        op->data = parent ? (LPM_DIR24_VALID_FLAG | parent->next_hop) : 0;
+        op->depth = parent ? parent->len : 0;
+        op->depth_lo = prefix_len;
+        op->depth_hi = prefix_len;
+    } else {
+        bool existed;
+        if (lpm_rules_insert(rt, prefix, prefix_len, next_hop, &existed) < 0) { return -1; }
+        if (!existed) { __atomic_add_fetch(&trie->num_prefixes, 1, __ATOMIC_RELAXED); }
         
-        trie->num_prefixes++;
+        op->data = LPM_DIR24_VALID_FLAG | next_hop;
+        op->depth = prefix_len;
+        op->depth_lo = 0;
+        op->depth_hi = prefix_len;
+    }
+    
+    /* Handle default route */
+    if (prefix_len == 0) {
+        trie->has_default_route = !del;
+        trie->default_next_hop = del ? LPM_INVALID_NEXT_HOP : next_hop;
         return 0;
     }
     
-    /* Routes longer than /24: Need tbl8 */
-    uint32_t dir24_idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8) | prefix[2];
-    struct lpm_dir24_entry *dir_entry = &trie->dir24_table[dir24_idx];
+    /* Routes longer than /24: at most 256 entries, done in one go */
+    if (prefix_len > 24) {
+        if (group >= 0) {
+            uint32_t count = 1U << (32 - prefix_len);
+            tbl8_apply(trie, (uint32_t)group, prefix[3] & ~(count - 1), count, op);
+        }
+        return 0;
+    }
     
-    uint32_t tbl8_group;
+    /* Routes up to /24: 2^(24 - len) slots, left to lpm_dir24_op_run() */
+    op->base = dir24_index(prefix, prefix_len);
+    op->count = 1U << (24 - prefix_len);
+    return 1;
+}
+
+uint32_t lpm_dir24_op_run(lpm_trie_t *trie, lpm_dir24_op_t *op, uint32_t budget)
+{
+    uint32_t done = 0;
     
-    /* Check if we need to allocate a tbl8 group */
-    if (!(dir_entry->data & LPM_DIR24_EXT_FLAG)) {
-        /* Allocate new tbl8 group */
-        int32_t new_group = tbl8_group_alloc(trie);
-        if (new_group < 0) { return -1; }
-        tbl8_group = new_group;
+    while (op->cursor < op->count && done < budget) {
+        uint32_t idx = op->base + op->cursor++;
+        uint32_t data = slot_load(trie, idx);
         
-        /* If dir24 entry had a valid next hop, copy it to all tbl8 entries */
-        struct lpm_tbl8_entry *tbl8 = &trie->tbl8_groups[(size_t)tbl8_group * LPM_TBL8_GROUP_ENTRIES];
-        if (dir_entry->data & LPM_DIR24_VALID_FLAG) {
-            uint32_t parent_nh = dir_entry->data & LPM_DIR24_NH_MASK;
-            for (int i = 0; i < LPM_TBL8_GROUP_ENTRIES; i++) {
-                tbl8[i].data = LPM_DIR24_VALID_FLAG | parent_nh;
+        if (data & LPM_DIR24_EXT_FLAG) {
+            /* Longer routes live below this slot: update only what they leave */
+            tbl8_apply(trie, data & LPM_DIR24_NH_MASK, 0, LPM_TBL8_GROUP_ENTRIES, op);
+            done += LPM_TBL8_GROUP_ENTRIES;
+        } else {
+            if (op_matches(op, trie->dir24_depth[idx])) {
+                slot_store(trie, idx, op->data);
+                trie->dir24_depth[idx] = op->depth;
             }
+            done++;
         }
-        
-        /* Update dir24 entry to point to tbl8 group */
-        dir_entry->data = LPM_DIR24_VALID_FLAG | LPM_DIR24_EXT_FLAG | tbl8_group;
-    } else {
-        tbl8_group = dir_entry->data & LPM_DIR24_NH_MASK;
+    }
+    return done;
+}
+
+/* ============================================================================
+ * Add/Delete Prefix
+ * ============================================================================ */
+
+static int dir24_update(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                        uint32_t next_hop, bool del)
+{
+    if (!trie || !prefix || prefix_len > 32) { return -1; }
+    if (!trie->dir24_table && !trie->dir24c_table) { return -1; }
+    if (trie->shards) {
+        int rc = lpm_shard_update(trie, prefix, prefix_len, next_hop, del);
+        lpm_generation_bump(trie);
+        return rc;
     }
     
-    /* Add route to tbl8 */
-    struct lpm_tbl8_entry *tbl8 = &trie->tbl8_groups[(size_t)tbl8_group * LPM_TBL8_GROUP_ENTRIES];
-    uint8_t last_byte = prefix[3];
-    uint8_t remaining_bits = prefix_len - 24;  /* 1-8 bits */
+    /* Queued incremental updates were issued first and must land first */
+    lpm_update_flush(trie);
     
-    if (remaining_bits == 8) {
-        /* Exact /32 route */
-        tbl8[last_byte].data = LPM_DIR24_VALID_FLAG | next_hop;
-    } else {
-        /* Partial last byte - expand to all matching entries */
-        uint8_t mask = ~((1 << (8 - remaining_bits)) - 1);
-        uint8_t base = last_byte & mask;
-        uint32_t count = 1 << (8 - remaining_bits);
-        
-        for (uint32_t i = 0; i < count; i++) {
-            uint8_t idx = base + i;
-            tbl8[idx].data = LPM_DIR24_VALID_FLAG | next_hop;
-        }
+    lpm_dir24_op_t op;
+    int rc = lpm_dir24_op_begin(trie, prefix, prefix_len, next_hop, del, &op);
+    if (rc > 0) {
+        lpm_dir24_op_run(trie, &op, UINT32_MAX);
+        lpm_generation_bump(trie);
+        rc = 0;
     }
-    
-    trie->num_prefixes++;
-    return 0;
+    return rc;
+}
+
+int lpm_add_ipv4_dir24(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    return dir24_update(trie, prefix, prefix_len, next_hop, false);
+}
+
+int lpm_delete_ipv4_dir24(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    return dir24_update(trie, prefix, prefix_len, 0, true);
 }
 
 /* ============================================================================
- * Delete Prefix
+ * Bulk Build
+ *
+ * With routes in ascending length order every entry a route covers was last
+ * written by a route no longer than it, so the add rule (overwrite depth <=
+ * len) always holds and the entries can be filled unconditionally. All routes
+ * up to /24 precede the first tbl8 group, so no slot is extended while they
+ * are written.
  * ============================================================================ */
 
-int lpm_delete_ipv4_dir24(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+static void dir24_fill(lpm_trie_t *trie, uint32_t base, uint32_t count, uint32_t data, uint8_t depth)
 {
-    if (!trie || !prefix || prefix_len > 32 || !trie->dir24_table) { return -1; }
+    if (trie->dir24c_table) {
+        uint16_t v = compact_encode(data);
+        for (uint32_t i = base; i < base + count; i++) {
+            trie->dir24c_table[i] = v;
+        }
+    } else {
+        for (uint32_t i = base; i < base + count; i++) {
+            trie->dir24_table[i].data = data;
+        }
+    }
+    memset(&trie->dir24_depth[base], depth, count);
+}
+
+int lpm_dir24_build(lpm_trie_t *trie, const struct lpm_route *routes, size_t count,
+                    uint64_t *failed)
+{
+    if (!trie || (!trie->dir24_table && !trie->dir24c_table) || !trie->rules) { return -1; }
     
-    /* Handle default route */
-    if (prefix_len == 0) {
-        trie->has_default_route = false;
-        trie->default_next_hop = LPM_INVALID_NEXT_HOP;
-        if (trie->num_prefixes > 0) { trie->num_prefixes--; }
-        return 0;
+    lpm_update_flush(trie);
+    if (trie->shards || trie->num_prefixes || trie->tbl8_groups_used || trie->has_default_route) {
+        return -1;
     }
     
-    /* Routes up to /24: Delete from DIR24 table */
-    if (prefix_len <= 24) {
-        uint32_t base_idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8);
-        if (prefix_len >= 16) {
-            base_idx |= prefix[2];
+    /* Best effort: the inserts below grow the store themselves if this fails */
+    lpm_rules_reserve(trie->rules, count);
+    
+    const uint32_t max_nh = lpm_dir24_max_next_hop(trie);
+    for (size_t r = 0; r < count; r++) {
+        const struct lpm_route *rt = &routes[r];
+        if (rt->len > 32 || rt->next_hop > max_nh) {
+            (*failed)++;
+            continue;
         }
         
-        /* Mask off bits beyond prefix length */
-        if (prefix_len < 24) {
-            uint32_t mask = ~((1U << (24 - prefix_len)) - 1);
-            base_idx &= mask;
+        int32_t group = -1;
+        uint32_t idx = 0;
+        if (rt->len > 24) {
+            idx = ((uint32_t)rt->prefix[0] << 16) | ((uint32_t)rt->prefix[1] << 8) | rt->prefix[2];
+            uint32_t data = slot_load(trie, idx);
+            group = (data & LPM_DIR24_EXT_FLAG) ? (int32_t)(data & LPM_DIR24_NH_MASK)
+                                                : dir24_extend(trie, idx);
+            if (group < 0) {
+                (*failed)++;
+                continue;
+            }
         }
         
-        /* Calculate how many entries to clear (prefix expansion) */
-        uint32_t count = 1U << (24 - prefix_len);
+        bool existed;
+        if (lpm_rules_insert(trie->rules, rt->prefix, rt->len, rt->next_hop, &existed) < 0) {
+            (*failed)++;
+            continue;
+        }
+        if (!existed) { trie->num_prefixes++; }
         
-        /* Clear all matching entries */
-        for (uint32_t i = 0; i < count; i++) {
-            uint32_t idx = base_idx + i;
-            struct lpm_dir24_entry *entry = &trie->dir24_table[idx];
-            
-            /* Only clear if not extended to tbl8 */
-            if (!(entry->data & LPM_DIR24_EXT_FLAG)) {
-                entry->data = 0;  /* Clear both valid flag and next hop */
+        const uint32_t data = LPM_DIR24_VALID_FLAG | rt->next_hop;
+        if (rt->len == 0) {
+            trie->has_default_route = true;
+            trie->default_next_hop = rt->next_hop;
+        } else if (rt->len <= 24) {
+            dir24_fill(trie, dir24_index(rt->prefix, rt->len), 1U << (24 - rt->len), data, rt->len);
+        } else {
+            uint32_t n = 1U << (32 - rt->len);
+            size_t base = (size_t)group * LPM_TBL8_GROUP_ENTRIES + (rt->prefix[3] & ~(n - 1));
+            for (size_t i = base; i < base + n; i++) {
+                tbl8_store(trie, i, data);
             }
+            memset(&trie->tbl8_depth[base], rt->len, n);
         }
-        
-        if (trie->num_prefixes > 0) { trie->num_prefixes--; }
-        return 0;
-    }
-    
-    /* Routes longer than /24: Delete from tbl8 */
-    uint32_t dir24_idx = ((uint32_t)prefix[0] << 16) | ((uint32_t)prefix[1] << 8) | prefix[2];
-    struct lpm_dir24_entry *dir_entry = &trie->dir24_table[dir24_idx];
-    
-    /* Check if this entry uses tbl8 */
-    if (!(dir_entry->data & LPM_DIR24_EXT_FLAG)) {
-        /* No tbl8 group - just clear the dir24 entry */
-        dir_entry->data = 0;
-        if (trie->num_prefixes > 0) { trie->num_prefixes--; }
-        return 0;
     }
     
-    uint32_t tbl8_group = dir_entry->data & LPM_DIR24_NH_MASK;
-    struct lpm_tbl8_entry *tbl8 = &trie->tbl8_groups[(size_t)tbl8_group * LPM_TBL8_GROUP_ENTRIES];
-    
-    uint8_t last_byte = prefix[3];
-    uint8_t remaining_bits = prefix_len - 24;  /* 1-8 bits */
-    
-    if (remaining_bits == 8) {
-        /* Exact /32 route */
-        tbl8[last_byte].data = 0;
+    lpm_generation_bump(trie);
+    return 0;
+}
+
+/* ============================================================================
+ * Next-Hop Rewrite
+ * ============================================================================ */
+
+void lpm_dir24_repoint(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t old_nh, uint32_t new_nh)
+{
+    const uint32_t old_data = LPM_DIR24_VALID_FLAG | old_nh;
+    const uint32_t new_data = LPM_DIR24_VALID_FLAG | new_nh;
+    uint32_t base, count, first = 0, entries = LPM_TBL8_GROUP_ENTRIES;
+
+    if (prefix_len > 24) {
+        base = dir24_index(prefix, 24);
+        count = 1;
+        entries = 1U << (32 - prefix_len);
+        first = prefix[3] & ~(entries - 1);
     } else {
-        /* Partial last byte - clear all matching entries */
-        uint8_t mask = ~((1 << (8 - remaining_bits)) - 1);
-        uint8_t base = last_byte & mask;
-        uint32_t count = 1 << (8 - remaining_bits);
-        
-        for (uint32_t i = 0; i < count; i++) {
-            uint8_t idx = base + i;
-            tbl8[idx].data = 0;
+        base = dir24_index(prefix, prefix_len);
+        count = 1U << (24 - prefix_len);
+    }
+
+    for (uint32_t idx = base; idx < base + count; idx++) {
+        uint32_t data = slot_load(trie, idx);
+        if (data & LPM_DIR24_EXT_FLAG) {
+            size_t g = (size_t)(data & LPM_DIR24_NH_MASK) * LPM_TBL8_GROUP_ENTRIES;
+            for (size_t i = g + first; i < g + first + entries; i++) {
+                if (tbl8_load(trie, i) == old_data) {
+                    tbl8_store(trie, i, new_data);
+                }
+            }
+        } else if (data == old_data) {
+            slot_store(trie, idx, new_data);
         }
     }
-    
-    if (trie->num_prefixes > 0) { trie->num_prefixes--; }
-    return 0;
 }
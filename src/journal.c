@@ -0,0 +1,846 @@
+/*
+ * liblpm Update Journal
+ *
+ * lpm_enable_journal() makes a trie durable across restarts. Every update
+ * that lpm_add()/lpm_delete() (and their incremental forms, and
+ * lpm_replace_next_hop()) apply is appended to a write-ahead journal, and
+ * lpm_snapshot() writes the table image itself so the journal can start
+ * over. lpm_recover() maps the last snapshot, copies the engine's arrays
+ * back in place and replays only the journal records written after it, so
+ * restart time follows the churn since the snapshot, not the table size.
+ *
+ * Files, for a journal at path P:
+ * - P.snap: header (trie scalars, side-structure headers, section
+ *   directory), then one section per engine array at a 4KB-aligned offset.
+ *   The image is only meaningful to the same build of the library; the
+ *   header carries the structure sizes and is refused otherwise.
+ * - P.wal: header with the LSN the journal starts after, then frames of
+ *   {payload length, CRC-32C, first LSN} followed by packed records. A frame
+ *   with a short payload or a bad CRC is a torn tail and ends the journal.
+ *
+ * Records get consecutive LSNs. The snapshot stores the LSN it includes, so
+ * records at or below it are skipped on replay. This makes the switch to a
+ * new journal safe at any point: the snapshot is renamed into place first,
+ * then the new journal.
+ *
+ * Group commit: records collect in a buffer. The buffer is written as one
+ * frame and fdatasync()ed once sync_records records are pending or the
+ * oldest is sync_us old, or on lpm_journal_sync(). The age is checked on
+ * append and by lpm_journal_poll() and lpm_update_step(), so the tail of a
+ * burst is committed even if no further update arrives.
+ * A write error latches: the journal stops recording and lpm_journal_sync()
+ * fails until lpm_snapshot() starts a new one. Updates themselves never
+ * fail because of the journal.
+ *
+ * Snapshots write the whole table, so they never run inside an update.
+ * Once snapshot_records records are pending, lpm_journal_poll() takes one;
+ * the async writer does so when its queue runs empty.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_JOURNAL_VERSION        1
+#define LPM_JOURNAL_BUF_SIZE       (64 * 1024)
+#define LPM_JOURNAL_MAX_RECORD     (2 + 4 + 4 + 16)
+#define LPM_SNAP_ALIGN             4096
+#define LPM_SNAP_MAX_SECTIONS      16
+
+#define LPM_JOURNAL_DEFAULT_SYNC_RECORDS     1024
+#define LPM_JOURNAL_DEFAULT_SYNC_US          10000
+#define LPM_JOURNAL_DEFAULT_SNAPSHOT_RECORDS (1U << 20)
+
+static const char snap_magic[8] = "LPMSNAP";
+static const char wal_magic[8] = "LPMWAL";
+
+enum journal_engine {
+    ENGINE_NONE = 0,
+    ENGINE_DIR24,
+    ENGINE_DIR24C,
+    ENGINE_STRIDE4,
+    ENGINE_STRIDE6,
+    ENGINE_WIDE16,
+    ENGINE_SMALL,
+};
+
+#define SNAP_FLAG_NH_INDEX  (1U << 0)
+
+struct lpm_journal {
+    int fd;
+    char *wal_path;
+    char *snap_path;
+    lpm_journal_config_t cfg;
+    uint64_t lsn;              /* Last record appended */
+    uint64_t since_snapshot;
+    uint32_t unsynced;         /* Records not yet fdatasync()ed */
+    struct timespec first_unsynced;
+    bool failed;
+    uint32_t frame_records;    /* Records in buf */
+    size_t len;                /* Bytes in buf, frame header included */
+    uint8_t buf[LPM_JOURNAL_BUF_SIZE];
+};
+
+struct wal_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t base_lsn;         /* Records start at base_lsn + 1 */
+};
+
+struct wal_frame {
+    uint32_t len;              /* Payload bytes */
+    uint32_t crc;              /* CRC-32C of first_lsn and the payload */
+    uint64_t first_lsn;
+};
+
+struct snap_dir_entry {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct snap_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t abi;
+    uint32_t engine;
+    uint32_t flags;
+    uint64_t lsn;
+
+    /* Trie scalars */
+    uint64_t num_prefixes;
+    uint64_t num_nodes;
+    uint64_t num_wide_nodes;
+    uint32_t pool_capacity;
+    uint32_t pool_used;
+    uint32_t wide_pool_capacity;
+    uint32_t wide_pool_used;
+    uint32_t tbl8_num_groups;
+    uint32_t tbl8_groups_used;
+    uint32_t root_idx;
+    uint32_t default_next_hop;
+    uint8_t has_default_route;
+    uint8_t wide_levels;
+    uint8_t reserved[6];
+
+    /* Side-structure headers; their pointers are not used */
+    struct lpm_sparse16_pool sparse;
+    struct lpm_rule_table rules;
+    struct lpm_small small;
+
+    uint32_t num_sections;
+    uint32_t crc;              /* CRC-32C of the header with this field 0 */
+    struct snap_dir_entry dir[LPM_SNAP_MAX_SECTIONS];
+};
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static uint32_t crc32c_table[256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (0x82F63B78U & (0U - (c & 1)));
+        }
+        crc32c_table[i] = c;
+    }
+}
+
+static uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+    pthread_once(&crc32c_once, crc32c_init);
+    const uint8_t *p = data;
+    crc = ~crc;
+    while (len--) {
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/* Structure sizes a snapshot image depends on */
+static uint32_t snap_abi(void)
+{
+    const size_t sizes[] = {
+        sizeof(lpm_trie_t), sizeof(struct lpm_node), sizeof(struct lpm_node_16),
+        sizeof(struct lpm_dir24_entry), sizeof(struct lpm_tbl8_entry), sizeof(struct lpm_direct_entry),
+        sizeof(struct lpm_rule), sizeof(struct lpm_small_rule), sizeof(struct snap_header),
+    };
+    return crc32c(0, sizes, sizeof(sizes));
+}
+
+static int write_all(int fd, const void *buf, size_t len, off_t off)
+{
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return -1; }
+        p += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return 0;
+}
+
+static int append_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return -1; }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Make a rename in the directory of path durable */
+static int dir_sync(const char *path)
+{
+    char *copy = strdup(path);
+    if (!copy) { return -1; }
+    int fd = open(dirname(copy), O_RDONLY | O_DIRECTORY);
+    free(copy);
+    if (fd < 0) { return -1; }
+    int rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+static char *path_with(const char *path, const char *suffix)
+{
+    size_t n = strlen(path), m = strlen(suffix);
+    char *s = malloc(n + m + 1);
+    if (s) {
+        memcpy(s, path, n);
+        memcpy(s + n, suffix, m + 1);
+    }
+    return s;
+}
+
+/* ============================================================================
+ * Engines
+ * ============================================================================ */
+
+static enum journal_engine engine_of(const lpm_trie_t *trie)
+{
+    if (trie->set || trie->adapt || trie->agg || trie->ttl || trie->shards) { return ENGINE_NONE; }
+    if (trie->lctrie) { return ENGINE_NONE; }                     /* Nodes are not arrays */
+    if (trie->nh_index && !trie->rules) { return ENGINE_NONE; }   /* Index not rebuildable */
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        if (trie->dir24_table) { return ENGINE_DIR24; }
+        if (trie->dir24c_table) { return ENGINE_DIR24C; }
+        if (trie->small) { return ENGINE_SMALL; }
+        return ENGINE_STRIDE4;
+    }
+    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) { return ENGINE_WIDE16; }
+    return ENGINE_STRIDE6;
+}
+
+static lpm_trie_t *engine_create(uint32_t engine, uint8_t wide_levels)
+{
+    switch (engine) {
+    case ENGINE_DIR24:   return lpm_create_ipv4_dir24();
+    case ENGINE_DIR24C:  return lpm_create_ipv4_dir24_compact();
+    case ENGINE_STRIDE4: return lpm_create_ipv4_8stride();
+    case ENGINE_STRIDE6: return lpm_create_ipv6_8stride();
+    case ENGINE_WIDE16:  return lpm_create_ipv6_wide16_levels(wide_levels);
+    case ENGINE_SMALL:   return lpm_create_ipv4_small();
+    default:             return NULL;
+    }
+}
+
+/* One engine array. where is the address of the pointer to it; size bytes
+ * are saved, capacity bytes are allocated on restore. Fixed arrays are
+ * allocated by the engine's create call and restored in place. */
+struct snap_section {
+    uint32_t id;
+    void *where;
+    size_t size;
+    size_t capacity;
+    bool fixed;
+};
+
+static void *section_ptr(const struct snap_section *s)
+{
+    void *p;
+    memcpy(&p, s->where, sizeof(p));
+    return p;
+}
+
+static void section_add(struct snap_section *s, unsigned *n, uint32_t id, void *where,
+                        size_t size, size_t capacity, bool fixed)
+{
+    s[*n] = (struct snap_section){ .id = id, .where = where, .size = size, .capacity = capacity,
+                                   .fixed = fixed };
+    if (section_ptr(&s[*n])) {
+        (*n)++;
+    }
+}
+
+/* Sections follow from the trie's scalars, so a restored header yields the
+ * same list the snapshot was written from */
+static unsigned snap_sections(lpm_trie_t *t, struct snap_section *s)
+{
+    unsigned n = 0;
+    size_t node = sizeof(struct lpm_node), node16 = sizeof(struct lpm_node_16);
+    size_t tbl8 = (size_t)t->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
+
+    section_add(s, &n, 1, &t->node_pool, t->pool_used * node, t->pool_capacity * node, false);
+    section_add(s, &n, 2, &t->wide_nodes_pool, t->wide_pool_used * node16,
+                t->wide_pool_capacity * node16, false);
+    if (t->sparse16) {
+        struct lpm_sparse16_pool *p = t->sparse16;
+        section_add(s, &n, 3, &p->cells, (size_t)p->used * LPM_SPARSE16_CELL,
+                    (size_t)p->capacity * LPM_SPARSE16_CELL, false);
+    }
+    section_add(s, &n, 4, &t->dir24_table, LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry),
+                LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry), true);
+    section_add(s, &n, 5, &t->tbl8_groups, tbl8 * sizeof(struct lpm_tbl8_entry),
+                tbl8 * sizeof(struct lpm_tbl8_entry), false);
+    section_add(s, &n, 6, &t->dir24c_table, LPM_IPV4_DIR24_SIZE * sizeof(uint16_t),
+                LPM_IPV4_DIR24_SIZE * sizeof(uint16_t), true);
+    section_add(s, &n, 7, &t->tbl8c_groups, tbl8 * sizeof(uint16_t),
+                tbl8 * sizeof(uint16_t) + LPM_DIR24C_PAD, false);
+    section_add(s, &n, 8, &t->dir24_depth, LPM_IPV4_DIR24_SIZE, LPM_IPV4_DIR24_SIZE, true);
+    section_add(s, &n, 9, &t->tbl8_depth, tbl8, tbl8, false);
+    section_add(s, &n, 10, &t->direct_table, LPM_DIRECT_SIZE * sizeof(struct lpm_direct_entry),
+                LPM_DIRECT_SIZE * sizeof(struct lpm_direct_entry), true);
+    if (t->rules) {
+        size_t bytes = (size_t)t->rules->capacity * sizeof(struct lpm_rule);
+        section_add(s, &n, 11, &t->rules->slots, bytes, bytes, false);
+    }
+    if (t->small) {
+        struct lpm_small *sm = t->small;
+        size_t tree = ((size_t)1 << sm->height) * sizeof(int32_t);
+        section_add(s, &n, 12, &sm->rules, sm->rule_count * sizeof(struct lpm_small_rule),
+                    sm->rule_capacity * sizeof(struct lpm_small_rule), false);
+        section_add(s, &n, 13, &sm->keys, tree, tree, false);
+        section_add(s, &n, 14, &sm->vals, tree, tree, false);
+    }
+    return n;
+}
+
+static int section_restore(const struct snap_section *s, const uint8_t *src)
+{
+    void *dst = section_ptr(s);
+    if (!s->fixed) {
+        dst = aligned_alloc(LPM_CACHE_LINE_SIZE, (s->capacity + LPM_CACHE_LINE_SIZE - 1) &
+                                                 ~(size_t)(LPM_CACHE_LINE_SIZE - 1));
+        if (!dst) { return -1; }
+        void *old = section_ptr(s);
+        memcpy(s->where, &dst, sizeof(dst));
+        free(old);
+    }
+    memcpy(dst, src, s->size);
+    memset((uint8_t *)dst + s->size, 0, s->capacity - s->size);
+    return 0;
+}
+
+/* ============================================================================
+ * Snapshots
+ * ============================================================================ */
+
+static int snapshot_write(lpm_trie_t *trie, const char *path, uint64_t lsn)
+{
+    struct snap_header *h = calloc(1, sizeof(*h));
+    if (!h) { return -1; }
+    memcpy(h->magic, snap_magic, sizeof(h->magic));
+    h->version = LPM_JOURNAL_VERSION;
+    h->abi = snap_abi();
+    h->engine = engine_of(trie);
+    h->flags = trie->nh_index ? SNAP_FLAG_NH_INDEX : 0;
+    h->lsn = lsn;
+    h->num_prefixes = trie->num_prefixes;
+    h->num_nodes = trie->num_nodes;
+    h->num_wide_nodes = trie->num_wide_nodes;
+    h->pool_capacity = trie->pool_capacity;
+    h->pool_used = trie->pool_used;
+    h->wide_pool_capacity = trie->wide_pool_capacity;
+    h->wide_pool_used = trie->wide_pool_used;
+    h->tbl8_num_groups = trie->tbl8_num_groups;
+    h->tbl8_groups_used = trie->tbl8_groups_used;
+    h->root_idx = trie->root_idx;
+    h->default_next_hop = trie->default_next_hop;
+    h->has_default_route = trie->has_default_route;
+    h->wide_levels = trie->wide_levels;
+    if (trie->sparse16) { h->sparse = *trie->sparse16; }
+    if (trie->rules) { h->rules = *trie->rules; }
+    if (trie->small) { h->small = *trie->small; }
+
+    struct snap_section s[LPM_SNAP_MAX_SECTIONS];
+    h->num_sections = snap_sections(trie, s);
+    uint64_t off = (sizeof(*h) + LPM_SNAP_ALIGN - 1) & ~(uint64_t)(LPM_SNAP_ALIGN - 1);
+    for (unsigned i = 0; i < h->num_sections; i++) {
+        h->dir[i] = (struct snap_dir_entry){ .id = s[i].id, .offset = off, .size = s[i].size };
+        off = (off + s[i].size + LPM_SNAP_ALIGN - 1) & ~(uint64_t)(LPM_SNAP_ALIGN - 1);
+    }
+    h->crc = crc32c(0, h, sizeof(*h));
+
+    char *tmp = path_with(path, ".tmp");
+    int fd = tmp ? open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    int rc = fd < 0 ? -1 : write_all(fd, h, sizeof(*h), 0);
+    for (unsigned i = 0; rc == 0 && i < h->num_sections; i++) {
+        rc = write_all(fd, section_ptr(&s[i]), s[i].size, (off_t)h->dir[i].offset);
+    }
+    if (rc == 0) { rc = ftruncate(fd, (off_t)off); }
+    if (rc == 0) { rc = fsync(fd); }
+    if (fd >= 0) { close(fd); }
+    if (rc == 0) { rc = rename(tmp, path); }
+    if (rc == 0) { rc = dir_sync(path); }
+    if (rc != 0 && tmp) { unlink(tmp); }
+    free(tmp);
+    free(h);
+    return rc;
+}
+
+static lpm_trie_t *snapshot_restore(const uint8_t *base, size_t size, uint64_t *lsn)
+{
+    const struct snap_header *h = (const struct snap_header *)base;
+    if (size < sizeof(*h) || memcmp(h->magic, snap_magic, sizeof(h->magic)) != 0 ||
+        h->version != LPM_JOURNAL_VERSION || h->abi != snap_abi() ||
+        h->num_sections > LPM_SNAP_MAX_SECTIONS) {
+        return NULL;
+    }
+    struct snap_header check = *h;
+    check.crc = 0;
+    if (crc32c(0, &check, sizeof(check)) != h->crc) { return NULL; }
+
+    lpm_trie_t *t = engine_create(h->engine, h->wide_levels);
+    if (!t) { return NULL; }
+    t->num_prefixes = h->num_prefixes;
+    t->num_nodes = h->num_nodes;
+    t->num_wide_nodes = h->num_wide_nodes;
+    t->pool_capacity = h->pool_capacity;
+    t->pool_used = h->pool_used;
+    t->wide_pool_capacity = h->wide_pool_capacity;
+    t->wide_pool_used = h->wide_pool_used;
+    t->tbl8_num_groups = h->tbl8_num_groups;
+    t->tbl8_groups_used = h->tbl8_groups_used;
+    t->root_idx = h->root_idx;
+    t->default_next_hop = h->default_next_hop;
+    t->has_default_route = h->has_default_route;
+
+    /* Keep the arrays the engine allocated; sections replace them below */
+    if (t->sparse16) {
+        uint8_t *cells = t->sparse16->cells;
+        *t->sparse16 = h->sparse;
+        t->sparse16->cells = cells;
+    }
+    if (t->rules) {
+        struct lpm_rule *slots = t->rules->slots;
+        *t->rules = h->rules;
+        t->rules->slots = slots;
+    }
+    if (t->small) {
+        struct lpm_small sm = h->small;
+        sm.rules = t->small->rules;
+        sm.keys = t->small->keys;
+        sm.vals = t->small->vals;
+        *t->small = sm;
+    }
+
+    struct snap_section s[LPM_SNAP_MAX_SECTIONS];
+    unsigned n = snap_sections(t, s);
+    bool ok = n == h->num_sections;
+    for (unsigned i = 0; ok && i < n; i++) {
+        const struct snap_dir_entry *d = &h->dir[i];
+        ok = d->id == s[i].id && d->size == s[i].size && d->offset <= size &&
+             d->size <= size - d->offset && section_restore(&s[i], base + d->offset) == 0;
+    }
+    if (ok && (h->flags & SNAP_FLAG_NH_INDEX)) {
+        ok = lpm_enable_next_hop_index(t) == 0;
+    }
+    if (!ok) {
+        lpm_destroy(t);
+        return NULL;
+    }
+    *lsn = h->lsn;
+    return t;
+}
+
+/* ============================================================================
+ * Journal Files
+ * ============================================================================ */
+
+/* Start an empty journal after base_lsn, replacing any previous one */
+static int wal_create(struct lpm_journal *j, uint64_t base_lsn)
+{
+    struct wal_header h = { .version = LPM_JOURNAL_VERSION, .base_lsn = base_lsn };
+    memcpy(h.magic, wal_magic, sizeof(h.magic));
+
+    char *tmp = path_with(j->wal_path, ".tmp");
+    int fd = tmp ? open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    int rc = fd < 0 ? -1 : write_all(fd, &h, sizeof(h), 0);
+    if (rc == 0) { rc = fsync(fd); }
+    if (rc == 0) { rc = rename(tmp, j->wal_path); }
+    if (rc == 0) { rc = dir_sync(j->wal_path); }
+    if (rc != 0) {
+        if (fd >= 0) { close(fd); }
+        if (tmp) { unlink(tmp); }
+        free(tmp);
+        return -1;
+    }
+    free(tmp);
+
+    /* The descriptor now names the journal; appends go to its end */
+    if (lseek(fd, 0, SEEK_END) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (j->fd >= 0) { close(j->fd); }
+    j->fd = fd;
+    j->len = 0;
+    j->frame_records = 0;
+    j->unsynced = 0;
+    j->failed = false;
+    return 0;
+}
+
+static int journal_write(struct lpm_journal *j)
+{
+    if (j->len == 0) { return j->failed ? -1 : 0; }
+    struct wal_frame *f = (struct wal_frame *)j->buf;
+    f->len = (uint32_t)(j->len - sizeof(*f));
+    f->first_lsn = j->lsn - j->frame_records + 1;
+    f->crc = crc32c(crc32c(0, &f->first_lsn, sizeof(f->first_lsn)), j->buf + sizeof(*f), f->len);
+    if (!j->failed && append_all(j->fd, j->buf, j->len) != 0) {
+        j->failed = true;
+    }
+    j->len = 0;
+    j->frame_records = 0;
+    return j->failed ? -1 : 0;
+}
+
+static int journal_sync(struct lpm_journal *j)
+{
+    if (journal_write(j) != 0) { return -1; }
+    if (j->unsynced && fdatasync(j->fd) != 0) {
+        j->failed = true;
+        return -1;
+    }
+    j->unsynced = 0;
+    return 0;
+}
+
+static struct lpm_journal *journal_alloc(const char *path, const lpm_journal_config_t *config)
+{
+    struct lpm_journal *j = calloc(1, sizeof(*j));
+    if (!j) { return NULL; }
+    j->fd = -1;
+    j->wal_path = path_with(path, ".wal");
+    j->snap_path = path_with(path, ".snap");
+    if (!j->wal_path || !j->snap_path) {
+        lpm_journal_destroy(j);
+        return NULL;
+    }
+    if (config) {
+        j->cfg = *config;
+    } else {
+        j->cfg.sync_records = LPM_JOURNAL_DEFAULT_SYNC_RECORDS;
+        j->cfg.sync_us = LPM_JOURNAL_DEFAULT_SYNC_US;
+        j->cfg.snapshot_records = LPM_JOURNAL_DEFAULT_SNAPSHOT_RECORDS;
+    }
+    return j;
+}
+
+void lpm_journal_destroy(struct lpm_journal *j)
+{
+    if (!j) { return; }
+    if (j->fd >= 0) {
+        journal_sync(j);
+        close(j->fd);
+    }
+    free(j->wal_path);
+    free(j->snap_path);
+    free(j);
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+/* The oldest pending record is sync_us old */
+static bool sync_overdue(const struct lpm_journal *j)
+{
+    if (j->unsynced == 0 || !j->cfg.sync_us) { return false; }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return lpm_elapsed_ms(&j->first_unsynced, &now) * 1000.0 >= j->cfg.sync_us;
+}
+
+void lpm_journal_idle(lpm_trie_t *trie)
+{
+    struct lpm_journal *j = trie->journal;
+    if (!j->failed && sync_overdue(j)) {
+        journal_sync(j);
+    }
+}
+
+bool lpm_journal_snapshot_due(const lpm_trie_t *trie)
+{
+    const struct lpm_journal *j = trie->journal;
+    return j->cfg.snapshot_records && j->since_snapshot >= j->cfg.snapshot_records;
+}
+
+void lpm_journal_record(lpm_trie_t *trie, enum lpm_journal_op op, const uint8_t *prefix,
+                        uint8_t prefix_len, uint32_t a, uint32_t b)
+{
+    struct lpm_journal *j = trie->journal;
+    if (j->failed) { return; }
+
+    if (j->len + LPM_JOURNAL_MAX_RECORD > sizeof(j->buf)) {
+        journal_write(j);
+    }
+    if (j->len == 0) {
+        j->len = sizeof(struct wal_frame);
+    }
+
+    /* op, length, then the op's next hops and the prefix's significant bytes */
+    uint8_t *p = j->buf + j->len;
+    *p++ = (uint8_t)op;
+    *p++ = prefix_len;
+    if (op != LPM_JOURNAL_DELETE) {
+        memcpy(p, &a, sizeof(a));
+        p += sizeof(a);
+    }
+    if (op == LPM_JOURNAL_REPLACE) {
+        memcpy(p, &b, sizeof(b));
+        p += sizeof(b);
+    } else {
+        size_t bytes = ((size_t)prefix_len + 7) / 8;
+        memcpy(p, prefix, bytes);
+        p += bytes;
+    }
+    j->len = (size_t)(p - j->buf);
+    j->lsn++;
+    j->frame_records++;
+    j->since_snapshot++;
+
+    if (j->unsynced++ == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &j->first_unsynced);
+    }
+    if ((j->cfg.sync_records && j->unsynced >= j->cfg.sync_records) || sync_overdue(j)) {
+        journal_sync(j);
+    }
+}
+
+/* Apply one record; returns its size, or 0 if it does not parse */
+static size_t record_replay(lpm_trie_t *trie, const uint8_t *p, size_t avail, bool apply, bool *failed)
+{
+    if (avail < 2) { return 0; }
+    uint8_t op = p[0], len = p[1];
+    size_t need = 2 + (op != LPM_JOURNAL_DELETE ? 4 : 0) +
+                  (op == LPM_JOURNAL_REPLACE ? 4 : ((size_t)len + 7) / 8);
+    if (op < LPM_JOURNAL_ADD || op > LPM_JOURNAL_REPLACE || len > trie->max_depth || avail < need) {
+        return 0;
+    }
+    if (!apply) { return need; }
+
+    uint32_t a = 0, b = 0;
+    uint8_t prefix[16] = {0};
+    const uint8_t *q = p + 2;
+    if (op != LPM_JOURNAL_DELETE) {
+        memcpy(&a, q, sizeof(a));
+        q += sizeof(a);
+    }
+    if (op == LPM_JOURNAL_REPLACE) {
+        memcpy(&b, q, sizeof(b));
+    } else {
+        memcpy(prefix, q, ((size_t)len + 7) / 8);
+    }
+
+    int rc;
+    switch (op) {
+    case LPM_JOURNAL_ADD:    rc = lpm_add(trie, prefix, len, a); break;
+    case LPM_JOURNAL_DELETE: rc = lpm_delete(trie, prefix, len); break;
+    default:                 rc = lpm_replace_next_hop(trie, a, b); break;
+    }
+    *failed = rc != 0;
+    return need;
+}
+
+/* Replay the records after snap_lsn; returns the end of the last whole
+ * frame and the last LSN seen, or -1 if the journal does not continue the
+ * snapshot */
+static ssize_t wal_replay(lpm_trie_t *trie, const uint8_t *base, size_t size, uint64_t snap_lsn,
+                          uint64_t *last_lsn, lpm_recover_stats_t *stats)
+{
+    const struct wal_header *h = (const struct wal_header *)base;
+    if (size < sizeof(*h) || memcmp(h->magic, wal_magic, sizeof(h->magic)) != 0 ||
+        h->version != LPM_JOURNAL_VERSION || h->base_lsn > snap_lsn) {
+        return -1;
+    }
+
+    size_t off = sizeof(*h);
+    *last_lsn = snap_lsn;
+    while (size - off >= sizeof(struct wal_frame)) {
+        struct wal_frame f;
+        memcpy(&f, base + off, sizeof(f));
+        const uint8_t *payload = base + off + sizeof(f);
+        if (f.len > size - off - sizeof(f) ||
+            crc32c(crc32c(0, &f.first_lsn, sizeof(f.first_lsn)), payload, f.len) != f.crc) {
+            break;   /* Torn tail */
+        }
+        uint64_t lsn = f.first_lsn;
+        for (size_t pos = 0; pos < f.len; lsn++) {
+            bool failed = false;
+            size_t n = record_replay(trie, payload + pos, f.len - pos, lsn > snap_lsn, &failed);
+            if (n == 0) { return -1; }
+            pos += n;
+            if (lsn > snap_lsn) {
+                stats->replayed++;
+                stats->failed += failed;
+            }
+        }
+        if (lsn - 1 > *last_lsn) { *last_lsn = lsn - 1; }
+        off += sizeof(f) + f.len;
+    }
+    return (ssize_t)off;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_enable_journal(lpm_trie_t *trie, const char *path, const lpm_journal_config_t *config)
+{
+    if (!trie || !path || trie->journal || trie->async || engine_of(trie) == ENGINE_NONE) { return -1; }
+
+    struct lpm_journal *j = journal_alloc(path, config);
+    if (!j) { return -1; }
+
+    /* The current contents become the base snapshot */
+    lpm_update_flush(trie);
+    if (snapshot_write(trie, j->snap_path, 0) != 0 || wal_create(j, 0) != 0) {
+        lpm_journal_destroy(j);
+        return -1;
+    }
+    trie->journal = j;
+    return 0;
+}
+
+int lpm_journal_sync(lpm_trie_t *trie)
+{
+    if (!trie || !trie->journal) { return -1; }
+    return journal_sync(trie->journal);
+}
+
+int lpm_journal_poll(lpm_trie_t *trie)
+{
+    if (!trie || !trie->journal) { return -1; }
+    lpm_journal_idle(trie);
+    if (!lpm_journal_snapshot_due(trie)) {
+        return trie->journal->failed ? -1 : 0;
+    }
+    return lpm_snapshot(trie) == 0 ? 1 : -1;
+}
+
+int lpm_snapshot(lpm_trie_t *trie)
+{
+    if (!trie || !trie->journal || engine_of(trie) == ENGINE_NONE) { return -1; }
+    struct lpm_journal *j = trie->journal;
+
+    /* Records up to j->lsn are in the image; the old journal stays valid
+     * until the new one replaces it */
+    lpm_update_flush(trie);
+    journal_sync(j);
+    if (snapshot_write(trie, j->snap_path, j->lsn) != 0 || wal_create(j, j->lsn) != 0) {
+        return -1;
+    }
+    j->since_snapshot = 0;
+    return 0;
+}
+
+lpm_trie_t *lpm_recover(const char *path, const lpm_journal_config_t *config,
+                        lpm_recover_stats_t *stats)
+{
+    lpm_recover_stats_t local;
+    if (!stats) { stats = &local; }
+    memset(stats, 0, sizeof(*stats));
+    if (!path) { return NULL; }
+
+    struct lpm_journal *j = journal_alloc(path, config);
+    if (!j) { return NULL; }
+
+    /* Snapshot */
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    lpm_trie_t *trie = NULL;
+    uint64_t snap_lsn = 0;
+    int fd = open(j->snap_path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t size = (size_t)st.st_size;
+        void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (base != MAP_FAILED) {
+            madvise(base, size, MADV_SEQUENTIAL);
+            trie = snapshot_restore(base, size, &snap_lsn);
+            munmap(base, size);
+            stats->snapshot_bytes = size;
+        }
+    }
+    if (fd >= 0) { close(fd); }
+    if (!trie) {
+        lpm_journal_destroy(j);
+        return NULL;
+    }
+    stats->snapshot_lsn = snap_lsn;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    /* Journal tail; a missing journal means nothing was recorded after the
+     * snapshot (a crash before it was first created) */
+    uint64_t last_lsn = snap_lsn;
+    fd = open(j->wal_path, O_RDWR | O_CLOEXEC);
+    bool ok = true;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t size = (size_t)st.st_size;
+        void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ssize_t end = base == MAP_FAILED ? -1 : wal_replay(trie, base, size, snap_lsn, &last_lsn, stats);
+        if (base != MAP_FAILED) { munmap(base, size); }
+        ok = end >= 0;
+        if (ok && (size_t)end < size) {
+            stats->truncated_bytes = size - (size_t)end;
+            ok = ftruncate(fd, end) == 0 && fsync(fd) == 0;
+        }
+        ok = ok && lseek(fd, 0, SEEK_END) >= 0;
+        if (ok) {
+            j->fd = fd;
+            fd = -1;
+        }
+    }
+    if (fd >= 0) { close(fd); }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    stats->snapshot_ms = lpm_elapsed_ms(&t0, &t1);
+    stats->replay_ms = lpm_elapsed_ms(&t1, &t2);
+
+    /* Keep recording where the journal left off */
+    j->lsn = last_lsn;
+    j->since_snapshot = last_lsn - snap_lsn;
+    if (!ok || (j->fd < 0 && wal_create(j, snap_lsn) != 0)) {
+        lpm_journal_destroy(j);
+        lpm_destroy(trie);
+        return NULL;
+    }
+    trie->journal = j;
+    return trie;
+}
@@ -0,0 +1,584 @@
+/*
+ * IPv4 LC-Trie Engine - Core Functions
+ * Create, Add, Delete and node resizing
+ *
+ * A binary trie with both compressions of Nilsson and Karlsson's LC-trie,
+ * kept dynamic the way Linux's fib_trie does it. Path compression: a node
+ * only exists where the keys below it differ, the bits they share are kept
+ * in its key. Level compression: a node indexes bits bits at once, and is
+ * inflated (one more bit, its full children split between the two halves)
+ * while that keeps at least half its slots busy, halved when fewer than a
+ * quarter are. The top node uses lower thresholds so it stays wide.
+ *
+ * Updates walk down once, remember the path and resize it bottom-up;
+ * nothing else is touched. Each resize step is bounded, so a long run of
+ * inserts into one node catches up over the following updates.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+#define LPM_LCT_MAX_BITS      24    /* Widest node: as wide as DIR-24-8's table */
+#define LPM_LCT_MAX_WORK      10    /* Inflate or halve steps per resize */
+
+/* Fill thresholds, in percent of the slots of the resized node */
+#define LPM_LCT_INFLATE       50
+#define LPM_LCT_INFLATE_ROOT  30
+#define LPM_LCT_HALVE         25
+#define LPM_LCT_HALVE_ROOT    15
+
+struct lct_step {
+    struct lpm_lct_tnode *tn;
+    uint32_t idx;
+};
+
+/* ============================================================================
+ * Nodes
+ * ============================================================================ */
+
+static size_t tnode_size(unsigned bits)
+{
+    return sizeof(struct lpm_lct_tnode) + ((size_t)1 << bits) * sizeof(struct lpm_lct_node *);
+}
+
+static size_t leaf_size(unsigned count)
+{
+    return sizeof(struct lpm_lct_leaf) + count * sizeof(struct lpm_lct_alias);
+}
+
+static struct lpm_lct_tnode *tnode_new(struct lpm_lctrie *t, uint32_t key, unsigned pos, unsigned bits)
+{
+    struct lpm_lct_tnode *tn = calloc(1, tnode_size(bits));
+    if (!tn) { return NULL; }
+
+    unsigned shift = pos + bits;
+    tn->n.key = shift < 32 ? (key >> shift) << shift : 0;
+    tn->n.pos = (uint8_t)pos;
+    tn->n.bits = (uint8_t)bits;
+    tn->n.slen = (uint8_t)pos;
+    tn->empty_children = 1U << bits;
+    t->tnodes++;
+    t->bytes += tnode_size(bits);
+    return tn;
+}
+
+static void tnode_free(struct lpm_lctrie *t, struct lpm_lct_tnode *tn)
+{
+    t->tnodes--;
+    t->bytes -= tnode_size(tn->n.bits);
+    free(tn);
+}
+
+/* An internal child that indexes the bits right below its parent's */
+static bool tnode_full(const struct lpm_lct_node *tn, const struct lpm_lct_node *n)
+{
+    return n && !lpm_lct_is_leaf(n) && n->pos + n->bits == tn->pos;
+}
+
+/* Replace child i; the old child must still be allocated */
+static void put_child(struct lpm_lct_tnode *tn, uint32_t i, struct lpm_lct_node *n)
+{
+    struct lpm_lct_node *old = tn->child[i];
+
+    if (!old && n) {
+        tn->empty_children--;
+    } else if (old && !n) {
+        tn->empty_children++;
+    }
+    bool was_full = tnode_full(&tn->n, old), is_full = tnode_full(&tn->n, n);
+    if (was_full && !is_full) {
+        tn->full_children--;
+    } else if (!was_full && is_full) {
+        tn->full_children++;
+    }
+    if (n && n->slen > tn->n.slen) {
+        tn->n.slen = n->slen;
+    }
+    tn->child[i] = n;
+}
+
+/* Put n where child idx of tp (the root if tp is NULL) was */
+static void replace(struct lpm_lctrie *t, struct lpm_lct_tnode *tp, uint32_t idx, struct lpm_lct_node *n)
+{
+    if (tp) {
+        put_child(tp, idx, n);
+    } else {
+        t->root = n;
+    }
+}
+
+/* Recompute slen after something below shrank. Child i of a node holds only
+ * keys with i at [pos, pos + bits), so its suffixes are at most pos + ctz(i);
+ * once slen is known only children with more trailing zeros can beat it. */
+static void update_suffix(struct lpm_lct_tnode *tn)
+{
+    unsigned slen = tn->n.pos;
+    unsigned slen_max = tn->n.pos + tn->n.bits - 1u;
+    if (tn->n.slen < slen_max) {
+        slen_max = tn->n.slen;
+    }
+
+    uint64_t len = 1ULL << tn->n.bits, stride = 2;
+    for (uint64_t i = 0; i < len; i += stride) {
+        const struct lpm_lct_node *c = tn->child[i];
+        if (!c || c->slen <= slen) { continue; }
+        stride <<= c->slen - slen;
+        slen = c->slen;
+        i &= ~(stride - 1);
+        if (slen >= slen_max) { break; }
+    }
+    tn->n.slen = (uint8_t)slen;
+}
+
+/* ============================================================================
+ * Resizing
+ * ============================================================================ */
+
+static bool should_inflate(const struct lpm_lct_tnode *tn, bool root)
+{
+    uint64_t size = 1ULL << tn->n.bits;
+    uint64_t used = size - tn->empty_children + tn->full_children;
+    uint64_t threshold = root ? LPM_LCT_INFLATE_ROOT : LPM_LCT_INFLATE;
+
+    /* Doubled, the node would have 2 * size slots and at least used children */
+    return used > 1 && tn->n.pos && tn->n.bits < LPM_LCT_MAX_BITS && 50 * used >= threshold * size;
+}
+
+static bool should_halve(const struct lpm_lct_tnode *tn, bool root)
+{
+    uint64_t size = 1ULL << tn->n.bits;
+    uint64_t used = size - tn->empty_children;
+    uint64_t threshold = root ? LPM_LCT_HALVE_ROOT : LPM_LCT_HALVE;
+
+    return used > 1 && tn->n.bits > 1 && 100 * used < threshold * size;
+}
+
+/* One more index bit. Full children are split in two (or dissolved, if they
+ * index a single bit); the rest move by the bit below the old pos. Returns
+ * NULL, with nothing changed, if memory runs out. */
+static struct lpm_lct_tnode *inflate(struct lpm_lctrie *t, const struct lpm_lct_tnode *old)
+{
+    struct lpm_lct_tnode *tn = tnode_new(t, old->n.key, old->n.pos - 1u, old->n.bits + 1u);
+    if (!tn) { return NULL; }
+
+    uint32_t len = 1U << old->n.bits;
+    for (uint32_t i = 0; i < len; i++) {
+        struct lpm_lct_node *c = old->child[i];
+        if (!c) { continue; }
+        if (!tnode_full(&old->n, c)) {
+            put_child(tn, lpm_lct_index(c->key, &tn->n), c);
+            continue;
+        }
+
+        const struct lpm_lct_tnode *ct = (const struct lpm_lct_tnode *)c;
+        if (c->bits == 1) {
+            put_child(tn, 2 * i, ct->child[0]);
+            put_child(tn, 2 * i + 1, ct->child[1]);
+            continue;
+        }
+
+        uint32_t half = 1U << (c->bits - 1);
+        struct lpm_lct_tnode *n0 = tnode_new(t, c->key, c->pos, c->bits - 1u);
+        struct lpm_lct_tnode *n1 = tnode_new(t, c->key | (1U << (c->pos + c->bits - 1)), c->pos, c->bits - 1u);
+        if (!n0 || !n1) {
+            if (n0) { tnode_free(t, n0); }
+            if (n1) { tnode_free(t, n1); }
+            /* Drop the halves made so far; the old children are untouched */
+            for (uint32_t j = 0; j < i; j++) {
+                const struct lpm_lct_node *o = old->child[j];
+                if (tnode_full(&old->n, o) && o->bits > 1) {
+                    tnode_free(t, (struct lpm_lct_tnode *)tn->child[2 * j]);
+                    tnode_free(t, (struct lpm_lct_tnode *)tn->child[2 * j + 1]);
+                }
+            }
+            tnode_free(t, tn);
+            return NULL;
+        }
+        for (uint32_t j = 0; j < half; j++) {
+            if (ct->child[j]) { put_child(n0, j, ct->child[j]); }
+            if (ct->child[half + j]) { put_child(n1, j, ct->child[half + j]); }
+        }
+        put_child(tn, 2 * i, &n0->n);
+        put_child(tn, 2 * i + 1, &n1->n);
+    }
+    return tn;
+}
+
+/* One index bit less; pairs of children that both survive get a binary node */
+static struct lpm_lct_tnode *halve(struct lpm_lctrie *t, const struct lpm_lct_tnode *old)
+{
+    struct lpm_lct_tnode *tn = tnode_new(t, old->n.key, old->n.pos + 1u, old->n.bits - 1u);
+    if (!tn) { return NULL; }
+
+    uint32_t len = 1U << old->n.bits;
+    for (uint32_t i = 0; i < len; i += 2) {
+        struct lpm_lct_node *c0 = old->child[i], *c1 = old->child[i + 1];
+        if (!c0 || !c1) {
+            if (c0 || c1) { put_child(tn, i / 2, c0 ? c0 : c1); }
+            continue;
+        }
+        struct lpm_lct_tnode *b = tnode_new(t, c0->key, old->n.pos, 1);
+        if (!b) {
+            for (uint32_t j = 0; j < i; j += 2) {
+                if (old->child[j] && old->child[j + 1]) {
+                    tnode_free(t, (struct lpm_lct_tnode *)tn->child[j / 2]);
+                }
+            }
+            tnode_free(t, tn);
+            return NULL;
+        }
+        put_child(b, 0, c0);
+        put_child(b, 1, c1);
+        put_child(tn, i / 2, &b->n);
+    }
+    return tn;
+}
+
+static struct lpm_lct_node *resize(struct lpm_lctrie *t, struct lpm_lct_tnode *tn,
+                                   struct lpm_lct_tnode *tp, uint32_t idx);
+
+/* After an inflate or halve the full children are new or have new
+ * neighbours: give them a chance to settle too */
+static void resize_children(struct lpm_lctrie *t, struct lpm_lct_tnode *tn)
+{
+    uint32_t len = 1U << tn->n.bits;
+    for (uint32_t i = 0; i < len; i++) {
+        if (tnode_full(&tn->n, tn->child[i])) {
+            resize(t, (struct lpm_lct_tnode *)tn->child[i], tn, i);
+        }
+    }
+}
+
+/* Free a node that has been replaced; after an inflate its full children
+ * were dissolved or split, so they go too */
+static void tnode_retire(struct lpm_lctrie *t, struct lpm_lct_tnode *old, bool inflated)
+{
+    if (inflated) {
+        uint32_t len = 1U << old->n.bits;
+        for (uint32_t i = 0; i < len; i++) {
+            if (tnode_full(&old->n, old->child[i])) {
+                tnode_free(t, (struct lpm_lct_tnode *)old->child[i]);
+            }
+        }
+    }
+    tnode_free(t, old);
+}
+
+/* Resize tn, child idx of tp (tp NULL for the root); returns what now
+ * stands in its place, possibly NULL or a single child */
+static struct lpm_lct_node *resize(struct lpm_lctrie *t, struct lpm_lct_tnode *tn,
+                                   struct lpm_lct_tnode *tp, uint32_t idx)
+{
+    bool root = tp == NULL;
+    int work = LPM_LCT_MAX_WORK;
+
+    while (work && should_inflate(tn, root)) {
+        struct lpm_lct_tnode *grown = inflate(t, tn);
+        if (!grown) { break; }
+        replace(t, tp, idx, &grown->n);
+        tnode_retire(t, tn, true);
+        tn = grown;
+        resize_children(t, tn);
+        work--;
+    }
+    while (work == LPM_LCT_MAX_WORK && should_halve(tn, root)) {
+        struct lpm_lct_tnode *shrunk = halve(t, tn);
+        if (!shrunk) { break; }
+        replace(t, tp, idx, &shrunk->n);
+        tnode_retire(t, tn, false);
+        tn = shrunk;
+        resize_children(t, tn);
+    }
+
+    /* One child or none: the node has nothing left to tell apart */
+    if ((1ULL << tn->n.bits) - tn->empty_children < 2) {
+        struct lpm_lct_node *only = NULL;
+        for (uint32_t i = 0; i < (1U << tn->n.bits) && !only; i++) {
+            only = tn->child[i];
+        }
+        replace(t, tp, idx, only);
+        tnode_free(t, tn);
+        return only;
+    }
+    return &tn->n;
+}
+
+/* Resize the path from the bottom up; shrunk when a suffix may have gone */
+static void rebalance(struct lpm_lctrie *t, struct lct_step *path, unsigned depth, bool shrunk)
+{
+    for (unsigned k = depth; k-- > 0;) {
+        struct lpm_lct_tnode *tp = k ? path[k - 1].tn : NULL;
+        uint32_t idx = k ? path[k - 1].idx : 0;
+
+        if (shrunk) {
+            update_suffix(path[k].tn);
+        }
+        struct lpm_lct_node *n = resize(t, path[k].tn, tp, idx);
+        if (tp && n && n->slen > tp->n.slen) {
+            tp->n.slen = n->slen;
+        }
+    }
+}
+
+/* ============================================================================
+ * Insert / Remove
+ * ============================================================================ */
+
+/* Follow key down to the leaf or gap it belongs in */
+static struct lpm_lct_node *descend(const struct lpm_lctrie *t, uint32_t key,
+                                    struct lct_step *path, unsigned *depth)
+{
+    struct lpm_lct_node *n = t->root;
+
+    *depth = 0;
+    while (n && !lpm_lct_is_leaf(n)) {
+        uint32_t idx = lpm_lct_index(key, n);
+        if (idx >> n->bits) { break; }
+        path[*depth].tn = (struct lpm_lct_tnode *)n;
+        path[*depth].idx = idx;
+        (*depth)++;
+        n = ((struct lpm_lct_tnode *)n)->child[idx];
+    }
+    return n;
+}
+
+static void set_leaf(struct lpm_lctrie *t, struct lct_step *path, unsigned depth, struct lpm_lct_leaf *l)
+{
+    if (depth) {
+        path[depth - 1].tn->child[path[depth - 1].idx] = &l->n;
+    } else {
+        t->root = &l->n;
+    }
+}
+
+/* Returns 1 if the prefix is new, 0 if its next hop changed, -1 on failure */
+static int lct_insert(struct lpm_lctrie *t, uint32_t key, uint8_t slen, uint32_t next_hop)
+{
+    struct lct_step path[LPM_IPV4_MAX_DEPTH + 1];
+    unsigned depth;
+    struct lpm_lct_node *n = descend(t, key, path, &depth);
+    struct lpm_lct_tnode *tp = depth ? path[depth - 1].tn : NULL;
+    uint32_t tidx = depth ? path[depth - 1].idx : 0;
+
+    if (n && lpm_lct_is_leaf(n) && n->key == key) {
+        struct lpm_lct_leaf *l = (struct lpm_lct_leaf *)n;
+        uint32_t i = 0;
+        while (i < n->count && l->alias[i].slen < slen) {
+            i++;
+        }
+        if (i < n->count && l->alias[i].slen == slen) {
+            l->alias[i].next_hop = next_hop;
+            return 0;
+        }
+
+        l = realloc(l, leaf_size(n->count + 1u));
+        if (!l) { return -1; }
+        t->bytes += sizeof(struct lpm_lct_alias);
+        memmove(&l->alias[i + 1], &l->alias[i], (l->n.count - i) * sizeof(struct lpm_lct_alias));
+        l->alias[i] = (struct lpm_lct_alias){ .next_hop = next_hop, .slen = slen };
+        l->n.count++;
+        if (slen > l->n.slen) {
+            l->n.slen = slen;
+        }
+        set_leaf(t, path, depth, l);
+        for (unsigned k = 0; k < depth; k++) {
+            if (slen > path[k].tn->n.slen) {
+                path[k].tn->n.slen = slen;
+            }
+        }
+        return 1;
+    }
+
+    struct lpm_lct_leaf *l = malloc(leaf_size(1));
+    if (!l) { return -1; }
+    l->n = (struct lpm_lct_node){ .key = key, .slen = slen, .count = 1 };
+    l->alias[0] = (struct lpm_lct_alias){ .next_hop = next_hop, .slen = slen };
+
+    if (n) {
+        /* A leaf with another key, or a node key leaves above its index
+         * bits: the two part ways at their highest differing bit */
+        unsigned d = 31u - (unsigned)__builtin_clz(key ^ n->key);
+        struct lpm_lct_tnode *tn = tnode_new(t, key, d, 1);
+        if (!tn) {
+            free(l);
+            return -1;
+        }
+        put_child(tn, (key >> d) & 1, &l->n);
+        put_child(tn, (n->key >> d) & 1, n);
+        replace(t, tp, tidx, &tn->n);
+    } else {
+        replace(t, tp, tidx, &l->n);
+    }
+    t->leaves++;
+    t->bytes += leaf_size(1);
+    rebalance(t, path, depth, false);
+    return 1;
+}
+
+static int lct_remove(struct lpm_lctrie *t, uint32_t key, uint8_t slen)
+{
+    struct lct_step path[LPM_IPV4_MAX_DEPTH + 1];
+    unsigned depth;
+    struct lpm_lct_node *n = descend(t, key, path, &depth);
+    if (!n || !lpm_lct_is_leaf(n) || n->key != key) { return -1; }
+
+    struct lpm_lct_leaf *l = (struct lpm_lct_leaf *)n;
+    uint32_t i = 0;
+    while (i < n->count && l->alias[i].slen != slen) {
+        i++;
+    }
+    if (i == n->count) { return -1; }
+
+    if (n->count == 1) {
+        replace(t, depth ? path[depth - 1].tn : NULL, depth ? path[depth - 1].idx : 0, NULL);
+        free(l);
+        t->leaves--;
+        t->bytes -= leaf_size(1);
+    } else {
+        memmove(&l->alias[i], &l->alias[i + 1], (n->count - i - 1u) * sizeof(struct lpm_lct_alias));
+        l->n.count--;
+        l->n.slen = l->alias[l->n.count - 1].slen;
+        t->bytes -= sizeof(struct lpm_lct_alias);
+        struct lpm_lct_leaf *shrunk = realloc(l, leaf_size(l->n.count));
+        if (shrunk) {
+            set_leaf(t, path, depth, shrunk);
+        }
+    }
+    rebalance(t, path, depth, true);
+    return 0;
+}
+
+/* ============================================================================
+ * Creation / Destruction
+ * ============================================================================ */
+
+lpm_trie_t *lpm_create_ipv4_lctrie(void)
+{
+    lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
+    if (!t) { return NULL; }
+    memset(t, 0, sizeof(lpm_trie_t));
+
+    t->max_depth = LPM_IPV4_MAX_DEPTH;
+    t->default_next_hop = LPM_INVALID_NEXT_HOP;
+    t->lctrie = calloc(1, sizeof(struct lpm_lctrie));
+    if (!t->lctrie) {
+        lpm_destroy(t);
+        return NULL;
+    }
+    lpm_dispatch_init(t);
+    return t;
+}
+
+static void node_free(struct lpm_lct_node *n)
+{
+    if (!n) { return; }
+    if (!lpm_lct_is_leaf(n)) {
+        struct lpm_lct_tnode *tn = (struct lpm_lct_tnode *)n;
+        for (uint32_t i = 0; i < (1U << n->bits); i++) {
+            node_free(tn->child[i]);
+        }
+    }
+    free(n);
+}
+
+void lpm_lctrie_destroy(struct lpm_lctrie *t)
+{
+    if (!t) { return; }
+    node_free(t->root);
+    free(t);
+}
+
+size_t lpm_lctrie_memory(const lpm_trie_t *trie)
+{
+    if (!trie || !trie->lctrie) { return 0; }
+    return sizeof(struct lpm_lctrie) + trie->lctrie->bytes;
+}
+
+static void node_repoint(struct lpm_lct_node *n, uint32_t old_nh, uint32_t new_nh)
+{
+    if (!n) { return; }
+    if (lpm_lct_is_leaf(n)) {
+        struct lpm_lct_leaf *l = (struct lpm_lct_leaf *)n;
+        for (uint32_t i = 0; i < n->count; i++) {
+            if (l->alias[i].next_hop == old_nh) {
+                l->alias[i].next_hop = new_nh;
+            }
+        }
+        return;
+    }
+    struct lpm_lct_tnode *tn = (struct lpm_lct_tnode *)n;
+    for (uint32_t i = 0; i < (1U << n->bits); i++) {
+        node_repoint(tn->child[i], old_nh, new_nh);
+    }
+}
+
+void lpm_lctrie_repoint(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    node_repoint(trie->lctrie->root, old_nh, new_nh);
+}
+
+/* ============================================================================
+ * Add / Delete
+ * ============================================================================ */
+
+static uint32_t lct_prefix(const uint8_t *prefix, uint8_t prefix_len)
+{
+    uint32_t p = ((uint32_t)prefix[0] << 24) | ((uint32_t)prefix[1] << 16) |
+                 ((uint32_t)prefix[2] << 8) | prefix[3];
+    return prefix_len ? p & (0xFFFFFFFFU << (32 - prefix_len)) : 0;
+}
+
+static int add_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    if (!trie || !trie->lctrie || !prefix || prefix_len > LPM_IPV4_MAX_DEPTH ||
+        next_hop == LPM_INVALID_NEXT_HOP) {
+        return -1;
+    }
+    int rc = lct_insert(trie->lctrie, lct_prefix(prefix, prefix_len),
+                        (uint8_t)(LPM_IPV4_MAX_DEPTH - prefix_len), next_hop);
+    if (rc < 0) { return -1; }
+    if (prefix_len == 0) {
+        trie->has_default_route = true;
+        trie->default_next_hop = next_hop;
+    }
+    trie->num_prefixes += (uint64_t)rc;
+    return 0;
+}
+
+int lpm_add_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    int rc = add_ipv4_lctrie(trie, prefix, prefix_len, next_hop);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
+
+static int delete_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (!trie || !trie->lctrie || !prefix || prefix_len > LPM_IPV4_MAX_DEPTH) {
+        return -1;
+    }
+    if (lct_remove(trie->lctrie, lct_prefix(prefix, prefix_len),
+                   (uint8_t)(LPM_IPV4_MAX_DEPTH - prefix_len)) != 0) {
+        return -1;
+    }
+    if (prefix_len == 0) {
+        trie->has_default_route = false;
+        trie->default_next_hop = LPM_INVALID_NEXT_HOP;
+    }
+    trie->num_prefixes--;
+    return 0;
+}
+
+int lpm_delete_ipv4_lctrie(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    int rc = delete_ipv4_lctrie(trie, prefix, prefix_len);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
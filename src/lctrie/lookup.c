@@ -0,0 +1,177 @@
+/*
+ * IPv4 LC-Trie Engine - Lookups
+ *
+ * A lookup follows the address down as far as the trie lets it. The leaf it
+ * ends on, if it covers the address, holds the longest match. Otherwise the
+ * match is a shorter prefix a/len with a = addr with its low 32 - len bits
+ * cleared: such a key sits under the same nodes as addr, except that where
+ * it takes a child index it has the low bits of addr's index cleared. So the
+ * walk backs up, clearing the lowest set bit of the index at each node in
+ * turn (the prefix gets shorter each time), and below the child it lands on
+ * follows index 0 only. The first alias that covers addr wins.
+ *
+ * The batch kernel descends several addresses in lock step, prefetching
+ * the node each lane lands on before the next round reads it, so the cache
+ * misses of different lanes overlap. A lane whose descent does not end on a
+ * covering leaf backs up from the path it recorded on the way down.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+#define LPM_LCT_BATCH_LANES 8
+
+/* ============================================================================
+ * Single Lookup
+ * ============================================================================ */
+
+/* Aliases under n that cover addr have suffixes longer than b, so their keys
+ * are zero from bit b down: they lie on the all-zero path */
+static const struct lpm_lct_alias *zero_descend(const struct lpm_lct_node *n, uint32_t addr, unsigned b)
+{
+    uint32_t low = (uint32_t)((2ULL << b) - 1);
+
+    while (n && n->slen > b && !(n->key & low)) {
+        if (lpm_lct_is_leaf(n)) {
+            return lpm_lct_leaf_match(n, addr);
+        }
+        n = ((const struct lpm_lct_tnode *)n)->child[0];
+    }
+    return NULL;
+}
+
+/* Back up from a failed descent: below each recorded node in turn, try the
+ * children with low index bits cleared, lowest set bit first, until the
+ * cleared bits pass the node's longest suffix */
+static inline uint32_t backtrack(const struct lpm_lct_tnode *const *path, uint32_t *cidx,
+                                 unsigned depth, uint32_t addr)
+{
+    const struct lpm_lct_alias *a;
+
+    while (depth) {
+        uint32_t idx = cidx[depth - 1];
+        if (!idx) {
+            depth--;
+            continue;
+        }
+        const struct lpm_lct_tnode *tn = path[depth - 1];
+        unsigned b = tn->n.pos + (unsigned)__builtin_ctz(idx);
+        if (b >= tn->n.slen) {
+            /* b only grows from here: nothing in tn is short enough */
+            depth--;
+            continue;
+        }
+        idx &= idx - 1;
+        cidx[depth - 1] = idx;
+        a = zero_descend(tn->child[idx], addr, b);
+        if (a) { return a->next_hop; }
+    }
+    return LPM_INVALID_NEXT_HOP;
+}
+
+__attribute__((hot))
+uint32_t lpm_lctrie_lookup(const struct lpm_lctrie *t, uint32_t addr)
+{
+    const struct lpm_lct_tnode *path[LPM_IPV4_MAX_DEPTH + 1];
+    uint32_t cidx[LPM_IPV4_MAX_DEPTH + 1];
+    unsigned depth = 0;
+    const struct lpm_lct_node *n = t->root;
+    const struct lpm_lct_alias *a;
+
+    while (n) {
+        if (lpm_lct_is_leaf(n)) {
+            a = lpm_lct_leaf_match(n, addr);
+            if (a) { return a->next_hop; }
+            break;
+        }
+        uint32_t idx = lpm_lct_index(addr, n);
+        if (idx >> n->bits) {
+            /* addr leaves the node above its index bits */
+            a = zero_descend(n, addr, 31u - (unsigned)__builtin_clz(addr ^ n->key));
+            if (a) { return a->next_hop; }
+            break;
+        }
+        path[depth] = (const struct lpm_lct_tnode *)n;
+        cidx[depth] = idx;
+        depth++;
+        n = path[depth - 1]->child[idx];
+    }
+    return backtrack(path, cidx, depth, addr);
+}
+
+uint32_t lpm_lookup_ipv4_lctrie(const lpm_trie_t *trie, uint32_t addr)
+{
+    if (!trie || !trie->lctrie) {
+        return LPM_INVALID_NEXT_HOP;
+    }
+    return lpm_lctrie_lookup(trie->lctrie, addr);
+}
+
+/* ============================================================================
+ * Batch Lookup - LPM_LCT_BATCH_LANES descents in lock step
+ * ============================================================================ */
+
+__attribute__((hot))
+void lpm_lookup_batch_ipv4_lctrie(const lpm_trie_t *trie, const uint32_t *addrs,
+                                  uint32_t *next_hops, size_t count)
+{
+    if (!trie || !trie->lctrie || !addrs || !next_hops) {
+        return;
+    }
+    const struct lpm_lctrie *t = trie->lctrie;
+    const struct lpm_lct_tnode *path[LPM_LCT_BATCH_LANES][LPM_IPV4_MAX_DEPTH + 1];
+    uint32_t cidx[LPM_LCT_BATCH_LANES][LPM_IPV4_MAX_DEPTH + 1];
+    unsigned depth[LPM_LCT_BATCH_LANES];
+    const struct lpm_lct_node *n[LPM_LCT_BATCH_LANES];
+    size_t i = 0;
+
+    for (; i + LPM_LCT_BATCH_LANES <= count; i += LPM_LCT_BATCH_LANES) {
+        const uint32_t *addr = &addrs[i];
+        unsigned active = (1u << LPM_LCT_BATCH_LANES) - 1;
+
+        for (unsigned j = 0; j < LPM_LCT_BATCH_LANES; j++) {
+            n[j] = t->root;
+            depth[j] = 0;
+        }
+
+        /* Each round moves every lane still on an internal node one level
+         * down and prefetches the node it lands on for the next round */
+        while (active) {
+            for (unsigned m = active; m; m &= m - 1) {
+                unsigned j = (unsigned)__builtin_ctz(m);
+                const struct lpm_lct_node *x = n[j];
+                uint32_t idx;
+                if (!x || lpm_lct_is_leaf(x) || ((idx = lpm_lct_index(addr[j], x)) >> x->bits)) {
+                    active &= ~(1u << j);
+                    continue;
+                }
+                path[j][depth[j]] = (const struct lpm_lct_tnode *)x;
+                cidx[j][depth[j]] = idx;
+                depth[j]++;
+                n[j] = ((const struct lpm_lct_tnode *)x)->child[idx];
+                if (n[j]) {
+                    __builtin_prefetch(n[j], 0, 3);
+                }
+            }
+        }
+
+        /* Most lanes end on a covering leaf; the rest back up from where
+         * their descent stopped */
+        for (unsigned j = 0; j < LPM_LCT_BATCH_LANES; j++) {
+            const struct lpm_lct_node *x = n[j];
+            const struct lpm_lct_alias *a = NULL;
+            if (x) {
+                a = lpm_lct_is_leaf(x) ? lpm_lct_leaf_match(x, addr[j])
+                                       : zero_descend(x, addr[j], 31u - (unsigned)__builtin_clz(addr[j] ^ x->key));
+            }
+            next_hops[i + j] = a ? a->next_hop : backtrack(path[j], cidx[j], depth[j], addr[j]);
+        }
+    }
+
+    for (; i < count; i++) {
+        next_hops[i] = lpm_lctrie_lookup(t, addrs[i]);
+    }
+}
@@ -0,0 +1,673 @@
+/*
+ * liblpm Bulk Loader
+ *
+ * Builds a trie from a route dump in three stages:
+ *   1. parse  - the memory-mapped file is split into per-thread ranges and
+ *               every thread collects (prefix, len, next_hop) records
+ *   2. sort   - records are bucketed by prefix length (stable counting sort,
+ *               scattered in parallel from per-thread histograms)
+ *   3. build  - records are inserted shortest-first with the hot cache
+ *               detached, so every engine's plain overwrite semantics yield
+ *               correct longest-prefix results without per-insert cache
+ *               flushes; tries with sharded writers are built by one
+ *               thread per group of shards after the routes spanning
+ *               several shards
+ *
+ * Text input is tokenised here and handed to lpm_parse_prefix_batch() in
+ * blocks. MRT input (RFC 6396 TABLE_DUMP_V2) is first walked once to index
+ * the RIB records, then the index is split across threads.
+ *
+ * lpm_load_prefix_file_pair() fills an IPv4 and an IPv6 trie from one parse:
+ * workers keep one record list per family, and the sort and build stages
+ * run once per trie.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LOAD_MAX_THREADS      64
+#define LOAD_BYTES_PER_THREAD (256 * 1024)  /* Smaller files use fewer threads */
+#define LOAD_PARSE_BLOCK      256
+#define LOAD_INITIAL_RECORDS  4096
+
+/* MRT (RFC 6396, RFC 8050) */
+#define MRT_HEADER_LEN                 12
+#define MRT_TYPE_TABLE_DUMP_V2         13
+#define MRT_RIB_IPV4_UNICAST           2
+#define MRT_RIB_IPV6_UNICAST           4
+#define MRT_RIB_IPV4_UNICAST_ADDPATH   8
+#define MRT_RIB_IPV6_UNICAST_ADDPATH   10
+
+typedef struct lpm_route load_record_t;
+
+/* Family index of the per-family arrays: 0 IPv4, 1 IPv6 */
+#define LOAD_FAMILY(max_depth) ((max_depth) == LPM_IPV6_MAX_DEPTH)
+
+/* One worker's records of one address family */
+typedef struct {
+    load_record_t *recs;
+    size_t count;
+    size_t capacity;
+    size_t hist[LPM_IPV6_MAX_DEPTH + 1];   /* Sort stage */
+} load_family_t;
+
+typedef struct {
+    const uint8_t *base;
+    bool want[2];       /* Families collected; the other one is skipped */
+
+    /* Text: byte range [begin, end); MRT: record offsets [begin, end) */
+    size_t begin;
+    size_t end;
+    const size_t *mrt_offsets;
+
+    load_family_t fam[2];
+
+    uint64_t records;
+    uint64_t skipped;
+    uint64_t errors;
+    int failed;
+
+    /* Sort stage */
+    unsigned sort_family;
+    load_record_t *sorted;
+} load_worker_t;
+
+static inline uint16_t load_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static load_record_t *worker_push(load_worker_t *w, unsigned family)
+{
+    load_family_t *f = &w->fam[family];
+    if (f->count == f->capacity) {
+        size_t cap = f->capacity ? f->capacity * 2 : LOAD_INITIAL_RECORDS;
+        load_record_t *recs = realloc(f->recs, cap * sizeof(*recs));
+        if (!recs) {
+            w->failed = 1;
+            return NULL;
+        }
+        f->recs = recs;
+        f->capacity = cap;
+    }
+    return &f->recs[f->count++];
+}
+
+/* ============================================================================
+ * Text Parsing
+ * ============================================================================ */
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static void text_flush(load_worker_t *w, const char **strs, const size_t *lens,
+                       const uint32_t *nhs, size_t n)
+{
+    uint8_t prefixes[LOAD_PARSE_BLOCK][16];
+    uint8_t plens[LOAD_PARSE_BLOCK];
+    uint8_t depths[LOAD_PARSE_BLOCK];
+    uint8_t status[LOAD_PARSE_BLOCK];
+
+    lpm_parse_prefix_batch(strs, lens, prefixes, plens, depths, status, n);
+
+    for (size_t i = 0; i < n; i++) {
+        if (status[i] != LPM_PARSE_OK) {
+            w->errors++;
+            continue;
+        }
+        unsigned family = LOAD_FAMILY(depths[i]);
+        if (!w->want[family]) {
+            w->skipped++;
+            continue;
+        }
+        load_record_t *r = worker_push(w, family);
+        if (!r) { return; }
+        memcpy(r->prefix, prefixes[i], 16);
+        r->len = plens[i];
+        r->next_hop = nhs[i];
+    }
+}
+
+static void text_parse_range(load_worker_t *w)
+{
+    const char *p = (const char *)w->base + w->begin;
+    const char *end = (const char *)w->base + w->end;
+
+    const char *strs[LOAD_PARSE_BLOCK];
+    size_t lens[LOAD_PARSE_BLOCK];
+    uint32_t nhs[LOAD_PARSE_BLOCK];
+    size_t n = 0;
+
+    while (p < end && !w->failed) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *le = nl ? nl : end;
+
+        while (p < le && is_blank(*p)) { p++; }
+        if (p == le || *p == '#') {
+            p = le + 1;
+            continue;
+        }
+        w->records++;
+
+        const char *tok = p;
+        while (p < le && !is_blank(*p) && *p != '#') { p++; }
+        size_t tok_len = (size_t)(p - tok);
+
+        while (p < le && is_blank(*p)) { p++; }
+
+        /* Optional decimal next-hop column */
+        uint64_t nh = 0;
+        bool bad = false;
+        if (p < le && *p != '#') {
+            const char *digits = p;
+            while (p < le && *p >= '0' && *p <= '9' && p - digits < 11) {
+                nh = nh * 10 + (uint64_t)(*p - '0');
+                p++;
+            }
+            while (p < le && is_blank(*p)) { p++; }
+            bad = p == digits || nh >= LPM_INVALID_NEXT_HOP || (p < le && *p != '#');
+        }
+        p = le + 1;
+
+        if (bad) {
+            w->errors++;
+            continue;
+        }
+
+        strs[n] = tok;
+        lens[n] = tok_len;
+        nhs[n] = (uint32_t)nh;
+        if (++n == LOAD_PARSE_BLOCK) {
+            text_flush(w, strs, lens, nhs, n);
+            n = 0;
+        }
+    }
+
+    if (n > 0 && !w->failed) {
+        text_flush(w, strs, lens, nhs, n);
+    }
+}
+
+/* ============================================================================
+ * MRT TABLE_DUMP_V2 Parsing
+ * ============================================================================ */
+
+static bool mrt_is_rib(uint16_t subtype, bool *ipv6, bool *addpath)
+{
+    switch (subtype) {
+    case MRT_RIB_IPV4_UNICAST:         *ipv6 = false; *addpath = false; return true;
+    case MRT_RIB_IPV6_UNICAST:         *ipv6 = true;  *addpath = false; return true;
+    case MRT_RIB_IPV4_UNICAST_ADDPATH: *ipv6 = false; *addpath = true;  return true;
+    case MRT_RIB_IPV6_UNICAST_ADDPATH: *ipv6 = true;  *addpath = true;  return true;
+    default: return false;
+    }
+}
+
+static bool mrt_detect(const uint8_t *base, size_t size)
+{
+    /* Text never contains NUL bytes, the MRT type field always starts with one */
+    return size >= MRT_HEADER_LEN &&
+           load_be16(base + 4) == MRT_TYPE_TABLE_DUMP_V2 &&
+           load_be32(base + 8) <= size - MRT_HEADER_LEN;
+}
+
+/*
+ * Walk the record headers once, keeping the offsets of RIB records in the
+ * wanted families. Returns the number of offsets or (size_t)-1 on allocation
+ * failure; a truncated trailing record counts as one error.
+ */
+static size_t mrt_index(const uint8_t *base, size_t size, const bool want[2],
+                        size_t **out, uint64_t *skipped, uint64_t *errors)
+{
+    size_t n = 0, cap = LOAD_INITIAL_RECORDS;
+    size_t *offs = malloc(cap * sizeof(*offs));
+    if (!offs) { return (size_t)-1; }
+
+    size_t off = 0;
+    while (size - off >= MRT_HEADER_LEN) {
+        const uint8_t *h = base + off;
+        uint32_t len = load_be32(h + 8);
+        if (len > size - off - MRT_HEADER_LEN) {
+            (*errors)++;
+            break;
+        }
+
+        bool ipv6, addpath;
+        if (load_be16(h + 4) == MRT_TYPE_TABLE_DUMP_V2 &&
+            mrt_is_rib(load_be16(h + 6), &ipv6, &addpath)) {
+            if (!want[ipv6]) {
+                (*skipped)++;
+            } else {
+                if (n == cap) {
+                    cap *= 2;
+                    size_t *grown = realloc(offs, cap * sizeof(*offs));
+                    if (!grown) {
+                        free(offs);
+                        return (size_t)-1;
+                    }
+                    offs = grown;
+                }
+                offs[n++] = off;
+            }
+        }
+        off += MRT_HEADER_LEN + len;
+    }
+
+    *out = offs;
+    return n;
+}
+
+static void mrt_parse_range(load_worker_t *w)
+{
+    for (size_t i = w->begin; i < w->end && !w->failed; i++) {
+        const uint8_t *h = w->base + w->mrt_offsets[i];
+        const uint8_t *p = h + MRT_HEADER_LEN;
+        const uint8_t *end = p + load_be32(h + 8);
+        bool ipv6 = false, addpath = false;
+        mrt_is_rib(load_be16(h + 6), &ipv6, &addpath);
+        w->records++;
+
+        /* sequence(4) prefix_len(1) prefix(var) entry_count(2) */
+        if (end - p < 5 || p[4] > (ipv6 ? LPM_IPV6_MAX_DEPTH : LPM_IPV4_MAX_DEPTH)) {
+            w->errors++;
+            continue;
+        }
+        uint8_t plen = p[4];
+        uint8_t nbytes = (uint8_t)((plen + 7) / 8);
+        p += 5;
+        if (end - p < nbytes + 2) {
+            w->errors++;
+            continue;
+        }
+
+        load_record_t *r = worker_push(w, ipv6);
+        if (!r) { return; }
+        memset(r->prefix, 0, sizeof(r->prefix));
+        memcpy(r->prefix, p, nbytes);
+        if (plen & 7) {
+            r->prefix[nbytes - 1] &= (uint8_t)(0xFF << (8 - (plen & 7)));
+        }
+        r->len = plen;
+        p += nbytes;
+
+        /* First RIB entry: peer_index(2) originated(4) [path_id(4)] attr_len(2) */
+        uint16_t entries = load_be16(p);
+        p += 2;
+        size_t entry_min = addpath ? 12 : 8;
+        if (entries > 0 && (size_t)(end - p) >= entry_min) {
+            r->next_hop = load_be16(p);
+        } else {
+            r->next_hop = 0;
+        }
+    }
+}
+
+static void *parse_worker_main(void *arg)
+{
+    load_worker_t *w = arg;
+    if (w->mrt_offsets) {
+        mrt_parse_range(w);
+    } else {
+        text_parse_range(w);
+    }
+    return NULL;
+}
+
+/* Run fn on each of the n workers of size bytes at w, the last one on the
+ * calling thread */
+static void run_workers(void *w, size_t size, unsigned n, void *(*fn)(void *))
+{
+    pthread_t tids[LOAD_MAX_THREADS];
+    unsigned started = 0;
+    for (unsigned i = 0; i + 1 < n; i++) {
+        if (pthread_create(&tids[i], NULL, fn, (char *)w + i * size) != 0) { break; }
+        started++;
+    }
+    for (unsigned i = started; i < n; i++) {
+        fn((char *)w + i * size);
+    }
+    for (unsigned i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+/* ============================================================================
+ * Sort by Prefix Length
+ * ============================================================================ */
+
+static void *scatter_worker_main(void *arg)
+{
+    load_worker_t *w = arg;
+    load_family_t *f = &w->fam[w->sort_family];
+    size_t *pos = f->hist;  /* Holds this worker's start offsets by now */
+    for (size_t i = 0; i < f->count; i++) {
+        w->sorted[pos[f->recs[i].len]++] = f->recs[i];
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Build
+ * ============================================================================ */
+
+typedef int (*load_add_fn)(lpm_trie_t *, const uint8_t *, uint8_t, uint32_t);
+
+typedef struct {
+    lpm_trie_t *trie;
+    load_add_fn add;
+    const load_record_t *recs;
+    size_t count;
+    unsigned index;      /* Shards s with s % stride == index */
+    unsigned stride;
+    uint64_t failed;
+} build_worker_t;
+
+static load_add_fn load_select_add(const lpm_trie_t *trie)
+{
+    if (trie->set || trie->nh_index || trie->adapt) {
+        return lpm_add;
+    }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        if (trie->use_ipv4_dir24 && (trie->dir24_table || trie->dir24c_table)) {
+            return lpm_add_ipv4_dir24;
+        }
+        if (trie->small) {
+            return lpm_add_ipv4_small;
+        }
+        if (trie->lctrie) {
+            return lpm_add_ipv4_lctrie;
+        }
+        return lpm_add_ipv4_8stride;
+    }
+    if (trie->max_depth == LPM_IPV6_MAX_DEPTH) {
+        if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
+            return lpm_add_ipv6_wide16;
+        }
+        return lpm_add_ipv6_8stride;
+    }
+    return NULL;
+}
+
+static void *build_worker_main(void *arg)
+{
+    build_worker_t *b = arg;
+    for (size_t i = 0; i < b->count; i++) {
+        int s = lpm_shard_of(b->trie, b->recs[i].prefix, b->recs[i].len);
+        if ((unsigned)s % b->stride == b->index &&
+            b->add(b->trie, b->recs[i].prefix, b->recs[i].len, b->recs[i].next_hop) != 0) {
+            b->failed++;
+        }
+    }
+    return NULL;
+}
+
+/* Each shard's routes still go in shortest-first, on the thread owning it */
+static uint64_t load_build_sharded(lpm_trie_t *trie, load_add_fn add,
+                                   const load_record_t *recs, size_t count, unsigned threads)
+{
+    uint64_t failed = 0;
+    size_t i = 0;
+    for (; i < count && lpm_shard_of(trie, recs[i].prefix, recs[i].len) < 0; i++) {
+        if (add(trie, recs[i].prefix, recs[i].len, recs[i].next_hop) != 0) {
+            failed++;
+        }
+    }
+
+    build_worker_t b[LOAD_MAX_THREADS];
+    if (threads > lpm_shard_count(trie)) { threads = lpm_shard_count(trie); }
+    for (unsigned t = 0; t < threads; t++) {
+        b[t] = (build_worker_t){ .trie = trie, .add = add, .recs = &recs[i], .count = count - i,
+                                 .index = t, .stride = threads };
+    }
+    run_workers(b, sizeof(b[0]), threads, build_worker_main);
+    for (unsigned t = 0; t < threads; t++) {
+        failed += b[t].failed;
+    }
+    return failed;
+}
+
+static uint64_t load_build(lpm_trie_t *trie, load_add_fn add,
+                           const load_record_t *recs, size_t count, unsigned threads)
+{
+    /* The stride engines flush the whole hot cache on every insert; detach
+     * it for the duration of the build and flush once at the end. */
+    struct lpm_cache_entry *cache = trie->hot_cache;
+    trie->hot_cache = NULL;
+
+    uint64_t failed = 0;
+    if (trie->agg) {
+        /* Record every route, then install the minimized set in one pass */
+        for (size_t i = 0; i < count; i++) {
+            if (lpm_agg_stage(trie, recs[i].prefix, recs[i].len, recs[i].next_hop) != 0) {
+                failed++;
+            }
+        }
+        if (lpm_agg_commit(trie) != 0) {
+            failed = count;
+        }
+    } else if (add == lpm_add_ipv4_dir24 && lpm_dir24_build(trie, recs, count, &failed) == 0) {
+        /* Empty DIR-24-8 table: filled directly from the sorted routes */
+    } else if (trie->shards && threads > 1) {
+        failed = load_build_sharded(trie, add, recs, count, threads);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (add(trie, recs[i].prefix, recs[i].len, recs[i].next_hop) != 0) {
+                failed++;
+            }
+        }
+    }
+
+    trie->hot_cache = cache;
+    if (cache) {
+        memset(cache, 0, LPM_HOT_CACHE_SIZE * sizeof(struct lpm_cache_entry));
+    }
+    return failed;
+}
+
+/* ============================================================================
+ * Public Entry Point
+ * ============================================================================ */
+
+static unsigned load_thread_count(unsigned requested, size_t work_bytes)
+{
+    unsigned n = requested;
+    if (n == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (unsigned)cpus : 1;
+    }
+    size_t by_size = work_bytes / LOAD_BYTES_PER_THREAD + 1;
+    if (n > by_size) { n = (unsigned)by_size; }
+    if (n > LOAD_MAX_THREADS) { n = LOAD_MAX_THREADS; }
+    return n;
+}
+
+/* Sort one family's records by length across the workers and build trie */
+static int load_family(lpm_trie_t *trie, load_worker_t *w, unsigned n, unsigned family,
+                       lpm_load_stats_t *stats)
+{
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    size_t total = 0;
+    for (unsigned i = 0; i < n; i++) {
+        total += w[i].fam[family].count;
+    }
+
+    /* ---- Sort: stable counting sort on prefix length ---- */
+    load_record_t *sorted = malloc((total ? total : 1) * sizeof(*sorted));
+    if (!sorted) { return -1; }
+
+    for (unsigned i = 0; i < n; i++) {
+        load_family_t *f = &w[i].fam[family];
+        for (size_t j = 0; j < f->count; j++) {
+            f->hist[f->recs[j].len]++;
+        }
+    }
+    /* Per-worker start offsets: length-major, worker order within a length */
+    size_t pos = 0;
+    for (unsigned l = 0; l <= trie->max_depth; l++) {
+        for (unsigned i = 0; i < n; i++) {
+            size_t c = w[i].fam[family].hist[l];
+            w[i].fam[family].hist[l] = pos;
+            pos += c;
+        }
+    }
+    for (unsigned i = 0; i < n; i++) {
+        w[i].sort_family = family;
+        w[i].sorted = sorted;
+    }
+    run_workers(w, sizeof(*w), n, scatter_worker_main);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    /* ---- Build ---- */
+    uint64_t failed = load_build(trie, load_select_add(trie), sorted, total, n);
+    free(sorted);
+    stats->loaded += total - failed;
+    stats->errors += failed;
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    stats->sort_ms += lpm_elapsed_ms(&t0, &t1);
+    stats->build_ms += lpm_elapsed_ms(&t1, &t2);
+
+    /* Bulk inserts bypass the journal; persist them as a new snapshot */
+    if (trie->journal && total) {
+        return lpm_snapshot(trie);
+    }
+    return 0;
+}
+
+/* tries[0] IPv4 and tries[1] IPv6, either may be NULL */
+static int load_file(lpm_trie_t *tries[2], const char *path, unsigned num_threads,
+                     lpm_load_stats_t *stats)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+    const uint8_t *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) { return -1; }
+    madvise((void *)base, size, MADV_SEQUENTIAL);
+
+    int rc = -1;
+    unsigned n = 0;
+    size_t *mrt_offsets = NULL;
+    load_worker_t *w = NULL;
+    const bool want[2] = {tries[0] != NULL, tries[1] != NULL};
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    /* ---- Parse ---- */
+    size_t units = size;  /* Bytes for text, records for MRT */
+    stats->mrt = mrt_detect(base, size);
+    if (stats->mrt) {
+        units = mrt_index(base, size, want, &mrt_offsets, &stats->skipped, &stats->errors);
+        if (units == (size_t)-1) { goto out; }
+    }
+
+    n = load_thread_count(num_threads, size);
+    w = calloc(n, sizeof(*w));
+    if (!w) { goto out; }
+
+    for (unsigned i = 0; i < n; i++) {
+        w[i].base = base;
+        w[i].want[0] = want[0];
+        w[i].want[1] = want[1];
+        w[i].mrt_offsets = mrt_offsets;
+        w[i].begin = units * i / n;
+        w[i].end = units * (i + 1) / n;
+    }
+    if (!stats->mrt) {
+        /* Move every boundary past the next newline so lines are not split */
+        for (unsigned i = 1; i < n; i++) {
+            size_t b = w[i].begin;
+            const uint8_t *nl = b < size ? memchr(base + b, '\n', size - b) : NULL;
+            b = nl ? (size_t)(nl - base) + 1 : size;
+            if (b < w[i - 1].begin) { b = w[i - 1].begin; }
+            w[i - 1].end = b;
+            w[i].begin = b;
+        }
+    }
+    run_workers(w, sizeof(*w), n, parse_worker_main);
+
+    for (unsigned i = 0; i < n; i++) {
+        if (w[i].failed) { goto out; }
+        stats->records += w[i].records;
+        stats->skipped += w[i].skipped;
+        stats->errors += w[i].errors;
+    }
+    stats->threads = n;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    stats->parse_ms = lpm_elapsed_ms(&t0, &t1);
+
+    rc = 0;
+    for (unsigned f = 0; f < 2 && rc == 0; f++) {
+        if (tries[f]) {
+            rc = load_family(tries[f], w, n, f, stats);
+        }
+    }
+
+out:
+    if (w) {
+        for (unsigned i = 0; i < n; i++) {
+            free(w[i].fam[0].recs);
+            free(w[i].fam[1].recs);
+        }
+        free(w);
+    }
+    free(mrt_offsets);
+    munmap((void *)base, size);
+    return rc;
+}
+
+int lpm_load_prefix_file(lpm_trie_t *trie, const char *path, unsigned num_threads,
+                         lpm_load_stats_t *stats)
+{
+    lpm_load_stats_t local;
+    if (!stats) { stats = &local; }
+    memset(stats, 0, sizeof(*stats));
+
+    if (!trie || !path || !load_select_add(trie)) { return -1; }
+    lpm_trie_t *tries[2] = {NULL, NULL};
+    tries[LOAD_FAMILY(trie->max_depth)] = trie;
+    return load_file(tries, path, num_threads, stats);
+}
+
+int lpm_load_prefix_file_pair(lpm_trie_t *ipv4, lpm_trie_t *ipv6, const char *path,
+                              unsigned num_threads, lpm_load_stats_t *stats)
+{
+    lpm_load_stats_t local;
+    if (!stats) { stats = &local; }
+    memset(stats, 0, sizeof(*stats));
+
+    if (!path || (!ipv4 && !ipv6) ||
+        (ipv4 && (ipv4->max_depth != LPM_IPV4_MAX_DEPTH || !load_select_add(ipv4))) ||
+        (ipv6 && (ipv6->max_depth != LPM_IPV6_MAX_DEPTH || !load_select_add(ipv6)))) {
+        return -1;
+    }
+    lpm_trie_t *tries[2] = {ipv4, ipv6};
+    return load_file(tries, path, num_threads, stats);
+}
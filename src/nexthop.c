@@ -0,0 +1,485 @@
+/*
+ * liblpm Next-Hop Index
+ *
+ * Optional reverse map from next hop to the prefixes using it, kept by
+ * lpm_add()/lpm_delete() once lpm_enable_next_hop_index() is called. When a
+ * peer goes away, lpm_replace_next_hop() walks only that next hop's prefixes
+ * and rewrites the table entries inside each of them, instead of scanning
+ * every route.
+ *
+ * Each indexed prefix is a ref on a doubly linked list per next hop (the list
+ * heads live in a small open-addressing table keyed on the next hop); a rule
+ * table maps (prefix, length) to its ref, as in the expiry wheel.
+ *
+ * Rewrites are value based: every entry in a prefix's span that holds the old
+ * next hop gets the new one, whichever prefix wrote it, since all of them are
+ * being repointed. Each entry changes with a single store, so a concurrent
+ * lookup returns the old or the new next hop for an address, never anything
+ * else.
+ *
+ * The rewrite as a whole is published like a seqlock: trie->replace_seq turns
+ * odd before the first entry changes and even after the last one. Batch
+ * lookups read it around the batch and run again if it moved, so a batch
+ * never mixes results from before and after a replacement. Copying the
+ * touched tbl8 groups and stride nodes aside and swapping them in would not
+ * cover DIR-24-8 spans, which live in the 64 MB first-level table itself.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_NH_LISTS_INITIAL 64     /* Power of two */
+
+struct lpm_nh_ref {
+    uint32_t next;            /* 0 terminates (ref 0 is never used) */
+    uint32_t prev;
+    uint32_t next_hop;
+    uint8_t len;
+    uint8_t prefix[16];
+};
+
+struct lpm_nh_list {
+    uint32_t next_hop;
+    uint32_t head;
+    uint32_t count;
+    bool used;
+};
+
+struct lpm_nh_index {
+    struct lpm_nh_ref *refs;
+    uint32_t capacity;
+    uint32_t used;            /* High-water mark */
+    uint32_t free_head;
+    struct lpm_nh_list *lists;
+    uint32_t list_capacity;
+    uint32_t list_used;
+    struct lpm_rule_table *where;  /* (prefix, len) -> ref, in next_hop */
+};
+
+/* ============================================================================
+ * Lists
+ * ============================================================================ */
+
+static uint32_t list_slot(const struct lpm_nh_index *x, uint32_t next_hop)
+{
+    return (uint32_t)(((uint64_t)next_hop * 0x9E3779B97F4A7C15ULL) >> 32) & (x->list_capacity - 1);
+}
+
+static struct lpm_nh_list *list_find(const struct lpm_nh_index *x, uint32_t next_hop)
+{
+    for (uint32_t s = list_slot(x, next_hop); x->lists[s].used; s = (s + 1) & (x->list_capacity - 1)) {
+        if (x->lists[s].next_hop == next_hop) {
+            return &x->lists[s];
+        }
+    }
+    return NULL;
+}
+
+static int lists_grow(struct lpm_nh_index *x)
+{
+    uint32_t old_cap = x->list_capacity;
+    struct lpm_nh_list *old = x->lists;
+    struct lpm_nh_list *lists = calloc((size_t)old_cap * 2, sizeof(*lists));
+    if (!lists) { return -1; }
+
+    /* Emptied lists are dropped here */
+    x->lists = lists;
+    x->list_capacity = old_cap * 2;
+    x->list_used = 0;
+    for (uint32_t i = 0; i < old_cap; i++) {
+        if (!old[i].used || !old[i].count) { continue; }
+        uint32_t s = list_slot(x, old[i].next_hop);
+        while (lists[s].used) {
+            s = (s + 1) & (x->list_capacity - 1);
+        }
+        lists[s] = old[i];
+        x->list_used++;
+    }
+    free(old);
+    return 0;
+}
+
+static struct lpm_nh_list *list_get(struct lpm_nh_index *x, uint32_t next_hop)
+{
+    struct lpm_nh_list *l = list_find(x, next_hop);
+    if (l) { return l; }
+
+    /* Keep the load factor at or below 1/2 */
+    if ((x->list_used + 1) * 2 > x->list_capacity && lists_grow(x) < 0) { return NULL; }
+
+    uint32_t s = list_slot(x, next_hop);
+    while (x->lists[s].used) {
+        s = (s + 1) & (x->list_capacity - 1);
+    }
+    l = &x->lists[s];
+    l->used = true;
+    l->next_hop = next_hop;
+    l->head = 0;
+    l->count = 0;
+    x->list_used++;
+    return l;
+}
+
+static void ref_link(struct lpm_nh_index *x, struct lpm_nh_list *l, uint32_t r)
+{
+    struct lpm_nh_ref *ref = &x->refs[r];
+    ref->next_hop = l->next_hop;
+    ref->prev = 0;
+    ref->next = l->head;
+    if (ref->next) {
+        x->refs[ref->next].prev = r;
+    }
+    l->head = r;
+    l->count++;
+}
+
+static void ref_unlink(struct lpm_nh_index *x, uint32_t r)
+{
+    struct lpm_nh_ref *ref = &x->refs[r];
+    struct lpm_nh_list *l = list_find(x, ref->next_hop);
+    if (ref->prev) {
+        x->refs[ref->prev].next = ref->next;
+    } else {
+        l->head = ref->next;
+    }
+    if (ref->next) {
+        x->refs[ref->next].prev = ref->prev;
+    }
+    l->count--;
+}
+
+static uint32_t ref_alloc(struct lpm_nh_index *x)
+{
+    if (x->free_head) {
+        uint32_t r = x->free_head;
+        x->free_head = x->refs[r].next;
+        return r;
+    }
+    if (x->used == x->capacity) {
+        uint32_t cap = x->capacity * 2;
+        struct lpm_nh_ref *refs = realloc(x->refs, (size_t)cap * sizeof(*refs));
+        if (!refs) { return 0; }
+        x->refs = refs;
+        x->capacity = cap;
+    }
+    return x->used++;
+}
+
+/* ============================================================================
+ * Engine Rewrites
+ * ============================================================================ */
+
+/* Stride engines keep a prefix's next hop in the node entries at its own
+ * level, so only those entries need rewriting */
+static void stride_repoint(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                           uint32_t old_nh, uint32_t new_nh)
+{
+    unsigned wide_levels = (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) ?
+                           trie->wide_levels : 0;
+    uint32_t node_idx = trie->root_idx;
+    uint8_t depth = 0;
+
+    for (unsigned level = 0;; level++) {
+        bool wide = level < wide_levels;
+        uint8_t stride = wide ? 16 : 8;
+        if (wide && level > 0) {
+            /* Sparse 16-bit node: rewrite its runs, or follow the child */
+            uint32_t index = ((uint32_t)prefix[depth / 8] << 8) | prefix[(depth / 8) + 1];
+            if (depth + 16 >= prefix_len) {
+                uint32_t count = 1U << (16 - (prefix_len - depth));
+                index &= ~(count - 1);
+                lpm_sparse16_repoint(trie->sparse16, node_idx, index, index + count - 1, old_nh, new_nh);
+                return;
+            }
+            uint32_t child = lpm_sparse16_find(trie->sparse16, node_idx, (uint16_t)index)->child_and_valid &
+                             LPM_CHILD_MASK;
+            if (child == LPM_INVALID_INDEX) { return; }
+            node_idx = child;
+            depth += stride;
+            continue;
+        }
+        struct lpm_entry *entries = wide ? ((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx].entries
+                                         : ((struct lpm_node *)trie->node_pool)[node_idx].entries;
+        uint32_t index = wide ? ((uint32_t)prefix[depth / 8] << 8) | prefix[(depth / 8) + 1]
+                              : prefix[depth / 8];
+
+        if (depth + stride >= prefix_len) {
+            uint32_t count = 1U << (stride - (prefix_len - depth));
+            index &= ~(count - 1);
+            for (uint32_t i = index; i < index + count; i++) {
+                if ((entries[i].child_and_valid & LPM_VALID_FLAG) && entries[i].next_hop == old_nh) {
+                    entries[i].next_hop = new_nh;
+                }
+            }
+            return;
+        }
+
+        uint32_t child = entries[index].child_and_valid & LPM_CHILD_MASK;
+        if (child == LPM_INVALID_INDEX) { return; }
+        node_idx = child;
+        depth += stride;
+    }
+}
+
+static void direct_repoint(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                           uint32_t old_nh, uint32_t new_nh)
+{
+    if (!trie->direct_table || prefix_len > 16) { return; }
+
+    uint32_t count = 1U << (16 - prefix_len);
+    uint32_t base = (((uint32_t)prefix[0] << 8) | prefix[1]) & ~(count - 1);
+    for (uint32_t i = base; i < base + count; i++) {
+        struct lpm_direct_entry *e = &trie->direct_table[i];
+        if (e->prefix_len && e->next_hop == old_nh) {
+            e->next_hop = new_nh;
+        }
+    }
+}
+
+static void engine_repoint(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                           uint32_t old_nh, uint32_t new_nh)
+{
+    if (prefix_len == 0) { return; }     /* Default route: done by the caller */
+
+    if (trie->dir24_table || trie->dir24c_table) {
+        lpm_dir24_repoint(trie, prefix, prefix_len, old_nh, new_nh);
+        struct lpm_rule *r = lpm_rules_find(trie->rules, prefix, prefix_len);
+        if (r) {
+            r->next_hop = new_nh;
+        }
+        return;
+    }
+    stride_repoint(trie, prefix, prefix_len, old_nh, new_nh);
+    direct_repoint(trie, prefix, prefix_len, old_nh, new_nh);
+}
+
+/* No index: rewrite every table entry */
+static void engine_repoint_all(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    static const uint8_t zero[16];
+
+    if (trie->dir24_table || trie->dir24c_table) {
+        lpm_dir24_repoint(trie, zero, 0, old_nh, new_nh);
+        for (uint32_t i = 0; i < trie->rules->capacity; i++) {
+            struct lpm_rule *r = &trie->rules->slots[i];
+            if (r->used && r->next_hop == old_nh) {
+                r->next_hop = new_nh;
+            }
+        }
+        return;
+    }
+
+    for (uint32_t n = 0; n < trie->wide_pool_used; n++) {
+        struct lpm_entry *e = ((struct lpm_node_16 *)trie->wide_nodes_pool)[n].entries;
+        for (uint32_t i = 0; i < LPM_STRIDE_SIZE_16; i++) {
+            if ((e[i].child_and_valid & LPM_VALID_FLAG) && e[i].next_hop == old_nh) {
+                e[i].next_hop = new_nh;
+            }
+        }
+    }
+    if (trie->sparse16) {
+        lpm_sparse16_repoint_all(trie->sparse16, old_nh, new_nh);
+    }
+    for (uint32_t n = 0; n < trie->pool_used; n++) {
+        struct lpm_entry *e = ((struct lpm_node *)trie->node_pool)[n].entries;
+        for (uint32_t i = 0; i < LPM_STRIDE_SIZE_8; i++) {
+            if ((e[i].child_and_valid & LPM_VALID_FLAG) && e[i].next_hop == old_nh) {
+                e[i].next_hop = new_nh;
+            }
+        }
+    }
+    direct_repoint(trie, zero, 0, old_nh, new_nh);
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+int lpm_nh_index_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    struct lpm_nh_index *x = trie->nh_index;
+
+    const struct lpm_rule *w = lpm_rules_find(x->where, prefix, prefix_len);
+    uint32_t r = w ? w->next_hop : 0;
+    if (r && x->refs[r].next_hop == next_hop) { return 0; }
+
+    struct lpm_nh_list *l = list_get(x, next_hop);
+    if (!l) { return -1; }
+    if (r) {
+        ref_unlink(x, r);
+        ref_link(x, l, r);
+        return 0;
+    }
+
+    r = ref_alloc(x);
+    if (!r || lpm_rules_insert(x->where, prefix, prefix_len, r, NULL) < 0) {
+        if (r) {
+            x->refs[r].next = x->free_head;
+            x->free_head = r;
+        }
+        return -1;
+    }
+    struct lpm_nh_ref *ref = &x->refs[r];
+    ref->len = prefix_len;
+    memset(ref->prefix, 0, sizeof(ref->prefix));
+    memcpy(ref->prefix, prefix, (prefix_len + 7) / 8);
+    ref_link(x, l, r);
+    return 0;
+}
+
+void lpm_nh_index_clear(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    struct lpm_nh_index *x = trie->nh_index;
+
+    const struct lpm_rule *w = lpm_rules_find(x->where, prefix, prefix_len);
+    if (!w) { return; }
+    uint32_t r = w->next_hop;
+    lpm_rules_remove(x->where, prefix, prefix_len);
+    ref_unlink(x, r);
+    x->refs[r].next = x->free_head;
+    x->free_head = r;
+}
+
+void lpm_nh_index_destroy(struct lpm_nh_index *x)
+{
+    if (!x) { return; }
+    lpm_rules_destroy(x->where);
+    free(x->lists);
+    free(x->refs);
+    free(x);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_enable_next_hop_index(lpm_trie_t *trie)
+{
+    if (!trie || trie->set || trie->async) { return -1; }
+    if (trie->nh_index) { return 0; }
+
+    /* Existing routes can be indexed only from a rule store */
+    lpm_update_flush(trie);
+    bool from_rules = trie->rules && !trie->agg;
+    if (lpm_route_count(trie) && !from_rules) { return -1; }
+    if (trie->journal && !trie->rules) { return -1; }   /* Not restorable */
+    if (trie->shards) { return -1; }                     /* Rules are split by shard */
+
+    struct lpm_nh_index *x = calloc(1, sizeof(*x));
+    if (!x) { return -1; }
+    x->capacity = 64;
+    x->used = 1;   /* Ref 0 is the list terminator */
+    x->refs = malloc((size_t)x->capacity * sizeof(*x->refs));
+    x->list_capacity = LPM_NH_LISTS_INITIAL;
+    x->lists = calloc(x->list_capacity, sizeof(*x->lists));
+    x->where = lpm_rules_create();
+    if (!x->refs || !x->lists || !x->where) {
+        lpm_nh_index_destroy(x);
+        return -1;
+    }
+    trie->nh_index = x;
+
+    if (from_rules) {
+        for (uint32_t i = 0; i < trie->rules->capacity; i++) {
+            const struct lpm_rule *r = &trie->rules->slots[i];
+            if (r->used && lpm_nh_index_set(trie, r->prefix, r->len, r->next_hop) < 0) {
+                trie->nh_index = NULL;
+                lpm_nh_index_destroy(x);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+size_t lpm_next_hop_count(const lpm_trie_t *trie, uint32_t next_hop)
+{
+    if (!trie || !trie->nh_index) { return 0; }
+    const struct lpm_nh_list *l = list_find(trie->nh_index, next_hop);
+    return l ? l->count : 0;
+}
+
+int lpm_replace_next_hop(lpm_trie_t *trie, uint32_t old_next_hop, uint32_t new_next_hop)
+{
+    if (!trie || trie->set || new_next_hop == LPM_INVALID_NEXT_HOP) { return -1; }
+    if ((trie->dir24_table || trie->dir24c_table) && new_next_hop > lpm_dir24_max_next_hop(trie)) {
+        return -1;
+    }
+    if (old_next_hop == new_next_hop) { return 0; }
+
+    /* Queued updates carry next hops too; land them first */
+    lpm_update_flush(trie);
+
+    struct lpm_nh_index *x = trie->nh_index;
+    struct lpm_nh_list *from = x ? list_find(x, old_next_hop) : NULL;
+    struct lpm_nh_list *to = NULL;
+    if (from && from->count) {
+        to = list_get(x, new_next_hop);
+        if (!to) { return -1; }
+        from = list_find(x, old_next_hop);   /* list_get() may have rehashed */
+    }
+
+    /* Odd epoch: readers wait, and batches already running retry */
+    __atomic_store_n(&trie->replace_seq, trie->replace_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    int rc = 0;
+    if (trie->agg) {
+        /* Aggregated: repoint the routes and let the selection follow */
+        rc = lpm_agg_replace(trie, old_next_hop, new_next_hop);
+    } else if (trie->shards) {
+        /* Rewritten with every shard locked, default route included */
+        lpm_shard_replace(trie, old_next_hop, new_next_hop);
+    } else {
+        if (trie->has_default_route && trie->default_next_hop == old_next_hop) {
+            trie->default_next_hop = new_next_hop;
+        }
+        if (trie->adapt) {
+            rc = lpm_adapt_replace(trie, old_next_hop, new_next_hop);
+        } else if (trie->small) {
+            /* The range tree is rebuilt from its own rules either way */
+            rc = lpm_small_repoint(trie, old_next_hop, new_next_hop);
+        } else if (trie->lctrie) {
+            /* Aliases live in the leaves; one walk finds them all */
+            lpm_lctrie_repoint(trie, old_next_hop, new_next_hop);
+        } else if (!x) {
+            engine_repoint_all(trie, old_next_hop, new_next_hop);
+        } else if (from) {
+            for (uint32_t r = from->head; r; r = x->refs[r].next) {
+                engine_repoint(trie, x->refs[r].prefix, x->refs[r].len, old_next_hop, new_next_hop);
+            }
+        }
+    }
+
+    /* Move the whole list over */
+    if (from && from->count) {
+        uint32_t r = from->head;
+        while (r) {
+            uint32_t next = x->refs[r].next;
+            ref_unlink(x, r);
+            ref_link(x, to, r);
+            r = next;
+        }
+    }
+
+    __atomic_store_n(&trie->replace_seq, trie->replace_seq + 1, __ATOMIC_RELEASE);
+
+    lpm_cache_invalidate(trie);
+    if (rc == 0 && trie->journal) {
+        lpm_journal_record(trie, LPM_JOURNAL_REPLACE, NULL, 0, old_next_hop, new_next_hop);
+    }
+    return rc;
+}
+
+uint64_t lpm_replace_seq(const lpm_trie_t *trie)
+{
+    return trie ? lpm_replace_read_begin(trie) : 0;
+}
+
+bool lpm_replace_retry(const lpm_trie_t *trie, uint64_t seq)
+{
+    return trie && lpm_replace_read_retry(trie, seq);
+}
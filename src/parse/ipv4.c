@@ -0,0 +1,390 @@
+/*
+ * Address Text Parsing - IPv4
+ * SIMD-optimized dotted-quad parser with ifunc dispatch
+ *
+ * The vector kernel classifies all 16 bytes at once (digits, dots, length
+ * mask), derives the four field lengths from the dot positions and uses
+ * them to pick one of 81 shuffle patterns. The shuffle lines up every octet
+ * as [hundreds, tens, ones, 0], so a single maddubs/madd pair turns the
+ * digits into four 32-bit octet values:
+ * - SSE4.2: one address per iteration
+ * - AVX2: two addresses per iteration (one per 128-bit lane)
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef LPM_X86_ARCH
+#include <immintrin.h>
+#endif
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+/* Shuffle patterns indexed by (len0-1)*27 + (len1-1)*9 + (len2-1)*3 + (len3-1).
+ * Output byte 4*i+k holds the hundreds/tens/ones digit of octet i (k = 0..2);
+ * 0x80 clears digits that do not exist and the padding byte. */
+static const uint8_t lpm_ipv4_shuffle[81][16] __attribute__((aligned(16))) = {
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x80, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x80, 0x02, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x80, 0x80, 0x00, 0x80, 0x02, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x80, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x80, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x03, 0x80, 0x05, 0x06, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x80, 0x03, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x80, 0x80, 0x0b, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x80, 0x0b, 0x0c, 0x80},
+    {0x80, 0x00, 0x01, 0x80, 0x03, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x0b, 0x0c, 0x0d, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x80, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x80, 0x06, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x80, 0x04, 0x80, 0x06, 0x07, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x80, 0x80, 0x09, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x80, 0x09, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x80, 0x07, 0x80, 0x09, 0x0a, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80, 0x07, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x80, 0x80, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x80, 0x0b, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x80, 0x04, 0x05, 0x80, 0x07, 0x08, 0x09, 0x80, 0x0b, 0x0c, 0x0d, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80, 0x80, 0x80, 0x0a, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80, 0x80, 0x0a, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80, 0x08, 0x80, 0x0a, 0x0b, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x0b, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x0b, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x80, 0x08, 0x09, 0x80, 0x0b, 0x0c, 0x0d, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80, 0x80, 0x80, 0x0c, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80, 0x80, 0x0c, 0x0d, 0x80},
+    {0x00, 0x01, 0x02, 0x80, 0x04, 0x05, 0x06, 0x80, 0x08, 0x09, 0x0a, 0x80, 0x0c, 0x0d, 0x0e, 0x80},
+};
+
+/* ============================================================================
+ * Shared Field Validation
+ * ============================================================================ */
+
+/* Validate the byte classes of one address and compute its shuffle pattern.
+ * lm: bytes inside the string, gm: digits, dm: dots, zm: '0' characters. */
+__attribute__((always_inline))
+static inline uint8_t ipv4_classify(uint32_t lm, uint32_t gm, uint32_t dm, uint32_t zm,
+                                    size_t len, uint32_t *pattern)
+{
+    gm &= lm;
+    dm &= lm;
+    if ((gm | dm) != lm || __builtin_popcount(dm) != 3) {
+        return LPM_PARSE_ERR_SYNTAX;
+    }
+
+    uint32_t p0 = (uint32_t)__builtin_ctz(dm);
+    uint32_t rest = dm & (dm - 1);
+    uint32_t p1 = (uint32_t)__builtin_ctz(rest);
+    rest &= rest - 1;
+    uint32_t p2 = (uint32_t)__builtin_ctz(rest);
+
+    /* Field lengths minus one; 0 and >3 both wrap above 2 */
+    uint32_t l0 = p0 - 1;
+    uint32_t l1 = p1 - p0 - 2;
+    uint32_t l2 = p2 - p1 - 2;
+    uint32_t l3 = (uint32_t)len - p2 - 2;
+    if (l0 > 2 || l1 > 2 || l2 > 2 || l3 > 2) {
+        return LPM_PARSE_ERR_SYNTAX;
+    }
+
+    /* Leading zero: a field starting with '0' that continues with a digit */
+    uint32_t starts = ((dm << 1) | 1) & lm;
+    if (zm & starts & (gm >> 1)) {
+        return LPM_PARSE_ERR_SYNTAX;
+    }
+
+    *pattern = l0 * 27 + l1 * 9 + l2 * 3 + l3;
+    return LPM_PARSE_OK;
+}
+
+/* ============================================================================
+ * Scalar Implementation
+ * ============================================================================ */
+
+uint8_t lpm_parse_ipv4_elem_scalar(const char *s, size_t len, uint32_t *out)
+{
+    if (len < 7 || len > LPM_PARSE_IPV4_MAX_CHARS) { return LPM_PARSE_ERR_SYNTAX; }
+
+    uint32_t addr = 0;
+    uint32_t octet = 0;
+    unsigned digits = 0;
+    unsigned dots = 0;
+    bool range = false;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned c = (unsigned char)s[i] - '0';
+        if (c <= 9) {
+            if (digits == 1 && octet == 0) { return LPM_PARSE_ERR_SYNTAX; }
+            if (++digits > 3) { return LPM_PARSE_ERR_SYNTAX; }
+            octet = octet * 10 + c;
+        } else if (s[i] == '.') {
+            if (digits == 0 || ++dots > 3) { return LPM_PARSE_ERR_SYNTAX; }
+            range |= octet > 255;
+            addr = (addr << 8) | (octet & 0xFF);
+            octet = 0;
+            digits = 0;
+        } else {
+            return LPM_PARSE_ERR_SYNTAX;
+        }
+    }
+    if (dots != 3 || digits == 0) { return LPM_PARSE_ERR_SYNTAX; }
+    if (range || octet > 255) { return LPM_PARSE_ERR_RANGE; }
+
+    *out = (addr << 8) | octet;
+    return LPM_PARSE_OK;
+}
+
+__attribute__((hot))
+size_t lpm_parse_ipv4_batch_scalar(const char *const *strs, const size_t *lens,
+                                   uint32_t *addrs, uint8_t *status, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        addrs[i] = 0;
+        if (strs[i]) {
+            st = lpm_parse_ipv4_elem_scalar(strs[i], lens ? lens[i] : strlen(strs[i]), &addrs[i]);
+        }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * SSE4.2 Implementation - one address per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("sse4.2")))
+uint8_t lpm_parse_ipv4_elem_sse42(const char *s, size_t len, uint32_t *out)
+{
+    if (len < 7 || len > LPM_PARSE_IPV4_MAX_CHARS) { return LPM_PARSE_ERR_SYNTAX; }
+
+    char buf[16];
+    const char *p = lpm_parse_load_ptr(s, len, buf, sizeof(buf));
+    const __m128i v = _mm_loadu_si128((const __m128i *)p);
+
+    const __m128i iota = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+
+    uint32_t lm = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8((char)len), iota));
+    uint32_t gm = (uint32_t)_mm_movemask_epi8(is_digit);
+    uint32_t dm = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+    uint32_t zm = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('0')));
+
+    uint32_t pattern;
+    uint8_t st = ipv4_classify(lm, gm, dm, zm, len, &pattern);
+    if (st != LPM_PARSE_OK) { return st; }
+
+    const __m128i shuf = _mm_load_si128((const __m128i *)lpm_ipv4_shuffle[pattern]);
+    const __m128i weights = _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0,
+                                          100, 10, 1, 0, 100, 10, 1, 0);
+    __m128i digits = _mm_shuffle_epi8(d, shuf);
+    __m128i octets = _mm_madd_epi16(_mm_maddubs_epi16(digits, weights), _mm_set1_epi16(1));
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(octets, _mm_set1_epi32(255)))) {
+        return LPM_PARSE_ERR_RANGE;
+    }
+
+    __m128i packed = _mm_packus_epi16(_mm_packus_epi32(octets, octets), octets);
+    *out = __builtin_bswap32((uint32_t)_mm_cvtsi128_si32(packed));
+    return LPM_PARSE_OK;
+}
+
+__attribute__((hot, target("sse4.2")))
+size_t lpm_parse_ipv4_batch_sse42(const char *const *strs, const size_t *lens,
+                                  uint32_t *addrs, uint8_t *status, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        addrs[i] = 0;
+        if (strs[i]) {
+            st = lpm_parse_ipv4_elem_sse42(strs[i], lens ? lens[i] : strlen(strs[i]), &addrs[i]);
+        }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * AVX2 Implementation - two addresses per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("avx2")))
+size_t lpm_parse_ipv4_batch_avx2(const char *const *strs, const size_t *lens,
+                                 uint32_t *addrs, uint8_t *status, size_t count)
+{
+    const __m256i iota = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                          0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i weights = _mm256_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0,
+                                             100, 10, 1, 0, 100, 10, 1, 0,
+                                             100, 10, 1, 0, 100, 10, 1, 0,
+                                             100, 10, 1, 0, 100, 10, 1, 0);
+    size_t ok = 0;
+    size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        const char *s0 = strs[i];
+        const char *s1 = strs[i + 1];
+        size_t n0 = s0 ? (lens ? lens[i] : strlen(s0)) : 0;
+        size_t n1 = s1 ? (lens ? lens[i + 1] : strlen(s1)) : 0;
+
+        if (n0 < 7 || n0 > LPM_PARSE_IPV4_MAX_CHARS || n1 < 7 || n1 > LPM_PARSE_IPV4_MAX_CHARS) {
+            /* Let the single-address kernel sort out the odd one(s) */
+            for (size_t k = 0; k < 2; k++) {
+                const char *s = k ? s1 : s0;
+                uint8_t st = LPM_PARSE_ERR_SYNTAX;
+                addrs[i + k] = 0;
+                if (s) { st = lpm_parse_ipv4_elem_sse42(s, k ? n1 : n0, &addrs[i + k]); }
+                ok += st == LPM_PARSE_OK;
+                if (status) { status[i + k] = st; }
+            }
+            continue;
+        }
+
+        char buf0[16], buf1[16];
+        const char *p0 = lpm_parse_load_ptr(s0, n0, buf0, sizeof(buf0));
+        const char *p1 = lpm_parse_load_ptr(s1, n1, buf1, sizeof(buf1));
+        const __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p0)),
+            _mm_loadu_si128((const __m128i *)p1), 1);
+
+        const __m256i lens_v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_set1_epi8((char)n0)), _mm_set1_epi8((char)n1), 1);
+        const __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+        const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+
+        uint32_t lm = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(lens_v, iota));
+        uint32_t gm = (uint32_t)_mm256_movemask_epi8(is_digit);
+        uint32_t dm = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+        uint32_t zm = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('0')));
+
+        uint32_t pat0 = 0, pat1 = 0;
+        uint8_t st0 = ipv4_classify(lm & 0xFFFF, gm & 0xFFFF, dm & 0xFFFF, zm & 0xFFFF, n0, &pat0);
+        uint8_t st1 = ipv4_classify(lm >> 16, gm >> 16, dm >> 16, zm >> 16, n1, &pat1);
+
+        const __m256i shuf = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_load_si128((const __m128i *)lpm_ipv4_shuffle[pat0])),
+            _mm_load_si128((const __m128i *)lpm_ipv4_shuffle[pat1]), 1);
+        __m256i digits = _mm256_shuffle_epi8(d, shuf);
+        __m256i octets = _mm256_madd_epi16(_mm256_maddubs_epi16(digits, weights),
+                                           _mm256_set1_epi16(1));
+
+        uint32_t over = (uint32_t)_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(octets, _mm256_set1_epi32(255))));
+        if (st0 == LPM_PARSE_OK && (over & 0x0F)) { st0 = LPM_PARSE_ERR_RANGE; }
+        if (st1 == LPM_PARSE_OK && (over & 0xF0)) { st1 = LPM_PARSE_ERR_RANGE; }
+
+        /* Reverse each octet quad in-lane so the result is already in host order */
+        const __m256i to_host = _mm256_setr_epi8(12, 8, 4, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 12, 8, 4, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        uint32_t out[8] __attribute__((aligned(32)));
+        _mm256_store_si256((__m256i *)out, _mm256_shuffle_epi8(octets, to_host));
+        uint32_t a0 = out[0];
+        uint32_t a1 = out[4];
+
+        addrs[i] = st0 == LPM_PARSE_OK ? a0 : 0;
+        addrs[i + 1] = st1 == LPM_PARSE_OK ? a1 : 0;
+        ok += (st0 == LPM_PARSE_OK) + (st1 == LPM_PARSE_OK);
+        if (status) {
+            status[i] = st0;
+            status[i + 1] = st1;
+        }
+    }
+
+    /* Remainder */
+    for (; i < count; i++) {
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        addrs[i] = 0;
+        if (strs[i]) {
+            st = lpm_parse_ipv4_elem_sse42(strs[i], lens ? lens[i] : strlen(strs[i]), &addrs[i]);
+        }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+typedef size_t (*lpm_parse_ipv4_batch_func_t)(const char *const *, const size_t *,
+                                              uint32_t *, uint8_t *, size_t);
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_parse_ipv4_batch_resolver)
+{
+    simd_level_t level = LPM_DETECT_SIMD();
+
+    switch (level) {
+    case SIMD_AVX512F:
+    case SIMD_AVX2:
+        return (void*)lpm_parse_ipv4_batch_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+        return (void*)lpm_parse_ipv4_batch_sse42;
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return (void*)lpm_parse_ipv4_batch_scalar;
+    }
+}
+
+size_t lpm_parse_ipv4_batch(const char *const *strs, const size_t *lens,
+                            uint32_t *addrs, uint8_t *status, size_t count)
+    __attribute__((ifunc("lpm_parse_ipv4_batch_resolver")));
@@ -0,0 +1,336 @@
+/*
+ * Address Text Parsing - IPv6
+ * SIMD-optimized RFC 4291 text parser with ifunc dispatch
+ *
+ * The vector kernels classify the whole string in one pass (hex digits,
+ * colons, dots) and convert every hex digit to its nibble value. Group
+ * boundaries are then walked with tzcnt over the colon bitmask, so the
+ * per-character branching of inet_pton disappears:
+ * - SSE4.2: 3 x 16-byte blocks
+ * - AVX2: 2 x 32-byte blocks
+ * Addresses with an embedded dotted quad take the scalar path.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef LPM_X86_ARCH
+#include <immintrin.h>
+#endif
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+/* Pure hex form fits in 39 characters; the vector path loads 48/64 bytes */
+#define LPM_PARSE_IPV6_HEX_MAX_CHARS 39
+
+/* ============================================================================
+ * Scalar Implementation (full grammar, including embedded IPv4)
+ * ============================================================================ */
+
+static inline int hex_nibble(unsigned char c)
+{
+    if (c - '0' <= 9u) { return c - '0'; }
+    c |= 0x20;
+    if (c - 'a' <= 5u) { return c - 'a' + 10; }
+    return -1;
+}
+
+uint8_t lpm_parse_ipv6_elem_scalar(const char *s, size_t len, uint8_t out[16])
+{
+    if (len < 2 || len > LPM_PARSE_IPV6_MAX_CHARS) { return LPM_PARSE_ERR_SYNTAX; }
+
+    uint8_t tmp[16] = {0};
+    size_t tp = 0;
+    int gap = -1;
+    size_t i = 0;
+
+    if (s[0] == ':') {
+        if (s[1] != ':') { return LPM_PARSE_ERR_SYNTAX; }
+        i = 1;
+    }
+
+    size_t tok = i;
+    unsigned val = 0;
+    unsigned xdigits = 0;
+
+    while (i < len) {
+        unsigned char c = (unsigned char)s[i++];
+        int nib = hex_nibble(c);
+        if (nib >= 0) {
+            val = (val << 4) | (unsigned)nib;
+            if (++xdigits > 4) { return LPM_PARSE_ERR_SYNTAX; }
+            continue;
+        }
+        if (c == ':') {
+            tok = i;
+            if (!xdigits) {
+                if (gap >= 0) { return LPM_PARSE_ERR_SYNTAX; }
+                gap = (int)tp;
+                continue;
+            }
+            if (i == len || tp + 2 > 16) { return LPM_PARSE_ERR_SYNTAX; }
+            tmp[tp++] = (uint8_t)(val >> 8);
+            tmp[tp++] = (uint8_t)val;
+            xdigits = 0;
+            val = 0;
+            continue;
+        }
+        if (c == '.' && tp + 4 <= 16) {
+            uint32_t v4;
+            uint8_t st = lpm_parse_ipv4_elem_scalar(s + tok, len - tok, &v4);
+            if (st != LPM_PARSE_OK) { return st; }
+            tmp[tp++] = (uint8_t)(v4 >> 24);
+            tmp[tp++] = (uint8_t)(v4 >> 16);
+            tmp[tp++] = (uint8_t)(v4 >> 8);
+            tmp[tp++] = (uint8_t)v4;
+            xdigits = 0;
+            break;
+        }
+        return LPM_PARSE_ERR_SYNTAX;
+    }
+
+    if (xdigits) {
+        if (tp + 2 > 16) { return LPM_PARSE_ERR_SYNTAX; }
+        tmp[tp++] = (uint8_t)(val >> 8);
+        tmp[tp++] = (uint8_t)val;
+    }
+    if (gap >= 0) {
+        if (tp == 16) { return LPM_PARSE_ERR_SYNTAX; }
+        size_t n = tp - (size_t)gap;
+        memmove(&tmp[16 - n], &tmp[gap], n);
+        memset(&tmp[gap], 0, 16 - n - (size_t)gap);
+        tp = 16;
+    }
+    if (tp != 16) { return LPM_PARSE_ERR_SYNTAX; }
+
+    memcpy(out, tmp, 16);
+    return LPM_PARSE_OK;
+}
+
+__attribute__((hot))
+size_t lpm_parse_ipv6_batch_scalar(const char *const *strs, const size_t *lens,
+                                   uint8_t (*addrs)[16], uint8_t *status, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        if (strs[i]) {
+            st = lpm_parse_ipv6_elem_scalar(strs[i], lens ? lens[i] : strlen(strs[i]), addrs[i]);
+        }
+        if (st != LPM_PARSE_OK) { memset(addrs[i], 0, 16); }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * Group Assembly (shared by the vector kernels)
+ * ============================================================================ */
+
+/* Assemble the address from the colon bitmask and precomputed nibbles.
+ * The caller has already checked that every byte is a hex digit or colon. */
+__attribute__((always_inline))
+static inline uint8_t ipv6_assemble(uint64_t colons, const uint8_t *nib, size_t len,
+                                    uint8_t out[16])
+{
+    uint16_t groups[8];
+    unsigned ng = 0;
+    int gap = -1;
+    size_t pos = 0;
+
+    if (colons & 1) {
+        if (!(colons & 2)) { return LPM_PARSE_ERR_SYNTAX; }
+        gap = 0;
+        pos = 2;
+    }
+
+    while (pos < len) {
+        uint64_t ahead = colons >> pos;
+        size_t flen = ahead ? (size_t)__builtin_ctzll(ahead) : len - pos;
+        if (flen - 1 > 3 || ng == 8) { return LPM_PARSE_ERR_SYNTAX; }
+
+        unsigned v = 0;
+        for (size_t k = 0; k < flen; k++) {
+            v = (v << 4) | nib[pos + k];
+        }
+        groups[ng++] = (uint16_t)v;
+        pos += flen;
+        if (pos == len) { break; }
+
+        /* At a colon: either a separator or the start of "::" */
+        pos++;
+        if (pos == len) { return LPM_PARSE_ERR_SYNTAX; }
+        if ((colons >> pos) & 1) {
+            if (gap >= 0) { return LPM_PARSE_ERR_SYNTAX; }
+            gap = (int)ng;
+            pos++;
+        }
+    }
+
+    if (gap < 0 ? ng != 8 : ng > 7) { return LPM_PARSE_ERR_SYNTAX; }
+
+    memset(out, 0, 16);
+    unsigned head = gap < 0 ? ng : (unsigned)gap;
+    for (unsigned g = 0; g < head; g++) {
+        out[2 * g] = (uint8_t)(groups[g] >> 8);
+        out[2 * g + 1] = (uint8_t)groups[g];
+    }
+    for (unsigned g = head; g < ng; g++) {
+        unsigned slot = (8 - (ng - g)) & 7;
+        out[2 * slot] = (uint8_t)(groups[g] >> 8);
+        out[2 * slot + 1] = (uint8_t)groups[g];
+    }
+    return LPM_PARSE_OK;
+}
+
+/* ============================================================================
+ * SSE4.2 Implementation - 3 x 16-byte blocks
+ * ============================================================================ */
+
+__attribute__((hot, target("sse4.2")))
+uint8_t lpm_parse_ipv6_elem_sse42(const char *s, size_t len, uint8_t out[16])
+{
+    if (len < 2 || len > LPM_PARSE_IPV6_HEX_MAX_CHARS) {
+        return lpm_parse_ipv6_elem_scalar(s, len, out);
+    }
+
+    char buf[48];
+    const char *p = lpm_parse_load_ptr(s, len, buf, sizeof(buf));
+    uint8_t nib[48] __attribute__((aligned(16)));
+    uint64_t colons = 0, hex = 0, dots = 0;
+
+    for (int b = 0; b < 3; b++) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * b));
+        const __m128i dec = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        const __m128i alpha = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i is_dec = _mm_cmpeq_epi8(_mm_min_epu8(dec, _mm_set1_epi8(9)), dec);
+        const __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+        _mm_store_si128((__m128i *)(nib + 16 * b),
+                        _mm_blendv_epi8(_mm_add_epi8(alpha, _mm_set1_epi8(10)), dec, is_dec));
+        hex |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(is_dec, is_alpha)) << (16 * b);
+        colons |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(':'))) << (16 * b);
+        dots |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))) << (16 * b);
+    }
+
+    const uint64_t lm = (1ULL << len) - 1;
+    if (dots & lm) {
+        return lpm_parse_ipv6_elem_scalar(s, len, out);
+    }
+    colons &= lm;
+    if (((hex & lm) | colons) != lm) { return LPM_PARSE_ERR_SYNTAX; }
+
+    return ipv6_assemble(colons, nib, len, out);
+}
+
+__attribute__((hot, target("sse4.2")))
+size_t lpm_parse_ipv6_batch_sse42(const char *const *strs, const size_t *lens,
+                                  uint8_t (*addrs)[16], uint8_t *status, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        if (strs[i]) {
+            st = lpm_parse_ipv6_elem_sse42(strs[i], lens ? lens[i] : strlen(strs[i]), addrs[i]);
+        }
+        if (st != LPM_PARSE_OK) { memset(addrs[i], 0, 16); }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * AVX2 Implementation - 2 x 32-byte blocks
+ * ============================================================================ */
+
+__attribute__((hot, target("avx2")))
+uint8_t lpm_parse_ipv6_elem_avx2(const char *s, size_t len, uint8_t out[16])
+{
+    if (len < 2 || len > LPM_PARSE_IPV6_HEX_MAX_CHARS) {
+        return lpm_parse_ipv6_elem_scalar(s, len, out);
+    }
+
+    char buf[64];
+    const char *p = lpm_parse_load_ptr(s, len, buf, sizeof(buf));
+    uint8_t nib[64] __attribute__((aligned(32)));
+    uint64_t colons = 0, hex = 0, dots = 0;
+
+    for (int b = 0; b < 2; b++) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(p + 32 * b));
+        const __m256i dec = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+        const __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)),
+                                              _mm256_set1_epi8('a'));
+        const __m256i is_dec = _mm256_cmpeq_epi8(_mm256_min_epu8(dec, _mm256_set1_epi8(9)), dec);
+        const __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+        _mm256_store_si256((__m256i *)(nib + 32 * b),
+                           _mm256_blendv_epi8(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), dec, is_dec));
+        hex |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_dec, is_alpha)) << (32 * b);
+        colons |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':'))) << (32 * b);
+        dots |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))) << (32 * b);
+    }
+
+    const uint64_t lm = (1ULL << len) - 1;
+    if (dots & lm) {
+        return lpm_parse_ipv6_elem_scalar(s, len, out);
+    }
+    colons &= lm;
+    if (((hex & lm) | colons) != lm) { return LPM_PARSE_ERR_SYNTAX; }
+
+    return ipv6_assemble(colons, nib, len, out);
+}
+
+__attribute__((hot, target("avx2")))
+size_t lpm_parse_ipv6_batch_avx2(const char *const *strs, const size_t *lens,
+                                 uint8_t (*addrs)[16], uint8_t *status, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        /* Pull the next string towards L1 while this one is parsed */
+        if (i + 4 < count && strs[i + 4]) {
+            __builtin_prefetch(strs[i + 4], 0, 0);
+        }
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;
+        if (strs[i]) {
+            st = lpm_parse_ipv6_elem_avx2(strs[i], lens ? lens[i] : strlen(strs[i]), addrs[i]);
+        }
+        if (st != LPM_PARSE_OK) { memset(addrs[i], 0, 16); }
+        ok += st == LPM_PARSE_OK;
+        if (status) { status[i] = st; }
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+typedef size_t (*lpm_parse_ipv6_batch_func_t)(const char *const *, const size_t *,
+                                              uint8_t (*)[16], uint8_t *, size_t);
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_parse_ipv6_batch_resolver)
+{
+    simd_level_t level = LPM_DETECT_SIMD();
+
+    switch (level) {
+    case SIMD_AVX512F:
+    case SIMD_AVX2:
+        return (void*)lpm_parse_ipv6_batch_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+        return (void*)lpm_parse_ipv6_batch_sse42;
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return (void*)lpm_parse_ipv6_batch_scalar;
+    }
+}
+
+size_t lpm_parse_ipv6_batch(const char *const *strs, const size_t *lens,
+                            uint8_t (*addrs)[16], uint8_t *status, size_t count)
+    __attribute__((ifunc("lpm_parse_ipv6_batch_resolver")));
@@ -0,0 +1,158 @@
+/*
+ * Address Text Parsing - CIDR Prefixes
+ * Batch "addr/len" parser built on the per-address kernels, with ifunc dispatch
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+typedef uint8_t (*lpm_parse_ipv4_elem_func_t)(const char *, size_t, uint32_t *);
+typedef uint8_t (*lpm_parse_ipv6_elem_func_t)(const char *, size_t, uint8_t *);
+
+/* ============================================================================
+ * Shared Prefix Parsing
+ * ============================================================================ */
+
+/* Parse the decimal length after '/' (no sign, no leading zeros) */
+static inline bool parse_prefix_len(const char *s, size_t len, unsigned max, uint8_t *out)
+{
+    if (len == 0 || len > 3 || (s[0] == '0' && len > 1)) { return false; }
+
+    unsigned v = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned c = (unsigned char)s[i] - '0';
+        if (c > 9) { return false; }
+        v = v * 10 + c;
+    }
+    if (v > max) { return false; }
+    *out = (uint8_t)v;
+    return true;
+}
+
+__attribute__((always_inline))
+static inline uint8_t parse_prefix_one(const char *s, size_t len,
+                                       lpm_parse_ipv4_elem_func_t parse_v4,
+                                       lpm_parse_ipv6_elem_func_t parse_v6,
+                                       uint8_t prefix[16], uint8_t *prefix_len,
+                                       uint8_t *max_depth)
+{
+    const char *slash = memchr(s, '/', len);
+    size_t alen = slash ? (size_t)(slash - s) : len;
+    bool is_v6 = memchr(s, ':', alen) != NULL;
+    unsigned max = is_v6 ? LPM_IPV6_MAX_DEPTH : LPM_IPV4_MAX_DEPTH;
+    uint8_t st;
+
+    memset(prefix, 0, 16);
+    if (is_v6) {
+        st = parse_v6(s, alen, prefix);
+    } else {
+        uint32_t v4 = 0;
+        st = parse_v4(s, alen, &v4);
+        prefix[0] = (uint8_t)(v4 >> 24);
+        prefix[1] = (uint8_t)(v4 >> 16);
+        prefix[2] = (uint8_t)(v4 >> 8);
+        prefix[3] = (uint8_t)v4;
+    }
+    if (st != LPM_PARSE_OK) {
+        memset(prefix, 0, 16);
+        return st;
+    }
+
+    uint8_t plen = (uint8_t)max;
+    if (slash && !parse_prefix_len(slash + 1, len - alen - 1, max, &plen)) {
+        memset(prefix, 0, 16);
+        return LPM_PARSE_ERR_PREFIX_LEN;
+    }
+
+    /* Clear host bits */
+    unsigned full = plen / 8;
+    if (full < max / 8) {
+        prefix[full] &= (uint8_t)(0xFF00 >> (plen % 8));
+        memset(&prefix[full + 1], 0, max / 8 - full - 1);
+    }
+
+    *prefix_len = plen;
+    if (max_depth) { *max_depth = (uint8_t)max; }
+    return LPM_PARSE_OK;
+}
+
+#define LPM_PARSE_PREFIX_BATCH_BODY(parse_v4, parse_v6)                              \
+    size_t ok = 0;                                                                  \
+    for (size_t i = 0; i < count; i++) {                                            \
+        uint8_t st = LPM_PARSE_ERR_SYNTAX;                                          \
+        prefix_lens[i] = 0;                                                         \
+        if (max_depths) { max_depths[i] = 0; }                                      \
+        if (strs[i]) {                                                              \
+            st = parse_prefix_one(strs[i], lens ? lens[i] : strlen(strs[i]),       \
+                                  parse_v4, parse_v6, prefixes[i], &prefix_lens[i], \
+                                  max_depths ? &max_depths[i] : NULL);              \
+        } else {                                                                    \
+            memset(prefixes[i], 0, 16);                                             \
+        }                                                                           \
+        ok += st == LPM_PARSE_OK;                                                   \
+        if (status) { status[i] = st; }                                             \
+    }                                                                               \
+    return ok
+
+/* ============================================================================
+ * Per-ISA Variants
+ * ============================================================================ */
+
+__attribute__((hot))
+size_t lpm_parse_prefix_batch_scalar(const char *const *strs, const size_t *lens,
+                                     uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                     uint8_t *max_depths, uint8_t *status, size_t count)
+{
+    LPM_PARSE_PREFIX_BATCH_BODY(lpm_parse_ipv4_elem_scalar, lpm_parse_ipv6_elem_scalar);
+}
+
+__attribute__((hot, target("sse4.2")))
+size_t lpm_parse_prefix_batch_sse42(const char *const *strs, const size_t *lens,
+                                    uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                    uint8_t *max_depths, uint8_t *status, size_t count)
+{
+    LPM_PARSE_PREFIX_BATCH_BODY(lpm_parse_ipv4_elem_sse42, lpm_parse_ipv6_elem_sse42);
+}
+
+__attribute__((hot, target("avx2")))
+size_t lpm_parse_prefix_batch_avx2(const char *const *strs, const size_t *lens,
+                                   uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                                   uint8_t *max_depths, uint8_t *status, size_t count)
+{
+    LPM_PARSE_PREFIX_BATCH_BODY(lpm_parse_ipv4_elem_sse42, lpm_parse_ipv6_elem_avx2);
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+typedef size_t (*lpm_parse_prefix_batch_func_t)(const char *const *, const size_t *,
+                                                uint8_t (*)[16], uint8_t *, uint8_t *,
+                                                uint8_t *, size_t);
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_parse_prefix_batch_resolver)
+{
+    simd_level_t level = LPM_DETECT_SIMD();
+
+    switch (level) {
+    case SIMD_AVX512F:
+    case SIMD_AVX2:
+        return (void*)lpm_parse_prefix_batch_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+        return (void*)lpm_parse_prefix_batch_sse42;
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return (void*)lpm_parse_prefix_batch_scalar;
+    }
+}
+
+size_t lpm_parse_prefix_batch(const char *const *strs, const size_t *lens,
+                              uint8_t (*prefixes)[16], uint8_t *prefix_lens,
+                              uint8_t *max_depths, uint8_t *status, size_t count)
+    __attribute__((ifunc("lpm_parse_prefix_batch_resolver")));
@@ -0,0 +1,246 @@
+/*
+ * liblpm Prefaulting
+ *
+ * Table memory comes from malloc()/aligned_alloc(), so parts of it (calloc'd
+ * arrays, pool tails, a table mapped back in after reclaim) are only backed
+ * by pages on first touch, and every page costs a TLB fill the first time a
+ * lookup reaches it. After a failover the first lookups into a cold table
+ * pay for both. lpm_prefault() does that work up front: it populates every
+ * page of the table, optionally backs the large arrays with transparent
+ * huge pages and locks them in RAM, and reads the parts every lookup walks
+ * (tbl8 groups, stride nodes, search trees, and the 24-bit tables when the
+ * LLC can hold them) into the cache.
+ *
+ * The contents are never written, so lookups may run concurrently; updates
+ * should not, as they may reallocate the regions being walked.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_PREFAULT_MAX_REGIONS 16
+
+/* One allocation of a trie; the first hot bytes are what lookups walk.
+ * Large regions are warmed only when the whole table fits in the LLC. */
+struct prefault_region {
+    void *base;
+    size_t len;
+    size_t hot;
+    bool large;
+};
+
+struct prefault_map {
+    struct prefault_region r[LPM_PREFAULT_MAX_REGIONS];
+    unsigned n;
+};
+
+static void region_add(struct prefault_map *m, void *base, size_t len, size_t hot, bool large)
+{
+    if (!base || !len || m->n == LPM_PREFAULT_MAX_REGIONS) { return; }
+    m->r[m->n++] = (struct prefault_region){ .base = base, .len = len, .hot = hot < len ? hot : len,
+                                             .large = large };
+}
+
+/* Every array the trie owns directly; side tables reached only from the
+ * update path (rules, TTL wheel, next-hop index) are left alone */
+static void regions_collect(const lpm_trie_t *trie, struct prefault_map *m)
+{
+    region_add(m, trie->node_pool, (size_t)trie->pool_capacity * sizeof(struct lpm_node),
+               (size_t)trie->pool_used * sizeof(struct lpm_node), false);
+    region_add(m, trie->wide_nodes_pool, (size_t)trie->wide_pool_capacity * sizeof(struct lpm_node_16),
+               (size_t)trie->wide_pool_used * sizeof(struct lpm_node_16), false);
+    if (trie->sparse16) {
+        const struct lpm_sparse16_pool *p = trie->sparse16;
+        region_add(m, p->cells, (size_t)p->capacity * LPM_SPARSE16_CELL,
+                   (size_t)p->used * LPM_SPARSE16_CELL, false);
+    }
+
+    /* The 24-bit tables are warmed only if the LLC can hold them */
+    size_t tbl8_entries = (size_t)trie->tbl8_num_groups * LPM_TBL8_GROUP_ENTRIES;
+    size_t tbl8_used = (size_t)trie->tbl8_groups_used * LPM_TBL8_GROUP_ENTRIES;
+    region_add(m, trie->dir24_table, LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry), SIZE_MAX, true);
+    region_add(m, trie->tbl8_groups, tbl8_entries * sizeof(struct lpm_tbl8_entry),
+               tbl8_used * sizeof(struct lpm_tbl8_entry), false);
+    region_add(m, trie->dir24c_table, LPM_IPV4_DIR24_SIZE * sizeof(uint16_t), SIZE_MAX, true);
+    region_add(m, trie->tbl8c_groups, tbl8_entries * sizeof(uint16_t), tbl8_used * sizeof(uint16_t), false);
+    region_add(m, trie->dir24_depth, trie->dir24_depth ? LPM_IPV4_DIR24_SIZE : 0, 0, false);
+    region_add(m, trie->tbl8_depth, trie->tbl8_depth ? tbl8_entries : 0, 0, false);
+
+    if (trie->set) {
+        const struct lpm_set *s = trie->set;
+        region_add(m, s->cover, s->cover ? LPM_SET_IPV4_BITMAP_BYTES : 0, LPM_SET_IPV4_BITMAP_BYTES, false);
+        region_add(m, s->ext, s->ext ? LPM_SET_IPV4_BITMAP_BYTES : 0, LPM_SET_IPV4_BITMAP_BYTES, false);
+        region_add(m, s->blocks, (size_t)s->block_capacity * sizeof(struct lpm_set_block), SIZE_MAX, false);
+        region_add(m, s->nodes, (size_t)s->node_capacity * sizeof(struct lpm_set_node6),
+                   (size_t)s->node_used * sizeof(struct lpm_set_node6), false);
+    }
+    if (trie->small) {
+        const struct lpm_small *s = trie->small;
+        size_t tree = ((size_t)1 << s->height) * sizeof(int32_t);
+        region_add(m, s->keys, tree, tree, false);
+        region_add(m, s->vals, tree, tree, false);
+    }
+
+    region_add(m, trie->direct_table, trie->direct_table ? LPM_DIRECT_SIZE * sizeof(struct lpm_direct_entry) : 0,
+               SIZE_MAX, false);
+    region_add(m, trie->hot_cache, trie->hot_cache ? LPM_HOT_CACHE_SIZE * sizeof(struct lpm_cache_entry) : 0,
+               SIZE_MAX, false);
+}
+
+/* Whole huge pages inside a region, or an empty range */
+static size_t huge_aligned(const struct prefault_region *r, uint8_t **start)
+{
+    const uintptr_t huge = LPM_HUGE_PAGE_SIZE;
+    uintptr_t lo = ((uintptr_t)r->base + huge - 1) & ~(huge - 1);
+    uintptr_t hi = ((uintptr_t)r->base + r->len) & ~(huge - 1);
+    *start = (uint8_t *)lo;
+    return hi > lo ? hi - lo : 0;
+}
+
+/* ============================================================================
+ * Steps
+ * ============================================================================ */
+
+/* Map every page writable where the kernel can; otherwise read one byte per
+ * page, which is enough for lookups (never-written pages map the zero page) */
+static void region_populate(const struct prefault_region *r, size_t page)
+{
+#ifdef MADV_POPULATE_WRITE
+    uintptr_t lo = (uintptr_t)r->base & ~(page - 1);
+    if (madvise((void *)lo, (uintptr_t)r->base + r->len - lo, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    const volatile uint8_t *p = r->base;
+    for (size_t off = 0; off < r->len; off += page) {
+        (void)p[off];
+    }
+    (void)p[r->len - 1];
+}
+
+/* Regions of at least one huge page get THP; collapse synchronously where
+ * the kernel supports it, else khugepaged does it in the background */
+static size_t region_hugepages(const struct prefault_region *r)
+{
+    uint8_t *start;
+    size_t len = huge_aligned(r, &start);
+    if (!len || madvise(start, len, MADV_HUGEPAGE) != 0) { return 0; }
+#ifdef MADV_COLLAPSE
+    (void)madvise(start, len, MADV_COLLAPSE);
+#endif
+    return len;
+}
+
+static uint64_t region_warm(const struct prefault_region *r)
+{
+    const uint8_t *p = r->base;
+    uint64_t sum = 0;
+    for (size_t off = 0; off < r->hot; off += LPM_CACHE_LINE_SIZE) {
+        sum += p[off];
+    }
+    return sum;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_prefault(lpm_trie_t *trie, unsigned flags, lpm_prefault_stats_t *stats)
+{
+    lpm_prefault_stats_t local;
+    if (!stats) { stats = &local; }
+    memset(stats, 0, sizeof(*stats));
+    if (!trie || (flags & ~LPM_PREFAULT_ALL)) { return -1; }
+
+    /* An adaptive trie forwards to the engine serving lookups */
+    if (trie->adapt) {
+        return lpm_prefault(lpm_adapt_active(trie)->engine, flags, stats);
+    }
+
+    struct prefault_map m = { .n = 0 };
+    regions_collect(trie, &m);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    int ret = 0;
+    struct timespec t0, t1;
+
+    for (unsigned i = 0; i < m.n; i++) {
+        stats->bytes += m.r[i].len;
+    }
+
+    if (flags & LPM_PREFAULT_HUGEPAGES) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (unsigned i = 0; i < m.n; i++) {
+            stats->huge_bytes += region_hugepages(&m.r[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats->hugepage_ms = lpm_elapsed_ms(&t0, &t1);
+        if (stats->huge_bytes) {
+            trie->use_huge_pages = true;
+        }
+    }
+
+    if (flags & LPM_PREFAULT_POPULATE) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (unsigned i = 0; i < m.n; i++) {
+            region_populate(&m.r[i], page);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats->populate_ms = lpm_elapsed_ms(&t0, &t1);
+    }
+
+    if (flags & LPM_PREFAULT_LOCK) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (unsigned i = 0; i < m.n; i++) {
+            if (mlock(m.r[i].base, m.r[i].len) == 0) {
+                stats->locked_bytes += m.r[i].len;
+            } else {
+                ret = -1;   /* RLIMIT_MEMLOCK or no privilege: keep going */
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats->lock_ms = lpm_elapsed_ms(&t0, &t1);
+        if (stats->locked_bytes) {
+            trie->mem_locked = true;
+        }
+    }
+
+    if (flags & LPM_PREFAULT_WARM) {
+        size_t hot = 0;
+        for (unsigned i = 0; i < m.n; i++) {
+            hot += m.r[i].hot;
+        }
+        long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        bool fits = llc > 0 && hot <= (size_t)llc / 2;
+
+        uint64_t sum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (unsigned i = 0; i < m.n; i++) {
+            if (m.r[i].large && !fits) { continue; }
+            sum += region_warm(&m.r[i]);
+            stats->warm_bytes += m.r[i].hot;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        stats->warm_ms = lpm_elapsed_ms(&t0, &t1);
+        __asm__ volatile("" : : "r"(sum));
+    }
+
+    stats->total_ms = stats->hugepage_ms + stats->populate_ms + stats->lock_ms + stats->warm_ms;
+    return ret;
+}
+
+void lpm_prefault_release(lpm_trie_t *trie)
+{
+    if (!trie->mem_locked) { return; }
+    struct prefault_map m = { .n = 0 };
+    regions_collect(trie, &m);
+    for (unsigned i = 0; i < m.n; i++) {
+        munlock(m.r[i].base, m.r[i].len);
+    }
+    trie->mem_locked = false;
+}
@@ -0,0 +1,289 @@
+/*
+ * liblpm Range Cache
+ *
+ * The trie's hot cache is keyed by the full address, so it only helps when
+ * the same address comes back. A range cache stores each result under the
+ * address range every member of which resolves the same way, so one miss
+ * serves a whole /64 of hosts (or whatever the table's structure allows).
+ *
+ * That range is where the lookup stopped, not the matched prefix: a /48
+ * route with a /56 inside it still sends part of the /48 elsewhere, but a
+ * walk that ended at a node entry without a child has seen everything
+ * that can apply to any address sharing the bits consumed so far. The
+ * stride tries stop on byte boundaries, wide16 on 16-bit ones below its
+ * wide levels, DIR-24-8 at /24 unless the slot is extended. Other engines
+ * (small tables, LC-tries, sets) are cached per address.
+ *
+ * Within one table generation the ranges never overlap (they are the
+ * leaves of the walk), so a lookup may probe the range lengths seen so far
+ * in any order; the most useful one goes first. Every change to the table
+ * bumps trie->generation after it is made. Entries carry the generation
+ * read before their lookup, so anything filled while an update was under
+ * way stops matching once it finishes.
+ *
+ * A cache belongs to one thread and one trie; lookups on the trie itself
+ * and updates may run in other threads meanwhile.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_RANGE_CACHE_DEFAULT  4096
+#define LPM_RANGE_CACHE_MAX      (1U << 24)
+#define LPM_RANGE_MAX_SPANS      16     /* Range lengths are multiples of 8 */
+
+struct lpm_range_entry {
+    uint64_t hi;              /* Address masked to span bits, big-endian halves */
+    uint64_t lo;
+    uint64_t generation;
+    uint32_t next_hop;
+    uint8_t span;
+};
+
+struct lpm_range_cache {
+    const lpm_trie_t *trie;
+    struct lpm_range_entry *entries;
+    uint32_t mask;
+    uint32_t nspans;
+    uint64_t generation;      /* Of spans[] */
+    uint8_t spans[LPM_RANGE_MAX_SPANS];     /* Probe order */
+    uint64_t span_hits[LPM_RANGE_MAX_SPANS];
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+};
+
+/* ============================================================================
+ * Walks That Report Their Range
+ * ============================================================================ */
+
+static uint32_t with_default(const lpm_trie_t *trie, uint32_t r)
+{
+    if (r != LPM_INVALID_NEXT_HOP || !trie->has_default_route) { return r; }
+    return trie->default_next_hop;
+}
+
+static uint32_t walk_stride(const lpm_trie_t *trie, const uint8_t *addr, uint8_t *span)
+{
+    const lpm_node_t *P = trie->node_pool;
+    uint32_t n = trie->root_idx;
+    uint32_t r = LPM_INVALID_NEXT_HOP;
+    unsigned bytes = trie->max_depth / 8;
+
+    *span = trie->max_depth;
+    for (unsigned i = 0; i < bytes; i++) {
+        const struct lpm_entry *e = &P[n].entries[addr[i]];
+        uint32_t cv = e->child_and_valid;
+        if (cv & LPM_VALID_FLAG) { r = e->next_hop; }
+        n = cv & LPM_CHILD_MASK;
+        if (!n) {
+            *span = (uint8_t)(8 * (i + 1));
+            break;
+        }
+    }
+    return with_default(trie, r);
+}
+
+static uint32_t walk_wide16(const lpm_trie_t *trie, const uint8_t *addr, uint8_t *span)
+{
+    uint32_t r = LPM_INVALID_NEXT_HOP;
+    uint32_t n = trie->root_idx;
+
+    for (unsigned level = 0; level < trie->wide_levels; level++) {
+        uint16_t index = (uint16_t)(((uint16_t)addr[level * 2] << 8) | addr[level * 2 + 1]);
+        const struct lpm_entry *e = lpm_wide16_entry(trie, level, n, index);
+        uint32_t cv = e->child_and_valid;
+        if (cv & LPM_VALID_FLAG) { r = e->next_hop; }
+        n = cv & LPM_CHILD_MASK;
+        if (!n && !(cv & LPM_WIDE_NODE_FLAG)) {
+            *span = (uint8_t)(16 * (level + 1));
+            return with_default(trie, r);
+        }
+    }
+
+    const struct lpm_node *P = trie->node_pool;
+    *span = LPM_IPV6_MAX_DEPTH;
+    for (unsigned i = 2 * trie->wide_levels; i < 16; i++) {
+        const struct lpm_entry *e = &P[n].entries[addr[i]];
+        uint32_t cv = e->child_and_valid;
+        if (cv & LPM_VALID_FLAG) { r = e->next_hop; }
+        n = cv & LPM_CHILD_MASK;
+        if (n == LPM_INVALID_INDEX) {
+            *span = (uint8_t)(8 * (i + 1));
+            break;
+        }
+    }
+    return with_default(trie, r);
+}
+
+/* Next hop of addr, and the length of the range that resolves the same */
+static uint32_t walk(const lpm_trie_t *trie, const uint8_t *addr, uint8_t *span)
+{
+    if (trie->adapt) {
+        return walk(lpm_adapt_active(trie)->engine, addr, span);
+    }
+
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        uint32_t a = ((uint32_t)addr[0] << 24) | ((uint32_t)addr[1] << 16) |
+                     ((uint32_t)addr[2] << 8) | addr[3];
+        if (trie->use_ipv4_dir24 && trie->dir24_table) {
+            *span = (trie->dir24_table[a >> 8].data & LPM_DIR24_EXT_FLAG) ? 32 : 24;
+            return lpm_lookup_ipv4_dir24(trie, a);
+        }
+        if (trie->dir24c_table) {
+            *span = (trie->dir24c_table[a >> 8] & LPM_DIR24C_EXT_FLAG) ? 32 : 24;
+            return lpm_lookup_ipv4_dir24_compact(trie, a);
+        }
+        if (!trie->small && !trie->lctrie && !trie->set) {
+            return walk_stride(trie, addr, span);
+        }
+        *span = LPM_IPV4_MAX_DEPTH;
+        return lpm_lookup_ipv4(trie, a);
+    }
+
+    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) {
+        return walk_wide16(trie, addr, span);
+    }
+    if (!trie->set) {
+        return walk_stride(trie, addr, span);
+    }
+    *span = LPM_IPV6_MAX_DEPTH;
+    return lpm_lookup_ipv6(trie, addr);
+}
+
+/* ============================================================================
+ * Entries
+ * ============================================================================ */
+
+static uint64_t load_be64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return __builtin_bswap64(v);
+}
+
+static uint64_t mask_bits(unsigned bits)
+{
+    return bits == 0 ? 0 : bits >= 64 ? ~0ULL : ~0ULL << (64 - bits);
+}
+
+static struct lpm_range_entry *slot_of(const struct lpm_range_cache *c, uint64_t hi, uint64_t lo,
+                                       uint8_t span)
+{
+    uint64_t h = (hi * 0x9E3779B97F4A7C15ULL) ^ (lo * 0xC2B2AE3D27D4EB4FULL) ^ span;
+    h ^= h >> 29;
+    return &c->entries[(uint32_t)(h * 0xBF58476D1CE4E5B9ULL >> 32) & c->mask];
+}
+
+/* hi/lo hold the address; lo is 0 for IPv4 (its address sits in the top
+ * 32 bits of hi) */
+static uint32_t cached_lookup(struct lpm_range_cache *c, const uint8_t *addr, uint64_t hi, uint64_t lo)
+{
+    uint64_t gen = __atomic_load_n(&c->trie->generation, __ATOMIC_ACQUIRE);
+    if (gen != c->generation) {
+        c->generation = gen;
+        c->nspans = 0;
+        c->invalidations++;
+    }
+
+    for (uint32_t i = 0; i < c->nspans; i++) {
+        uint8_t s = c->spans[i];
+        uint64_t mh = hi & mask_bits(s);
+        uint64_t ml = lo & mask_bits(s > 64 ? s - 64 : 0);
+        const struct lpm_range_entry *e = slot_of(c, mh, ml, s);
+        if (e->generation != gen || e->span != s || e->hi != mh || e->lo != ml) { continue; }
+
+        /* Keep the busiest range length first */
+        c->hits++;
+        c->span_hits[i]++;
+        if (i > 0 && c->span_hits[i] > c->span_hits[i - 1]) {
+            c->spans[i] = c->spans[i - 1];
+            c->spans[i - 1] = s;
+            uint64_t t = c->span_hits[i];
+            c->span_hits[i] = c->span_hits[i - 1];
+            c->span_hits[i - 1] = t;
+        }
+        return e->next_hop;
+    }
+
+    c->misses++;
+    uint8_t s;
+    uint32_t nh = walk(c->trie, addr, &s);
+    uint64_t mh = hi & mask_bits(s);
+    uint64_t ml = lo & mask_bits(s > 64 ? s - 64 : 0);
+    *slot_of(c, mh, ml, s) = (struct lpm_range_entry){ .hi = mh, .lo = ml, .generation = gen,
+                                                       .next_hop = nh, .span = s };
+
+    uint32_t i = 0;
+    while (i < c->nspans && c->spans[i] != s) {
+        i++;
+    }
+    if (i == c->nspans && i < LPM_RANGE_MAX_SPANS) {
+        c->spans[i] = s;
+        c->span_hits[i] = 0;
+        c->nspans++;
+    }
+    return nh;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+lpm_range_cache_t *lpm_range_cache_create(const lpm_trie_t *trie, uint32_t entries)
+{
+    if (!trie || entries > LPM_RANGE_CACHE_MAX) { return NULL; }
+    if (entries == 0) { entries = LPM_RANGE_CACHE_DEFAULT; }
+    uint32_t n = 1;
+    while (n < entries) {
+        n <<= 1;
+    }
+
+    struct lpm_range_cache *c = calloc(1, sizeof(*c));
+    if (!c) { return NULL; }
+    c->entries = aligned_alloc(LPM_CACHE_LINE_SIZE, (size_t)n * sizeof(struct lpm_range_entry));
+    if (!c->entries) {
+        free(c);
+        return NULL;
+    }
+
+    /* Span 0 never matches: walks stop after at least one stride */
+    memset(c->entries, 0, (size_t)n * sizeof(struct lpm_range_entry));
+    c->trie = trie;
+    c->mask = n - 1;
+    c->generation = __atomic_load_n(&trie->generation, __ATOMIC_ACQUIRE);
+    return c;
+}
+
+void lpm_range_cache_destroy(lpm_range_cache_t *cache)
+{
+    if (!cache) { return; }
+    free(cache->entries);
+    free(cache);
+}
+
+uint32_t lpm_lookup_ipv4_cached(lpm_range_cache_t *cache, uint32_t addr)
+{
+    if (!cache || cache->trie->max_depth != LPM_IPV4_MAX_DEPTH) { return LPM_INVALID_NEXT_HOP; }
+    uint8_t bytes[4] = { (uint8_t)(addr >> 24), (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr };
+    return cached_lookup(cache, bytes, (uint64_t)addr << 32, 0);
+}
+
+uint32_t lpm_lookup_ipv6_cached(lpm_range_cache_t *cache, const uint8_t addr[16])
+{
+    if (!cache || !addr || cache->trie->max_depth != LPM_IPV6_MAX_DEPTH) { return LPM_INVALID_NEXT_HOP; }
+    return cached_lookup(cache, addr, load_be64(addr), load_be64(addr + 8));
+}
+
+int lpm_range_cache_stats(const lpm_range_cache_t *cache, lpm_range_cache_stats_t *stats)
+{
+    if (!cache || !stats) { return -1; }
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->invalidations = cache->invalidations;
+    stats->spans = cache->nspans;
+    return 0;
+}
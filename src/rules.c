@@ -0,0 +1,245 @@
+/*
+ * liblpm Rule Store
+ *
+ * Exact set of installed prefixes, kept next to the expanded lookup tables.
+ * Expansion-based engines overwrite shorter prefixes in place, so when a
+ * prefix is deleted the table alone cannot tell what was underneath it; the
+ * store answers that (lpm_rules_find_parent) and is the source of truth for
+ * anything that needs to enumerate routes.
+ *
+ * Open addressing with linear probing and backward-shift deletion, keyed on
+ * (masked prefix, length). Prefixes are stored as 16 bytes for both families.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_RULES_INITIAL_CAPACITY 1024  /* Power of two */
+
+static void rule_key(uint8_t key[16], const uint8_t *prefix, uint8_t len)
+{
+    uint8_t bytes = (len + 7) / 8;
+
+    memset(key, 0, 16);
+    memcpy(key, prefix, bytes);
+    if (len % 8) {
+        key[bytes - 1] &= (uint8_t)(0xFF << (8 - len % 8));
+    }
+}
+
+static uint32_t rule_slot(const struct lpm_rule_table *rt, const uint8_t key[16], uint8_t len)
+{
+    uint64_t lo, hi;
+    memcpy(&lo, key, 8);
+    memcpy(&hi, key + 8, 8);
+
+    uint64_t h = (lo ^ ((uint64_t)len << 56)) * 0x9E3779B97F4A7C15ULL;
+    h ^= hi * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 32;
+    return (uint32_t)h & (rt->capacity - 1);
+}
+
+static int rules_resize(struct lpm_rule_table *rt, uint32_t new_cap)
+{
+    uint32_t old_cap = rt->capacity;
+    struct lpm_rule *old = rt->slots;
+    struct lpm_rule *slots = calloc(new_cap, sizeof(*slots));
+    if (!slots) { return -1; }
+
+    rt->slots = slots;
+    rt->capacity = new_cap;
+    for (uint32_t i = 0; i < old_cap; i++) {
+        if (!old[i].used) { continue; }
+        uint32_t s = rule_slot(rt, old[i].prefix, old[i].len);
+        while (slots[s].used) {
+            s = (s + 1) & (rt->capacity - 1);
+        }
+        slots[s] = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+/* ============================================================================
+ * Lifetime
+ * ============================================================================ */
+
+struct lpm_rule_table *lpm_rules_create(void)
+{
+    struct lpm_rule_table *rt = calloc(1, sizeof(*rt));
+    if (!rt) { return NULL; }
+
+    rt->capacity = LPM_RULES_INITIAL_CAPACITY;
+    rt->slots = calloc(rt->capacity, sizeof(*rt->slots));
+    if (!rt->slots) {
+        free(rt);
+        return NULL;
+    }
+    return rt;
+}
+
+void lpm_rules_destroy(struct lpm_rule_table *rt)
+{
+    if (!rt) { return; }
+    free(rt->slots);
+    free(rt);
+}
+
+/* ============================================================================
+ * Queries and Updates
+ * ============================================================================ */
+
+struct lpm_rule *lpm_rules_find(const struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len)
+{
+    uint8_t key[16];
+
+    if (!rt || len > 128 || rt->len_count[len] == 0) { return NULL; }
+    rule_key(key, prefix, len);
+
+    for (uint32_t s = rule_slot(rt, key, len); rt->slots[s].used; s = (s + 1) & (rt->capacity - 1)) {
+        struct lpm_rule *r = &rt->slots[s];
+        if (r->len == len && memcmp(r->prefix, key, 16) == 0) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+int lpm_rules_reserve(struct lpm_rule_table *rt, size_t count)
+{
+    uint32_t cap = rt->capacity;
+    while ((uint64_t)count * 2 > cap) {
+        if (cap > UINT32_MAX / 2) { return -1; }
+        cap *= 2;
+    }
+    return cap == rt->capacity ? 0 : rules_resize(rt, cap);
+}
+
+int lpm_rules_insert(struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len,
+                     uint32_t next_hop, bool *existed)
+{
+    uint8_t key[16];
+
+    if (!rt || len > 128) { return -1; }
+
+    /* Keep the load factor at or below 1/2 */
+    if ((rt->count + 1) * 2 > rt->capacity && rules_resize(rt, rt->capacity * 2) < 0) { return -1; }
+
+    rule_key(key, prefix, len);
+    uint32_t s = rule_slot(rt, key, len);
+    for (; rt->slots[s].used; s = (s + 1) & (rt->capacity - 1)) {
+        struct lpm_rule *r = &rt->slots[s];
+        if (r->len == len && memcmp(r->prefix, key, 16) == 0) {
+            r->next_hop = next_hop;
+            if (existed) { *existed = true; }
+            return 0;
+        }
+    }
+
+    struct lpm_rule *r = &rt->slots[s];
+    memcpy(r->prefix, key, 16);
+    r->len = len;
+    r->used = 1;
+    r->next_hop = next_hop;
+    rt->count++;
+    rt->len_count[len]++;
+    if (existed) { *existed = false; }
+    return 0;
+}
+
+int lpm_rules_remove(struct lpm_rule_table *rt, const uint8_t *prefix, uint8_t len)
+{
+    struct lpm_rule *r = lpm_rules_find(rt, prefix, len);
+    if (!r) { return -1; }
+
+    uint32_t mask = rt->capacity - 1;
+    uint32_t hole = (uint32_t)(r - rt->slots);
+
+    /* Backward-shift deletion: pull later entries of the cluster into the hole */
+    for (uint32_t s = (hole + 1) & mask; rt->slots[s].used; s = (s + 1) & mask) {
+        uint32_t home = rule_slot(rt, rt->slots[s].prefix, rt->slots[s].len);
+        if (((s - home) & mask) >= ((s - hole) & mask)) {
+            rt->slots[hole] = rt->slots[s];
+            hole = s;
+        }
+    }
+    memset(&rt->slots[hole], 0, sizeof(rt->slots[hole]));
+
+    rt->count--;
+    rt->len_count[len]--;
+    return 0;
+}
+
+struct lpm_rule *lpm_rules_find_parent(const struct lpm_rule_table *rt, const uint8_t *prefix,
+                                       uint8_t len)
+{
+    if (!rt) { return NULL; }
+
+    /* Lengths with no rules are skipped without hashing */
+    for (int l = (int)len - 1; l >= 1; l--) {
+        if (rt->len_count[l] == 0) { continue; }
+        struct lpm_rule *r = lpm_rules_find(rt, prefix, (uint8_t)l);
+        if (r) { return r; }
+    }
+    return NULL;
+}
+
+/* True if prefix/len covers the first len bits of key */
+static bool rule_under(const uint8_t key[16], const uint8_t *prefix, uint8_t len)
+{
+    uint8_t full = len / 8;
+    if (memcmp(key, prefix, full) != 0) { return false; }
+    if (len % 8) {
+        uint8_t m = (uint8_t)(0xFF << (8 - len % 8));
+        return (key[full] & m) == (prefix[full] & m);
+    }
+    return true;
+}
+
+void lpm_rules_for_each_within(const struct lpm_rule_table *rt, const uint8_t *prefix,
+                               uint8_t len, uint8_t max_len,
+                               void (*fn)(const struct lpm_rule *r, void *ctx), void *ctx)
+{
+    if (!rt || len >= max_len) { return; }
+
+    /* Probing every sub-prefix costs 2^(l - len) lookups per length; fall
+     * back to a full scan when that exceeds the number of rules */
+    uint64_t probes = 0;
+    for (unsigned l = len + 1u; l <= max_len; l++) {
+        if (rt->len_count[l] == 0) { continue; }
+        probes += (l - len >= 32) ? UINT32_MAX : (1ULL << (l - len));
+        if (probes >= rt->count) { break; }
+    }
+
+    if (probes >= rt->count) {
+        for (uint32_t i = 0; i < rt->capacity; i++) {
+            const struct lpm_rule *r = &rt->slots[i];
+            if (r->used && r->len > len && r->len <= max_len && rule_under(r->prefix, prefix, len)) {
+                fn(r, ctx);
+            }
+        }
+        return;
+    }
+
+    uint8_t key[16];
+    rule_key(key, prefix, len);
+    for (unsigned l = len + 1u; l <= max_len; l++) {
+        if (rt->len_count[l] == 0) { continue; }
+        uint8_t sub[16];
+        for (uint64_t k = 0; k < (1ULL << (l - len)); k++) {
+            /* Write the l - len bits of k right after the first len bits */
+            memcpy(sub, key, 16);
+            for (unsigned b = 0; b < l - len; b++) {
+                if ((k >> (l - len - 1 - b)) & 1) {
+                    unsigned pos = len + b;
+                    sub[pos / 8] |= (uint8_t)(0x80 >> (pos % 8));
+                }
+            }
+            const struct lpm_rule *r = lpm_rules_find(rt, sub, (uint8_t)l);
+            if (r) { fn(r, ctx); }
+        }
+    }
+}
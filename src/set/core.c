@@ -0,0 +1,453 @@
+/*
+ * liblpm Membership Sets - Core Functions
+ * Create, Add, Delete for address sets that only answer "is it covered"
+ *
+ * IPv4: a 2MB bitmap with one bit per /24 covered by a prefix up to /24, a
+ * second 2MB bitmap marking /24s that hold longer prefixes, and a hash of
+ * 256-bit blocks for those /24s.
+ *
+ * IPv6: a byte-stride trie whose nodes are two 256-bit bitmaps (covered
+ * bytes, bytes with a child) plus a rank-indexed child array, about 80 bytes
+ * per node instead of 2KB.
+ *
+ * Coverage is a union, so deleting a prefix cannot simply clear its bits:
+ * the affected range is rebuilt from the rule store (same-stride parents and
+ * children of the deleted prefix).
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+#define LPM_SET_INITIAL_BLOCKS 64   /* Power of two */
+#define LPM_SET_INITIAL_NODES  256
+
+/* ============================================================================
+ * Bitmap Helpers
+ * ============================================================================ */
+
+static void bits_assign(uint64_t *bm, uint32_t first, uint32_t count, bool value)
+{
+    uint32_t i = first, end = first + count;
+
+    /* Partial leading word, whole words, partial trailing word */
+    while (i < end && (i & 63)) {
+        bm[i >> 6] = value ? (bm[i >> 6] | (1ULL << (i & 63))) : (bm[i >> 6] & ~(1ULL << (i & 63)));
+        i++;
+    }
+    if (i + 64 <= end) {
+        memset(&bm[i >> 6], value ? 0xFF : 0, ((end - i) >> 6) * sizeof(uint64_t));
+        i += (end - i) & ~63U;
+    }
+    while (i < end) {
+        bm[i >> 6] = value ? (bm[i >> 6] | (1ULL << (i & 63))) : (bm[i >> 6] & ~(1ULL << (i & 63)));
+        i++;
+    }
+}
+
+static bool bits_empty(const uint64_t bm[4])
+{
+    return !(bm[0] | bm[1] | bm[2] | bm[3]);
+}
+
+/* Entries [first, first + count) of an 8-bit stride covered by byte/rem bits */
+static void stride_range(uint8_t byte, uint8_t rem, uint32_t *first, uint32_t *count)
+{
+    *count = 1U << (8 - rem);
+    *first = byte & ~(*count - 1);
+}
+
+/* ============================================================================
+ * Creation / Destruction
+ * ============================================================================ */
+
+static lpm_trie_t *set_create(uint8_t max_depth)
+{
+    lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
+    if (!t) { return NULL; }
+    memset(t, 0, sizeof(lpm_trie_t));
+
+    t->max_depth = max_depth;
+    t->default_next_hop = LPM_INVALID_NEXT_HOP;
+    t->rules = lpm_rules_create();
+    t->set = calloc(1, sizeof(struct lpm_set));
+    if (!t->rules || !t->set) {
+        lpm_destroy(t);
+        return NULL;
+    }
+
+    struct lpm_set *s = t->set;
+    if (max_depth == LPM_IPV4_MAX_DEPTH) {
+        s->cover = aligned_alloc(LPM_CACHE_LINE_SIZE, LPM_SET_IPV4_BITMAP_BYTES);
+        s->ext = aligned_alloc(LPM_CACHE_LINE_SIZE, LPM_SET_IPV4_BITMAP_BYTES);
+        s->block_capacity = LPM_SET_INITIAL_BLOCKS;
+        s->blocks = calloc(s->block_capacity, sizeof(struct lpm_set_block));
+        if (!s->cover || !s->ext || !s->blocks) {
+            lpm_destroy(t);
+            return NULL;
+        }
+        memset(s->cover, 0, LPM_SET_IPV4_BITMAP_BYTES);
+        memset(s->ext, 0, LPM_SET_IPV4_BITMAP_BYTES);
+    } else {
+        s->node_capacity = LPM_SET_INITIAL_NODES;
+        s->nodes = calloc(s->node_capacity, sizeof(struct lpm_set_node6));
+        if (!s->nodes) {
+            lpm_destroy(t);
+            return NULL;
+        }
+        s->node_used = 1;   /* Root */
+        s->node_live = 1;
+    }
+    lpm_dispatch_init(t);
+    return t;
+}
+
+lpm_trie_t *lpm_create_set_ipv4(void)
+{
+    return set_create(LPM_IPV4_MAX_DEPTH);
+}
+
+lpm_trie_t *lpm_create_set_ipv6(void)
+{
+    return set_create(LPM_IPV6_MAX_DEPTH);
+}
+
+void lpm_set_destroy(struct lpm_set *s)
+{
+    if (!s) { return; }
+    free(s->cover);
+    free(s->ext);
+    free(s->blocks);
+    for (uint32_t i = 0; i < s->node_used; i++) {
+        free(s->nodes[i].children);
+    }
+    free(s->nodes);
+    free(s);
+}
+
+size_t lpm_set_memory(const lpm_trie_t *trie)
+{
+    const struct lpm_set *s = trie->set;
+    if (!s) { return 0; }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        return 2 * LPM_SET_IPV4_BITMAP_BYTES + (size_t)s->block_capacity * sizeof(struct lpm_set_block);
+    }
+    size_t bytes = (size_t)s->node_capacity * sizeof(struct lpm_set_node6);
+    for (uint32_t i = 0; i < s->node_used; i++) {
+        bytes += (size_t)s->nodes[i].num_children * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+/* ============================================================================
+ * IPv4 Blocks (/25-/32)
+ * ============================================================================ */
+
+static int blocks_grow(struct lpm_set *s)
+{
+    uint32_t old_cap = s->block_capacity;
+    struct lpm_set_block *old = s->blocks;
+    struct lpm_set_block *blocks = calloc((size_t)old_cap * 2, sizeof(*blocks));
+    if (!blocks) { return -1; }
+
+    uint32_t mask = old_cap * 2 - 1;
+    for (uint32_t i = 0; i < old_cap; i++) {
+        if (!old[i].key) { continue; }
+        uint32_t j = lpm_set_block_home(old[i].key - 1, mask);
+        while (blocks[j].key) {
+            j = (j + 1) & mask;
+        }
+        blocks[j] = old[i];
+    }
+    s->blocks = blocks;
+    s->block_capacity = old_cap * 2;
+    free(old);
+    return 0;
+}
+
+static struct lpm_set_block *block_get(struct lpm_set *s, uint32_t idx24)
+{
+    struct lpm_set_block *b = (struct lpm_set_block *)lpm_set_block_find(s, idx24);
+    if (b) { return b; }
+
+    /* Keep the load factor at or below 1/2 */
+    if ((s->block_count + 1) * 2 > s->block_capacity && blocks_grow(s) < 0) { return NULL; }
+
+    uint32_t mask = s->block_capacity - 1;
+    uint32_t i = lpm_set_block_home(idx24, mask);
+    while (s->blocks[i].key) {
+        i = (i + 1) & mask;
+    }
+    b = &s->blocks[i];
+    memset(b->bits, 0, sizeof(b->bits));
+    b->key = idx24 + 1;
+    s->block_count++;
+    return b;
+}
+
+static void block_remove(struct lpm_set *s, struct lpm_set_block *b)
+{
+    uint32_t mask = s->block_capacity - 1;
+    uint32_t hole = (uint32_t)(b - s->blocks);
+
+    /* Backward-shift deletion */
+    for (uint32_t i = (hole + 1) & mask; s->blocks[i].key; i = (i + 1) & mask) {
+        uint32_t home = lpm_set_block_home(s->blocks[i].key - 1, mask);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            s->blocks[hole] = s->blocks[i];
+            hole = i;
+        }
+    }
+    memset(&s->blocks[hole], 0, sizeof(s->blocks[hole]));
+    s->block_count--;
+}
+
+/* ============================================================================
+ * IPv4 Add/Delete
+ * ============================================================================ */
+
+static uint32_t ipv4_idx24(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+/* Mark the range of one rule (len 1..32) covered */
+static int set4_mark(struct lpm_set *s, const uint8_t *prefix, uint8_t len)
+{
+    if (len <= 24) {
+        uint32_t count = 1U << (24 - len);
+        bits_assign(s->cover, ipv4_idx24(prefix) & ~(count - 1), count, true);
+        return 0;
+    }
+
+    uint32_t idx = ipv4_idx24(prefix);
+    struct lpm_set_block *b = block_get(s, idx);
+    if (!b) { return -1; }
+    uint32_t first, count;
+    stride_range(prefix[3], len - 24, &first, &count);
+    bits_assign(b->bits, first, count, true);
+    bits_assign(s->ext, idx, 1, true);
+    return 0;
+}
+
+static void set4_mark_rule(const struct lpm_rule *r, void *ctx)
+{
+    set4_mark((struct lpm_set *)ctx, r->prefix, r->len);
+}
+
+static void set4_unmark(lpm_trie_t *trie, const uint8_t *prefix, uint8_t len)
+{
+    struct lpm_set *s = trie->set;
+
+    if (len <= 24) {
+        /* A remaining shorter prefix still covers the whole range */
+        if (lpm_rules_find_parent(trie->rules, prefix, len)) { return; }
+        uint32_t count = 1U << (24 - len);
+        bits_assign(s->cover, ipv4_idx24(prefix) & ~(count - 1), count, false);
+        lpm_rules_for_each_within(trie->rules, prefix, len, 24, set4_mark_rule, s);
+        return;
+    }
+
+    /* Longer prefixes live in the /24's block; only /25+ parents matter there */
+    for (uint8_t l = len - 1; l > 24; l--) {
+        if (lpm_rules_find(trie->rules, prefix, l)) { return; }
+    }
+    uint32_t idx = ipv4_idx24(prefix);
+    struct lpm_set_block *b = (struct lpm_set_block *)lpm_set_block_find(s, idx);
+    if (!b) { return; }
+    uint32_t first, count;
+    stride_range(prefix[3], len - 24, &first, &count);
+    bits_assign(b->bits, first, count, false);
+    lpm_rules_for_each_within(trie->rules, prefix, len, 32, set4_mark_rule, s);
+
+    if (bits_empty(b->bits)) {
+        bits_assign(s->ext, idx, 1, false);
+        block_remove(s, b);
+    }
+}
+
+/* ============================================================================
+ * IPv6 Nodes
+ * ============================================================================ */
+
+static uint32_t node6_alloc(struct lpm_set *s)
+{
+    uint32_t idx;
+    if (s->free_head) {
+        idx = s->free_head;
+        s->free_head = s->nodes[idx].next_free;
+    } else {
+        if (s->node_used == s->node_capacity) {
+            struct lpm_set_node6 *nodes = realloc(s->nodes, (size_t)s->node_capacity * 2 * sizeof(*nodes));
+            if (!nodes) { return 0; }
+            s->nodes = nodes;
+            s->node_capacity *= 2;
+        }
+        idx = s->node_used++;
+    }
+    memset(&s->nodes[idx], 0, sizeof(s->nodes[idx]));
+    s->node_live++;
+    return idx;
+}
+
+static uint32_t node6_rank(const struct lpm_set_node6 *n, uint8_t byte)
+{
+    uint32_t r = 0;
+    for (unsigned w = 0; w < (unsigned)(byte >> 6); w++) {
+        r += (uint32_t)__builtin_popcountll(n->child[w]);
+    }
+    return r + (uint32_t)__builtin_popcountll(n->child[byte >> 6] & ((1ULL << (byte & 63)) - 1));
+}
+
+/* Child of node for byte, created on demand; 0 if missing and !create or on OOM */
+static uint32_t node6_child(struct lpm_set *s, uint32_t node, uint8_t byte, bool create)
+{
+    struct lpm_set_node6 *n = &s->nodes[node];
+    uint32_t rank = node6_rank(n, byte);
+    if (lpm_set_bit(n->child, byte)) {
+        return n->children[rank];
+    }
+    if (!create) { return 0; }
+
+    uint32_t child = node6_alloc(s);
+    if (!child) { return 0; }
+    n = &s->nodes[node];   /* The pool may have moved */
+
+    uint32_t *children = realloc(n->children, (n->num_children + 1) * sizeof(uint32_t));
+    if (!children) {
+        s->nodes[child].next_free = s->free_head;
+        s->free_head = child;
+        s->node_live--;
+        return 0;
+    }
+    memmove(&children[rank + 1], &children[rank], (n->num_children - rank) * sizeof(uint32_t));
+    children[rank] = child;
+    n->children = children;
+    n->num_children++;
+    bits_assign(n->child, byte, 1, true);
+    return child;
+}
+
+static void node6_unlink(struct lpm_set *s, uint32_t parent, uint8_t byte)
+{
+    struct lpm_set_node6 *n = &s->nodes[parent];
+    uint32_t rank = node6_rank(n, byte);
+    uint32_t child = n->children[rank];
+
+    memmove(&n->children[rank], &n->children[rank + 1], (n->num_children - rank - 1) * sizeof(uint32_t));
+    n->num_children--;
+    bits_assign(n->child, byte, 1, false);
+
+    free(s->nodes[child].children);
+    memset(&s->nodes[child], 0, sizeof(s->nodes[child]));
+    s->nodes[child].next_free = s->free_head;
+    s->free_head = child;
+    s->node_live--;
+}
+
+/* ============================================================================
+ * IPv6 Add/Delete
+ * ============================================================================ */
+
+struct set6_ctx {
+    struct lpm_set *s;
+    uint32_t node;
+};
+
+/* Set the leaf bits of a rule whose last stride ends in node */
+static void set6_mark_rule(const struct lpm_rule *r, void *arg)
+{
+    struct set6_ctx *ctx = arg;
+    uint8_t d = (uint8_t)((r->len - 1) / 8);
+    uint32_t first, count;
+    stride_range(r->prefix[d], (uint8_t)(r->len - 8 * d), &first, &count);
+    bits_assign(ctx->s->nodes[ctx->node].leaf, first, count, true);
+}
+
+static int set6_mark(struct lpm_set *s, const uint8_t *prefix, uint8_t len)
+{
+    uint8_t d = (uint8_t)((len - 1) / 8);
+    uint32_t node = 0;
+    for (uint8_t i = 0; i < d; i++) {
+        node = node6_child(s, node, prefix[i], true);
+        if (!node) { return -1; }
+    }
+
+    uint32_t first, count;
+    stride_range(prefix[d], (uint8_t)(len - 8 * d), &first, &count);
+    bits_assign(s->nodes[node].leaf, first, count, true);
+    return 0;
+}
+
+static void set6_unmark(lpm_trie_t *trie, const uint8_t *prefix, uint8_t len)
+{
+    struct lpm_set *s = trie->set;
+    uint8_t d = (uint8_t)((len - 1) / 8);
+    uint32_t path[16];
+
+    path[0] = 0;
+    for (uint8_t i = 0; i < d; i++) {
+        path[i + 1] = node6_child(s, path[i], prefix[i], false);
+        if (!path[i + 1]) { return; }
+    }
+
+    /* A shorter prefix ending in the same node still covers the range */
+    for (uint8_t l = len - 1; l > 8 * d; l--) {
+        if (lpm_rules_find(trie->rules, prefix, l)) { return; }
+    }
+
+    struct set6_ctx ctx = {s, path[d]};
+    uint32_t first, count;
+    stride_range(prefix[d], (uint8_t)(len - 8 * d), &first, &count);
+    bits_assign(s->nodes[path[d]].leaf, first, count, false);
+    lpm_rules_for_each_within(trie->rules, prefix, len, (uint8_t)(8 * d + 8), set6_mark_rule, &ctx);
+
+    /* Release nodes left with neither coverage nor children */
+    for (int i = d; i > 0; i--) {
+        const struct lpm_set_node6 *n = &s->nodes[path[i]];
+        if (n->num_children || !bits_empty(n->leaf)) { break; }
+        node6_unlink(s, path[i - 1], prefix[i - 1]);
+    }
+}
+
+/* ============================================================================
+ * Add/Delete Prefix
+ * ============================================================================ */
+
+int lpm_add_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (!trie || !trie->set || !prefix || prefix_len > trie->max_depth) { return -1; }
+
+    if (lpm_rules_find(trie->rules, prefix, prefix_len)) { return 0; }
+
+    if (prefix_len == 0) {
+        trie->has_default_route = true;
+    } else {
+        int rc = trie->max_depth == LPM_IPV4_MAX_DEPTH ? set4_mark(trie->set, prefix, prefix_len)
+                                                       : set6_mark(trie->set, prefix, prefix_len);
+        if (rc < 0) { return -1; }
+    }
+
+    if (lpm_rules_insert(trie->rules, prefix, prefix_len, 0, NULL) < 0) { return -1; }
+    trie->num_prefixes++;
+    return 0;
+}
+
+int lpm_delete_set(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (!trie || !trie->set || !prefix || prefix_len > trie->max_depth) { return -1; }
+
+    if (lpm_rules_remove(trie->rules, prefix, prefix_len) < 0) { return -1; }
+    if (trie->num_prefixes > 0) { trie->num_prefixes--; }
+
+    if (prefix_len == 0) {
+        trie->has_default_route = false;
+    } else if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        set4_unmark(trie, prefix, prefix_len);
+    } else {
+        set6_unmark(trie, prefix, prefix_len);
+    }
+    return 0;
+}
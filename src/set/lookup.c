@@ -0,0 +1,258 @@
+/*
+ * liblpm Membership Sets - Lookups
+ *
+ * IPv4 batch kernels gather the 32-bit cover word of each /24 and shift the
+ * lane's bit down, so a batch with no /25+ coverage never leaves the vector
+ * unit. Lanes whose /24 holds longer prefixes fall back to the block probe.
+ * Results are packed into a bitmask, one bit per address.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef LPM_X86_ARCH
+#include <immintrin.h>
+#endif
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+/* ============================================================================
+ * Single Lookup
+ * ============================================================================ */
+
+bool lpm_contains_ipv4(const lpm_trie_t *set, uint32_t addr)
+{
+    if (!set || !set->set || !set->set->cover) { return false; }
+    return set->has_default_route || lpm_set_contains_ipv4_inline(set->set, addr);
+}
+
+bool lpm_contains_ipv6(const lpm_trie_t *set, const uint8_t addr[16])
+{
+    if (!set || !set->set || !set->set->nodes || !addr) { return false; }
+    if (set->has_default_route) { return true; }
+
+    const struct lpm_set_node6 *nodes = set->set->nodes;
+    const struct lpm_set_node6 *n = &nodes[0];
+    for (int i = 0; i < 16; i++) {
+        uint8_t byte = addr[i];
+        if (lpm_set_bit(n->leaf, byte)) { return true; }
+        if (!lpm_set_bit(n->child, byte)) { return false; }
+
+        /* Rank of the child bit = index into the child array */
+        uint32_t rank = 0;
+        for (unsigned w = 0; w < (unsigned)(byte >> 6); w++) {
+            rank += (uint32_t)__builtin_popcountll(n->child[w]);
+        }
+        rank += (uint32_t)__builtin_popcountll(n->child[byte >> 6] & ((1ULL << (byte & 63)) - 1));
+        n = &nodes[n->children[rank]];
+    }
+    return false;
+}
+
+/* ============================================================================
+ * Batch Helpers
+ * ============================================================================ */
+
+static inline void mask_clear(uint64_t *mask, size_t count)
+{
+    memset(mask, 0, ((count + 63) / 64) * sizeof(uint64_t));
+}
+
+/* OR bits (one per address, LSB first) for addresses [i, i + n) into mask */
+static inline void mask_put(uint64_t *mask, size_t i, uint64_t bits, unsigned n)
+{
+    mask[i >> 6] |= bits << (i & 63);
+    if ((i & 63) + n > 64) {
+        mask[(i >> 6) + 1] |= bits >> (64 - (i & 63));
+    }
+}
+
+/* ============================================================================
+ * Scalar Batch Implementation
+ * ============================================================================ */
+
+__attribute__((hot))
+size_t lpm_contains_batch_ipv4_scalar(const lpm_trie_t *set, const uint32_t *addrs,
+                                      uint64_t *mask, size_t count)
+{
+    const struct lpm_set *s = set->set;
+    size_t hits = 0;
+
+    mask_clear(mask, count);
+    if (set->has_default_route) {
+        for (size_t i = 0; i < count; i++) {
+            mask[i >> 6] |= 1ULL << (i & 63);
+        }
+        return count;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (i + 8 < count) {
+            __builtin_prefetch(&s->cover[(addrs[i + 8] >> 8) >> 6], 0, 0);
+        }
+        uint64_t hit = lpm_set_contains_ipv4_inline(s, addrs[i]);
+        mask[i >> 6] |= hit << (i & 63);
+        hits += hit;
+    }
+    return hits;
+}
+
+/* ============================================================================
+ * AVX2 Batch - 8 addresses per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("avx2")))
+size_t lpm_contains_batch_ipv4_avx2(const lpm_trie_t *set, const uint32_t *addrs,
+                                    uint64_t *mask, size_t count)
+{
+    const struct lpm_set *s = set->set;
+    if (set->has_default_route) {
+        return lpm_contains_batch_ipv4_scalar(set, addrs, mask, count);
+    }
+
+    const int *cover = (const int *)s->cover;
+    const int *ext = (const int *)s->ext;
+    const __m256i low5 = _mm256_set1_epi32(31);
+    const __m256i ones = _mm256_set1_epi32(1);
+    size_t hits = 0;
+    size_t i = 0;
+
+    mask_clear(mask, count);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&addrs[i]);
+        __m256i idx = _mm256_srli_epi32(a, 8);
+        __m256i word = _mm256_srli_epi32(idx, 5);
+        __m256i shift = _mm256_and_si256(idx, low5);
+
+        /* GATHER: cover word of each /24, then isolate the lane's bit */
+        __m256i c = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32(cover, word, 4), shift), ones);
+        uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(c, 31)));
+
+        /* Uncovered lanes whose /24 has longer prefixes */
+        __m256i e = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32(ext, word, 4), shift), ones);
+        uint32_t pending = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(e, 31))) & ~bits;
+        while (pending) {
+            unsigned lane = (unsigned)__builtin_ctz(pending);
+            pending &= pending - 1;
+            const struct lpm_set_block *b = lpm_set_block_find(s, addrs[i + lane] >> 8);
+            if (b && lpm_set_bit(b->bits, addrs[i + lane] & 0xFF)) {
+                bits |= 1U << lane;
+            }
+        }
+
+        mask_put(mask, i, bits, 8);
+        hits += (size_t)__builtin_popcount(bits);
+    }
+
+    /* Scalar remainder */
+    for (; i < count; i++) {
+        uint64_t hit = lpm_set_contains_ipv4_inline(s, addrs[i]);
+        mask[i >> 6] |= hit << (i & 63);
+        hits += hit;
+    }
+    return hits;
+}
+
+/* ============================================================================
+ * AVX512 Batch - 16 addresses per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("avx512f")))
+size_t lpm_contains_batch_ipv4_avx512(const lpm_trie_t *set, const uint32_t *addrs,
+                                      uint64_t *mask, size_t count)
+{
+    const struct lpm_set *s = set->set;
+    if (set->has_default_route) {
+        return lpm_contains_batch_ipv4_scalar(set, addrs, mask, count);
+    }
+
+    const __m512i low5 = _mm512_set1_epi32(31);
+    const __m512i ones = _mm512_set1_epi32(1);
+    size_t hits = 0;
+    size_t i = 0;
+
+    mask_clear(mask, count);
+
+    for (; i + 16 <= count; i += 16) {
+        __m512i a = _mm512_loadu_si512(&addrs[i]);
+        __m512i idx = _mm512_srli_epi32(a, 8);
+        __m512i word = _mm512_srli_epi32(idx, 5);
+        __m512i shift = _mm512_and_si512(idx, low5);
+
+        __m512i c = _mm512_srlv_epi32(_mm512_i32gather_epi32(word, s->cover, 4), shift);
+        uint32_t bits = _mm512_test_epi32_mask(c, ones);
+
+        /* Only gather ext words for the lanes that missed */
+        __m512i e = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), (__mmask16)~bits, word, s->ext, 4);
+        uint32_t pending = _mm512_test_epi32_mask(_mm512_srlv_epi32(e, shift), ones);
+        while (pending) {
+            unsigned lane = (unsigned)__builtin_ctz(pending);
+            pending &= pending - 1;
+            const struct lpm_set_block *b = lpm_set_block_find(s, addrs[i + lane] >> 8);
+            if (b && lpm_set_bit(b->bits, addrs[i + lane] & 0xFF)) {
+                bits |= 1U << lane;
+            }
+        }
+
+        mask_put(mask, i, bits, 16);
+        hits += (size_t)__builtin_popcount(bits);
+    }
+
+    /* Handle remaining with AVX2 (it clears only its own mask words) */
+    if (i < count) {
+        uint64_t tail[1] = {0};
+        size_t n = count - i;
+        hits += lpm_contains_batch_ipv4_avx2(set, &addrs[i], tail, n);
+        mask_put(mask, i, tail[0], (unsigned)n);
+    }
+    return hits;
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_contains_batch_ipv4_resolver)
+{
+    simd_level_t level = LPM_DETECT_SIMD();
+
+    switch (level) {
+    case SIMD_AVX512F:
+        return (void*)lpm_contains_batch_ipv4_avx512;
+    case SIMD_AVX2:
+        return (void*)lpm_contains_batch_ipv4_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return (void*)lpm_contains_batch_ipv4_scalar;
+    }
+}
+
+size_t lpm_contains_batch_ipv4(const lpm_trie_t *set, const uint32_t *addrs,
+                               uint64_t *mask, size_t count)
+    __attribute__((ifunc("lpm_contains_batch_ipv4_resolver")));
+
+/* ============================================================================
+ * IPv6 Batch
+ * The trie walk is data dependent per address, so this stays scalar.
+ * ============================================================================ */
+
+size_t lpm_contains_batch_ipv6(const lpm_trie_t *set, const uint8_t (*addrs)[16],
+                               uint64_t *mask, size_t count)
+{
+    size_t hits = 0;
+
+    mask_clear(mask, count);
+    for (size_t i = 0; i < count; i++) {
+        if (i + 4 < count) {
+            __builtin_prefetch(addrs[i + 4], 0, 0);
+        }
+        uint64_t hit = lpm_contains_ipv6(set, addrs[i]);
+        mask[i >> 6] |= hit << (i & 63);
+        hits += hit;
+    }
+    return hits;
+}
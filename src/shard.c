@@ -0,0 +1,273 @@
+/*
+ * liblpm Sharded Writers
+ *
+ * Updates are single-threaded by default: every add touches shared state
+ * (the rule store, the tbl8 allocator, the prefix count). Once
+ * lpm_enable_sharded_writers() is called on a DIR-24-8 trie, ownership is
+ * split by the top shard_bits of the address. Each shard has its own lock,
+ * its own rule table for the prefixes inside it, and a reservation of tbl8
+ * groups it allocates from, so updates to different shards run in parallel.
+ *
+ * Prefixes shorter than shard_bits (and the default route) span several
+ * shards; they take every shard lock, in order, and keep their rules in the
+ * trie's own table. A shard writer reads that table under its own lock,
+ * which is safe because it is only written with every lock held.
+ *
+ * The tbl8 arrays are shared. A shard whose reservation runs out takes a
+ * new chunk of groups under a short pool lock; when the arrays themselves
+ * must grow, it drops its lock and takes all of them, since growing moves
+ * the arrays every writer is storing into. Updates reserve before they
+ * change anything, so a dropped lock never splits an update.
+ *
+ * Lookups need no locks: entries change with single stores as before.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_SHARD_MAX_BITS    8
+#define LPM_SHARD_TBL8_CHUNK  16     /* Groups a shard reserves at a time */
+
+struct lpm_shard {
+    pthread_mutex_t lock;
+    struct lpm_rule_table *rules;    /* Prefixes of shard_bits or longer */
+    uint32_t tbl8_next;              /* Reserved groups [tbl8_next, tbl8_end) */
+    uint32_t tbl8_end;
+} LPM_ALIGN_CACHE;
+
+struct lpm_shards {
+    pthread_mutex_t pool_lock;       /* tbl8_groups_used */
+    unsigned bits;
+    uint32_t count;
+    struct lpm_shard shard[];
+};
+
+static void lock_all(struct lpm_shards *x)
+{
+    for (uint32_t i = 0; i < x->count; i++) {
+        pthread_mutex_lock(&x->shard[i].lock);
+    }
+}
+
+static void unlock_all(struct lpm_shards *x)
+{
+    for (uint32_t i = x->count; i-- > 0;) {
+        pthread_mutex_unlock(&x->shard[i].lock);
+    }
+}
+
+void lpm_shards_destroy(struct lpm_shards *x)
+{
+    if (!x) { return; }
+    for (uint32_t i = 0; i < x->count; i++) {
+        pthread_mutex_destroy(&x->shard[i].lock);
+        lpm_rules_destroy(x->shard[i].rules);
+    }
+    pthread_mutex_destroy(&x->pool_lock);
+    free(x);
+}
+
+/* ============================================================================
+ * tbl8 Reservations
+ * ============================================================================ */
+
+/* Called with s locked; s may be unlocked and relocked while the arrays grow */
+static int tbl8_refill(lpm_trie_t *trie, struct lpm_shards *x, struct lpm_shard *s)
+{
+    pthread_mutex_lock(&x->pool_lock);
+    uint32_t left = trie->tbl8_num_groups - trie->tbl8_groups_used;
+    if (left) {
+        uint32_t n = left < LPM_SHARD_TBL8_CHUNK ? left : LPM_SHARD_TBL8_CHUNK;
+        s->tbl8_next = trie->tbl8_groups_used;
+        s->tbl8_end = s->tbl8_next + n;
+        trie->tbl8_groups_used += n;
+        pthread_mutex_unlock(&x->pool_lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&x->pool_lock);
+
+    /* Growing moves the arrays: stop every writer. Another shard may have
+     * grown them while this one waited, so check again. */
+    int rc = 0;
+    pthread_mutex_unlock(&s->lock);
+    lock_all(x);
+    if (trie->tbl8_groups_used == trie->tbl8_num_groups) {
+        rc = lpm_dir24_tbl8_grow(trie);
+    }
+    unlock_all(x);
+    pthread_mutex_lock(&s->lock);
+    return rc;
+}
+
+int32_t lpm_shard_tbl8_alloc(lpm_trie_t *trie, uint32_t idx)
+{
+    struct lpm_shards *x = trie->shards;
+    struct lpm_shard *s = &x->shard[idx >> (24 - x->bits)];
+
+    /* lpm_shard_update() reserved a group for any route longer than /24 */
+    if (s->tbl8_next == s->tbl8_end) { return -1; }
+    return (int32_t)s->tbl8_next++;
+}
+
+/* ============================================================================
+ * Rules
+ * ============================================================================ */
+
+struct lpm_rule_table *lpm_shard_rules(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    struct lpm_shards *x = trie->shards;
+    if (prefix_len < x->bits) { return trie->rules; }
+    return x->shard[prefix[0] >> (8 - x->bits)].rules;
+}
+
+struct lpm_rule *lpm_shard_find_parent(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    struct lpm_shards *x = trie->shards;
+    if (prefix_len > x->bits) {
+        struct lpm_rule *r = lpm_rules_find_parent(x->shard[prefix[0] >> (8 - x->bits)].rules,
+                                                   prefix, prefix_len);
+        if (r) { return r; }
+    }
+    return lpm_rules_find_parent(trie->rules, prefix, prefix_len);
+}
+
+int lpm_shard_of(const lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    const struct lpm_shards *x = trie->shards;
+    if (!x || prefix_len < x->bits) { return -1; }
+    return prefix[0] >> (8 - x->bits);
+}
+
+unsigned lpm_shard_count(const lpm_trie_t *trie)
+{
+    return trie->shards ? trie->shards->count : 0;
+}
+
+/* ============================================================================
+ * Updates
+ * ============================================================================ */
+
+static void rules_repoint(struct lpm_rule_table *rt, uint32_t old_nh, uint32_t new_nh)
+{
+    for (uint32_t i = 0; i < rt->capacity; i++) {
+        struct lpm_rule *r = &rt->slots[i];
+        if (r->used && r->next_hop == old_nh) {
+            r->next_hop = new_nh;
+        }
+    }
+}
+
+void lpm_shard_replace(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    static const uint8_t zero[16];
+    struct lpm_shards *x = trie->shards;
+
+    lock_all(x);
+    if (trie->has_default_route && trie->default_next_hop == old_nh) {
+        trie->default_next_hop = new_nh;
+    }
+    lpm_dir24_repoint(trie, zero, 0, old_nh, new_nh);
+    rules_repoint(trie->rules, old_nh, new_nh);
+    for (uint32_t i = 0; i < x->count; i++) {
+        rules_repoint(x->shard[i].rules, old_nh, new_nh);
+    }
+    unlock_all(x);
+}
+
+static int shard_apply(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t next_hop, bool del)
+{
+    lpm_dir24_op_t op;
+    int rc = lpm_dir24_op_begin(trie, prefix, prefix_len, next_hop, del, &op);
+    if (rc > 0) {
+        lpm_dir24_op_run(trie, &op, UINT32_MAX);
+        rc = 0;
+    }
+    return rc;
+}
+
+int lpm_shard_update(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                     uint32_t next_hop, bool del)
+{
+    struct lpm_shards *x = trie->shards;
+
+    /* Spans several shards: routes this short are rare, so stop everyone */
+    if (prefix_len < x->bits) {
+        lock_all(x);
+        int rc = shard_apply(trie, prefix, prefix_len, next_hop, del);
+        unlock_all(x);
+        return rc;
+    }
+
+    struct lpm_shard *s = &x->shard[prefix[0] >> (8 - x->bits)];
+    pthread_mutex_lock(&s->lock);
+    while (!del && prefix_len > 24 && s->tbl8_next == s->tbl8_end) {
+        if (tbl8_refill(trie, x, s) != 0) {
+            pthread_mutex_unlock(&s->lock);
+            return -1;
+        }
+    }
+    int rc = shard_apply(trie, prefix, prefix_len, next_hop, del);
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_enable_sharded_writers(lpm_trie_t *trie, unsigned shard_bits)
+{
+    if (!trie || shard_bits < 1 || shard_bits > LPM_SHARD_MAX_BITS) { return -1; }
+    if ((!trie->dir24_table && !trie->dir24c_table) || !trie->rules || trie->async) { return -1; }
+    if (trie->shards) { return trie->shards->bits == shard_bits ? 0 : -1; }
+
+    /* Features that need every route in one place stay single-writer */
+    if (trie->agg || trie->ttl || trie->nh_index || trie->journal) { return -1; }
+    lpm_update_flush(trie);
+
+    uint32_t count = 1U << shard_bits;
+    size_t bytes = sizeof(struct lpm_shards) + (size_t)count * sizeof(struct lpm_shard);
+    bytes = (bytes + LPM_CACHE_LINE_SIZE - 1) & ~(size_t)(LPM_CACHE_LINE_SIZE - 1);
+    struct lpm_shards *x = aligned_alloc(LPM_CACHE_LINE_SIZE, bytes);
+    if (!x) { return -1; }
+    memset(x, 0, bytes);
+    pthread_mutex_init(&x->pool_lock, NULL);
+    x->bits = shard_bits;
+    for (uint32_t i = 0; i < count; i++) {
+        pthread_mutex_init(&x->shard[i].lock, NULL);
+        x->count = i + 1;
+        x->shard[i].rules = lpm_rules_create();
+        if (!x->shard[i].rules) {
+            lpm_shards_destroy(x);
+            return -1;
+        }
+    }
+
+    /* Existing rules move to their shard; only shorter ones stay global */
+    struct lpm_rule_table *global = lpm_rules_create();
+    if (!global) {
+        lpm_shards_destroy(x);
+        return -1;
+    }
+    const struct lpm_rule_table *rt = trie->rules;
+    for (uint32_t i = 0; i < rt->capacity; i++) {
+        const struct lpm_rule *r = &rt->slots[i];
+        if (!r->used) { continue; }
+        struct lpm_rule_table *to = r->len < shard_bits ? global
+                                                        : x->shard[r->prefix[0] >> (8 - shard_bits)].rules;
+        if (lpm_rules_insert(to, r->prefix, r->len, r->next_hop, NULL) < 0) {
+            lpm_rules_destroy(global);
+            lpm_shards_destroy(x);
+            return -1;
+        }
+    }
+    lpm_rules_destroy(trie->rules);
+    trie->rules = global;
+    trie->shards = x;
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * SIMD Kernel Selection
+ *
+ * Each engine's batch lookup is bound to one kernel by an ifunc resolver when
+ * the library loads. The resolvers ask lpm_simd_detect() for the level to
+ * bind: the CPU's, capped by the LPM_SIMD environment variable so a slower
+ * variant can be forced without rebuilding. The explicit API below calls the
+ * same per-engine kernel selectors the resolvers use, at a level the caller
+ * picks, so benchmarks and differential tests can run every variant in one
+ * process.
+ *
+ * Resolvers can run while the dynamic linker is still relocating the
+ * library, before libc has set environ (always for local ifuncs, and for
+ * all of them under BIND_NOW). The variable is then read from
+ * /proc/self/environ.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+extern char **environ;
+
+static const char *const level_names[LPM_SIMD_LEVELS] = {
+    "scalar", "sse2", "sse42", "avx", "avx2", "avx512"
+};
+
+static const simd_level_t dynemit_levels[LPM_SIMD_LEVELS] = {
+    SIMD_SCALAR, SIMD_SSE2, SIMD_SSE4_2, SIMD_AVX, SIMD_AVX2, SIMD_AVX512F
+};
+
+/* Levels the resolvers do not know bind the scalar kernels */
+static lpm_simd_level_t from_dynemit(simd_level_t level)
+{
+    for (int l = LPM_SIMD_LEVELS - 1; l > 0; l--) {
+        if (dynemit_levels[l] == level) {
+            return (lpm_simd_level_t)l;
+        }
+    }
+    return LPM_SIMD_SCALAR;
+}
+
+/* ============================================================================
+ * LPM_SIMD Override
+ * ============================================================================ */
+
+/* Cap from LPM_SIMD; -1 until read, LPM_SIMD_LEVELS when there is none */
+static int simd_cap = -1;
+
+static const char simd_env_key[] = "LPM_SIMD=";
+
+/* ASCII only: strcasecmp() reads the locale, which is not set up yet */
+static bool level_name_equal(const char *value, const char *name)
+{
+    for (; *name; value++, name++) {
+        char c = *value >= 'A' && *value <= 'Z' ? (char)(*value - 'A' + 'a') : *value;
+        if (c != *name) {
+            return false;
+        }
+    }
+    return *value == '\0';
+}
+
+static const char *env_value(const char *entry)
+{
+    for (const char *k = simd_env_key; *k; k++, entry++) {
+        if (*entry != *k) {
+            return NULL;
+        }
+    }
+    return entry;
+}
+
+static int parse_simd_cap(const char *value)
+{
+    for (int l = 0; l < LPM_SIMD_LEVELS; l++) {
+        if (level_name_equal(value, level_names[l])) {
+            return l;
+        }
+    }
+    return LPM_SIMD_LEVELS;
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+static long raw_syscall3(long nr, long a, long b, long c)
+{
+    long ret;
+    __asm__ volatile ("syscall" : "=a"(ret) : "a"(nr), "D"(a), "S"(b), "d"(c) : "rcx", "r11", "memory");
+    return ret;
+}
+
+/* Value of LPM_SIMD from the initial environment, truncated to size - 1 */
+static bool proc_environ_value(char *value, size_t size)
+{
+    char buf[512];
+    size_t matched = 0, len = 0;
+    bool at_start = true, in_value = false;
+    long n;
+
+    long fd = raw_syscall3(SYS_openat, AT_FDCWD, (long)"/proc/self/environ", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    while ((n = raw_syscall3(SYS_read, fd, (long)buf, sizeof(buf))) > 0) {
+        for (long i = 0; i < n; i++) {
+            char c = buf[i];
+            if (in_value) {
+                if (c == '\0') {
+                    goto done;
+                }
+                if (len + 1 < size) {
+                    value[len++] = c;
+                }
+            } else if (c == '\0') {
+                matched = 0;
+                at_start = true;
+            } else if (at_start && c == simd_env_key[matched]) {
+                in_value = ++matched == sizeof(simd_env_key) - 1;
+            } else {
+                at_start = false;
+            }
+        }
+    }
+done:
+    raw_syscall3(SYS_close, fd, 0, 0);
+    value[len] = '\0';
+    return in_value;
+}
+#else
+static bool proc_environ_value(char *value, size_t size)
+{
+    (void)value;
+    (void)size;
+    return false;
+}
+#endif
+
+/* Nothing here may call through the PLT: under BIND_NOW the resolvers run
+ * before it is bound. Without environ yet, read /proc with raw syscalls */
+static int read_simd_cap(void)
+{
+    char buf[16];
+
+    if (environ) {
+        for (char **e = environ; *e; e++) {
+            const char *value = env_value(*e);
+            if (value) {
+                return parse_simd_cap(value);
+            }
+        }
+        return LPM_SIMD_LEVELS;
+    }
+    if (proc_environ_value(buf, sizeof(buf))) {
+        return parse_simd_cap(buf);
+    }
+    return LPM_SIMD_LEVELS;
+}
+
+simd_level_t lpm_simd_detect(void)
+{
+    simd_level_t cpu = LPM_DETECT_SIMD_CPU();
+    int cap = __atomic_load_n(&simd_cap, __ATOMIC_ACQUIRE);
+
+    if (cap < 0) {
+        cap = read_simd_cap();
+        __atomic_store_n(&simd_cap, cap, __ATOMIC_RELEASE);
+    }
+    if (cap < (int)from_dynemit(cpu)) {
+        return dynemit_levels[cap];
+    }
+    return cpu;
+}
+
+/* ============================================================================
+ * Levels
+ * ============================================================================ */
+
+lpm_simd_level_t lpm_simd_cpu_level(void)
+{
+    return from_dynemit(LPM_DETECT_SIMD_CPU());
+}
+
+lpm_simd_level_t lpm_simd_active_level(void)
+{
+    return from_dynemit(lpm_simd_detect());
+}
+
+const char *lpm_simd_level_name(lpm_simd_level_t level)
+{
+    if ((unsigned)level >= LPM_SIMD_LEVELS) {
+        return NULL;
+    }
+    return level_names[level];
+}
+
+/* ============================================================================
+ * Explicit Kernel Selection
+ * ============================================================================ */
+
+enum batch_engine {
+    BATCH_NONE,         /* set or adaptive trie: no fixed kernel */
+    BATCH_DIR24,
+    BATCH_DIR24C,
+    BATCH_SMALL,
+    BATCH_LCTRIE,
+    BATCH_4STRIDE8,
+    BATCH_WIDE16,
+    BATCH_6STRIDE8
+};
+
+/* Same order as lpm_lookup_batch_ipv4() and lpm_lookup_batch_ipv6() */
+static enum batch_engine batch_engine(const lpm_trie_t *trie)
+{
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH) {
+        if (trie->use_ipv4_dir24 && trie->dir24_table) { return BATCH_DIR24; }
+        if (trie->dir24c_table) { return BATCH_DIR24C; }
+        if (trie->small) { return BATCH_SMALL; }
+        if (trie->lctrie) { return BATCH_LCTRIE; }
+        if (trie->set || trie->adapt) { return BATCH_NONE; }
+        return BATCH_4STRIDE8;
+    }
+    if (trie->use_ipv6_wide_stride && trie->wide_nodes_pool) { return BATCH_WIDE16; }
+    if (trie->set || trie->adapt) { return BATCH_NONE; }
+    return BATCH_6STRIDE8;
+}
+
+/* A kernel of the engine's type; every member is NULL for BATCH_NONE */
+union batch_kernel {
+    lpm_batch_ipv4_kernel_t ipv4;
+    lpm_ipv4_8stride_batch_func_t stride4;
+    lpm_wide16_batch_func_t wide16;
+    lpm_ipv6_8stride_batch_func_t stride6;
+};
+
+static union batch_kernel batch_kernel(enum batch_engine engine, lpm_simd_level_t level)
+{
+    simd_level_t l = dynemit_levels[level];
+    union batch_kernel k = { .ipv4 = NULL };
+
+    switch (engine) {
+    case BATCH_DIR24:    k.ipv4 = lpm_dir24_batch_kernel(l); break;
+    case BATCH_DIR24C:   k.ipv4 = lpm_dir24_compact_batch_kernel(l); break;
+    case BATCH_SMALL:    k.ipv4 = lpm_small_batch_kernel(l); break;
+    case BATCH_LCTRIE:   k.ipv4 = lpm_lookup_batch_ipv4_lctrie; break;
+    case BATCH_4STRIDE8: k.stride4 = lpm_ipv4_8stride_batch_kernel(l); break;
+    case BATCH_WIDE16:   k.wide16 = lpm_wide16_batch_kernel(l); break;
+    case BATCH_6STRIDE8: k.stride6 = lpm_ipv6_8stride_batch_kernel(l); break;
+    case BATCH_NONE:
+    default:
+        break;
+    }
+    return k;
+}
+
+/* Compare through the member the engine set */
+static bool batch_kernel_equal(enum batch_engine engine, union batch_kernel a, union batch_kernel b)
+{
+    switch (engine) {
+    case BATCH_4STRIDE8: return a.stride4 == b.stride4;
+    case BATCH_WIDE16:   return a.wide16 == b.wide16;
+    case BATCH_6STRIDE8: return a.stride6 == b.stride6;
+    default:             return a.ipv4 == b.ipv4;
+    }
+}
+
+int lpm_simd_kernel_level(const lpm_trie_t *trie, lpm_simd_level_t level)
+{
+    if (!trie || (unsigned)level >= LPM_SIMD_LEVELS) {
+        return -1;
+    }
+    enum batch_engine engine = batch_engine(trie);
+    if (engine == BATCH_NONE) {
+        return -1;
+    }
+    union batch_kernel kernel = batch_kernel(engine, level);
+    int l = LPM_SIMD_SCALAR;
+    while (!batch_kernel_equal(engine, batch_kernel(engine, (lpm_simd_level_t)l), kernel)) {
+        l++;
+    }
+    return l;
+}
+
+/* Kernel for a lookup at level; *engine is BATCH_NONE if none can run here */
+static union batch_kernel checked_kernel(const lpm_trie_t *trie, lpm_simd_level_t level,
+                                         enum batch_engine *engine)
+{
+    if ((unsigned)level >= LPM_SIMD_LEVELS || level > lpm_simd_cpu_level()) {
+        *engine = BATCH_NONE;
+        return (union batch_kernel){ .ipv4 = NULL };
+    }
+    *engine = batch_engine(trie);
+    return batch_kernel(*engine, level);
+}
+
+int lpm_lookup_batch_ipv4_simd(const lpm_trie_t *trie, lpm_simd_level_t level,
+                               const uint32_t *addrs, uint32_t *next_hops, size_t count)
+{
+    enum batch_engine engine;
+
+    if (!trie || !addrs || !next_hops || trie->max_depth != LPM_IPV4_MAX_DEPTH) {
+        return -1;
+    }
+    union batch_kernel kernel = checked_kernel(trie, level, &engine);
+    if (engine == BATCH_NONE) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (engine == BATCH_4STRIDE8) {
+        lpm_lookup_batch_ipv4_8stride_with(kernel.stride4, trie, addrs, next_hops, count);
+    } else {
+        kernel.ipv4(trie, addrs, next_hops, count);
+    }
+    return 0;
+}
+
+int lpm_lookup_batch_ipv6_simd(const lpm_trie_t *trie, lpm_simd_level_t level,
+                               const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count)
+{
+    enum batch_engine engine;
+
+    if (!trie || !addrs || !next_hops || trie->max_depth != LPM_IPV6_MAX_DEPTH) {
+        return -1;
+    }
+    union batch_kernel kernel = checked_kernel(trie, level, &engine);
+    if (engine == BATCH_NONE) {
+        return -1;
+    }
+    if (engine == BATCH_WIDE16) {
+        lpm_lookup_batch_ipv6_wide16_with(kernel.wide16, trie, addrs, next_hops, count);
+    } else {
+        lpm_lookup_batch_ipv6_8stride_with(kernel.stride6, trie, addrs, next_hops, count);
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * IPv4 Small-Table Engine - Core Functions
+ * Create, Add, Delete for tables of up to LPM_SMALL_MAX_PREFIXES prefixes
+ *
+ * DIR-24-8 spends 64MB (32MB compact) on its first level whatever the table
+ * size, and the stride engines allocate their node pool up front. A table of a
+ * few hundred prefixes fits in a few KB instead: the prefixes are flattened
+ * into disjoint address ranges and the range starts searched as an implicit
+ * Eytzinger tree (see include/algo/small.h).
+ *
+ * Prefixes are kept sorted by (prefix, length); every update rewrites the
+ * sorted array in place and rebuilds the search tree in fresh arrays, which
+ * are swapped in only once complete. That is O(n) per update, cheap at this
+ * size and the reason for the cap.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+#define LPM_SMALL_INITIAL_RULES 16
+
+/* Address range [start, next range's start) and the next hop covering it */
+struct small_range {
+    uint32_t start;
+    uint32_t next_hop;
+};
+
+/* ============================================================================
+ * Search Tree Build
+ * ============================================================================ */
+
+/* Append a range; a range starting at the same address is superseded, and a
+ * range with the previous next hop extends it. */
+static void range_emit(struct small_range *r, uint32_t *n, uint32_t start, uint32_t next_hop)
+{
+    if (*n && r[*n - 1].start == start) {
+        (*n)--;
+    }
+    if (*n && r[*n - 1].next_hop == next_hop) {
+        return;
+    }
+    r[*n].start = start;
+    r[*n].next_hop = next_hop;
+    (*n)++;
+}
+
+/* Sweep the sorted prefixes with a stack of the ones still open */
+static uint32_t ranges_build(const struct lpm_small *s, struct small_range *r)
+{
+    struct { uint64_t end; uint32_t next_hop; } open[LPM_IPV4_MAX_DEPTH + 1];
+    uint32_t depth = 0, n = 0;
+
+    range_emit(r, &n, 0, LPM_INVALID_NEXT_HOP);
+    for (uint32_t i = 0; i < s->rule_count; i++) {
+        const struct lpm_small_rule *p = &s->rules[i];
+        uint64_t end = (uint64_t)p->prefix + (1ULL << (32 - p->len)) - 1;
+
+        /* Close the prefixes that end before this one starts */
+        while (depth && open[depth - 1].end < p->prefix) {
+            uint64_t resume = open[--depth].end + 1;
+            range_emit(r, &n, (uint32_t)resume,
+                       depth ? open[depth - 1].next_hop : LPM_INVALID_NEXT_HOP);
+        }
+        range_emit(r, &n, p->prefix, p->next_hop);
+        open[depth].end = end;
+        open[depth].next_hop = p->next_hop;
+        depth++;
+    }
+    while (depth) {
+        uint64_t resume = open[--depth].end + 1;
+        if (resume > UINT32_MAX) {
+            break;   /* Everything still open runs to the end of the space */
+        }
+        range_emit(r, &n, (uint32_t)resume,
+                   depth ? open[depth - 1].next_hop : LPM_INVALID_NEXT_HOP);
+    }
+    return n;
+}
+
+/* In-order walk of the implicit tree: sorted key i lands at node k */
+static void tree_fill(int32_t *keys, uint32_t *vals, uint32_t size, uint32_t k,
+                      const struct small_range *r, uint32_t n, uint32_t *i)
+{
+    if (k >= size) { return; }
+    tree_fill(keys, vals, size, 2 * k, r, n, i);
+    if (*i + 1 < n) {
+        keys[k] = (int32_t)(r[*i + 1].start ^ 0x80000000U);
+        vals[k] = r[*i].next_hop;
+    } else {
+        keys[k] = INT32_MAX;   /* Padding: past every real key */
+        vals[k] = r[n - 1].next_hop;
+    }
+    (*i)++;
+    tree_fill(keys, vals, size, 2 * k + 1, r, n, i);
+}
+
+static int small_rebuild(struct lpm_small *s)
+{
+    struct small_range *r = malloc(((size_t)s->rule_count * 2 + 1) * sizeof(*r));
+    if (!r) { return -1; }
+    uint32_t n = ranges_build(s, r);
+
+    /* n ranges give n - 1 keys; round up to a complete tree */
+    uint32_t height = 0;
+    while ((1U << height) - 1 < n - 1) {
+        height++;
+    }
+    uint32_t size = 1U << height;
+    int32_t *keys = aligned_alloc(LPM_CACHE_LINE_SIZE, (size * sizeof(int32_t) + 63) & ~(size_t)63);
+    uint32_t *vals = aligned_alloc(LPM_CACHE_LINE_SIZE, (size * sizeof(uint32_t) + 63) & ~(size_t)63);
+    if (!keys || !vals) {
+        free(keys);
+        free(vals);
+        free(r);
+        return -1;
+    }
+
+    uint32_t i = 0;
+    keys[0] = INT32_MAX;
+    vals[0] = r[n - 1].next_hop;
+    tree_fill(keys, vals, size, 1, r, n, &i);
+    free(r);
+
+    int32_t *old_keys = s->keys;
+    uint32_t *old_vals = s->vals;
+    s->keys = keys;
+    s->vals = vals;
+    s->height = height;
+    free(old_keys);
+    free(old_vals);
+    return 0;
+}
+
+/* ============================================================================
+ * Creation / Destruction
+ * ============================================================================ */
+
+lpm_trie_t *lpm_create_ipv4_small(void)
+{
+    lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
+    if (!t) { return NULL; }
+    memset(t, 0, sizeof(lpm_trie_t));
+
+    t->max_depth = LPM_IPV4_MAX_DEPTH;
+    t->default_next_hop = LPM_INVALID_NEXT_HOP;
+    t->small = calloc(1, sizeof(struct lpm_small));
+    if (!t->small) {
+        lpm_destroy(t);
+        return NULL;
+    }
+
+    struct lpm_small *s = t->small;
+    s->rule_capacity = LPM_SMALL_INITIAL_RULES;
+    s->rules = malloc(s->rule_capacity * sizeof(struct lpm_small_rule));
+    if (!s->rules || small_rebuild(s) != 0) {
+        lpm_destroy(t);
+        return NULL;
+    }
+    lpm_dispatch_init(t);
+    return t;
+}
+
+void lpm_small_destroy(struct lpm_small *s)
+{
+    if (!s) { return; }
+    free(s->rules);
+    free(s->keys);
+    free(s->vals);
+    free(s);
+}
+
+size_t lpm_small_memory(const lpm_trie_t *trie)
+{
+    const struct lpm_small *s = trie->small;
+    if (!s) { return 0; }
+    return (size_t)s->rule_capacity * sizeof(struct lpm_small_rule) +
+           ((size_t)1 << s->height) * (sizeof(int32_t) + sizeof(uint32_t));
+}
+
+/* ============================================================================
+ * Add / Delete
+ * ============================================================================ */
+
+static uint32_t small_prefix(const uint8_t *prefix, uint8_t prefix_len)
+{
+    uint32_t p = ((uint32_t)prefix[0] << 24) | ((uint32_t)prefix[1] << 16) |
+                 ((uint32_t)prefix[2] << 8) | prefix[3];
+    return prefix_len ? p & (0xFFFFFFFFU << (32 - prefix_len)) : 0;
+}
+
+/* Position of (prefix, len) in the sorted rules, or where it would go */
+static uint32_t rule_search(const struct lpm_small *s, uint32_t prefix, uint8_t len, bool *found)
+{
+    uint32_t lo = 0, hi = s->rule_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const struct lpm_small_rule *r = &s->rules[mid];
+        if (r->prefix < prefix || (r->prefix == prefix && r->len < len)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *found = lo < s->rule_count && s->rules[lo].prefix == prefix && s->rules[lo].len == len;
+    return lo;
+}
+
+static void small_set_default(lpm_trie_t *trie, uint8_t prefix_len, bool del, uint32_t next_hop)
+{
+    if (prefix_len == 0) {
+        trie->has_default_route = !del;
+        trie->default_next_hop = del ? LPM_INVALID_NEXT_HOP : next_hop;
+    }
+}
+
+static int add_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    if (!trie || !trie->small || !prefix || prefix_len > LPM_IPV4_MAX_DEPTH ||
+        next_hop == LPM_INVALID_NEXT_HOP) {
+        return -1;
+    }
+    struct lpm_small *s = trie->small;
+    uint32_t p = small_prefix(prefix, prefix_len);
+    bool found;
+    uint32_t pos = rule_search(s, p, prefix_len, &found);
+
+    if (found) {
+        uint32_t old = s->rules[pos].next_hop;
+        if (old == next_hop) { return 0; }
+        s->rules[pos].next_hop = next_hop;
+        if (small_rebuild(s) != 0) {
+            s->rules[pos].next_hop = old;
+            return -1;
+        }
+        small_set_default(trie, prefix_len, false, next_hop);
+        return 0;
+    }
+
+    if (s->rule_count >= LPM_SMALL_MAX_PREFIXES) { return -1; }
+    if (s->rule_count == s->rule_capacity) {
+        uint32_t cap = s->rule_capacity * 2;
+        struct lpm_small_rule *rules = realloc(s->rules, cap * sizeof(*rules));
+        if (!rules) { return -1; }
+        s->rules = rules;
+        s->rule_capacity = cap;
+    }
+    memmove(&s->rules[pos + 1], &s->rules[pos], (s->rule_count - pos) * sizeof(*s->rules));
+    s->rules[pos] = (struct lpm_small_rule){ .prefix = p, .next_hop = next_hop, .len = prefix_len };
+    s->rule_count++;
+    if (small_rebuild(s) != 0) {
+        s->rule_count--;
+        memmove(&s->rules[pos], &s->rules[pos + 1], (s->rule_count - pos) * sizeof(*s->rules));
+        return -1;
+    }
+    small_set_default(trie, prefix_len, false, next_hop);
+    trie->num_prefixes++;
+    return 0;
+}
+
+int lpm_add_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    int rc = add_ipv4_small(trie, prefix, prefix_len, next_hop);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
+
+static int delete_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (!trie || !trie->small || !prefix || prefix_len > LPM_IPV4_MAX_DEPTH) {
+        return -1;
+    }
+    struct lpm_small *s = trie->small;
+    bool found;
+    uint32_t pos = rule_search(s, small_prefix(prefix, prefix_len), prefix_len, &found);
+    if (!found) { return -1; }
+
+    struct lpm_small_rule gone = s->rules[pos];
+    s->rule_count--;
+    memmove(&s->rules[pos], &s->rules[pos + 1], (s->rule_count - pos) * sizeof(*s->rules));
+    if (small_rebuild(s) != 0) {
+        memmove(&s->rules[pos + 1], &s->rules[pos], (s->rule_count - pos) * sizeof(*s->rules));
+        s->rules[pos] = gone;
+        s->rule_count++;
+        return -1;
+    }
+    small_set_default(trie, prefix_len, true, 0);
+    trie->num_prefixes--;
+    return 0;
+}
+
+int lpm_delete_ipv4_small(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    int rc = delete_ipv4_small(trie, prefix, prefix_len);
+    if (trie) {
+        lpm_generation_bump(trie);
+    }
+    return rc;
+}
+
+int lpm_small_repoint(lpm_trie_t *trie, uint32_t old_nh, uint32_t new_nh)
+{
+    struct lpm_small *s = trie->small;
+    bool changed = false;
+    for (uint32_t i = 0; i < s->rule_count; i++) {
+        if (s->rules[i].next_hop == old_nh) {
+            s->rules[i].next_hop = new_nh;
+            changed = true;
+        }
+    }
+    return changed ? small_rebuild(s) : 0;
+}
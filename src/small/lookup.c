@@ -0,0 +1,177 @@
+/*
+ * IPv4 Small-Table Engine - Lookups
+ *
+ * Every lookup walks exactly height levels of the implicit tree, so a batch
+ * needs no per-lane control flow: the SIMD kernels run the search vertically,
+ * one lane per address, with a gather per level, a signed compare and two
+ * blends. Two vectors are kept in flight to overlap the gather latency. The
+ * top levels of the tree are shared by every lane and stay in L1.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef LPM_X86_ARCH
+#include <immintrin.h>
+#endif
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+/* ============================================================================
+ * Single Lookup
+ * ============================================================================ */
+
+uint32_t lpm_lookup_ipv4_small(const lpm_trie_t *trie, uint32_t addr)
+{
+    if (!trie || !trie->small) {
+        return LPM_INVALID_NEXT_HOP;
+    }
+    return lpm_small_lookup_inline(trie->small, addr);
+}
+
+/* ============================================================================
+ * Scalar Batch Implementation - 4 independent searches interleaved
+ * ============================================================================ */
+
+__attribute__((hot))
+void lpm_lookup_batch_ipv4_small_scalar(const lpm_trie_t *trie, const uint32_t *addrs,
+                                        uint32_t *next_hops, size_t count)
+{
+    const struct lpm_small *s = trie->small;
+    const int32_t * restrict keys = s->keys;
+    const uint32_t * restrict vals = s->vals;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        int32_t x[4];
+        uint32_t k[4] = { 1, 1, 1, 1 }, res[4] = { 0, 0, 0, 0 };
+        for (int j = 0; j < 4; j++) {
+            x[j] = (int32_t)(addrs[i + j] ^ 0x80000000U);
+        }
+        for (uint32_t h = s->height; h; h--) {
+            for (int j = 0; j < 4; j++) {
+                bool gt = keys[k[j]] > x[j];
+                res[j] = gt ? k[j] : res[j];
+                k[j] = 2 * k[j] + !gt;
+            }
+        }
+        for (int j = 0; j < 4; j++) {
+            next_hops[i + j] = vals[res[j]];
+        }
+    }
+    for (; i < count; i++) {
+        next_hops[i] = lpm_small_lookup_inline(s, addrs[i]);
+    }
+}
+
+/* ============================================================================
+ * AVX2 Batch - 2 x 8 lookups per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("avx2")))
+void lpm_lookup_batch_ipv4_small_avx2(const lpm_trie_t *trie, const uint32_t *addrs,
+                                      uint32_t *next_hops, size_t count)
+{
+    const struct lpm_small *s = trie->small;
+    const int *keys = (const int *)s->keys;
+    const int *vals = (const int *)s->vals;
+    const __m256i bias = _mm256_set1_epi32((int)0x80000000U);
+    const __m256i ones = _mm256_set1_epi32(1);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i xa = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&addrs[i]), bias);
+        __m256i xb = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&addrs[i + 8]), bias);
+        __m256i ka = ones, kb = ones;
+        __m256i ra = _mm256_setzero_si256(), rb = _mm256_setzero_si256();
+
+        for (uint32_t h = s->height; h; h--) {
+            __m256i gta = _mm256_cmpgt_epi32(_mm256_i32gather_epi32(keys, ka, 4), xa);
+            __m256i gtb = _mm256_cmpgt_epi32(_mm256_i32gather_epi32(keys, kb, 4), xb);
+            /* res = k where key > x; k = 2k + (key <= x) */
+            ra = _mm256_blendv_epi8(ra, ka, gta);
+            rb = _mm256_blendv_epi8(rb, kb, gtb);
+            ka = _mm256_add_epi32(_mm256_add_epi32(ka, ka), _mm256_andnot_si256(gta, ones));
+            kb = _mm256_add_epi32(_mm256_add_epi32(kb, kb), _mm256_andnot_si256(gtb, ones));
+        }
+
+        _mm256_storeu_si256((__m256i *)&next_hops[i], _mm256_i32gather_epi32(vals, ra, 4));
+        _mm256_storeu_si256((__m256i *)&next_hops[i + 8], _mm256_i32gather_epi32(vals, rb, 4));
+    }
+
+    if (i < count) {
+        lpm_lookup_batch_ipv4_small_scalar(trie, &addrs[i], &next_hops[i], count - i);
+    }
+}
+
+/* ============================================================================
+ * AVX512 Batch - 2 x 16 lookups per iteration
+ * ============================================================================ */
+
+__attribute__((hot, target("avx512f")))
+void lpm_lookup_batch_ipv4_small_avx512(const lpm_trie_t *trie, const uint32_t *addrs,
+                                        uint32_t *next_hops, size_t count)
+{
+    const struct lpm_small *s = trie->small;
+    const int32_t *keys = s->keys;
+    const uint32_t *vals = s->vals;
+    const __m512i bias = _mm512_set1_epi32((int)0x80000000U);
+    const __m512i ones = _mm512_set1_epi32(1);
+    size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m512i xa = _mm512_xor_si512(_mm512_loadu_si512(&addrs[i]), bias);
+        __m512i xb = _mm512_xor_si512(_mm512_loadu_si512(&addrs[i + 16]), bias);
+        __m512i ka = ones, kb = ones;
+        __m512i ra = _mm512_setzero_si512(), rb = _mm512_setzero_si512();
+
+        for (uint32_t h = s->height; h; h--) {
+            __mmask16 gta = _mm512_cmpgt_epi32_mask(_mm512_i32gather_epi32(ka, keys, 4), xa);
+            __mmask16 gtb = _mm512_cmpgt_epi32_mask(_mm512_i32gather_epi32(kb, keys, 4), xb);
+            ra = _mm512_mask_mov_epi32(ra, gta, ka);
+            rb = _mm512_mask_mov_epi32(rb, gtb, kb);
+            ka = _mm512_add_epi32(ka, ka);
+            kb = _mm512_add_epi32(kb, kb);
+            ka = _mm512_mask_add_epi32(ka, (__mmask16)~gta, ka, ones);
+            kb = _mm512_mask_add_epi32(kb, (__mmask16)~gtb, kb, ones);
+        }
+
+        _mm512_storeu_si512(&next_hops[i], _mm512_i32gather_epi32(ra, vals, 4));
+        _mm512_storeu_si512(&next_hops[i + 16], _mm512_i32gather_epi32(rb, vals, 4));
+    }
+
+    /* Handle remaining with AVX2 */
+    if (i < count) {
+        lpm_lookup_batch_ipv4_small_avx2(trie, &addrs[i], &next_hops[i], count - i);
+    }
+}
+
+/* ============================================================================
+ * ifunc Resolver
+ * ============================================================================ */
+
+/* Kernel for a SIMD level; also used by the explicit selection API */
+lpm_batch_ipv4_kernel_t lpm_small_batch_kernel(simd_level_t level)
+{
+    switch (level) {
+    case SIMD_AVX512F:
+        return lpm_lookup_batch_ipv4_small_avx512;
+    case SIMD_AVX2:
+        return lpm_lookup_batch_ipv4_small_avx2;
+    case SIMD_AVX:
+    case SIMD_SSE4_2:
+    case SIMD_SSE2:
+    case SIMD_SCALAR:
+    default:
+        return lpm_lookup_batch_ipv4_small_scalar;
+    }
+}
+
+EXPLICIT_RUNTIME_RESOLVER(lpm_small_batch_resolver)
+{
+    return (void*)lpm_small_batch_kernel(LPM_DETECT_SIMD());
+}
+
+void lpm_lookup_batch_ipv4_small(const lpm_trie_t *trie, const uint32_t *addrs,
+                                 uint32_t *next_hops, size_t count)
+    __attribute__((ifunc("lpm_small_batch_resolver")));
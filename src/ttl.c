@@ -0,0 +1,326 @@
+/*
+ * liblpm Expiring Prefixes
+ *
+ * lpm_add_ttl() installs a prefix together with an expiry time and
+ * lpm_expire(now) removes every prefix that is due. Timers live in a
+ * hierarchical timing wheel beside the lookup tables: four levels of 256
+ * slots cover 2^32 ticks, later expiries wait on an overflow list. A timer
+ * sits on the level of the highest byte in which its expiry differs from
+ * the wheel's current time; when that byte of the current time reaches the
+ * timer's slot, the slot is cascaded into the levels below. Advancing jumps
+ * straight to the next occupied slot, so a call costs O(levels) plus the
+ * timers it touches, however far the clock moves.
+ *
+ * Lookups never see any of this; the wheel is reached only from the update
+ * path. Times are in whatever monotonic unit the caller uses (seconds,
+ * milliseconds, ...), one tick per unit.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_TTL_LEVELS     4
+#define LPM_TTL_SLOTS      256
+#define LPM_TTL_OVERFLOW   (LPM_TTL_LEVELS * LPM_TTL_SLOTS)      /* List ids */
+#define LPM_TTL_DUE        (LPM_TTL_OVERFLOW + 1)
+#define LPM_TTL_NUM_LISTS  (LPM_TTL_DUE + 1)
+
+struct lpm_ttl_timer {
+    uint64_t expires;
+    uint32_t next;            /* 0 terminates (timer 0 is never used) */
+    uint32_t prev;
+    uint16_t list;            /* Wheel slot, overflow or due list */
+    uint8_t len;
+    uint8_t prefix[16];
+};
+
+struct lpm_ttl {
+    struct lpm_ttl_timer *timers;
+    uint32_t capacity;
+    uint32_t used;            /* High-water mark */
+    uint32_t free_head;
+    uint32_t count;           /* Live timers */
+    uint64_t now;             /* Wheel time: every timer expiring <= now is due */
+    uint32_t head[LPM_TTL_NUM_LISTS];
+    uint64_t occupied[LPM_TTL_LEVELS][LPM_TTL_SLOTS / 64];
+    struct lpm_rule_table *index;  /* (prefix, len) -> timer, in next_hop */
+};
+
+/* ============================================================================
+ * Timer Lists
+ * ============================================================================ */
+
+static void timer_link(struct lpm_ttl *w, uint32_t t, uint16_t list)
+{
+    struct lpm_ttl_timer *tm = &w->timers[t];
+    tm->list = list;
+    tm->prev = 0;
+    tm->next = w->head[list];
+    if (tm->next) {
+        w->timers[tm->next].prev = t;
+    }
+    w->head[list] = t;
+    if (list < LPM_TTL_OVERFLOW) {
+        w->occupied[list / LPM_TTL_SLOTS][(list % LPM_TTL_SLOTS) / 64] |= 1ULL << (list % 64);
+    }
+}
+
+static void timer_unlink(struct lpm_ttl *w, uint32_t t)
+{
+    struct lpm_ttl_timer *tm = &w->timers[t];
+    if (tm->prev) {
+        w->timers[tm->prev].next = tm->next;
+    } else {
+        w->head[tm->list] = tm->next;
+    }
+    if (tm->next) {
+        w->timers[tm->next].prev = tm->prev;
+    }
+    if (tm->list < LPM_TTL_OVERFLOW && !w->head[tm->list]) {
+        w->occupied[tm->list / LPM_TTL_SLOTS][(tm->list % LPM_TTL_SLOTS) / 64] &= ~(1ULL << (tm->list % 64));
+    }
+}
+
+/* Place a timer by the highest byte in which its expiry differs from now */
+static void timer_place(struct lpm_ttl *w, uint32_t t)
+{
+    uint64_t e = w->timers[t].expires;
+    if (e <= w->now) {
+        timer_link(w, t, LPM_TTL_DUE);
+        return;
+    }
+
+    uint64_t diff = e ^ w->now;
+    for (unsigned l = 0; l < LPM_TTL_LEVELS; l++) {
+        if (diff < (1ULL << (8 * (l + 1)))) {
+            timer_link(w, t, (uint16_t)(l * LPM_TTL_SLOTS + ((e >> (8 * l)) & 0xFF)));
+            return;
+        }
+    }
+    timer_link(w, t, LPM_TTL_OVERFLOW);
+}
+
+static uint32_t timer_alloc(struct lpm_ttl *w)
+{
+    if (w->free_head) {
+        uint32_t t = w->free_head;
+        w->free_head = w->timers[t].next;
+        return t;
+    }
+    if (w->used == w->capacity) {
+        uint32_t cap = w->capacity * 2;
+        struct lpm_ttl_timer *timers = realloc(w->timers, (size_t)cap * sizeof(*timers));
+        if (!timers) { return 0; }
+        w->timers = timers;
+        w->capacity = cap;
+    }
+    return w->used++;
+}
+
+static void timer_free(struct lpm_ttl *w, uint32_t t)
+{
+    w->timers[t].next = w->free_head;
+    w->free_head = t;
+}
+
+/* ============================================================================
+ * Advancing the Wheel
+ * ============================================================================ */
+
+static int first_occupied(const uint64_t occ[LPM_TTL_SLOTS / 64])
+{
+    for (int i = 0; i < LPM_TTL_SLOTS / 64; i++) {
+        if (occ[i]) {
+            return i * 64 + __builtin_ctzll(occ[i]);
+        }
+    }
+    return -1;
+}
+
+/* Move a whole list onto the due list or re-place its timers */
+static void list_cascade(struct lpm_ttl *w, uint16_t list)
+{
+    uint32_t t = w->head[list];
+    w->head[list] = 0;
+    if (list < LPM_TTL_OVERFLOW) {
+        w->occupied[list / LPM_TTL_SLOTS][(list % LPM_TTL_SLOTS) / 64] &= ~(1ULL << (list % 64));
+    }
+    while (t) {
+        uint32_t next = w->timers[t].next;
+        timer_place(w, t);
+        t = next;
+    }
+}
+
+static void wheel_advance(struct lpm_ttl *w, uint64_t target)
+{
+    while (w->now < target) {
+        /* Timers on level l share every byte above l with now, so the lowest
+         * occupied level holds the next event; it fires (l = 0) or cascades
+         * (l > 0) when that byte of now reaches the slot. */
+        int level = -1, slot = -1;
+        for (unsigned l = 0; l < LPM_TTL_LEVELS && slot < 0; l++) {
+            slot = first_occupied(w->occupied[l]);
+            level = (int)l;
+        }
+
+        uint64_t event;
+        if (slot >= 0) {
+            unsigned shift = 8 * (unsigned)level;
+            event = ((w->now >> (shift + 8)) << (shift + 8)) | ((uint64_t)slot << shift);
+        } else if (w->head[LPM_TTL_OVERFLOW]) {
+            /* Wheel empty: the next event is the 2^32 window of the earliest
+             * overflow timer */
+            uint64_t min = UINT64_MAX;
+            for (uint32_t t = w->head[LPM_TTL_OVERFLOW]; t; t = w->timers[t].next) {
+                min = w->timers[t].expires < min ? w->timers[t].expires : min;
+            }
+            event = min & ~0xFFFFFFFFULL;
+        } else {
+            w->now = target;
+            return;
+        }
+
+        if (event > target) {
+            w->now = target;
+            return;
+        }
+        w->now = event;
+        list_cascade(w, slot >= 0 ? (uint16_t)(level * LPM_TTL_SLOTS + slot) : LPM_TTL_OVERFLOW);
+    }
+}
+
+/* ============================================================================
+ * Internal API
+ * ============================================================================ */
+
+static struct lpm_ttl *ttl_get(lpm_trie_t *trie)
+{
+    if (trie->ttl) { return trie->ttl; }
+
+    struct lpm_ttl *w = calloc(1, sizeof(*w));
+    if (!w) { return NULL; }
+    w->capacity = 64;
+    w->used = 1;   /* Timer 0 is the list terminator */
+    w->timers = malloc((size_t)w->capacity * sizeof(*w->timers));
+    w->index = lpm_rules_create();
+    if (!w->timers || !w->index) {
+        lpm_ttl_destroy(w);
+        return NULL;
+    }
+    trie->ttl = w;
+    return w;
+}
+
+void lpm_ttl_cancel(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    struct lpm_ttl *w = trie->ttl;
+    if (!w) { return; }
+
+    const struct lpm_rule *r = lpm_rules_find(w->index, prefix, prefix_len);
+    if (!r) { return; }
+    uint32_t t = r->next_hop;
+    lpm_rules_remove(w->index, prefix, prefix_len);
+    timer_unlink(w, t);
+    timer_free(w, t);
+    w->count--;
+}
+
+void lpm_ttl_destroy(struct lpm_ttl *w)
+{
+    if (!w) { return; }
+    lpm_rules_destroy(w->index);
+    free(w->timers);
+    free(w);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int lpm_add_ttl(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                uint32_t next_hop, uint64_t expires_at)
+{
+    if (!trie || !prefix || prefix_len > trie->max_depth || trie->journal || trie->shards) {
+        return -1;
+    }
+
+    struct lpm_ttl *w = ttl_get(trie);
+    if (!w) { return -1; }
+
+    /* lpm_add() drops any previous timer for the prefix */
+    if (lpm_add(trie, prefix, prefix_len, next_hop) < 0) { return -1; }
+
+    uint32_t t = timer_alloc(w);
+    if (!t || lpm_rules_insert(w->index, prefix, prefix_len, t, NULL) < 0) {
+        if (t) { timer_free(w, t); }
+        return -1;
+    }
+
+    struct lpm_ttl_timer *tm = &w->timers[t];
+    tm->expires = expires_at;
+    tm->len = prefix_len;
+    memset(tm->prefix, 0, sizeof(tm->prefix));
+    memcpy(tm->prefix, prefix, (prefix_len + 7) / 8);
+    timer_place(w, t);
+    w->count++;
+    return 0;
+}
+
+size_t lpm_expire(lpm_trie_t *trie, uint64_t now)
+{
+    if (!trie || !trie->ttl) { return 0; }
+    struct lpm_ttl *w = trie->ttl;
+
+    wheel_advance(w, now);
+
+    /* DIR-24-8 queues the due deletes and applies them in one flush with a
+     * single generation bump; the rule store, current once earlier queued
+     * updates are applied, tells which of them are installed. Other engines
+     * delete one prefix at a time. */
+    const bool batch = lpm_update_deferred(trie) && trie->rules;
+    if (batch && lpm_update_pending(trie)) {
+        lpm_update_flush(trie);
+    }
+
+    /* Everything due is collected first and removed in one pass */
+    size_t removed = 0;
+    uint32_t t = w->head[LPM_TTL_DUE];
+    w->head[LPM_TTL_DUE] = 0;
+    while (t) {
+        struct lpm_ttl_timer *tm = &w->timers[t];
+        uint32_t next = tm->next;
+        lpm_rules_remove(w->index, tm->prefix, tm->len);
+        if (batch) {
+            if (lpm_rules_find(trie->rules, tm->prefix, tm->len) &&
+                lpm_delete_incremental(trie, tm->prefix, tm->len) == 0) {
+                removed++;
+            }
+        } else if (lpm_delete(trie, tm->prefix, tm->len) == 0) {
+            removed++;
+        }
+        timer_free(w, t);
+        w->count--;
+        t = next;
+    }
+    if (batch && removed) {
+        lpm_update_flush(trie);
+    }
+    return removed;
+}
+
+size_t lpm_ttl_count(const lpm_trie_t *trie)
+{
+    return (trie && trie->ttl) ? trie->ttl->count : 0;
+}
+
+size_t lpm_ttl_memory(const lpm_trie_t *trie)
+{
+    if (!trie || !trie->ttl) { return 0; }
+    const struct lpm_ttl *w = trie->ttl;
+    return sizeof(*w) + (size_t)w->capacity * sizeof(struct lpm_ttl_timer) +
+           sizeof(*w->index) + (size_t)w->index->capacity * sizeof(struct lpm_rule);
+}
@@ -0,0 +1,225 @@
+/*
+ * liblpm Incremental Updates
+ *
+ * Adding or deleting a short prefix in DIR-24-8 rewrites up to 2^23 slots,
+ * and one up to /16 in wide16 up to 2^15 root entries.
+ * lpm_add_incremental()/lpm_delete_incremental() queue the update instead,
+ * and lpm_update_step() applies queued work for a bounded amount of time, so
+ * a control plane can interleave a /8 with lookups rather than stalling them
+ * for the whole expansion.
+ *
+ * Consistency: each DIR-24-8 slot is rewritten with one 32-bit store and
+ * only slots whose current prefix length the update is allowed to replace are
+ * touched, so a lookup between steps returns either the route it had before
+ * the update or the one it has after it, never a route that is wrong under
+ * both. wide16 root entries are rewritten with one 8-byte store each, with
+ * the same per-entry result as lpm_add()/lpm_delete(). Updates are applied in
+ * the order they were queued; a synchronous lpm_add()/lpm_delete() applies
+ * everything queued before it first.
+ *
+ * DIR-24-8 and wide16 defer work. Every other engine applies incremental
+ * updates immediately through lpm_add()/lpm_delete(), with no time budget;
+ * for the 8-bit stride engines that is at most one 256-entry node. On wide16
+ * only the root range is deferred: prefixes longer than /16 end in a sparse
+ * node, rewritten run by run, or an 8-bit node, and are applied when their
+ * turn comes.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lpm.h"
+#include "../include/internal.h"
+
+#define LPM_UPDATE_QUANTUM 4096  /* Work units between clock reads */
+
+struct lpm_update {
+    uint8_t prefix[16];
+    uint8_t prefix_len;
+    bool del;
+    uint32_t next_hop;
+};
+
+struct lpm_update_queue {
+    struct lpm_update *ops;
+    size_t head;             /* Next op to start */
+    size_t tail;             /* One past the last queued op */
+    size_t capacity;
+    bool active;             /* cur is partially applied */
+    bool wide16;             /* cur.wide16 rather than cur.dir24 */
+    union {
+        lpm_dir24_op_t dir24;
+        lpm_wide16_op_t wide16;
+    } cur;
+};
+
+static int update_push(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                       uint32_t next_hop, bool del)
+{
+    struct lpm_update_queue *q = trie->updates;
+    if (!q) {
+        q = calloc(1, sizeof(*q));
+        if (!q) { return -1; }
+        q->wide16 = trie->max_depth == LPM_IPV6_MAX_DEPTH;
+        trie->updates = q;
+    }
+
+    if (q->tail == q->capacity) {
+        if (q->head > 0) {
+            /* Reuse the consumed front before growing */
+            memmove(q->ops, &q->ops[q->head], (q->tail - q->head) * sizeof(*q->ops));
+            q->tail -= q->head;
+            q->head = 0;
+        } else {
+            size_t cap = q->capacity ? q->capacity * 2 : 64;
+            struct lpm_update *ops = realloc(q->ops, cap * sizeof(*ops));
+            if (!ops) { return -1; }
+            q->ops = ops;
+            q->capacity = cap;
+        }
+    }
+
+    struct lpm_update *u = &q->ops[q->tail++];
+    memset(u, 0, sizeof(*u));
+    memcpy(u->prefix, prefix, (prefix_len + 7) / 8);
+    u->prefix_len = prefix_len;
+    u->del = del;
+    u->next_hop = next_hop;
+    return 0;
+}
+
+/*
+ * Apply queued work until the queue is empty or deadline_ns passes (0 means
+ * no deadline). At least one quantum is applied per call so progress is made
+ * even with a zero budget. Returns true if work remains.
+ */
+static bool update_run(lpm_trie_t *trie, uint64_t deadline_ns)
+{
+    struct lpm_update_queue *q = trie->updates;
+    if (!q) { return false; }
+
+    uint32_t units = 0;
+    for (;;) {
+        if (!q->active) {
+            if (q->head == q->tail) {
+                q->head = q->tail = 0;
+                return false;
+            }
+            struct lpm_update *u = &q->ops[q->head++];
+
+            /* Failed updates (e.g. deleting a missing prefix) are dropped */
+            if (q->wide16) {
+                q->active = lpm_wide16_op_begin(trie, u->prefix, u->prefix_len, u->next_hop,
+                                                u->del, &q->cur.wide16) > 0;
+            } else {
+                q->active = lpm_dir24_op_begin(trie, u->prefix, u->prefix_len, u->next_hop,
+                                               u->del, &q->cur.dir24) > 0;
+            }
+            units += 256;  /* Longer routes touch up to one tbl8 group or node */
+        } else if (q->wide16) {
+            units += lpm_wide16_op_run(trie, &q->cur.wide16, LPM_UPDATE_QUANTUM);
+            if (q->cur.wide16.cursor == q->cur.wide16.count) {
+                q->active = false;
+            }
+        } else {
+            units += lpm_dir24_op_run(trie, &q->cur.dir24, LPM_UPDATE_QUANTUM);
+            if (q->cur.dir24.cursor == q->cur.dir24.count) {
+                q->active = false;
+            }
+        }
+
+        if (units >= LPM_UPDATE_QUANTUM) {
+            units = 0;
+            if (deadline_ns && lpm_now_ns() >= deadline_ns) {
+                return q->active || q->head != q->tail;
+            }
+        }
+    }
+}
+
+void lpm_update_flush(lpm_trie_t *trie)
+{
+    if (trie && trie->updates) {
+        update_run(trie, 0);
+        lpm_generation_bump(trie);
+    }
+}
+
+void lpm_update_queue_destroy(struct lpm_update_queue *q)
+{
+    if (!q) { return; }
+    free(q->ops);
+    free(q);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+bool lpm_update_deferred(const lpm_trie_t *trie)
+{
+    /* Aggregated tries rewrite few engine prefixes per update; apply now */
+    /* Sharded writers would race on the queue; apply now as well */
+    if (trie->agg || trie->set || trie->adapt) { return false; }
+    if (trie->max_depth == LPM_IPV6_MAX_DEPTH) {
+        return trie->use_ipv6_wide_stride && trie->wide_nodes_pool;
+    }
+    return trie->use_ipv4_dir24 && !trie->shards && (trie->dir24_table || trie->dir24c_table);
+}
+
+int lpm_add_incremental(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                        uint32_t next_hop)
+{
+    if (!trie || !prefix || prefix_len > trie->max_depth) { return -1; }
+    if (!lpm_update_deferred(trie)) {
+        return lpm_add(trie, prefix, prefix_len, next_hop);
+    }
+    if (trie->max_depth == LPM_IPV4_MAX_DEPTH && next_hop > lpm_dir24_max_next_hop(trie)) {
+        return -1;
+    }
+    if (update_push(trie, prefix, prefix_len, next_hop, false) < 0) { return -1; }
+    if (trie->nh_index && lpm_nh_index_set(trie, prefix, prefix_len, next_hop) < 0) { return -1; }
+    if (trie->journal) {
+        lpm_journal_record(trie, LPM_JOURNAL_ADD, prefix, prefix_len, next_hop, 0);
+    }
+    return 0;
+}
+
+int lpm_delete_incremental(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    if (!trie || !prefix || prefix_len > trie->max_depth) { return -1; }
+    if (!lpm_update_deferred(trie)) {
+        return lpm_delete(trie, prefix, prefix_len);
+    }
+    if (update_push(trie, prefix, prefix_len, 0, true) < 0) { return -1; }
+    if (trie->nh_index) {
+        lpm_nh_index_clear(trie, prefix, prefix_len);
+    }
+    if (trie->journal) {
+        lpm_journal_record(trie, LPM_JOURNAL_DELETE, prefix, prefix_len, 0, 0);
+    }
+    return 0;
+}
+
+int lpm_update_step(lpm_trie_t *trie, uint32_t budget_us)
+{
+    if (!trie) { return -1; }
+    /* Control planes call this when idle: commit a journal tail that is due */
+    if (trie->journal) {
+        lpm_journal_idle(trie);
+    }
+    if (!trie->updates) { return 0; }
+
+    uint64_t deadline = lpm_now_ns() + (uint64_t)budget_us * 1000ULL;
+    bool more = update_run(trie, deadline);
+    lpm_generation_bump(trie);
+    return more ? 1 : 0;
+}
+
+size_t lpm_update_pending(const lpm_trie_t *trie)
+{
+    if (!trie || !trie->updates) { return 0; }
+    const struct lpm_update_queue *q = trie->updates;
+    return (q->tail - q->head) + (q->active ? 1 : 0);
+}
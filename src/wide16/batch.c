@@ -3,6 +3,8 @@
  * SIMD-optimized batch lookup with ifunc dispatch
  *
  * NEW IMPLEMENTATION - This was missing from the original codebase!
+ * Below the flat root, the sparse 16-bit levels prefetch the node's first
+ * cache line, which holds the whole node when it has few runs.
  */
 
 #include <stdint.h>
@@ -14,61 +16,6 @@
 #include "../../include/lpm.h"
 #include "../../include/internal.h"
 
-/* ============================================================================
- * Wide Stride Lookup Helper (inline for batch use)
- * ============================================================================ */
-
-__attribute__((hot, always_inline))
-static inline uint32_t lookup_wide16_single(const lpm_trie_t *trie, const uint8_t *addr)
-{
-    uint32_t best_next_hop = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
-    uint32_t node_idx = trie->root_idx;
-    
-    /* First level: 16-bit wide stride */
-    bool is_wide_node = true;
-    for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS && is_wide_node; level++) {
-        struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-        uint16_t index = ((uint16_t)addr[(size_t)level * 2] << 8) | addr[((size_t)level * 2) + 1];
-        
-        struct lpm_entry *entry = &wide_node->entries[index];
-        
-        if (entry->child_and_valid & LPM_VALID_FLAG) {
-            best_next_hop = entry->next_hop;
-        }
-        
-        uint32_t cv = entry->child_and_valid;
-        uint32_t child_idx = cv & LPM_CHILD_MASK;
-        bool has_child = (child_idx != 0) || (cv & LPM_WIDE_NODE_FLAG);
-        if (!has_child) {
-            return best_next_hop;
-        }
-        
-        is_wide_node = (cv & LPM_WIDE_NODE_FLAG) != 0;
-        node_idx = child_idx;
-    }
-    
-    /* Remaining levels: 8-bit stride */
-    for (uint8_t byte_idx = 2; byte_idx < 16; byte_idx++) {
-        if (node_idx == LPM_INVALID_INDEX) { break; }
-        
-        struct lpm_node *node = &((struct lpm_node *)trie->node_pool)[node_idx];
-        struct lpm_entry *entry = &node->entries[addr[byte_idx]];
-        
-        if (entry->child_and_valid & LPM_VALID_FLAG) {
-            best_next_hop = entry->next_hop;
-        }
-        
-        uint32_t child_idx = entry->child_and_valid & LPM_CHILD_MASK;
-        if (child_idx == LPM_INVALID_INDEX) {
-            return best_next_hop;
-        }
-        
-        node_idx = child_idx;
-    }
-    
-    return best_next_hop;
-}
-
 /* ============================================================================
  * Scalar Batch Implementation
  * ============================================================================ */
@@ -78,7 +25,7 @@ void lpm_lookup_batch_ipv6_wide16_scalar(const lpm_trie_t *trie, const uint8_t *
                                           uint32_t *next_hops, size_t count)
 {
     for (size_t i = 0; i < count; i++) {
-        next_hops[i] = lookup_wide16_single(trie, addrs[i]);
+        next_hops[i] = lpm_wide16_lookup_inline(trie, addrs[i]);
     }
 }
 
@@ -94,6 +41,7 @@ void lpm_lookup_batch_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t **a
     const struct lpm_node * restrict node_pool = trie->node_pool;
     const uint32_t root = trie->root_idx;
     const uint32_t def = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+    const unsigned wide_levels = trie->wide_levels;
     
     size_t i = 0;
     
@@ -111,10 +59,12 @@ void lpm_lookup_batch_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t **a
         }
         
         /* Wide stride levels (16-bit) */
-        for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS; level++) {
+        for (unsigned level = 0; level < wide_levels; level++) {
             for (int j = 0; j < 4; j++) {
-                if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
+                if (wide[j] && level > 0) {
+                    _mm_prefetch((const char*)lpm_sparse16_node(trie->sparse16, n[j]), _MM_HINT_T0);
+                } else if (wide[j]) {
+                    const struct lpm_node_16 *wn = &wide_pool[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
                     
                     _mm_prefetch((const char*)&wn->entries[idx], _MM_HINT_T0);
@@ -123,9 +73,8 @@ void lpm_lookup_batch_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t **a
             
             for (int j = 0; j < 4; j++) {
                 if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
-                    struct lpm_entry *e = &wn->entries[idx];
+                    const struct lpm_entry *e = lpm_wide16_entry(trie, level, n[j], idx);
                     
                     if (e->child_and_valid & LPM_VALID_FLAG) {
                         r[j] = e->next_hop;
@@ -147,7 +96,7 @@ void lpm_lookup_batch_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t **a
         }
         
         /* 8-bit stride levels */
-        for (uint8_t byte_idx = 2; byte_idx < 16; byte_idx++) {
+        for (unsigned byte_idx = 2 * wide_levels; byte_idx < 16; byte_idx++) {
             bool any_active = false;
             
             for (int j = 0; j < 4; j++) {
@@ -181,7 +130,7 @@ void lpm_lookup_batch_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t **a
     
     /* Remainder */
     for (; i < count; i++) {
-        next_hops[i] = lookup_wide16_single(trie, addrs[i]);
+        next_hops[i] = lpm_wide16_lookup_inline(trie, addrs[i]);
     }
 }
 
@@ -197,6 +146,7 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
     const struct lpm_node * restrict node_pool = trie->node_pool;
     const uint32_t root = trie->root_idx;
     const uint32_t def = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+    const unsigned wide_levels = trie->wide_levels;
     
     size_t i = 0;
     
@@ -214,10 +164,12 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
         }
         
         /* Wide stride levels */
-        for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS; level++) {
+        for (unsigned level = 0; level < wide_levels; level++) {
             for (int j = 0; j < 8; j++) {
-                if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
+                if (wide[j] && level > 0) {
+                    _mm_prefetch((const char*)lpm_sparse16_node(trie->sparse16, n[j]), _MM_HINT_T0);
+                } else if (wide[j]) {
+                    const struct lpm_node_16 *wn = &wide_pool[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
                     _mm_prefetch((const char*)&wn->entries[idx], _MM_HINT_T0);
                 }
@@ -225,9 +177,8 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
             
             for (int j = 0; j < 8; j++) {
                 if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
-                    struct lpm_entry *e = &wn->entries[idx];
+                    const struct lpm_entry *e = lpm_wide16_entry(trie, level, n[j], idx);
                     
                     if (e->child_and_valid & LPM_VALID_FLAG) {
                         r[j] = e->next_hop;
@@ -249,7 +200,7 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
         }
         
         /* 8-bit stride levels */
-        for (uint8_t byte_idx = 2; byte_idx < 16; byte_idx++) {
+        for (unsigned byte_idx = 2 * wide_levels; byte_idx < 16; byte_idx++) {
             int active = 0;
             
             for (int j = 0; j < 8; j++) {
@@ -283,7 +234,7 @@ void lpm_lookup_batch_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t **a
     
     /* Remainder */
     for (; i < count; i++) {
-        next_hops[i] = lookup_wide16_single(trie, addrs[i]);
+        next_hops[i] = lpm_wide16_lookup_inline(trie, addrs[i]);
     }
 }
 
@@ -299,6 +250,7 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
     const struct lpm_node * restrict node_pool = trie->node_pool;
     const uint32_t root = trie->root_idx;
     const uint32_t def = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
+    const unsigned wide_levels = trie->wide_levels;
     
     size_t i = 0;
     
@@ -316,10 +268,12 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
         }
         
         /* Wide stride levels */
-        for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS; level++) {
+        for (unsigned level = 0; level < wide_levels; level++) {
             for (int j = 0; j < 16; j++) {
-                if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
+                if (wide[j] && level > 0) {
+                    _mm_prefetch((const char*)lpm_sparse16_node(trie->sparse16, n[j]), _MM_HINT_T0);
+                } else if (wide[j]) {
+                    const struct lpm_node_16 *wn = &wide_pool[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
                     _mm_prefetch((const char*)&wn->entries[idx], _MM_HINT_T0);
                 }
@@ -327,9 +281,8 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
             
             for (int j = 0; j < 16; j++) {
                 if (wide[j]) {
-                    struct lpm_node_16 *wn = &((struct lpm_node_16 *)wide_pool)[n[j]];
                     uint16_t idx = ((uint16_t)a[j][(size_t)level * 2] << 8) | a[j][((size_t)level * 2) + 1];
-                    struct lpm_entry *e = &wn->entries[idx];
+                    const struct lpm_entry *e = lpm_wide16_entry(trie, level, n[j], idx);
                     
                     if (e->child_and_valid & LPM_VALID_FLAG) {
                         r[j] = e->next_hop;
@@ -351,7 +304,7 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
         }
         
         /* 8-bit stride levels */
-        for (uint8_t byte_idx = 2; byte_idx < 16; byte_idx++) {
+        for (unsigned byte_idx = 2 * wide_levels; byte_idx < 16; byte_idx++) {
             int active = 0;
             
             for (int j = 0; j < 16; j++) {
@@ -391,7 +344,7 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
     
     /* Scalar remainder */
     for (; i < count; i++) {
-        next_hops[i] = lookup_wide16_single(trie, addrs[i]);
+        next_hops[i] = lpm_wide16_lookup_inline(trie, addrs[i]);
     }
 }
 
@@ -399,35 +352,37 @@ void lpm_lookup_batch_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *
  * ifunc Resolver
  * ============================================================================ */
 
-typedef void (*lpm_wide16_batch_func_t)(const lpm_trie_t *, const uint8_t **, uint32_t *, size_t);
-
-EXPLICIT_RUNTIME_RESOLVER(lpm_wide16_batch_resolver)
+/* Kernel for a SIMD level; also used by the explicit selection API */
+lpm_wide16_batch_func_t lpm_wide16_batch_kernel(simd_level_t level)
 {
-    simd_level_t level = LPM_DETECT_SIMD();
-    
     switch (level) {
     case SIMD_AVX512F:
-        return (void*)lpm_lookup_batch_ipv6_wide16_avx512;
+        return lpm_lookup_batch_ipv6_wide16_avx512;
     case SIMD_AVX2:
+        return lpm_lookup_batch_ipv6_wide16_avx2;
     case SIMD_AVX:
-        return (void*)lpm_lookup_batch_ipv6_wide16_avx2;
     case SIMD_SSE4_2:
     case SIMD_SSE2:
-        return (void*)lpm_lookup_batch_ipv6_wide16_sse2;
+        return lpm_lookup_batch_ipv6_wide16_sse2;
     case SIMD_SCALAR:
     default:
-        return (void*)lpm_lookup_batch_ipv6_wide16_scalar;
+        return lpm_lookup_batch_ipv6_wide16_scalar;
     }
 }
 
+EXPLICIT_RUNTIME_RESOLVER(lpm_wide16_batch_resolver)
+{
+    return (void*)lpm_wide16_batch_kernel(LPM_DETECT_SIMD());
+}
+
 /* Internal ifunc-dispatched batch lookup for pointer array */
 static void lpm_lookup_batch_ipv6_wide16_internal(const lpm_trie_t *trie, const uint8_t **addrs,
                                                    uint32_t *next_hops, size_t count)
     __attribute__((ifunc("lpm_wide16_batch_resolver")));
 
-/* Public API for 2D array */
-void lpm_lookup_batch_ipv6_wide16(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
-                                   uint32_t *next_hops, size_t count)
+/* Convert a 2D array for a pointer-array kernel; NULL runs the ifunc-bound one */
+void lpm_lookup_batch_ipv6_wide16_with(lpm_wide16_batch_func_t kernel, const lpm_trie_t *trie,
+                                       const uint8_t (*addrs)[16], uint32_t *next_hops, size_t count)
 {
     if (!trie || !addrs || !next_hops || count == 0) { return; }
     if (!trie->use_ipv6_wide_stride) { return; }
@@ -446,9 +401,20 @@ void lpm_lookup_batch_ipv6_wide16(const lpm_trie_t *trie, const uint8_t (*addrs)
         ptrs[i] = addrs[i];
     }
     
-    lpm_lookup_batch_ipv6_wide16_internal(trie, ptrs, next_hops, count);
+    if (kernel) {
+        kernel(trie, ptrs, next_hops, count);
+    } else {
+        lpm_lookup_batch_ipv6_wide16_internal(trie, ptrs, next_hops, count);
+    }
     
     if (count > 256) {
         free((void *)ptrs);
     }
 }
+
+/* Public API for 2D array */
+void lpm_lookup_batch_ipv6_wide16(const lpm_trie_t *trie, const uint8_t (*addrs)[16],
+                                   uint32_t *next_hops, size_t count)
+{
+    lpm_lookup_batch_ipv6_wide16_with(NULL, trie, addrs, next_hops, count);
+}
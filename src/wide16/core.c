@@ -3,8 +3,16 @@
  * Create, Add, Delete operations for IPv6 with wide stride (16-16-16-8-8-8...)
  *
  * Uses 16-16-16-8-8-8... stride pattern for IPv6:
- * - First 48 bits: 3 levels of 16-bit stride (covers common /48 allocations)
- * - Remaining 80 bits: 10 levels of 8-bit stride
+ * - First 16-48 bits: 1 to 3 levels of 16-bit stride, chosen at creation
+ *   (three cover the common /48 allocations)
+ * - Remaining bits: 8-bit stride
+ *
+ * The root is a flat 512KB node; deeper 16-bit levels are sparse nodes
+ * (src/wide16/sparse.c) that apply the same per-entry updates.
+ *
+ * Prefixes up to /16 rewrite a range of root entries; they go through the
+ * resumable op below, so lpm_update_step() can spread a /1 (32,768 entries)
+ * over several steps.
  */
 
 #define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
@@ -18,8 +26,10 @@
  * Trie Creation
  * ============================================================================ */
 
-lpm_trie_t *lpm_create_ipv6_wide16(void)
+lpm_trie_t *lpm_create_ipv6_wide16_levels(uint8_t wide_levels)
 {
+    if (wide_levels < 1 || wide_levels > LPM_IPV6_WIDE_STRIDE_MAX_LEVELS) { return NULL; }
+
     lpm_trie_t *t = (lpm_trie_t *)aligned_alloc(LPM_CACHE_LINE_SIZE, sizeof(lpm_trie_t));
     if (!t) { return NULL; }
     memset(t, 0, sizeof(lpm_trie_t));
@@ -29,6 +39,7 @@ lpm_trie_t *lpm_create_ipv6_wide16(void)
     t->default_next_hop = LPM_INVALID_NEXT_HOP;
     t->use_ipv6_wide_stride = true;  /* Enable wide stride */
     t->use_ipv4_dir24 = false;
+    t->wide_levels = wide_levels;
     
     /* Allocate regular node pool (for 8-bit stride levels) */
     size_t pool_size = LPM_INITIAL_POOL_SIZE * sizeof(struct lpm_node);
@@ -56,6 +67,15 @@ lpm_trie_t *lpm_create_ipv6_wide16(void)
     t->root_idx = wide_node_alloc(t);
     /* Note: For wide nodes, index 0 is valid */
     
+    /* Sparse pool for the 16-bit levels below the root */
+    if (wide_levels > 1) {
+        t->sparse16 = lpm_sparse16_pool_create();
+        if (!t->sparse16) {
+            lpm_destroy(t);
+            return NULL;
+        }
+    }
+    
     /* Hot cache */
     size_t cache_size = LPM_HOT_CACHE_SIZE * sizeof(struct lpm_cache_entry);
     t->hot_cache = (struct lpm_cache_entry *)aligned_alloc(LPM_CACHE_LINE_SIZE, cache_size);
@@ -63,14 +83,74 @@ lpm_trie_t *lpm_create_ipv6_wide16(void)
         memset(t->hot_cache, 0, cache_size);
     }
     
+    lpm_dispatch_init(t);
     return t;
 }
 
+lpm_trie_t *lpm_create_ipv6_wide16(void)
+{
+    return lpm_create_ipv6_wide16_levels(LPM_IPV6_WIDE_STRIDE_LEVELS);
+}
+
+/* ============================================================================
+ * Wide Levels
+ * ============================================================================ */
+
+static inline uint16_t wide_index(const uint8_t *prefix, unsigned level)
+{
+    return (uint16_t)(((uint16_t)prefix[(size_t)level * 2] << 8) | prefix[((size_t)level * 2) + 1]);
+}
+
+static inline bool wide_has_child(uint32_t cv)
+{
+    /* Wide node index 0 is valid, hence the flag */
+    return (cv & LPM_CHILD_MASK) != 0 || (cv & LPM_WIDE_NODE_FLAG);
+}
+
+/*
+ * Apply op to indexes [lo, hi] of the wide node at level. A sparse node can
+ * move to a bigger block; the parent entry (parent, parent_index at the
+ * level above) is then pointed at its new index.
+ */
+static int wide_update(lpm_trie_t *trie, unsigned level, uint32_t node,
+                       uint32_t parent, uint16_t parent_index,
+                       uint32_t lo, uint32_t hi, enum lpm_sparse16_op op, uint32_t value)
+{
+    if (level == 0) {
+        struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node];
+        for (uint32_t i = lo; i <= hi; i++) {
+            struct lpm_entry *e = &wide_node->entries[i];
+            switch (op) {
+            case LPM_SPARSE16_SET_NH:
+                e->child_and_valid |= LPM_VALID_FLAG;
+                e->next_hop = value;
+                break;
+            case LPM_SPARSE16_CLEAR_NH:
+                e->child_and_valid &= ~LPM_VALID_FLAG;
+                e->next_hop = LPM_INVALID_NEXT_HOP;
+                break;
+            case LPM_SPARSE16_SET_CHILD:
+                e->child_and_valid = (e->child_and_valid & LPM_VALID_FLAG) | value;
+                break;
+            }
+        }
+        return 0;
+    }
+
+    uint32_t moved = node;
+    if (lpm_sparse16_update(trie->sparse16, &moved, lo, hi, op, value) != 0) { return -1; }
+    if (moved != node) {
+        struct lpm_entry *e = (struct lpm_entry *)lpm_wide16_entry(trie, level - 1, parent, parent_index);
+        e->child_and_valid = (e->child_and_valid & ~LPM_CHILD_MASK) | moved;
+    }
+    return 0;
+}
+
 /* ============================================================================
  * Add Prefix
  * ============================================================================ */
 
-int lpm_add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+static int add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
 {
     if (!trie || !prefix || prefix_len > 128) { return -1; }
     
@@ -83,69 +163,49 @@ int lpm_add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_
     }
     
     uint32_t node_idx = trie->root_idx;
+    uint32_t parent = 0;
+    uint16_t parent_index = 0;
     uint8_t depth = 0;
     
-    /* First 3 levels: 16-bit wide stride */
-    for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS && depth < prefix_len; level++) {
-        uint16_t stride_bits = 16;
+    /* First levels: 16-bit wide stride */
+    for (unsigned level = 0; level < trie->wide_levels && depth < prefix_len; level++) {
+        uint16_t index = wide_index(prefix, level);
         
-        if (depth + stride_bits > prefix_len) {
-            /* Partial level - need to expand to all matching entries */
-            struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-            uint8_t remaining = prefix_len - depth;
-            
-            /* Extract base index */
-            uint16_t base_index = ((uint16_t)prefix[(size_t)level * 2] << 8) | prefix[((size_t)level * 2) + 1];
-            base_index &= ~((1 << (16 - remaining)) - 1);
-            
-            /* Expand to all matching entries */
-            uint32_t count = 1 << (16 - remaining);
-            for (uint32_t i = 0; i < count; i++) {
-                uint16_t idx = base_index + i;
-                wide_node->entries[idx].child_and_valid |= LPM_VALID_FLAG;
-                wide_node->entries[idx].next_hop = next_hop;
+        if (depth + 16 >= prefix_len) {
+            /* Ends at this level - expand to all matching entries */
+            uint32_t count = 1U << (depth + 16 - prefix_len);
+            uint32_t base = index & ~(count - 1);
+            if (wide_update(trie, level, node_idx, parent, parent_index, base, base + count - 1,
+                            LPM_SPARSE16_SET_NH, next_hop) != 0) {
+                return -1;
             }
-            
-            trie->num_prefixes++;
-            return 0;
-        }
-        
-        /* Full 16-bit level */
-        struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-        uint16_t index = ((uint16_t)prefix[(size_t)level * 2] << 8) | prefix[((size_t)level * 2) + 1];
-        
-        if (depth + stride_bits == prefix_len) {
-            /* Terminal node at this level */
-            wide_node->entries[index].child_and_valid |= LPM_VALID_FLAG;
-            wide_node->entries[index].next_hop = next_hop;
             trie->num_prefixes++;
             return 0;
         }
         
         /* Need to go deeper */
-        uint32_t child_idx = wide_node->entries[index].child_and_valid & LPM_CHILD_MASK;
-        if (child_idx == LPM_INVALID_INDEX) {
-            /* Allocate next level */
-            uint32_t flags = (wide_node->entries[index].child_and_valid & LPM_VALID_FLAG);
-            
-            if (level + 1 < LPM_IPV6_WIDE_STRIDE_LEVELS) {
-                /* Next level is also wide (16-bit) */
-                child_idx = wide_node_alloc(trie);
-                flags |= LPM_WIDE_NODE_FLAG;  /* Mark as wide node */
-            } else {
-                /* Transition to 8-bit nodes */
-                child_idx = node_alloc(trie);
-            }
-            
+        uint32_t cv = lpm_wide16_entry(trie, level, node_idx, index)->child_and_valid;
+        uint32_t child_idx = cv & LPM_CHILD_MASK;
+        if (!wide_has_child(cv)) {
+            /* Allocate next level: sparse 16-bit, or the first 8-bit node */
+            bool next_wide = level + 1 < trie->wide_levels;
+            child_idx = next_wide ? lpm_sparse16_alloc(trie->sparse16) : node_alloc(trie);
             if (child_idx == LPM_INVALID_INDEX) { return -1; }
             
-            /* Refresh pointer after potential realloc */
-            wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-            wide_node->entries[index].child_and_valid = flags | child_idx;
+            uint32_t link = child_idx | (next_wide ? LPM_WIDE_NODE_FLAG : 0);
+            if (wide_update(trie, level, node_idx, parent, parent_index, index, index,
+                            LPM_SPARSE16_SET_CHILD, link) != 0) {
+                if (next_wide) {
+                    lpm_sparse16_free(trie->sparse16, child_idx);
+                }
+                return -1;
+            }
         }
         
+        parent = node_idx;
+        parent_index = index;
         node_idx = child_idx;
-        depth += stride_bits;
+        depth += 16;
     }
     
     /* Remaining levels: 8-bit stride */
@@ -202,7 +262,7 @@ int lpm_add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_
  * Delete Prefix
  * ============================================================================ */
 
-int lpm_delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+static int delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
 {
     if (!trie || !prefix || prefix_len > 128) { return -1; }
     
@@ -215,49 +275,34 @@ int lpm_delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t pref
     }
     
     uint32_t node_idx = trie->root_idx;
+    uint32_t parent = 0;
+    uint16_t parent_index = 0;
     uint8_t depth = 0;
     
     /* First levels: 16-bit wide stride */
-    for (uint8_t level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS && depth < prefix_len; level++) {
-        uint16_t stride_bits = 16;
+    for (unsigned level = 0; level < trie->wide_levels && depth < prefix_len; level++) {
+        uint16_t index = wide_index(prefix, level);
         
-        if (depth + stride_bits > prefix_len) {
-            /* Partial level */
-            struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-            uint8_t remaining = prefix_len - depth;
-            
-            uint16_t base_index = ((uint16_t)prefix[(size_t)level * 2] << 8) | prefix[((size_t)level * 2) + 1];
-            base_index &= ~((1 << (16 - remaining)) - 1);
-            
-            uint32_t count = 1 << (16 - remaining);
-            for (uint32_t i = 0; i < count; i++) {
-                uint16_t idx = base_index + i;
-                wide_node->entries[idx].child_and_valid &= ~LPM_VALID_FLAG;
-                wide_node->entries[idx].next_hop = LPM_INVALID_NEXT_HOP;
+        if (depth + 16 >= prefix_len) {
+            uint32_t count = 1U << (depth + 16 - prefix_len);
+            uint32_t base = index & ~(count - 1);
+            if (wide_update(trie, level, node_idx, parent, parent_index, base, base + count - 1,
+                            LPM_SPARSE16_CLEAR_NH, 0) != 0) {
+                return -1;
             }
-            
             if (trie->num_prefixes > 0) { trie->num_prefixes--; }
             return 0;
         }
         
-        struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-        uint16_t index = ((uint16_t)prefix[(size_t)level * 2] << 8) | prefix[((size_t)level * 2) + 1];
-        
-        if (depth + stride_bits == prefix_len) {
-            wide_node->entries[index].child_and_valid &= ~LPM_VALID_FLAG;
-            wide_node->entries[index].next_hop = LPM_INVALID_NEXT_HOP;
-            if (trie->num_prefixes > 0) { trie->num_prefixes--; }
-            return 0;
-        }
-        
-        uint32_t child_idx = wide_node->entries[index].child_and_valid & LPM_CHILD_MASK;
-        bool has_child = (child_idx != 0) || (wide_node->entries[index].child_and_valid & LPM_WIDE_NODE_FLAG);
-        if (!has_child) {
+        uint32_t cv = lpm_wide16_entry(trie, level, node_idx, index)->child_and_valid;
+        if (!wide_has_child(cv)) {
             return -1;  /* Prefix not found */
         }
         
-        node_idx = child_idx;
-        depth += stride_bits;
+        parent = node_idx;
+        parent_index = index;
+        node_idx = cv & LPM_CHILD_MASK;
+        depth += 16;
     }
     
     /* Remaining levels: 8-bit stride */
@@ -303,3 +348,95 @@ int lpm_delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t pref
     if (trie->num_prefixes > 0) { trie->num_prefixes--; }
     return 0;
 }
+
+/* ============================================================================
+ * Resumable Root Updates
+ * ============================================================================ */
+
+/* Rewrite one root entry with a single 8-byte store. A delete clears only the
+ * valid bit and keeps the next hop, so a lookup that still read the old valid
+ * bit pairs it with the old next hop. */
+static inline void root_entry_store(struct lpm_entry *e, bool del, uint32_t next_hop)
+{
+    struct lpm_entry v = *e;
+    if (del) {
+        v.child_and_valid &= ~LPM_VALID_FLAG;
+    } else {
+        v.child_and_valid |= LPM_VALID_FLAG;
+        v.next_hop = next_hop;
+    }
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    __atomic_store_n((uint64_t *)(void *)e, bits, __ATOMIC_RELAXED);
+}
+
+int lpm_wide16_op_begin(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                        uint32_t next_hop, bool del, lpm_wide16_op_t *op)
+{
+    if (!trie || !prefix || !op || prefix_len > 128 || !trie->wide_nodes_pool) { return -1; }
+    
+    memset(op, 0, sizeof(*op));
+    
+    /* The default route and prefixes below the root touch few entries */
+    if (prefix_len == 0 || prefix_len > 16) {
+        int rc = del ? delete_ipv6_wide16(trie, prefix, prefix_len)
+                     : add_ipv6_wide16(trie, prefix, prefix_len, next_hop);
+        return rc < 0 ? -1 : 0;
+    }
+    
+    /* Up to /16: 2^(16 - len) root entries, left to lpm_wide16_op_run() */
+    op->count = 1U << (16 - prefix_len);
+    op->base = wide_index(prefix, 0) & ~(op->count - 1);
+    op->next_hop = next_hop;
+    op->del = del;
+    if (!del) {
+        trie->num_prefixes++;
+    } else if (trie->num_prefixes > 0) {
+        trie->num_prefixes--;
+    }
+    return 1;
+}
+
+uint32_t lpm_wide16_op_run(lpm_trie_t *trie, lpm_wide16_op_t *op, uint32_t budget)
+{
+    struct lpm_entry *entries = ((struct lpm_node_16 *)trie->wide_nodes_pool)[trie->root_idx].entries;
+    uint32_t done = 0;
+    
+    while (op->cursor < op->count && done < budget) {
+        root_entry_store(&entries[op->base + op->cursor++], op->del, op->next_hop);
+        done++;
+    }
+    return done;
+}
+
+/* ============================================================================
+ * Public Add/Delete
+ * ============================================================================ */
+
+static int wide16_update(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len,
+                         uint32_t next_hop, bool del)
+{
+    if (!trie) { return -1; }
+    
+    /* Queued incremental updates were issued first and must land first */
+    lpm_update_flush(trie);
+    
+    lpm_wide16_op_t op;
+    int rc = lpm_wide16_op_begin(trie, prefix, prefix_len, next_hop, del, &op);
+    if (rc > 0) {
+        lpm_wide16_op_run(trie, &op, UINT32_MAX);
+        rc = 0;
+    }
+    lpm_generation_bump(trie);
+    return rc;
+}
+
+int lpm_add_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len, uint32_t next_hop)
+{
+    return wide16_update(trie, prefix, prefix_len, next_hop, false);
+}
+
+int lpm_delete_ipv6_wide16(lpm_trie_t *trie, const uint8_t *prefix, uint8_t prefix_len)
+{
+    return wide16_update(trie, prefix, prefix_len, 0, true);
+}
@@ -11,71 +11,6 @@
 #include "../../include/lpm.h"
 #include "../../include/internal.h"
 
-/* ============================================================================
- * Wide Stride Lookup Implementation
- * ============================================================================ */
-
-__attribute__((hot))
-static uint32_t lookup_wide16_internal(const lpm_trie_t *trie, const uint8_t *addr)
-{
-    uint32_t best_next_hop = trie->has_default_route ? trie->default_next_hop : LPM_INVALID_NEXT_HOP;
-    uint32_t node_idx = trie->root_idx;
-    uint8_t level = 0;
-    
-    /* First 3 levels: 16-bit wide stride (48 bits total) */
-    bool is_wide_node = true;
-    for (level = 0; level < LPM_IPV6_WIDE_STRIDE_LEVELS && level < 3; level++) {
-        if (!is_wide_node && node_idx == LPM_INVALID_INDEX) { break; }
-        if (!is_wide_node) { break; }  /* Transitioned to 8-bit nodes */
-        
-        struct lpm_node_16 *wide_node = &((struct lpm_node_16 *)trie->wide_nodes_pool)[node_idx];
-        
-        /* Extract 16-bit index from address */
-        uint16_t index = ((uint16_t)addr[(size_t)level * 2] << 8) | addr[((size_t)level * 2) + 1];
-        
-        struct lpm_entry *entry = &wide_node->entries[index];
-        
-        /* Update best match if this entry has a valid next hop */
-        if (entry->child_and_valid & LPM_VALID_FLAG) {
-            best_next_hop = entry->next_hop;
-        }
-        
-        /* Get child node and check its type */
-        uint32_t cv = entry->child_and_valid;
-        uint32_t child_idx = cv & LPM_CHILD_MASK;
-        bool has_child = (child_idx != 0) || (cv & LPM_WIDE_NODE_FLAG);
-        if (!has_child) {
-            return best_next_hop;
-        }
-        
-        is_wide_node = (cv & LPM_WIDE_NODE_FLAG) != 0;
-        node_idx = child_idx;
-    }
-    
-    /* Remaining levels: 8-bit stride (bytes 2-15 after first 16-bit level, 112 bits) */
-    for (uint8_t byte_idx = 2; byte_idx < 16; byte_idx++) {
-        if (node_idx == LPM_INVALID_INDEX) { break; }
-        
-        struct lpm_node *node = &((struct lpm_node *)trie->node_pool)[node_idx];
-        uint8_t index = addr[byte_idx];
-        
-        struct lpm_entry *entry = &node->entries[index];
-        
-        if (entry->child_and_valid & LPM_VALID_FLAG) {
-            best_next_hop = entry->next_hop;
-        }
-        
-        uint32_t child_idx = entry->child_and_valid & LPM_CHILD_MASK;
-        if (child_idx == LPM_INVALID_INDEX) {
-            return best_next_hop;
-        }
-        
-        node_idx = child_idx;
-    }
-    
-    return best_next_hop;
-}
-
 /* ============================================================================
  * SIMD Variants (same algorithm, different compilation targets)
  * ============================================================================ */
@@ -83,25 +18,25 @@ static uint32_t lookup_wide16_internal(const lpm_trie_t *trie, const uint8_t *ad
 __attribute__((hot))
 uint32_t lpm_lookup_ipv6_wide16_scalar(const lpm_trie_t *trie, const uint8_t *addr)
 {
-    return lookup_wide16_internal(trie, addr);
+    return lpm_wide16_lookup_inline(trie, addr);
 }
 
 __attribute__((hot))
 uint32_t lpm_lookup_ipv6_wide16_sse2(const lpm_trie_t *trie, const uint8_t *addr)
 {
-    return lookup_wide16_internal(trie, addr);
+    return lpm_wide16_lookup_inline(trie, addr);
 }
 
 __attribute__((hot, target("avx2")))
 uint32_t lpm_lookup_ipv6_wide16_avx2(const lpm_trie_t *trie, const uint8_t *addr)
 {
-    return lookup_wide16_internal(trie, addr);
+    return lpm_wide16_lookup_inline(trie, addr);
 }
 
 __attribute__((hot, target("avx512f")))
 uint32_t lpm_lookup_ipv6_wide16_avx512(const lpm_trie_t *trie, const uint8_t *addr)
 {
-    return lookup_wide16_internal(trie, addr);
+    return lpm_wide16_lookup_inline(trie, addr);
 }
 
 /* ============================================================================
@@ -118,8 +53,8 @@ EXPLICIT_RUNTIME_RESOLVER(lpm_wide16_single_resolver)
     case SIMD_AVX512F:
         return (void*)lpm_lookup_ipv6_wide16_avx512;
     case SIMD_AVX2:
-    case SIMD_AVX:
         return (void*)lpm_lookup_ipv6_wide16_avx2;
+    case SIMD_AVX:
     case SIMD_SSE4_2:
     case SIMD_SSE2:
         return (void*)lpm_lookup_ipv6_wide16_sse2;
@@ -0,0 +1,298 @@
+/*
+ * IPv6 Wide 16-bit Stride Algorithm - Sparse Nodes
+ * Run-length 16-bit nodes for the wide levels below the root
+ *
+ * A flat 16-bit node is 512KB however few prefixes sit under it, which is
+ * why only the root used to be wide. Below the root a 16-bit node usually
+ * holds a handful of /32 or /48 prefixes, so it is stored as the runs of
+ * equal entries those prefixes cut the index space into (see
+ * include/algo/wide16.h). Updates apply the same per-entry changes a flat
+ * node would see, splitting runs at the range ends and merging equal
+ * neighbours afterwards, so lookups return exactly what a flat node would.
+ *
+ * Nodes live in one pool of 64-byte cells handed out in power-of-two
+ * blocks, with a free list per block size. Child links hold cell indexes,
+ * so a node that outgrows its block moves and its parent is repointed.
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/lpm.h"
+#include "../../include/internal.h"
+
+#define LPM_SPARSE16_INITIAL_CELLS 64
+#define LPM_SPARSE16_MAX_RUNS      65536
+
+/* ============================================================================
+ * Blocks
+ * ============================================================================ */
+
+static size_t block_bytes(uint32_t capacity)
+{
+    return sizeof(struct lpm_sparse16) + (((size_t)capacity * sizeof(uint16_t) + 7) & ~(size_t)7) +
+           (size_t)capacity * sizeof(struct lpm_entry);
+}
+
+/* Most runs a block of 2^k cells holds */
+static uint32_t class_capacity(unsigned k)
+{
+    size_t bytes = (size_t)LPM_SPARSE16_CELL << k;
+    uint32_t cap = (uint32_t)((bytes - sizeof(struct lpm_sparse16)) / (sizeof(uint16_t) + sizeof(struct lpm_entry)));
+    while (block_bytes(cap) > bytes) {
+        cap--;
+    }
+    return cap;
+}
+
+static unsigned class_for(uint32_t runs)
+{
+    unsigned k = 0;
+    while (class_capacity(k) < runs) {
+        k++;
+    }
+    return k;
+}
+
+static int sparse_pool_grow(struct lpm_sparse16_pool *p, uint32_t cells)
+{
+    uint32_t cap = p->capacity;
+    while (cap - p->used < cells) {
+        cap *= 2;
+    }
+    uint8_t *mem = aligned_alloc(LPM_CACHE_LINE_SIZE, (size_t)cap * LPM_SPARSE16_CELL);
+    if (!mem) { return -1; }
+    memcpy(mem, p->cells, (size_t)p->used * LPM_SPARSE16_CELL);
+    free(p->cells);
+    p->cells = mem;
+    p->capacity = cap;
+    return 0;
+}
+
+static uint32_t block_alloc(struct lpm_sparse16_pool *p, unsigned k)
+{
+    uint32_t idx = p->free_head[k];
+    if (idx) {
+        memcpy(&p->free_head[k], lpm_sparse16_node(p, idx)->starts, sizeof(uint32_t));
+    } else {
+        uint32_t cells = 1U << k;
+        if (p->capacity - p->used < cells && sparse_pool_grow(p, cells) != 0) {
+            return LPM_INVALID_INDEX;
+        }
+        idx = p->used;
+        p->used += cells;
+    }
+    struct lpm_sparse16 *n = lpm_sparse16_node(p, idx);
+    n->count = 0;
+    n->capacity = class_capacity(k);
+    p->live_cells += 1U << k;
+    return idx;
+}
+
+static void block_free(struct lpm_sparse16_pool *p, uint32_t idx)
+{
+    struct lpm_sparse16 *n = lpm_sparse16_node(p, idx);
+    unsigned k = class_for(n->capacity);
+    n->count = 0;
+    memcpy(n->starts, &p->free_head[k], sizeof(uint32_t));
+    p->free_head[k] = idx;
+    p->live_cells -= 1U << k;
+}
+
+/* Copy a node into a block sized for runs; the old block is freed */
+static int node_move(struct lpm_sparse16_pool *p, uint32_t *idx, uint32_t runs)
+{
+    uint32_t to = block_alloc(p, class_for(runs));
+    if (to == LPM_INVALID_INDEX) { return -1; }
+
+    /* The pool may have moved: resolve both blocks afterwards */
+    struct lpm_sparse16 *src = lpm_sparse16_node(p, *idx);
+    struct lpm_sparse16 *dst = lpm_sparse16_node(p, to);
+    dst->count = src->count;
+    memcpy(dst->starts, src->starts, src->count * sizeof(uint16_t));
+    memcpy(lpm_sparse16_entries(dst), lpm_sparse16_entries(src), src->count * sizeof(struct lpm_entry));
+    block_free(p, *idx);
+    *idx = to;
+    return 0;
+}
+
+/* ============================================================================
+ * Pool
+ * ============================================================================ */
+
+struct lpm_sparse16_pool *lpm_sparse16_pool_create(void)
+{
+    struct lpm_sparse16_pool *p = calloc(1, sizeof(*p));
+    if (!p) { return NULL; }
+    p->cells = aligned_alloc(LPM_CACHE_LINE_SIZE, (size_t)LPM_SPARSE16_INITIAL_CELLS * LPM_SPARSE16_CELL);
+    if (!p->cells) {
+        free(p);
+        return NULL;
+    }
+    p->capacity = LPM_SPARSE16_INITIAL_CELLS;
+    p->used = 1;
+    return p;
+}
+
+void lpm_sparse16_pool_destroy(struct lpm_sparse16_pool *p)
+{
+    if (!p) { return; }
+    free(p->cells);
+    free(p);
+}
+
+size_t lpm_sparse16_memory(const struct lpm_sparse16_pool *p)
+{
+    return p ? (size_t)p->capacity * LPM_SPARSE16_CELL : 0;
+}
+
+uint32_t lpm_sparse16_alloc(struct lpm_sparse16_pool *p)
+{
+    uint32_t idx = block_alloc(p, 0);
+    if (idx == LPM_INVALID_INDEX) { return idx; }
+
+    struct lpm_sparse16 *n = lpm_sparse16_node(p, idx);
+    n->count = 1;
+    n->starts[0] = 0;
+    lpm_sparse16_entries(n)[0] = (struct lpm_entry){ .child_and_valid = 0,
+                                                     .next_hop = LPM_INVALID_NEXT_HOP };
+    p->nodes++;
+    return idx;
+}
+
+void lpm_sparse16_free(struct lpm_sparse16_pool *p, uint32_t idx)
+{
+    block_free(p, idx);
+    p->nodes--;
+}
+
+/* ============================================================================
+ * Updates
+ * ============================================================================ */
+
+/* Run holding index */
+static uint32_t run_of(const struct lpm_sparse16 *n, uint32_t index)
+{
+    uint32_t lo = 0, hi = n->count;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (n->starts[mid] <= index) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Make a run start at index; capacity for one more run is reserved */
+static void run_split(struct lpm_sparse16 *n, uint32_t index)
+{
+    struct lpm_entry *e = lpm_sparse16_entries(n);
+    uint32_t r = run_of(n, index);
+    if (n->starts[r] == index) { return; }
+
+    uint32_t tail = n->count - r - 1;
+    memmove(&n->starts[r + 2], &n->starts[r + 1], tail * sizeof(uint16_t));
+    memmove(&e[r + 2], &e[r + 1], tail * sizeof(struct lpm_entry));
+    n->starts[r + 1] = (uint16_t)index;
+    e[r + 1] = e[r];
+    n->count++;
+}
+
+static bool entry_equal(const struct lpm_entry *a, const struct lpm_entry *b)
+{
+    return a->child_and_valid == b->child_and_valid && a->next_hop == b->next_hop;
+}
+
+static void runs_merge(struct lpm_sparse16 *n)
+{
+    struct lpm_entry *e = lpm_sparse16_entries(n);
+    uint32_t w = 0;
+    for (uint32_t r = 1; r < n->count; r++) {
+        if (entry_equal(&e[w], &e[r])) { continue; }
+        w++;
+        n->starts[w] = n->starts[r];
+        e[w] = e[r];
+    }
+    n->count = w + 1;
+}
+
+int lpm_sparse16_update(struct lpm_sparse16_pool *p, uint32_t *idx, uint32_t lo, uint32_t hi,
+                        enum lpm_sparse16_op op, uint32_t value)
+{
+    struct lpm_sparse16 *n = lpm_sparse16_node(p, *idx);
+
+    /* Splitting at both ends adds at most two runs */
+    if (n->count + 2 > n->capacity) {
+        uint32_t runs = n->count + 2 < LPM_SPARSE16_MAX_RUNS ? n->count + 2 : LPM_SPARSE16_MAX_RUNS;
+        if (node_move(p, idx, runs) != 0) { return -1; }
+        n = lpm_sparse16_node(p, *idx);
+    }
+
+    run_split(n, lo);
+    if (hi + 1 < LPM_STRIDE_SIZE_16) {
+        run_split(n, hi + 1);
+    }
+
+    struct lpm_entry *e = lpm_sparse16_entries(n);
+    for (uint32_t r = run_of(n, lo); r < n->count && n->starts[r] <= hi; r++) {
+        switch (op) {
+        case LPM_SPARSE16_SET_NH:
+            e[r].child_and_valid |= LPM_VALID_FLAG;
+            e[r].next_hop = value;
+            break;
+        case LPM_SPARSE16_CLEAR_NH:
+            e[r].child_and_valid &= ~LPM_VALID_FLAG;
+            e[r].next_hop = LPM_INVALID_NEXT_HOP;
+            break;
+        case LPM_SPARSE16_SET_CHILD:
+            e[r].child_and_valid = (e[r].child_and_valid & LPM_VALID_FLAG) | value;
+            break;
+        }
+    }
+    runs_merge(n);
+
+    /* Give back a block that is three quarters empty; if that fails the
+     * node just stays where it is */
+    unsigned k = class_for(n->capacity);
+    if (k >= 2 && n->count + 2 <= class_capacity(k - 2)) {
+        node_move(p, idx, n->count + 2);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Next-Hop Rewrites
+ * ============================================================================ */
+
+static void runs_repoint(struct lpm_sparse16 *n, uint32_t lo, uint32_t hi,
+                         uint32_t old_nh, uint32_t new_nh)
+{
+    struct lpm_entry *e = lpm_sparse16_entries(n);
+    for (uint32_t r = run_of(n, lo); r < n->count && n->starts[r] <= hi; r++) {
+        if ((e[r].child_and_valid & LPM_VALID_FLAG) && e[r].next_hop == old_nh) {
+            e[r].next_hop = new_nh;
+        }
+    }
+}
+
+void lpm_sparse16_repoint(struct lpm_sparse16_pool *p, uint32_t idx, uint32_t lo, uint32_t hi,
+                          uint32_t old_nh, uint32_t new_nh)
+{
+    /* A run reaching past [lo, hi] holds the same next hop on both sides,
+     * and every prefix using old_nh is repointed, so whole runs are fine */
+    runs_repoint(lpm_sparse16_node(p, idx), lo, hi, old_nh, new_nh);
+}
+
+void lpm_sparse16_repoint_all(struct lpm_sparse16_pool *p, uint32_t old_nh, uint32_t new_nh)
+{
+    uint32_t idx = 1;
+    while (idx < p->used) {
+        struct lpm_sparse16 *n = lpm_sparse16_node(p, idx);
+        if (n->count) {
+            runs_repoint(n, 0, LPM_STRIDE_SIZE_16 - 1, old_nh, new_nh);
+        }
+        idx += 1U << class_for(n->capacity);
+    }
+}
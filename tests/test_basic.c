@@ -2,8 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #include <arpa/inet.h>
 #include "../include/lpm.h"
+#include "../include/lpm_inline.h"
 
 #ifdef DEBUG_TESTS
 #define DEBUG_VERBOSE 1
@@ -333,6 +337,2062 @@ static void test_default_route(void)
     printf("Default route tests passed!\n\n");
 }
 
+static void test_address_parsing(void)
+{
+    printf("Testing batch address parsing...\n");
+
+    const char *v4[] = {"192.168.0.1", "0.0.0.0", "255.255.255.255", "10.0.0.256",
+                        "01.2.3.4", "1.2.3", "1.2.3.4.5", "a.b.c.d", NULL, "8.8.8.8"};
+    const size_t n4 = sizeof(v4) / sizeof(v4[0]);
+    uint32_t addrs[10];
+    uint8_t status[10];
+
+    assert(lpm_parse_ipv4_batch(v4, NULL, addrs, status, n4) == 4);
+    assert(status[0] == LPM_PARSE_OK && addrs[0] == 0xC0A80001);
+    assert(status[1] == LPM_PARSE_OK && addrs[1] == 0);
+    assert(status[2] == LPM_PARSE_OK && addrs[2] == 0xFFFFFFFF);
+    assert(status[3] == LPM_PARSE_ERR_RANGE && addrs[3] == 0);
+    for (size_t i = 4; i < 9; i++) {
+        assert(status[i] == LPM_PARSE_ERR_SYNTAX);
+    }
+    assert(status[9] == LPM_PARSE_OK && addrs[9] == 0x08080808);
+
+    /* Explicit lengths: parse a token out of a larger buffer */
+    const char *line = "10.1.2.3 GET /index.html";
+    const size_t len = 8;
+    assert(lpm_parse_ipv4_batch(&line, &len, addrs, status, 1) == 1);
+    assert(addrs[0] == 0x0A010203);
+
+    const char *v6[] = {"2001:db8::1", "::", "::ffff:192.0.2.1", "fe80::1:2:3:4:5:6",
+                        "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8:9", "2001:db8:::1", "12345::", "g::"};
+    const size_t n6 = sizeof(v6) / sizeof(v6[0]);
+    uint8_t addrs6[9][16];
+    assert(lpm_parse_ipv6_batch(v6, NULL, addrs6, status, n6) == 5);
+    for (size_t i = 0; i < n6; i++) {
+        uint8_t ref[16];
+        int ok = inet_pton(AF_INET6, v6[i], ref) == 1;
+        assert((status[i] == LPM_PARSE_OK) == ok);
+        assert(!ok || memcmp(addrs6[i], ref, 16) == 0);
+    }
+
+    /* CIDR prefixes, mixed families; host bits are cleared */
+    const char *pfx[] = {"10.1.2.3/8", "2001:db8::1/32", "192.0.2.1", "1.2.3.4/33", "::/0"};
+    uint8_t prefixes[5][16];
+    uint8_t plens[5];
+    uint8_t depths[5];
+    assert(lpm_parse_prefix_batch(pfx, NULL, prefixes, plens, depths, status, 5) == 4);
+    assert(plens[0] == 8 && depths[0] == LPM_IPV4_MAX_DEPTH);
+    assert(prefixes[0][0] == 10 && prefixes[0][1] == 0 && prefixes[0][3] == 0);
+    assert(plens[1] == 32 && depths[1] == LPM_IPV6_MAX_DEPTH);
+    assert(prefixes[1][3] == 0xb8 && prefixes[1][15] == 0);
+    assert(plens[2] == 32 && prefixes[2][3] == 1);
+    assert(status[3] == LPM_PARSE_ERR_PREFIX_LEN);
+    assert(plens[4] == 0 && depths[4] == LPM_IPV6_MAX_DEPTH);
+
+    printf("Batch address parsing tests passed!\n\n");
+}
+
+static void write_test_file(char *path, const void *data, size_t len)
+{
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, data, len) == (ssize_t)len);
+    close(fd);
+}
+
+/* Append one TABLE_DUMP_V2 record to buf, return the new length */
+static size_t mrt_append(uint8_t *buf, size_t off, uint16_t subtype,
+                         const uint8_t *body, uint32_t body_len)
+{
+    uint8_t hdr[12] = {0, 0, 0, 0, 0, 13, (uint8_t)(subtype >> 8), (uint8_t)subtype,
+                       (uint8_t)(body_len >> 24), (uint8_t)(body_len >> 16),
+                       (uint8_t)(body_len >> 8), (uint8_t)body_len};
+    memcpy(buf + off, hdr, sizeof(hdr));
+    memcpy(buf + off + sizeof(hdr), body, body_len);
+    return off + sizeof(hdr) + body_len;
+}
+
+static void test_prefix_file_loading(void)
+{
+    printf("Testing bulk prefix file loading...\n");
+
+    /* More specific routes first: the loader must order them itself */
+    const char *text =
+        "# test table\n"
+        "10.1.2.0/24   300\n"
+        "10.1.2.128/25 400\n"
+        "10.1.2.200/30 600\n"
+        "10.0.0.0/8    100\n"
+        "  10.1.0.0/16 200   # trailing comment\n"
+        "\n"
+        "192.0.2.0/24\n"
+        "2001:db8::/32 500\n"
+        "10.2.0.0/16 junk\n"
+        "300.0.0.0/8 1\n"
+        "10.1.0.0/16 250\n";
+    char path[] = "/tmp/lpm_load_XXXXXX";
+    write_test_file(path, text, strlen(text));
+
+    lpm_trie_t *tries[] = {lpm_create_ipv4_dir24(), lpm_create_ipv4_dir24_compact(),
+                           lpm_create_ipv4_8stride()};
+    for (size_t t = 0; t < 3; t++) {
+        lpm_load_stats_t st;
+        assert(tries[t]);
+        assert(lpm_load_prefix_file(tries[t], path, 2, &st) == 0);
+        assert(!st.mrt);
+        assert(st.records == 10 && st.loaded == 7 && st.skipped == 1 && st.errors == 2);
+        assert(t == 2 || tries[t]->num_prefixes == 6);  /* Stride tries count re-adds */
+        assert(lpm_lookup_ipv4(tries[t], 0x0A010203) == 300);
+        assert(lpm_lookup_ipv4(tries[t], 0x0A010281) == 400);
+        assert(lpm_lookup_ipv4(tries[t], 0x0A0102C9) == 600);
+        assert(lpm_lookup_ipv4(tries[t], 0x0A010303) == 250);  /* Last duplicate wins */
+        assert(lpm_lookup_ipv4(tries[t], 0x0A050505) == 100);
+        assert(lpm_lookup_ipv4(tries[t], 0xC0000207) == 0);
+        assert(lpm_lookup_ipv4(tries[t], 0x0B000000) == LPM_INVALID_NEXT_HOP);
+
+        /* DIR-24-8 loads fill the rule store: deletes fall back to loaded
+         * routes and keep the more specific ones */
+        const uint8_t p25[4] = {10, 1, 2, 128};
+        if (t < 2) {
+            assert(lpm_delete(tries[t], p25, 25) == 0);
+            assert(lpm_lookup_ipv4(tries[t], 0x0A010281) == 300);
+            assert(lpm_lookup_ipv4(tries[t], 0x0A0102C9) == 600);
+
+            /* A second load onto a populated table merges with it */
+            assert(lpm_load_prefix_file(tries[t], path, 1, &st) == 0);
+            assert(lpm_lookup_ipv4(tries[t], 0x0A010281) == 400);
+        }
+        lpm_destroy(tries[t]);
+    }
+
+    lpm_trie_t *trie6 = lpm_create_ipv6();
+    lpm_load_stats_t st;
+    assert(lpm_load_prefix_file(trie6, path, 0, &st) == 0);
+    assert(st.loaded == 1 && st.skipped == 7 && st.errors == 2);
+    uint8_t addr6[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    assert(lpm_lookup_ipv6(trie6, addr6) == 500);
+
+    /* Both families from one parse */
+    lpm_trie_t *pair4 = lpm_create_ipv4_dir24();
+    lpm_trie_t *pair6 = lpm_create_ipv6();
+    assert(lpm_load_prefix_file_pair(pair4, pair6, path, 2, &st) == 0);
+    assert(st.records == 10 && st.loaded == 8 && st.skipped == 0 && st.errors == 2);
+    assert(lpm_lookup_ipv4(pair4, 0x0A010303) == 250);
+    assert(lpm_lookup_ipv4(pair4, 0xC0000207) == 0);
+    assert(lpm_lookup_ipv6(pair6, addr6) == 500);
+    assert(lpm_load_prefix_file_pair(NULL, NULL, path, 0, NULL) == -1);
+    assert(lpm_load_prefix_file_pair(trie6, NULL, path, 0, NULL) == -1);
+    assert(lpm_load_prefix_file_pair(NULL, pair4, path, 0, NULL) == -1);
+    lpm_destroy(trie6);
+    unlink(path);
+
+    /* MRT: peer index table, two IPv4 RIBs and one IPv6 RIB */
+    uint8_t mrt[256];
+    size_t len = 0;
+    const uint8_t peers[] = {0, 0, 0, 0, 0, 0, 0, 0};
+    const uint8_t rib_a[] = {0, 0, 0, 0, 8, 10,            0, 1, 0, 7, 0, 0, 0, 0, 0, 0};
+    const uint8_t rib_b[] = {0, 0, 0, 1, 20, 10, 1, 0xFF,  0, 1, 0, 3, 0, 0, 0, 0, 0, 0};
+    const uint8_t rib_c[] = {0, 0, 0, 2, 16, 0x20, 0x01,   0, 1, 0, 9, 0, 0, 0, 0, 0, 0};
+    len = mrt_append(mrt, len, 1, peers, sizeof(peers));
+    len = mrt_append(mrt, len, 2, rib_a, sizeof(rib_a));
+    len = mrt_append(mrt, len, 2, rib_b, sizeof(rib_b));
+    len = mrt_append(mrt, len, 4, rib_c, sizeof(rib_c));
+    char mrt_path[] = "/tmp/lpm_mrt_XXXXXX";
+    write_test_file(mrt_path, mrt, len);
+
+    lpm_trie_t *trie = lpm_create_ipv4();
+    assert(lpm_load_prefix_file(trie, mrt_path, 0, &st) == 0);
+    assert(st.mrt && st.records == 2 && st.loaded == 2 && st.skipped == 1 && st.errors == 0);
+    assert(lpm_lookup_ipv4(trie, 0x0A000001) == 7);
+    assert(lpm_lookup_ipv4(trie, 0x0A01F001) == 3);  /* Host bits cleared to 10.1.240.0/20 */
+    lpm_destroy(trie);
+
+    lpm_destroy(pair4);
+    lpm_destroy(pair6);
+    pair4 = lpm_create_ipv4();
+    pair6 = lpm_create_ipv6();
+    assert(lpm_load_prefix_file_pair(pair4, pair6, mrt_path, 0, &st) == 0);
+    assert(st.mrt && st.records == 3 && st.loaded == 3 && st.skipped == 0);
+    assert(lpm_lookup_ipv4(pair4, 0x0A000001) == 7);
+    assert(lpm_lookup_ipv6(pair6, addr6) == 9);  /* 2001::/16 */
+    lpm_destroy(pair4);
+    lpm_destroy(pair6);
+    unlink(mrt_path);
+
+    assert(lpm_load_prefix_file(NULL, mrt_path, 0, NULL) == -1);
+    printf("Bulk prefix file loading tests passed!\n\n");
+}
+
+static void test_multi_table_lookup(void)
+{
+    printf("Testing multi-table batch lookup...\n");
+
+    enum { N = 1000 };
+    lpm_trie_t *v4[] = {lpm_create_ipv4_dir24(), lpm_create_ipv4_8stride(), NULL,
+                        lpm_create_ipv4_dir24()};
+    lpm_trie_t *v6[] = {lpm_create_ipv6_wide16(), lpm_create_ipv6_8stride()};
+    srand(42);
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; v4[t] && i < 2000; i++) {
+            uint8_t p[4] = {(uint8_t)(rand() % 4), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+            lpm_add(v4[t], p, (uint8_t)(8 + rand() % 25), (uint32_t)(t * 10000 + i));
+        }
+    }
+    uint8_t dflt[4] = {0};
+    lpm_add(v4[3], dflt, 0, 7);
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 2000; i++) {
+            uint8_t p[16] = {0x20, 0x01, (uint8_t)(rand() % 4)};
+            for (int b = 3; b < 16; b++) { p[b] = (uint8_t)rand(); }
+            lpm_add(v6[t], p, (uint8_t)(16 + rand() % 113), (uint32_t)(t * 10000 + i));
+        }
+    }
+
+    static uint32_t addrs[N];
+    static uint8_t addrs6[N][16];
+    static uint32_t res[4][N];
+    static uint32_t ref[N];
+    for (int i = 0; i < N; i++) {
+        addrs[i] = ((uint32_t)(rand() % 4) << 24) | ((uint32_t)rand() & 0xFFFFFF);
+        addrs6[i][0] = 0x20; addrs6[i][1] = 0x01; addrs6[i][2] = (uint8_t)(rand() % 4);
+        for (int b = 3; b < 16; b++) { addrs6[i][b] = (uint8_t)rand(); }
+    }
+
+    uint32_t *out[] = {res[0], res[1], res[2], res[3]};
+    lpm_lookup_batch_multi_ipv4((const lpm_trie_t *const *)v4, 4, addrs, out, N);
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < N; i++) {
+            ref[i] = v4[t] ? lpm_lookup_ipv4(v4[t], addrs[i]) : LPM_INVALID_NEXT_HOP;
+            assert(res[t][i] == ref[i]);
+        }
+    }
+
+    /* IPv6 tries passed to the IPv4 variant are treated as missing */
+    lpm_lookup_batch_multi_ipv4((const lpm_trie_t *const *)v6, 1, addrs, out, N);
+    assert(res[0][0] == LPM_INVALID_NEXT_HOP);
+
+    lpm_lookup_batch_multi_ipv6((const lpm_trie_t *const *)v6, 2, (const uint8_t (*)[16])addrs6, out, N);
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < N; i++) {
+            assert(res[t][i] == lpm_lookup_ipv6(v6[t], addrs6[i]));
+        }
+    }
+
+    for (int t = 0; t < 4; t++) { lpm_destroy(v4[t]); }
+    for (int t = 0; t < 2; t++) { lpm_destroy(v6[t]); }
+    printf("Multi-table batch lookup tests passed!\n\n");
+}
+
+static void test_incremental_update(void)
+{
+    printf("Testing incremental updates...\n");
+
+    lpm_trie_t *t = lpm_create_ipv4_dir24();
+    uint8_t p8[4] = {10, 0, 0, 0}, p16[4] = {10, 1, 0, 0}, p25[4] = {10, 1, 2, 128};
+    assert(lpm_add(t, p16, 16, 1) == 0);
+    assert(lpm_add(t, p25, 25, 3) == 0);
+
+    /* A covering /8 applied in steps never hides the more specific routes */
+    assert(lpm_add_incremental(t, p8, 8, 2) == 0);
+    assert(lpm_update_pending(t) == 1);
+    int steps = 0;
+    int rc;
+    do {
+        rc = lpm_update_step(t, 0);
+        steps++;
+        uint32_t nh = lpm_lookup_ipv4(t, 0x0A050001);  /* 10.5.0.1 */
+        assert(nh == LPM_INVALID_NEXT_HOP || nh == 2);
+        assert(lpm_lookup_ipv4(t, 0x0A010203) == 1);   /* 10.1.2.3 */
+        assert(lpm_lookup_ipv4(t, 0x0A0102C8) == 3);   /* 10.1.2.200 */
+    } while (rc == 1);
+    assert(rc == 0 && steps > 1);
+    assert(lpm_update_pending(t) == 0);
+    assert(lpm_lookup_ipv4(t, 0x0A050001) == 2);
+    assert(lpm_lookup_ipv4(t, 0x0AFFFFFF) == 2);
+
+    /* Deleting a prefix restores the longest covering one */
+    assert(lpm_delete(t, p16, 16) == 0);
+    assert(lpm_lookup_ipv4(t, 0x0A010203) == 2);
+    assert(lpm_lookup_ipv4(t, 0x0A0102C8) == 3);
+    assert(lpm_delete(t, p25, 25) == 0);
+    assert(lpm_lookup_ipv4(t, 0x0A0102C8) == 2);
+
+    /* Deleting a prefix that is not installed fails and changes nothing */
+    uint8_t p12[4] = {10, 16, 0, 0};
+    assert(lpm_delete(t, p16, 16) == -1);
+    assert(lpm_delete(t, p12, 12) == -1);
+    assert(lpm_delete(t, p25, 25) == -1);
+    assert(lpm_lookup_ipv4(t, 0x0A100001) == 2);
+    assert(lpm_delete_incremental(t, p12, 12) == 0);   /* Queued, then ignored */
+    assert(lpm_update_step(t, 0) == 0);
+    assert(lpm_lookup_ipv4(t, 0x0A100001) == 2);
+
+    assert(lpm_add(t, p16, 16, 1) == 0);
+    assert(lpm_delete_incremental(t, p8, 8) == 0);
+    while ((rc = lpm_update_step(t, 0)) == 1) {
+        uint32_t nh = lpm_lookup_ipv4(t, 0x0A050001);
+        assert(nh == LPM_INVALID_NEXT_HOP || nh == 2);
+        assert(lpm_lookup_ipv4(t, 0x0A010203) == 1);
+    }
+    assert(lpm_lookup_ipv4(t, 0x0A050001) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_lookup_ipv4(t, 0x0A010203) == 1);
+
+    /* Synchronous updates apply queued work first */
+    uint8_t p20[4] = {20, 0, 0, 0}, p30[4] = {30, 0, 0, 0};
+    assert(lpm_add_incremental(t, p20, 8, 20) == 0);
+    assert(lpm_add(t, p30, 8, 30) == 0);
+    assert(lpm_update_pending(t) == 0);
+    assert(lpm_lookup_ipv4(t, 0x14000001) == 20);
+    assert(lpm_lookup_ipv4(t, 0x1E000001) == 30);
+    lpm_destroy(t);
+
+    /* Stride tries apply incremental updates immediately */
+    t = lpm_create_ipv4_8stride();
+    assert(lpm_add_incremental(t, p8, 8, 2) == 0);
+    assert(lpm_update_pending(t) == 0);
+    assert(lpm_update_step(t, 100) == 0);
+    assert(lpm_lookup_ipv4(t, 0x0A050001) == 2);
+    lpm_destroy(t);
+
+    /* wide16 defers root ranges: a /1 is 32,768 root entries */
+    t = lpm_create_ipv6_wide16();
+    uint8_t v6_1[16] = {0}, v6_24[16] = {0x20, 0x01, 0x0d};
+    uint8_t a_in[16] = {0x20, 0x01, 0x0d, 0xb8, [15] = 1};  /* Under the /24 */
+    uint8_t a_out[16] = {0x30, [15] = 1};                  /* Under the /1 only */
+    assert(lpm_add(t, v6_24, 24, 7) == 0);
+    assert(lpm_add_incremental(t, v6_1, 1, 8) == 0);
+    assert(lpm_update_pending(t) == 1);
+    steps = 0;
+    do {
+        rc = lpm_update_step(t, 0);
+        steps++;
+        uint32_t nh = lpm_lookup_ipv6(t, a_out);
+        assert(nh == LPM_INVALID_NEXT_HOP || nh == 8);
+        assert(lpm_lookup_ipv6(t, a_in) == 7);
+    } while (rc == 1);
+    assert(rc == 0 && steps > 1);
+    assert(lpm_lookup_ipv6(t, a_out) == 8);
+
+    assert(lpm_delete_incremental(t, v6_1, 1) == 0);
+    while ((rc = lpm_update_step(t, 0)) == 1) {
+        uint32_t nh = lpm_lookup_ipv6(t, a_out);
+        assert(nh == LPM_INVALID_NEXT_HOP || nh == 8);
+        assert(lpm_lookup_ipv6(t, a_in) == 7);
+    }
+    assert(lpm_lookup_ipv6(t, a_out) == LPM_INVALID_NEXT_HOP);
+
+    /* Longer prefixes and synchronous updates behind queued work */
+    uint8_t v6_48[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 1};
+    assert(lpm_add_incremental(t, v6_1, 1, 9) == 0);
+    assert(lpm_add_incremental(t, v6_48, 48, 10) == 0);
+    assert(lpm_delete(t, v6_24, 24) == 0);
+    assert(lpm_update_pending(t) == 0);
+    assert(lpm_lookup_ipv6(t, a_in) == 9);
+    a_in[5] = 1;
+    assert(lpm_lookup_ipv6(t, a_in) == 10);
+    lpm_destroy(t);
+
+    printf("Incremental update tests passed!\n\n");
+}
+
+static void test_dir24_compact(void)
+{
+    printf("Testing compact DIR-24-8...\n");
+
+    enum { N = 4099 };
+    lpm_trie_t *full = lpm_create_ipv4_dir24();
+    lpm_trie_t *compact = lpm_create_ipv4_dir24_compact();
+    assert(full && compact);
+
+    srand(7);
+    for (int i = 0; i < 5000; i++) {
+        uint8_t p[4] = {(uint8_t)(rand() % 8), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        uint8_t len = (uint8_t)(8 + rand() % 25);
+        uint32_t nh = (uint32_t)(rand() % (LPM_DIR24C_MAX_NEXT_HOP + 1));
+        assert(lpm_add(full, p, len, nh) == lpm_add(compact, p, len, nh));
+        if (i % 7 == 0) {
+            assert(lpm_delete(full, p, len) == 0);
+            assert(lpm_delete(compact, p, len) == 0);
+        }
+    }
+    uint8_t dflt[4] = {0};
+    assert(lpm_add(compact, dflt, 0, 5) == 0);
+    assert(lpm_add(full, dflt, 0, 5) == 0);
+
+    /* Next hops must fit in 15 bits */
+    uint8_t p24[4] = {9, 9, 9, 0};
+    assert(lpm_add(compact, p24, 24, LPM_DIR24C_MAX_NEXT_HOP + 1) == -1);
+    assert(lpm_add(compact, p24, 24, 0) == 0);
+    assert(lpm_add(full, p24, 24, 0) == 0);
+
+    static uint32_t addrs[N], ref[N], res[N];
+    for (int i = 0; i < N; i++) {
+        addrs[i] = ((uint32_t)(rand() % 10) << 24) | ((uint32_t)rand() & 0xFFFFFF);
+    }
+    addrs[0] = 0x09090901;   /* next hop 0 */
+    addrs[1] = 0xFFFFFFFF;   /* last slot */
+
+    lpm_lookup_batch_ipv4(full, addrs, ref, N);
+    lpm_lookup_batch_ipv4(compact, addrs, res, N);
+    for (int i = 0; i < N; i++) {
+        assert(res[i] == ref[i]);
+        assert(lpm_lookup_ipv4(compact, addrs[i]) == ref[i]);
+    }
+    assert(res[0] == 0 && res[1] == 5);
+
+    uint8_t a[4] = {9, 9, 9, 200};
+    assert(lpm_lookup(compact, a) == 0);
+
+    lpm_destroy(full);
+    lpm_destroy(compact);
+    printf("Compact DIR-24-8 tests passed!\n\n");
+}
+
+/* True if the first len bits of a and p agree */
+static bool prefix_covers(const uint8_t *p, uint8_t len, const uint8_t *a)
+{
+    for (uint8_t b = 0; b < len; b++) {
+        if (((p[b / 8] ^ a[b / 8]) >> (7 - b % 8)) & 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_membership_set(void)
+{
+    printf("Testing membership sets...\n");
+
+    enum { N = 4099, R = 1500 };
+    lpm_trie_t *set4 = lpm_create_set_ipv4();
+    lpm_trie_t *set6 = lpm_create_set_ipv6();
+    assert(set4 && set6);
+
+    /* Reference: every prefix added, cleared when deleted. Deletes must leave
+     * overlapping shorter and longer prefixes covered. */
+    static uint8_t pfx[R][16], len4[R], len6[R];
+    static bool live[R];
+    srand(11);
+    for (int i = 0; i < R; i++) {
+        for (int b = 0; b < 16; b++) {
+            pfx[i][b] = (uint8_t)rand();
+        }
+        pfx[i][0] &= 3;
+        pfx[i][1] &= 7;
+        len4[i] = (uint8_t)(18 + rand() % 15);
+        len6[i] = (uint8_t)(24 + rand() % 41);
+        assert(lpm_add(set4, pfx[i], len4[i], 0) == 0);
+        assert(lpm_add(set6, pfx[i], len6[i], 0) == 0);
+        live[i] = true;
+        if (i % 3 == 0) {
+            assert(lpm_delete(set4, pfx[i], len4[i]) == 0);
+            assert(lpm_delete(set4, pfx[i], len4[i]) == -1);
+            assert(lpm_delete(set6, pfx[i], len6[i]) == 0);
+            /* Duplicates of this prefix went with it */
+            for (int j = 0; j <= i; j++) {
+                if (len4[j] == len4[i] && prefix_covers(pfx[i], len4[i], pfx[j])) {
+                    len4[j] = 0;
+                }
+                if (len6[j] == len6[i] && prefix_covers(pfx[i], len6[i], pfx[j])) {
+                    len6[j] = 0;
+                }
+            }
+            live[i] = false;
+        }
+    }
+
+    static uint32_t addrs[N];
+    static uint8_t addrs6[N][16];
+    static uint64_t mask[(N + 63) / 64];
+    for (int i = 0; i < N; i++) {
+        addrs[i] = ((uint32_t)(rand() % 4) << 24) | ((uint32_t)(rand() % 8) << 16) |
+                   ((uint32_t)rand() & 0xFFFF);
+        for (int b = 0; b < 16; b++) {
+            addrs6[i][b] = (uint8_t)rand();
+        }
+        addrs6[i][0] &= 3;
+        addrs6[i][1] &= 7;
+        addrs6[i][2] &= 1;
+    }
+    /* Addresses inside (possibly deleted) prefixes, e.g. /25-/32 blocks */
+    for (int i = 0; i < 256; i++) {
+        addrs[i * 16] = ((uint32_t)pfx[i][0] << 24) | ((uint32_t)pfx[i][1] << 16) |
+                        ((uint32_t)pfx[i][2] << 8) | pfx[i][3];
+        memcpy(addrs6[i * 16], pfx[i], 16);
+    }
+
+    size_t hits4 = lpm_contains_batch_ipv4(set4, addrs, mask, N);
+    size_t expect = 0;
+    for (int i = 0; i < N; i++) {
+        uint8_t a[4] = {(uint8_t)(addrs[i] >> 24), (uint8_t)(addrs[i] >> 16),
+                        (uint8_t)(addrs[i] >> 8), (uint8_t)addrs[i]};
+        bool in = false;
+        for (int j = 0; j < R && !in; j++) {
+            in = live[j] && len4[j] && prefix_covers(pfx[j], len4[j], a);
+        }
+        assert(lpm_contains_ipv4(set4, addrs[i]) == in);
+        assert(((mask[i / 64] >> (i % 64)) & 1) == in);
+        assert(lpm_lookup_ipv4(set4, addrs[i]) == (in ? 0 : LPM_INVALID_NEXT_HOP));
+        expect += in;
+    }
+    assert(hits4 == expect && hits4 > 0 && hits4 < N);
+
+    size_t hits6 = lpm_contains_batch_ipv6(set6, (const uint8_t (*)[16])addrs6, mask, N);
+    expect = 0;
+    for (int i = 0; i < N; i++) {
+        bool in = false;
+        for (int j = 0; j < R && !in; j++) {
+            in = live[j] && len6[j] && prefix_covers(pfx[j], len6[j], addrs6[i]);
+        }
+        assert(lpm_contains_ipv6(set6, addrs6[i]) == in);
+        assert(((mask[i / 64] >> (i % 64)) & 1) == in);
+        expect += in;
+    }
+    assert(hits6 == expect && hits6 > 0);
+
+    /* A default route covers everything */
+    uint8_t zero[16] = {0};
+    assert(lpm_add(set4, zero, 0, 0) == 0);
+    assert(lpm_contains_batch_ipv4(set4, addrs, mask, N) == N);
+    assert(lpm_contains_ipv4(set4, 0xFFFFFFFF));
+    assert(lpm_delete(set4, zero, 0) == 0);
+    assert(!lpm_contains_ipv4(set4, 0xFFFFFFFF));
+
+    lpm_destroy(set4);
+    lpm_destroy(set6);
+    printf("Membership set tests passed!\n\n");
+}
+
+static void test_expiring_prefixes(void)
+{
+    printf("Testing expiring prefixes...\n");
+
+    lpm_trie_t *v4 = lpm_create_ipv4_dir24();
+    lpm_trie_t *v6 = lpm_create_ipv6_wide16();
+    assert(v4 && v6);
+    assert(lpm_expire(v4, 1000) == 0 && lpm_ttl_count(v4) == 0);
+
+    /* 256 /32 blocks expiring at 1001..1256, one /128 at 2000 */
+    const uint64_t t0 = 1000;
+    uint8_t covering[4] = {203, 0, 113, 0};
+    assert(lpm_add(v4, covering, 24, 7) == 0);
+    for (int i = 0; i < 256; i++) {
+        uint8_t p[4] = {203, 0, 113, (uint8_t)i};
+        assert(lpm_add_ttl(v4, p, 32, 100 + (uint32_t)i, t0 + 1 + (uint64_t)i) == 0);
+    }
+    uint8_t p6[16] = {0x20, 0x01, 0x0d, 0xb8, [15] = 1};
+    assert(lpm_add_ttl(v6, p6, 128, 9, 2000) == 0);
+    assert(lpm_ttl_count(v4) == 256 && lpm_ttl_memory(v4) > 0);
+
+    /* Re-adding refreshes the expiry, lpm_add() makes it permanent, and
+     * lpm_delete() cancels it */
+    uint8_t p5[4] = {203, 0, 113, 5}, p6b[4] = {203, 0, 113, 6}, p7[4] = {203, 0, 113, 7};
+    assert(lpm_add_ttl(v4, p5, 32, 105, t0 + 1000000) == 0);
+    assert(lpm_add(v4, p6b, 32, 106) == 0);
+    assert(lpm_delete(v4, p7, 32) == 0);
+    assert(lpm_ttl_count(v4) == 254);
+
+    uint64_t gen = v4->generation;
+    assert(lpm_expire(v4, t0 + 100) == 97);     /* .0-.99 less .5, .6, .7 */
+    assert(v4->generation == gen + 1);          /* One DIR-24-8 flush */
+    assert(lpm_lookup_ipv4(v4, 0xCB007100) == 7);     /* .0 expired, /24 remains */
+    assert(lpm_lookup_ipv4(v4, 0xCB007163) == 7);     /* .99 */
+    assert(lpm_lookup_ipv4(v4, 0xCB007164) == 200);   /* .100 due at t0 + 101 */
+    assert(lpm_lookup_ipv4(v4, 0xCB007105) == 105);
+    assert(lpm_lookup_ipv4(v4, 0xCB007106) == 106);
+
+    /* A large jump expires the rest in one call; a clock going back is a no-op */
+    assert(lpm_expire(v4, t0 + 500000) == 156);
+    assert(lpm_expire(v4, t0) == 0);
+    assert(lpm_lookup_ipv4(v4, 0xCB0071FF) == 7);
+    assert(lpm_lookup_ipv4(v4, 0xCB007105) == 105);
+    assert(lpm_expire(v4, UINT64_MAX) == 1);
+    assert(lpm_lookup_ipv4(v4, 0xCB007105) == 7);
+    assert(lpm_lookup_ipv4(v4, 0xCB007106) == 106);
+    assert(lpm_ttl_count(v4) == 0);
+
+    assert(lpm_lookup_ipv6(v6, p6) == 9);
+    assert(lpm_expire(v6, 1999) == 0 && lpm_lookup_ipv6(v6, p6) == 9);
+    assert(lpm_expire(v6, 2000) == 1 && lpm_lookup_ipv6(v6, p6) == LPM_INVALID_NEXT_HOP);
+
+    lpm_destroy(v4);
+    lpm_destroy(v6);
+    printf("Expiring prefix tests passed!\n\n");
+}
+
+static uint32_t brute_lookup(const uint8_t (*pfx)[16], const uint8_t *len, const uint32_t *nh,
+                             size_t n, const uint8_t *a)
+{
+    int best = -1;
+    uint32_t out = LPM_INVALID_NEXT_HOP;
+    for (size_t i = 0; i < n; i++) {
+        if (nh[i] != LPM_INVALID_NEXT_HOP && len[i] > best && prefix_covers(pfx[i], len[i], a)) {
+            best = len[i];
+            out = nh[i];
+        }
+    }
+    return out;
+}
+
+static void test_fib_aggregation(void)
+{
+    printf("Testing FIB aggregation...\n");
+
+    /* Four sibling /24s and a nested /25 with one next hop become a /22 */
+    uint8_t pfx[6][16] = {
+        {10, 0, 0, 0}, {10, 0, 1, 0}, {10, 0, 2, 0}, {10, 0, 3, 0}, {10, 0, 0, 128}, {10, 0, 4, 0},
+    };
+    uint8_t lens[6] = {24, 24, 24, 24, 25, 24};
+    uint32_t nhs[6] = {5, 5, 5, 5, 5, 6};
+    size_t count = 6;
+    assert(lpm_aggregate(pfx, lens, nhs, &count, 32) == 0);
+    assert(count == 2);
+    lpm_trie_t *t = lpm_create_ipv4_dir24();
+    assert(t);
+    for (size_t i = 0; i < count; i++) {
+        assert(lpm_add(t, pfx[i], lens[i], nhs[i]) == 0);
+    }
+    assert(lpm_lookup_ipv4(t, 0x0A000281) == 5);
+    assert(lpm_lookup_ipv4(t, 0x0A000401) == 6);
+    assert(lpm_lookup_ipv4(t, 0x0A000501) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_enable_aggregation(t) == -1);    /* Needs an empty trie */
+    lpm_destroy(t);
+
+    /* Random adds, changes and deletes: IPv4 runs incrementally on DIR-24-8,
+     * IPv6 aggregates the live routes offline; both against brute force. The
+     * stride engines (8-bit stride, wide16) run incrementally as well: they
+     * do not keep covered prefixes, so the aggregated set must be installed
+     * in an order they can hold */
+    enum { N = 96 };
+    static uint8_t rp[N][16], rl[N];
+    static uint32_t rn[N];
+    uint8_t mp[N][16], ml[N];
+    uint32_t mn[N];
+    for (int fam = 0; fam < 2; fam++) {
+        uint8_t depth = fam ? 128 : 32;
+        t = fam ? NULL : lpm_create_ipv4_dir24();
+        assert(fam || (t && lpm_enable_aggregation(t) == 0));
+        lpm_trie_t *st = fam ? lpm_create_ipv6_wide16_levels(3) : lpm_create_ipv4_8stride();
+        assert(st && lpm_enable_aggregation(st) == 0);
+        memset(rp, 0, sizeof(rp));
+        for (int i = 0; i < N; i++) {
+            rn[i] = LPM_INVALID_NEXT_HOP;
+        }
+
+        srand(84 + (unsigned)fam);
+        for (int step = 0; step < 1500; step++) {
+            int i = rand() % N;
+            if (rn[i] != LPM_INVALID_NEXT_HOP && rand() % 3 == 0) {
+                assert(fam || lpm_delete(t, rp[i], rl[i]) == 0);
+                assert(lpm_delete(st, rp[i], rl[i]) == 0);
+                rn[i] = LPM_INVALID_NEXT_HOP;
+            } else {
+                if (rn[i] == LPM_INVALID_NEXT_HOP) {
+                    /* New route in a small window so routes nest and touch */
+                    uint8_t len = (uint8_t)(fam ? 40 + rand() % 25 : 12 + rand() % 21);
+                    memset(rp[i], 0, 16);
+                    rp[i][0] = fam ? 0x20 : 10;
+                    for (int b = 1; b < 8; b++) {
+                        rp[i][b] = (uint8_t)(b < 3 ? rand() & 3 : rand());
+                    }
+                    for (int b = len; b < 128; b++) {
+                        rp[i][b / 8] &= (uint8_t)~(0x80 >> (b % 8));
+                    }
+                    for (int j = 0; j < N; j++) {
+                        if (j != i && rn[j] != LPM_INVALID_NEXT_HOP && rl[j] == len &&
+                            prefix_covers(rp[j], len, rp[i])) {
+                            rn[j] = LPM_INVALID_NEXT_HOP;     /* Same prefix: replaced */
+                        }
+                    }
+                    rl[i] = len;
+                }
+                rn[i] = (uint32_t)(rand() % 3);
+                assert(fam || lpm_add(t, rp[i], rl[i], rn[i]) == 0);
+                assert(lpm_add(st, rp[i], rl[i], rn[i]) == 0);
+            }
+
+            if (step % 100 != 99) {
+                continue;
+            }
+            size_t live = 0;
+            for (int j = 0; j < N; j++) {
+                if (rn[j] != LPM_INVALID_NEXT_HOP) {
+                    memcpy(mp[live], rp[j], 16);
+                    ml[live] = rl[j];
+                    mn[live] = rn[j];
+                    live++;
+                }
+            }
+            size_t routes = live;
+            assert(lpm_aggregate(mp, ml, mn, &live, depth) == 0);
+            assert(live <= routes);
+            for (int k = 0; k < 500; k++) {
+                uint8_t a[16];
+                memcpy(a, rp[rand() % N], 16);
+                for (int b = fam ? 4 : 2; b < 16; b++) {
+                    a[b] ^= (uint8_t)(rand() & (k & 1 ? 0xFF : 0x0F));
+                }
+                uint32_t expect = brute_lookup(rp, rl, rn, N, a);
+                assert(brute_lookup(mp, ml, mn, live, a) == expect);
+                if (!fam) {
+                    uint32_t addr = ((uint32_t)a[0] << 24) | ((uint32_t)a[1] << 16) |
+                                    ((uint32_t)a[2] << 8) | a[3];
+                    assert(lpm_lookup_ipv4(t, addr) == expect);
+                    assert(lpm_lookup_ipv4(st, addr) == expect);
+                } else {
+                    assert(lpm_lookup_ipv6(st, a) == expect);
+                }
+            }
+
+            /* The installed set stays as small as aggregating from scratch */
+            if (!fam) {
+                assert(lpm_route_count(t) == routes);
+                assert(t->num_prefixes == live);
+            }
+            assert(lpm_route_count(st) == routes);
+        }
+        if (t) {
+            lpm_destroy(t);
+        }
+        lpm_destroy(st);
+    }
+
+    printf("FIB aggregation tests passed!\n\n");
+}
+
+/* Batch reader for the replacement epoch: every batch must see one side */
+struct replace_reader {
+    lpm_trie_t *trie;
+    const uint32_t *addrs;
+    size_t count;
+    int stop;
+    int mixed;
+    unsigned long batches;
+};
+
+static void *replace_reader_main(void *arg)
+{
+    struct replace_reader *r = arg;
+    uint32_t got[512];
+    while (!__atomic_load_n(&r->stop, __ATOMIC_ACQUIRE)) {
+        lpm_lookup_batch_ipv4(r->trie, r->addrs, got, r->count);
+        for (size_t i = 1; i < r->count; i++) {
+            if (got[i] != got[0] || (got[0] != 1 && got[0] != 2)) {
+                r->mixed = 1;
+            }
+        }
+        __atomic_fetch_add(&r->batches, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void test_replace_next_hop(void)
+{
+    printf("Testing next-hop replacement...\n");
+
+    lpm_trie_t *t = lpm_create_ipv4_dir24();
+    lpm_trie_t *t6 = lpm_create_ipv6_wide16();
+    assert(t && t6);
+    assert(lpm_enable_next_hop_index(t) == 0);
+
+    /* Peer 1 carries a /16, a /24 inside it and a /28; peer 2 a /20 between */
+    uint8_t p16[4] = {172, 16, 0, 0}, p20[4] = {172, 16, 16, 0};
+    uint8_t p24[4] = {172, 16, 17, 0}, p28[4] = {172, 16, 17, 64};
+    assert(lpm_add(t, p16, 16, 1) == 0);
+    assert(lpm_add(t, p20, 20, 2) == 0);
+    assert(lpm_add(t, p24, 24, 1) == 0);
+    assert(lpm_add(t, p28, 28, 1) == 0);
+    assert(lpm_next_hop_count(t, 1) == 3 && lpm_next_hop_count(t, 2) == 1);
+
+    assert(lpm_replace_next_hop(t, 1, 9) == 0);
+    assert(lpm_lookup_ipv4(t, 0xAC100001) == 9);     /* 172.16.0.1, /16 */
+    assert(lpm_lookup_ipv4(t, 0xAC101001) == 2);     /* 172.16.16.1, /20 untouched */
+    assert(lpm_lookup_ipv4(t, 0xAC101101) == 9);     /* 172.16.17.1, /24 */
+    assert(lpm_lookup_ipv4(t, 0xAC101141) == 9);     /* 172.16.17.65, /28 */
+    assert(lpm_next_hop_count(t, 1) == 0 && lpm_next_hop_count(t, 9) == 3);
+
+    /* Deletes fall back to the repointed covering routes */
+    assert(lpm_delete(t, p28, 28) == 0);
+    assert(lpm_delete(t, p20, 20) == 0);
+    assert(lpm_lookup_ipv4(t, 0xAC101141) == 9);
+    assert(lpm_lookup_ipv4(t, 0xAC101001) == 9);
+    assert(lpm_next_hop_count(t, 9) == 2 && lpm_next_hop_count(t, 2) == 0);
+
+    /* Merging into a next hop that is already in use */
+    assert(lpm_add(t, p20, 20, 2) == 0);
+    assert(lpm_replace_next_hop(t, 2, 9) == 0);
+    assert(lpm_lookup_ipv4(t, 0xAC101001) == 9 && lpm_next_hop_count(t, 9) == 3);
+    assert(lpm_replace_next_hop(t, 5, 6) == 0);     /* Unused: nothing to do */
+
+    /* Without the index the whole table is rewritten */
+    uint8_t a6[16] = {0x20, 0x01, 0x0d, 0xb8};
+    uint8_t b6[16] = {0x20, 0x01, 0x0d, 0xb9, 0x80};
+    assert(lpm_add(t6, a6, 32, 4) == 0);
+    assert(lpm_add(t6, b6, 40, 4) == 0);
+    assert(lpm_replace_next_hop(t6, 4, 5) == 0);
+    assert(lpm_lookup_ipv6(t6, a6) == 5 && lpm_lookup_ipv6(t6, b6) == 5);
+    assert(lpm_enable_next_hop_index(t6) == -1);    /* Needs an empty trie */
+
+    lpm_destroy(t);
+    lpm_destroy(t6);
+
+    /* Concurrent batches see all of a replacement or none of it */
+    enum { R = 512 };
+    static uint32_t raddrs[R];
+    lpm_trie_t *rt = lpm_create_ipv4_dir24();
+    assert(rt && lpm_enable_next_hop_index(rt) == 0);
+    for (uint32_t i = 0; i < R; i++) {
+        /* /24s in the first-level table and /28s in tbl8 groups */
+        uint8_t p[4] = {10, (uint8_t)(i >> 8), (uint8_t)i, (uint8_t)(i & 1 ? 16 : 0)};
+        assert(lpm_add(rt, p, i & 1 ? 28 : 24, 1) == 0);
+        raddrs[i] = 0x0A000000 | i << 8 | (i & 1 ? 17 : 1);
+    }
+
+    uint64_t seq = lpm_replace_seq(rt);
+    assert(seq % 2 == 0 && !lpm_replace_retry(rt, seq));
+    assert(lpm_replace_next_hop(rt, 1, 2) == 0);
+    assert(lpm_replace_retry(rt, seq) && lpm_replace_seq(rt) == seq + 2);
+    assert(lpm_replace_next_hop(rt, 2, 1) == 0);
+
+    struct replace_reader rr = {.trie = rt, .addrs = raddrs, .count = R};
+    pthread_t tid;
+    assert(pthread_create(&tid, NULL, replace_reader_main, &rr) == 0);
+    for (int i = 0; i < 400 || __atomic_load_n(&rr.batches, __ATOMIC_RELAXED) < 10; i++) {
+        assert(lpm_replace_next_hop(rt, i & 1 ? 2 : 1, i & 1 ? 1 : 2) == 0);
+        if (i % 50 == 0) {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&rr.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(tid, NULL);
+    assert(!rr.mixed);
+    lpm_destroy(rt);
+
+    printf("Next-hop replacement tests passed!\n\n");
+}
+
+static void test_small_table(void)
+{
+    printf("Testing small-table engine...\n");
+
+    enum { N = 1037 };
+    lpm_trie_t *ref = lpm_create_ipv4_dir24();
+    lpm_trie_t *small = lpm_create_ipv4_small();
+    assert(ref && small);
+
+    /* Nested and adjacent prefixes, deletes, overwrites and a default route */
+    srand(11);
+    for (int i = 0; i < 1500; i++) {
+        uint8_t p[4] = {(uint8_t)(rand() % 4), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        uint8_t len = (uint8_t)(8 + rand() % 25);
+        uint32_t nh = (uint32_t)(rand() % 64);
+        assert(lpm_add(ref, p, len, nh) == 0);
+        assert(lpm_add(small, p, len, nh) == 0);
+        if (i % 5 == 0) {
+            assert(lpm_delete(ref, p, len) == 0);
+            assert(lpm_delete(small, p, len) == 0);
+        }
+    }
+    uint8_t dflt[4] = {0};
+    assert(lpm_add(ref, dflt, 0, 7) == 0);
+    assert(lpm_add(small, dflt, 0, 7) == 0);
+    uint8_t top[4] = {255, 255, 255, 255};
+    assert(lpm_add(ref, top, 32, 9) == 0);
+    assert(lpm_add(small, top, 32, 9) == 0);
+
+    static uint32_t addrs[N], want[N], got[N];
+    for (int i = 0; i < N; i++) {
+        addrs[i] = ((uint32_t)(rand() % 5) << 24) | ((uint32_t)rand() & 0xFFFFFF);
+    }
+    addrs[0] = 0;
+    addrs[1] = 0xFFFFFFFF;
+    addrs[2] = 0xFFFFFFFE;
+
+    lpm_lookup_batch_ipv4(ref, addrs, want, N);
+    lpm_lookup_batch_ipv4(small, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == want[i]);
+        assert(lpm_lookup_ipv4(small, addrs[i]) == want[i]);
+    }
+    assert(got[1] == 9 && got[2] == 7);
+
+    /* Without the default route uncovered addresses miss again */
+    assert(lpm_delete(small, dflt, 0) == 0);
+    assert(lpm_delete(small, dflt, 0) == -1);
+    assert(lpm_lookup_ipv4(small, 0xFFFFFFFE) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_lookup_ipv4(small, 0xFFFFFFFF) == 9);
+
+    /* Adds beyond the cap fail */
+    lpm_trie_t *full = lpm_create_ipv4_small();
+    assert(full);
+    for (uint32_t i = 0; i < LPM_SMALL_MAX_PREFIXES; i++) {
+        uint8_t p[4] = {10, (uint8_t)(i >> 8), (uint8_t)i, 0};
+        assert(lpm_add(full, p, 24, i) == 0);
+    }
+    uint8_t extra[4] = {11, 0, 0, 0};
+    assert(lpm_add(full, extra, 8, 1) == -1);
+    assert(lpm_lookup_ipv4(full, 0x0A0F3401) == 0x0F34);
+
+    lpm_destroy(ref);
+    lpm_destroy(small);
+    lpm_destroy(full);
+    printf("Small-table engine tests passed!\n\n");
+}
+
+static void test_wide16_levels(void)
+{
+    printf("Testing wide16 with sparse 16-bit levels...\n");
+
+    assert(lpm_create_ipv6_wide16_levels(0) == NULL);
+    assert(lpm_create_ipv6_wide16_levels(LPM_IPV6_WIDE_STRIDE_MAX_LEVELS + 1) == NULL);
+
+    enum { N = 512 };
+    lpm_trie_t *t[3];
+    for (int l = 0; l < 3; l++) {
+        t[l] = lpm_create_ipv6_wide16_levels((uint8_t)(l + 1));
+        assert(t[l] != NULL);
+    }
+
+    /* A /16 > /32 > /48 > /64 chain, siblings and partial-level lengths */
+    srand(31);
+    for (int i = 0; i < 2000; i++) {
+        static const uint8_t lens[] = {16, 20, 32, 36, 44, 48, 64, 128};
+        uint8_t p[16] = {0x20, (uint8_t)(rand() % 2), 0x0d, (uint8_t)(rand() % 4),
+                         (uint8_t)(rand() % 8), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        uint8_t len = lens[rand() % 8];
+        if (len == 20 || len == 36 || len == 44) {
+            /* Partial levels, one region per length: a stride node does not
+             * keep two nested prefixes that end inside it */
+            p[0] = 0x30;
+            p[1] = len;
+        }
+        uint32_t nh = (uint32_t)(rand() % 5000);
+        for (int l = 0; l < 3; l++) {
+            assert(lpm_add(t[l], p, len, nh) == 0);
+            if (i % 7 == 0) {
+                assert(lpm_delete(t[l], p, len) == 0);
+            }
+        }
+    }
+
+    static uint8_t addrs[N][16];
+    uint32_t want[N], got[N];
+    for (int i = 0; i < N; i++) {
+        static const uint8_t second[] = {0, 1, 20, 36, 44};
+        uint8_t a[16] = {(uint8_t)(rand() % 2 ? 0x20 : 0x30), second[rand() % 5], 0x0d,
+                         (uint8_t)(rand() % 4), (uint8_t)(rand() % 8), (uint8_t)rand()};
+        for (int b = 6; b < 16; b++) {
+            a[b] = (uint8_t)rand();
+        }
+        memcpy(addrs[i], a, 16);
+    }
+    lpm_lookup_batch_ipv6(t[0], (const uint8_t (*)[16])addrs, want, N);
+    for (int l = 1; l < 3; l++) {
+        lpm_lookup_batch_ipv6(t[l], (const uint8_t (*)[16])addrs, got, N);
+        for (int i = 0; i < N; i++) {
+            assert(got[i] == want[i]);
+            assert(lpm_lookup_ipv6(t[l], addrs[i]) == want[i]);
+        }
+    }
+
+    /* A busy sparse node: every /48 of a /32, then all removed again */
+    lpm_trie_t *busy = lpm_create_ipv6_wide16_levels(3);
+    assert(busy != NULL);
+    uint8_t cover[16] = {0x20, 0x01, 0x0d, 0xb8};
+    assert(lpm_add(busy, cover, 32, 1) == 0);
+    for (uint32_t i = 0; i < 65536; i += 3) {
+        uint8_t p[16] = {0x20, 0x01, 0x0d, 0xb8, (uint8_t)(i >> 8), (uint8_t)i};
+        assert(lpm_add(busy, p, 48, 2 + i % 2) == 0);
+    }
+    uint8_t a[16] = {0x20, 0x01, 0x0d, 0xb8, 0x12, 0x33, 0x55};   /* 0x1233 = 3 * 1553 */
+    assert(lpm_lookup_ipv6(busy, a) == 3);
+    a[5] = 0x34;
+    assert(lpm_lookup_ipv6(busy, a) == 1);
+    assert(lpm_replace_next_hop(busy, 3, 9) == 0);
+    a[5] = 0x33;
+    assert(lpm_lookup_ipv6(busy, a) == 9);
+    for (uint32_t i = 0; i < 65536; i += 3) {
+        uint8_t p[16] = {0x20, 0x01, 0x0d, 0xb8, (uint8_t)(i >> 8), (uint8_t)i};
+        assert(lpm_delete(busy, p, 48) == 0);
+    }
+    assert(lpm_lookup_ipv6(busy, a) == 1);
+
+    for (int l = 0; l < 3; l++) {
+        lpm_destroy(t[l]);
+    }
+    lpm_destroy(busy);
+    printf("Wide16 sparse level tests passed!\n\n");
+}
+
+static void test_prefault(void)
+{
+    printf("Testing prefaulting...\n");
+
+    lpm_trie_t *v4 = lpm_create_ipv4_dir24();
+    lpm_trie_t *v6 = lpm_create_ipv6_wide16_levels(2);
+    lpm_trie_t *small = lpm_create_ipv4_small();
+    assert(v4 && v6 && small);
+    uint8_t p4[4] = {10, 1, 2, 128};
+    uint8_t p6[16] = {0x20, 0x01, 0x0d, 0xb8};
+    assert(lpm_add(v4, p4, 25, 4) == 0);
+    assert(lpm_add(v6, p6, 32, 6) == 0);
+    assert(lpm_add(small, p4, 25, 5) == 0);
+
+    /* Bad arguments */
+    lpm_prefault_stats_t st;
+    assert(lpm_prefault(NULL, LPM_PREFAULT_ALL, &st) == -1);
+    assert(lpm_prefault(v4, 1U << 7, &st) == -1);
+
+    /* Every step but locking must succeed; the lookup tables are covered */
+    unsigned flags = LPM_PREFAULT_POPULATE | LPM_PREFAULT_HUGEPAGES | LPM_PREFAULT_WARM;
+    assert(lpm_prefault(v4, flags, &st) == 0);
+    assert(st.bytes >= (size_t)LPM_IPV4_DIR24_SIZE * sizeof(struct lpm_dir24_entry));
+    assert(st.warm_bytes >= 256 * sizeof(struct lpm_tbl8_entry));
+    assert(st.warm_bytes < st.bytes && st.locked_bytes == 0);
+    assert(st.total_ms >= st.populate_ms && st.populate_ms >= 0.0);
+    assert(lpm_prefault(v6, flags, NULL) == 0);
+    assert(lpm_prefault(small, flags, &st) == 0 && st.warm_bytes > 0);
+
+    /* Locking may be refused by RLIMIT_MEMLOCK; either way lookups hold */
+    int rc = lpm_prefault(small, LPM_PREFAULT_LOCK, &st);
+    assert(rc == 0 ? st.locked_bytes == st.bytes : st.locked_bytes < st.bytes);
+
+    assert(lpm_lookup_ipv4(v4, 0x0A0102FF) == 4);
+    assert(lpm_lookup_ipv4(v4, 0x0A01027F) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_lookup_ipv6(v6, p6) == 6);
+    assert(lpm_lookup_ipv4(small, 0x0A0102FF) == 5);
+
+    lpm_destroy(v4);
+    lpm_destroy(v6);
+    lpm_destroy(small);
+    printf("Prefaulting tests passed!\n\n");
+}
+
+static void journal_files_remove(const char *dir, const char *path)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "%s.snap", path);
+    unlink(name);
+    snprintf(name, sizeof(name), "%s.wal", path);
+    unlink(name);
+    rmdir(dir);
+}
+
+static void test_update_journal(void)
+{
+    printf("Testing update journal and recovery...\n");
+
+    char dir[] = "/tmp/lpm_journal_XXXXXX";
+    assert(mkdtemp(dir));
+    char path[64], wal[80];
+    snprintf(path, sizeof(path), "%s/fib", dir);
+    snprintf(wal, sizeof(wal), "%s.wal", path);
+
+    /* Unsupported tries and missing files */
+    lpm_trie_t *set = lpm_create_set_ipv4();
+    assert(lpm_enable_journal(set, path, NULL) == -1);
+    lpm_destroy(set);
+    assert(lpm_recover(path, NULL, NULL) == NULL);
+
+    /* Routes before the journal land in the first snapshot */
+    lpm_trie_t *fib = lpm_create_ipv4_dir24();
+    uint8_t p8[4] = {10, 0, 0, 0}, p24[4] = {10, 1, 2, 0}, p28[4] = {10, 1, 2, 16};
+    assert(lpm_add(fib, p8, 8, 1) == 0);
+    lpm_journal_config_t cfg = { .sync_records = 8, .sync_us = 0, .snapshot_records = 0 };
+    assert(lpm_enable_journal(fib, path, &cfg) == 0);
+    assert(lpm_enable_journal(fib, path, &cfg) == -1);
+    assert(lpm_add_ttl(fib, p24, 24, 9, 100) == -1);
+
+    srand(17);
+    for (int i = 0; i < 300; i++) {
+        uint8_t p[4] = {10, (uint8_t)(rand() % 8), (uint8_t)rand(), (uint8_t)rand()};
+        assert(lpm_add(fib, p, (uint8_t)(16 + rand() % 17), (uint32_t)(2 + rand() % 8)) == 0);
+    }
+    assert(lpm_snapshot(fib) == 0);
+    assert(lpm_add(fib, p24, 24, 20) == 0);
+    assert(lpm_add_incremental(fib, p28, 28, 21) == 0);
+    assert(lpm_replace_next_hop(fib, 3, 30) == 0);
+    assert(lpm_delete(fib, p8, 8) == 0);
+    assert(lpm_journal_sync(fib) == 0);
+
+    /* Recovery: the snapshot plus the four records after it */
+    lpm_recover_stats_t st;
+    lpm_trie_t *back = lpm_recover(path, &cfg, &st);
+    assert(back);
+    assert(st.snapshot_lsn == 300 && st.replayed == 4 && st.failed == 0 && st.truncated_bytes == 0);
+    assert(back->num_prefixes == fib->num_prefixes);
+    for (uint32_t a = 0x0A000000; a < 0x0A080000; a += 97) {
+        assert(lpm_lookup_ipv4(back, a) == lpm_lookup_ipv4(fib, a));
+    }
+    assert(lpm_lookup_ipv4(back, 0x0A010211) == 21);
+    assert(lpm_lookup_ipv4(back, 0x0A090000) == LPM_INVALID_NEXT_HOP);
+
+    /* The recovered trie keeps journaling; a torn tail is dropped */
+    assert(lpm_add(back, p8, 8, 40) == 0);
+    lpm_destroy(back);
+    lpm_destroy(fib);
+    FILE *f = fopen(wal, "ab");
+    assert(f);
+    const uint8_t torn[12] = {200, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8};
+    assert(fwrite(torn, 1, sizeof(torn), f) == sizeof(torn));
+    fclose(f);
+    back = lpm_recover(path, NULL, &st);
+    assert(back);
+    assert(st.replayed == 5 && st.truncated_bytes == sizeof(torn));
+    assert(lpm_lookup_ipv4(back, 0x0A090000) == 40);
+    lpm_destroy(back);
+    journal_files_remove(dir, path);
+
+    /* IPv6 wide16 with sparse levels */
+    assert(mkdtemp(strcpy(dir, "/tmp/lpm_journal_XXXXXX")));
+    snprintf(path, sizeof(path), "%s/fib6", dir);
+    lpm_trie_t *fib6 = lpm_create_ipv6_wide16_levels(3);
+    assert(lpm_enable_journal(fib6, path, NULL) == 0);
+    for (int i = 0; i < 200; i++) {
+        uint8_t p[16] = {0x20, 0x01, (uint8_t)(i % 4), (uint8_t)i, (uint8_t)(i * 7)};
+        assert(lpm_add(fib6, p, i % 2 ? 32 : 48, (uint32_t)i) == 0);
+    }
+    assert(lpm_journal_sync(fib6) == 0);
+    back = lpm_recover(path, NULL, &st);
+    assert(back && st.snapshot_lsn == 0 && st.replayed == 200);
+    for (int i = 0; i < 200; i++) {
+        uint8_t a[16] = {0x20, 0x01, (uint8_t)(i % 4), (uint8_t)i, (uint8_t)(i * 7), 9};
+        assert(lpm_lookup_ipv6(back, a) == lpm_lookup_ipv6(fib6, a));
+    }
+    lpm_destroy(back);
+    lpm_destroy(fib6);
+    journal_files_remove(dir, path);
+
+    /* Updates never snapshot; an idle tail is committed by lpm_update_step()
+     * and the due snapshot is taken by lpm_journal_poll() */
+    assert(mkdtemp(strcpy(dir, "/tmp/lpm_journal_XXXXXX")));
+    snprintf(path, sizeof(path), "%s/lazy", dir);
+    lpm_journal_config_t lazy = { .sync_records = 0, .sync_us = 1000, .snapshot_records = 4 };
+    fib = lpm_create_ipv4_dir24();
+    assert(lpm_enable_journal(fib, path, &lazy) == 0);
+    for (int i = 0; i < 6; i++) {
+        uint8_t p[4] = {10, (uint8_t)i, 0, 0};
+        assert(lpm_add(fib, p, 16, (uint32_t)i + 1) == 0);
+    }
+    usleep(2000);
+    assert(lpm_update_step(fib, 0) == 0);
+    back = lpm_recover(path, &lazy, &st);
+    assert(back && st.snapshot_lsn == 0 && st.replayed == 6);
+    lpm_destroy(back);
+    assert(lpm_journal_poll(fib) == 1);
+    assert(lpm_journal_poll(fib) == 0);
+    back = lpm_recover(path, &lazy, &st);
+    assert(back && st.snapshot_lsn == 6 && st.replayed == 0);
+    assert(lpm_lookup_ipv4(back, 0x0A050000) == 6);
+    assert(lpm_journal_poll(NULL) == -1);
+    lpm_destroy(back);
+    lpm_destroy(fib);
+    journal_files_remove(dir, path);
+    printf("Update journal tests passed!\n\n");
+}
+
+struct shard_route {
+    uint32_t addr;
+    uint8_t len;
+};
+
+struct shard_writer {
+    lpm_trie_t *trie;
+    const struct shard_route *routes;
+    size_t count;
+    unsigned index;
+    unsigned stride;
+    int failed;
+};
+
+static int shard_route_cmp(const void *a, const void *b)
+{
+    const struct shard_route *x = a, *y = b;
+    if (x->addr != y->addr) { return x->addr < y->addr ? -1 : 1; }
+    return (int)x->len - (int)y->len;
+}
+
+static uint32_t shard_route_nh(const struct shard_route *r)
+{
+    return (r->addr >> 8 ^ r->len * 7919U) % 1000;
+}
+
+static void shard_route_bytes(const struct shard_route *r, uint8_t p[4])
+{
+    p[0] = (uint8_t)(r->addr >> 24);
+    p[1] = (uint8_t)(r->addr >> 16);
+    p[2] = (uint8_t)(r->addr >> 8);
+    p[3] = (uint8_t)r->addr;
+}
+
+/* Add this writer's routes, then delete every fifth of them */
+static void *shard_writer_main(void *arg)
+{
+    struct shard_writer *w = arg;
+    uint8_t p[4];
+    for (size_t i = w->index; i < w->count; i += w->stride) {
+        shard_route_bytes(&w->routes[i], p);
+        w->failed |= lpm_add(w->trie, p, w->routes[i].len, shard_route_nh(&w->routes[i]));
+    }
+    for (size_t i = w->index; i < w->count; i += w->stride) {
+        if (i % 5 == 0) {
+            shard_route_bytes(&w->routes[i], p);
+            w->failed |= lpm_delete(w->trie, p, w->routes[i].len);
+        }
+    }
+    return NULL;
+}
+
+static void test_sharded_writers(void)
+{
+    printf("Testing sharded writers...\n");
+
+    /* Distinct routes, many longer than /24 so the tbl8 arrays grow while
+     * writers run; a few shorter than any shard lock every shard. Mostly /16
+     * and longer, which keeps the expansions (and the test) short */
+    size_t count = 24000;
+    struct shard_route *routes = malloc(count * sizeof(*routes));
+    assert(routes);
+    srand(91);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t len = i % 4000 == 0 ? (uint8_t)(1 + rand() % 7)
+                    : i % 20 == 0   ? (uint8_t)(8 + rand() % 8)
+                                    : (uint8_t)(16 + rand() % 17);
+        uint32_t addr = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        routes[i].len = len;
+        routes[i].addr = addr & (~0U << (32 - len));
+    }
+    qsort(routes, count, sizeof(*routes), shard_route_cmp);
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (n == 0 || shard_route_cmp(&routes[n - 1], &routes[i]) != 0) {
+            routes[n++] = routes[i];
+        }
+    }
+    count = n;
+
+    /* Reference: the same updates from one thread */
+    lpm_trie_t *ref = lpm_create_ipv4_dir24();
+    uint8_t p[4];
+    for (size_t i = 0; i < count; i++) {
+        shard_route_bytes(&routes[i], p);
+        assert(lpm_add(ref, p, routes[i].len, shard_route_nh(&routes[i])) == 0);
+    }
+    for (size_t i = 0; i < count; i += 5) {
+        shard_route_bytes(&routes[i], p);
+        assert(lpm_delete(ref, p, routes[i].len) == 0);
+    }
+
+    static const unsigned bits[] = {3, 8};
+    for (int v = 0; v < 2; v++) {
+        lpm_trie_t *sh = v == 0 ? lpm_create_ipv4_dir24_compact() : lpm_create_ipv4_dir24();
+        uint8_t net[4] = {192, 168, 0, 0};
+        assert(lpm_add(sh, net, 16, 5) == 0);   /* Moves into its shard */
+        assert(lpm_enable_sharded_writers(sh, bits[v]) == 0);
+        assert(lpm_enable_sharded_writers(sh, bits[v]) == 0);
+        assert(lpm_enable_sharded_writers(sh, 4) == -1);
+        assert(lpm_enable_next_hop_index(sh) == -1);
+        assert(lpm_enable_journal(sh, "/tmp/lpm_shard_never", NULL) == -1);
+        assert(lpm_delete(sh, net, 16) == 0);
+
+        struct shard_writer w[4];
+        pthread_t tids[4];
+        for (unsigned t = 0; t < 4; t++) {
+            w[t] = (struct shard_writer){ .trie = sh, .routes = routes, .count = count,
+                                          .index = t, .stride = 4 };
+            assert(pthread_create(&tids[t], NULL, shard_writer_main, &w[t]) == 0);
+        }
+        for (unsigned t = 0; t < 4; t++) {
+            pthread_join(tids[t], NULL);
+            assert(w[t].failed == 0);
+        }
+
+        assert(sh->num_prefixes == ref->num_prefixes);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t a = routes[i].addr | ((uint32_t)rand() & ~(~0U << (32 - routes[i].len)));
+            assert(lpm_lookup_ipv4(sh, a) == lpm_lookup_ipv4(ref, a));
+        }
+        for (int i = 0; i < 100000; i++) {
+            uint32_t a = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+            assert(lpm_lookup_ipv4(sh, a) == lpm_lookup_ipv4(ref, a));
+        }
+
+        /* Next-hop replacement and incremental updates still work; the
+         * reference follows on the last pass */
+        lpm_trie_t *ref2 = v == 1 ? ref : NULL;
+        assert(lpm_replace_next_hop(sh, shard_route_nh(&routes[1]), 1000) == 0);
+        if (ref2) {
+            assert(lpm_replace_next_hop(ref2, shard_route_nh(&routes[1]), 1000) == 0);
+        }
+        assert(lpm_add_incremental(sh, net, 16, 6) == 0);
+        assert(lpm_update_pending(sh) == 0);
+        assert(lpm_lookup_ipv4(sh, 0xC0A80101) == 6 || lpm_lookup_ipv4(sh, 0xC0A80101) == 1000);
+        uint8_t shorter[4] = {192, 168, 1, 0};
+        assert(lpm_add(sh, shorter, 24, 7) == 0);
+        assert(lpm_lookup_ipv4(sh, 0xC0A80101) == 7);
+        assert(lpm_delete(sh, shorter, 24) == 0);
+        if (ref2) {
+            assert(lpm_add(ref2, net, 16, 6) == 0);
+            for (int i = 0; i < 100000; i++) {
+                uint32_t a = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+                assert(lpm_lookup_ipv4(sh, a) == lpm_lookup_ipv4(ref2, a));
+            }
+            assert(lpm_delete(ref2, net, 16) == 0);
+        }
+        lpm_destroy(sh);
+    }
+
+    /* The bulk loader splits its insert pass by shard */
+    char path[] = "/tmp/lpm_shard_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE *f = fdopen(fd, "w");
+    for (size_t i = 0; i < count; i++) {
+        uint32_t a = routes[i].addr;
+        fprintf(f, "%u.%u.%u.%u/%u %u\n", a >> 24, (a >> 16) & 0xFF, (a >> 8) & 0xFF, a & 0xFF,
+                routes[i].len, shard_route_nh(&routes[i]));
+    }
+    fclose(f);
+    lpm_trie_t *one = lpm_create_ipv4_dir24();
+    lpm_trie_t *many = lpm_create_ipv4_dir24();
+    assert(lpm_enable_sharded_writers(many, 8) == 0);
+    lpm_load_stats_t st;
+    assert(lpm_load_prefix_file(one, path, 1, &st) == 0);
+    assert(lpm_load_prefix_file(many, path, 4, &st) == 0);
+    assert(st.threads > 1 && st.loaded == count && many->num_prefixes == count);
+    for (int i = 0; i < 100000; i++) {
+        uint32_t a = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        assert(lpm_lookup_ipv4(many, a) == lpm_lookup_ipv4(one, a));
+    }
+    lpm_destroy(one);
+    lpm_destroy(many);
+    unlink(path);
+
+    /* Other engines keep a single writer */
+    lpm_trie_t *stride = lpm_create_ipv4_8stride();
+    assert(lpm_enable_sharded_writers(stride, 8) == -1);
+    lpm_destroy(stride);
+    lpm_trie_t *bad = lpm_create_ipv4_dir24();
+    assert(lpm_enable_sharded_writers(bad, 0) == -1);
+    assert(lpm_enable_sharded_writers(bad, 9) == -1);
+    lpm_destroy(bad);
+
+    lpm_destroy(ref);
+    free(routes);
+    printf("Sharded writer tests passed!\n\n");
+}
+
+/* Blocks the writer in its first callback until opened */
+struct async_gate {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool entered;
+    bool open;
+    unsigned calls;
+    uint64_t seq;
+};
+
+static void async_gate_cb(void *ctx, uint64_t seq)
+{
+    struct async_gate *g = ctx;
+    pthread_mutex_lock(&g->lock);
+    g->calls++;
+    g->seq = seq;
+    g->entered = true;
+    pthread_cond_broadcast(&g->cond);
+    while (!g->open) {
+        pthread_cond_wait(&g->cond, &g->lock);
+    }
+    pthread_mutex_unlock(&g->lock);
+}
+
+struct async_producer {
+    lpm_trie_t *trie;
+    unsigned index;
+    unsigned stride;
+    uint32_t count;
+    uint64_t last;
+    int failed;
+};
+
+/* Per /24 key: two adds, every third deleted again, every fifth with a
+ * /28 added and removed inside it */
+static void *async_producer_main(void *arg)
+{
+    struct async_producer *w = arg;
+    for (uint32_t i = w->index; i < w->count; i += w->stride) {
+        uint32_t a = 0x0A000000 + (i << 8);
+        uint8_t p[4] = {(uint8_t)(a >> 24), (uint8_t)(a >> 16), (uint8_t)(a >> 8), 0};
+        uint64_t s[5] = {0};
+        int n = 0;
+        s[n++] = lpm_add_async(w->trie, p, 24, i % 1000);
+        s[n++] = lpm_add_async(w->trie, p, 24, i % 1000 + 1);
+        if (i % 3 == 0) {
+            s[n++] = lpm_delete_async(w->trie, p, 24);
+        }
+        if (i % 5 == 0) {
+            p[3] = 0x10;
+            s[n++] = lpm_add_async(w->trie, p, 28, 7);
+            s[n++] = lpm_delete_async(w->trie, p, 28);
+        }
+        for (int k = 0; k < n; k++) {
+            w->failed |= s[k] <= w->last;
+            w->last = s[k];
+        }
+    }
+    return NULL;
+}
+
+static void test_async_updates(void)
+{
+    printf("Testing asynchronous updates...\n");
+
+    /* Coalescing: hold the writer after its first batch so the next one
+     * holds everything enqueued meanwhile */
+    struct async_gate g = { .entered = false, .open = false };
+    pthread_mutex_init(&g.lock, NULL);
+    pthread_cond_init(&g.cond, NULL);
+    lpm_trie_t *trie = lpm_create_ipv4_dir24();
+    uint8_t p10[4] = {10, 0, 0, 0}, p1[4] = {1, 0, 0, 0}, x[4] = {20, 0, 0, 0};
+    uint8_t y[4] = {30, 0, 0, 0}, z[4] = {40, 1, 2, 0}, w[4] = {50, 0, 0, 0};
+    assert(lpm_add(trie, p10, 8, 1) == 0);
+
+    lpm_async_config_t cfg = { .queue_size = 1000 };
+    assert(lpm_enable_async_updates(trie, &cfg) == -1);
+    cfg = (lpm_async_config_t){ .queue_size = 64, .batch_size = 128 };
+    assert(lpm_enable_async_updates(trie, &cfg) == -1);
+    cfg = (lpm_async_config_t){ .queue_size = 1024, .batch_size = 256,
+                                .on_applied = async_gate_cb, .ctx = &g };
+    assert(lpm_enable_async_updates(trie, &cfg) == 0);
+    assert(lpm_enable_async_updates(trie, &cfg) == -1);
+    assert(lpm_enable_next_hop_index(trie) == -1);
+    assert(lpm_enable_journal(trie, "/tmp/lpm_async_never", NULL) == -1);
+    assert(lpm_enable_sharded_writers(trie, 8) == -1);
+    assert(lpm_add_async(trie, p1, 33, 1) == 0);
+
+    assert(lpm_add_async(trie, p1, 8, 9) == 1);
+    pthread_mutex_lock(&g.lock);
+    while (!g.entered) {
+        pthread_cond_wait(&g.cond, &g.lock);
+    }
+    pthread_mutex_unlock(&g.lock);
+    assert(lpm_async_applied(trie) == 1);
+    assert(lpm_lookup_ipv4(trie, 0x01020304) == 9);
+
+    assert(lpm_add_async(trie, x, 16, 1) == 2);     /* Superseded */
+    assert(lpm_add_async(trie, x, 16, 2) == 3);     /* Superseded */
+    assert(lpm_delete_async(trie, x, 16) == 4);     /* Cancels the adds */
+    assert(lpm_add_async(trie, y, 24, 3) == 5);     /* Superseded */
+    assert(lpm_add_async(trie, y, 24, 4) == 6);
+    assert(lpm_delete_async(trie, p10, 8) == 7);    /* Installed before */
+    assert(lpm_add_async(trie, z, 25, 5) == 8);     /* Superseded */
+    assert(lpm_delete_async(trie, z, 25) == 9);     /* Cancels the add */
+    assert(lpm_delete_async(trie, w, 8) == 10);     /* Not installed: fails */
+    assert(lpm_async_applied(trie) == 1);
+    assert(lpm_async_wait(trie, 11) == -1);
+
+    pthread_mutex_lock(&g.lock);
+    g.open = true;
+    pthread_cond_broadcast(&g.cond);
+    pthread_mutex_unlock(&g.lock);
+    assert(lpm_async_wait(trie, 10) == 0);
+    assert(lpm_async_applied(trie) == 10);
+    pthread_mutex_lock(&g.lock);
+    assert(g.calls == 2 && g.seq == 10);
+    pthread_mutex_unlock(&g.lock);
+
+    assert(lpm_lookup_ipv4(trie, 0x01020304) == 9);
+    assert(lpm_lookup_ipv4(trie, 0x14000101) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_lookup_ipv4(trie, 0x1E000001) == 4);
+    assert(lpm_lookup_ipv4(trie, 0x0A010101) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_lookup_ipv4(trie, 0x28010201) == LPM_INVALID_NEXT_HOP);
+
+    lpm_async_stats_t st;
+    assert(lpm_async_stats(trie, &st) == 0);
+    assert(st.enqueued == 10 && st.applied == 10 && st.depth == 0);
+    assert(st.coalesced == 6 && st.failed == 1 && st.batches == 2);
+    assert(st.max_depth >= 9);
+    assert(st.latency_max_us > 0 && st.latency_avg_us <= st.latency_max_us);
+    lpm_destroy(trie);
+    pthread_cond_destroy(&g.cond);
+    pthread_mutex_destroy(&g.lock);
+
+    /* Several producers, on DIR-24-8 with the default queue and on the
+     * stride trie with a queue small enough to fill up */
+    uint32_t count = 20000;
+    lpm_trie_t *ref = lpm_create_ipv4_8stride();
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = 0x0A000000 + (i << 8);
+        uint8_t p[4] = {(uint8_t)(a >> 24), (uint8_t)(a >> 16), (uint8_t)(a >> 8), 0};
+        if (i % 3) {
+            assert(lpm_add(ref, p, 24, i % 1000 + 1) == 0);
+        }
+    }
+    for (int v = 0; v < 2; v++) {
+        lpm_trie_t *t = v == 0 ? lpm_create_ipv4_dir24() : lpm_create_ipv4_8stride();
+        cfg = (lpm_async_config_t){ .queue_size = v == 0 ? 0 : 64, .batch_size = v == 0 ? 0 : 16 };
+        assert(lpm_enable_async_updates(t, &cfg) == 0);
+
+        struct async_producer prod[4];
+        pthread_t tids[4];
+        for (unsigned k = 0; k < 4; k++) {
+            prod[k] = (struct async_producer){ .trie = t, .index = k, .stride = 4, .count = count };
+            assert(pthread_create(&tids[k], NULL, async_producer_main, &prod[k]) == 0);
+        }
+        uint64_t last = 0;
+        for (unsigned k = 0; k < 4; k++) {
+            pthread_join(tids[k], NULL);
+            assert(prod[k].failed == 0);
+            last = prod[k].last > last ? prod[k].last : last;
+        }
+        assert(lpm_async_wait(t, last) == 0);
+
+        assert(lpm_async_stats(t, &st) == 0);
+        assert(st.applied == last && st.enqueued == last && st.failed == 0);
+        if (v == 0) {
+            assert(t->num_prefixes == ref->num_prefixes);   /* Stride tries count re-adds */
+        }
+        for (int i = 0; i < 200000; i++) {
+            uint32_t a = 0x0A000000 + ((uint32_t)rand() % (count << 8));
+            assert(lpm_lookup_ipv4(t, a) == lpm_lookup_ipv4(ref, a));
+        }
+
+        /* lpm_destroy() applies what is still queued */
+        uint8_t q[4] = {172, 16, 0, 0};
+        for (int i = 0; i < 1000; i++) {
+            q[2] = (uint8_t)i;
+            assert(lpm_add_async(t, q, 24, 1) != 0);
+        }
+        lpm_destroy(t);
+    }
+    lpm_destroy(ref);
+
+    /* Without a writer nothing is accepted */
+    lpm_trie_t *plain = lpm_create_ipv4_dir24();
+    assert(lpm_add_async(plain, p1, 8, 1) == 0);
+    assert(lpm_delete_async(plain, p1, 8) == 0);
+    assert(lpm_async_wait(plain, 1) == -1);
+    assert(lpm_async_applied(plain) == 0);
+    assert(lpm_async_stats(plain, &st) == -1);
+    lpm_destroy(plain);
+
+    printf("Asynchronous update tests passed!\n\n");
+}
+
+/* Random address inside one of the prefixes, or anywhere */
+static void range_cache_addr(const uint8_t (*prefixes)[16], const uint8_t *lens, size_t n,
+                             unsigned bytes, uint8_t *out)
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)rand();
+    }
+    if (rand() % 8 == 0) { return; }
+    size_t k = (size_t)rand() % n;
+    for (unsigned b = 0; b < lens[k]; b++) {
+        uint8_t bit = (uint8_t)(0x80 >> (b % 8));
+        out[b / 8] = (uint8_t)((out[b / 8] & ~bit) | (prefixes[k][b / 8] & bit));
+    }
+}
+
+static void test_range_cache(void)
+{
+    printf("Testing range cache...\n");
+
+    /* One miss serves the whole range the walk stopped in */
+    lpm_trie_t *t6 = lpm_create_ipv6_8stride();
+    uint8_t p32[16] = {0x20, 0x01, 0x0d, 0xb8};
+    uint8_t p48[16] = {0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01};
+    uint8_t p64[16] = {0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01, 0x00, 0x02};
+    assert(lpm_add(t6, p32, 32, 1) == 0);
+    assert(lpm_add(t6, p48, 48, 2) == 0);
+    assert(lpm_add(t6, p64, 64, 3) == 0);
+    lpm_range_cache_t *c = lpm_range_cache_create(t6, 0);
+    assert(c);
+
+    uint8_t a[16];
+    memcpy(a, p64, 16);
+    for (int i = 0; i < 1000; i++) {
+        for (int b = 8; b < 16; b++) {
+            a[b] = (uint8_t)rand();
+        }
+        assert(lpm_lookup_ipv6_cached(c, a) == 3);
+    }
+    lpm_range_cache_stats_t st;
+    assert(lpm_range_cache_stats(c, &st) == 0);
+    assert(st.misses == 1 && st.hits == 999 && st.spans == 1);
+
+    /* Outside the /64 but inside the /48, the range is a /56 */
+    memcpy(a, p48, 16);
+    a[6] = 0x01;
+    assert(lpm_lookup_ipv6_cached(c, a) == 2);
+    a[7] = 0x77;
+    a[15] = 0x01;
+    assert(lpm_lookup_ipv6_cached(c, a) == 2);
+    assert(lpm_range_cache_stats(c, &st) == 0);
+    assert(st.misses == 2 && st.hits == 1000 && st.spans == 2);
+
+    /* An update makes the old ranges miss */
+    uint8_t p65[16] = {0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01, 0x00, 0x02, 0x80};
+    assert(lpm_add(t6, p65, 65, 4) == 0);
+    memcpy(a, p64, 16);
+    a[8] = 0x90;
+    assert(lpm_lookup_ipv6_cached(c, a) == 4);
+    a[8] = 0x10;
+    assert(lpm_lookup_ipv6_cached(c, a) == 3);
+    assert(lpm_delete(t6, p65, 65) == 0);
+    a[8] = 0x90;
+    assert(lpm_lookup_ipv6_cached(c, a) == 3);
+    assert(lpm_replace_next_hop(t6, 3, 30) == 0);
+    assert(lpm_lookup_ipv6_cached(c, a) == 30);
+    assert(lpm_range_cache_stats(c, &st) == 0);
+    assert(st.invalidations == 3);
+    assert(lpm_lookup_ipv4_cached(c, 0x0A000001) == LPM_INVALID_NEXT_HOP);
+    lpm_range_cache_destroy(c);
+    lpm_destroy(t6);
+
+    /* Cached and uncached lookups agree on every engine while routes come
+     * and go; addresses cluster inside the routes */
+    size_t n = 3000;
+    uint8_t (*prefixes)[16] = calloc(n, sizeof(*prefixes));
+    uint8_t *lens = malloc(n);
+    assert(prefixes && lens);
+    for (int v = 0; v < 8; v++) {
+        lpm_trie_t *t = v == 0 ? lpm_create_ipv6_8stride()
+                      : v == 1 ? lpm_create_ipv6_wide16()
+                      : v == 2 ? lpm_create_ipv6_wide16_levels(3)
+                      : v == 3 ? lpm_create_ipv4_dir24()
+                      : v == 4 ? lpm_create_ipv4_dir24_compact()
+                      : v == 5 ? lpm_create_ipv4_8stride()
+                      : v == 6 ? lpm_create_ipv4_small()
+                      : lpm_create_adaptive(LPM_IPV6_MAX_DEPTH, NULL);
+        assert(t);
+        bool v6 = t->max_depth == LPM_IPV6_MAX_DEPTH;
+        unsigned bytes = v6 ? 16 : 4;
+        for (size_t i = 0; i < n; i++) {
+            lens[i] = v6 ? (uint8_t)(16 + rand() % 113) : (uint8_t)(8 + rand() % 25);
+            for (unsigned b = 0; b < bytes; b++) {
+                prefixes[i][b] = (uint8_t)rand();
+            }
+            if (i % 3 && i >= 3) {
+                memcpy(prefixes[i], prefixes[i - 3], lens[i] / 16);   /* Nest some */
+            }
+        }
+
+        lpm_range_cache_t *rc = lpm_range_cache_create(t, 1024);
+        assert(rc);
+        for (int round = 0; round < 4; round++) {
+            for (size_t i = (size_t)round; i < n; i += 2) {
+                if (round % 2 && i % 4 == 1) {
+                    lpm_delete(t, prefixes[i], lens[i]);
+                } else {
+                    assert(lpm_add(t, prefixes[i], lens[i], (uint32_t)(i * 3 + round) % 30000) == 0);
+                }
+            }
+            for (int i = 0; i < 10000; i++) {
+                range_cache_addr(prefixes, lens, n, bytes, a);
+                if (v6) {
+                    assert(lpm_lookup_ipv6_cached(rc, a) == lpm_lookup_ipv6(t, a));
+                } else {
+                    uint32_t x = ((uint32_t)a[0] << 24) | ((uint32_t)a[1] << 16) |
+                                 ((uint32_t)a[2] << 8) | a[3];
+                    assert(lpm_lookup_ipv4_cached(rc, x) == lpm_lookup_ipv4(t, x));
+                }
+            }
+        }
+        assert(lpm_range_cache_stats(rc, &st) == 0);
+        assert(st.hits > 0 && st.misses > 0);
+        lpm_range_cache_destroy(rc);
+        lpm_destroy(t);
+    }
+    free(lens);
+    free(prefixes);
+
+    assert(lpm_range_cache_create(NULL, 0) == NULL);
+    lpm_trie_t *t4 = lpm_create_ipv4_dir24();
+    assert(lpm_range_cache_create(t4, (1U << 24) + 1) == NULL);
+    lpm_destroy(t4);
+    assert(lpm_lookup_ipv6_cached(NULL, p32) == LPM_INVALID_NEXT_HOP);
+    assert(lpm_range_cache_stats(NULL, &st) == -1);
+
+    printf("Range cache tests passed!\n\n");
+}
+
+static void test_adaptive_table(void)
+{
+    printf("Testing adaptive tables...\n");
+
+    enum { N = 1000 };
+    lpm_adaptive_config_t cfg = { .small_max = 64, .stride_max = 512, .hot_lookups = 0 };
+    lpm_trie_t *ref = lpm_create_ipv4_dir24();
+    lpm_trie_t *t = lpm_create_adaptive(LPM_IPV4_MAX_DEPTH, &cfg);
+    assert(ref && t);
+    assert(strcmp(lpm_adaptive_engine(t), "small") == 0);
+    assert(lpm_adaptive_engine(ref) == NULL);
+
+    /* Nested prefixes, so the stride tier has to keep same-node overlaps */
+    static uint8_t pfx[N][4];
+    static uint8_t lens[N];
+    static uint32_t addrs[N], want[N], got[N];
+    srand(23);
+    for (int i = 0; i < N; i++) {
+        uint8_t p[4] = {(uint8_t)(rand() % 3), (uint8_t)(rand() % 8), (uint8_t)rand(), (uint8_t)rand()};
+        memcpy(pfx[i], p, 4);
+        lens[i] = (uint8_t)(i % 20 ? 8 + rand() % 25 : 1 + rand() % 32);
+        uint32_t nh = (uint32_t)(1 + rand() % 1000);
+        assert(lpm_add(ref, p, lens[i], nh) == 0);
+        assert(lpm_add(t, p, lens[i], nh) == 0);
+        if (i == 200) {
+            /* Past small_max: a stride engine is built in the background */
+            assert(lpm_adaptive_wait(t) == 0);
+            assert(strcmp(lpm_adaptive_engine(t), "stride8") == 0);
+        }
+    }
+    assert(lpm_adaptive_wait(t) == 0);
+    assert(strcmp(lpm_adaptive_engine(t), "dir24") == 0);
+    assert(lpm_adaptive_migrations(t) == 2);
+
+    for (int i = 0; i < N; i++) {
+        addrs[i] = ((uint32_t)(rand() % 3) << 24) | ((uint32_t)rand() & 0x7FFFFF);
+    }
+    lpm_lookup_batch_ipv4(ref, addrs, want, N);
+    lpm_lookup_batch_ipv4(t, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == want[i]);
+        assert(lpm_lookup_ipv4(t, addrs[i]) == want[i]);
+    }
+    lpm_adaptive_reclaim(t);
+
+    /* Shrinking below half the thresholds moves back down */
+    for (int i = 0; i < N - 20; i++) {
+        int a = lpm_delete(ref, pfx[i], lens[i]);
+        assert(lpm_delete(t, pfx[i], lens[i]) == a);
+        if (i % 100 == 0) {
+            lpm_adaptive_poll(t);
+        }
+    }
+    /* Each poll lands one step down and starts the next */
+    while (lpm_adaptive_poll(t) == 1) {
+        assert(lpm_adaptive_wait(t) == 0);
+    }
+    assert(strcmp(lpm_adaptive_engine(t), "small") == 0);
+    assert(lpm_adaptive_migrations(t) == 4);
+    assert(lpm_route_count(t) == lpm_route_count(ref));
+    lpm_lookup_batch_ipv4(ref, addrs, want, N);
+    lpm_lookup_batch_ipv4(t, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == want[i]);
+    }
+
+    /* IPv6 promotes from the 8-bit stride engine to wide16 */
+    lpm_trie_t *t6 = lpm_create_adaptive(LPM_IPV6_MAX_DEPTH, &cfg);
+    assert(t6 && strcmp(lpm_adaptive_engine(t6), "stride8") == 0);
+    for (int i = 0; i < 600; i++) {
+        uint8_t p[16] = {0x20, 0x01, 0x0d, 0xb8, (uint8_t)(i >> 8), (uint8_t)i};
+        assert(lpm_add(t6, p, 48, (uint32_t)i + 1) == 0);
+    }
+    uint8_t p6[16] = {0x20, 0x01, 0x0d, 0xb8};
+    assert(lpm_add(t6, p6, 32, 5000) == 0);
+    assert(lpm_adaptive_wait(t6) == 0);
+    assert(strcmp(lpm_adaptive_engine(t6), "wide16") == 0);
+    uint8_t a6[16] = {0x20, 0x01, 0x0d, 0xb8, 0x01, 0x02, 0xff};
+    assert(lpm_lookup_ipv6(t6, a6) == 0x0102 + 1);
+    a6[4] = 0x7f;
+    assert(lpm_lookup_ipv6(t6, a6) == 5000);
+
+    /* Invalid configurations and next hops DIR-24-8 cannot hold */
+    lpm_adaptive_config_t bad = { .small_max = 512, .stride_max = 256 };
+    assert(lpm_create_adaptive(LPM_IPV4_MAX_DEPTH, &bad) == NULL);
+    assert(lpm_create_adaptive(64, NULL) == NULL);
+    assert(lpm_add(t, pfx[0], 8, LPM_DIR24_NH_MASK + 1) == -1);
+
+    lpm_destroy(ref);
+    lpm_destroy(t);
+    lpm_destroy(t6);
+    printf("Adaptive table tests passed!\n\n");
+}
+
+static void test_lctrie(void)
+{
+    printf("Testing LC-trie engine...\n");
+
+    enum { N = 4099 };
+    lpm_trie_t *ref = lpm_create_ipv4_dir24();
+    lpm_trie_t *lct = lpm_create_ipv4_lctrie();
+    assert(ref && lct);
+
+    /* Dense and sparse regions, nested prefixes sharing keys, deletes and
+     * overwrites, so nodes inflate, halve and collapse along the way */
+    static uint8_t pfx[6000][4];
+    static uint8_t lens[6000];
+    srand(29);
+    for (int i = 0; i < 6000; i++) {
+        uint8_t p[4] = {(uint8_t)(i % 3 ? rand() % 4 : rand()), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        memcpy(pfx[i], p, 4);
+        lens[i] = (uint8_t)(i % 97 ? 8 + rand() % 25 : 1 + rand() % 32);
+        uint32_t nh = (uint32_t)(rand() % 1000);
+        assert(lpm_add(ref, p, lens[i], nh) == 0);
+        assert(lpm_add(lct, p, lens[i], nh) == 0);
+        if (i % 4 == 0) {
+            int r = lpm_delete(ref, pfx[i / 2], lens[i / 2]);
+            assert(lpm_delete(lct, pfx[i / 2], lens[i / 2]) == r);
+        }
+    }
+    uint8_t dflt[4] = {0};
+    assert(lpm_add(ref, dflt, 0, 7) == 0);
+    assert(lpm_add(lct, dflt, 0, 7) == 0);
+
+    static uint32_t addrs[N], want[N], got[N];
+    for (int i = 0; i < N; i++) {
+        uint32_t a = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        addrs[i] = i % 2 ? a : (a & 0x03FFFFFF);
+    }
+    addrs[0] = 0;
+    addrs[1] = 0xFFFFFFFF;
+
+    lpm_lookup_batch_ipv4(ref, addrs, want, N);
+    lpm_lookup_batch_ipv4(lct, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == want[i]);
+        assert(lpm_lookup_ipv4(lct, addrs[i]) == want[i]);
+    }
+    assert(lpm_route_count(lct) == lpm_route_count(ref));
+    assert(lpm_lctrie_memory(lct) > sizeof(lpm_trie_t));
+
+    /* Repointing a next hop and dropping the default route */
+    assert(lpm_replace_next_hop(ref, want[2], 5000) == 0);
+    assert(lpm_replace_next_hop(lct, want[2], 5000) == 0);
+    assert(lpm_delete(ref, dflt, 0) == 0);
+    assert(lpm_delete(lct, dflt, 0) == 0);
+    assert(lpm_delete(lct, dflt, 0) == -1);
+    lpm_lookup_batch_ipv4(ref, addrs, want, N);
+    lpm_lookup_batch_ipv4(lct, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == want[i]);
+    }
+
+    /* Emptied out, it misses everywhere and gives its nodes back */
+    lpm_trie_t *fresh = lpm_create_ipv4_lctrie();
+    size_t empty = lpm_lctrie_memory(fresh);
+    lpm_destroy(fresh);
+    for (int i = 0; i < 6000; i++) {
+        lpm_delete(lct, pfx[i], lens[i]);
+    }
+    assert(lpm_lctrie_memory(lct) == empty);
+    assert(lpm_lookup_ipv4(lct, addrs[2]) == LPM_INVALID_NEXT_HOP);
+    lpm_lookup_batch_ipv4(lct, addrs, got, N);
+    for (int i = 0; i < N; i++) {
+        assert(got[i] == LPM_INVALID_NEXT_HOP);
+    }
+    assert(lpm_lctrie_memory(NULL) == 0);
+
+    lpm_destroy(ref);
+    lpm_destroy(lct);
+    printf("LC-trie engine tests passed!\n\n");
+}
+
+static void test_simd_selection(void)
+{
+    printf("Testing SIMD kernel selection...\n");
+
+    enum { N = 1000 };
+    lpm_simd_level_t cpu = lpm_simd_cpu_level();
+    assert(cpu < LPM_SIMD_LEVELS);
+    assert(lpm_simd_active_level() <= cpu);
+    assert(strcmp(lpm_simd_level_name(LPM_SIMD_SCALAR), "scalar") == 0);
+    assert(strcmp(lpm_simd_level_name(LPM_SIMD_AVX512), "avx512") == 0);
+    assert(lpm_simd_level_name(LPM_SIMD_LEVELS) == NULL);
+
+    /* Every variant of every engine agrees with the bound one; the batch
+     * is long enough to leave a remainder after the widest vector loop */
+    lpm_trie_t *v4[] = {lpm_create_ipv4_dir24(), lpm_create_ipv4_dir24_compact(),
+                        lpm_create_ipv4_small(), lpm_create_ipv4_lctrie(),
+                        lpm_create_ipv4_8stride()};
+    lpm_trie_t *v6[] = {lpm_create_ipv6_wide16(), lpm_create_ipv6_8stride()};
+    static uint32_t addrs[N], want[N], got[N];
+    static uint8_t addrs6[N][16];
+
+    srand(31);
+    for (int i = 0; i < 1000; i++) {
+        uint8_t p[16];
+        for (int b = 0; b < 16; b++) {
+            p[b] = (uint8_t)rand();
+        }
+        p[0] &= 0x3F;
+        uint8_t len4 = (uint8_t)(4 + rand() % 29);
+        uint8_t len6 = (uint8_t)(8 + rand() % 57);
+        for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+            assert(lpm_add(v4[t], p, len4, (uint32_t)i) == 0);
+        }
+        for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+            assert(lpm_add(v6[t], p, len6, (uint32_t)i) == 0);
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        addrs[i] = (((uint32_t)rand() << 16) ^ (uint32_t)rand()) & 0x3FFFFFFF;
+        for (int b = 0; b < 16; b++) {
+            addrs6[i][b] = (uint8_t)rand();
+        }
+        addrs6[i][0] &= 0x3F;
+        addrs6[i][1] &= 0x0F;
+    }
+
+    for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+        lpm_lookup_batch_ipv4(v4[t], addrs, want, N);
+        for (int l = 0; l < LPM_SIMD_LEVELS; l++) {
+            int k = lpm_simd_kernel_level(v4[t], (lpm_simd_level_t)l);
+            assert(k >= 0 && k <= l);
+            assert(lpm_simd_kernel_level(v4[t], (lpm_simd_level_t)k) == k);
+            if (l > (int)cpu) {
+                assert(lpm_lookup_batch_ipv4_simd(v4[t], (lpm_simd_level_t)l, addrs, got, N) == -1);
+                continue;
+            }
+            memset(got, 0, sizeof(got));
+            assert(lpm_lookup_batch_ipv4_simd(v4[t], (lpm_simd_level_t)l, addrs, got, N) == 0);
+            assert(memcmp(got, want, sizeof(want)) == 0);
+        }
+        assert(lpm_lookup_batch_ipv6_simd(v4[t], LPM_SIMD_SCALAR, addrs6, got, N) == -1);
+    }
+    for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+        lpm_lookup_batch_ipv6(v6[t], addrs6, want, N);
+        for (int l = 0; l <= (int)cpu; l++) {
+            memset(got, 0, sizeof(got));
+            assert(lpm_lookup_batch_ipv6_simd(v6[t], (lpm_simd_level_t)l, addrs6, got, N) == 0);
+            assert(memcmp(got, want, sizeof(want)) == 0);
+        }
+        assert(lpm_lookup_batch_ipv4_simd(v6[t], LPM_SIMD_SCALAR, addrs, got, N) == -1);
+    }
+
+    /* Sets and adaptive tries have no per-level kernels */
+    lpm_trie_t *set = lpm_create_set_ipv4();
+    assert(lpm_simd_kernel_level(set, LPM_SIMD_SCALAR) == -1);
+    assert(lpm_lookup_batch_ipv4_simd(set, LPM_SIMD_SCALAR, addrs, got, N) == -1);
+    assert(lpm_simd_kernel_level(v4[0], LPM_SIMD_LEVELS) == -1);
+    assert(lpm_lookup_batch_ipv4_simd(v4[0], LPM_SIMD_LEVELS, addrs, got, N) == -1);
+    assert(lpm_lookup_batch_ipv4_simd(NULL, LPM_SIMD_SCALAR, addrs, got, N) == -1);
+    lpm_destroy(set);
+
+    for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+        lpm_destroy(v4[t]);
+    }
+    for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+        lpm_destroy(v6[t]);
+    }
+    printf("SIMD kernel selection tests passed!\n\n");
+}
+
+static void test_inline_kernels(void)
+{
+    printf("Testing inline lookup kernels...\n");
+
+    lpm_trie_t *v4[] = {lpm_create_ipv4_dir24(), lpm_create_ipv4_dir24_compact(),
+                        lpm_create_ipv4_small(), lpm_create_ipv4_lctrie(),
+                        lpm_create_ipv4_8stride()};
+    const lpm_inline_engine_t e4[] = {LPM_INLINE_IPV4_DIR24, LPM_INLINE_IPV4_DIR24C,
+                                      LPM_INLINE_IPV4_SMALL, LPM_INLINE_IPV4_LCTRIE,
+                                      LPM_INLINE_IPV4_8STRIDE};
+    lpm_trie_t *v6[] = {lpm_create_ipv6_wide16(), lpm_create_ipv6_8stride()};
+    const lpm_inline_engine_t e6[] = {LPM_INLINE_IPV6_WIDE16, LPM_INLINE_IPV6_8STRIDE};
+    uint8_t zero[16] = {0};
+
+    /* Nested prefixes of mixed lengths, so LC-trie lookups back up */
+    srand(37);
+    for (int i = 0; i < 1000; i++) {
+        uint8_t p[16];
+        for (int b = 0; b < 16; b++) {
+            p[b] = (uint8_t)rand();
+        }
+        p[0] &= 0x3F;
+        uint8_t len4 = (uint8_t)(4 + rand() % 29);
+        uint8_t len6 = (uint8_t)(8 + rand() % 57);
+        for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+            assert(lpm_add(v4[t], p, len4, (uint32_t)i) == 0);
+        }
+        for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+            assert(lpm_add(v6[t], p, len6, (uint32_t)i) == 0);
+        }
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+            lpm_inline_engine_t e = lpm_inline_engine(v4[t]);
+            assert(e == e4[t]);
+            for (int i = 0; i < 4000; i++) {
+                uint32_t addr = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+                if (i & 1) {
+                    addr &= 0x3FFFFFFF;
+                }
+                uint32_t want = lpm_lookup_ipv4(v4[t], addr);
+                assert(lpm_inline_lookup_ipv4(v4[t], e, addr) == want);
+                switch (e) {
+                case LPM_INLINE_IPV4_DIR24:
+                    assert(lpm_inline_lookup_ipv4_dir24(v4[t], addr) == want);
+                    break;
+                case LPM_INLINE_IPV4_DIR24C:
+                    assert(lpm_inline_lookup_ipv4_dir24c(v4[t], addr) == want);
+                    break;
+                case LPM_INLINE_IPV4_SMALL:
+                    assert(lpm_inline_lookup_ipv4_small(v4[t], addr) == want);
+                    break;
+                case LPM_INLINE_IPV4_LCTRIE:
+                    assert(lpm_inline_lookup_ipv4_lctrie(v4[t], addr) == want);
+                    break;
+                default:
+                    assert(lpm_inline_lookup_ipv4_8stride(v4[t], addr) == want);
+                    break;
+                }
+            }
+        }
+        for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+            lpm_inline_engine_t e = lpm_inline_engine(v6[t]);
+            assert(e == e6[t]);
+            for (int i = 0; i < 4000; i++) {
+                uint8_t addr[16];
+                for (int b = 0; b < 16; b++) {
+                    addr[b] = (uint8_t)rand();
+                }
+                if (i & 1) {
+                    addr[0] &= 0x3F;
+                    addr[1] &= 0x0F;
+                }
+                uint32_t want = lpm_lookup_ipv6(v6[t], addr);
+                assert(lpm_inline_lookup_ipv6(v6[t], e, addr) == want);
+                if (e == LPM_INLINE_IPV6_WIDE16) {
+                    assert(lpm_inline_lookup_ipv6_wide16(v6[t], addr) == want);
+                } else {
+                    assert(lpm_inline_lookup_ipv6_8stride(v6[t], addr) == want);
+                }
+            }
+        }
+
+        /* Second pass with a default route behind every miss */
+        for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+            assert(lpm_add(v4[t], zero, 0, 9999) == 0);
+            assert(lpm_inline_lookup_ipv4(v4[t], e4[t], 0xFFFFFFFFu) == 9999);
+        }
+        for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+            assert(lpm_add(v6[t], zero, 0, 9999) == 0);
+        }
+    }
+
+    /* No kernel: the dispatchers fall back to the exported lookups */
+    lpm_trie_t *set = lpm_create_set_ipv4();
+    uint8_t net[4] = {10, 0, 0, 0};
+    assert(lpm_add(set, net, 8, 1) == 0);
+    assert(lpm_inline_engine(set) == LPM_INLINE_NONE);
+    assert(lpm_inline_lookup_ipv4(set, LPM_INLINE_NONE, 0x0A010203) ==
+           lpm_lookup_ipv4(set, 0x0A010203));
+    assert(lpm_inline_engine(NULL) == LPM_INLINE_NONE);
+    lpm_destroy(set);
+
+    for (size_t t = 0; t < sizeof(v4) / sizeof(v4[0]); t++) {
+        lpm_destroy(v4[t]);
+    }
+    for (size_t t = 0; t < sizeof(v6) / sizeof(v6[0]); t++) {
+        lpm_destroy(v6[t]);
+    }
+    printf("Inline lookup kernel tests passed!\n\n");
+}
+
 int main(void)
 {
     printf("=== LPM Library Test Suite ===\n");
@@ -343,6 +2403,26 @@ int main(void)
     test_batch_lookup();
     test_overlapping_prefixes();
     test_default_route();
+    test_address_parsing();
+    test_prefix_file_loading();
+    test_multi_table_lookup();
+    test_incremental_update();
+    test_dir24_compact();
+    test_membership_set();
+    test_expiring_prefixes();
+    test_fib_aggregation();
+    test_replace_next_hop();
+    test_small_table();
+    test_adaptive_table();
+    test_wide16_levels();
+    test_prefault();
+    test_update_journal();
+    test_sharded_writers();
+    test_async_updates();
+    test_range_cache();
+    test_lctrie();
+    test_simd_selection();
+    test_inline_kernels();
     
     printf("All tests passed successfully!\n");
     return 0;
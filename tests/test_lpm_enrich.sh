@@ -0,0 +1,105 @@
+#!/bin/bash
+
+# lpm-enrich test script for liblpm
+# Runs the tool on inputs that cross 1 MB chunk boundaries, end without a
+# newline, and contain a line longer than a chunk, and checks that the
+# output matches a line-by-line reference with one and with several workers.
+#
+# Usage: test_lpm_enrich.sh <path-to-lpm-enrich>
+
+set -e
+
+ENRICH="$1"
+if [ -z "$ENRICH" ] || [ ! -x "$ENRICH" ]; then
+    echo "usage: $0 <lpm-enrich>" >&2
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Mixed-family table: one parse must fill both tries
+cat > "$WORK/table.txt" <<'EOF'
+# test table
+10.0.0.0/8      1
+10.1.0.0/16     2
+2001:db8::/32   3
+EOF
+
+# Line i carries address kind i % 4; gen_expected applies the same rule.
+#   0: 10.1.x.y -> 2    1: 10.2.x.y -> 1    2: 2001:db8::x -> 3    3: 192.0.2.1 -> -
+gen_input() {
+    awk -v first="$1" -v last="$2" 'BEGIN {
+        for (i = first; i <= last; i++) {
+            k = i % 4
+            if (k == 0)      a = "10.1." int(i / 256) % 256 "." i % 256
+            else if (k == 1) a = "10.2." int(i / 256) % 256 "." i % 256
+            else if (k == 2) a = sprintf("2001:db8::%x", i % 65536)
+            else             a = "192.0.2.1"
+            printf "line%d %s", i, a
+            if (i < last) printf "\n"
+        }
+    }'
+}
+
+gen_expected() {
+    awk -v first="$1" -v last="$2" 'BEGIN {
+        split("2 1 3 -", nh, " ")
+        for (i = first; i <= last; i++) {
+            k = i % 4
+            if (k == 0)      a = "10.1." int(i / 256) % 256 "." i % 256
+            else if (k == 1) a = "10.2." int(i / 256) % 256 "." i % 256
+            else if (k == 2) a = sprintf("2001:db8::%x", i % 65536)
+            else             a = "192.0.2.1"
+            printf "line%d %s\t%s\n", i, a, nh[k + 1]
+        }
+    }'
+}
+
+# a: ~2.5 MB, several chunks, no trailing newline
+gen_input 0 149999 > "$WORK/a.txt"
+gen_expected 0 149999 > "$WORK/expected.txt"
+
+# b: a line longer than the chunk size, then a short unterminated tail
+{
+    printf 'long 10.1.2.3 '
+    head -c 1500000 /dev/zero | tr '\0' 'x'
+    printf '\n'
+    gen_input 150000 150009
+} > "$WORK/b.txt"
+{
+    printf 'long 10.1.2.3 '
+    head -c 1500000 /dev/zero | tr '\0' 'x'
+    printf '\t2\n'
+    gen_expected 150000 150009
+} >> "$WORK/expected.txt"
+
+# c: a single unterminated line
+gen_input 150010 150010 > "$WORK/c.txt"
+gen_expected 150010 150010 >> "$WORK/expected.txt"
+
+status=0
+for threads in 1 4; do
+    "$ENRICH" -t "$WORK/table.txt" -f 2 -c 1 -j "$threads" \
+        -o "$WORK/out.$threads" "$WORK/a.txt" "$WORK/b.txt" "$WORK/c.txt"
+    if cmp -s "$WORK/expected.txt" "$WORK/out.$threads"; then
+        echo "lpm-enrich with $threads worker(s): OK"
+    else
+        echo "lpm-enrich with $threads worker(s): output differs" >&2
+        diff "$WORK/expected.txt" "$WORK/out.$threads" | head -5 >&2 || true
+        status=1
+    fi
+done
+
+# Same inputs through stdin, a single stream
+{ cat "$WORK/a.txt"; printf '\n'; gen_input 0 3; } > "$WORK/stdin.txt"
+"$ENRICH" -t "$WORK/table.txt" -f 2 -c 1 -j 4 < "$WORK/stdin.txt" > "$WORK/out.stdin"
+{ gen_expected 0 149999; gen_expected 0 3; } > "$WORK/expected.stdin"
+if cmp -s "$WORK/expected.stdin" "$WORK/out.stdin"; then
+    echo "lpm-enrich from stdin: OK"
+else
+    echo "lpm-enrich from stdin: output differs" >&2
+    status=1
+fi
+
+exit $status
@@ -0,0 +1,806 @@
+/*
+ * lpm-enrich - Streaming log enrichment with liblpm
+ *
+ * Reads newline-delimited text from stdin or files, extracts an IPv4/IPv6
+ * address from a configurable field of every line, resolves it against a
+ * routing table and writes the line back with the next hop appended.
+ *
+ * Input is consumed in large chunks that are cut on line boundaries and
+ * handed to a pool of worker threads. A dedicated writer emits the chunks
+ * strictly in input order, so the output is line-for-line identical to a
+ * sequential run.
+ *
+ * Table format (one prefix per line, '#' starts a comment), or an MRT
+ * TABLE_DUMP_V2 RIB dump; see lpm_load_prefix_file():
+ *   10.0.0.0/8        100
+ *   2001:db8::/32     200
+ */
+
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier)
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/lpm.h"
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+#define ENRICH_DEFAULT_CHUNK_MB  4
+#define ENRICH_MAX_CHUNK_MB      1024
+#define ENRICH_BATCH_SIZE        256
+#define ENRICH_MAX_THREADS       256
+#define ENRICH_NH_MAX_CHARS      10   /* "4294967294" */
+
+typedef struct {
+    const char *table_path;
+    unsigned field;          /* 1-based field index */
+    char delim;              /* 0 = any run of blanks */
+    char out_sep;
+    const char *missing;
+    size_t missing_len;
+    unsigned threads;
+    size_t chunk_size;
+} enrich_config_t;
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_READY,
+    SLOT_BUSY,
+    SLOT_DONE,
+} slot_state_t;
+
+/* One in-flight chunk. The ring holds 2x threads slots so the reader can
+ * run ahead of the workers while the writer drains finished chunks. */
+typedef struct {
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    char *out;
+    size_t out_len;
+    size_t out_cap;
+    uint64_t seq;
+    slot_state_t state;
+} chunk_slot_t;
+
+typedef struct {
+    const enrich_config_t *cfg;
+    const lpm_trie_t *v4;
+    const lpm_trie_t *v6;
+
+    chunk_slot_t *slots;
+    unsigned num_slots;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint64_t next_work;      /* next chunk sequence to hand to a worker */
+    uint64_t total_chunks;   /* valid once eof is set */
+    bool eof;
+    bool failed;
+
+    int out_fd;
+    uint64_t lines;
+    uint64_t matched;
+} enrich_ctx_t;
+
+/* ============================================================================
+ * Field Extraction
+ * ============================================================================ */
+
+/* Locate the configured field of a line. Returns false if the line has
+ * fewer fields. Surrounding brackets (e.g. "[2001:db8::1]") are stripped. */
+static bool find_field(const enrich_config_t *cfg, const char *line, size_t len,
+                       const char **field, size_t *field_len)
+{
+    const char *p = line;
+    const char *end = line + len;
+
+    for (unsigned f = 1; ; f++) {
+        const char *start;
+        if (cfg->delim) {
+            start = p;
+            const char *d = memchr(p, cfg->delim, (size_t)(end - p));
+            p = d ? d : end;
+        } else {
+            while (p < end && (*p == ' ' || *p == '\t')) { p++; }
+            if (p == end) { return false; }
+            start = p;
+            while (p < end && *p != ' ' && *p != '\t') { p++; }
+        }
+
+        if (f == cfg->field) {
+            const char *fe = p;
+            if (fe - start >= 2 && *start == '[' && fe[-1] == ']') {
+                start++;
+                fe--;
+            }
+            *field = start;
+            *field_len = (size_t)(fe - start);
+            return true;
+        }
+
+        if (p == end) { return false; }
+        if (cfg->delim) { p++; }
+    }
+}
+
+/* ============================================================================
+ * Chunk Processing
+ * ============================================================================ */
+
+typedef struct {
+    const char *line[ENRICH_BATCH_SIZE];
+    size_t len[ENRICH_BATCH_SIZE];
+    int8_t family[ENRICH_BATCH_SIZE];       /* 4, 6 or 0 (no field) */
+    uint16_t slot[ENRICH_BATCH_SIZE];       /* index into v4/v6 arrays */
+    const char *v4_strs[ENRICH_BATCH_SIZE];
+    size_t v4_lens[ENRICH_BATCH_SIZE];
+    uint8_t v4_status[ENRICH_BATCH_SIZE];
+    uint32_t v4_addrs[ENRICH_BATCH_SIZE];
+    uint32_t v4_hops[ENRICH_BATCH_SIZE];
+    const char *v6_strs[ENRICH_BATCH_SIZE];
+    size_t v6_lens[ENRICH_BATCH_SIZE];
+    uint8_t v6_status[ENRICH_BATCH_SIZE];
+    uint8_t v6_addrs[ENRICH_BATCH_SIZE][16];
+    uint32_t v6_hops[ENRICH_BATCH_SIZE];
+    unsigned count;
+    unsigned v4_count;
+    unsigned v6_count;
+} line_batch_t;
+
+static int out_reserve(chunk_slot_t *slot, size_t extra)
+{
+    if (slot->out_len + extra <= slot->out_cap) { return 0; }
+
+    size_t cap = slot->out_cap ? slot->out_cap : 4096;
+    while (cap < slot->out_len + extra) { cap *= 2; }
+
+    char *p = realloc(slot->out, cap);
+    if (!p) { return -1; }
+    slot->out = p;
+    slot->out_cap = cap;
+    return 0;
+}
+
+static size_t format_u32(char *dst, uint32_t v)
+{
+    char tmp[ENRICH_NH_MAX_CHARS];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+static int flush_batch(const enrich_ctx_t *ctx, line_batch_t *b, chunk_slot_t *slot,
+                       uint64_t *matched)
+{
+    const enrich_config_t *cfg = ctx->cfg;
+
+    /* Parse the whole batch in one call per family, then look it up */
+    if (b->v4_count && ctx->v4) {
+        lpm_parse_ipv4_batch(b->v4_strs, b->v4_lens, b->v4_addrs, b->v4_status, b->v4_count);
+        lpm_lookup_batch_ipv4(ctx->v4, b->v4_addrs, b->v4_hops, b->v4_count);
+    } else {
+        for (unsigned i = 0; i < b->v4_count; i++) { b->v4_hops[i] = LPM_INVALID_NEXT_HOP; }
+    }
+    if (b->v6_count && ctx->v6) {
+        lpm_parse_ipv6_batch(b->v6_strs, b->v6_lens, b->v6_addrs, b->v6_status, b->v6_count);
+        lpm_lookup_batch_ipv6(ctx->v6, (const uint8_t (*)[16])b->v6_addrs,
+                              b->v6_hops, b->v6_count);
+    } else {
+        for (unsigned i = 0; i < b->v6_count; i++) { b->v6_hops[i] = LPM_INVALID_NEXT_HOP; }
+    }
+
+    for (unsigned i = 0; i < b->count; i++) {
+        uint32_t nh = LPM_INVALID_NEXT_HOP;
+        unsigned k = b->slot[i];
+        if (b->family[i] == 4 && b->v4_status[k] == LPM_PARSE_OK) {
+            nh = b->v4_hops[k];
+        } else if (b->family[i] == 6 && b->v6_status[k] == LPM_PARSE_OK) {
+            nh = b->v6_hops[k];
+        }
+
+        if (out_reserve(slot, b->len[i] + 2 + ENRICH_NH_MAX_CHARS + cfg->missing_len) != 0) {
+            return -1;
+        }
+        char *o = slot->out + slot->out_len;
+        memcpy(o, b->line[i], b->len[i]);
+        o += b->len[i];
+        *o++ = cfg->out_sep;
+        if (nh != LPM_INVALID_NEXT_HOP) {
+            o += format_u32(o, nh);
+            (*matched)++;
+        } else {
+            memcpy(o, cfg->missing, cfg->missing_len);
+            o += cfg->missing_len;
+        }
+        *o++ = '\n';
+        slot->out_len = (size_t)(o - slot->out);
+    }
+
+    b->count = 0;
+    b->v4_count = 0;
+    b->v6_count = 0;
+    return 0;
+}
+
+static int process_chunk(const enrich_ctx_t *ctx, chunk_slot_t *slot,
+                         line_batch_t *b, uint64_t *lines, uint64_t *matched)
+{
+    const char *p = slot->in;
+    const char *end = slot->in + slot->in_len;
+
+    slot->out_len = 0;
+    b->count = b->v4_count = b->v6_count = 0;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+        size_t line_len = (len && p[len - 1] == '\r') ? len - 1 : len;
+
+        unsigned i = b->count++;
+        b->line[i] = p;
+        b->len[i] = line_len;
+        b->family[i] = 0;
+
+        const char *f;
+        size_t flen;
+        if (find_field(ctx->cfg, p, line_len, &f, &flen)) {
+            if (memchr(f, ':', flen)) {
+                b->v6_strs[b->v6_count] = f;
+                b->v6_lens[b->v6_count] = flen;
+                b->v6_status[b->v6_count] = LPM_PARSE_ERR_SYNTAX;
+                b->family[i] = 6;
+                b->slot[i] = (uint16_t)b->v6_count++;
+            } else {
+                b->v4_strs[b->v4_count] = f;
+                b->v4_lens[b->v4_count] = flen;
+                b->v4_status[b->v4_count] = LPM_PARSE_ERR_SYNTAX;
+                b->family[i] = 4;
+                b->slot[i] = (uint16_t)b->v4_count++;
+            }
+        }
+
+        if (b->count == ENRICH_BATCH_SIZE && flush_batch(ctx, b, slot, matched) != 0) {
+            return -1;
+        }
+        (*lines)++;
+        p += len + 1;
+    }
+
+    if (b->count) {
+        return flush_batch(ctx, b, slot, matched);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Pipeline: reader (caller), workers, ordered writer
+ * ============================================================================ */
+
+static void *worker_main(void *arg)
+{
+    enrich_ctx_t *ctx = arg;
+    uint64_t lines = 0;
+    uint64_t matched = 0;
+
+    line_batch_t *batch = malloc(sizeof(*batch));
+    if (!batch) {
+        pthread_mutex_lock(&ctx->lock);
+        ctx->failed = true;
+        pthread_cond_broadcast(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    for (;;) {
+        chunk_slot_t *slot = &ctx->slots[ctx->next_work % ctx->num_slots];
+        while (!ctx->failed && !(slot->state == SLOT_READY && slot->seq == ctx->next_work) &&
+               !(ctx->eof && ctx->next_work >= ctx->total_chunks)) {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+        }
+        if (ctx->failed || (ctx->eof && ctx->next_work >= ctx->total_chunks)) {
+            break;
+        }
+
+        ctx->next_work++;
+        slot->state = SLOT_BUSY;
+        pthread_mutex_unlock(&ctx->lock);
+
+        int rc = process_chunk(ctx, slot, batch, &lines, &matched);
+
+        pthread_mutex_lock(&ctx->lock);
+        if (rc != 0) {
+            ctx->failed = true;
+        }
+        slot->state = SLOT_DONE;
+        pthread_cond_broadcast(&ctx->cond);
+    }
+    ctx->lines += lines;
+    ctx->matched += matched;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+
+    free(batch);
+    return NULL;
+}
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void *writer_main(void *arg)
+{
+    enrich_ctx_t *ctx = arg;
+
+    pthread_mutex_lock(&ctx->lock);
+    for (uint64_t seq = 0; ; seq++) {
+        chunk_slot_t *slot = &ctx->slots[seq % ctx->num_slots];
+        while (!ctx->failed && !(slot->state == SLOT_DONE && slot->seq == seq) &&
+               !(ctx->eof && seq >= ctx->total_chunks)) {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+        }
+        if (ctx->failed || (ctx->eof && seq >= ctx->total_chunks)) {
+            break;
+        }
+        pthread_mutex_unlock(&ctx->lock);
+
+        int rc = write_all(ctx->out_fd, slot->out, slot->out_len);
+
+        pthread_mutex_lock(&ctx->lock);
+        if (rc != 0) {
+            fprintf(stderr, "lpm-enrich: write: %s\n", strerror(errno));
+            ctx->failed = true;
+        }
+        slot->state = SLOT_FREE;
+        pthread_cond_broadcast(&ctx->cond);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    return NULL;
+}
+
+/* Acquire the slot for chunk 'seq', waiting for the writer to release it. */
+static chunk_slot_t *reader_acquire(enrich_ctx_t *ctx, uint64_t seq)
+{
+    chunk_slot_t *slot = &ctx->slots[seq % ctx->num_slots];
+
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->failed && slot->state != SLOT_FREE) {
+        pthread_cond_wait(&ctx->cond, &ctx->lock);
+    }
+    bool failed = ctx->failed;
+    pthread_mutex_unlock(&ctx->lock);
+
+    return failed ? NULL : slot;
+}
+
+static void reader_publish(enrich_ctx_t *ctx, chunk_slot_t *slot, uint64_t seq)
+{
+    pthread_mutex_lock(&ctx->lock);
+    slot->seq = seq;
+    slot->state = SLOT_READY;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+/* Read all input files into line-aligned chunks. Any partial trailing line
+ * is carried over into the next chunk of the same file; lines longer than a
+ * chunk grow the chunk buffer. */
+static int read_inputs(enrich_ctx_t *ctx, char **files, int num_files)
+{
+    const size_t chunk = ctx->cfg->chunk_size;
+    char *carry = NULL;
+    size_t carry_len = 0;
+    uint64_t seq = 0;
+    int rc = 0;
+
+    for (int f = 0; f < (num_files ? num_files : 1) && rc == 0; f++) {
+        int fd = STDIN_FILENO;
+        if (num_files && strcmp(files[f], "-") != 0) {
+            fd = open(files[f], O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                fprintf(stderr, "lpm-enrich: %s: %s\n", files[f], strerror(errno));
+                rc = -1;
+                break;
+            }
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        bool file_eof = false;
+        while (!file_eof) {
+            chunk_slot_t *slot = reader_acquire(ctx, seq);
+            if (!slot) {
+                rc = -1;
+                break;
+            }
+
+            size_t need = carry_len + chunk;
+            if (slot->in_cap < need) {
+                char *p = realloc(slot->in, need);
+                if (!p) {
+                    rc = -1;
+                    break;
+                }
+                slot->in = p;
+                slot->in_cap = need;
+            }
+            if (carry_len) {
+                memcpy(slot->in, carry, carry_len);
+            }
+            slot->in_len = carry_len;
+            carry_len = 0;
+
+            while (slot->in_len < slot->in_cap) {
+                ssize_t n = read(fd, slot->in + slot->in_len, slot->in_cap - slot->in_len);
+                if (n < 0) {
+                    if (errno == EINTR) { continue; }
+                    fprintf(stderr, "lpm-enrich: read: %s\n", strerror(errno));
+                    rc = -1;
+                    break;
+                }
+                if (n == 0) {
+                    file_eof = true;
+                    break;
+                }
+                slot->in_len += (size_t)n;
+            }
+            if (rc != 0) { break; }
+
+            /* Cut at the last newline; keep the tail for the next chunk. */
+            char *last = memrchr(slot->in, '\n', slot->in_len);
+            size_t keep = last ? (size_t)(last - slot->in) + 1 : 0;
+            if (keep < slot->in_len) {
+                size_t tail = slot->in_len - keep;
+                char *p = realloc(carry, tail);
+                if (!p) {
+                    rc = -1;
+                    break;
+                }
+                carry = p;
+                memcpy(carry, slot->in + keep, tail);
+                carry_len = tail;
+                slot->in_len = keep;
+            }
+
+            if (slot->in_len) {
+                reader_publish(ctx, slot, seq++);
+            }
+        }
+
+        /* Unterminated last line of this file: emit it as its own line
+         * rather than joining it with the next file's first line. */
+        if (rc == 0 && carry_len) {
+            chunk_slot_t *slot = reader_acquire(ctx, seq);
+            if (slot && slot->in_cap < carry_len) {
+                char *p = realloc(slot->in, carry_len);
+                if (p) {
+                    slot->in = p;
+                    slot->in_cap = carry_len;
+                } else {
+                    slot = NULL;
+                }
+            }
+            if (slot) {
+                memcpy(slot->in, carry, carry_len);
+                slot->in_len = carry_len;
+                reader_publish(ctx, slot, seq++);
+            } else {
+                rc = -1;
+            }
+        }
+        carry_len = 0;
+
+        if (fd != STDIN_FILENO) {
+            close(fd);
+        }
+    }
+
+    free(carry);
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->total_chunks = seq;
+    ctx->eof = true;
+    if (rc != 0) {
+        ctx->failed = true;
+    }
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+    return rc;
+}
+
+/* ============================================================================
+ * Table Loading
+ * ============================================================================ */
+
+static int load_table(const char *path, unsigned threads, bool verbose,
+                      lpm_trie_t **v4, lpm_trie_t **v6)
+{
+    lpm_trie_t *tries[2] = {lpm_create_ipv4(), lpm_create_ipv6()};
+    lpm_load_stats_t st;
+    int rc = 0;
+
+    /* One parse of the dump fills both families */
+    if (!tries[0] || !tries[1]) {
+        fprintf(stderr, "lpm-enrich: out of memory\n");
+        rc = -1;
+    } else if (lpm_load_prefix_file_pair(tries[0], tries[1], path, threads, &st) != 0) {
+        fprintf(stderr, "lpm-enrich: %s: %s\n", path, strerror(errno));
+        rc = -1;
+    } else if (st.errors > 0) {
+        fprintf(stderr, "lpm-enrich: %s: %llu malformed entries\n", path,
+                (unsigned long long)st.errors);
+        rc = -1;
+    } else if (st.loaded == 0) {
+        fprintf(stderr, "lpm-enrich: %s: empty table\n", path);
+        rc = -1;
+    }
+    if (rc != 0) {
+        lpm_destroy(tries[0]);
+        lpm_destroy(tries[1]);
+        return -1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "lpm-enrich: %s: %llu prefixes, IPv4 %zu, IPv6 %zu (parse %.1f ms, "
+                "sort %.1f ms, build %.1f ms, %u threads)\n", st.mrt ? "MRT" : "text",
+                (unsigned long long)st.loaded, lpm_route_count(tries[0]),
+                lpm_route_count(tries[1]), st.parse_ms, st.sort_ms, st.build_ms, st.threads);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (lpm_route_count(tries[i]) == 0) {
+            lpm_destroy(tries[i]);
+            tries[i] = NULL;
+        }
+    }
+    *v4 = tries[0];
+    *v6 = tries[1];
+    return 0;
+}
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+static void print_usage(const char *prog)
+{
+    printf("Usage: %s -t TABLE [OPTIONS] [FILE...]\n\n", prog);
+    printf("Annotate each input line with the next hop of the address found\n");
+    printf("in the selected field. Reads stdin when no FILE is given.\n\n");
+    printf("Options:\n");
+    printf("  -t, --table FILE      Routing table ('<prefix>/<len> <next_hop>' per line, or MRT)\n");
+    printf("  -f, --field N         1-based field holding the address (default: 1)\n");
+    printf("  -d, --delimiter C     Field delimiter (default: runs of spaces/tabs)\n");
+    printf("  -s, --separator C     Separator before the appended next hop (default: tab)\n");
+    printf("  -m, --missing STR     Text written when nothing matches (default: -)\n");
+    printf("  -j, --threads N       Worker threads (default: online CPUs)\n");
+    printf("  -c, --chunk-mb N      Input chunk size in MB (default: %d)\n", ENRICH_DEFAULT_CHUNK_MB);
+    printf("  -o, --output FILE     Write to FILE instead of stdout\n");
+    printf("  -v, --verbose         Print throughput statistics to stderr\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+static char parse_char_arg(const char *arg)
+{
+    if (strcmp(arg, "\\t") == 0 || strcmp(arg, "tab") == 0) { return '\t'; }
+    return arg[0];
+}
+
+int main(int argc, char **argv)
+{
+    enrich_config_t cfg = {
+        .field = 1,
+        .delim = 0,
+        .out_sep = '\t',
+        .missing = "-",
+        .threads = 0,
+        .chunk_size = (size_t)ENRICH_DEFAULT_CHUNK_MB << 20,
+    };
+    const char *output = NULL;
+    bool verbose = false;
+
+    static const struct option long_options[] = {
+        {"table",     required_argument, 0, 't'},
+        {"field",     required_argument, 0, 'f'},
+        {"delimiter", required_argument, 0, 'd'},
+        {"separator", required_argument, 0, 's'},
+        {"missing",   required_argument, 0, 'm'},
+        {"threads",   required_argument, 0, 'j'},
+        {"chunk-mb",  required_argument, 0, 'c'},
+        {"output",    required_argument, 0, 'o'},
+        {"verbose",   no_argument,       0, 'v'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:f:d:s:m:j:c:o:vh", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 't':
+            cfg.table_path = optarg;
+            break;
+        case 'f':
+            cfg.field = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            cfg.delim = parse_char_arg(optarg);
+            break;
+        case 's':
+            cfg.out_sep = parse_char_arg(optarg);
+            break;
+        case 'm':
+            cfg.missing = optarg;
+            break;
+        case 'j':
+            cfg.threads = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'c': {
+            unsigned long mb = strtoul(optarg, NULL, 10);
+            if (mb == 0 || mb > ENRICH_MAX_CHUNK_MB) {
+                fprintf(stderr, "lpm-enrich: chunk size must be 1-%d MB\n", ENRICH_MAX_CHUNK_MB);
+                return 1;
+            }
+            cfg.chunk_size = (size_t)mb << 20;
+            break;
+        }
+        case 'o':
+            output = optarg;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!cfg.table_path || cfg.field == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    cfg.missing_len = strlen(cfg.missing);
+
+    if (cfg.threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        cfg.threads = n > 0 ? (unsigned)n : 1;
+    }
+    if (cfg.threads > ENRICH_MAX_THREADS) {
+        cfg.threads = ENRICH_MAX_THREADS;
+    }
+
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    lpm_trie_t *v4 = NULL;
+    lpm_trie_t *v6 = NULL;
+    if (load_table(cfg.table_path, cfg.threads, verbose, &v4, &v6) != 0) {
+        lpm_destroy(v4);
+        lpm_destroy(v6);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    enrich_ctx_t ctx = {
+        .cfg = &cfg,
+        .v4 = v4,
+        .v6 = v6,
+        .num_slots = cfg.threads * 2,
+        .out_fd = STDOUT_FILENO,
+    };
+
+    if (output) {
+        ctx.out_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (ctx.out_fd < 0) {
+            fprintf(stderr, "lpm-enrich: %s: %s\n", output, strerror(errno));
+            lpm_destroy(v4);
+            lpm_destroy(v6);
+            return 1;
+        }
+    }
+
+    ctx.slots = calloc(ctx.num_slots, sizeof(*ctx.slots));
+    pthread_t *workers = calloc(cfg.threads, sizeof(*workers));
+    if (!ctx.slots || !workers) {
+        fprintf(stderr, "lpm-enrich: out of memory\n");
+        free(ctx.slots);
+        free(workers);
+        if (output) {
+            close(ctx.out_fd);
+        }
+        lpm_destroy(v4);
+        lpm_destroy(v6);
+        return 1;
+    }
+    pthread_mutex_init(&ctx.lock, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+
+    /* A thread that failed to start would leave the ordered writer waiting
+     * forever, so mark the run failed and let the started ones drain. */
+    int rc = 0;
+    unsigned started = 0;
+    pthread_t writer;
+    bool writer_started = false;
+    int err = pthread_create(&writer, NULL, writer_main, &ctx);
+    if (err == 0) {
+        writer_started = true;
+        for (; started < cfg.threads; started++) {
+            err = pthread_create(&workers[started], NULL, worker_main, &ctx);
+            if (err != 0) {
+                break;
+            }
+        }
+    }
+    if (err != 0) {
+        fprintf(stderr, "lpm-enrich: pthread_create: %s\n", strerror(err));
+        pthread_mutex_lock(&ctx.lock);
+        ctx.failed = true;
+        ctx.eof = true;
+        pthread_cond_broadcast(&ctx.cond);
+        pthread_mutex_unlock(&ctx.lock);
+        rc = -1;
+    } else {
+        rc = read_inputs(&ctx, argv + optind, argc - optind);
+    }
+
+    for (unsigned i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    if (writer_started) {
+        pthread_join(writer, NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    if (ctx.failed) {
+        rc = -1;
+    }
+
+    if (verbose) {
+        double load_s = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+        double run_s = (double)(t2.tv_sec - t1.tv_sec) + (double)(t2.tv_nsec - t1.tv_nsec) / 1e9;
+        fprintf(stderr, "lpm-enrich: table loaded in %.3f s\n", load_s);
+        fprintf(stderr, "lpm-enrich: %llu lines, %llu matched, %.3f s (%.2f M lines/s, %u threads)\n",
+                (unsigned long long)ctx.lines, (unsigned long long)ctx.matched, run_s,
+                run_s > 0 ? (double)ctx.lines / run_s / 1e6 : 0.0, cfg.threads);
+    }
+
+    for (unsigned i = 0; i < ctx.num_slots; i++) {
+        free(ctx.slots[i].in);
+        free(ctx.slots[i].out);
+    }
+    free(ctx.slots);
+    free(workers);
+    pthread_mutex_destroy(&ctx.lock);
+    pthread_cond_destroy(&ctx.cond);
+    if (output) {
+        close(ctx.out_fd);
+    }
+    lpm_destroy(v4);
+    lpm_destroy(v6);
+
+    return rc == 0 ? 0 : 1;
+}